@@ -0,0 +1,57 @@
+struct ChunkVertex {
+    uint packed : PackedVertex;
+};
+
+struct VertexOutput {
+    float4 position : SV_POSITION;
+    float3 position_worldspace : WORLDPOS;
+    float3 normal : NORMAL;
+    float4 color : COLOR;
+    float2 texcoord : TEXCOORD;
+};
+
+struct MaterialData {};
+
+#include "inc/standard_root_signature.hlsl"
+
+// Must match VoxelMaterial in voxel_chunk.hpp
+static const float4 VOXEL_MATERIAL_COLORS[] = {
+    float4(1, 1, 1, 0),          // Air. Never meshed
+    float4(0.5, 0.5, 0.5, 1),    // Stone
+    float4(0.45, 0.3, 0.2, 1),   // Dirt
+    float4(0.3, 0.55, 0.2, 1),   // Grass
+    float4(0.85, 0.8, 0.55, 1),  // Sand
+};
+
+// Must match VoxelFace in chunk_vertex.hpp
+float3 get_face_normal(uint face) {
+    float3 normal = float3(0, 0, 0);
+    normal[face / 2] = face % 2 == 0 ? 1 : -1;
+    return normal;
+}
+
+VertexOutput main(ChunkVertex input) {
+    VertexOutput output;
+
+    Camera camera = cameras[constants.camera_index];
+    float4x4 model_matrix = model_matrices[constants.model_matrix_index];
+
+    // Must match make_chunk_vertex in chunk_vertex.cpp
+    const float3 position = float3(input.packed & 0x3F, (input.packed >> 6) & 0x3F, (input.packed >> 12) & 0x3F);
+    const uint face = (input.packed >> 18) & 0x7;
+    const uint material = input.packed >> 21;
+
+    // The model matrix moves the chunk to its place in the world
+    output.position_worldspace = mul(model_matrix, float4(position, 1)).xyz;
+    output.position = mul(camera.projection, mul(camera.view, float4(output.position_worldspace, 1)));
+    output.normal = get_face_normal(face);
+    output.color = VOXEL_MATERIAL_COLORS[min(material, 4)];
+
+    // Greedy quads span many voxels, so use world-space texcoords on the face's plane to tile the texture once per voxel
+    const uint axis = face / 2;
+    output.texcoord = axis == 0 ? output.position_worldspace.zy :
+                      axis == 1 ? output.position_worldspace.xz :
+                                  output.position_worldspace.xy;
+
+    return output;
+}
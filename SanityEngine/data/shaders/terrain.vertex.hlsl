@@ -1,8 +1,9 @@
-struct StandardVertex {
-    float3 position : Position;
-    float3 normal : Normal;
-    float4 color : Color;
-    float2 texcoord : Texcoord;
+// Number of vertices on each side of a terrain tile's grid. Must match Terrain::TILE_SIZE + 1
+#define TERRAIN_GRID_SIZE 65
+
+struct TerrainVertex {
+    float2 encoded_normal : Normal;
+    float height : Height;
 };
 
 struct VertexOutput {
@@ -13,23 +14,60 @@ struct VertexOutput {
     float2 texcoord : TEXCOORD;
 };
 
-struct MaterialData {
-    float4x4 model_matrix;
-};
+struct MaterialData {};
 
 #include "inc/standard_root_signature.hlsl"
 
-VertexOutput main(StandardVertex input) {
+float3 decode_octahedral_normal(float2 encoded_normal) {
+    float3 normal = float3(encoded_normal.x, 1 - abs(encoded_normal.x) - abs(encoded_normal.y), encoded_normal.y);
+    if(normal.y < 0) {
+        const float2 signs = float2(normal.x >= 0 ? 1 : -1, normal.z >= 0 ? 1 : -1);
+        const float2 folded = (1 - abs(normal.zx)) * signs;
+        normal.x = folded.x;
+        normal.z = folded.y;
+    }
+
+    return normalize(normal);
+}
+
+// Must match get_terrain_skirt_grid_position in terrain_vertex.cpp
+float2 get_skirt_grid_position(uint skirt_index) {
+    const uint edge_length = TERRAIN_GRID_SIZE - 1;
+    const uint side = skirt_index / edge_length;
+    const uint offset = skirt_index % edge_length;
+
+    if(side == 0) {
+        return float2(offset, 0);
+    } else if(side == 1) {
+        return float2(edge_length, offset);
+    } else if(side == 2) {
+        return float2(edge_length - offset, edge_length);
+    } else {
+        return float2(0, edge_length - offset);
+    }
+}
+
+VertexOutput main(TerrainVertex input, uint vertex_id : SV_VertexID) {
     VertexOutput output;
 
     Camera camera = cameras[constants.camera_index];
-    MaterialData material = material_buffer[constants.material_index];
+    float4x4 model_matrix = model_matrices[constants.model_matrix_index];
 
-    output.position_worldspace = mul(material.model_matrix, float4(input.position, 1)).xyz;
+    // Terrain tiles are regular grids, so the vertex's position in the tile comes from its index. SV_VertexID doesn't include the base
+    // vertex, so this is the index within the tile. The skirt vertices come after the grid
+    const uint num_grid_vertices = TERRAIN_GRID_SIZE * TERRAIN_GRID_SIZE;
+    const float2 grid_position = vertex_id < num_grid_vertices ?
+                                     float2(vertex_id % TERRAIN_GRID_SIZE, vertex_id / TERRAIN_GRID_SIZE) :
+                                     get_skirt_grid_position(vertex_id - num_grid_vertices);
+
+    // The model matrix scales the grid to the tile's texel size, and the normalized height into the tile's height range
+    output.position_worldspace = mul(model_matrix, float4(grid_position.x, input.height, grid_position.y, 1)).xyz;
     output.position = mul(camera.projection, mul(camera.view, float4(output.position_worldspace, 1)));
-    output.normal = input.normal;
-    output.color = input.color;
-    output.texcoord = input.texcoord;
+    output.normal = decode_octahedral_normal(input.encoded_normal);
+    output.color = float4(1, 1, 1, 1);
+
+    // Use world-space texcoords so that textures line up across tiles with different levels of detail
+    output.texcoord = output.position_worldspace.xz;
 
     return output;
 }
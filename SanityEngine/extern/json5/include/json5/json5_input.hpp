@@ -504,7 +504,8 @@ inline error parser::parse_literal( token_type &result )
 //---------------------------------------------------------------------------------------------------------------------
 inline error from_stream( std::istream &is, document &doc )
 {
-	parser r( doc, detail::stl_istream( is ) );
+	detail::stl_istream src( is );
+	parser r( doc, src );
 	return r.parse();
 }
 
@@ -1,6 +1,8 @@
 #ifndef RX_CORE_UNINITIALIZED_H
 #define RX_CORE_UNINITIALIZED_H
 #include "rx/core/memory/uninitialized_storage.h"
+#include "rx/core/utility/construct.h"
+#include "rx/core/utility/destruct.h"
 
 namespace Rx {
 
@@ -3,8 +3,13 @@
 #include <cstdio>
 
 namespace rex {
+#ifdef _WIN32
     StdoutStream::StdoutStream() : Stream(k_flush | k_write), fileyboi{freopen("CON", "wb", stdout)} {
     }
+#else
+    // There's no CON device outside of Windows, and stdout is already the console
+    StdoutStream::StdoutStream() : Stream(k_flush | k_write), fileyboi{stdout} {}
+#endif
 
     StdoutStream::~StdoutStream() { fclose(fileyboi); }
 
@@ -0,0 +1,45 @@
+#include "epoch_reclaimer.hpp"
+
+/*!
+ * \brief Hands out reader stripes to threads round-robin
+ */
+static Rx::Concurrency::Atomic<Uint32> next_stripe{0};
+
+EpochReclaimer::ReadGuard::ReadGuard(Rx::Concurrency::Atomic<Uint32>& counter_in) : counter{&counter_in} {}
+
+EpochReclaimer::ReadGuard::~ReadGuard() { counter->fetch_sub(1); }
+
+EpochReclaimer::ReadGuard EpochReclaimer::enter() const {
+    thread_local const auto stripe_index = next_stripe.fetch_add(1) % NUM_STRIPES;
+    auto& stripe = stripes[stripe_index];
+
+    while(true) {
+        const auto current_epoch = epoch.load();
+        auto& counter = stripe.num_readers[current_epoch & 1];
+        counter.fetch_add(1);
+
+        // If the writer advanced while we were registering, it might have already checked our counter and decided that the old data was
+        // free. Back out and register with the new epoch instead
+        if(epoch.load() == current_epoch) {
+            return ReadGuard{counter};
+        }
+
+        counter.fetch_sub(1);
+    }
+}
+
+void EpochReclaimer::advance() { epoch.fetch_add(1); }
+
+bool EpochReclaimer::is_previous_epoch_quiescent() const {
+    const auto previous_epoch = epoch.load() - 1;
+    return get_num_readers(static_cast<Uint32>(previous_epoch & 1)) == 0;
+}
+
+Uint32 EpochReclaimer::get_num_readers(const Uint32 parity) const {
+    Uint32 num_readers = 0;
+    for(const auto& stripe : stripes) {
+        num_readers += stripe.num_readers[parity].load();
+    }
+
+    return num_readers;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/atomic.h"
+
+/*!
+ * \brief Lets readers use shared data without locks, and tells the writer when old data is safe to free
+ *
+ * This is a minimal epoch-based reclamation scheme for data with one writer and any number of readers:
+ *
+ * - Readers call `enter` before loading the shared pointer, and keep the returned guard alive for as long as they use the data
+ * - The writer publishes new data by swapping the shared pointer, then calls `advance`. The old data may still be in use by readers who
+ *   entered before the advance
+ * - Once `is_previous_epoch_quiescent` returns true, every reader who could see the old data has left, and the writer may free it. The
+ *   writer must not call `advance` again until then
+ *
+ * Readers only touch a counter that's shared with a few other threads, so they scale with the number of threads instead of fighting over
+ * one mutex. The writer never blocks either, it just checks again later
+ */
+class EpochReclaimer {
+public:
+    /*!
+     * \brief Marks the current thread as reading the shared data until the guard is destroyed
+     */
+    class ReadGuard {
+        friend class EpochReclaimer;
+
+    public:
+        ReadGuard(const ReadGuard& other) = delete;
+        ReadGuard& operator=(const ReadGuard& other) = delete;
+
+        ReadGuard(ReadGuard&& old) noexcept = delete;
+        ReadGuard& operator=(ReadGuard&& old) noexcept = delete;
+
+        ~ReadGuard();
+
+    private:
+        explicit ReadGuard(Rx::Concurrency::Atomic<Uint32>& counter_in);
+
+        Rx::Concurrency::Atomic<Uint32>* counter;
+    };
+
+    EpochReclaimer() = default;
+
+    EpochReclaimer(const EpochReclaimer& other) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer& other) = delete;
+
+    EpochReclaimer(EpochReclaimer&& old) noexcept = delete;
+    EpochReclaimer& operator=(EpochReclaimer&& old) noexcept = delete;
+
+    /*!
+     * \brief Enters the current epoch. Load the shared pointer after calling this, not before
+     */
+    [[nodiscard]] ReadGuard enter() const;
+
+    /*!
+     * \brief Starts a new epoch. Call this right after publishing new data
+     *
+     * Must only be called by the writer, and only when `is_previous_epoch_quiescent` is true
+     */
+    void advance();
+
+    /*!
+     * \brief Checks if every reader who entered before the last `advance` has left
+     */
+    [[nodiscard]] bool is_previous_epoch_quiescent() const;
+
+private:
+    /*!
+     * \brief Number of sets of reader counters. Threads are spread across them so that readers on different threads rarely share a cache
+     * line
+     */
+    static constexpr Uint32 NUM_STRIPES = 32;
+
+    /*!
+     * \brief Number of readers in each of the two most recent epochs, indexed by the epoch's parity
+     */
+    struct alignas(64) Stripe {
+        mutable Rx::Concurrency::Atomic<Uint32> num_readers[2]{};
+    };
+
+    Rx::Concurrency::Atomic<Uint64> epoch{0};
+
+    Stripe stripes[NUM_STRIPES]{};
+
+    [[nodiscard]] Uint32 get_num_readers(Uint32 parity) const;
+};
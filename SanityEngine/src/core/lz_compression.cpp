@@ -0,0 +1,235 @@
+#include "lz_compression.hpp"
+
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/min.h"
+
+/*!
+ * \brief Matches shorter than this aren't worth the three bytes that a match costs
+ */
+constexpr Size LZ_MIN_MATCH_LENGTH = 4;
+
+/*!
+ * \brief Matches may reach at most this far back, so that the offset fits in two bytes
+ */
+constexpr Size LZ_MAX_MATCH_OFFSET = 65535;
+
+/*!
+ * \brief The data always ends with at least this many literal bytes, so that the decompressor may finish with a plain copy
+ */
+constexpr Size LZ_NUM_LAST_LITERALS = 5;
+
+/*!
+ * \brief Matches must start at least this far before the end of the data
+ */
+constexpr Size LZ_MATCH_START_MARGIN = 12;
+
+constexpr Uint32 LZ_HASH_BITS = 12;
+
+/*!
+ * \brief The four bits of a sequence's token that hold a length can't hold this value or more, so longer lengths continue in the bytes
+ * after the token
+ */
+constexpr Size LZ_TOKEN_LENGTH_LIMIT = 15;
+
+/*!
+ * \brief The compressor checks for a match one byte further on each time it fails to find one this many times in a row
+ */
+constexpr Uint32 LZ_SKIP_STRENGTH = 6;
+
+static Uint32 read_uint32(const Byte* bytes) {
+    Uint32 value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static Uint32 hash_four_bytes(const Uint32 bytes) { return (bytes * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+static Byte* write_length_continuation(Byte* output, Size length) {
+    while(length >= 255) {
+        *output++ = 255;
+        length -= 255;
+    }
+    *output++ = static_cast<Byte>(length);
+
+    return output;
+}
+
+/*!
+ * \brief Writes one sequence
+ *
+ * \param match_length Length of the sequence's match, or zero for the last sequence, which only has literals
+ */
+static Byte* write_sequence(Byte* output,
+                            const Byte* literals,
+                            const Size num_literals,
+                            const Size match_offset,
+                            const Size match_length) {
+    auto* token = output++;
+    *token = static_cast<Byte>(Rx::Algorithm::min(num_literals, LZ_TOKEN_LENGTH_LIMIT) << 4);
+    if(num_literals >= LZ_TOKEN_LENGTH_LIMIT) {
+        output = write_length_continuation(output, num_literals - LZ_TOKEN_LENGTH_LIMIT);
+    }
+
+    // Empty input has no literals to point at, and memcpy mustn't be handed a null pointer even for zero bytes
+    if(num_literals > 0) {
+        memcpy(output, literals, num_literals);
+        output += num_literals;
+    }
+
+    if(match_length == 0) {
+        return output;
+    }
+
+    *output++ = static_cast<Byte>(match_offset & 0xFF);
+    *output++ = static_cast<Byte>(match_offset >> 8);
+
+    const auto match_length_code = match_length - LZ_MIN_MATCH_LENGTH;
+    *token |= static_cast<Byte>(Rx::Algorithm::min(match_length_code, LZ_TOKEN_LENGTH_LIMIT));
+    if(match_length_code >= LZ_TOKEN_LENGTH_LIMIT) {
+        output = write_length_continuation(output, match_length_code - LZ_TOKEN_LENGTH_LIMIT);
+    }
+
+    return output;
+}
+
+/*!
+ * \brief Reads the bytes that continue a length from a sequence's token
+ *
+ * \return Whether the length ended before the compressed data did
+ */
+static bool read_length_continuation(const std::span<const Byte> compressed_data, Size& read_position, Size& length) {
+    Byte next_byte;
+    do {
+        if(read_position >= compressed_data.size()) {
+            return false;
+        }
+
+        next_byte = compressed_data[read_position++];
+        length += next_byte;
+    } while(next_byte == 255);
+
+    return true;
+}
+
+Size get_lz_compressed_bound(const Size num_bytes) { return num_bytes + num_bytes / 255 + 16; }
+
+Rx::Vector<Byte> lz_compress(const std::span<const Byte> data) {
+    ZoneScoped;
+
+    Rx::Vector<Byte> compressed_data;
+    compressed_data.resize(get_lz_compressed_bound(data.size()));
+
+    const auto* input = data.data();
+    auto* output = compressed_data.data();
+
+    // Start of the literals that haven't been written yet
+    Size anchor = 0;
+
+    if(data.size() > LZ_MATCH_START_MARGIN) {
+        // Position of the last four bytes with each hash. Zero is a fine starting value, since position zero is never a match for itself
+        Uint32 last_positions[1 << LZ_HASH_BITS]{};
+
+        const auto match_start_limit = data.size() - LZ_MATCH_START_MARGIN;
+        const auto match_end_limit = data.size() - LZ_NUM_LAST_LITERALS;
+
+        Size position = 0;
+        Uint32 num_misses = 0;
+        while(position < match_start_limit) {
+            const auto bytes = read_uint32(input + position);
+            const auto hash = hash_four_bytes(bytes);
+            const Size candidate = last_positions[hash];
+            last_positions[hash] = static_cast<Uint32>(position);
+
+            if(candidate >= position || position - candidate > LZ_MAX_MATCH_OFFSET || read_uint32(input + candidate) != bytes) {
+                position += 1 + (num_misses++ >> LZ_SKIP_STRENGTH);
+                continue;
+            }
+
+            auto match_length = LZ_MIN_MATCH_LENGTH;
+            while(position + match_length < match_end_limit && input[candidate + match_length] == input[position + match_length]) {
+                match_length++;
+            }
+
+            output = write_sequence(output, input + anchor, position - anchor, position - candidate, match_length);
+
+            position += match_length;
+            anchor = position;
+            num_misses = 0;
+        }
+    }
+
+    output = write_sequence(output, input + anchor, data.size() - anchor, 0, 0);
+
+    compressed_data.resize(static_cast<Size>(output - compressed_data.data()));
+
+    return compressed_data;
+}
+
+bool lz_decompress(const std::span<const Byte> compressed_data, const std::span<Byte> data) {
+    ZoneScoped;
+
+    Size read_position = 0;
+    Size write_position = 0;
+
+    while(read_position < compressed_data.size()) {
+        const auto token = compressed_data[read_position++];
+
+        Size num_literals = token >> 4;
+        if(num_literals == LZ_TOKEN_LENGTH_LIMIT && !read_length_continuation(compressed_data, read_position, num_literals)) {
+            return false;
+        }
+
+        if(num_literals > compressed_data.size() - read_position || num_literals > data.size() - write_position) {
+            return false;
+        }
+
+        if(num_literals > 0) {
+            memcpy(data.data() + write_position, compressed_data.data() + read_position, num_literals);
+            read_position += num_literals;
+            write_position += num_literals;
+        }
+
+        // The last sequence has no match
+        if(read_position == compressed_data.size()) {
+            break;
+        }
+
+        if(compressed_data.size() - read_position < 2) {
+            return false;
+        }
+
+        const Size match_offset = compressed_data[read_position] | (static_cast<Size>(compressed_data[read_position + 1]) << 8);
+        read_position += 2;
+        if(match_offset == 0 || match_offset > write_position) {
+            return false;
+        }
+
+        Size match_length = token & 0xF;
+        if(match_length == LZ_TOKEN_LENGTH_LIMIT && !read_length_continuation(compressed_data, read_position, match_length)) {
+            return false;
+        }
+
+        match_length += LZ_MIN_MATCH_LENGTH;
+        if(match_length > data.size() - write_position) {
+            return false;
+        }
+
+        // A match that overlaps the bytes it's copying repeats them. Each copy doubles the number of repeated bytes behind the destination,
+        // so long runs of a short pattern only take a handful of copies
+        auto* destination = data.data() + write_position;
+        const auto* source = destination - match_offset;
+        auto num_bytes_left = match_length;
+        while(num_bytes_left > 0) {
+            const auto num_bytes = Rx::Algorithm::min(static_cast<Size>(destination - source), num_bytes_left);
+            memcpy(destination, source, num_bytes);
+            destination += num_bytes;
+            num_bytes_left -= num_bytes;
+        }
+
+        write_position += match_length;
+    }
+
+    return write_position == data.size();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+/*!
+ * \brief Largest number of bytes that `lz_compress` can turn `num_bytes` bytes into
+ */
+[[nodiscard]] Size get_lz_compressed_bound(Size num_bytes);
+
+/*!
+ * \brief Compresses bytes with a fast LZ77 codec
+ *
+ * The output is a series of sequences, each one a run of literal bytes followed by a match that copies earlier output. Matches are found
+ * with a single hash table lookup on the next four bytes, and the compressor skips ahead faster the longer it goes without finding one,
+ * so data that doesn't compress costs little more than a copy. This trades some compression ratio for speed: it's meant for data that
+ * gets saved and loaded while the game runs, like voxel chunks and terrain tiles
+ *
+ * The layout of the sequences is the same as an LZ4 block's
+ */
+[[nodiscard]] Rx::Vector<Byte> lz_compress(std::span<const Byte> data);
+
+/*!
+ * \brief Decompresses bytes that `lz_compress` made
+ *
+ * \param compressed_data The compressed bytes
+ * \param data Where to put the decompressed bytes. Must be exactly the size of the data before it was compressed
+ *
+ * \return Whether the compressed bytes were valid and decompressed into exactly `data.size()` bytes. Never reads or writes out of bounds,
+ * even if the compressed bytes are damaged
+ */
+[[nodiscard]] bool lz_decompress(std::span<const Byte> compressed_data, std::span<Byte> data);
@@ -0,0 +1,212 @@
+#include "mapped_file.hpp"
+
+#include "rx/core/config.h"
+#include "rx/core/log.h"
+
+#if defined(RX_PLATFORM_POSIX)
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(RX_PLATFORM_WINDOWS)
+#include <Windows.h>
+
+#include "windows/windows_helpers.hpp"
+#else
+#error "MappedFile doesn't support this platform"
+#endif
+
+RX_LOG("MappedFile", logger);
+
+#if defined(RX_PLATFORM_POSIX)
+MappedFile::MappedFile(const Rx::String& path) {
+    const auto file = open(path.data(), O_RDONLY);
+    if(file < 0) {
+        if(errno != ENOENT) {
+            logger->error("Could not open %s: %s", path, strerror(errno));
+        }
+        return;
+    }
+
+    struct stat file_info {};
+    if(fstat(file, &file_info) != 0) {
+        logger->error("Could not get the size of %s: %s", path, strerror(errno));
+        close(file);
+        return;
+    }
+
+    // Empty files can't be mapped. They stay closed, since there's nothing to read from them anyway
+    if(file_info.st_size > 0) {
+        auto* data = mmap(nullptr, static_cast<Size>(file_info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if(data == MAP_FAILED) {
+            logger->error("Could not map %s: %s", path, strerror(errno));
+        } else {
+            mapped_data = static_cast<Byte*>(data);
+            size = static_cast<Size>(file_info.st_size);
+        }
+    }
+
+    // The mapping keeps its own reference to the file
+    close(file);
+}
+
+MappedFile::MappedFile(const Rx::String& path, const Size size_in) {
+    const auto file = open(path.data(), O_RDWR | O_CREAT, 0644);
+    if(file < 0) {
+        logger->error("Could not open %s: %s", path, strerror(errno));
+        return;
+    }
+
+    struct stat file_info {};
+    if(fstat(file, &file_info) != 0) {
+        logger->error("Could not get the size of %s: %s", path, strerror(errno));
+        close(file);
+        return;
+    }
+
+    // Growing the file fills the new space with zeros
+    if(static_cast<Size>(file_info.st_size) < size_in && ftruncate(file, static_cast<off_t>(size_in)) != 0) {
+        logger->error("Could not grow %s to %zu bytes: %s", path, size_in, strerror(errno));
+        close(file);
+        return;
+    }
+
+    auto* data = mmap(nullptr, size_in, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if(data == MAP_FAILED) {
+        logger->error("Could not map %s: %s", path, strerror(errno));
+    } else {
+        mapped_data = static_cast<Byte*>(data);
+        size = size_in;
+        writable = true;
+    }
+
+    // The mapping keeps its own reference to the file
+    close(file);
+}
+
+MappedFile::~MappedFile() {
+    if(mapped_data != nullptr) {
+        flush();
+        munmap(mapped_data, size);
+    }
+}
+
+void MappedFile::flush() const {
+    if(writable && mapped_data != nullptr) {
+        msync(mapped_data, size, MS_ASYNC);
+    }
+}
+
+#elif defined(RX_PLATFORM_WINDOWS)
+MappedFile::MappedFile(const Rx::String& path) {
+    auto* file = CreateFileA(path.data(),
+                             GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_DELETE,
+                             nullptr,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        const auto error = GetLastError();
+        if(error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND) {
+            logger->error("Could not open %s: %s", path, get_last_windows_error());
+        }
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size)) {
+        logger->error("Could not get the size of %s: %s", path, get_last_windows_error());
+        CloseHandle(file);
+        return;
+    }
+
+    // Empty files can't be mapped. They stay closed, since there's nothing to read from them anyway
+    if(file_size.QuadPart > 0) {
+        auto* file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(file_mapping == nullptr) {
+            logger->error("Could not map %s: %s", path, get_last_windows_error());
+        } else {
+            mapped_data = static_cast<Byte*>(MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0));
+            if(mapped_data == nullptr) {
+                logger->error("Could not map a view of %s: %s", path, get_last_windows_error());
+            } else {
+                size = static_cast<Size>(file_size.QuadPart);
+            }
+
+            // The view keeps its own reference to the mapping
+            CloseHandle(file_mapping);
+        }
+    }
+
+    CloseHandle(file);
+}
+
+MappedFile::MappedFile(const Rx::String& path, const Size size_in) {
+    auto* file = CreateFileA(path.data(),
+                             GENERIC_READ | GENERIC_WRITE,
+                             FILE_SHARE_READ,
+                             nullptr,
+                             OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        logger->error("Could not open %s: %s", path, get_last_windows_error());
+        return;
+    }
+
+    // Mapping more of the file than it has grows the file. The new space reads as zeros
+    auto* file_mapping = CreateFileMappingA(file,
+                                            nullptr,
+                                            PAGE_READWRITE,
+                                            static_cast<DWORD>(static_cast<Uint64>(size_in) >> 32),
+                                            static_cast<DWORD>(size_in & 0xFFFFFFFF),
+                                            nullptr);
+    if(file_mapping == nullptr) {
+        logger->error("Could not map %s: %s", path, get_last_windows_error());
+    } else {
+        mapped_data = static_cast<Byte*>(MapViewOfFile(file_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_in));
+        if(mapped_data == nullptr) {
+            logger->error("Could not map a view of %s: %s", path, get_last_windows_error());
+        } else {
+            size = size_in;
+            writable = true;
+        }
+
+        // The view keeps its own reference to the mapping
+        CloseHandle(file_mapping);
+    }
+
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile() {
+    if(mapped_data != nullptr) {
+        flush();
+        UnmapViewOfFile(mapped_data);
+    }
+}
+
+void MappedFile::flush() const {
+    if(writable && mapped_data != nullptr) {
+        FlushViewOfFile(mapped_data, 0);
+    }
+}
+#endif
+
+bool MappedFile::is_open() const { return mapped_data != nullptr; }
+
+std::span<const Byte> MappedFile::get_data() const { return {mapped_data, size}; }
+
+bool MappedFile::is_writable() const { return writable; }
+
+std::span<Byte> MappedFile::get_writable_data() const {
+    if(!writable) {
+        return {};
+    }
+
+    return {mapped_data, size};
+}
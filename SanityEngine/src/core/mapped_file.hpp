@@ -0,0 +1,68 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/string.h"
+
+/*!
+ * \brief A view of a whole file through a memory mapping, either read-only or writable
+ *
+ * Reading from the view only pages in the parts of the file that get touched, so opening a big file costs the same as opening a small one.
+ * The view stays valid even if the file is replaced while it's mapped, but on Windows a mapped file can't be replaced, so unmap files
+ * before writing over them
+ *
+ * Writes to a writable view go to the file itself rather than a private copy, and reach the disk when the view is flushed or unmapped
+ */
+class MappedFile {
+public:
+    /*!
+     * \brief Maps a file
+     *
+     * If the file can't be opened or mapped, the error is logged and the file stays closed. A file that doesn't exist isn't an error, it
+     * just leaves the file closed
+     */
+    explicit MappedFile(const Rx::String& path);
+
+    /*!
+     * \brief Maps the first `size` bytes of a file for reading and writing
+     *
+     * The file is created if it doesn't exist, and grown to `size` bytes if it's smaller. The new bytes read as zeros. If the file can't
+     * be created, grown, or mapped, the error is logged and the file stays closed
+     */
+    MappedFile(const Rx::String& path, Size size);
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    MappedFile(MappedFile&& old) noexcept = delete;
+    MappedFile& operator=(MappedFile&& old) noexcept = delete;
+
+    ~MappedFile();
+
+    [[nodiscard]] bool is_open() const;
+
+    /*!
+     * \brief The file's contents, or an empty span if the file is closed
+     */
+    [[nodiscard]] std::span<const Byte> get_data() const;
+
+    [[nodiscard]] bool is_writable() const;
+
+    /*!
+     * \brief The file's contents, or an empty span if the file is closed or read-only
+     */
+    [[nodiscard]] std::span<Byte> get_writable_data() const;
+
+    /*!
+     * \brief Starts writing everything that was written to the view to the disk. Does nothing if the file is closed or read-only
+     */
+    void flush() const;
+
+private:
+    Byte* mapped_data{nullptr};
+
+    Size size{0};
+
+    bool writable{false};
+};
@@ -14,18 +14,22 @@ using Uint16 = Rx::Uint16;
 using Uint32 = Rx::Uint32;
 using Uint64 = Rx::Uint64;
 
+using Int16 = Rx::Sint16;
 using Int32 = Rx::Sint32;
 using Int64 = Rx::Sint64;
 
 using Float32 = Rx::Float32;
+using Float64 = Rx::Float64;
 
 using Rx::Math::Vec2f;
 using Rx::Math::Vec2i;
 using Vec2u = Rx::Math::Vec2<Uint32>;
+using Vec2d = Rx::Math::Vec2<Float64>;
 
 using Rx::Math::Vec3f;
 using Rx::Math::Vec3i;
 using Vec3u = Rx::Math::Vec3<Uint32>;
+using Vec3d = Rx::Math::Vec3<Float64>;
 
 using Rx::Math::Vec4f;
 using Rx::Math::Vec4i;
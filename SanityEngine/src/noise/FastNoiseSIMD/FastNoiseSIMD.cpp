@@ -31,6 +31,8 @@
 #include <stdlib.h>
 #include <algorithm>
 #include <cstdint>
+#include <math.h>
+#include <vector>
 
 #ifdef FN_COMPILE_NO_SIMD_FALLBACK
 #define SIMD_LEVEL_H FN_NO_SIMD_FALLBACK
@@ -439,6 +441,177 @@ void FastNoiseSIMD::FillNoiseSet(float* noiseSet, int xStart, int yStart, int zS
 	}
 }
 
+bool FastNoiseSIMD::FillNoiseSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier)
+{
+	switch (m_noiseType)
+	{
+	case Perlin:
+		FillPerlinSetWithDerivatives(noiseSet, xDerivSet, yDerivSet, zDerivSet, xStart, yStart, zStart, xSize, ySize, zSize, scaleModifier);
+		return true;
+	case PerlinFractal:
+		FillPerlinFractalSetWithDerivatives(noiseSet, xDerivSet, yDerivSet, zDerivSet, xStart, yStart, zStart, xSize, ySize, zSize, scaleModifier);
+		return true;
+	case Simplex:
+		FillSimplexSetWithDerivatives(noiseSet, xDerivSet, yDerivSet, zDerivSet, xStart, yStart, zStart, xSize, ySize, zSize, scaleModifier);
+		return true;
+	case SimplexFractal:
+		FillSimplexFractalSetWithDerivatives(noiseSet, xDerivSet, yDerivSet, zDerivSet, xStart, yStart, zStart, xSize, ySize, zSize, scaleModifier);
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Must match xPrime, yPrime and zPrime in FastNoiseSIMD_internal.cpp
+static const uint64_t originXPrime = 1619;
+static const uint64_t originYPrime = 31337;
+static const uint64_t originZPrime = 6971;
+
+// Multiplies a lattice cell by its axis prime, wrapping the same way the SIMD kernels' 32-bit multiplies do
+static int HashOriginCell(int64_t cell, uint64_t prime)
+{
+	return static_cast<int>(static_cast<uint32_t>(static_cast<uint64_t>(cell) * prime));
+}
+
+bool FastNoiseSIMD::GetOriginOctaves(std::vector<FastNoiseOriginOctave>& octaves, double xOrigin, double yOrigin, double zOrigin, float scaleModifier) const
+{
+	bool fractal;
+	switch (m_noiseType)
+	{
+	case Value:
+	case Perlin:
+	case Simplex:
+		fractal = false;
+		break;
+	case ValueFractal:
+	case PerlinFractal:
+	case SimplexFractal:
+		fractal = true;
+		break;
+	default:
+		return false;
+	}
+
+	octaves.resize(fractal ? std::max(m_octaves, 1) : 1);
+
+	// Work in doubles until the origin has been split, so the lattice cell is exact
+	double frequency = static_cast<double>(scaleModifier) * m_frequency;
+
+	for (FastNoiseOriginOctave& octave : octaves)
+	{
+		double xStep = frequency * m_xScale;
+		double yStep = frequency * m_yScale;
+		double zStep = frequency * m_zScale;
+
+		double x = xOrigin * xStep;
+		double y = yOrigin * yStep;
+		double z = zOrigin * zStep;
+
+		int64_t xCell = static_cast<int64_t>(floor(x));
+		int64_t yCell = static_cast<int64_t>(floor(y));
+		int64_t zCell = static_cast<int64_t>(floor(z));
+
+		int64_t xLattice = xCell;
+		int64_t yLattice = yCell;
+		int64_t zLattice = zCell;
+
+		if (m_noiseType == Simplex || m_noiseType == SimplexFractal)
+		{
+			// Simplex skews its lattice along (1, 1, 1), so a cell only lines up with the skewed lattice if its coordinates add up to a
+			// multiple of 3. Move the cell back along z until they do, then skew it like SimplexSingle skews its coordinates
+			int64_t remainder = ((xCell + yCell + zCell) % 3 + 3) % 3;
+			zCell -= remainder;
+
+			int64_t skew = (xCell + yCell + zCell) / 3;
+			xLattice = xCell + skew;
+			yLattice = yCell + skew;
+			zLattice = zCell + skew;
+		}
+
+		octave.xOffset = static_cast<float>(x - static_cast<double>(xCell));
+		octave.yOffset = static_cast<float>(y - static_cast<double>(yCell));
+		octave.zOffset = static_cast<float>(z - static_cast<double>(zCell));
+
+		octave.xStep = static_cast<float>(xStep);
+		octave.yStep = static_cast<float>(yStep);
+		octave.zStep = static_cast<float>(zStep);
+
+		octave.xHash = HashOriginCell(xLattice, originXPrime);
+		octave.yHash = HashOriginCell(yLattice, originYPrime);
+		octave.zHash = HashOriginCell(zLattice, originZPrime);
+
+		frequency *= m_lacunarity;
+	}
+
+	return true;
+}
+
+bool FastNoiseSIMD::FillNoiseSetAtOrigin(float* noiseSet, double xOrigin, double yOrigin, double zOrigin, int xSize, int ySize, int zSize, float scaleModifier)
+{
+	std::vector<FastNoiseOriginOctave> octaves;
+	if (!GetOriginOctaves(octaves, xOrigin, yOrigin, zOrigin, scaleModifier))
+		return false;
+
+	switch (m_noiseType)
+	{
+	case Value:
+		FillValueSetAtOrigin(noiseSet, octaves.data(), xSize, ySize, zSize);
+		break;
+	case ValueFractal:
+		FillValueFractalSetAtOrigin(noiseSet, octaves.data(), xSize, ySize, zSize);
+		break;
+	case Perlin:
+		FillPerlinSetAtOrigin(noiseSet, octaves.data(), xSize, ySize, zSize);
+		break;
+	case PerlinFractal:
+		FillPerlinFractalSetAtOrigin(noiseSet, octaves.data(), xSize, ySize, zSize);
+		break;
+	case Simplex:
+		FillSimplexSetAtOrigin(noiseSet, octaves.data(), xSize, ySize, zSize);
+		break;
+	case SimplexFractal:
+		FillSimplexFractalSetAtOrigin(noiseSet, octaves.data(), xSize, ySize, zSize);
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+bool FastNoiseSIMD::FillNoiseSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, double xOrigin, double yOrigin, double zOrigin)
+{
+	std::vector<FastNoiseOriginOctave> octaves;
+	if (!GetOriginOctaves(octaves, xOrigin, yOrigin, zOrigin, 1.0f))
+		return false;
+
+	switch (m_noiseType)
+	{
+	case Value:
+		FillValueSetAtOrigin(noiseSet, vectorSet, octaves.data());
+		break;
+	case ValueFractal:
+		FillValueFractalSetAtOrigin(noiseSet, vectorSet, octaves.data());
+		break;
+	case Perlin:
+		FillPerlinSetAtOrigin(noiseSet, vectorSet, octaves.data());
+		break;
+	case PerlinFractal:
+		FillPerlinFractalSetAtOrigin(noiseSet, vectorSet, octaves.data());
+		break;
+	case Simplex:
+		FillSimplexSetAtOrigin(noiseSet, vectorSet, octaves.data());
+		break;
+	case SimplexFractal:
+		FillSimplexFractalSetAtOrigin(noiseSet, vectorSet, octaves.data());
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
 void FastNoiseSIMD::FillNoiseSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset, float yOffset, float zOffset)
 {
 	switch (m_noiseType)
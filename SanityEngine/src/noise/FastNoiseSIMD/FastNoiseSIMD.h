@@ -31,6 +31,8 @@
 #ifndef FASTNOISE_SIMD_H
 #define FASTNOISE_SIMD_H
 
+#include <vector>
+
 #if defined(__arm__) || defined(__aarch64__)
 #define FN_ARM
 //#define FN_IOS
@@ -97,6 +99,7 @@ Intel Skylake-X - Q2 2017
 */
 
 struct FastNoiseVectorSet;
+struct FastNoiseOriginOctave;
 
 class FastNoiseSIMD
 {
@@ -165,6 +168,12 @@ public:
 	// Defaults: 1.0
 	void SetAxisScales(float xScale, float yScale, float zScale) { m_xScale = xScale; m_yScale = yScale; m_zScale = zScale; }
 
+	// Sets a remap applied to every value as it's stored: value * scale + offset
+	// Much cheaper than a second pass over the set, since the values are still in registers
+	// Applies to every noise type. Sampled sets remap their samples before interpolating them, which comes out the same
+	// Defaults: 1.0, 0.0
+	void SetOutputRemap(float scale, float offset) { m_outputScale = scale; m_outputOffset = offset; }
+
 
 	// Sets octave count for all fractal noise types
 	// Default: 3
@@ -250,6 +259,22 @@ public:
 	void FillNoiseSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
 	void FillNoiseSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f);
 
+	// Fills noiseSet like FillNoiseSet(), and the derivative sets with the noise's partial derivatives along each axis, in the same pass
+	// Derivatives are per unit of the set coordinates, and include frequency, axis scales, scaleModifier and the output remap scale
+	// Only Perlin, PerlinFractal, Simplex and SimplexFractal have derivatives, returns false without filling anything for other types
+	// Perturb is ignored
+	bool FillNoiseSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
+
+	// Fills noiseSet like FillNoiseSet(), with the first value at a double precision origin instead of an int start, for sets far from 0
+	// Each octave's origin is split into a lattice cell, which is hashed with 64-bit integers, and a float offset from that cell
+	// The SIMD kernels only see the offset, so precision depends on the size of the set and not on how far the origin is from 0
+	// Lattice cells wrap every 2^32 cells, the same as FillNoiseSet()
+	// Only Value, ValueFractal, Perlin, PerlinFractal, Simplex and SimplexFractal are supported, returns false without filling anything for other types
+	// Perturb is ignored
+	bool FillNoiseSetAtOrigin(float* noiseSet, double xOrigin, double yOrigin, double zOrigin, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
+	// Same again for a vector set, whose positions are relative to the origin
+	bool FillNoiseSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, double xOrigin, double yOrigin, double zOrigin);
+
 	float* GetSampledNoiseSet(int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, int sampleScale);
 	virtual void FillSampledNoiseSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, int sampleScale) = 0;
 	virtual void FillSampledNoiseSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
@@ -264,6 +289,10 @@ public:
 	virtual void FillValueFractalSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
 	virtual void FillValueSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
 	virtual void FillValueFractalSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
+	virtual void FillValueSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) = 0;
+	virtual void FillValueFractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) = 0;
+	virtual void FillValueSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) = 0;
+	virtual void FillValueFractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) = 0;
 
 	float* GetPerlinSet(int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
 	float* GetPerlinFractalSet(int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
@@ -271,6 +300,12 @@ public:
 	virtual void FillPerlinFractalSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
 	virtual void FillPerlinSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
 	virtual void FillPerlinFractalSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
+	virtual void FillPerlinSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) = 0;
+	virtual void FillPerlinFractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) = 0;
+	virtual void FillPerlinSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) = 0;
+	virtual void FillPerlinFractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) = 0;
+	virtual void FillPerlinSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
+	virtual void FillPerlinFractalSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
 
 	float* GetSimplexSet(int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
 	float* GetSimplexFractalSet(int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
@@ -278,6 +313,12 @@ public:
 	virtual void FillSimplexFractalSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
 	virtual void FillSimplexSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
 	virtual void FillSimplexFractalSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) = 0;
+	virtual void FillSimplexSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) = 0;
+	virtual void FillSimplexFractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) = 0;
+	virtual void FillSimplexSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) = 0;
+	virtual void FillSimplexFractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) = 0;
+	virtual void FillSimplexSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
+	virtual void FillSimplexFractalSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
 
 	float* GetCellularSet(int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f);
 	virtual void FillCellularSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) = 0;
@@ -301,6 +342,9 @@ protected:
 	float m_yScale = 1.0f;
 	float m_zScale = 1.0f;
 
+	float m_outputScale = 1.0f;
+	float m_outputOffset = 0.0f;
+
 	int m_octaves = 3;
 	float m_lacunarity = 2.0f;
 	float m_gain = 0.5f;
@@ -316,7 +360,7 @@ protected:
 	float m_cellularJitter = 0.45f;
 
 	PerturbType m_perturbType = None;
-	float m_perturbAmp = 1.0f;
+	float m_perturbAmp = 1.0f / 511.5f;
 	float m_perturbFrequency = 0.5f;
 
 	int m_perturbOctaves = 3;
@@ -327,6 +371,9 @@ protected:
 
 	static int s_currentSIMDLevel;
 	static float CalculateFractalBounding(int octaves, float gain);
+
+	// Splits the origin for every octave of the current noise type, returns false for types that can't be filled at an origin
+	bool GetOriginOctaves(std::vector<FastNoiseOriginOctave>& octaves, double xOrigin, double yOrigin, double zOrigin, float scaleModifier) const;
 };
 
 struct FastNoiseVectorSet
@@ -354,6 +401,25 @@ public:
 	void SetSize(int _size);
 };
 
+// One octave of a FillNoiseSetAtOrigin() set
+struct FastNoiseOriginOctave
+{
+	// Offset of the first value from the lattice cell at the origin, in noise coordinates
+	float xOffset = 0.0f;
+	float yOffset = 0.0f;
+	float zOffset = 0.0f;
+
+	// Distance between neighbouring values, in noise coordinates
+	float xStep = 0.0f;
+	float yStep = 0.0f;
+	float zStep = 0.0f;
+
+	// Lattice cell at the origin multiplied by the axis primes, wrapped to 32 bits
+	int xHash = 0;
+	int yHash = 0;
+	int zHash = 0;
+};
+
 #define FN_CELLULAR_INDEX_MAX 3
 
 #define FN_NO_SIMD_FALLBACK 0
@@ -562,8 +562,10 @@ static SIMDf SIMDf_NUM(incremental);
 static SIMDf SIMDf_NUM(0);
 static SIMDf SIMDf_NUM(2);
 static SIMDf SIMDf_NUM(6);
+static SIMDf SIMDf_NUM(8);
 static SIMDf SIMDf_NUM(10);
 static SIMDf SIMDf_NUM(15);
+static SIMDf SIMDf_NUM(30);
 static SIMDf SIMDf_NUM(32);
 static SIMDf SIMDf_NUM(999999);
 
@@ -628,8 +630,10 @@ void FUNC(InitSIMDValues)()
 	SIMDf_NUM(1) = SIMDf_SET(1.0f);
 	SIMDf_NUM(2) = SIMDf_SET(2.0f);
 	SIMDf_NUM(6) = SIMDf_SET(6.0f);
+	SIMDf_NUM(8) = SIMDf_SET(8.0f);
 	SIMDf_NUM(10) = SIMDf_SET(10.0f);
 	SIMDf_NUM(15) = SIMDf_SET(15.0f);
+	SIMDf_NUM(30) = SIMDf_SET(30.0f);
 	SIMDf_NUM(32) = SIMDf_SET(32.0f);
 	SIMDf_NUM(999999) = SIMDf_SET(999999.0f);
 
@@ -802,15 +806,17 @@ static SIMDf VECTORCALL FUNC(WhiteNoiseSingle)(SIMDi seed, SIMDf x, SIMDf y, SIM
 		SIMDi_MUL(SIMDi_XOR(SIMDi_CAST_TO_INT(z), SIMDi_SHIFT_R(SIMDi_CAST_TO_INT(z), 16)), SIMDi_NUM(zPrime)));
 }
 
-static SIMDf VECTORCALL FUNC(ValueSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
+// The Origin versions add a lattice cell, already multiplied by the primes, to every cell they hash
+// This is how FillNoiseSetAtOrigin() keeps the float coordinates small
+static SIMDf VECTORCALL FUNC(ValueOriginSingle)(SIMDi seed, SIMDi xHash, SIMDi yHash, SIMDi zHash, SIMDf x, SIMDf y, SIMDf z)
 {
 	SIMDf xs = SIMDf_FLOOR(x);
 	SIMDf ys = SIMDf_FLOOR(y);
 	SIMDf zs = SIMDf_FLOOR(z);
 
-	SIMDi x0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(xs), SIMDi_NUM(xPrime));
-	SIMDi y0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(ys), SIMDi_NUM(yPrime));
-	SIMDi z0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(zs), SIMDi_NUM(zPrime));
+	SIMDi x0 = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(xs), SIMDi_NUM(xPrime)), xHash);
+	SIMDi y0 = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(ys), SIMDi_NUM(yPrime)), yHash);
+	SIMDi z0 = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(zs), SIMDi_NUM(zPrime)), zHash);
 	SIMDi x1 = SIMDi_ADD(x0, SIMDi_NUM(xPrime));
 	SIMDi y1 = SIMDi_ADD(y0, SIMDi_NUM(yPrime));
 	SIMDi z1 = SIMDi_ADD(z0, SIMDi_NUM(zPrime));
@@ -828,15 +834,20 @@ static SIMDf VECTORCALL FUNC(ValueSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
 			FUNC(Lerp)(FUNC(ValCoord)(seed, x0, y1, z1), FUNC(ValCoord)(seed, x1, y1, z1), xs), ys), zs);
 }
 
-static SIMDf VECTORCALL FUNC(PerlinSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
+static SIMDf VECTORCALL FUNC(ValueSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
+{
+	return FUNC(ValueOriginSingle)(seed, SIMDi_SET_ZERO(), SIMDi_SET_ZERO(), SIMDi_SET_ZERO(), x, y, z);
+}
+
+static SIMDf VECTORCALL FUNC(PerlinOriginSingle)(SIMDi seed, SIMDi xHash, SIMDi yHash, SIMDi zHash, SIMDf x, SIMDf y, SIMDf z)
 {
 	SIMDf xs = SIMDf_FLOOR(x);
 	SIMDf ys = SIMDf_FLOOR(y);
 	SIMDf zs = SIMDf_FLOOR(z);
 
-	SIMDi x0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(xs), SIMDi_NUM(xPrime));
-	SIMDi y0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(ys), SIMDi_NUM(yPrime));
-	SIMDi z0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(zs), SIMDi_NUM(zPrime));
+	SIMDi x0 = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(xs), SIMDi_NUM(xPrime)), xHash);
+	SIMDi y0 = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(ys), SIMDi_NUM(yPrime)), yHash);
+	SIMDi z0 = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(zs), SIMDi_NUM(zPrime)), zHash);
 	SIMDi x1 = SIMDi_ADD(x0, SIMDi_NUM(xPrime));
 	SIMDi y1 = SIMDi_ADD(y0, SIMDi_NUM(yPrime));
 	SIMDi z1 = SIMDi_ADD(z0, SIMDi_NUM(zPrime));
@@ -861,16 +872,22 @@ static SIMDf VECTORCALL FUNC(PerlinSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z
 			FUNC(Lerp)(FUNC(GradCoord)(seed, x0, y1, z1, xf0, yf1, zf1), FUNC(GradCoord)(seed, x1, y1, z1, xf1, yf1, zf1), xs), ys), zs);
 }
 
-static SIMDf VECTORCALL FUNC(SimplexSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
+static SIMDf VECTORCALL FUNC(PerlinSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
+{
+	return FUNC(PerlinOriginSingle)(seed, SIMDi_SET_ZERO(), SIMDi_SET_ZERO(), SIMDi_SET_ZERO(), x, y, z);
+}
+
+// The hashes are for the cell in the skewed lattice
+static SIMDf VECTORCALL FUNC(SimplexOriginSingle)(SIMDi seed, SIMDi xHash, SIMDi yHash, SIMDi zHash, SIMDf x, SIMDf y, SIMDf z)
 {
 	SIMDf f = SIMDf_MUL(SIMDf_NUM(F3), SIMDf_ADD(SIMDf_ADD(x, y), z));
 	SIMDf x0 = SIMDf_FLOOR(SIMDf_ADD(x, f));
 	SIMDf y0 = SIMDf_FLOOR(SIMDf_ADD(y, f));
 	SIMDf z0 = SIMDf_FLOOR(SIMDf_ADD(z, f));
 
-	SIMDi i = SIMDi_MUL(SIMDi_CONVERT_TO_INT(x0), SIMDi_NUM(xPrime));
-	SIMDi j = SIMDi_MUL(SIMDi_CONVERT_TO_INT(y0), SIMDi_NUM(yPrime));
-	SIMDi k = SIMDi_MUL(SIMDi_CONVERT_TO_INT(z0), SIMDi_NUM(zPrime));
+	SIMDi i = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(x0), SIMDi_NUM(xPrime)), xHash);
+	SIMDi j = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(y0), SIMDi_NUM(yPrime)), yHash);
+	SIMDi k = SIMDi_ADD(SIMDi_MUL(SIMDi_CONVERT_TO_INT(z0), SIMDi_NUM(zPrime)), zHash);
 
 	SIMDf g = SIMDf_MUL(SIMDf_NUM(G3), SIMDf_ADD(SIMDf_ADD(x0, y0), z0));
 	x0 = SIMDf_SUB(x, SIMDf_SUB(x0, g));
@@ -922,6 +939,229 @@ static SIMDf VECTORCALL FUNC(SimplexSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf
 	return SIMDf_MUL(SIMDf_NUM(32), SIMDf_MASK_ADD(n0, SIMDf_MASK_ADD(n1, SIMDf_MASK_ADD(n2, v3, v2), v1), v0));
 }
 
+static SIMDf VECTORCALL FUNC(SimplexSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
+{
+	return FUNC(SimplexOriginSingle)(seed, SIMDi_SET_ZERO(), SIMDi_SET_ZERO(), SIMDi_SET_ZERO(), x, y, z);
+}
+
+// Derivatives
+static SIMDf VECTORCALL FUNC(InterpQuinticDerivative)(SIMDf t)
+{
+	SIMDf r;
+	r = SIMDf_SUB(t, SIMDf_NUM(2));
+	r = SIMDf_MUL_ADD(r, t, SIMDf_NUM(1));
+	r = SIMDf_MUL(r, SIMDf_MUL(t, t));
+	r = SIMDf_MUL(r, SIMDf_NUM(30));
+
+	return r;
+}
+
+static SIMDf VECTORCALL FUNC(TrilinearLerp)(SIMDf c000, SIMDf c100, SIMDf c010, SIMDf c110, SIMDf c001, SIMDf c101, SIMDf c011, SIMDf c111, SIMDf xs, SIMDf ys, SIMDf zs)
+{
+	return FUNC(Lerp)(
+		FUNC(Lerp)(FUNC(Lerp)(c000, c100, xs), FUNC(Lerp)(c010, c110, xs), ys),
+		FUNC(Lerp)(FUNC(Lerp)(c001, c101, xs), FUNC(Lerp)(c011, c111, xs), ys), zs);
+}
+
+// Same as GradCoord, but also returns the gradient vector that was dotted with x, y, z
+#if SIMD_LEVEL == FN_AVX512
+static SIMDf VECTORCALL FUNC(GradCoordWithGradient)(SIMDi seed, SIMDi xi, SIMDi yi, SIMDi zi, SIMDf x, SIMDf y, SIMDf z, SIMDf& xGrad, SIMDf& yGrad, SIMDf& zGrad)
+{
+	SIMDi hash = FUNC(Hash)(seed, xi, yi, zi);
+
+	xGrad = SIMDf_PERMUTE(SIMDf_NUM(X_GRAD), hash);
+	yGrad = SIMDf_PERMUTE(SIMDf_NUM(Y_GRAD), hash);
+	zGrad = SIMDf_PERMUTE(SIMDf_NUM(Z_GRAD), hash);
+
+	return SIMDf_MUL_ADD(x, xGrad, SIMDf_MUL_ADD(y, yGrad, SIMDf_MUL(z, zGrad)));
+}
+#else
+static SIMDf VECTORCALL FUNC(GradCoordWithGradient)(SIMDi seed, SIMDi xi, SIMDi yi, SIMDi zi, SIMDf x, SIMDf y, SIMDf z, SIMDf& xGrad, SIMDf& yGrad, SIMDf& zGrad)
+{
+	SIMDi hash = FUNC(Hash)(seed, xi, yi, zi);
+	SIMDi hasha13 = SIMDi_AND(hash, SIMDi_NUM(13));
+
+	MASK l8 = SIMDi_LESS_THAN(hasha13, SIMDi_NUM(8));
+	MASK l4 = SIMDi_LESS_THAN(hasha13, SIMDi_NUM(2));
+	MASK h12o14 = SIMDi_EQUAL(SIMDi_NUM(12), hasha13);
+
+	SIMDf h1 = SIMDf_CAST_TO_FLOAT(SIMDi_SHIFT_L(hash, 31));
+	SIMDf h2 = SIMDf_CAST_TO_FLOAT(SIMDi_SHIFT_L(SIMDi_AND(hash, SIMDi_NUM(2)), 30));
+
+	// The result is linear in x, y and z, so putting each axis' unit vector through the same selection gives the gradient
+	xGrad = SIMDf_ADD(SIMDf_XOR(SIMDf_BLENDV(SIMDf_NUM(0), SIMDf_NUM(1), l8), h1),
+		SIMDf_XOR(SIMDf_BLENDV(SIMDf_BLENDV(SIMDf_NUM(0), SIMDf_NUM(1), h12o14), SIMDf_NUM(0), l4), h2));
+	yGrad = SIMDf_ADD(SIMDf_XOR(SIMDf_BLENDV(SIMDf_NUM(1), SIMDf_NUM(0), l8), h1),
+		SIMDf_XOR(SIMDf_BLENDV(SIMDf_NUM(0), SIMDf_NUM(1), l4), h2));
+	zGrad = SIMDf_XOR(SIMDf_BLENDV(SIMDf_BLENDV(SIMDf_NUM(1), SIMDf_NUM(0), h12o14), SIMDf_NUM(0), l4), h2);
+
+	SIMDf u = SIMDf_BLENDV(y, x, l8);
+	SIMDf v = SIMDf_BLENDV(SIMDf_BLENDV(z, x, h12o14), y, l4);
+
+	return SIMDf_ADD(SIMDf_XOR(u, h1), SIMDf_XOR(v, h2));
+}
+#endif
+
+// Returns the same value as PerlinSingle, and its partial derivatives along each axis
+static SIMDf VECTORCALL FUNC(PerlinSingleWithDerivatives)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z, SIMDf& xDeriv, SIMDf& yDeriv, SIMDf& zDeriv)
+{
+	SIMDf xs = SIMDf_FLOOR(x);
+	SIMDf ys = SIMDf_FLOOR(y);
+	SIMDf zs = SIMDf_FLOOR(z);
+
+	SIMDi x0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(xs), SIMDi_NUM(xPrime));
+	SIMDi y0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(ys), SIMDi_NUM(yPrime));
+	SIMDi z0 = SIMDi_MUL(SIMDi_CONVERT_TO_INT(zs), SIMDi_NUM(zPrime));
+	SIMDi x1 = SIMDi_ADD(x0, SIMDi_NUM(xPrime));
+	SIMDi y1 = SIMDi_ADD(y0, SIMDi_NUM(yPrime));
+	SIMDi z1 = SIMDi_ADD(z0, SIMDi_NUM(zPrime));
+
+	SIMDf xf0 = xs = SIMDf_SUB(x, xs);
+	SIMDf yf0 = ys = SIMDf_SUB(y, ys);
+	SIMDf zf0 = zs = SIMDf_SUB(z, zs);
+	SIMDf xf1 = SIMDf_SUB(xf0, SIMDf_NUM(1));
+	SIMDf yf1 = SIMDf_SUB(yf0, SIMDf_NUM(1));
+	SIMDf zf1 = SIMDf_SUB(zf0, SIMDf_NUM(1));
+
+	xs = FUNC(InterpQuintic)(xf0);
+	ys = FUNC(InterpQuintic)(yf0);
+	zs = FUNC(InterpQuintic)(zf0);
+
+	SIMDf xsDeriv = FUNC(InterpQuinticDerivative)(xf0);
+	SIMDf ysDeriv = FUNC(InterpQuinticDerivative)(yf0);
+	SIMDf zsDeriv = FUNC(InterpQuinticDerivative)(zf0);
+
+	SIMDf xg000, yg000, zg000, xg100, yg100, zg100, xg010, yg010, zg010, xg110, yg110, zg110;
+	SIMDf xg001, yg001, zg001, xg101, yg101, zg101, xg011, yg011, zg011, xg111, yg111, zg111;
+
+	SIMDf v000 = FUNC(GradCoordWithGradient)(seed, x0, y0, z0, xf0, yf0, zf0, xg000, yg000, zg000);
+	SIMDf v100 = FUNC(GradCoordWithGradient)(seed, x1, y0, z0, xf1, yf0, zf0, xg100, yg100, zg100);
+	SIMDf v010 = FUNC(GradCoordWithGradient)(seed, x0, y1, z0, xf0, yf1, zf0, xg010, yg010, zg010);
+	SIMDf v110 = FUNC(GradCoordWithGradient)(seed, x1, y1, z0, xf1, yf1, zf0, xg110, yg110, zg110);
+	SIMDf v001 = FUNC(GradCoordWithGradient)(seed, x0, y0, z1, xf0, yf0, zf1, xg001, yg001, zg001);
+	SIMDf v101 = FUNC(GradCoordWithGradient)(seed, x1, y0, z1, xf1, yf0, zf1, xg101, yg101, zg101);
+	SIMDf v011 = FUNC(GradCoordWithGradient)(seed, x0, y1, z1, xf0, yf1, zf1, xg011, yg011, zg011);
+	SIMDf v111 = FUNC(GradCoordWithGradient)(seed, x1, y1, z1, xf1, yf1, zf1, xg111, yg111, zg111);
+
+	// Each corner's dot product changes with its gradient, and the blend between the corners changes with the interpolants
+	SIMDf xBlendDeriv = FUNC(Lerp)(
+		FUNC(Lerp)(SIMDf_SUB(v100, v000), SIMDf_SUB(v110, v010), ys),
+		FUNC(Lerp)(SIMDf_SUB(v101, v001), SIMDf_SUB(v111, v011), ys), zs);
+	SIMDf yBlendDeriv = FUNC(Lerp)(
+		FUNC(Lerp)(SIMDf_SUB(v010, v000), SIMDf_SUB(v110, v100), xs),
+		FUNC(Lerp)(SIMDf_SUB(v011, v001), SIMDf_SUB(v111, v101), xs), zs);
+	SIMDf zBlendDeriv = FUNC(Lerp)(
+		FUNC(Lerp)(SIMDf_SUB(v001, v000), SIMDf_SUB(v101, v100), xs),
+		FUNC(Lerp)(SIMDf_SUB(v011, v010), SIMDf_SUB(v111, v110), xs), ys);
+
+	xDeriv = SIMDf_MUL_ADD(xBlendDeriv, xsDeriv, FUNC(TrilinearLerp)(xg000, xg100, xg010, xg110, xg001, xg101, xg011, xg111, xs, ys, zs));
+	yDeriv = SIMDf_MUL_ADD(yBlendDeriv, ysDeriv, FUNC(TrilinearLerp)(yg000, yg100, yg010, yg110, yg001, yg101, yg011, yg111, xs, ys, zs));
+	zDeriv = SIMDf_MUL_ADD(zBlendDeriv, zsDeriv, FUNC(TrilinearLerp)(zg000, zg100, zg010, zg110, zg001, zg101, zg011, zg111, xs, ys, zs));
+
+	return FUNC(TrilinearLerp)(v000, v100, v010, v110, v001, v101, v011, v111, xs, ys, zs);
+}
+
+// Returns the same value as SimplexSingle, and its partial derivatives along each axis
+static SIMDf VECTORCALL FUNC(SimplexSingleWithDerivatives)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z, SIMDf& xDeriv, SIMDf& yDeriv, SIMDf& zDeriv)
+{
+	SIMDf f = SIMDf_MUL(SIMDf_NUM(F3), SIMDf_ADD(SIMDf_ADD(x, y), z));
+	SIMDf x0 = SIMDf_FLOOR(SIMDf_ADD(x, f));
+	SIMDf y0 = SIMDf_FLOOR(SIMDf_ADD(y, f));
+	SIMDf z0 = SIMDf_FLOOR(SIMDf_ADD(z, f));
+
+	SIMDi i = SIMDi_MUL(SIMDi_CONVERT_TO_INT(x0), SIMDi_NUM(xPrime));
+	SIMDi j = SIMDi_MUL(SIMDi_CONVERT_TO_INT(y0), SIMDi_NUM(yPrime));
+	SIMDi k = SIMDi_MUL(SIMDi_CONVERT_TO_INT(z0), SIMDi_NUM(zPrime));
+
+	SIMDf g = SIMDf_MUL(SIMDf_NUM(G3), SIMDf_ADD(SIMDf_ADD(x0, y0), z0));
+	x0 = SIMDf_SUB(x, SIMDf_SUB(x0, g));
+	y0 = SIMDf_SUB(y, SIMDf_SUB(y0, g));
+	z0 = SIMDf_SUB(z, SIMDf_SUB(z0, g));
+
+	MASK x0_ge_y0 = SIMDf_GREATER_EQUAL(x0, y0);
+	MASK y0_ge_z0 = SIMDf_GREATER_EQUAL(y0, z0);
+	MASK x0_ge_z0 = SIMDf_GREATER_EQUAL(x0, z0);
+
+	MASK i1 = MASK_AND(x0_ge_y0, x0_ge_z0);
+	MASK j1 = MASK_AND_NOT(x0_ge_y0, y0_ge_z0);
+	MASK k1 = MASK_AND_NOT(x0_ge_z0, MASK_NOT(y0_ge_z0));
+
+	MASK i2 = MASK_OR(x0_ge_y0, x0_ge_z0);
+	MASK j2 = MASK_OR(MASK_NOT(x0_ge_y0), y0_ge_z0);
+	MASK k2 = MASK_NOT(MASK_AND(x0_ge_z0, y0_ge_z0));
+
+	SIMDf x1 = SIMDf_ADD(SIMDf_MASK_SUB(i1, x0, SIMDf_NUM(1)), SIMDf_NUM(G3));
+	SIMDf y1 = SIMDf_ADD(SIMDf_MASK_SUB(j1, y0, SIMDf_NUM(1)), SIMDf_NUM(G3));
+	SIMDf z1 = SIMDf_ADD(SIMDf_MASK_SUB(k1, z0, SIMDf_NUM(1)), SIMDf_NUM(G3));
+	SIMDf x2 = SIMDf_ADD(SIMDf_MASK_SUB(i2, x0, SIMDf_NUM(1)), SIMDf_NUM(F3));
+	SIMDf y2 = SIMDf_ADD(SIMDf_MASK_SUB(j2, y0, SIMDf_NUM(1)), SIMDf_NUM(F3));
+	SIMDf z2 = SIMDf_ADD(SIMDf_MASK_SUB(k2, z0, SIMDf_NUM(1)), SIMDf_NUM(F3));
+	SIMDf x3 = SIMDf_ADD(x0, SIMDf_NUM(G33));
+	SIMDf y3 = SIMDf_ADD(y0, SIMDf_NUM(G33));
+	SIMDf z3 = SIMDf_ADD(z0, SIMDf_NUM(G33));
+
+	SIMDf t0 = SIMDf_NMUL_ADD(z0, z0, SIMDf_NMUL_ADD(y0, y0, SIMDf_NMUL_ADD(x0, x0, SIMDf_NUM(0_6))));
+	SIMDf t1 = SIMDf_NMUL_ADD(z1, z1, SIMDf_NMUL_ADD(y1, y1, SIMDf_NMUL_ADD(x1, x1, SIMDf_NUM(0_6))));
+	SIMDf t2 = SIMDf_NMUL_ADD(z2, z2, SIMDf_NMUL_ADD(y2, y2, SIMDf_NMUL_ADD(x2, x2, SIMDf_NUM(0_6))));
+	SIMDf t3 = SIMDf_NMUL_ADD(z3, z3, SIMDf_NMUL_ADD(y3, y3, SIMDf_NMUL_ADD(x3, x3, SIMDf_NUM(0_6))));
+
+	MASK n0 = SIMDf_GREATER_EQUAL(t0, SIMDf_NUM(0));
+	MASK n1 = SIMDf_GREATER_EQUAL(t1, SIMDf_NUM(0));
+	MASK n2 = SIMDf_GREATER_EQUAL(t2, SIMDf_NUM(0));
+	MASK n3 = SIMDf_GREATER_EQUAL(t3, SIMDf_NUM(0));
+
+	SIMDf tt0 = SIMDf_MUL(t0, t0);
+	SIMDf tt1 = SIMDf_MUL(t1, t1);
+	SIMDf tt2 = SIMDf_MUL(t2, t2);
+	SIMDf tt3 = SIMDf_MUL(t3, t3);
+
+	SIMDf xg0, yg0, zg0, xg1, yg1, zg1, xg2, yg2, zg2, xg3, yg3, zg3;
+
+	SIMDf d0 = FUNC(GradCoordWithGradient)(seed, i, j, k, x0, y0, z0, xg0, yg0, zg0);
+	SIMDf d1 = FUNC(GradCoordWithGradient)(seed, SIMDi_MASK_ADD(i1, i, SIMDi_NUM(xPrime)), SIMDi_MASK_ADD(j1, j, SIMDi_NUM(yPrime)), SIMDi_MASK_ADD(k1, k, SIMDi_NUM(zPrime)), x1, y1, z1, xg1, yg1, zg1);
+	SIMDf d2 = FUNC(GradCoordWithGradient)(seed, SIMDi_MASK_ADD(i2, i, SIMDi_NUM(xPrime)), SIMDi_MASK_ADD(j2, j, SIMDi_NUM(yPrime)), SIMDi_MASK_ADD(k2, k, SIMDi_NUM(zPrime)), x2, y2, z2, xg2, yg2, zg2);
+	SIMDf d3 = FUNC(GradCoordWithGradient)(seed, SIMDi_ADD(i, SIMDi_NUM(xPrime)), SIMDi_ADD(j, SIMDi_NUM(yPrime)), SIMDi_ADD(k, SIMDi_NUM(zPrime)), x3, y3, z3, xg3, yg3, zg3);
+
+	SIMDf v0 = SIMDf_MUL(SIMDf_MUL(tt0, tt0), d0);
+	SIMDf v1 = SIMDf_MUL(SIMDf_MUL(tt1, tt1), d1);
+	SIMDf v2 = SIMDf_MUL(SIMDf_MUL(tt2, tt2), d2);
+	SIMDf v3 = SIMDf_MASK(n3, SIMDf_MUL(SIMDf_MUL(tt3, tt3), d3));
+
+	// Each corner contributes t^4 * (g . d), where t = 0.6 - |d|^2, so its derivative is t^4 * g - 8 * t^3 * (g . d) * d
+	SIMDf a0 = SIMDf_MUL(SIMDf_NUM(8), SIMDf_MUL(SIMDf_MUL(tt0, t0), d0));
+	SIMDf a1 = SIMDf_MUL(SIMDf_NUM(8), SIMDf_MUL(SIMDf_MUL(tt1, t1), d1));
+	SIMDf a2 = SIMDf_MUL(SIMDf_NUM(8), SIMDf_MUL(SIMDf_MUL(tt2, t2), d2));
+	SIMDf a3 = SIMDf_MUL(SIMDf_NUM(8), SIMDf_MUL(SIMDf_MUL(tt3, t3), d3));
+	tt0 = SIMDf_MUL(tt0, tt0);
+	tt1 = SIMDf_MUL(tt1, tt1);
+	tt2 = SIMDf_MUL(tt2, tt2);
+	tt3 = SIMDf_MUL(tt3, tt3);
+
+#define SIMPLEX_CORNER_DERIVATIVES(_axis)\
+	_axis##Deriv = SIMDf_MUL(SIMDf_NUM(32), SIMDf_MASK_ADD(n0, SIMDf_MASK_ADD(n1, SIMDf_MASK_ADD(n2,\
+		SIMDf_MASK(n3, SIMDf_NMUL_ADD(a3, _axis##3, SIMDf_MUL(tt3, _axis##g3))),\
+		SIMDf_NMUL_ADD(a2, _axis##2, SIMDf_MUL(tt2, _axis##g2))),\
+		SIMDf_NMUL_ADD(a1, _axis##1, SIMDf_MUL(tt1, _axis##g1))),\
+		SIMDf_NMUL_ADD(a0, _axis##0, SIMDf_MUL(tt0, _axis##g0))))
+
+	SIMPLEX_CORNER_DERIVATIVES(x);
+	SIMPLEX_CORNER_DERIVATIVES(y);
+	SIMPLEX_CORNER_DERIVATIVES(z);
+#undef SIMPLEX_CORNER_DERIVATIVES
+
+	return SIMDf_MUL(SIMDf_NUM(32), SIMDf_MASK_ADD(n0, SIMDf_MASK_ADD(n1, SIMDf_MASK_ADD(n2, v3, v2), v1), v0));
+}
+
+// Turns the derivatives of a noise value into the derivatives of its absolute value
+static void VECTORCALL FUNC(AbsDerivatives)(SIMDf value, SIMDf& xDeriv, SIMDf& yDeriv, SIMDf& zDeriv)
+{
+	SIMDf signBit = SIMDf_XOR(value, SIMDf_ABS(value));
+
+	xDeriv = SIMDf_XOR(xDeriv, signBit);
+	yDeriv = SIMDf_XOR(yDeriv, signBit);
+	zDeriv = SIMDf_XOR(zDeriv, signBit);
+}
+
 static SIMDf VECTORCALL FUNC(CubicSingle)(SIMDi seed, SIMDf x, SIMDf y, SIMDf z)
 {
 	SIMDf xf1 = SIMDf_FLOOR(x);
@@ -1076,6 +1316,12 @@ y = SIMDi_MASK_SUB(_yReset, y, ySizeV);}
 #define STORE_LAST_RESULT(_dest, _source) std::memcpy(_dest, &_source, (maxIndex - index) * 4)
 #endif
 
+#define INIT_OUTPUT_REMAP_VALUES() \
+SIMDf outputScaleV = SIMDf_SET(m_outputScale);\
+SIMDf outputOffsetV = SIMDf_SET(m_outputOffset)
+
+#define REMAP_OUTPUT(_source) SIMDf_MUL_ADD(_source, outputScaleV, outputOffsetV)
+
 #define INIT_PERTURB_VALUES() \
 SIMDf perturbAmpV, perturbFreqV, perturbLacunarityV, perturbGainV, perturbNormaliseLengthV;\
 switch (m_perturbType)\
@@ -1188,6 +1434,7 @@ if ((zSize & (VECTOR_SIZE - 1)) == 0)\
 			PERTURB_SWITCH()\
 			SIMDf result;\
 			f;\
+			result = REMAP_OUTPUT(result);\
 			SIMDf_STORE(&noiseSet[index], result);\
 			\
 			int iz = VECTOR_SIZE;\
@@ -1203,6 +1450,7 @@ if ((zSize & (VECTOR_SIZE - 1)) == 0)\
 				PERTURB_SWITCH()\
 				SIMDf result;\
 				f;\
+				result = REMAP_OUTPUT(result);\
 				SIMDf_STORE(&noiseSet[index], result);\
 			}\
 			index += VECTOR_SIZE;\
@@ -1236,6 +1484,7 @@ else\
 		PERTURB_SWITCH()\
 		SIMDf result;\
 		f;\
+		result = REMAP_OUTPUT(result);\
 		SIMDf_STORE(&noiseSet[index], result);\
 		\
 		z = SIMDi_ADD(z, SIMDi_NUM(vectorSize));\
@@ -1250,6 +1499,7 @@ else\
 	PERTURB_SWITCH()\
 	SIMDf result;\
 	f;\
+	result = REMAP_OUTPUT(result);\
 	STORE_LAST_RESULT(&noiseSet[index], result);\
 }
 
@@ -1322,6 +1572,7 @@ void SIMD_LEVEL_CLASS::Fill##func##Set(float* noiseSet, int xStart, int yStart,
 	SIMD_ZERO_ALL();\
 	SIMDi seedV = SIMDi_SET(m_seed); \
 	INIT_PERTURB_VALUES();\
+	INIT_OUTPUT_REMAP_VALUES();\
 	\
 	scaleModifier *= m_frequency;\
 	\
@@ -1345,6 +1596,7 @@ void SIMD_LEVEL_CLASS::Fill##func##FractalSet(float* noiseSet, int xStart, int y
 	SIMDf gainV = SIMDf_SET(m_gain);\
 	SIMDf fractalBoundingV = SIMDf_SET(m_fractalBounding);\
 	INIT_PERTURB_VALUES();\
+	INIT_OUTPUT_REMAP_VALUES();\
 	\
 	scaleModifier *= m_frequency;\
 	\
@@ -1381,6 +1633,467 @@ FILL_FRACTAL_SET(Simplex)
 FILL_SET(Cubic)
 FILL_FRACTAL_SET(Cubic)
 
+// Derivative sets are built like SET_BUILDER, without perturbing. f sets result to the noise value and xD, yD, zD to its
+// derivatives along xF, yF, zF, which are scaled by x/y/zDerivScaleV to per unit of the set coordinates before they're stored
+#define DERIVATIVE_SET_BUILDER(f)\
+if ((zSize & (VECTOR_SIZE - 1)) == 0)\
+{\
+	SIMDi yBase = SIMDi_SET(yStart);\
+	SIMDi zBase = SIMDi_ADD(SIMDi_NUM(incremental), SIMDi_SET(zStart));\
+	\
+	SIMDi x = SIMDi_SET(xStart);\
+	\
+	int index = 0;\
+	\
+	for (int ix = 0; ix < xSize; ix++)\
+	{\
+		SIMDf xf = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(x), xFreqV);\
+		SIMDi y = yBase;\
+		\
+		for (int iy = 0; iy < ySize; iy++)\
+		{\
+			SIMDf yf = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(y), yFreqV);\
+			SIMDi z = zBase;\
+			\
+			int iz = 0;\
+			while (iz < zSize)\
+			{\
+				SIMDf xF = xf;\
+				SIMDf yF = yf;\
+				SIMDf zF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(z), zFreqV);\
+				\
+				SIMDf result, xD, yD, zD;\
+				f;\
+				SIMDf_STORE(&noiseSet[index], REMAP_OUTPUT(result));\
+				SIMDf_STORE(&xDerivSet[index], SIMDf_MUL(xD, xDerivScaleV));\
+				SIMDf_STORE(&yDerivSet[index], SIMDf_MUL(yD, yDerivScaleV));\
+				SIMDf_STORE(&zDerivSet[index], SIMDf_MUL(zD, zDerivScaleV));\
+				\
+				z = SIMDi_ADD(z, SIMDi_NUM(vectorSize));\
+				index += VECTOR_SIZE;\
+				iz += VECTOR_SIZE;\
+			}\
+			y = SIMDi_ADD(y, SIMDi_NUM(1));\
+		}\
+		x = SIMDi_ADD(x, SIMDi_NUM(1));\
+	}\
+}\
+else\
+{\
+	SIMDi ySizeV = SIMDi_SET(ySize); \
+	SIMDi zSizeV = SIMDi_SET(zSize); \
+	\
+	SIMDi yEndV = SIMDi_SET(yStart + ySize - 1); \
+	SIMDi zEndV = SIMDi_SET(zStart + zSize - 1); \
+	\
+	SIMDi x = SIMDi_SET(xStart); \
+	SIMDi y = SIMDi_SET(yStart); \
+	SIMDi z = SIMDi_ADD(SIMDi_SET(zStart), SIMDi_NUM(incremental)); \
+	AXIS_RESET(zSize, 1)\
+	\
+	int index = 0; \
+	int maxIndex = xSize * ySize * zSize; \
+	\
+	for (; index < maxIndex - VECTOR_SIZE; index += VECTOR_SIZE)\
+	{\
+		SIMDf xF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(x), xFreqV);\
+		SIMDf yF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(y), yFreqV);\
+		SIMDf zF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(z), zFreqV);\
+		\
+		SIMDf result, xD, yD, zD;\
+		f;\
+		SIMDf_STORE(&noiseSet[index], REMAP_OUTPUT(result));\
+		SIMDf_STORE(&xDerivSet[index], SIMDf_MUL(xD, xDerivScaleV));\
+		SIMDf_STORE(&yDerivSet[index], SIMDf_MUL(yD, yDerivScaleV));\
+		SIMDf_STORE(&zDerivSet[index], SIMDf_MUL(zD, zDerivScaleV));\
+		\
+		z = SIMDi_ADD(z, SIMDi_NUM(vectorSize));\
+		\
+		AXIS_RESET(zSize, 0)\
+	}\
+	\
+	SIMDf xF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(x), xFreqV);\
+	SIMDf yF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(y), yFreqV);\
+	SIMDf zF = SIMDf_MUL(SIMDf_CONVERT_TO_FLOAT(z), zFreqV);\
+	\
+	SIMDf result, xD, yD, zD;\
+	f;\
+	result = REMAP_OUTPUT(result);\
+	xD = SIMDf_MUL(xD, xDerivScaleV);\
+	yD = SIMDf_MUL(yD, yDerivScaleV);\
+	zD = SIMDf_MUL(zD, zDerivScaleV);\
+	STORE_LAST_RESULT(&noiseSet[index], result);\
+	STORE_LAST_RESULT(&xDerivSet[index], xD);\
+	STORE_LAST_RESULT(&yDerivSet[index], yD);\
+	STORE_LAST_RESULT(&zDerivSet[index], zD);\
+}
+
+// Each octave samples at lacunarity^octave times the coordinates, so its derivatives are scaled by that as well as by its amplitude
+// FBM DERIV SINGLE
+#define FBM_DERIV_SINGLE(f)\
+	SIMDi seedF = seedV;\
+	SIMDf xDF, yDF, zDF;\
+	\
+	result = FUNC(f##SingleWithDerivatives)(seedF, xF, yF, zF, xD, yD, zD);\
+	\
+	SIMDf ampF = SIMDf_NUM(1);\
+	SIMDf freqF = SIMDf_NUM(1);\
+	int octaveIndex = 0;\
+	\
+	while (++octaveIndex < m_octaves)\
+	{\
+		xF = SIMDf_MUL(xF, lacunarityV);\
+		yF = SIMDf_MUL(yF, lacunarityV);\
+		zF = SIMDf_MUL(zF, lacunarityV);\
+		seedF = SIMDi_ADD(seedF, SIMDi_NUM(1));\
+		\
+		ampF = SIMDf_MUL(ampF, gainV);\
+		freqF = SIMDf_MUL(freqF, lacunarityV);\
+		result = SIMDf_MUL_ADD(FUNC(f##SingleWithDerivatives)(seedF, xF, yF, zF, xDF, yDF, zDF), ampF, result);\
+		\
+		SIMDf ampFreqF = SIMDf_MUL(ampF, freqF);\
+		xD = SIMDf_MUL_ADD(xDF, ampFreqF, xD);\
+		yD = SIMDf_MUL_ADD(yDF, ampFreqF, yD);\
+		zD = SIMDf_MUL_ADD(zDF, ampFreqF, zD);\
+	}\
+	result = SIMDf_MUL(result, fractalBoundingV);\
+	xD = SIMDf_MUL(xD, fractalBoundingV);\
+	yD = SIMDf_MUL(yD, fractalBoundingV);\
+	zD = SIMDf_MUL(zD, fractalBoundingV)
+
+// BILLOW DERIV SINGLE
+#define BILLOW_DERIV_SINGLE(f)\
+	SIMDi seedF = seedV;\
+	SIMDf xDF, yDF, zDF;\
+	\
+	SIMDf noiseF = FUNC(f##SingleWithDerivatives)(seedF, xF, yF, zF, xD, yD, zD);\
+	FUNC(AbsDerivatives)(noiseF, xD, yD, zD);\
+	result = SIMDf_MUL_SUB(SIMDf_ABS(noiseF), SIMDf_NUM(2), SIMDf_NUM(1));\
+	\
+	SIMDf ampF = SIMDf_NUM(1);\
+	SIMDf freqF = SIMDf_NUM(1);\
+	int octaveIndex = 0;\
+	\
+	while (++octaveIndex < m_octaves)\
+	{\
+		xF = SIMDf_MUL(xF, lacunarityV);\
+		yF = SIMDf_MUL(yF, lacunarityV);\
+		zF = SIMDf_MUL(zF, lacunarityV);\
+		seedF = SIMDi_ADD(seedF, SIMDi_NUM(1));\
+		\
+		ampF = SIMDf_MUL(ampF, gainV);\
+		freqF = SIMDf_MUL(freqF, lacunarityV);\
+		noiseF = FUNC(f##SingleWithDerivatives)(seedF, xF, yF, zF, xDF, yDF, zDF);\
+		FUNC(AbsDerivatives)(noiseF, xDF, yDF, zDF);\
+		result = SIMDf_MUL_ADD(SIMDf_MUL_SUB(SIMDf_ABS(noiseF), SIMDf_NUM(2), SIMDf_NUM(1)), ampF, result);\
+		\
+		SIMDf ampFreqF = SIMDf_MUL(ampF, freqF);\
+		xD = SIMDf_MUL_ADD(xDF, ampFreqF, xD);\
+		yD = SIMDf_MUL_ADD(yDF, ampFreqF, yD);\
+		zD = SIMDf_MUL_ADD(zDF, ampFreqF, zD);\
+	}\
+	result = SIMDf_MUL(result, fractalBoundingV);\
+	SIMDf derivBoundingF = SIMDf_MUL(SIMDf_NUM(2), fractalBoundingV);\
+	xD = SIMDf_MUL(xD, derivBoundingF);\
+	yD = SIMDf_MUL(yD, derivBoundingF);\
+	zD = SIMDf_MUL(zD, derivBoundingF)
+
+// RIGIDMULTI DERIV SINGLE
+#define RIGIDMULTI_DERIV_SINGLE(f)\
+	SIMDi seedF = seedV;\
+	SIMDf xDF, yDF, zDF;\
+	\
+	SIMDf noiseF = FUNC(f##SingleWithDerivatives)(seedF, xF, yF, zF, xD, yD, zD);\
+	FUNC(AbsDerivatives)(noiseF, xD, yD, zD);\
+	result = SIMDf_SUB(SIMDf_NUM(1), SIMDf_ABS(noiseF));\
+	xD = SIMDf_SUB(SIMDf_NUM(0), xD);\
+	yD = SIMDf_SUB(SIMDf_NUM(0), yD);\
+	zD = SIMDf_SUB(SIMDf_NUM(0), zD);\
+	\
+	SIMDf ampF = SIMDf_NUM(1);\
+	SIMDf freqF = SIMDf_NUM(1);\
+	int octaveIndex = 0;\
+	\
+	while (++octaveIndex < m_octaves)\
+	{\
+		xF = SIMDf_MUL(xF, lacunarityV);\
+		yF = SIMDf_MUL(yF, lacunarityV);\
+		zF = SIMDf_MUL(zF, lacunarityV);\
+		seedF = SIMDi_ADD(seedF, SIMDi_NUM(1));\
+		\
+		ampF = SIMDf_MUL(ampF, gainV);\
+		freqF = SIMDf_MUL(freqF, lacunarityV);\
+		noiseF = FUNC(f##SingleWithDerivatives)(seedF, xF, yF, zF, xDF, yDF, zDF);\
+		FUNC(AbsDerivatives)(noiseF, xDF, yDF, zDF);\
+		result = SIMDf_NMUL_ADD(SIMDf_SUB(SIMDf_NUM(1), SIMDf_ABS(noiseF)), ampF, result);\
+		\
+		SIMDf ampFreqF = SIMDf_MUL(ampF, freqF);\
+		xD = SIMDf_MUL_ADD(xDF, ampFreqF, xD);\
+		yD = SIMDf_MUL_ADD(yDF, ampFreqF, yD);\
+		zD = SIMDf_MUL_ADD(zDF, ampFreqF, zD);\
+	}
+
+#define FILL_SET_WITH_DERIVATIVES(func) \
+void SIMD_LEVEL_CLASS::Fill##func##SetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier)\
+{\
+	assert(noiseSet && xDerivSet && yDerivSet && zDerivSet);\
+	SIMD_ZERO_ALL();\
+	SIMDi seedV = SIMDi_SET(m_seed); \
+	INIT_OUTPUT_REMAP_VALUES();\
+	\
+	scaleModifier *= m_frequency;\
+	\
+	SIMDf xFreqV = SIMDf_SET(scaleModifier * m_xScale);\
+	SIMDf yFreqV = SIMDf_SET(scaleModifier * m_yScale);\
+	SIMDf zFreqV = SIMDf_SET(scaleModifier * m_zScale);\
+	\
+	SIMDf xDerivScaleV = SIMDf_MUL(xFreqV, outputScaleV);\
+	SIMDf yDerivScaleV = SIMDf_MUL(yFreqV, outputScaleV);\
+	SIMDf zDerivScaleV = SIMDf_MUL(zFreqV, outputScaleV);\
+	\
+	DERIVATIVE_SET_BUILDER(result = FUNC(func##SingleWithDerivatives)(seedV, xF, yF, zF, xD, yD, zD))\
+	\
+	SIMD_ZERO_ALL();\
+}
+
+#define FILL_FRACTAL_SET_WITH_DERIVATIVES(func) \
+void SIMD_LEVEL_CLASS::Fill##func##FractalSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier)\
+{\
+	assert(noiseSet && xDerivSet && yDerivSet && zDerivSet);\
+	SIMD_ZERO_ALL();\
+	\
+	SIMDi seedV = SIMDi_SET(m_seed);\
+	SIMDf lacunarityV = SIMDf_SET(m_lacunarity);\
+	SIMDf gainV = SIMDf_SET(m_gain);\
+	SIMDf fractalBoundingV = SIMDf_SET(m_fractalBounding);\
+	INIT_OUTPUT_REMAP_VALUES();\
+	\
+	scaleModifier *= m_frequency;\
+	\
+	SIMDf xFreqV = SIMDf_SET(scaleModifier * m_xScale);\
+	SIMDf yFreqV = SIMDf_SET(scaleModifier * m_yScale);\
+	SIMDf zFreqV = SIMDf_SET(scaleModifier * m_zScale);\
+	\
+	SIMDf xDerivScaleV = SIMDf_MUL(xFreqV, outputScaleV);\
+	SIMDf yDerivScaleV = SIMDf_MUL(yFreqV, outputScaleV);\
+	SIMDf zDerivScaleV = SIMDf_MUL(zFreqV, outputScaleV);\
+	\
+	switch(m_fractalType)\
+	{\
+	case FBM:\
+		DERIVATIVE_SET_BUILDER(FBM_DERIV_SINGLE(func))\
+		break;\
+	case Billow:\
+		DERIVATIVE_SET_BUILDER(BILLOW_DERIV_SINGLE(func))\
+		break;\
+	case RigidMulti:\
+		DERIVATIVE_SET_BUILDER(RIGIDMULTI_DERIV_SINGLE(func))\
+		break;\
+	}\
+	SIMD_ZERO_ALL();\
+}
+
+FILL_SET_WITH_DERIVATIVES(Perlin)
+FILL_FRACTAL_SET_WITH_DERIVATIVES(Perlin)
+
+FILL_SET_WITH_DERIVATIVES(Simplex)
+FILL_FRACTAL_SET_WITH_DERIVATIVES(Simplex)
+
+// Origin sets are built like SET_BUILDER, without perturbing, with every axis starting at 0. xS, yS, zS are the index of each value
+// along each axis, which ORIGIN_OCTAVE_SINGLE turns into an octave's coordinates relative to its lattice cell at the origin
+#define ORIGIN_SET_BUILDER(f)\
+if ((zSize & (VECTOR_SIZE - 1)) == 0)\
+{\
+	SIMDi zBase = SIMDi_NUM(incremental);\
+	\
+	SIMDi x = SIMDi_SET_ZERO();\
+	\
+	int index = 0;\
+	\
+	for (int ix = 0; ix < xSize; ix++)\
+	{\
+		SIMDf xS = SIMDf_CONVERT_TO_FLOAT(x);\
+		SIMDi y = SIMDi_SET_ZERO();\
+		\
+		for (int iy = 0; iy < ySize; iy++)\
+		{\
+			SIMDf yS = SIMDf_CONVERT_TO_FLOAT(y);\
+			SIMDi z = zBase;\
+			SIMDf zS = SIMDf_CONVERT_TO_FLOAT(z);\
+			\
+			SIMDf result;\
+			f;\
+			result = REMAP_OUTPUT(result);\
+			SIMDf_STORE(&noiseSet[index], result);\
+			\
+			int iz = VECTOR_SIZE;\
+			while (iz < zSize)\
+			{\
+				z = SIMDi_ADD(z, SIMDi_NUM(vectorSize));\
+				index += VECTOR_SIZE;\
+				iz += VECTOR_SIZE;\
+				zS = SIMDf_CONVERT_TO_FLOAT(z);\
+				\
+				SIMDf result;\
+				f;\
+				result = REMAP_OUTPUT(result);\
+				SIMDf_STORE(&noiseSet[index], result);\
+			}\
+			index += VECTOR_SIZE;\
+			y = SIMDi_ADD(y, SIMDi_NUM(1));\
+		}\
+		x = SIMDi_ADD(x, SIMDi_NUM(1));\
+	}\
+}\
+else\
+{\
+	SIMDi ySizeV = SIMDi_SET(ySize); \
+	SIMDi zSizeV = SIMDi_SET(zSize); \
+	\
+	SIMDi yEndV = SIMDi_SET(ySize - 1); \
+	SIMDi zEndV = SIMDi_SET(zSize - 1); \
+	\
+	SIMDi x = SIMDi_SET_ZERO(); \
+	SIMDi y = SIMDi_SET_ZERO(); \
+	SIMDi z = SIMDi_NUM(incremental); \
+	AXIS_RESET(zSize, 1)\
+	\
+	int index = 0; \
+	int maxIndex = xSize * ySize * zSize; \
+	\
+	for (; index < maxIndex - VECTOR_SIZE; index += VECTOR_SIZE)\
+	{\
+		SIMDf xS = SIMDf_CONVERT_TO_FLOAT(x);\
+		SIMDf yS = SIMDf_CONVERT_TO_FLOAT(y);\
+		SIMDf zS = SIMDf_CONVERT_TO_FLOAT(z);\
+		\
+		SIMDf result;\
+		f;\
+		result = REMAP_OUTPUT(result);\
+		SIMDf_STORE(&noiseSet[index], result);\
+		\
+		z = SIMDi_ADD(z, SIMDi_NUM(vectorSize));\
+		\
+		AXIS_RESET(zSize, 0)\
+	}\
+	\
+	SIMDf xS = SIMDf_CONVERT_TO_FLOAT(x);\
+	SIMDf yS = SIMDf_CONVERT_TO_FLOAT(y);\
+	SIMDf zS = SIMDf_CONVERT_TO_FLOAT(z);\
+	\
+	SIMDf result;\
+	f;\
+	result = REMAP_OUTPUT(result);\
+	STORE_LAST_RESULT(&noiseSet[index], result);\
+}
+
+#define ORIGIN_OCTAVE_SINGLE(f, _seed, _octave)\
+	FUNC(f##OriginSingle)(_seed, SIMDi_SET((_octave).xHash), SIMDi_SET((_octave).yHash), SIMDi_SET((_octave).zHash),\
+		SIMDf_MUL_ADD(xS, SIMDf_SET((_octave).xStep), SIMDf_SET((_octave).xOffset)),\
+		SIMDf_MUL_ADD(yS, SIMDf_SET((_octave).yStep), SIMDf_SET((_octave).yOffset)),\
+		SIMDf_MUL_ADD(zS, SIMDf_SET((_octave).zStep), SIMDf_SET((_octave).zOffset)))
+
+// The fractals take each octave's coordinates from its own FastNoiseOriginOctave, instead of scaling the previous octave's by the lacunarity
+#define FBM_ORIGIN_SINGLE(f)\
+	SIMDi seedF = seedV;\
+	\
+	result = ORIGIN_OCTAVE_SINGLE(f, seedF, octaves[0]);\
+	\
+	SIMDf ampF = SIMDf_NUM(1);\
+	int octaveIndex = 0;\
+	\
+	while (++octaveIndex < m_octaves)\
+	{\
+		seedF = SIMDi_ADD(seedF, SIMDi_NUM(1));\
+		\
+		ampF = SIMDf_MUL(ampF, gainV);\
+		result = SIMDf_MUL_ADD(ORIGIN_OCTAVE_SINGLE(f, seedF, octaves[octaveIndex]), ampF, result);\
+	}\
+	result = SIMDf_MUL(result, fractalBoundingV)
+
+#define BILLOW_ORIGIN_SINGLE(f)\
+	SIMDi seedF = seedV;\
+	\
+	result = SIMDf_MUL_SUB(SIMDf_ABS(ORIGIN_OCTAVE_SINGLE(f, seedF, octaves[0])), SIMDf_NUM(2), SIMDf_NUM(1));\
+	\
+	SIMDf ampF = SIMDf_NUM(1);\
+	int octaveIndex = 0;\
+	\
+	while (++octaveIndex < m_octaves)\
+	{\
+		seedF = SIMDi_ADD(seedF, SIMDi_NUM(1));\
+		\
+		ampF = SIMDf_MUL(ampF, gainV);\
+		result = SIMDf_MUL_ADD(SIMDf_MUL_SUB(SIMDf_ABS(ORIGIN_OCTAVE_SINGLE(f, seedF, octaves[octaveIndex])), SIMDf_NUM(2), SIMDf_NUM(1)), ampF, result);\
+	}\
+	result = SIMDf_MUL(result, fractalBoundingV)
+
+#define RIGIDMULTI_ORIGIN_SINGLE(f)\
+	SIMDi seedF = seedV;\
+	\
+	result = SIMDf_SUB(SIMDf_NUM(1), SIMDf_ABS(ORIGIN_OCTAVE_SINGLE(f, seedF, octaves[0])));\
+	\
+	SIMDf ampF = SIMDf_NUM(1);\
+	int octaveIndex = 0;\
+	\
+	while (++octaveIndex < m_octaves)\
+	{\
+		seedF = SIMDi_ADD(seedF, SIMDi_NUM(1));\
+		\
+		ampF = SIMDf_MUL(ampF, gainV);\
+		result = SIMDf_NMUL_ADD(SIMDf_SUB(SIMDf_NUM(1), SIMDf_ABS(ORIGIN_OCTAVE_SINGLE(f, seedF, octaves[octaveIndex]))), ampF, result);\
+	}
+
+#define FILL_SET_AT_ORIGIN(func) \
+void SIMD_LEVEL_CLASS::Fill##func##SetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize)\
+{\
+	assert(noiseSet);\
+	assert(octaves);\
+	SIMD_ZERO_ALL();\
+	SIMDi seedV = SIMDi_SET(m_seed);\
+	INIT_OUTPUT_REMAP_VALUES();\
+	\
+	ORIGIN_SET_BUILDER(result = ORIGIN_OCTAVE_SINGLE(func, seedV, octaves[0]))\
+	\
+	SIMD_ZERO_ALL();\
+}
+
+#define FILL_FRACTAL_SET_AT_ORIGIN(func) \
+void SIMD_LEVEL_CLASS::Fill##func##FractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize)\
+{\
+	assert(noiseSet);\
+	assert(octaves);\
+	SIMD_ZERO_ALL();\
+	\
+	SIMDi seedV = SIMDi_SET(m_seed);\
+	SIMDf gainV = SIMDf_SET(m_gain);\
+	SIMDf fractalBoundingV = SIMDf_SET(m_fractalBounding);\
+	INIT_OUTPUT_REMAP_VALUES();\
+	\
+	switch(m_fractalType)\
+	{\
+	case FBM:\
+		ORIGIN_SET_BUILDER(FBM_ORIGIN_SINGLE(func))\
+		break;\
+	case Billow:\
+		ORIGIN_SET_BUILDER(BILLOW_ORIGIN_SINGLE(func))\
+		break;\
+	case RigidMulti:\
+		ORIGIN_SET_BUILDER(RIGIDMULTI_ORIGIN_SINGLE(func))\
+		break;\
+	}\
+	SIMD_ZERO_ALL();\
+}
+
+FILL_SET_AT_ORIGIN(Value)
+FILL_FRACTAL_SET_AT_ORIGIN(Value)
+
+FILL_SET_AT_ORIGIN(Perlin)
+FILL_FRACTAL_SET_AT_ORIGIN(Perlin)
+
+FILL_SET_AT_ORIGIN(Simplex)
+FILL_FRACTAL_SET_AT_ORIGIN(Simplex)
+
 #ifdef FN_ALIGNED_SETS
 #define SIZE_MASK
 #define SAFE_LAST(f)
@@ -1401,6 +2114,7 @@ if (loopMax != vectorSet->size)\
 	\
 	SIMDf result;\
 	f;\
+	result = REMAP_OUTPUT(result);\
 	std::memcpy(&noiseSet[index], &result, remaining);\
 }
 #endif
@@ -1415,6 +2129,7 @@ while (index < loopMax)\
 	PERTURB_SWITCH()\
 	SIMDf result;\
 	f;\
+	result = REMAP_OUTPUT(result);\
 	SIMDf_STORE(&noiseSet[index], result);\
 	index += VECTOR_SIZE;\
 }\
@@ -1436,6 +2151,7 @@ void SIMD_LEVEL_CLASS::Fill##func##Set(float* noiseSet, FastNoiseVectorSet* vect
 	SIMDf yOffsetV = SIMDf_MUL(SIMDf_SET(yOffset), yFreqV);\
 	SIMDf zOffsetV = SIMDf_MUL(SIMDf_SET(zOffset), zFreqV);\
 	INIT_PERTURB_VALUES();\
+	INIT_OUTPUT_REMAP_VALUES();\
 	\
 	int index = 0;\
 	int loopMax = vectorSet->size SIZE_MASK;\
@@ -1463,6 +2179,7 @@ void SIMD_LEVEL_CLASS::Fill##func##FractalSet(float* noiseSet, FastNoiseVectorSe
 	SIMDf yOffsetV = SIMDf_MUL(SIMDf_SET(yOffset), yFreqV);\
 	SIMDf zOffsetV = SIMDf_MUL(SIMDf_SET(zOffset), zFreqV);\
 	INIT_PERTURB_VALUES();\
+	INIT_OUTPUT_REMAP_VALUES();\
 	\
 	int index = 0;\
 	int loopMax = vectorSet->size SIZE_MASK;\
@@ -1496,11 +2213,107 @@ void SIMD_LEVEL_CLASS::Fill##func##FractalSet(float* noiseSet, FastNoiseVectorSe
 	FILL_VECTOR_SET(Cubic)
 	FILL_FRACTAL_VECTOR_SET(Cubic)
 
+#ifdef FN_ALIGNED_SETS
+#define ORIGIN_SAFE_LAST(f)
+#else
+#define ORIGIN_SAFE_LAST(f)\
+if (loopMax != vectorSet->size)\
+{\
+	std::size_t remaining = (vectorSet->size - loopMax) * 4;\
+	\
+	SIMDf xS = SIMDf_LOAD(&vectorSet->xSet[loopMax]);\
+	SIMDf yS = SIMDf_LOAD(&vectorSet->ySet[loopMax]);\
+	SIMDf zS = SIMDf_LOAD(&vectorSet->zSet[loopMax]);\
+	\
+	SIMDf result;\
+	f;\
+	result = REMAP_OUTPUT(result);\
+	std::memcpy(&noiseSet[index], &result, remaining);\
+}
+#endif
+
+// Like VECTOR_SET_BUILDER, without perturbing. The vector set's positions take the place of the sample indices in ORIGIN_SET_BUILDER
+#define ORIGIN_VECTOR_SET_BUILDER(f)\
+while (index < loopMax)\
+{\
+	SIMDf xS = SIMDf_LOAD(&vectorSet->xSet[index]);\
+	SIMDf yS = SIMDf_LOAD(&vectorSet->ySet[index]);\
+	SIMDf zS = SIMDf_LOAD(&vectorSet->zSet[index]);\
+	\
+	SIMDf result;\
+	f;\
+	result = REMAP_OUTPUT(result);\
+	SIMDf_STORE(&noiseSet[index], result);\
+	index += VECTOR_SIZE;\
+}\
+ORIGIN_SAFE_LAST(f)
+
+#define FILL_VECTOR_SET_AT_ORIGIN(func) \
+void SIMD_LEVEL_CLASS::Fill##func##SetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves)\
+{\
+	assert(noiseSet);\
+	assert(vectorSet);\
+	assert(vectorSet->size >= 0);\
+	assert(octaves);\
+	SIMD_ZERO_ALL();\
+	SIMDi seedV = SIMDi_SET(m_seed);\
+	INIT_OUTPUT_REMAP_VALUES();\
+	\
+	int index = 0;\
+	int loopMax = vectorSet->size SIZE_MASK;\
+	\
+	ORIGIN_VECTOR_SET_BUILDER(result = ORIGIN_OCTAVE_SINGLE(func, seedV, octaves[0]))\
+	\
+	SIMD_ZERO_ALL();\
+}
+
+#define FILL_FRACTAL_VECTOR_SET_AT_ORIGIN(func) \
+void SIMD_LEVEL_CLASS::Fill##func##FractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves)\
+{\
+	assert(noiseSet);\
+	assert(vectorSet);\
+	assert(vectorSet->size >= 0);\
+	assert(octaves);\
+	SIMD_ZERO_ALL();\
+	\
+	SIMDi seedV = SIMDi_SET(m_seed);\
+	SIMDf gainV = SIMDf_SET(m_gain);\
+	SIMDf fractalBoundingV = SIMDf_SET(m_fractalBounding);\
+	INIT_OUTPUT_REMAP_VALUES();\
+	\
+	int index = 0;\
+	int loopMax = vectorSet->size SIZE_MASK;\
+	\
+	switch(m_fractalType)\
+	{\
+	case FBM:\
+		ORIGIN_VECTOR_SET_BUILDER(FBM_ORIGIN_SINGLE(func))\
+		break;\
+	case Billow:\
+		ORIGIN_VECTOR_SET_BUILDER(BILLOW_ORIGIN_SINGLE(func))\
+		break;\
+	case RigidMulti:\
+		ORIGIN_VECTOR_SET_BUILDER(RIGIDMULTI_ORIGIN_SINGLE(func))\
+		break;\
+	}\
+	SIMD_ZERO_ALL();\
+}
+
+FILL_VECTOR_SET_AT_ORIGIN(Value)
+FILL_FRACTAL_VECTOR_SET_AT_ORIGIN(Value)
+
+FILL_VECTOR_SET_AT_ORIGIN(Perlin)
+FILL_FRACTAL_VECTOR_SET_AT_ORIGIN(Perlin)
+
+FILL_VECTOR_SET_AT_ORIGIN(Simplex)
+FILL_FRACTAL_VECTOR_SET_AT_ORIGIN(Simplex)
+
 	void SIMD_LEVEL_CLASS::FillWhiteNoiseSet(float* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier)
 {
 	assert(noiseSet);
 	SIMD_ZERO_ALL();
 	SIMDi seedV = SIMDi_SET(m_seed);
+	INIT_OUTPUT_REMAP_VALUES();
 
 	if ((zSize & (VECTOR_SIZE - 1)) == 0)
 	{
@@ -1520,7 +2333,7 @@ void SIMD_LEVEL_CLASS::Fill##func##FractalSet(float* noiseSet, FastNoiseVectorSe
 			{
 				SIMDi z = zBase;
 
-				SIMDf_STORE(&noiseSet[index], FUNC(ValCoord)(seedV, x, y, z));
+				SIMDf_STORE(&noiseSet[index], REMAP_OUTPUT(FUNC(ValCoord)(seedV, x, y, z)));
 
 				int iz = VECTOR_SIZE;
 				while (iz < zSize)
@@ -1529,7 +2342,7 @@ void SIMD_LEVEL_CLASS::Fill##func##FractalSet(float* noiseSet, FastNoiseVectorSe
 					index += VECTOR_SIZE;
 					iz += VECTOR_SIZE;
 
-					SIMDf_STORE(&noiseSet[index], FUNC(ValCoord)(seedV, x, y, z));
+					SIMDf_STORE(&noiseSet[index], REMAP_OUTPUT(FUNC(ValCoord)(seedV, x, y, z)));
 				}
 				index += VECTOR_SIZE;
 				y = SIMDi_ADD(y, SIMDi_NUM(yPrime));
@@ -1555,13 +2368,13 @@ void SIMD_LEVEL_CLASS::Fill##func##FractalSet(float* noiseSet, FastNoiseVectorSe
 
 		for (; index < maxIndex - VECTOR_SIZE; index += VECTOR_SIZE)
 		{
-			SIMDf_STORE(&noiseSet[index], FUNC(ValCoord)(seedV, SIMDi_MUL(x, SIMDi_NUM(xPrime)), SIMDi_MUL(y, SIMDi_NUM(yPrime)), SIMDi_MUL(z, SIMDi_NUM(zPrime))));
+			SIMDf_STORE(&noiseSet[index], REMAP_OUTPUT(FUNC(ValCoord)(seedV, SIMDi_MUL(x, SIMDi_NUM(xPrime)), SIMDi_MUL(y, SIMDi_NUM(yPrime)), SIMDi_MUL(z, SIMDi_NUM(zPrime)))));
 
 			z = SIMDi_ADD(z, SIMDi_NUM(vectorSize));
 
 			AXIS_RESET(zSize, 0);
 		}
-		SIMDf result = FUNC(ValCoord)(seedV, SIMDi_MUL(x, SIMDi_NUM(xPrime)), SIMDi_MUL(y, SIMDi_NUM(yPrime)), SIMDi_MUL(z, SIMDi_NUM(zPrime)));
+		SIMDf result = REMAP_OUTPUT(FUNC(ValCoord)(seedV, SIMDi_MUL(x, SIMDi_NUM(xPrime)), SIMDi_MUL(y, SIMDi_NUM(yPrime)), SIMDi_MUL(z, SIMDi_NUM(zPrime))));
 		STORE_LAST_RESULT(&noiseSet[index], result);
 	}
 	SIMD_ZERO_ALL();
@@ -1967,6 +2780,7 @@ void SIMD_LEVEL_CLASS::FillCellularSet(float* noiseSet, int xStart, int yStart,
 	SIMD_ZERO_ALL();
 	SIMDi seedV = SIMDi_SET(m_seed);
 	INIT_PERTURB_VALUES();
+	INIT_OUTPUT_REMAP_VALUES();
 
 	scaleModifier *= m_frequency;
 
@@ -2073,6 +2887,7 @@ void SIMD_LEVEL_CLASS::FillCellularSet(float* noiseSet, FastNoiseVectorSet* vect
 	SIMDf zOffsetV = SIMDf_MUL(SIMDf_SET(zOffset), zFreqV);
 	SIMDf cellJitterV = SIMDf_SET(m_cellularJitter);
 	INIT_PERTURB_VALUES();
+	INIT_OUTPUT_REMAP_VALUES();
 
 	int index = 0;
 	int loopMax = vectorSet->size SIZE_MASK;
@@ -53,16 +53,32 @@ namespace FastNoiseSIMD_internal
 		void FillValueFractalSet(float* floatSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 		void FillValueSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
 		void FillValueFractalSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
+		void FillValueSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) override;
+		void FillValueFractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) override;
+		void FillValueSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) override;
+		void FillValueFractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) override;
 
 		void FillPerlinSet(float* floatSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 		void FillPerlinFractalSet(float* floatSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 		void FillPerlinSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
 		void FillPerlinFractalSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
+		void FillPerlinSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) override;
+		void FillPerlinFractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) override;
+		void FillPerlinSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) override;
+		void FillPerlinFractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) override;
+		void FillPerlinSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
+		void FillPerlinFractalSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 
 		void FillSimplexSet(float* floatSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 		void FillSimplexFractalSet(float* floatSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 		void FillSimplexSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
 		void FillSimplexFractalSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
+		void FillSimplexSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) override;
+		void FillSimplexFractalSetAtOrigin(float* noiseSet, const FastNoiseOriginOctave* octaves, int xSize, int ySize, int zSize) override;
+		void FillSimplexSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) override;
+		void FillSimplexFractalSetAtOrigin(float* noiseSet, FastNoiseVectorSet* vectorSet, const FastNoiseOriginOctave* octaves) override;
+		void FillSimplexSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
+		void FillSimplexFractalSetWithDerivatives(float* noiseSet, float* xDerivSet, float* yDerivSet, float* zDerivSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 
 		void FillCellularSet(float* floatSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, float scaleModifier = 1.0f) override;
 		void FillCellularSet(float* noiseSet, FastNoiseVectorSet* vectorSet, float xOffset = 0.0f, float yOffset = 0.0f, float zOffset = 0.0f) override;
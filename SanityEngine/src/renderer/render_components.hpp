@@ -3,7 +3,9 @@
 #include "core/types.hpp"
 #include "renderer/handles.hpp"
 #include "renderer/lights.hpp"
+#include "rhi/chunk_mesh_store.hpp"
 #include "rhi/mesh_data_store.hpp"
+#include "rhi/terrain_mesh_store.hpp"
 
 namespace renderer {
     /*!
@@ -46,6 +48,41 @@ namespace renderer {
         bool is_background{false};
     };
 
+    /*!
+     * \brief Renders a terrain tile from the renderer's terrain mesh store
+     */
+    struct TerrainTileRenderableComponent {
+        /*!
+         * \brief The tile's vertices in the terrain mesh store
+         */
+        TerrainTileMesh mesh;
+
+        /*!
+         * \brief Which level of detail to draw the tile at
+         */
+        Uint32 lod{0};
+
+        StandardMaterialHandle material{};
+
+        /*!
+         * \brief Whether to draw this tile. Terrain tiles at different levels of detail cover the same ground, so the terrain hides the
+         * ones it isn't using
+         */
+        bool is_visible{false};
+    };
+
+    /*!
+     * \brief Renders a voxel chunk from the renderer's chunk mesh store
+     */
+    struct ChunkRenderableComponent {
+        /*!
+         * \brief The chunk's vertices in the chunk mesh store
+         */
+        ChunkMesh mesh;
+
+        StandardMaterialHandle material{};
+    };
+
     /*!
      * \brief Renders a postprocessing pass
      */
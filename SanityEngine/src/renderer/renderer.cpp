@@ -132,6 +132,25 @@ namespace renderer {
         raytracing_scene_dirty = true;
     }
 
+    void Renderer::remove_raytracing_geometry(const RaytracableGeometryHandle handle) {
+        Rx::Vector<RaytracingObject> remaining_objects;
+        remaining_objects.reserve(raytracing_objects.size());
+        raytracing_objects.each_fwd([&](const RaytracingObject& object) {
+            if(object.geometry_handle.index != handle.index) {
+                remaining_objects.push_back(object);
+            }
+        });
+
+        raytracing_objects = Rx::Utility::move(remaining_objects);
+        raytracing_scene_dirty = true;
+
+        // Leave the geometry's slot in place so that the other geometry handles stay valid
+        auto& geometry = raytracing_geometries[handle.index];
+        if(geometry.blas_buffer) {
+            device->schedule_buffer_destruction(Rx::Utility::move(geometry.blas_buffer));
+        }
+    }
+
     TextureHandle Renderer::create_image(const ImageCreateInfo& create_info) {
         const auto idx = static_cast<Uint32>(all_images.size());
 
@@ -249,6 +268,18 @@ namespace renderer {
 
     MeshDataStore& Renderer::get_static_mesh_store() const { return *static_mesh_storage; }
 
+    void Renderer::create_terrain_mesh_store(const Uint32 tile_size, const Uint32 max_num_tiles) {
+        terrain_mesh_store = Rx::make_ptr<TerrainMeshStore>(RX_SYSTEM_ALLOCATOR, *device, tile_size, max_num_tiles);
+    }
+
+    TerrainMeshStore* Renderer::get_terrain_mesh_store() const { return terrain_mesh_store.get(); }
+
+    void Renderer::create_chunk_mesh_store(const Uint32 max_vertices_per_chunk, const Uint32 max_num_chunks) {
+        chunk_mesh_store = Rx::make_ptr<ChunkMeshStore>(RX_SYSTEM_ALLOCATOR, *device, max_vertices_per_chunk, max_num_chunks);
+    }
+
+    ChunkMeshStore* Renderer::get_chunk_mesh_store() const { return chunk_mesh_store.get(); }
+
     void Renderer::begin_device_capture() const { device->begin_capture(); }
 
     void Renderer::end_device_capture() const { device->end_capture(); }
@@ -276,6 +307,19 @@ namespace renderer {
         return {handle_idx};
     }
 
+    RaytracableGeometryHandle Renderer::create_raytracing_geometry(const Rx::Vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geom_descs,
+                                                                   ID3D12GraphicsCommandList4* commands) {
+        TracyD3D12Zone(RenderDevice::tracy_context, commands, "Renderer::create_raytracing_geometry");
+        PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "Renderer::create_raytracing_geometry");
+
+        auto new_ray_geo = build_acceleration_structure_for_geometry(commands, *device, geom_descs);
+
+        const auto handle_idx = static_cast<Uint32>(raytracing_geometries.size());
+        raytracing_geometries.push_back(Rx::Utility::move(new_ray_geo));
+
+        return {handle_idx};
+    }
+
     void Renderer::create_static_mesh_storage() {
         const auto vertex_create_info = BufferCreateInfo{
             .name = "Static Mesh Vertex Buffer",
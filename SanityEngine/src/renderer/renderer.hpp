@@ -14,6 +14,8 @@
 #include "rhi/mesh_data_store.hpp"
 #include "rhi/raytracing_structs.hpp"
 #include "rhi/render_pipeline_state.hpp"
+#include "rhi/chunk_mesh_store.hpp"
+#include "rhi/terrain_mesh_store.hpp"
 #include "rx/core/ptr.h"
 #include "rx/core/vector.h"
 #include "settings.hpp"
@@ -79,6 +81,13 @@ namespace renderer {
 
         void add_raytracing_objects_to_scene(const Rx::Vector<RaytracingObject>& new_objects);
 
+        /*!
+         * \brief Removes every raytracing object that uses the provided geometry from the scene, then destroys the geometry
+         *
+         * The geometry's handle must not be used after this
+         */
+        void remove_raytracing_geometry(RaytracableGeometryHandle handle);
+
         TextureHandle create_image(const ImageCreateInfo& create_info);
 
         [[nodiscard]] TextureHandle create_image(const ImageCreateInfo& create_info,
@@ -103,6 +112,26 @@ namespace renderer {
 
         [[nodiscard]] MeshDataStore& get_static_mesh_store() const;
 
+        /*!
+         * \brief Creates the store that terrain tile meshes live in. Replaces any existing terrain mesh store
+         */
+        void create_terrain_mesh_store(Uint32 tile_size, Uint32 max_num_tiles);
+
+        /*!
+         * \brief Returns the terrain mesh store, or nullptr if there's no terrain
+         */
+        [[nodiscard]] TerrainMeshStore* get_terrain_mesh_store() const;
+
+        /*!
+         * \brief Creates the store that voxel chunk meshes live in. Replaces any existing chunk mesh store
+         */
+        void create_chunk_mesh_store(Uint32 max_vertices_per_chunk, Uint32 max_num_chunks);
+
+        /*!
+         * \brief Returns the chunk mesh store, or nullptr if there are no voxel chunks
+         */
+        [[nodiscard]] ChunkMeshStore* get_chunk_mesh_store() const;
+
         void begin_device_capture() const;
 
         void end_device_capture() const;
@@ -120,6 +149,9 @@ namespace renderer {
                                                                            const Rx::Vector<Mesh>& meshes,
                                                                            ID3D12GraphicsCommandList4* commands);
 
+        [[nodiscard]] RaytracableGeometryHandle create_raytracing_geometry(const Rx::Vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geom_descs,
+                                                                           ID3D12GraphicsCommandList4* commands);
+
         [[nodiscard]] Rx::Ptr<BindGroup> bind_global_resources_for_frame(Uint32 frame_idx);
 
         [[nodiscard]] Buffer& get_model_matrix_for_frame(Uint32 frame_idx);
@@ -226,6 +258,10 @@ namespace renderer {
 
         Rx::Ptr<MeshDataStore> static_mesh_storage;
 
+        Rx::Ptr<TerrainMeshStore> terrain_mesh_store;
+
+        Rx::Ptr<ChunkMeshStore> chunk_mesh_store;
+
         PerFrameData per_frame_data;
         Rx::Vector<Rx::Ptr<Buffer>> per_frame_data_buffers;
 
@@ -30,10 +30,21 @@ namespace renderer {
         });
         logger->verbose("Created standard pipeline");
 
+        terrain_pipeline = device.create_render_pipeline_state({
+            .name = "Terrain pipeline",
+            .vertex_shader = load_shader("terrain.vertex"),
+            .pixel_shader = load_shader("standard.pixel"),
+            .input_assembler_layout = InputAssemblerLayout::TerrainVertex,
+            .render_target_formats = Rx::Array{ImageFormat::Rgba32F},
+            .depth_stencil_format = ImageFormat::Depth32,
+        });
+        logger->verbose("Created terrain pipeline");
+
         opaque_chunk_geometry_pipeline = device.create_render_pipeline_state({
             .name = "Opaque chunk geometry pipeline",
             .vertex_shader = load_shader("chunk.vertex"),
-            .pixel_shader = load_shader("opaque_chunk.pixel"),
+            .pixel_shader = load_shader("standard.pixel"),
+            .input_assembler_layout = InputAssemblerLayout::ChunkVertex,
             .render_target_formats = Rx::Array{ImageFormat::Rgba32F},
             .depth_stencil_format = ImageFormat::Depth32,
         });
@@ -85,6 +96,10 @@ namespace renderer {
 
         draw_objects_in_scene(commands, registry, frame_idx);
 
+        draw_terrain_tiles(commands, registry, frame_idx);
+
+        draw_chunks(commands, registry, frame_idx, world);
+
         commands->EndRenderPass();
     }
 
@@ -188,6 +203,64 @@ namespace renderer {
         }
     }
 
+    void ForwardPass::draw_terrain_tiles(ID3D12GraphicsCommandList4* commands, entt::registry& registry, const Uint32 frame_idx) {
+        const auto* terrain_mesh_store = renderer->get_terrain_mesh_store();
+        if(terrain_mesh_store == nullptr) {
+            return;
+        }
+
+        PIXScopedEvent(commands, forward_pass_color, "ForwardPass::draw_terrain_tiles");
+
+        commands->SetPipelineState(terrain_pipeline->pso.get());
+
+        // draw_objects_in_scene already bound the model matrix and material buffers, and they don't change between the two
+        terrain_mesh_store->bind_to_command_list(commands);
+
+        const auto& tile_view = registry.view<TransformComponent, TerrainTileRenderableComponent>();
+        tile_view.each([&](const TransformComponent& transform, const TerrainTileRenderableComponent& tile) {
+            if(!tile.is_visible) {
+                return;
+            }
+
+            commands->SetGraphicsRoot32BitConstant(0, tile.material.index, RenderDevice::MATERIAL_INDEX_ROOT_CONSTANT_OFFSET);
+
+            const auto model_matrix_index = renderer->add_model_matrix_to_frame(transform, frame_idx);
+            commands->SetGraphicsRoot32BitConstant(0, model_matrix_index, RenderDevice::MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET);
+
+            // Every tile shares the same indices, which are relative to the tile's first vertex
+            const auto& lod = terrain_mesh_store->get_lod(tile.lod);
+            commands->DrawIndexedInstanced(lod.num_indices, 1, lod.first_index, static_cast<INT>(tile.mesh.first_vertex), 0);
+        });
+    }
+
+    void ForwardPass::draw_chunks(ID3D12GraphicsCommandList4* commands,
+                                  entt::registry& registry,
+                                  const Uint32 frame_idx,
+                                  const World& /* world */) {
+        const auto* chunk_mesh_store = renderer->get_chunk_mesh_store();
+        if(chunk_mesh_store == nullptr) {
+            return;
+        }
+
+        PIXScopedEvent(commands, forward_pass_color, "ForwardPass::draw_chunks");
+
+        commands->SetPipelineState(opaque_chunk_geometry_pipeline->pso.get());
+
+        // draw_objects_in_scene already bound the model matrix and material buffers, and they don't change between the two
+        chunk_mesh_store->bind_to_command_list(commands);
+
+        const auto& chunk_view = registry.view<TransformComponent, ChunkRenderableComponent>();
+        chunk_view.each([&](const TransformComponent& transform, const ChunkRenderableComponent& chunk) {
+            commands->SetGraphicsRoot32BitConstant(0, chunk.material.index, RenderDevice::MATERIAL_INDEX_ROOT_CONSTANT_OFFSET);
+
+            const auto model_matrix_index = renderer->add_model_matrix_to_frame(transform, frame_idx);
+            commands->SetGraphicsRoot32BitConstant(0, model_matrix_index, RenderDevice::MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET);
+
+            // Every chunk shares the same quad indices, which are relative to the chunk's first vertex
+            commands->DrawIndexedInstanced(chunk.mesh.num_quads * 6, 1, 0, static_cast<INT>(chunk.mesh.first_vertex), 0);
+        });
+    }
+
     void ForwardPass::draw_atmosphere(ID3D12GraphicsCommandList4* commands, entt::registry& registry) const {
         const auto atmosphere_view = registry.view<AtmosphericSkyComponent>();
         if(atmosphere_view.size() > 1) {
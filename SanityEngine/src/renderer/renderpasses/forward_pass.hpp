@@ -33,6 +33,7 @@ namespace renderer {
         Renderer* renderer;
 
         Rx::Ptr<RenderPipelineState> standard_pipeline;
+        Rx::Ptr<RenderPipelineState> terrain_pipeline;
         Rx::Ptr<RenderPipelineState> opaque_chunk_geometry_pipeline;
         Rx::Ptr<RenderPipelineState> chunk_water_pipeline;
         Rx::Ptr<RenderPipelineState> atmospheric_sky_pipeline;
@@ -54,6 +55,8 @@ namespace renderer {
 
         void draw_objects_in_scene(ID3D12GraphicsCommandList4* commands, entt::registry& registry, Uint32 frame_idx);
 
+        void draw_terrain_tiles(ID3D12GraphicsCommandList4* commands, entt::registry& registry, Uint32 frame_idx);
+
         void draw_chunks(ID3D12GraphicsCommandList4* commands, entt::registry& registry, Uint32 frame_idx, const World& world);
 
         void draw_atmosphere(ID3D12GraphicsCommandList4* commands, entt::registry& registry) const;
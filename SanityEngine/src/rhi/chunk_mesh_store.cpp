@@ -0,0 +1,137 @@
+#include "chunk_mesh_store.hpp"
+
+#include "Tracy.hpp"
+#include "TracyD3D12.hpp"
+#include "core/align.hpp"
+#include "rhi/helpers.hpp"
+#include "rhi/render_device.hpp"
+#include "rx/core/log.h"
+
+namespace renderer {
+    RX_LOG("ChunkMeshStore", logger);
+
+    ChunkMeshStore::ChunkMeshStore(RenderDevice& device_in, const Uint32 max_vertices_per_chunk_in, const Uint32 max_num_chunks_in)
+        : device{&device_in}, max_vertices_per_chunk{max_vertices_per_chunk_in}, max_num_chunks{max_num_chunks_in} {
+        ZoneScoped;
+
+        RX_ASSERT(max_vertices_per_chunk % 4 == 0, "Chunk mesh slots hold whole quads, but %u vertices isn't one", max_vertices_per_chunk);
+        RX_ASSERT(max_vertices_per_chunk <= UINT16_MAX + 1,
+                  "Chunk meshes of %u vertices are too big for 16-bit indices",
+                  max_vertices_per_chunk);
+
+        vertex_buffer = device->create_buffer({.name = "Chunk Vertex Buffer",
+                                               .usage = BufferUsage::VertexBuffer,
+                                               .size = static_cast<Uint32>(max_vertices_per_chunk * sizeof(ChunkVertex) * max_num_chunks)});
+
+        // Push the slots in reverse order so that chunks fill the buffer front-to-back
+        free_slots.reserve(max_num_chunks);
+        for(Uint32 slot = max_num_chunks; slot > 0; slot--) {
+            free_slots.push_back(slot - 1);
+        }
+
+        create_index_buffer();
+    }
+
+    ChunkMeshStore::~ChunkMeshStore() {
+        device->schedule_buffer_destruction(Rx::Utility::move(vertex_buffer));
+        device->schedule_buffer_destruction(Rx::Utility::move(index_buffer));
+    }
+
+    Uint32 ChunkMeshStore::get_max_vertices_per_chunk() const { return max_vertices_per_chunk; }
+
+    Uint32 ChunkMeshStore::get_num_free_chunks() const { return static_cast<Uint32>(free_slots.size()); }
+
+    void ChunkMeshStore::begin_adding_chunks(ID3D12GraphicsCommandList4* commands) const {
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(vertex_buffer->resource.get(),
+                                                                  D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+                                                                  D3D12_RESOURCE_STATE_COPY_DEST);
+        commands->ResourceBarrier(1, &barrier);
+    }
+
+    Rx::Optional<ChunkMesh> ChunkMeshStore::add_chunk(const Rx::Vector<ChunkVertex>& vertices, ID3D12GraphicsCommandList4* commands) {
+        ZoneScoped;
+
+        TracyD3D12Zone(RenderDevice::tracy_context, commands, "ChunkMeshStore::add_chunk");
+        PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "ChunkMeshStore::add_chunk");
+
+        if(vertices.size() > max_vertices_per_chunk) {
+            logger->error("Chunk mesh has %zu vertices, but a slot only holds %u", vertices.size(), max_vertices_per_chunk);
+            return Rx::nullopt;
+        }
+
+        if(free_slots.is_empty()) {
+            logger->error("Can not add another chunk mesh, all %u slots are in use", max_num_chunks);
+            return Rx::nullopt;
+        }
+
+        const auto slot = free_slots.last();
+        free_slots.pop_back();
+
+        const auto first_vertex = slot * max_vertices_per_chunk;
+
+        upload_data_with_staging_buffer(commands,
+                                        *device,
+                                        vertex_buffer->resource.get(),
+                                        vertices.data(),
+                                        static_cast<Uint32>(vertices.size() * sizeof(ChunkVertex)),
+                                        static_cast<Uint32>(first_vertex * sizeof(ChunkVertex)));
+
+        return ChunkMesh{.first_vertex = first_vertex, .num_quads = static_cast<Uint32>(vertices.size() / 4)};
+    }
+
+    void ChunkMeshStore::end_adding_chunks(ID3D12GraphicsCommandList4* commands) const {
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(vertex_buffer->resource.get(),
+                                                                  D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                  D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        commands->ResourceBarrier(1, &barrier);
+    }
+
+    void ChunkMeshStore::free_chunk(const ChunkMesh& mesh) { free_slots.push_back(mesh.first_vertex / max_vertices_per_chunk); }
+
+    void ChunkMeshStore::bind_to_command_list(ID3D12GraphicsCommandList4* commands) const {
+        D3D12_VERTEX_BUFFER_VIEW vertex_view{};
+        vertex_view.BufferLocation = vertex_buffer->resource->GetGPUVirtualAddress();
+        vertex_view.SizeInBytes = vertex_buffer->size;
+        vertex_view.StrideInBytes = sizeof(ChunkVertex);
+
+        commands->IASetVertexBuffers(0, 1, &vertex_view);
+
+        D3D12_INDEX_BUFFER_VIEW index_view{};
+        index_view.BufferLocation = index_buffer->resource->GetGPUVirtualAddress();
+        index_view.SizeInBytes = index_buffer->size;
+        index_view.Format = DXGI_FORMAT_R16_UINT;
+
+        commands->IASetIndexBuffer(&index_view);
+
+        commands->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+
+    void ChunkMeshStore::create_index_buffer() {
+        ZoneScoped;
+
+        // Enough quads for the fullest slot. Smaller meshes draw a prefix of the same indices
+        const auto num_indices = max_vertices_per_chunk / 4 * 6;
+        Rx::Vector<Uint16> indices{num_indices};
+        for(Uint32 i = 0; i < num_indices; i++) {
+            indices[i] = static_cast<Uint16>(get_chunk_quad_index(i));
+        }
+
+        const auto index_data_size = static_cast<Uint32>(indices.size() * sizeof(Uint16));
+        index_buffer = device->create_buffer(
+            {.name = "Chunk Index Buffer", .usage = BufferUsage::IndexBuffer, .size = ALIGN(4, index_data_size)});
+
+        auto commands = device->create_command_list();
+        commands->SetName(L"ChunkMeshStore::create_index_buffer");
+
+        upload_data_with_staging_buffer(commands.get(), *device, index_buffer->resource.get(), indices.data(), index_data_size, 0);
+
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(index_buffer->resource.get(),
+                                                                  D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                  D3D12_RESOURCE_STATE_INDEX_BUFFER);
+        commands->ResourceBarrier(1, &barrier);
+
+        device->submit_command_list(Rx::Utility::move(commands));
+
+        logger->verbose("Created chunk index buffer with %u indices", num_indices);
+    }
+} // namespace renderer
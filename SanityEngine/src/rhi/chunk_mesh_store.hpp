@@ -0,0 +1,101 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "resources.hpp"
+#include "rhi/chunk_vertex.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/ptr.h"
+#include "rx/core/vector.h"
+
+namespace renderer {
+    class RenderDevice;
+
+    /*!
+     * \brief A voxel chunk's vertices in the chunk mesh store
+     */
+    struct ChunkMesh {
+        /*!
+         * \brief Index of the chunk's first vertex in the chunk vertex buffer
+         */
+        Uint32 first_vertex{0};
+
+        Uint32 num_quads{0};
+    };
+
+    /*!
+     * \brief Storage for voxel chunk meshes
+     *
+     * Chunk meshes are lists of quads that all use the same index pattern, see `get_chunk_quad_index`, so every chunk shares one index
+     * buffer that's long enough for the biggest chunk mesh. Chunks are drawn with their first vertex as the base vertex
+     *
+     * The vertex buffer is split into fixed-size slots, one per chunk, each big enough for the biggest chunk mesh. ChunkVertex is four
+     * bytes, so a slot that's much bigger than a typical greedy mesh still doesn't take much memory
+     */
+    class ChunkMeshStore {
+    public:
+        /*!
+         * \brief Creates a new chunk mesh store and uploads the shared index buffer
+         *
+         * \param device_in The device to create the buffers with
+         * \param max_vertices_per_chunk_in Number of vertices in each slot. Must be a multiple of four, and small enough for 16-bit indices
+         * \param max_num_chunks_in Maximum number of chunk meshes that may be in the store at once
+         */
+        ChunkMeshStore(RenderDevice& device_in, Uint32 max_vertices_per_chunk_in, Uint32 max_num_chunks_in);
+
+        ChunkMeshStore(const ChunkMeshStore& other) = delete;
+        ChunkMeshStore& operator=(const ChunkMeshStore& other) = delete;
+
+        ChunkMeshStore(ChunkMeshStore&& old) noexcept = delete;
+        ChunkMeshStore& operator=(ChunkMeshStore&& old) noexcept = delete;
+
+        ~ChunkMeshStore();
+
+        [[nodiscard]] Uint32 get_max_vertices_per_chunk() const;
+
+        [[nodiscard]] Uint32 get_num_free_chunks() const;
+
+        /*!
+         * \brief Prepares the vertex buffer to receive new chunk meshes
+         */
+        void begin_adding_chunks(ID3D12GraphicsCommandList4* commands) const;
+
+        /*!
+         * \brief Uploads a chunk's vertices into a free slot. Must be called between `begin_adding_chunks` and `end_adding_chunks`
+         *
+         * \return The chunk's mesh, or an empty optional if the store is full or the mesh doesn't fit in a slot
+         */
+        [[nodiscard]] Rx::Optional<ChunkMesh> add_chunk(const Rx::Vector<ChunkVertex>& vertices, ID3D12GraphicsCommandList4* commands);
+
+        /*!
+         * \brief Prepares the vertex buffer to be rendered with
+         */
+        void end_adding_chunks(ID3D12GraphicsCommandList4* commands) const;
+
+        /*!
+         * \brief Returns a chunk's slot to the store
+         *
+         * This does not wait for the GPU. Callers must make sure that no in-flight frames still reference the chunk
+         */
+        void free_chunk(const ChunkMesh& mesh);
+
+        void bind_to_command_list(ID3D12GraphicsCommandList4* commands) const;
+
+    private:
+        RenderDevice* device;
+
+        Uint32 max_vertices_per_chunk;
+
+        Uint32 max_num_chunks;
+
+        Rx::Ptr<Buffer> vertex_buffer;
+
+        Rx::Ptr<Buffer> index_buffer;
+
+        /*!
+         * \brief Indices of the vertex buffer slots that don't have a chunk in them
+         */
+        Rx::Vector<Uint32> free_slots;
+
+        void create_index_buffer();
+    };
+} // namespace renderer
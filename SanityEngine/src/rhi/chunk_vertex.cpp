@@ -0,0 +1,43 @@
+#include "chunk_vertex.hpp"
+
+#include "rx/core/assert.h"
+
+static constexpr Uint32 POSITION_BITS = 6;
+static constexpr Uint32 POSITION_MASK = (1 << POSITION_BITS) - 1;
+
+static constexpr Uint32 FACE_SHIFT = POSITION_BITS * 3;
+static constexpr Uint32 FACE_MASK = 0x7;
+
+static constexpr Uint32 MATERIAL_SHIFT = FACE_SHIFT + 3;
+
+ChunkVertex make_chunk_vertex(const Vec3u& position, const VoxelFace face, const Uint32 material) {
+    RX_ASSERT(position.x <= POSITION_MASK && position.y <= POSITION_MASK && position.z <= POSITION_MASK,
+              "Chunk vertex position (%u, %u, %u) is out of range",
+              position.x,
+              position.y,
+              position.z);
+    RX_ASSERT(material < MAX_NUM_CHUNK_VERTEX_MATERIALS, "Voxel material %u doesn't fit in a chunk vertex", material);
+
+    return ChunkVertex{.packed = position.x | (position.y << POSITION_BITS) | (position.z << (POSITION_BITS * 2)) |
+                                 (static_cast<Uint32>(face) << FACE_SHIFT) | (material << MATERIAL_SHIFT)};
+}
+
+Vec3u get_chunk_vertex_position(const ChunkVertex vertex) {
+    return {vertex.packed & POSITION_MASK,
+            (vertex.packed >> POSITION_BITS) & POSITION_MASK,
+            (vertex.packed >> (POSITION_BITS * 2)) & POSITION_MASK};
+}
+
+VoxelFace get_chunk_vertex_face(const ChunkVertex vertex) { return static_cast<VoxelFace>((vertex.packed >> FACE_SHIFT) & FACE_MASK); }
+
+Uint32 get_chunk_vertex_material(const ChunkVertex vertex) { return vertex.packed >> MATERIAL_SHIFT; }
+
+Vec3f get_voxel_face_normal(const VoxelFace face) {
+    const auto axis = static_cast<Uint32>(face) / 2;
+    const auto sign = static_cast<Uint32>(face) % 2 == 0 ? 1.0f : -1.0f;
+
+    auto normal = Vec3f{0, 0, 0};
+    normal[axis] = sign;
+
+    return normal;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "core/types.hpp"
+
+/*!
+ * \brief The six faces of a voxel, in the order that chunk.vertex.hlsl expects them
+ */
+enum class VoxelFace : Uint32 {
+    PositiveX = 0,
+    NegativeX,
+    PositiveY,
+    NegativeY,
+    PositiveZ,
+    NegativeZ,
+};
+
+constexpr Uint32 NUM_VOXEL_FACES = 6;
+
+/*!
+ * \brief Number of voxel materials that a ChunkVertex can address
+ */
+constexpr Uint32 MAX_NUM_CHUNK_VERTEX_MATERIALS = 1 << 11;
+
+/*!
+ * \brief Compact vertex for voxel chunk meshes
+ *
+ * Chunk meshes are made of axis-aligned quads whose corners sit on the chunk's voxel grid, so a vertex only needs its grid position in the
+ * chunk, which face of a voxel it's on, and the voxel's material. They're packed into one 32-bit word, from the lowest bit up:
+ *
+ * - x, y, and z take 6 bits each, enough for the 33 grid positions along each side of a 32-voxel chunk
+ * - The face takes 3 bits. The normal and the texcoords come from the face
+ * - The material takes the last 11 bits
+ *
+ * That's 4 bytes per vertex, instead of the 40 bytes that a StandardVertex takes. Every quad has four vertices, and every quad's indices
+ * follow the same pattern, see `get_chunk_quad_index`. chunk.vertex.hlsl has a copy of the unpacking code
+ */
+struct ChunkVertex {
+    Uint32 packed{0};
+};
+
+/*!
+ * \brief Builds a chunk vertex
+ *
+ * \param position The vertex's position on the chunk's voxel grid. Each component must be at most 63
+ * \param face The face of the voxel that the vertex is on
+ * \param material The voxel's material. Must be less than MAX_NUM_CHUNK_VERTEX_MATERIALS
+ */
+[[nodiscard]] ChunkVertex make_chunk_vertex(const Vec3u& position, VoxelFace face, Uint32 material);
+
+[[nodiscard]] Vec3u get_chunk_vertex_position(ChunkVertex vertex);
+
+[[nodiscard]] VoxelFace get_chunk_vertex_face(ChunkVertex vertex);
+
+[[nodiscard]] Uint32 get_chunk_vertex_material(ChunkVertex vertex);
+
+/*!
+ * \brief Unit normal of a voxel face
+ */
+[[nodiscard]] Vec3f get_voxel_face_normal(VoxelFace face);
+
+/*!
+ * \brief Finds the vertex that an index in a chunk mesh's index buffer refers to
+ *
+ * Each quad is two triangles, (0, 1, 2) and (0, 2, 3), over the quad's four vertices. Chunk meshes don't store their indices, they all
+ * share one index buffer filled with this pattern
+ */
+[[nodiscard]] constexpr Uint32 get_chunk_quad_index(const Uint32 index) {
+    constexpr Uint32 QUAD_CORNERS[6] = {0, 1, 2, 0, 2, 3};
+    return index / 6 * 4 + QUAD_CORNERS[index % 6];
+}
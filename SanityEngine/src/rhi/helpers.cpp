@@ -409,6 +409,12 @@ namespace renderer {
             geom_descs.push_back(Rx::Utility::move(geom_desc));
         });
 
+        return build_acceleration_structure_for_geometry(commands, device, geom_descs);
+    }
+
+    RaytracableGeometry build_acceleration_structure_for_geometry(ID3D12GraphicsCommandList4* commands,
+                                                                  RenderDevice& device,
+                                                                  const Rx::Vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geom_descs) {
         const auto build_as_inputs = D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS{
             .Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
             .Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
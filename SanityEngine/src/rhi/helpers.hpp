@@ -55,6 +55,13 @@ namespace renderer {
                                                                 const Buffer& index_buffer,
                                                                 const Rx::Vector<Mesh>& meshes);
 
+    /*!
+     * \brief Builds a bottom-level acceleration structure for arbitrary geometry, for meshes that don't live in a MeshDataStore
+     */
+    RaytracableGeometry build_acceleration_structure_for_geometry(ID3D12GraphicsCommandList4* commands,
+                                                                  RenderDevice& device,
+                                                                  const Rx::Vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geom_descs);
+
     void upload_data_with_staging_buffer(ID3D12GraphicsCommandList4* commands,
                                          RenderDevice& device,
                                          ID3D12Resource* dst,
@@ -5,10 +5,75 @@
 #include "rhi/helpers.hpp"
 #include "rhi/render_device.hpp"
 #include "rx/core/log.h"
+#include "rx/core/optional.h"
 
 namespace renderer {
     RX_LOG("MeshDataStore", logger);
 
+    /*!
+     * \brief Finds the first free range that can hold `count` elements and takes them out of it
+     *
+     * \return The start of the allocated elements, or an empty optional if no free range is big enough
+     */
+    static Rx::Optional<Uint32> allocate_from_free_ranges(Rx::Vector<BufferRange>& free_ranges, const Uint32 count) {
+        for(Size i = 0; i < free_ranges.size(); i++) {
+            auto& range = free_ranges[i];
+            if(range.count < count) {
+                continue;
+            }
+
+            const auto start = range.start;
+            if(range.count == count) {
+                free_ranges.erase(i, i + 1);
+            } else {
+                range.start += count;
+                range.count -= count;
+            }
+
+            return start;
+        }
+
+        return Rx::nullopt;
+    }
+
+    /*!
+     * \brief Adds a range to a sorted list of free ranges, merging it with its neighbors if they touch
+     */
+    static void add_free_range(Rx::Vector<BufferRange>& free_ranges, const BufferRange& new_range) {
+        if(new_range.count == 0) {
+            return;
+        }
+
+        Size insert_idx = 0;
+        while(insert_idx < free_ranges.size() && free_ranges[insert_idx].start < new_range.start) {
+            insert_idx++;
+        }
+
+        const auto merges_with_previous = insert_idx > 0 &&
+                                          free_ranges[insert_idx - 1].start + free_ranges[insert_idx - 1].count == new_range.start;
+        const auto merges_with_next = insert_idx < free_ranges.size() &&
+                                      new_range.start + new_range.count == free_ranges[insert_idx].start;
+
+        if(merges_with_previous && merges_with_next) {
+            free_ranges[insert_idx - 1].count += new_range.count + free_ranges[insert_idx].count;
+            free_ranges.erase(insert_idx, insert_idx + 1);
+
+        } else if(merges_with_previous) {
+            free_ranges[insert_idx - 1].count += new_range.count;
+
+        } else if(merges_with_next) {
+            free_ranges[insert_idx].start = new_range.start;
+            free_ranges[insert_idx].count += new_range.count;
+
+        } else {
+            free_ranges.push_back(new_range);
+            for(auto i = free_ranges.size() - 1; i > insert_idx; i--) {
+                free_ranges[i] = free_ranges[i - 1];
+            }
+            free_ranges[insert_idx] = new_range;
+        }
+    }
+
     MeshDataStore::MeshDataStore(RenderDevice& device_in, Rx::Ptr<Buffer> vertex_buffer_in, Rx::Ptr<Buffer> index_buffer_in)
         : device{&device_in}, vertex_buffer{Rx::Utility::move(vertex_buffer_in)}, index_buffer{Rx::Utility::move(index_buffer_in)} {
 
@@ -56,18 +121,40 @@ namespace renderer {
         const auto vertex_data_size = static_cast<Uint32>(vertices.size() * sizeof(StandardVertex));
         const auto index_data_size = static_cast<Uint32>(indices.size() * sizeof(Uint32));
 
+        // Reuse space from meshes that were freed if we can, otherwise put the new mesh at the end of the buffers
+        const auto num_vertices = static_cast<Uint32>(vertices.size());
+        const auto num_indices = static_cast<Uint32>(indices.size());
+
+        Uint32 vertex_offset;
+        if(const auto free_vertex_offset = allocate_from_free_ranges(free_vertex_ranges, num_vertices)) {
+            vertex_offset = *free_vertex_offset;
+        } else {
+            vertex_offset = next_vertex_offset;
+            next_vertex_offset += num_vertices;
+            next_free_vertex_byte += vertex_data_size;
+        }
+
+        Uint32 index_offset;
+        if(const auto free_index_offset = allocate_from_free_ranges(free_index_ranges, num_indices)) {
+            index_offset = *free_index_offset;
+        } else {
+            index_offset = next_index_offset;
+            next_index_offset += num_indices;
+        }
+
         // Offset the indices so they'll refer to the right vertex
         Rx::Vector<Uint32> offset_indices;
         offset_indices.reserve(indices.size());
 
-        indices.each_fwd([&](const Uint32 idx) { offset_indices.push_back(idx + next_vertex_offset); });
+        indices.each_fwd([&](const Uint32 idx) { offset_indices.push_back(idx + vertex_offset); });
 
         auto* vertex_resource = vertex_buffer->resource.get();
         auto* index_resource = index_buffer->resource.get();
 
-        const auto index_buffer_byte_offset = static_cast<Uint32>(next_index_offset * sizeof(Uint32));
+        const auto vertex_buffer_byte_offset = static_cast<Uint32>(vertex_offset * sizeof(StandardVertex));
+        const auto index_buffer_byte_offset = static_cast<Uint32>(index_offset * sizeof(Uint32));
 
-        upload_data_with_staging_buffer(commands, *device, vertex_resource, vertices.data(), vertex_data_size, next_free_vertex_byte);
+        upload_data_with_staging_buffer(commands, *device, vertex_resource, vertices.data(), vertex_data_size, vertex_buffer_byte_offset);
 
         upload_data_with_staging_buffer(commands,
                                         *device,
@@ -76,19 +163,17 @@ namespace renderer {
                                         index_data_size,
                                         index_buffer_byte_offset);
 
-        const auto vertex_offset = static_cast<Uint32>(next_free_vertex_byte / sizeof(StandardVertex));
-
-        next_free_vertex_byte += vertex_data_size;
-
-        const auto index_offset = next_index_offset;
-
-        next_vertex_offset += static_cast<Uint32>(vertices.size());
-        next_index_offset += static_cast<Uint32>(indices.size());
-
         return {.first_vertex = vertex_offset,
-                .num_vertices = static_cast<Uint32>(vertices.size()),
+                .num_vertices = num_vertices,
                 .first_index = index_offset,
-                .num_indices = static_cast<Uint32>(indices.size())};
+                .num_indices = num_indices};
+    }
+
+    void MeshDataStore::free_mesh(const Mesh& mesh) {
+        logger->verbose("Freeing mesh with %u vertices and %u indices", mesh.num_vertices, mesh.num_indices);
+
+        add_free_range(free_vertex_ranges, {.start = mesh.first_vertex, .count = mesh.num_vertices});
+        add_free_range(free_index_ranges, {.start = mesh.first_index, .count = mesh.num_indices});
     }
 
     void MeshDataStore::end_adding_meshes(ID3D12GraphicsCommandList4* commands) const {
@@ -26,6 +26,14 @@ namespace renderer {
         Uint32 num_indices{0};
     };
 
+    /*!
+     * \brief A range of elements in one of the mesh data store's buffers
+     */
+    struct BufferRange {
+        Uint32 start{0};
+        Uint32 count{0};
+    };
+
     /*!
      * \brief Binding for a vertex buffer
      */
@@ -75,6 +83,13 @@ namespace renderer {
                                     const Rx::Vector<Uint32>& indices,
                                     ID3D12GraphicsCommandList4* commands);
 
+        /*!
+         * \brief Returns a mesh's vertices and indices to the store, so that later meshes can reuse that space
+         *
+         * This does not wait for the GPU. Callers must make sure that no in-flight frames still reference the mesh
+         */
+        void free_mesh(const Mesh& mesh);
+
         /*!
          * Prepares the vertex and index buffers to be rendered with
          */
@@ -92,9 +107,7 @@ namespace renderer {
         Rx::Vector<VertexBufferBinding> vertex_bindings{};
 
         /*!
-         * \brief Index of the byte in the vertex buffer where the next mesh can be uploaded to
-         *
-         * I'll eventually need a way to unload meshes, but that's more complicated
+         * \brief Index of the byte in the vertex buffer where the next mesh can be uploaded to, if it doesn't fit in a free range
          */
         Uint32 next_free_vertex_byte{0};
 
@@ -107,5 +120,15 @@ namespace renderer {
          * \brief The offset in the index buffer where the next mesh's indices should start
          */
         Uint32 next_index_offset{0};
+
+        /*!
+         * \brief Ranges of vertices that were freed by `free_mesh`, sorted by their start vertex
+         */
+        Rx::Vector<BufferRange> free_vertex_ranges;
+
+        /*!
+         * \brief Ranges of indices that were freed by `free_mesh`, sorted by their start index
+         */
+        Rx::Vector<BufferRange> free_index_ranges;
     };
 } // namespace renderer
@@ -1139,6 +1139,38 @@ namespace renderer {
                                      .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
                                      .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
                                      .InstanceDataStepRate = 0});
+
+        // Terrain vertices don't store their position, the vertex shader derives it from SV_VertexID. The last two bytes of each vertex are
+        // padding, so they don't get an element
+        terrain_graphics_pipeline_input_layout.reserve(2);
+
+        terrain_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "Normal",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R16G16_SNORM,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
+
+        terrain_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "Height",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R16_UNORM,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
+
+        // Chunk vertices are one packed word, which the vertex shader unpacks itself
+        chunk_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "PackedVertex",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R32_UINT,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
     }
 
     void RenderDevice::create_command_signatures() {
@@ -1204,6 +1236,16 @@ namespace renderer {
                 desc.InputLayout.NumElements = static_cast<UINT>(dear_imgui_graphics_pipeline_input_layout.size());
                 desc.InputLayout.pInputElementDescs = dear_imgui_graphics_pipeline_input_layout.data();
                 break;
+
+            case InputAssemblerLayout::TerrainVertex:
+                desc.InputLayout.NumElements = static_cast<UINT>(terrain_graphics_pipeline_input_layout.size());
+                desc.InputLayout.pInputElementDescs = terrain_graphics_pipeline_input_layout.data();
+                break;
+
+            case InputAssemblerLayout::ChunkVertex:
+                desc.InputLayout.NumElements = static_cast<UINT>(chunk_graphics_pipeline_input_layout.size());
+                desc.InputLayout.pInputElementDescs = chunk_graphics_pipeline_input_layout.data();
+                break;
         }
         desc.PrimitiveTopologyType = to_d3d12_primitive_topology_type(create_info.primitive_type);
 
@@ -237,6 +237,8 @@ namespace renderer {
 
         Rx::Vector<D3D12_INPUT_ELEMENT_DESC> standard_graphics_pipeline_input_layout;
         Rx::Vector<D3D12_INPUT_ELEMENT_DESC> dear_imgui_graphics_pipeline_input_layout;
+        Rx::Vector<D3D12_INPUT_ELEMENT_DESC> terrain_graphics_pipeline_input_layout;
+        Rx::Vector<D3D12_INPUT_ELEMENT_DESC> chunk_graphics_pipeline_input_layout;
 
         uint64_t staging_buffer_idx{0};
         Rx::Vector<Buffer> staging_buffers;
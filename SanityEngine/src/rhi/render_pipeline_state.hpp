@@ -123,6 +123,16 @@ namespace renderer {
     enum class InputAssemblerLayout {
         StandardVertex,
         DearImGui,
+
+        /*!
+         * \brief The compact vertex format that terrain tiles use. See TerrainVertex
+         */
+        TerrainVertex,
+
+        /*!
+         * \brief The compact vertex format that voxel chunk meshes use. See ChunkVertex
+         */
+        ChunkVertex,
     };
 
     struct RenderPipelineStateCreateInfo {
@@ -0,0 +1,221 @@
+#include "terrain_mesh_store.hpp"
+
+#include "Tracy.hpp"
+#include "TracyD3D12.hpp"
+#include "core/align.hpp"
+#include "rhi/helpers.hpp"
+#include "rhi/render_device.hpp"
+#include "rx/core/log.h"
+
+namespace renderer {
+    RX_LOG("TerrainMeshStore", logger);
+
+    TerrainMeshStore::TerrainMeshStore(RenderDevice& device_in, const Uint32 tile_size_in, const Uint32 max_num_tiles_in)
+        : device{&device_in}, tile_size{tile_size_in}, max_num_tiles{max_num_tiles_in} {
+        ZoneScoped;
+
+        RX_ASSERT(get_num_terrain_tile_vertices(tile_size) <= UINT16_MAX + 1,
+                  "Terrain tiles of size %u are too big for 16-bit indices",
+                  tile_size);
+
+        const auto vertices_per_tile = get_num_terrain_tile_vertices(tile_size);
+        vertex_buffer = device->create_buffer({.name = "Terrain Vertex Buffer",
+                                               .usage = BufferUsage::VertexBuffer,
+                                               .size = static_cast<Uint32>(vertices_per_tile * sizeof(TerrainVertex) * max_num_tiles)});
+
+        // Push the slots in reverse order so that tiles fill the buffer front-to-back
+        free_slots.reserve(max_num_tiles);
+        for(Uint32 slot = max_num_tiles; slot > 0; slot--) {
+            free_slots.push_back(slot - 1);
+        }
+
+        create_index_buffer();
+    }
+
+    TerrainMeshStore::~TerrainMeshStore() {
+        device->schedule_buffer_destruction(Rx::Utility::move(vertex_buffer));
+        device->schedule_buffer_destruction(Rx::Utility::move(index_buffer));
+    }
+
+    Rx::Vector<Uint16> TerrainMeshStore::build_tile_indices(const Uint32 tile_size, const Uint32 lod) {
+        const auto stride = 1u << lod;
+
+        // The coordinates of the vertices that this LOD uses, along one axis
+        Rx::Vector<Uint32> coords;
+        for(Uint32 coord = 0; coord < tile_size - 1; coord += stride) {
+            coords.push_back(coord);
+        }
+        coords.push_back(tile_size - 1);
+
+        const auto num_quads_per_side = coords.size() - 1;
+
+        Rx::Vector<Uint16> indices;
+        indices.reserve(num_quads_per_side * num_quads_per_side * 6 + num_quads_per_side * 4 * 6);
+
+        for(Size y = 0; y < coords.size() - 1; y++) {
+            for(Size x = 0; x < coords.size() - 1; x++) {
+                const auto top_left = static_cast<Uint16>(coords[y] * tile_size + coords[x]);
+                const auto top_right = static_cast<Uint16>(coords[y] * tile_size + coords[x + 1]);
+                const auto bottom_left = static_cast<Uint16>(coords[y + 1] * tile_size + coords[x]);
+                const auto bottom_right = static_cast<Uint16>(coords[y + 1] * tile_size + coords[x + 1]);
+
+                indices.push_back(top_left);
+                indices.push_back(top_right);
+                indices.push_back(bottom_left);
+
+                indices.push_back(bottom_left);
+                indices.push_back(top_right);
+                indices.push_back(bottom_right);
+            }
+        }
+
+        // Connect every edge vertex that this LOD uses to its skirt vertex. The LOD's stride divides the edge length, so this walk visits
+        // every corner
+        const auto num_skirt_vertices = get_num_terrain_skirt_vertices(tile_size);
+        const auto first_skirt_vertex = tile_size * tile_size;
+        for(Uint32 skirt_index = 0; skirt_index < num_skirt_vertices; skirt_index += stride) {
+            const auto next_skirt_index = (skirt_index + stride) % num_skirt_vertices;
+
+            const auto edge_position = get_terrain_skirt_grid_position(skirt_index, tile_size);
+            const auto next_edge_position = get_terrain_skirt_grid_position(next_skirt_index, tile_size);
+
+            const auto edge = static_cast<Uint16>(edge_position.y * tile_size + edge_position.x);
+            const auto next_edge = static_cast<Uint16>(next_edge_position.y * tile_size + next_edge_position.x);
+            const auto skirt = static_cast<Uint16>(first_skirt_vertex + skirt_index);
+            const auto next_skirt = static_cast<Uint16>(first_skirt_vertex + next_skirt_index);
+
+            // Same winding as the grid's triangles, with the front face pointing away from the tile
+            indices.push_back(edge);
+            indices.push_back(skirt);
+            indices.push_back(next_edge);
+
+            indices.push_back(next_edge);
+            indices.push_back(skirt);
+            indices.push_back(next_skirt);
+        }
+
+        return indices;
+    }
+
+    Uint32 TerrainMeshStore::get_tile_size() const { return tile_size; }
+
+    Uint32 TerrainMeshStore::get_num_lods() const { return static_cast<Uint32>(lods.size()); }
+
+    const TerrainLod& TerrainMeshStore::get_lod(const Uint32 lod) const { return lods[lod]; }
+
+    Uint32 TerrainMeshStore::get_num_free_tiles() const { return static_cast<Uint32>(free_slots.size()); }
+
+    const Buffer& TerrainMeshStore::get_vertex_buffer() const { return *vertex_buffer; }
+
+    const Buffer& TerrainMeshStore::get_index_buffer() const { return *index_buffer; }
+
+    void TerrainMeshStore::begin_adding_tiles(ID3D12GraphicsCommandList4* commands) const {
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(vertex_buffer->resource.get(),
+                                                                  D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+                                                                  D3D12_RESOURCE_STATE_COPY_DEST);
+        commands->ResourceBarrier(1, &barrier);
+    }
+
+    Rx::Optional<TerrainTileMesh> TerrainMeshStore::add_tile(const Rx::Vector<TerrainVertex>& vertices,
+                                                             ID3D12GraphicsCommandList4* commands) {
+        ZoneScoped;
+
+        TracyD3D12Zone(RenderDevice::tracy_context, commands, "TerrainMeshStore::add_tile");
+        PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "TerrainMeshStore::add_tile");
+
+        const auto vertices_per_tile = get_num_terrain_tile_vertices(tile_size);
+        RX_ASSERT(vertices.size() == vertices_per_tile,
+                  "Terrain tile has %zu vertices, but it needs %u",
+                  vertices.size(),
+                  vertices_per_tile);
+
+        if(free_slots.is_empty()) {
+            logger->error("Can not add another terrain tile, all %u slots are in use", max_num_tiles);
+            return Rx::nullopt;
+        }
+
+        const auto slot = free_slots.last();
+        free_slots.pop_back();
+
+        const auto first_vertex = slot * vertices_per_tile;
+        const auto tile_data_size = static_cast<Uint32>(vertices_per_tile * sizeof(TerrainVertex));
+
+        upload_data_with_staging_buffer(commands,
+                                        *device,
+                                        vertex_buffer->resource.get(),
+                                        vertices.data(),
+                                        tile_data_size,
+                                        static_cast<Uint32>(first_vertex * sizeof(TerrainVertex)));
+
+        return TerrainTileMesh{.first_vertex = first_vertex};
+    }
+
+    void TerrainMeshStore::end_adding_tiles(ID3D12GraphicsCommandList4* commands) const {
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(vertex_buffer->resource.get(),
+                                                                  D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                  D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        commands->ResourceBarrier(1, &barrier);
+    }
+
+    void TerrainMeshStore::free_tile(const TerrainTileMesh& mesh) {
+        free_slots.push_back(mesh.first_vertex / get_num_terrain_tile_vertices(tile_size));
+    }
+
+    void TerrainMeshStore::bind_to_command_list(ID3D12GraphicsCommandList4* commands) const {
+        D3D12_VERTEX_BUFFER_VIEW vertex_view{};
+        vertex_view.BufferLocation = vertex_buffer->resource->GetGPUVirtualAddress();
+        vertex_view.SizeInBytes = vertex_buffer->size;
+        vertex_view.StrideInBytes = sizeof(TerrainVertex);
+
+        commands->IASetVertexBuffers(0, 1, &vertex_view);
+
+        D3D12_INDEX_BUFFER_VIEW index_view{};
+        index_view.BufferLocation = index_buffer->resource->GetGPUVirtualAddress();
+        index_view.SizeInBytes = index_buffer->size;
+        index_view.Format = DXGI_FORMAT_R16_UINT;
+
+        commands->IASetIndexBuffer(&index_view);
+
+        commands->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+
+    void TerrainMeshStore::create_index_buffer() {
+        ZoneScoped;
+
+        // Keep making coarser LODs until a LOD is just the tile's corners
+        Rx::Vector<Uint16> all_indices;
+        for(Uint32 lod = 0;; lod++) {
+            const auto lod_indices = build_tile_indices(tile_size, lod);
+
+            lods.push_back(
+                {.first_index = static_cast<Uint32>(all_indices.size()), .num_indices = static_cast<Uint32>(lod_indices.size())});
+            all_indices.append(lod_indices);
+
+            // The coarsest LOD is two triangles plus a quad of skirt on each side
+            if(lod_indices.size() <= 6 * 5) {
+                break;
+            }
+        }
+
+        const auto index_data_size = static_cast<Uint32>(all_indices.size() * sizeof(Uint16));
+        index_buffer = device->create_buffer(
+            {.name = "Terrain Index Buffer", .usage = BufferUsage::IndexBuffer, .size = ALIGN(4, index_data_size)});
+
+        auto commands = device->create_command_list();
+        commands->SetName(L"TerrainMeshStore::create_index_buffer");
+
+        upload_data_with_staging_buffer(commands.get(), *device, index_buffer->resource.get(), all_indices.data(), index_data_size, 0);
+
+        // Terrain tiles build their raytracing geometry from this index buffer, so it needs to be readable by the acceleration structure
+        // builder as well
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(index_buffer->resource.get(),
+                                                                  D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                  D3D12_RESOURCE_STATE_INDEX_BUFFER |
+                                                                      D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        commands->ResourceBarrier(1, &barrier);
+
+        device->submit_command_list(Rx::Utility::move(commands));
+
+        logger->verbose("Created terrain index buffer with %zu LODs for tiles of size %u", lods.size(), tile_size);
+    }
+} // namespace renderer
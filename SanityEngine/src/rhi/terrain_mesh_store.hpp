@@ -0,0 +1,126 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "resources.hpp"
+#include "rhi/terrain_vertex.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/ptr.h"
+#include "rx/core/vector.h"
+
+namespace renderer {
+    class RenderDevice;
+
+    /*!
+     * \brief A terrain tile's vertices in the terrain mesh store
+     */
+    struct TerrainTileMesh {
+        /*!
+         * \brief Index of the tile's first vertex in the terrain vertex buffer
+         */
+        Uint32 first_vertex{0};
+    };
+
+    /*!
+     * \brief The range of the shared index buffer that triangulates a tile at one level of detail
+     */
+    struct TerrainLod {
+        Uint32 first_index{0};
+        Uint32 num_indices{0};
+    };
+
+    /*!
+     * \brief Storage for terrain tile meshes
+     *
+     * Every terrain tile has the same topology, so all tiles share one index buffer with a triangulation for each level of detail. LOD 0
+     * uses every vertex in the tile, LOD 1 uses every second vertex, LOD 2 uses every fourth, and so on. Each LOD includes the tile's
+     * skirt. The indices are relative to the tile's first vertex, so tiles are drawn with their first vertex as the base vertex
+     *
+     * Tiles all have the same number of vertices, so the vertex buffer is split into fixed-size slots, one per tile
+     */
+    class TerrainMeshStore {
+    public:
+        /*!
+         * \brief Creates a new terrain mesh store and uploads the shared index buffer
+         *
+         * \param device_in The device to create the buffers with
+         * \param tile_size_in Number of grid vertices on each side of a tile. The edge length, `tile_size_in - 1`, must be a power of two
+         * \param max_num_tiles_in Maximum number of tiles that may be in the store at once
+         */
+        TerrainMeshStore(RenderDevice& device_in, Uint32 tile_size_in, Uint32 max_num_tiles_in);
+
+        TerrainMeshStore(const TerrainMeshStore& other) = delete;
+        TerrainMeshStore& operator=(const TerrainMeshStore& other) = delete;
+
+        TerrainMeshStore(TerrainMeshStore&& old) noexcept = delete;
+        TerrainMeshStore& operator=(TerrainMeshStore&& old) noexcept = delete;
+
+        ~TerrainMeshStore();
+
+        /*!
+         * \brief Builds the indices that triangulate a tile at a given level of detail
+         *
+         * The indices refer to vertices in a `tile_size * tile_size` grid, stored row-major, followed by the skirt vertices. Each LOD skips
+         * twice as many vertices as the LOD before it. The last row and column are always used, so tiles at every LOD cover the same area
+         */
+        [[nodiscard]] static Rx::Vector<Uint16> build_tile_indices(Uint32 tile_size, Uint32 lod);
+
+        [[nodiscard]] Uint32 get_tile_size() const;
+
+        [[nodiscard]] Uint32 get_num_lods() const;
+
+        [[nodiscard]] const TerrainLod& get_lod(Uint32 lod) const;
+
+        [[nodiscard]] Uint32 get_num_free_tiles() const;
+
+        [[nodiscard]] const Buffer& get_vertex_buffer() const;
+
+        [[nodiscard]] const Buffer& get_index_buffer() const;
+
+        /*!
+         * \brief Prepares the vertex buffer to receive new tiles
+         */
+        void begin_adding_tiles(ID3D12GraphicsCommandList4* commands) const;
+
+        /*!
+         * \brief Uploads a tile's vertices into a free slot. Must be called between `begin_adding_tiles` and `end_adding_tiles`
+         *
+         * \return The tile's mesh, or an empty optional if the store is full
+         */
+        [[nodiscard]] Rx::Optional<TerrainTileMesh> add_tile(const Rx::Vector<TerrainVertex>& vertices,
+                                                             ID3D12GraphicsCommandList4* commands);
+
+        /*!
+         * \brief Prepares the vertex buffer to be rendered with
+         */
+        void end_adding_tiles(ID3D12GraphicsCommandList4* commands) const;
+
+        /*!
+         * \brief Returns a tile's slot to the store
+         *
+         * This does not wait for the GPU. Callers must make sure that no in-flight frames still reference the tile
+         */
+        void free_tile(const TerrainTileMesh& mesh);
+
+        void bind_to_command_list(ID3D12GraphicsCommandList4* commands) const;
+
+    private:
+        RenderDevice* device;
+
+        Uint32 tile_size;
+
+        Uint32 max_num_tiles;
+
+        Rx::Ptr<Buffer> vertex_buffer;
+
+        Rx::Ptr<Buffer> index_buffer;
+
+        Rx::Vector<TerrainLod> lods;
+
+        /*!
+         * \brief Indices of the vertex buffer slots that don't have a tile in them
+         */
+        Rx::Vector<Uint32> free_slots;
+
+        void create_index_buffer();
+    };
+} // namespace renderer
@@ -0,0 +1,60 @@
+#include "terrain_vertex.hpp"
+
+#include <cmath>
+
+#include "rx/core/algorithm/clamp.h"
+
+static Float32 sign_not_zero(const Float32 value) { return value >= 0.0f ? 1.0f : -1.0f; }
+
+Vec2f encode_octahedral_normal(const Vec3f& normal) {
+    // Project onto the octahedron, then flatten it onto the XZ plane. Terrain normals mostly point up, so we fold the lower hemisphere
+    // into the corners
+    const auto inverse_l1_norm = 1.0f / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+    auto encoded = Vec2f{normal.x * inverse_l1_norm, normal.z * inverse_l1_norm};
+    if(normal.y < 0.0f) {
+        encoded = Vec2f{(1.0f - std::abs(encoded.y)) * sign_not_zero(encoded.x), (1.0f - std::abs(encoded.x)) * sign_not_zero(encoded.y)};
+    }
+
+    return encoded;
+}
+
+Vec3f decode_octahedral_normal(const Vec2f& encoded_normal) {
+    auto normal = Vec3f{encoded_normal.x, 1.0f - std::abs(encoded_normal.x) - std::abs(encoded_normal.y), encoded_normal.y};
+    if(normal.y < 0.0f) {
+        const auto x = normal.x;
+        normal.x = (1.0f - std::abs(normal.z)) * sign_not_zero(x);
+        normal.z = (1.0f - std::abs(x)) * sign_not_zero(normal.z);
+    }
+
+    return Rx::Math::normalize(normal);
+}
+
+TerrainVertex make_terrain_vertex(const Float32 normalized_height, const Vec3f& normal) {
+    const auto encoded_normal = encode_octahedral_normal(normal);
+
+    return TerrainVertex{
+        .normal_x = static_cast<Int16>(std::round(Rx::Algorithm::clamp(encoded_normal.x, -1.0f, 1.0f) * 32767.0f)),
+        .normal_y = static_cast<Int16>(std::round(Rx::Algorithm::clamp(encoded_normal.y, -1.0f, 1.0f) * 32767.0f)),
+        .height = static_cast<Uint16>(std::round(Rx::Algorithm::clamp(normalized_height, 0.0f, 1.0f) * 65535.0f)),
+    };
+}
+
+Vec2u get_terrain_skirt_grid_position(const Uint32 skirt_index, const Uint32 grid_size) {
+    const auto edge_length = grid_size - 1;
+    const auto side = skirt_index / edge_length;
+    const auto offset = skirt_index % edge_length;
+
+    switch(side) {
+        case 0:
+            return {offset, 0};
+
+        case 1:
+            return {edge_length, offset};
+
+        case 2:
+            return {edge_length - offset, edge_length};
+
+        default:
+            return {0, edge_length - offset};
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core/types.hpp"
+
+/*!
+ * \brief Compact vertex for terrain tiles
+ *
+ * Every terrain tile is a regular grid, so the vertex's x and z can be derived from its index in the tile and don't need to be stored.
+ * Texcoords come from x and z as well. That leaves the height and the normal:
+ *
+ * - The height is quantized to 16 bits across the terrain's height range. The tile's model matrix scales it back into meters
+ * - The normal is octahedral-encoded into two 16-bit snorms
+ *
+ * That's 8 bytes per vertex, instead of the 40 bytes that a StandardVertex takes
+ *
+ * A tile with a grid of `grid_size * grid_size` vertices stores them row-major, followed by one skirt vertex for every vertex on the edge
+ * of the grid. Skirt vertices hang below the edge of the tile, and hide the cracks between neighbouring tiles with different levels of
+ * detail. See `get_terrain_skirt_grid_position` for their order
+ */
+struct TerrainVertex {
+    Int16 normal_x{0};
+    Int16 normal_y{0};
+
+    Uint16 height{0};
+
+    /*!
+     * \brief Keeps the vertex four-byte aligned. Free for future use
+     */
+    Uint16 unused{0};
+};
+
+/*!
+ * \brief Builds a terrain vertex
+ *
+ * \param normalized_height The vertex's height, remapped so that 0 is the terrain's min height and 1 is the terrain's max height
+ * \param normal The vertex's normal. Must be normalized
+ */
+[[nodiscard]] TerrainVertex make_terrain_vertex(Float32 normalized_height, const Vec3f& normal);
+
+/*!
+ * \brief Encodes a normalized vector into two values in [-1, 1] with an octahedral mapping
+ */
+[[nodiscard]] Vec2f encode_octahedral_normal(const Vec3f& normal);
+
+/*!
+ * \brief Decodes a normal that was encoded with `encode_octahedral_normal`
+ */
+[[nodiscard]] Vec3f decode_octahedral_normal(const Vec2f& encoded_normal);
+
+/*!
+ * \brief Number of skirt vertices around a tile with `grid_size` vertices on each side
+ */
+[[nodiscard]] constexpr Uint32 get_num_terrain_skirt_vertices(const Uint32 grid_size) { return 4 * (grid_size - 1); }
+
+/*!
+ * \brief Number of vertices in a tile with `grid_size` vertices on each side, including its skirt
+ */
+[[nodiscard]] constexpr Uint32 get_num_terrain_tile_vertices(const Uint32 grid_size) {
+    return grid_size * grid_size + get_num_terrain_skirt_vertices(grid_size);
+}
+
+/*!
+ * \brief Finds the grid vertex that a skirt vertex hangs from
+ *
+ * Skirt vertices walk clockwise around the grid, starting at (0, 0): along the top edge in +x, down the right edge in +z, back along
+ * the bottom edge in -x, and up the left edge in -z. terrain.vertex.hlsl has a copy of this
+ */
+[[nodiscard]] Vec2u get_terrain_skirt_grid_position(Uint32 skirt_index, Uint32 grid_size);
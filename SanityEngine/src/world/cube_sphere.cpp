@@ -0,0 +1,391 @@
+#include "cube_sphere.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rx/core/algorithm/clamp.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+
+constexpr Float64 PI = 3.14159265358979323846;
+
+constexpr Float64 DEGREES_PER_RADIAN = 180.0 / PI;
+
+/*!
+ * \brief Each face's axes, in the same order as `CubeFace`
+ */
+static const CubeFaceAxes CUBE_FACE_AXES[NUM_CUBE_FACES] = {
+    {.normal = {1, 0, 0}, .u_axis = {0, 0, -1}, .v_axis = {0, -1, 0}},
+    {.normal = {-1, 0, 0}, .u_axis = {0, 0, 1}, .v_axis = {0, -1, 0}},
+    {.normal = {0, 1, 0}, .u_axis = {1, 0, 0}, .v_axis = {0, 0, 1}},
+    {.normal = {0, -1, 0}, .u_axis = {1, 0, 0}, .v_axis = {0, 0, -1}},
+    {.normal = {0, 0, 1}, .u_axis = {1, 0, 0}, .v_axis = {0, -1, 0}},
+    {.normal = {0, 0, -1}, .u_axis = {-1, 0, 0}, .v_axis = {0, -1, 0}},
+};
+
+static Vec3d normalize_direction(const Vec3d& direction) { return direction / std::sqrt(Rx::Math::dot(direction, direction)); }
+
+/*!
+ * \brief Inverse of `get_cube_face_tangent`
+ */
+static Float64 get_cube_face_coordinate(const Float64 tangent) { return std::atan(tangent) * (2.0 / PI) + 0.5; }
+
+/*!
+ * \brief Projects a direction onto a face, even if the direction passes through a different face
+ *
+ * Only meaningful for directions less than 90 degrees from the face's normal
+ */
+static Vec2d project_onto_face(const Vec3d& direction, const CubeFace face) {
+    const auto& axes = get_cube_face_axes(face);
+    const auto on_face = direction / Rx::Math::dot(direction, axes.normal);
+
+    return {get_cube_face_coordinate(Rx::Math::dot(on_face, axes.u_axis)), get_cube_face_coordinate(Rx::Math::dot(on_face, axes.v_axis))};
+}
+
+/*!
+ * \brief Gets the face whose normal is closest to a direction
+ */
+static CubeFace get_closest_face(const Vec3d& direction) {
+    auto closest_face = CubeFace::PositiveX;
+    auto closest_dot = Rx::Math::dot(direction, CUBE_FACE_AXES[0].normal);
+    for(Uint32 face = 1; face < NUM_CUBE_FACES; face++) {
+        // Strictly greater, so ties go to the face that comes first
+        const auto face_dot = Rx::Math::dot(direction, CUBE_FACE_AXES[face].normal);
+        if(face_dot > closest_dot) {
+            closest_face = static_cast<CubeFace>(face);
+            closest_dot = face_dot;
+        }
+    }
+
+    return closest_face;
+}
+
+/*!
+ * \brief Area of the spherical triangle between three directions, on the unit sphere
+ *
+ * Van Oosterom and Strackee's formula, which stays accurate for the tiny triangles of deep tiles
+ */
+static Float64 get_spherical_triangle_area(const Vec3d& a, const Vec3d& b, const Vec3d& c) {
+    const auto numerator = std::abs(Rx::Math::det(a, b, c));
+    const auto denominator = 1.0 + Rx::Math::dot(a, b) + Rx::Math::dot(b, c) + Rx::Math::dot(c, a);
+
+    return 2.0 * std::atan2(numerator, denominator);
+}
+
+/*!
+ * \brief Angle between two normalized directions, in radians
+ */
+static Float64 get_angle_between(const Vec3d& a, const Vec3d& b) {
+    // atan2 of the cross and dot products is accurate for small angles, where acos of the dot product isn't
+    const auto perpendicular = Rx::Math::cross(a, b);
+    return std::atan2(std::sqrt(Rx::Math::dot(perpendicular, perpendicular)), Rx::Math::dot(a, b));
+}
+
+bool CubeSphereTileKey::operator==(const CubeSphereTileKey& other) const {
+    return face == other.face && depth == other.depth && coord == other.coord;
+}
+
+bool CubeSphereTileKey::operator!=(const CubeSphereTileKey& other) const { return !(*this == other); }
+
+Uint32 CubeSphereTileKey::get_num_tiles_per_edge() const { return 1u << depth; }
+
+Vec2d CubeSphereTileKey::get_min_uv() const {
+    const auto uv_size = get_uv_size();
+    return {coord.x * uv_size, coord.y * uv_size};
+}
+
+Float64 CubeSphereTileKey::get_uv_size() const { return std::ldexp(1.0, -static_cast<int>(depth)); }
+
+CubeSphereTileKey CubeSphereTileKey::get_parent() const {
+    return {.face = face, .depth = depth - 1, .coord = {coord.x >> 1, coord.y >> 1}};
+}
+
+CubeSphereTileKey CubeSphereTileKey::get_child(const Uint32 index) const {
+    return {.face = face, .depth = depth + 1, .coord = coord * 2u + Vec2u{index & 1, index >> 1}};
+}
+
+bool CubeSphereTileKey::contains(const CubeSphereTileKey& other) const {
+    if(other.face != face || other.depth < depth) {
+        return false;
+    }
+
+    const auto depth_difference = other.depth - depth;
+    return Vec2u{other.coord.x >> depth_difference, other.coord.y >> depth_difference} == coord;
+}
+
+const CubeFaceAxes& get_cube_face_axes(const CubeFace face) { return CUBE_FACE_AXES[static_cast<Uint32>(face)]; }
+
+Float64 get_cube_face_tangent(const Float64 face_coordinate) { return std::tan((face_coordinate - 0.5) * (PI / 2.0)); }
+
+Vec3d get_cube_sphere_direction(const CubeFacePoint& point) {
+    const auto& axes = get_cube_face_axes(point.face);
+    return normalize_direction(axes.normal + axes.u_axis * get_cube_face_tangent(point.uv.x) +
+                               axes.v_axis * get_cube_face_tangent(point.uv.y));
+}
+
+CubeFacePoint get_cube_face_point(const Vec3d& direction) {
+    const auto face = get_closest_face(direction);
+    return {.face = face, .uv = project_onto_face(direction, face)};
+}
+
+Vec3d get_direction_from_lat_long(const LatLong& lat_long) {
+    const auto latitude = lat_long.latitude / DEGREES_PER_RADIAN;
+    const auto longitude = lat_long.longitude / DEGREES_PER_RADIAN;
+
+    return {std::cos(latitude) * std::cos(longitude), std::sin(latitude), std::cos(latitude) * std::sin(longitude)};
+}
+
+LatLong get_lat_long_from_direction(const Vec3d& direction) {
+    const auto horizontal_length = std::sqrt(direction.x * direction.x + direction.z * direction.z);
+
+    return {.latitude = std::atan2(direction.y, horizontal_length) * DEGREES_PER_RADIAN,
+            .longitude = std::atan2(direction.z, direction.x) * DEGREES_PER_RADIAN};
+}
+
+CubeFacePoint get_cube_face_point_from_lat_long(const LatLong& lat_long) {
+    return get_cube_face_point(get_direction_from_lat_long(lat_long));
+}
+
+LatLong get_lat_long_from_cube_face_point(const CubeFacePoint& point) {
+    return get_lat_long_from_direction(get_cube_sphere_direction(point));
+}
+
+CubeSphereTileKey get_cube_sphere_tile_containing(const Vec3d& direction, const Uint32 depth) {
+    const auto point = get_cube_face_point(direction);
+    const auto num_tiles = static_cast<Float64>(1u << depth);
+    const auto max_coord = (1u << depth) - 1;
+
+    // Points on the face's max edges would land one tile past the end
+    return {.face = point.face,
+            .depth = depth,
+            .coord = {Rx::Algorithm::min(static_cast<Uint32>(Rx::Algorithm::max(point.uv.x * num_tiles, 0.0)), max_coord),
+                      Rx::Algorithm::min(static_cast<Uint32>(Rx::Algorithm::max(point.uv.y * num_tiles, 0.0)), max_coord)}};
+}
+
+CubeSphereTileKey get_cube_sphere_tile_neighbour(const CubeSphereTileKey& tile, const CubeSphereTileEdge edge) {
+    const auto max_coord = tile.get_num_tiles_per_edge() - 1;
+
+    switch(edge) {
+        case CubeSphereTileEdge::MinU:
+            if(tile.coord.x > 0) {
+                return {.face = tile.face, .depth = tile.depth, .coord = {tile.coord.x - 1, tile.coord.y}};
+            }
+            break;
+
+        case CubeSphereTileEdge::MaxU:
+            if(tile.coord.x < max_coord) {
+                return {.face = tile.face, .depth = tile.depth, .coord = {tile.coord.x + 1, tile.coord.y}};
+            }
+            break;
+
+        case CubeSphereTileEdge::MinV:
+            if(tile.coord.y > 0) {
+                return {.face = tile.face, .depth = tile.depth, .coord = {tile.coord.x, tile.coord.y - 1}};
+            }
+            break;
+
+        case CubeSphereTileEdge::MaxV:
+            if(tile.coord.y < max_coord) {
+                return {.face = tile.face, .depth = tile.depth, .coord = {tile.coord.x, tile.coord.y + 1}};
+            }
+            break;
+    }
+
+    // The neighbour is on the face that the edge leads onto. Find where the middle of the shared edge is on that face. The middle of the
+    // edge is in the middle of the neighbour's edge too, so it's nowhere near the neighbour's corners and rounding can't pick wrong
+    const auto& axes = get_cube_face_axes(tile.face);
+    const auto min_uv = tile.get_min_uv();
+    const auto uv_size = tile.get_uv_size();
+
+    auto edge_middle = Vec2d{min_uv.x + uv_size * 0.5, min_uv.y + uv_size * 0.5};
+    auto edge_axis = Vec3d{};
+    switch(edge) {
+        case CubeSphereTileEdge::MinU:
+            edge_middle.x = 0;
+            edge_axis = -axes.u_axis;
+            break;
+
+        case CubeSphereTileEdge::MaxU:
+            edge_middle.x = 1;
+            edge_axis = axes.u_axis;
+            break;
+
+        case CubeSphereTileEdge::MinV:
+            edge_middle.y = 0;
+            edge_axis = -axes.v_axis;
+            break;
+
+        case CubeSphereTileEdge::MaxV:
+            edge_middle.y = 1;
+            edge_axis = axes.v_axis;
+            break;
+    }
+
+    const auto neighbour_face = get_closest_face(edge_axis);
+    const auto& neighbour_axes = get_cube_face_axes(neighbour_face);
+    const auto neighbour_uv = project_onto_face(get_cube_sphere_direction({.face = tile.face, .uv = edge_middle}), neighbour_face);
+
+    // This tile's face is along one of the neighbouring face's axes. The neighbour is on that axis's edge of its face. Along the other
+    // axis, it's wherever the middle of the shared edge is
+    const auto num_tiles = static_cast<Float64>(tile.get_num_tiles_per_edge());
+    const auto get_neighbour_coord = [&](const Vec3d& neighbour_axis, const Float64 face_coordinate) {
+        const auto toward_this_face = Rx::Math::dot(neighbour_axis, axes.normal);
+        if(toward_this_face > 0.5) {
+            return max_coord;
+        } else if(toward_this_face < -0.5) {
+            return 0u;
+        } else {
+            return Rx::Algorithm::min(static_cast<Uint32>(Rx::Algorithm::max(face_coordinate * num_tiles, 0.0)), max_coord);
+        }
+    };
+
+    return {.face = neighbour_face,
+            .depth = tile.depth,
+            .coord = {get_neighbour_coord(neighbour_axes.u_axis, neighbour_uv.x),
+                      get_neighbour_coord(neighbour_axes.v_axis, neighbour_uv.y)}};
+}
+
+Vec3d get_cube_sphere_tile_center(const CubeSphereTileKey& tile) {
+    const auto min_uv = tile.get_min_uv();
+    const auto half_size = tile.get_uv_size() * 0.5;
+
+    return get_cube_sphere_direction({.face = tile.face, .uv = {min_uv.x + half_size, min_uv.y + half_size}});
+}
+
+Float64 get_cube_sphere_tile_area(const CubeSphereTileKey& tile, const Float64 radius) {
+    const auto min_uv = tile.get_min_uv();
+    const auto max_uv = min_uv + tile.get_uv_size();
+
+    const auto corner_00 = get_cube_sphere_direction({.face = tile.face, .uv = min_uv});
+    const auto corner_10 = get_cube_sphere_direction({.face = tile.face, .uv = {max_uv.x, min_uv.y}});
+    const auto corner_11 = get_cube_sphere_direction({.face = tile.face, .uv = max_uv});
+    const auto corner_01 = get_cube_sphere_direction({.face = tile.face, .uv = {min_uv.x, max_uv.y}});
+
+    // The tile's edges and its diagonal are all great circle arcs, so the two triangles cover the tile exactly
+    const auto area = get_spherical_triangle_area(corner_00, corner_10, corner_11) +
+                      get_spherical_triangle_area(corner_00, corner_11, corner_01);
+    return area * radius * radius;
+}
+
+Float64 get_cube_sphere_tile_area_ratio(const Uint32 depth) {
+    const auto num_tiles = 1u << depth;
+
+    auto min_area = 4.0 * PI;
+    auto max_area = 0.0;
+    for(Uint32 y = 0; y < num_tiles; y++) {
+        for(Uint32 x = 0; x < num_tiles; x++) {
+            const auto area = get_cube_sphere_tile_area({.face = CubeFace::PositiveX, .depth = depth, .coord = {x, y}}, 1.0);
+            min_area = Rx::Algorithm::min(min_area, area);
+            max_area = Rx::Algorithm::max(max_area, area);
+        }
+    }
+
+    return min_area / max_area;
+}
+
+Uint32 get_cube_sphere_depth_for_tile_size(const Float64 radius, const Float64 tile_size) {
+    const auto face_width = radius * (PI / 2.0);
+    if(tile_size >= face_width) {
+        return 0;
+    }
+
+    return static_cast<Uint32>(std::ceil(std::log2(face_width / tile_size)));
+}
+
+Vec2d get_cube_sphere_texel_location(const CubeSphereTileKey& tile, const Uint32 heightmap_size, const Vec3d& direction) {
+    const auto uv = project_onto_face(direction, tile.face);
+    const auto texels_per_uv = static_cast<Float64>(heightmap_size - 1) / tile.get_uv_size();
+
+    return (uv - tile.get_min_uv()) * texels_per_uv;
+}
+
+Float32 sample_cube_sphere_heightmap(const TileHeightmap& heightmap, const CubeSphereTileKey& tile, const Vec3d& direction) {
+    const auto max_texel = static_cast<Float64>(heightmap.size - 1);
+    const auto texel_location = get_cube_sphere_texel_location(tile, heightmap.size, direction);
+    const auto x = Rx::Algorithm::clamp(texel_location.x, 0.0, max_texel);
+    const auto y = Rx::Algorithm::clamp(texel_location.y, 0.0, max_texel);
+
+    // The last texel's bilinear footprint would run off the heightmap, so back up one texel and use a weight of 1 instead
+    const auto x0 = Rx::Algorithm::min(static_cast<Uint32>(x), heightmap.size - 2);
+    const auto y0 = Rx::Algorithm::min(static_cast<Uint32>(y), heightmap.size - 2);
+    const auto x_weight = static_cast<Float32>(x - x0);
+    const auto y_weight = static_cast<Float32>(y - y0);
+
+    const auto top = heightmap.at(x0, y0) * (1.0f - x_weight) + heightmap.at(x0 + 1, y0) * x_weight;
+    const auto bottom = heightmap.at(x0, y0 + 1) * (1.0f - x_weight) + heightmap.at(x0 + 1, y0 + 1) * x_weight;
+
+    return top * (1.0f - y_weight) + bottom * y_weight;
+}
+
+/*!
+ * \brief Distance from a point to the closest point of the shell that a tile's terrain can be in
+ *
+ * The tile is bounded by the cone around its center that reaches its farthest corner, between the lowest and highest terrain heights.
+ * That's a little bigger than the tile, so this never overestimates the distance
+ */
+static Float64 get_distance_to_tile(const Vec3d& viewer_position,
+                                    const Float64 viewer_radius,
+                                    const CubeSphereTileKey& tile,
+                                    const CubeSphereStreamingSettings& streaming_settings,
+                                    const TerrainLodSettings& lod_settings) {
+    const auto center = get_cube_sphere_tile_center(tile);
+    const auto min_uv = tile.get_min_uv();
+    const auto max_uv = min_uv + tile.get_uv_size();
+
+    auto tile_angle = 0.0;
+    for(Uint32 corner = 0; corner < 4; corner++) {
+        const auto corner_uv = Vec2d{(corner & 1) != 0 ? max_uv.x : min_uv.x, (corner & 2) != 0 ? max_uv.y : min_uv.y};
+        const auto corner_direction = get_cube_sphere_direction({.face = tile.face, .uv = corner_uv});
+        tile_angle = Rx::Algorithm::max(tile_angle, get_angle_between(center, corner_direction));
+    }
+
+    const auto viewer_direction = viewer_radius > 0.0 ? viewer_position / viewer_radius : center;
+    const auto angle = Rx::Algorithm::max(get_angle_between(viewer_direction, center) - tile_angle, 0.0);
+    const auto cos_angle = std::cos(angle);
+
+    // The closest point on the ray at that angle is the viewer's projection onto it, clamped into the terrain's height range
+    const auto closest_radius = Rx::Algorithm::clamp(viewer_radius * cos_angle,
+                                                     streaming_settings.radius + lod_settings.min_terrain_height,
+                                                     streaming_settings.radius + lod_settings.max_terrain_height);
+
+    const auto distance_squared = viewer_radius * viewer_radius + closest_radius * closest_radius -
+                                  2.0 * viewer_radius * closest_radius * cos_angle;
+    return std::sqrt(Rx::Algorithm::max(distance_squared, 0.0));
+}
+
+void select_cube_sphere_tiles(const Vec3d& viewer_position,
+                              const CubeSphereStreamingSettings& streaming_settings,
+                              const TerrainLodSettings& lod_settings,
+                              Rx::Vector<CubeSphereTileRequest>& selection) {
+    selection.clear();
+
+    const auto viewer_radius = std::sqrt(Rx::Math::dot(viewer_position, viewer_position));
+    const auto finest_tile_size = streaming_settings.radius * (PI / 2.0) / static_cast<Float64>(1u << streaming_settings.max_depth);
+
+    const auto select_tile = [&](const auto& self, const CubeSphereTileKey& tile) -> void {
+        const auto distance = get_distance_to_tile(viewer_position, viewer_radius, tile, streaming_settings, lod_settings);
+        if(distance > streaming_settings.max_distance) {
+            return;
+        }
+
+        const auto level = streaming_settings.max_depth - tile.depth;
+        if(level == 0 || get_terrain_node_screen_space_error(level, static_cast<Float32>(distance), lod_settings) <=
+                             lod_settings.max_screen_space_error) {
+            selection.push_back({.tile = tile, .priority = static_cast<Float32>(distance / finest_tile_size)});
+            return;
+        }
+
+        for(Uint32 child = 0; child < 4; child++) {
+            self(self, tile.get_child(child));
+        }
+    };
+
+    for(Uint32 face = 0; face < NUM_CUBE_FACES; face++) {
+        select_tile(select_tile, {.face = static_cast<CubeFace>(face)});
+    }
+
+    // Rx::Algorithm::quick_sort loses and duplicates elements, so use the standard library's sort
+    std::sort(selection.data(),
+              selection.data() + selection.size(),
+              [](const CubeSphereTileRequest& a, const CubeSphereTileRequest& b) { return a.priority < b.priority; });
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/hash.h"
+#include "rx/core/vector.h"
+#include "world/heightmap_tile_pool.hpp"
+#include "world/terrain_lod.hpp"
+
+/*!
+ * \brief One of the six faces of the cube that a planet's terrain is projected from
+ *
+ * Each face is named for the axis that points out of its center. Y is up, so PositiveY is centered on the north pole. The faces' u and v
+ * axes run the same way as the faces of a D3D cube map, so a face can be baked straight into a cube map texture
+ */
+enum class CubeFace : Uint8 { PositiveX, NegativeX, PositiveY, NegativeY, PositiveZ, NegativeZ };
+
+constexpr Uint32 NUM_CUBE_FACES = 6;
+
+/*!
+ * \brief The directions that a cube face points along
+ */
+struct CubeFaceAxes {
+    /*!
+     * \brief Direction from the planet's center to the middle of the face
+     */
+    Vec3d normal{};
+
+    /*!
+     * \brief Direction that the face's u coordinate increases in
+     */
+    Vec3d u_axis{};
+
+    /*!
+     * \brief Direction that the face's v coordinate increases in
+     */
+    Vec3d v_axis{};
+};
+
+/*!
+ * \brief A point on one of the cube's faces
+ */
+struct CubeFacePoint {
+    CubeFace face{CubeFace::PositiveX};
+
+    /*!
+     * \brief Where the point is on the face. Both axes run from 0 to 1 across the face
+     *
+     * The face is mapped onto the sphere with an equi-angular projection: equal steps in u or v are equal angles from the planet's center.
+     * That keeps the smallest tile on a face within about 70% of the area of the biggest one, where projecting the cube straight onto the
+     * sphere shrinks the tiles in the corners to less than 20% of the ones in the middle
+     */
+    Vec2d uv{};
+};
+
+/*!
+ * \brief A location on a planet, in degrees
+ *
+ * Latitude runs from -90 at the south pole to 90 at the north pole. Longitude runs from -180 to 180, and increases to the east. Longitude
+ * 0 is on the positive X axis and longitude 90 is on the positive Z axis
+ */
+struct LatLong {
+    Float64 latitude{0};
+
+    Float64 longitude{0};
+};
+
+/*!
+ * \brief The four edges of a cube sphere tile
+ */
+enum class CubeSphereTileEdge : Uint8 { MinU, MaxU, MinV, MaxV };
+
+/*!
+ * \brief Identifies a tile of cube sphere terrain
+ *
+ * Each cube face has its own quadtree. The tile at depth 0 covers the whole face, and every depth splits its parent's tiles into four.
+ * Tile edges are arcs of great circles, so the tiles on either side of an edge meet along the same curve, even when the edge is between
+ * two faces
+ */
+struct CubeSphereTileKey {
+    CubeFace face{CubeFace::PositiveX};
+
+    Uint32 depth{0};
+
+    /*!
+     * \brief Coordinates of the tile on its face, from 0 to 2^depth - 1 along each axis
+     */
+    Vec2u coord{};
+
+    [[nodiscard]] bool operator==(const CubeSphereTileKey& other) const;
+
+    [[nodiscard]] bool operator!=(const CubeSphereTileKey& other) const;
+
+    /*!
+     * \brief Number of tiles along each edge of a face at this tile's depth
+     */
+    [[nodiscard]] Uint32 get_num_tiles_per_edge() const;
+
+    /*!
+     * \brief Face coordinates of the tile's corner with the lowest u and v
+     */
+    [[nodiscard]] Vec2d get_min_uv() const;
+
+    /*!
+     * \brief Width of the tile in face coordinates
+     */
+    [[nodiscard]] Float64 get_uv_size() const;
+
+    /*!
+     * \brief Gets the tile that this tile is one quarter of. Only valid for tiles below depth 0
+     */
+    [[nodiscard]] CubeSphereTileKey get_parent() const;
+
+    /*!
+     * \brief Gets one of this tile's four children
+     */
+    [[nodiscard]] CubeSphereTileKey get_child(Uint32 index) const;
+
+    /*!
+     * \brief Checks if this tile is `other` or one of its ancestors
+     */
+    [[nodiscard]] bool contains(const CubeSphereTileKey& other) const;
+};
+
+namespace Rx {
+    template <>
+    struct Hash<CubeSphereTileKey> {
+        Size operator()(const CubeSphereTileKey& key) const {
+            const auto hash = hash_combine(Hash<Uint32>{}(static_cast<Uint32>(key.face)), Hash<Uint32>{}(key.depth));
+            return hash_combine(hash, hash_combine(Hash<Uint32>{}(key.coord.x), Hash<Uint32>{}(key.coord.y)));
+        }
+    };
+} // namespace Rx
+
+struct CubeSphereStreamingSettings {
+    /*!
+     * \brief Radius of the planet at a height of 0, in meters
+     */
+    Float64 radius{6371000.0};
+
+    /*!
+     * \brief Depth of the most detailed tiles. `get_cube_sphere_depth_for_tile_size` picks this for a tile size
+     */
+    Uint32 max_depth{16};
+
+    /*!
+     * \brief Maximum distance from the viewer at which terrain gets loaded, in meters
+     */
+    Float64 max_distance{4096.0};
+};
+
+/*!
+ * \brief A tile that `select_cube_sphere_tiles` selected for rendering
+ */
+struct CubeSphereTileRequest {
+    CubeSphereTileKey tile{};
+
+    /*!
+     * \brief How urgently this tile is needed. Lower numbers are more urgent
+     */
+    Float32 priority{0};
+};
+
+[[nodiscard]] const CubeFaceAxes& get_cube_face_axes(CubeFace face);
+
+/*!
+ * \brief Gets the tangent of the angle between a face's normal and a point on the face, along one of the face's axes
+ *
+ * The direction through a point is `normal + tan(u) * u_axis + tan(v) * v_axis`, normalized. Callers that compute a lot of directions on
+ * a grid can compute the tangents of each row and column once and build the directions from those
+ */
+[[nodiscard]] Float64 get_cube_face_tangent(Float64 face_coordinate);
+
+/*!
+ * \brief Gets the normalized direction from the planet's center through a point on a cube face
+ */
+[[nodiscard]] Vec3d get_cube_sphere_direction(const CubeFacePoint& point);
+
+/*!
+ * \brief Gets the cube face point that a direction from the planet's center passes through
+ *
+ * Directions that point exactly at an edge or corner of the cube pick the face whose axis comes first in X, Y, Z order
+ */
+[[nodiscard]] CubeFacePoint get_cube_face_point(const Vec3d& direction);
+
+[[nodiscard]] Vec3d get_direction_from_lat_long(const LatLong& lat_long);
+
+[[nodiscard]] LatLong get_lat_long_from_direction(const Vec3d& direction);
+
+[[nodiscard]] CubeFacePoint get_cube_face_point_from_lat_long(const LatLong& lat_long);
+
+[[nodiscard]] LatLong get_lat_long_from_cube_face_point(const CubeFacePoint& point);
+
+/*!
+ * \brief Gets the tile at a depth that a direction from the planet's center passes through
+ */
+[[nodiscard]] CubeSphereTileKey get_cube_sphere_tile_containing(const Vec3d& direction, Uint32 depth);
+
+/*!
+ * \brief Gets the tile at the same depth on the other side of one of a tile's edges, which may be on another face
+ */
+[[nodiscard]] CubeSphereTileKey get_cube_sphere_tile_neighbour(const CubeSphereTileKey& tile, CubeSphereTileEdge edge);
+
+/*!
+ * \brief Gets the normalized direction from the planet's center through the middle of a tile
+ */
+[[nodiscard]] Vec3d get_cube_sphere_tile_center(const CubeSphereTileKey& tile);
+
+/*!
+ * \brief Area of a tile on a planet of the provided radius, in square meters
+ */
+[[nodiscard]] Float64 get_cube_sphere_tile_area(const CubeSphereTileKey& tile, Float64 radius);
+
+/*!
+ * \brief Gets the area of the smallest tile at a depth, divided by the area of the biggest tile at that depth
+ *
+ * Every face is the same, so this only looks at the tiles of one face. It looks at every one of them, so it gets slow past depth 10 or so
+ */
+[[nodiscard]] Float64 get_cube_sphere_tile_area_ratio(Uint32 depth);
+
+/*!
+ * \brief Gets the shallowest depth whose tiles are no wider than the provided size, on a planet of the provided radius
+ *
+ * The widest tiles at each depth are the ones along the middle of a face, which are a quarter of the planet's circumference divided by
+ * the number of tiles per edge
+ */
+[[nodiscard]] Uint32 get_cube_sphere_depth_for_tile_size(Float64 radius, Float64 tile_size);
+
+/*!
+ * \brief Gets where a direction falls in a tile's heightmap, in texels
+ *
+ * Texel (0, 0) is at the tile's corner with the lowest u and v, and texel (size - 1, size - 1) is at the opposite corner, so neighbouring
+ * tiles share their edge texels. The result isn't clamped to the heightmap
+ */
+[[nodiscard]] Vec2d get_cube_sphere_texel_location(const CubeSphereTileKey& tile, Uint32 heightmap_size, const Vec3d& direction);
+
+/*!
+ * \brief Looks up the height of a tile's heightmap in a direction from the planet's center, with bilinear filtering
+ *
+ * Directions that fall outside the tile get the height at the closest point of its edge. The heights along an edge are the same in both
+ * tiles that share it, so a query that lands on an edge gets the same height no matter which tile it's asked of
+ */
+[[nodiscard]] Float32 sample_cube_sphere_heightmap(const TileHeightmap& heightmap, const CubeSphereTileKey& tile, const Vec3d& direction);
+
+/*!
+ * \brief Selects the cube sphere tiles around a viewer, across every face of the planet
+ *
+ * Starts at the six faces, and splits every tile within the maximum distance of the viewer until its screen-space error is small enough
+ * or it reaches the maximum depth. The most detailed tiles count as level 0 of `TerrainLodSettings`, the next depth up as level 1, and so
+ * on. Tiles that touch more than one face split and stream just like any others, so there's no seam where faces meet. The selected tiles
+ * don't overlap
+ *
+ * Every tile's heightmap is the same size and every tile at a depth has about the same area, so each tile costs about the same to
+ * generate and the streaming scheduler can budget by tile count
+ *
+ * \param viewer_position Position of the viewer relative to the planet's center, in meters
+ * \param streaming_settings The planet's radius, the depth of the most detailed tiles, and how far to load terrain
+ * \param lod_settings LOD settings. `num_levels` isn't used, since every face's quadtree is `max_depth` deep
+ * \param selection Vector to write the selected tiles into, most urgent first. Any existing tiles are cleared
+ */
+void select_cube_sphere_tiles(const Vec3d& viewer_position,
+                              const CubeSphereStreamingSettings& streaming_settings,
+                              const TerrainLodSettings& lod_settings,
+                              Rx::Vector<CubeSphereTileRequest>& selection);
@@ -0,0 +1,701 @@
+#include "density_pipeline.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/clamp.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/log.h"
+#include "rx/core/string.h"
+#include "world/terrain_height_queries.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define DENSITY_PIPELINE_SSE2
+#include <emmintrin.h>
+#endif
+
+RX_LOG("DensityPipeline", logger);
+
+namespace environment {
+    /*!
+     * \brief Most nodes that a pipeline may have. Keeps a broken pipeline from eating all the registers
+     */
+    constexpr Uint32 MAX_PIPELINE_NODES = 256;
+
+    /*!
+     * \brief Deepest that nodes may nest
+     */
+    constexpr Uint32 MAX_PIPELINE_DEPTH = 32;
+
+    static_assert(DensityProgram::BATCH_SIZE % 4 == 0, "Batches must be made of whole SIMD vectors");
+
+    static Uint64 mix_hash(Uint64 hash, const Uint64 bits) {
+        hash ^= bits + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    static Uint64 get_float_bits(const Float32 value) {
+        Uint32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    /*!
+     * \brief Gets a property of a pipeline node, or null if the node doesn't have it
+     *
+     * json5 hands out a 0 for missing properties, which would look like a real number
+     */
+    static json5::value get_property(const json5::value& node, const char* key) {
+        const auto properties = json5::object_view{node};
+        const auto property = properties.find(key);
+        return property == properties.end() ? json5::value{nullptr} : (*property).second;
+    }
+
+    /*!
+     * \brief Turns the JSON nodes of a density pipeline into instructions, checking them on the way
+     *
+     * Nodes whose inputs are all constant get folded into a constant, so they cost nothing when the program runs
+     */
+    class DensityCompiler {
+    public:
+        explicit DensityCompiler(DensityProgram& program_in) : program{program_in} {}
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_node(const json5::value& node, const Rx::String& path, Uint32 depth);
+
+    private:
+        DensityProgram& program;
+
+        Uint32 num_nodes{0};
+
+        Uint16 add_instruction(DensityInstruction instruction);
+
+        Uint16 add_constant(Float32 value);
+
+        [[nodiscard]] bool is_constant(Uint16 reg) const;
+
+        [[nodiscard]] Float32 get_constant(Uint16 reg) const;
+
+        /*!
+         * \brief Removes the constants in the provided register and every register after it, so that folded constants don't leave dead
+         * instructions behind
+         */
+        void pop_constants(Uint16 reg);
+
+        [[nodiscard]] static bool read_number(
+            const json5::value& node, const char* key, Float32 default_value, Float32& value, const Rx::String& path);
+
+        [[nodiscard]] static bool read_range(const json5::value& node, const char* key, Float32 (&range)[2], const Rx::String& path);
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_noise(const json5::value& node, const Rx::String& path);
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_texture(const json5::value& node, const Rx::String& path);
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_distance_to_water(const json5::value& node, const Rx::String& path);
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_remap(const json5::value& node, const Rx::String& path, Uint32 depth);
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_threshold(const json5::value& node, const Rx::String& path, Uint32 depth);
+
+        [[nodiscard]] Rx::Optional<Uint16> compile_combine(DensityOp op, const json5::value& node, const Rx::String& path, Uint32 depth);
+
+        /*!
+         * \brief Adds an instruction that computes `value * scale + offset`, clamped to [min, max]
+         */
+        Uint16 add_linear(Uint16 input, Float32 scale, Float32 offset, Float32 min, Float32 max);
+    };
+
+    Rx::Optional<Uint16> DensityCompiler::compile_node(const json5::value& node, const Rx::String& path, const Uint32 depth) {
+        num_nodes++;
+        if(num_nodes > MAX_PIPELINE_NODES) {
+            logger->error("%s: Density pipelines may have at most %u nodes", path, MAX_PIPELINE_NODES);
+            return Rx::nullopt;
+        }
+
+        if(depth > MAX_PIPELINE_DEPTH) {
+            logger->error("%s: Density pipeline nodes may nest at most %u deep", path, MAX_PIPELINE_DEPTH);
+            return Rx::nullopt;
+        }
+
+        if(node.is_number()) {
+            return add_constant(node.get<Float32>());
+        }
+
+        if(!node.is_object()) {
+            logger->error("%s: Density pipeline nodes must be numbers or objects", path);
+            return Rx::nullopt;
+        }
+
+        const auto type_value = get_property(node, "type");
+        if(!type_value.is_string()) {
+            logger->error("%s: Density pipeline node has no type", path);
+            return Rx::nullopt;
+        }
+
+        const auto type = std::string_view{type_value.get_c_str()};
+        if(type == "noise") {
+            return compile_noise(node, path);
+
+        } else if(type == "texture") {
+            return compile_texture(node, path);
+
+        } else if(type == "slope") {
+            return add_instruction(DensityInstruction{.op = DensityOp::Slope});
+
+        } else if(type == "distance_to_water") {
+            return compile_distance_to_water(node, path);
+
+        } else if(type == "remap") {
+            return compile_remap(node, path, depth);
+
+        } else if(type == "threshold") {
+            return compile_threshold(node, path, depth);
+
+        } else if(type == "min") {
+            return compile_combine(DensityOp::Min, node, path, depth);
+
+        } else if(type == "max") {
+            return compile_combine(DensityOp::Max, node, path, depth);
+
+        } else if(type == "multiply") {
+            return compile_combine(DensityOp::Multiply, node, path, depth);
+        }
+
+        logger->error("%s: Unknown density pipeline node type '%s'", path, type_value.get_c_str());
+        return Rx::nullopt;
+    }
+
+    Uint16 DensityCompiler::add_instruction(DensityInstruction instruction) {
+        // Every instruction writes its own register, so register numbers are also instruction numbers
+        instruction.output = static_cast<Uint16>(program.num_registers++);
+        program.instructions.push_back(instruction);
+
+        return instruction.output;
+    }
+
+    Uint16 DensityCompiler::add_constant(const Float32 value) {
+        return add_instruction(DensityInstruction{.op = DensityOp::Constant, .parameters = {value}});
+    }
+
+    bool DensityCompiler::is_constant(const Uint16 reg) const {
+        return program.instructions[reg].op == DensityOp::Constant;
+    }
+
+    Float32 DensityCompiler::get_constant(const Uint16 reg) const { return program.instructions[reg].parameters[0]; }
+
+    void DensityCompiler::pop_constants(const Uint16 reg) {
+        // A fold's inputs are the last things that were compiled
+        while(program.num_registers > reg && is_constant(static_cast<Uint16>(program.num_registers - 1))) {
+            program.instructions.pop_back();
+            program.num_registers--;
+        }
+    }
+
+    bool DensityCompiler::read_number(
+        const json5::value& node, const char* key, const Float32 default_value, Float32& value, const Rx::String& path) {
+        const auto property = get_property(node, key);
+        if(property.is_null()) {
+            value = default_value;
+            return true;
+        }
+
+        if(!property.is_number()) {
+            logger->error("%s: '%s' must be a number", path, key);
+            return false;
+        }
+
+        value = property.get<Float32>();
+        return true;
+    }
+
+    bool DensityCompiler::read_range(const json5::value& node, const char* key, Float32 (&range)[2], const Rx::String& path) {
+        const auto property = get_property(node, key);
+        if(!property.is_array() || json5::array_view{property}.size() != 2 || !property[0].is_number() || !property[1].is_number()) {
+            logger->error("%s: '%s' must be an array of two numbers", path, key);
+            return false;
+        }
+
+        range[0] = property[0].get<Float32>();
+        range[1] = property[1].get<Float32>();
+        return true;
+    }
+
+    Rx::Optional<Uint16> DensityCompiler::compile_noise(const json5::value& node, const Rx::String& path) {
+        struct NoiseTypeName {
+            const char* name;
+            FastNoiseSIMD::NoiseType type;
+        };
+
+        static const NoiseTypeName NOISE_TYPES[] = {
+            {"value", FastNoiseSIMD::Value},
+            {"value_fractal", FastNoiseSIMD::ValueFractal},
+            {"perlin", FastNoiseSIMD::Perlin},
+            {"perlin_fractal", FastNoiseSIMD::PerlinFractal},
+            {"simplex", FastNoiseSIMD::Simplex},
+            {"simplex_fractal", FastNoiseSIMD::SimplexFractal},
+            {"white", FastNoiseSIMD::WhiteNoise},
+            {"cubic", FastNoiseSIMD::Cubic},
+            {"cubic_fractal", FastNoiseSIMD::CubicFractal},
+        };
+
+        auto config = terraingen::NoiseConfig{.noise_type = FastNoiseSIMD::SimplexFractal, .frequency = 0.01f, .octaves = 3};
+
+        const auto noise_type = get_property(node, "noise_type");
+        if(!noise_type.is_null()) {
+            const auto name = std::string_view{noise_type.get_c_str()};
+            bool is_known_type = false;
+            for(const auto& known_type : NOISE_TYPES) {
+                if(noise_type.is_string() && name == known_type.name) {
+                    config.noise_type = known_type.type;
+                    is_known_type = true;
+                }
+            }
+
+            if(!is_known_type) {
+                logger->error("%s: Unknown noise type '%s'", path, noise_type.get_c_str());
+                return Rx::nullopt;
+            }
+        }
+
+        Float32 seed;
+        Float32 octaves;
+        if(!read_number(node, "seed", static_cast<Float32>(config.seed), seed, path) ||
+           !read_number(node, "frequency", config.frequency, config.frequency, path) ||
+           !read_number(node, "octaves", static_cast<Float32>(config.octaves), octaves, path) ||
+           !read_number(node, "lacunarity", config.lacunarity, config.lacunarity, path) ||
+           !read_number(node, "gain", config.gain, config.gain, path)) {
+            return Rx::nullopt;
+        }
+
+        config.seed = static_cast<Int32>(seed);
+        config.octaves = static_cast<Int32>(octaves);
+
+        if(config.frequency <= 0) {
+            logger->error("%s: Noise frequency must be greater than 0", path);
+            return Rx::nullopt;
+        }
+
+        if(config.octaves < 1 || config.octaves > 16) {
+            logger->error("%s: Noise must have between 1 and 16 octaves", path);
+            return Rx::nullopt;
+        }
+
+        program.noises.push_back(config);
+        return add_instruction(DensityInstruction{.op = DensityOp::Noise, .noise_index = static_cast<Uint32>(program.noises.size() - 1)});
+    }
+
+    Rx::Optional<Uint16> DensityCompiler::compile_texture(const json5::value& node, const Rx::String& path) {
+        struct TextureName {
+            const char* name;
+            DensityTexture texture;
+        };
+
+        static const TextureName TEXTURES[] = {
+            {"height", DensityTexture::Height},
+            {"water_depth", DensityTexture::WaterDepth},
+            {"humidity", DensityTexture::Humidity},
+            {"soil_moisture", DensityTexture::SoilMoisture},
+            {"water_distance", DensityTexture::WaterDistance},
+            {"groundwater", DensityTexture::Groundwater},
+        };
+
+        const auto name_value = get_property(node, "name");
+        const auto name = std::string_view{name_value.get_c_str()};
+        for(const auto& texture : TEXTURES) {
+            if(name_value.is_string() && name == texture.name) {
+                return add_instruction(DensityInstruction{.op = DensityOp::Texture, .texture = texture.texture});
+            }
+        }
+
+        logger->error("%s: Unknown texture '%s'", path, name_value.get_c_str());
+        return Rx::nullopt;
+    }
+
+    Rx::Optional<Uint16> DensityCompiler::compile_distance_to_water(const json5::value& node, const Rx::String& path) {
+        Float32 max_distance;
+        if(!read_number(node, "max_distance", 64, max_distance, path)) {
+            return Rx::nullopt;
+        }
+
+        if(max_distance <= 0) {
+            logger->error("%s: 'max_distance' must be greater than 0", path);
+            return Rx::nullopt;
+        }
+
+        return add_instruction(DensityInstruction{.op = DensityOp::DistanceToWater, .parameters = {max_distance}});
+    }
+
+    Rx::Optional<Uint16> DensityCompiler::compile_remap(const json5::value& node, const Rx::String& path, const Uint32 depth) {
+        Float32 from[2];
+        Float32 to[2];
+        if(!read_range(node, "from", from, path) || !read_range(node, "to", to, path)) {
+            return Rx::nullopt;
+        }
+
+        if(from[0] == from[1]) {
+            logger->error("%s: 'from' must be a range of more than one value", path);
+            return Rx::nullopt;
+        }
+
+        const auto clamp = get_property(node, "clamp");
+        if(!clamp.is_null() && !clamp.is_boolean()) {
+            logger->error("%s: 'clamp' must be true or false", path);
+            return Rx::nullopt;
+        }
+
+        const auto input = compile_node(get_property(node, "input"), Rx::String::format("%s.input", path), depth + 1);
+        if(!input) {
+            return Rx::nullopt;
+        }
+
+        const auto scale = (to[1] - to[0]) / (from[1] - from[0]);
+        const auto offset = to[0] - from[0] * scale;
+        if(clamp.get_bool(true)) {
+            return add_linear(*input, scale, offset, Rx::Algorithm::min(to[0], to[1]), Rx::Algorithm::max(to[0], to[1]));
+        }
+
+        return add_linear(*input, scale, offset, -INFINITY, INFINITY);
+    }
+
+    Rx::Optional<Uint16> DensityCompiler::compile_threshold(const json5::value& node, const Rx::String& path, const Uint32 depth) {
+        Float32 threshold;
+        Float32 softness;
+        if(!read_number(node, "threshold", 0.5f, threshold, path) || !read_number(node, "softness", 0, softness, path)) {
+            return Rx::nullopt;
+        }
+
+        if(softness < 0) {
+            logger->error("%s: 'softness' can't be negative", path);
+            return Rx::nullopt;
+        }
+
+        const auto input = compile_node(get_property(node, "input"), Rx::String::format("%s.input", path), depth + 1);
+        if(!input) {
+            return Rx::nullopt;
+        }
+
+        // A soft threshold is a clamped ramp, which the linear instruction already does
+        if(softness > 0) {
+            const auto start = threshold - softness * 0.5f;
+            return add_linear(*input, 1.0f / softness, -start / softness, 0, 1);
+        }
+
+        if(is_constant(*input)) {
+            const auto value = get_constant(*input) >= threshold ? 1.0f : 0.0f;
+            pop_constants(*input);
+            return add_constant(value);
+        }
+
+        return add_instruction(DensityInstruction{.op = DensityOp::Threshold, .inputs = {*input}, .parameters = {threshold}});
+    }
+
+    Rx::Optional<Uint16> DensityCompiler::compile_combine(const DensityOp op,
+                                                          const json5::value& node,
+                                                          const Rx::String& path,
+                                                          const Uint32 depth) {
+        const auto inputs = get_property(node, "inputs");
+        if(!inputs.is_array() || json5::array_view{inputs}.size() < 2) {
+            logger->error("%s: 'inputs' must be an array of at least two nodes", path);
+            return Rx::nullopt;
+        }
+
+        const auto num_inputs = json5::array_view{inputs}.size();
+        auto result = compile_node(inputs[0], Rx::String::format("%s.inputs[0]", path), depth + 1);
+        for(Size i = 1; i < num_inputs && result; i++) {
+            const auto input = compile_node(inputs[i], Rx::String::format("%s.inputs[%zu]", path, i), depth + 1);
+            if(!input) {
+                return Rx::nullopt;
+            }
+
+            if(is_constant(*result) && is_constant(*input)) {
+                const auto a = get_constant(*result);
+                const auto b = get_constant(*input);
+                const auto value = op == DensityOp::Min ? Rx::Algorithm::min(a, b) :
+                                   op == DensityOp::Max ? Rx::Algorithm::max(a, b) :
+                                                          a * b;
+                pop_constants(*result);
+                result = add_constant(value);
+
+            } else {
+                result = add_instruction(DensityInstruction{.op = op, .inputs = {*result, *input}});
+            }
+        }
+
+        return result;
+    }
+
+    Uint16 DensityCompiler::add_linear(
+        const Uint16 input, const Float32 scale, const Float32 offset, const Float32 min, const Float32 max) {
+        if(is_constant(input)) {
+            const auto value = Rx::Algorithm::clamp(get_constant(input) * scale + offset, min, max);
+            pop_constants(input);
+            return add_constant(value);
+        }
+
+        return add_instruction(DensityInstruction{.op = DensityOp::Remap, .inputs = {input}, .parameters = {scale, offset, min, max}});
+    }
+
+    /*!
+     * \brief Bilinearly samples a map at a location in texels, clamping to the edges of the map
+     */
+    static Float32 sample_bilinear(const Rx::Vector<Float32>& map, const Uint32 width, const Uint32 depth, const Vec2f& texel_location) {
+        if(map.is_empty()) {
+            return 0;
+        }
+
+        const auto x = Rx::Algorithm::clamp(texel_location.x, 0.0f, static_cast<Float32>(width - 1));
+        const auto z = Rx::Algorithm::clamp(texel_location.y, 0.0f, static_cast<Float32>(depth - 1));
+        const auto x0 = static_cast<Uint32>(x);
+        const auto z0 = static_cast<Uint32>(z);
+        const auto x1 = Rx::Algorithm::min(x0 + 1, width - 1);
+        const auto z1 = Rx::Algorithm::min(z0 + 1, depth - 1);
+        const auto fraction_x = x - static_cast<Float32>(x0);
+        const auto fraction_z = z - static_cast<Float32>(z0);
+
+        const auto top = map[z0 * width + x0] + (map[z0 * width + x1] - map[z0 * width + x0]) * fraction_x;
+        const auto bottom = map[z1 * width + x0] + (map[z1 * width + x1] - map[z1 * width + x0]) * fraction_x;
+
+        return top + (bottom - top) * fraction_z;
+    }
+
+    static const Rx::Vector<Float32>& get_texture(const TerrainFallbackHeightmap& world_maps, const DensityTexture texture) {
+        switch(texture) {
+            case DensityTexture::Height:
+                return world_maps.heights;
+
+            case DensityTexture::WaterDepth:
+                return world_maps.water_depths;
+
+            case DensityTexture::Humidity:
+                return world_maps.humidity;
+
+            case DensityTexture::SoilMoisture:
+                return world_maps.soil_moisture;
+
+            case DensityTexture::WaterDistance:
+                return world_maps.water_distance;
+
+            case DensityTexture::Groundwater:
+                return world_maps.groundwater;
+        }
+
+        return world_maps.heights;
+    }
+
+    DensityScratch::DensityScratch()
+        : noise_locations{static_cast<int>(DensityProgram::BATCH_SIZE)},
+          noise_values{FastNoiseSIMD::GetEmptySet(static_cast<int>(DensityProgram::BATCH_SIZE))} {}
+
+    DensityScratch::~DensityScratch() { FastNoiseSIMD::FreeNoiseSet(noise_values); }
+
+    Rx::Optional<DensityProgram> DensityProgram::compile(const json5::value& pipeline) {
+        DensityProgram program;
+        DensityCompiler compiler{program};
+
+        const auto result = compiler.compile_node(pipeline, "pipeline", 0);
+        if(!result) {
+            return Rx::nullopt;
+        }
+
+        program.result = *result;
+        return program;
+    }
+
+    bool DensityProgram::is_empty() const { return instructions.is_empty(); }
+
+    Rx::Optional<Float32> DensityProgram::get_constant_density() const {
+        if(instructions.size() != 1 || instructions[0].op != DensityOp::Constant) {
+            return Rx::nullopt;
+        }
+
+        return Rx::Algorithm::clamp(instructions[0].parameters[0], 0.0f, 1.0f);
+    }
+
+    Uint64 DensityProgram::hash() const {
+        Uint64 hash = mix_hash(num_registers, result);
+        instructions.each_fwd([&](const DensityInstruction& instruction) {
+            hash = mix_hash(hash, static_cast<Uint64>(instruction.op) | static_cast<Uint64>(instruction.texture) << 8);
+            hash = mix_hash(hash, static_cast<Uint64>(instruction.output) | static_cast<Uint64>(instruction.inputs[0]) << 16 |
+                                      static_cast<Uint64>(instruction.inputs[1]) << 32);
+            hash = mix_hash(hash, instruction.noise_index);
+            for(const auto parameter : instruction.parameters) {
+                hash = mix_hash(hash, get_float_bits(parameter));
+            }
+        });
+        noises.each_fwd([&](const terraingen::NoiseConfig& noise) { hash = mix_hash(hash, noise.hash()); });
+
+        return hash;
+    }
+
+    void DensityProgram::evaluate(const TerrainFallbackHeightmap* world_maps,
+                                  const std::span<const Vec2f> locations,
+                                  Float32* densities,
+                                  DensityScratch& scratch) const {
+        ZoneScoped;
+
+        scratch.registers.resize(static_cast<Size>(num_registers) * BATCH_SIZE);
+        const auto get_register = [&](const Uint16 reg) { return scratch.registers.data() + static_cast<Size>(reg) * BATCH_SIZE; };
+
+        // Constants never change, so they only get written once
+        instructions.each_fwd([&](const DensityInstruction& instruction) {
+            if(instruction.op == DensityOp::Constant) {
+                auto* output = get_register(instruction.output);
+                for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                    output[lane] = instruction.parameters[0];
+                }
+            }
+        });
+
+        Vec2f texel_locations[BATCH_SIZE];
+        for(Size batch_start = 0; batch_start < locations.size(); batch_start += BATCH_SIZE) {
+            // Short batches repeat their last location, so that every instruction can work on whole batches
+            const auto batch_size = Rx::Algorithm::min(locations.size() - batch_start, static_cast<Size>(BATCH_SIZE));
+            for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                const auto& location = locations[batch_start + Rx::Algorithm::min(static_cast<Size>(lane), batch_size - 1)];
+                texel_locations[lane] = world_maps != nullptr ? location - world_maps->origin : location;
+
+                // Noise runs on the same axes as the terrain's heightmaps, so pipelines can reuse the terrain's noise settings
+                scratch.noise_locations.xSet[lane] = location.y;
+                scratch.noise_locations.ySet[lane] = location.x;
+                scratch.noise_locations.zSet[lane] = 0;
+            }
+
+            for(Size i = 0; i < instructions.size(); i++) {
+                const auto& instruction = instructions[i];
+                auto* output = get_register(instruction.output);
+                const auto* a = get_register(instruction.inputs[0]);
+                const auto* b = get_register(instruction.inputs[1]);
+
+                switch(instruction.op) {
+                    case DensityOp::Constant:
+                        break;
+
+                    case DensityOp::Noise: {
+                        // The thread's generator keeps the last remap that was set with the same config, such as the terrain's
+                        auto& generator = terraingen::get_thread_noise_generator(noises[instruction.noise_index]);
+                        generator.SetOutputRemap(1, 0);
+                        generator.FillNoiseSet(scratch.noise_values, &scratch.noise_locations);
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            output[lane] = scratch.noise_values[lane] * 0.5f + 0.5f;
+                        }
+                    } break;
+
+                    case DensityOp::Texture: {
+                        if(world_maps == nullptr) {
+                            memset(output, 0, BATCH_SIZE * sizeof(Float32));
+                            break;
+                        }
+
+                        const auto& texture = get_texture(*world_maps, instruction.texture);
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            output[lane] = sample_bilinear(texture, world_maps->width, world_maps->depth, texel_locations[lane]);
+                        }
+                    } break;
+
+                    case DensityOp::Slope: {
+                        if(world_maps == nullptr || world_maps->heights.is_empty()) {
+                            memset(output, 0, BATCH_SIZE * sizeof(Float32));
+                            break;
+                        }
+
+                        const auto& heights = world_maps->heights;
+                        const auto width = world_maps->width;
+                        const auto depth = world_maps->depth;
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            const auto& location = texel_locations[lane];
+                            const auto left = sample_bilinear(heights, width, depth, {location.x - 1, location.y});
+                            const auto right = sample_bilinear(heights, width, depth, {location.x + 1, location.y});
+                            const auto up = sample_bilinear(heights, width, depth, {location.x, location.y - 1});
+                            const auto down = sample_bilinear(heights, width, depth, {location.x, location.y + 1});
+                            const auto slope_x = (right - left) * 0.5f;
+                            const auto slope_z = (down - up) * 0.5f;
+                            output[lane] = std::sqrt(slope_x * slope_x + slope_z * slope_z);
+                        }
+                    } break;
+
+                    case DensityOp::DistanceToWater: {
+                        const auto max_distance = instruction.parameters[0];
+                        if(world_maps == nullptr || world_maps->water_distance.is_empty()) {
+                            for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                                output[lane] = max_distance;
+                            }
+                            break;
+                        }
+
+                        const auto& water_distance = world_maps->water_distance;
+                        const auto width = world_maps->width;
+                        const auto depth = world_maps->depth;
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            const auto distance = sample_bilinear(water_distance, width, depth, texel_locations[lane]);
+                            output[lane] = Rx::Algorithm::min(distance, max_distance);
+                        }
+                    } break;
+
+                    case DensityOp::Remap: {
+                        const auto scale = instruction.parameters[0];
+                        const auto offset = instruction.parameters[1];
+                        const auto min = instruction.parameters[2];
+                        const auto max = instruction.parameters[3];
+#ifdef DENSITY_PIPELINE_SSE2
+                        const auto scale_v = _mm_set1_ps(scale);
+                        const auto offset_v = _mm_set1_ps(offset);
+                        const auto min_v = _mm_set1_ps(min);
+                        const auto max_v = _mm_set1_ps(max);
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane += 4) {
+                            const auto value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + lane), scale_v), offset_v);
+                            _mm_storeu_ps(output + lane, _mm_min_ps(_mm_max_ps(value, min_v), max_v));
+                        }
+#else
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            output[lane] = Rx::Algorithm::clamp(a[lane] * scale + offset, min, max);
+                        }
+#endif
+                    } break;
+
+                    case DensityOp::Threshold: {
+                        const auto threshold = instruction.parameters[0];
+#ifdef DENSITY_PIPELINE_SSE2
+                        const auto threshold_v = _mm_set1_ps(threshold);
+                        const auto one_v = _mm_set1_ps(1);
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane += 4) {
+                            _mm_storeu_ps(output + lane, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(a + lane), threshold_v), one_v));
+                        }
+#else
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            output[lane] = a[lane] >= threshold ? 1.0f : 0.0f;
+                        }
+#endif
+                    } break;
+
+                    case DensityOp::Min:
+                    case DensityOp::Max:
+                    case DensityOp::Multiply: {
+#ifdef DENSITY_PIPELINE_SSE2
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane += 4) {
+                            const auto value_a = _mm_loadu_ps(a + lane);
+                            const auto value_b = _mm_loadu_ps(b + lane);
+                            const auto value = instruction.op == DensityOp::Min   ? _mm_min_ps(value_a, value_b) :
+                                               instruction.op == DensityOp::Max   ? _mm_max_ps(value_a, value_b) :
+                                                                                    _mm_mul_ps(value_a, value_b);
+                            _mm_storeu_ps(output + lane, value);
+                        }
+#else
+                        for(Uint32 lane = 0; lane < BATCH_SIZE; lane++) {
+                            output[lane] = instruction.op == DensityOp::Min ? Rx::Algorithm::min(a[lane], b[lane]) :
+                                           instruction.op == DensityOp::Max ? Rx::Algorithm::max(a[lane], b[lane]) :
+                                                                              a[lane] * b[lane];
+                        }
+#endif
+                    } break;
+                }
+            }
+
+            const auto* result_values = get_register(result);
+            for(Size lane = 0; lane < batch_size; lane++) {
+                densities[batch_start + lane] = Rx::Algorithm::clamp(result_values[lane], 0.0f, 1.0f);
+            }
+        }
+    }
+} // namespace environment
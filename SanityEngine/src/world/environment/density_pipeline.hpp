@@ -0,0 +1,162 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "json5/json5.hpp"
+#include "noise/FastNoiseSIMD/FastNoiseSIMD.h"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+#include "world/generation/terrain_noise.hpp"
+
+struct TerrainFallbackHeightmap;
+
+namespace environment {
+    /*!
+     * \brief The informational textures that a density pipeline can sample
+     */
+    enum class DensityTexture : Uint8 { Height, WaterDepth, Humidity, SoilMoisture, WaterDistance, Groundwater };
+
+    enum class DensityOp : Uint8 {
+        Constant,
+        Noise,
+        Texture,
+        Slope,
+        DistanceToWater,
+        Remap,
+        Threshold,
+        Min,
+        Max,
+        Multiply,
+    };
+
+    /*!
+     * \brief One step of a compiled density pipeline. Reads up to two registers and writes one
+     */
+    struct DensityInstruction {
+        DensityOp op{DensityOp::Constant};
+
+        DensityTexture texture{DensityTexture::Height};
+
+        Uint16 output{0};
+
+        Uint16 inputs[2]{};
+
+        /*!
+         * \brief Index of the noise settings, for noise instructions
+         */
+        Uint32 noise_index{0};
+
+        /*!
+         * \brief The instruction's constants. What they mean depends on the op
+         */
+        Float32 parameters[4]{};
+    };
+
+    class DensityProgram;
+
+    /*!
+     * \brief Working memory for evaluating density programs. Each thread that evaluates programs needs its own
+     */
+    class DensityScratch {
+    public:
+        DensityScratch();
+
+        DensityScratch(const DensityScratch& other) = delete;
+        DensityScratch& operator=(const DensityScratch& other) = delete;
+
+        DensityScratch(DensityScratch&& old) noexcept = delete;
+        DensityScratch& operator=(DensityScratch&& old) noexcept = delete;
+
+        ~DensityScratch();
+
+    private:
+        friend class DensityProgram;
+
+        /*!
+         * \brief One batch of values for each register of the program being evaluated
+         */
+        Rx::Vector<Float32> registers;
+
+        FastNoiseVectorSet noise_locations;
+
+        /*!
+         * \brief Where FastNoiseSIMD writes its noise. Must be aligned for its SIMD stores, so FastNoiseSIMD allocates it
+         */
+        Float32* noise_values;
+    };
+
+    /*!
+     * \brief A density pipeline that's been checked and compiled into a flat list of instructions
+     *
+     * Evaluating a program runs every instruction over a batch of `BATCH_SIZE` locations before moving on to the next batch, so all the
+     * intermediate values for a batch stay in a few kilobytes of registers instead of filling whole maps. Noise runs through
+     * FastNoiseSIMD's vector sets, and the arithmetic runs four lanes at a time
+     */
+    class DensityProgram {
+    public:
+        static constexpr Uint32 BATCH_SIZE = 64;
+
+        /*!
+         * \brief Checks and compiles a density pipeline
+         *
+         * A pipeline is a number, which is a constant density, or an object with a `type` and the type's properties. Nodes that have an
+         * `input` or `inputs` take other nodes:
+         *
+         * - `noise`: FastNoiseSIMD noise, mapped to [0, 1]. Optional `noise_type` (`value`, `perlin`, `simplex`, `cubic`, `white`, or one
+         * of the first four followed by `_fractal`; defaults to `simplex_fractal`), `seed`, `frequency`, `octaves`, `lacunarity`, `gain`
+         * - `texture`: bilinearly samples the `name`d informational texture, one of `height`, `water_depth`, `humidity`, `soil_moisture`,
+         * `water_distance` or `groundwater`
+         * - `slope`: steepness of the terrain, as height over distance
+         * - `distance_to_water`: meters to the nearest ocean, river, or lake texel, up to `max_distance` (defaults to 64). Reads the
+         * world's distance to water map
+         * - `remap`: maps `input` linearly `from` one range `to` another, both arrays of two numbers. Clamps to the `to` range unless
+         * `clamp` is false
+         * - `threshold`: 1 where `input` is at least `threshold` and 0 below it, with a linear ramp that's `softness` wide around the
+         * threshold
+         * - `min`, `max`, `multiply`: combine two or more `inputs`
+         *
+         * The final density is clamped to [0, 1]
+         *
+         * \return The compiled program, or nothing if the pipeline isn't valid. Errors get logged
+         */
+        [[nodiscard]] static Rx::Optional<DensityProgram> compile(const json5::value& pipeline);
+
+        [[nodiscard]] bool is_empty() const;
+
+        /*!
+         * \brief Gets the density that the program always evaluates to, or nothing if the density depends on the location
+         */
+        [[nodiscard]] Rx::Optional<Float32> get_constant_density() const;
+
+        [[nodiscard]] Uint64 hash() const;
+
+        /*!
+         * \brief Evaluates the program at a batch of locations
+         *
+         * \param world_maps The maps that were generated with the world. Texture, slope and distance nodes read from them. May be null, in
+         * which case textures and slopes are 0 and there's no water in range
+         * \param locations World x and z coordinates to evaluate at
+         * \param densities Where to write the densities. Must be at least as big as `locations`
+         * \param scratch Working memory for the evaluation
+         */
+        void evaluate(const TerrainFallbackHeightmap* world_maps,
+                      std::span<const Vec2f> locations,
+                      Float32* densities,
+                      DensityScratch& scratch) const;
+
+    private:
+        friend class DensityCompiler;
+
+        Rx::Vector<DensityInstruction> instructions;
+
+        Rx::Vector<terraingen::NoiseConfig> noises;
+
+        Uint32 num_registers{0};
+
+        /*!
+         * \brief Register that holds the density once every instruction has run
+         */
+        Uint16 result{0};
+    };
+} // namespace environment
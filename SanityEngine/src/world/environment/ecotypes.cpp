@@ -0,0 +1,148 @@
+#include "ecotypes.hpp"
+
+#include <cmath>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+
+namespace environment {
+    static Int32 get_nearest_texel(const Float32 coordinate) { return static_cast<Int32>(std::floor(coordinate + 0.5f)); }
+
+    /*!
+     * \brief Gets the steepest slope from a texel to its neighbours along the axes, as height over distance
+     */
+    static Float32 get_slope(const EcotypeFields& fields, const Uint32 x, const Uint32 z) {
+        const auto* height = &fields.heights[static_cast<Size>(z) * fields.width + x];
+        const auto left = x > 0 ? height[-1] : height[0];
+        const auto right = x + 1 < fields.width ? height[1] : height[0];
+        const auto up = z > 0 ? height[-static_cast<Int64>(fields.width)] : height[0];
+        const auto down = z + 1 < fields.depth ? height[fields.width] : height[0];
+
+        return Rx::Algorithm::max(std::abs(right - left), std::abs(down - up)) * 0.5f;
+    }
+
+    static Ecotype classify_texel(const EcotypeFields& fields, const EcotypeSettings& settings, const Uint32 x, const Uint32 z) {
+        const auto texel = static_cast<Size>(z) * fields.width + x;
+        const auto height = fields.heights[texel];
+
+        if(height < settings.sea_level - settings.tidal_range) {
+            return Ecotype::Ocean;
+        }
+
+        if(!fields.water_depths.empty() && fields.water_depths[texel] > 0) {
+            return !fields.river_mask.empty() && fields.river_mask[texel] != 0 ? Ecotype::River : Ecotype::Lake;
+        }
+
+        if(height <= settings.sea_level + settings.tidal_range) {
+            return Ecotype::TidalZone;
+        }
+
+        const auto slope = get_slope(fields, x, z);
+        if(slope <= settings.max_vegetation_slope) {
+            if(!fields.soil_moisture.empty() && fields.soil_moisture[texel] >= settings.min_forest_soil_moisture) {
+                return Ecotype::Forest;
+            }
+
+            const auto humidity = fields.humidity.empty() ? settings.min_lush_grassland_humidity : fields.humidity[texel];
+            if(humidity >= settings.min_lush_grassland_humidity) {
+                return Ecotype::LushGrassland;
+            }
+
+            if(humidity >= settings.min_arid_grassland_humidity) {
+                return Ecotype::AridGrassland;
+            }
+        }
+
+        return slope >= settings.min_rocky_desert_slope ? Ecotype::RockyDesert : Ecotype::SandyDesert;
+    }
+
+    const char* to_string(const Ecotype ecotype) {
+        switch(ecotype) {
+            case Ecotype::Ocean:
+                return "Ocean";
+
+            case Ecotype::TidalZone:
+                return "Tidal zone";
+
+            case Ecotype::River:
+                return "River";
+
+            case Ecotype::Lake:
+                return "Lake";
+
+            case Ecotype::Forest:
+                return "Forest";
+
+            case Ecotype::LushGrassland:
+                return "Lush grassland";
+
+            case Ecotype::AridGrassland:
+                return "Arid grassland";
+
+            case Ecotype::RockyDesert:
+                return "Rocky desert";
+
+            case Ecotype::SandyDesert:
+                return "Sandy desert";
+        }
+
+        return "Unknown";
+    }
+
+    bool EcotypeMap::is_empty() const { return ecotypes.is_empty(); }
+
+    EcotypeMask EcotypeMap::get_ecotype_at(const Vec2f& texel_location) const {
+        const auto x = get_nearest_texel(texel_location.x);
+        const auto z = get_nearest_texel(texel_location.y);
+        if(x < 0 || z < 0 || x >= static_cast<Int32>(width) || z >= static_cast<Int32>(depth)) {
+            return ALL_ECOTYPES;
+        }
+
+        return to_mask(ecotypes[static_cast<Size>(z) * width + x]);
+    }
+
+    EcotypeMask EcotypeMap::get_ecotypes_in_rect(const Vec2f& texel_min, const Vec2f& texel_max) const {
+        const auto min_x = get_nearest_texel(texel_min.x);
+        const auto min_z = get_nearest_texel(texel_min.y);
+        const auto max_x = get_nearest_texel(texel_max.x);
+        const auto max_z = get_nearest_texel(texel_max.y);
+        if(min_x < 0 || min_z < 0 || max_x >= static_cast<Int32>(width) || max_z >= static_cast<Int32>(depth)) {
+            return ALL_ECOTYPES;
+        }
+
+        EcotypeMask mask = 0;
+        for(auto block_z = min_z / static_cast<Int32>(BLOCK_SIZE); block_z <= max_z / static_cast<Int32>(BLOCK_SIZE); block_z++) {
+            for(auto block_x = min_x / static_cast<Int32>(BLOCK_SIZE); block_x <= max_x / static_cast<Int32>(BLOCK_SIZE); block_x++) {
+                mask |= block_masks[static_cast<Size>(block_z) * num_blocks_x + block_x];
+            }
+        }
+
+        return mask;
+    }
+
+    EcotypeMap classify_ecotypes(const EcotypeFields& fields, const EcotypeSettings& settings) {
+        ZoneScoped;
+
+        auto map = EcotypeMap{.width = fields.width,
+                              .depth = fields.depth,
+                              .num_blocks_x = (fields.width + EcotypeMap::BLOCK_SIZE - 1) / EcotypeMap::BLOCK_SIZE,
+                              .num_blocks_z = (fields.depth + EcotypeMap::BLOCK_SIZE - 1) / EcotypeMap::BLOCK_SIZE};
+        if(fields.heights.size() != static_cast<Size>(fields.width) * fields.depth) {
+            return {};
+        }
+
+        map.ecotypes.resize(fields.heights.size(), Ecotype::Ocean);
+        map.block_masks.resize(static_cast<Size>(map.num_blocks_x) * map.num_blocks_z, 0u);
+
+        for(Uint32 z = 0; z < fields.depth; z++) {
+            auto* block_masks = &map.block_masks[static_cast<Size>(z / EcotypeMap::BLOCK_SIZE) * map.num_blocks_x];
+            for(Uint32 x = 0; x < fields.width; x++) {
+                const auto ecotype = classify_texel(fields, settings, x, z);
+                map.ecotypes[static_cast<Size>(z) * fields.width + x] = ecotype;
+                block_masks[x / EcotypeMap::BLOCK_SIZE] |= to_mask(ecotype);
+            }
+        }
+
+        return map;
+    }
+} // namespace environment
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace environment {
+    /*!
+     * \brief A kind of place that environment objects can spawn in. Each biome from `docs/terrain/Biomes.md` is one ecotype
+     *
+     * Objects register for the ecotypes that they can spawn in. Only the objects that are registered for the ecotypes in a tile get their
+     * densities evaluated there
+     */
+    enum class Ecotype : Uint8 {
+        Ocean,
+        TidalZone,
+        River,
+        Lake,
+        Forest,
+        LushGrassland,
+        AridGrassland,
+        RockyDesert,
+        SandyDesert,
+    };
+
+    constexpr Uint32 NUM_ECOTYPES = 9;
+
+    /*!
+     * \brief A set of ecotypes, with one bit per ecotype
+     */
+    using EcotypeMask = Uint32;
+
+    constexpr EcotypeMask ALL_ECOTYPES = (1u << NUM_ECOTYPES) - 1;
+
+    [[nodiscard]] constexpr EcotypeMask to_mask(const Ecotype ecotype) { return 1u << static_cast<Uint32>(ecotype); }
+
+    [[nodiscard]] const char* to_string(Ecotype ecotype);
+
+    struct EcotypeSettings {
+        /*!
+         * \brief Height of the ocean's surface
+         */
+        Float32 sea_level{0};
+
+        /*!
+         * \brief Land and ocean floor within this many meters of sea level is tidal zone
+         */
+        Float32 tidal_range{2};
+
+        /*!
+         * \brief Land that's steeper than this, as height over distance, is too steep for forests or grass
+         */
+        Float32 max_vegetation_slope{0.8f};
+
+        /*!
+         * \brief Soil moisture that a forest needs
+         */
+        Float32 min_forest_soil_moisture{0.55f};
+
+        /*!
+         * \brief Humidity that lush grasslands need
+         */
+        Float32 min_lush_grassland_humidity{0.45f};
+
+        /*!
+         * \brief Humidity that arid grasslands need. Anything drier is desert
+         */
+        Float32 min_arid_grassland_humidity{0.2f};
+
+        /*!
+         * \brief Deserts that are steeper than this, as height over distance, are rocky. Flatter deserts are sandy
+         */
+        Float32 min_rocky_desert_slope{0.3f};
+    };
+
+    /*!
+     * \brief The terrain and climate maps that decide the ecotypes. All the maps have `width * depth` texels in rows along the x axis, one
+     * texel per meter
+     */
+    struct EcotypeFields {
+        Uint32 width{0};
+
+        Uint32 depth{0};
+
+        std::span<const Float32> heights;
+
+        /*!
+         * \brief Depth of the lakes and rivers on each texel. May be empty
+         */
+        std::span<const Float32> water_depths;
+
+        /*!
+         * \brief 1 for river texels. May be empty, in which case all the water that isn't ocean is lakes
+         */
+        std::span<const Uint8> river_mask;
+
+        /*!
+         * \brief Humidity of the air, from 0 to 1. May be empty, in which case the air everywhere is as humid as the lush grasslands need
+         */
+        std::span<const Float32> humidity;
+
+        /*!
+         * \brief Soil moisture, from 0 to 1. May be empty, in which case there are no forests
+         */
+        std::span<const Float32> soil_moisture;
+    };
+
+    /*!
+     * \brief The ecotype of every texel of the world's maps, with a mask of the ecotypes in each block of texels so that a tile can find
+     * its ecotypes without looking at every texel
+     */
+    struct EcotypeMap {
+        /*!
+         * \brief Width of a block, in texels
+         */
+        static constexpr Uint32 BLOCK_SIZE = 16;
+
+        Uint32 width{0};
+
+        Uint32 depth{0};
+
+        /*!
+         * \brief Ecotype of each texel, in rows along the x axis
+         */
+        Rx::Vector<Ecotype> ecotypes;
+
+        Uint32 num_blocks_x{0};
+
+        Uint32 num_blocks_z{0};
+
+        /*!
+         * \brief Ecotypes in each `BLOCK_SIZE` by `BLOCK_SIZE` block of texels, in rows along the x axis
+         */
+        Rx::Vector<EcotypeMask> block_masks;
+
+        [[nodiscard]] bool is_empty() const;
+
+        /*!
+         * \brief Gets the ecotype of the texel nearest to a location, as a mask
+         *
+         * \param texel_location Location in texels, relative to the first texel
+         *
+         * \return The ecotype's mask, or `ALL_ECOTYPES` if the location is off the map
+         */
+        [[nodiscard]] EcotypeMask get_ecotype_at(const Vec2f& texel_location) const;
+
+        /*!
+         * \brief Gets all the ecotypes that the texels nearest to the locations in a rectangle might have
+         *
+         * The result comes from whole blocks, so it may have a few ecotypes from just outside the rectangle. Rectangles that reach off the
+         * map get `ALL_ECOTYPES`
+         *
+         * \param texel_min Corner of the rectangle with the smallest coordinates, in texels relative to the first texel
+         * \param texel_max Corner of the rectangle with the largest coordinates, in texels relative to the first texel
+         */
+        [[nodiscard]] EcotypeMask get_ecotypes_in_rect(const Vec2f& texel_min, const Vec2f& texel_max) const;
+    };
+
+    /*!
+     * \brief Decides the ecotype of every texel of the world's maps
+     *
+     * Water comes first: texels below the tidal zone are ocean, and texels with water on them are river or lake. Everything within
+     * `tidal_range` of sea level is tidal zone. The rest is land, which is forest where the soil is wet enough, grassland where the air is
+     * humid enough, and desert everywhere else. Slopes that are too steep for vegetation are desert no matter how wet they are
+     */
+    [[nodiscard]] EcotypeMap classify_ecotypes(const EcotypeFields& fields, const EcotypeSettings& settings);
+} // namespace environment
@@ -2,6 +2,7 @@
 
 #include "json5/json5.hpp"
 #include "rx/core/string.h"
+#include "world/environment/ecotypes.hpp"
 
 namespace environment {
     enum class FootprintClass { OneMeter, TwoMeters, FiveMeters, TenMeters };
@@ -23,12 +24,20 @@ namespace environment {
          */
         FootprintClass footprint_class{FootprintClass::TwoMeters};
 
+        /*!
+         * \brief The ecotypes that this object can spawn in
+         *
+         * The object's density pipeline only gets evaluated on tiles that have at least one of these ecotypes, and the object never
+         * spawns outside of them
+         */
+        EcotypeMask ecotypes{ALL_ECOTYPES};
+
         /*!
          * \brief The pipeline that generates this object's density map
          *
          * This will probably be stored in a much better way in the future, but we're not in the future
          */
-        json5::value density_map_generation_pipeline{};
+        json5::value density_map_generation_pipeline{nullptr};
 
         /*!
          * \brief Path to this object's mesh, relative to the data directory
@@ -0,0 +1,174 @@
+#include "environment_object_placer.hpp"
+
+#include <cstring>
+#include <thread>
+
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.System.Threading.h>
+
+#include "Tracy.hpp"
+#include "rx/core/log.h"
+
+using winrt::Windows::Foundation::IAsyncAction;
+using winrt::Windows::System::Threading::ThreadPool;
+
+RX_LOG("EnvironmentObjectPlacer", logger);
+
+namespace environment {
+    EnvironmentObjectPlacer::EnvironmentObjectPlacer(const ScatterSettings& settings_in, const TerrainFallbackHeightmap* world_maps_in)
+        : settings{settings_in}, world_maps{world_maps_in}, generator_version{get_scatter_generator_version(settings, {})} {}
+
+    EnvironmentObjectPlacer::~EnvironmentObjectPlacer() {
+        while(num_active_tasks.load() > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    void EnvironmentObjectPlacer::add_object(const EnvironmentObject& object, const Uint32 mesh_id) {
+        objects.push_back(make_scatter_object(object, mesh_id));
+        generator_version = get_scatter_generator_version(settings, {objects.data(), objects.size()});
+    }
+
+    void EnvironmentObjectPlacer::add_tile(const Vec2i& coord, const std::span<const Float32> heights, const Uint32 height_stride) {
+        if(objects.is_empty()) {
+            return;
+        }
+
+        const auto request_id = next_request_id++;
+        auto new_tile = PlacementTile{.request_id = request_id, .generator_version = generator_version};
+
+        if(auto* cached_tile = cached_tiles.find(coord)) {
+            if(cached_tile->generator_version == generator_version) {
+                new_tile.is_placed = true;
+                new_tile.instances = Rx::Utility::move(cached_tile->instances);
+                num_cache_hits++;
+            }
+
+            cached_tiles.erase(coord);
+        }
+
+        const auto is_cached = new_tile.is_placed;
+        const auto num_cached_instances = new_tile.instances.size();
+        if(auto* tile = tiles.find(coord)) {
+            num_instances -= tile->instances.size();
+            *tile = Rx::Utility::move(new_tile);
+        } else {
+            tiles.insert(coord, Rx::Utility::move(new_tile));
+        }
+
+        if(is_cached) {
+            logger->verbose("Reused %zu cached environment objects on tile (%d, %d)", num_cached_instances, coord.x, coord.y);
+            num_instances += num_cached_instances;
+            return;
+        }
+
+        // The task gets its own copies of everything, so it doesn't care what happens to the terrain or the placer's objects while it runs
+        Rx::Vector<Float32> tile_heights{heights.size()};
+        memcpy(tile_heights.data(), heights.data(), heights.size_bytes());
+        auto tile_objects = objects;
+
+        num_active_tasks.fetch_add(1);
+        ThreadPool::RunAsync([=, this](const IAsyncAction& /* work_item */) {
+            ZoneScopedN("EnvironmentObjectPlacer::place_tile");
+
+            auto instances = scatter_objects_in_tile(settings,
+                                                     {tile_objects.data(), tile_objects.size()},
+                                                     world_maps,
+                                                     coord,
+                                                     {tile_heights.data(), tile_heights.size()},
+                                                     height_stride);
+
+            placed_tiles.lock()->push_back(PlacedTile{.coord = coord, .request_id = request_id, .instances = Rx::Utility::move(instances)});
+            num_active_tasks.fetch_sub(1);
+        });
+    }
+
+    void EnvironmentObjectPlacer::remove_tile(const Vec2i& coord) {
+        auto* tile = tiles.find(coord);
+        if(tile == nullptr) {
+            return;
+        }
+
+        if(tile->is_placed) {
+            num_instances -= tile->instances.size();
+
+            if(cached_tiles.size() >= MAX_CACHED_TILES) {
+                evict_oldest_cached_tile();
+            }
+
+            cached_tiles.insert(coord,
+                                CachedTile{.generator_version = tile->generator_version,
+                                           .removal_index = num_removed_tiles,
+                                           .instances = Rx::Utility::move(tile->instances)});
+        }
+
+        num_removed_tiles++;
+        tiles.erase(coord);
+    }
+
+    void EnvironmentObjectPlacer::collect_placed_tiles() {
+        ZoneScoped;
+
+        Rx::Vector<PlacedTile> new_tiles;
+        {
+            auto locked_placed_tiles = placed_tiles.lock();
+            if(locked_placed_tiles->is_empty()) {
+                return;
+            }
+
+            new_tiles = Rx::Utility::move(*locked_placed_tiles);
+            locked_placed_tiles->clear();
+        }
+
+        new_tiles.each_fwd([&](PlacedTile& placed_tile) {
+            auto* tile = tiles.find(placed_tile.coord);
+            if(tile == nullptr || tile->request_id != placed_tile.request_id) {
+                return;
+            }
+
+            logger->verbose("Placed %zu environment objects on tile (%d, %d)",
+                            placed_tile.instances.size(),
+                            placed_tile.coord.x,
+                            placed_tile.coord.y);
+
+            num_instances += placed_tile.instances.size();
+            tile->instances = Rx::Utility::move(placed_tile.instances);
+            tile->is_placed = true;
+        });
+    }
+
+    const Rx::Vector<EnvironmentObjectInstance>* EnvironmentObjectPlacer::get_instances(const Vec2i& coord) const {
+        const auto* tile = tiles.find(coord);
+        return tile != nullptr && tile->is_placed ? &tile->instances : nullptr;
+    }
+
+    Size EnvironmentObjectPlacer::get_num_instances() const { return num_instances; }
+
+    Uint32 EnvironmentObjectPlacer::get_num_placing_tiles() const {
+        Uint32 num_placing_tiles = 0;
+        tiles.each_value([&](const PlacementTile& tile) {
+            if(!tile.is_placed) {
+                num_placing_tiles++;
+            }
+        });
+
+        return num_placing_tiles;
+    }
+
+    Uint32 EnvironmentObjectPlacer::get_num_cached_tiles() const { return static_cast<Uint32>(cached_tiles.size()); }
+
+    Uint64 EnvironmentObjectPlacer::get_num_cache_hits() const { return num_cache_hits; }
+
+    void EnvironmentObjectPlacer::evict_oldest_cached_tile() {
+        Vec2i oldest_coord{};
+        auto oldest_removal_index = num_removed_tiles;
+        cached_tiles.each_pair([&](const Vec2i& coord, const CachedTile& cached_tile) {
+            if(cached_tile.removal_index < oldest_removal_index) {
+                oldest_coord = coord;
+                oldest_removal_index = cached_tile.removal_index;
+            }
+        });
+
+        cached_tiles.erase(oldest_coord);
+    }
+} // namespace environment
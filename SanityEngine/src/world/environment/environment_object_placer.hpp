@@ -0,0 +1,174 @@
+#pragma once
+
+#include <span>
+
+#include "core/async/synchronized_resource.hpp"
+#include "core/types.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/map.h"
+#include "rx/core/vector.h"
+#include "world/environment/object_scattering.hpp"
+
+struct TerrainFallbackHeightmap;
+
+namespace environment {
+    /*!
+     * \brief Places environment objects on terrain tiles as they stream in
+     *
+     * Each tile gets placed by its own task on the thread pool, so placing objects never holds up a frame. Finished tiles wait in a queue
+     * until the main thread collects them. Tiles that get removed while their task is running are thrown away when the task finishes
+     *
+     * The objects on a tile only depend on the tile's coordinates, the settings, and the registered objects, so a tile that streams out and
+     * back in gets the same objects, and objects line up across tile edges. Objects that are added after a tile was placed only show up on
+     * tiles that are placed after that
+     *
+     * Tiles that get removed keep their objects in a cache, keyed by the tile's coordinates and the generator version that placed them.
+     * A tile that comes back before it falls out of the cache reuses its objects instead of placing them again, as long as the settings
+     * and the objects haven't changed since
+     *
+     * Everything but the tasks runs on the main thread
+     */
+    class EnvironmentObjectPlacer {
+    public:
+        /*!
+         * \brief Number of removed tiles whose objects are kept around. The tiles that were removed the longest ago leave the cache first
+         */
+        static constexpr Uint32 MAX_CACHED_TILES = 512;
+
+        /*!
+         * \param settings_in How to place the objects
+         * \param world_maps_in The maps that were generated with the world. Must outlive the placer. May be null
+         */
+        EnvironmentObjectPlacer(const ScatterSettings& settings_in, const TerrainFallbackHeightmap* world_maps_in);
+
+        EnvironmentObjectPlacer(const EnvironmentObjectPlacer& other) = delete;
+        EnvironmentObjectPlacer& operator=(const EnvironmentObjectPlacer& other) = delete;
+
+        EnvironmentObjectPlacer(EnvironmentObjectPlacer&& old) noexcept = delete;
+        EnvironmentObjectPlacer& operator=(EnvironmentObjectPlacer&& old) noexcept = delete;
+
+        /*!
+         * \brief Waits for the placement tasks that are still running
+         */
+        ~EnvironmentObjectPlacer();
+
+        /*!
+         * \brief Registers an object to place on the terrain
+         *
+         * \param object The object to place
+         * \param mesh_id ID of the object's mesh. Instances of the object have this mesh ID
+         */
+        void add_object(const EnvironmentObject& object, Uint32 mesh_id);
+
+        /*!
+         * \brief Starts placing objects on a tile, or reuses its cached objects
+         *
+         * \param coord Coordinates of the tile
+         * \param heights The tile's heights, in rows along the x axis. Must have at least `tile_size + 1` rows and columns. The heights get
+         * copied, so they don't need to stay around
+         * \param height_stride Number of heights in each row of `heights`
+         */
+        void add_tile(const Vec2i& coord, std::span<const Float32> heights, Uint32 height_stride);
+
+        /*!
+         * \brief Moves a tile's objects into the cache, or cancels its placement if it's still being placed
+         */
+        void remove_tile(const Vec2i& coord);
+
+        /*!
+         * \brief Picks up the tiles whose placement tasks have finished since the last call
+         */
+        void collect_placed_tiles();
+
+        /*!
+         * \brief Gets the objects on a tile, or nullptr if the tile hasn't been placed
+         */
+        [[nodiscard]] const Rx::Vector<EnvironmentObjectInstance>* get_instances(const Vec2i& coord) const;
+
+        /*!
+         * \brief Number of objects on all the placed tiles
+         */
+        [[nodiscard]] Size get_num_instances() const;
+
+        [[nodiscard]] Uint32 get_num_placing_tiles() const;
+
+        [[nodiscard]] Uint32 get_num_cached_tiles() const;
+
+        /*!
+         * \brief Number of tiles that reused cached objects instead of placing them
+         */
+        [[nodiscard]] Uint64 get_num_cache_hits() const;
+
+    private:
+        struct PlacementTile {
+            /*!
+             * \brief Identifies the task that's placing this tile, so that a task for a tile that was removed and added again can tell
+             * that it's stale
+             */
+            Uint64 request_id{0};
+
+            Uint64 generator_version{0};
+
+            bool is_placed{false};
+
+            Rx::Vector<EnvironmentObjectInstance> instances;
+        };
+
+        struct PlacedTile {
+            Vec2i coord;
+
+            Uint64 request_id;
+
+            Rx::Vector<EnvironmentObjectInstance> instances;
+        };
+
+        struct CachedTile {
+            Uint64 generator_version{0};
+
+            /*!
+             * \brief When the tile was removed, in tile removals since the placer was created
+             */
+            Uint64 removal_index{0};
+
+            Rx::Vector<EnvironmentObjectInstance> instances;
+        };
+
+        ScatterSettings settings;
+
+        const TerrainFallbackHeightmap* world_maps;
+
+        Rx::Vector<ScatterObject> objects;
+
+        /*!
+         * \brief Generator version of the current settings and objects
+         */
+        Uint64 generator_version;
+
+        Rx::Map<Vec2i, PlacementTile> tiles;
+
+        Rx::Map<Vec2i, CachedTile> cached_tiles;
+
+        Uint64 num_removed_tiles{0};
+
+        Uint64 num_cache_hits{0};
+
+        Uint64 next_request_id{1};
+
+        Size num_instances{0};
+
+        /*!
+         * \brief Number of placement tasks that haven't finished yet, including the stale ones
+         */
+        Rx::Concurrency::Atomic<Uint32> num_active_tasks{0};
+
+        /*!
+         * \brief Tiles whose tasks have finished, waiting for `collect_placed_tiles`
+         */
+        SynchronizedResource<Rx::Vector<PlacedTile>> placed_tiles;
+
+        /*!
+         * \brief Throws out the tile that was removed the longest ago
+         */
+        void evict_oldest_cached_tile();
+    };
+} // namespace environment
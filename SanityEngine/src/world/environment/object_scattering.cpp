@@ -0,0 +1,636 @@
+#include "object_scattering.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/clamp.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/log.h"
+#include "world/generation/world_random.hpp"
+#include "world/terrain_height_queries.hpp"
+
+RX_LOG("ObjectScattering", logger);
+
+namespace environment {
+    /*!
+     * \brief Number of candidate locations that each cell throws. More candidates fill the gaps between objects better
+     */
+    constexpr Uint32 CANDIDATES_PER_CELL = 2;
+
+    /*!
+     * \brief Number of rounds that candidates get to resolve their overlaps in. Each round lets the decisions spread another two
+     * footprints, so it also makes the tiles generate more of their neighbours' candidates
+     */
+    constexpr Uint32 NUM_RESOLVE_ROUNDS = 3;
+
+    constexpr Uint32 NO_OBJECT = 0xFFFFFFFF;
+
+    /*!
+     * \brief Part of every generator version, so that tiles which were cached by an older version of the algorithm don't get reused
+     */
+    constexpr Uint64 SCATTER_ALGORITHM_VERSION = 2;
+
+    static Uint64 mix_bits(Uint64 bits) {
+        bits ^= bits >> 30;
+        bits *= 0xBF58476D1CE4E5B9ull;
+        bits ^= bits >> 27;
+        bits *= 0x94D049BB133111EBull;
+        bits ^= bits >> 31;
+
+        return bits;
+    }
+
+    /*!
+     * \brief Number of random blocks that each candidate draws. A candidate needs seven random words, and each block has four
+     */
+    constexpr Uint32 BLOCKS_PER_CANDIDATE = 2;
+
+    /*!
+     * \brief Finds the points near a location without allocating anything per cell
+     *
+     * Points go into square cells, and cells go into a power-of-two number of buckets by their hash. Searches look at the 3x3 cells around
+     * a location, so the cells must be at least as wide as the search radius. Cells that share a bucket get searched together, so searches
+     * may visit the same point more than once and must check the distance to every point they visit
+     *
+     * The grid keeps its own copy of the points, sorted by bucket, so that searches read memory in order
+     */
+    class ScatterHashGrid {
+    public:
+        void build(const Rx::Vector<Vec2f>& points, const Float32 cell_size) {
+            inverse_cell_size = 1.0f / cell_size;
+
+            Uint32 num_buckets = 16;
+            while(num_buckets < points.size() * 2) {
+                num_buckets *= 2;
+            }
+            bucket_mask = num_buckets - 1;
+
+            bucket_starts.clear();
+            bucket_starts.resize(num_buckets + 1, 0);
+            point_buckets.resize(points.size());
+            for(Size i = 0; i < points.size(); i++) {
+                const auto bucket = get_bucket(get_cell(points[i].x), get_cell(points[i].y));
+                point_buckets[i] = bucket;
+                bucket_starts[bucket + 1]++;
+            }
+
+            for(Uint32 bucket = 0; bucket < num_buckets; bucket++) {
+                bucket_starts[bucket + 1] += bucket_starts[bucket];
+            }
+
+            bucket_cursors.resize(num_buckets);
+            for(Uint32 bucket = 0; bucket < num_buckets; bucket++) {
+                bucket_cursors[bucket] = bucket_starts[bucket];
+            }
+
+            point_indices.resize(points.size());
+            sorted_points.resize(points.size());
+            for(Size i = 0; i < points.size(); i++) {
+                const auto sorted_index = bucket_cursors[point_buckets[i]]++;
+                point_indices[sorted_index] = static_cast<Uint32>(i);
+                sorted_points[sorted_index] = points[i];
+            }
+        }
+
+        /*!
+         * \brief Calls a function with the index and location of each point in the 3x3 cells around a location, until the function returns
+         * false
+         */
+        template <typename FuncType>
+        void for_each_point_near(const Vec2f& location, FuncType&& func) const {
+            if(point_indices.is_empty()) {
+                return;
+            }
+
+            const auto cell_x = get_cell(location.x);
+            const auto cell_z = get_cell(location.y);
+            for(Int32 z = cell_z - 1; z <= cell_z + 1; z++) {
+                for(Int32 x = cell_x - 1; x <= cell_x + 1; x++) {
+                    const auto bucket = get_bucket(x, z);
+                    for(Uint32 i = bucket_starts[bucket]; i < bucket_starts[bucket + 1]; i++) {
+                        if(!func(point_indices[i], sorted_points[i])) {
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        Float32 inverse_cell_size{1};
+
+        Uint32 bucket_mask{0};
+
+        Rx::Vector<Uint32> bucket_starts;
+
+        Rx::Vector<Uint32> bucket_cursors;
+
+        Rx::Vector<Uint32> point_buckets;
+
+        Rx::Vector<Uint32> point_indices;
+
+        Rx::Vector<Vec2f> sorted_points;
+
+        [[nodiscard]] Int32 get_cell(const Float32 coordinate) const {
+            return static_cast<Int32>(std::floor(coordinate * inverse_cell_size));
+        }
+
+        [[nodiscard]] Uint32 get_bucket(const Int32 cell_x, const Int32 cell_z) const {
+            const auto hash = static_cast<Uint32>(cell_x) * 73856093u ^ static_cast<Uint32>(cell_z) * 19349663u;
+            return (hash ^ hash >> 16) & bucket_mask;
+        }
+    };
+
+    /*!
+     * \brief The candidates that one footprint class throws, stored as separate arrays so that the density evaluation can read the
+     * locations in one batch
+     */
+    struct ScatterCandidates {
+        Rx::Vector<Vec2f> locations;
+
+        Rx::Vector<Uint64> priorities;
+
+        /*!
+         * \brief Random numbers in [0, 1) that pick which object each candidate spawns
+         */
+        Rx::Vector<Float32> object_choices;
+
+        Rx::Vector<Float32> yaws;
+
+        Rx::Vector<Float32> scales;
+
+        /*!
+         * \brief Index of the object that each candidate spawns, or NO_OBJECT
+         */
+        Rx::Vector<Uint32> objects;
+
+        void clear() {
+            locations.clear();
+            priorities.clear();
+            object_choices.clear();
+            yaws.clear();
+            scales.clear();
+            objects.clear();
+        }
+    };
+
+    /*!
+     * \brief A world-space rectangle, with the minimum inclusive and the maximum exclusive
+     */
+    struct ScatterRect {
+        Vec2f min;
+
+        Vec2f max;
+
+        [[nodiscard]] bool contains(const Vec2f& location) const {
+            return location.x >= min.x && location.y >= min.y && location.x < max.x && location.y < max.y;
+        }
+    };
+
+    static Int32 floor_divide(const Int32 numerator, const Int32 denominator) {
+        const auto quotient = numerator / denominator;
+        return (numerator % denominator != 0 && (numerator < 0) != (denominator < 0)) ? quotient - 1 : quotient;
+    }
+
+    /*!
+     * \brief Throws the candidates for one footprint class in every cell that overlaps a rectangle
+     *
+     * Cells are laid out per tile, so that a tile's cells and their random numbers don't depend on which tile is asking for them
+     */
+    static void throw_candidates(const ScatterSettings& settings,
+                                 const Uint32 class_index,
+                                 const ScatterRect& rect,
+                                 ScatterCandidates& candidates) {
+        const auto diameter = get_footprint_diameter(static_cast<FootprintClass>(class_index));
+        const auto tile_size = static_cast<Int32>(settings.tile_size);
+
+        // Cells whose diagonal is the footprint diameter can hold at most one object
+        const auto cells_per_tile = static_cast<Int32>(std::ceil(static_cast<Float32>(tile_size) * std::sqrt(2.0f) / diameter));
+        const auto cell_size = static_cast<Float32>(tile_size) / static_cast<Float32>(cells_per_tile);
+
+        const auto min_cell_x = static_cast<Int32>(std::floor(rect.min.x / cell_size));
+        const auto min_cell_z = static_cast<Int32>(std::floor(rect.min.y / cell_size));
+        const auto max_cell_x = static_cast<Int32>(std::ceil(rect.max.x / cell_size));
+        const auto max_cell_z = static_cast<Int32>(std::ceil(rect.max.y / cell_size));
+
+        const auto random = terraingen::WorldRandom{settings.seed, terraingen::WorldGenStage::ObjectScattering, class_index};
+        terraingen::RandomBlock cell_random[CANDIDATES_PER_CELL * BLOCKS_PER_CANDIDATE];
+
+        candidates.clear();
+        for(Int32 cell_z = min_cell_z; cell_z < max_cell_z; cell_z++) {
+            const auto tile_z = floor_divide(cell_z, cells_per_tile);
+            const auto local_z = cell_z - tile_z * cells_per_tile;
+
+            for(Int32 cell_x = min_cell_x; cell_x < max_cell_x; cell_x++) {
+                const auto tile_x = floor_divide(cell_x, cells_per_tile);
+                const auto local_x = cell_x - tile_x * cells_per_tile;
+
+                const auto cell_index = static_cast<Uint64>(local_z * cells_per_tile + local_x);
+                random.fill_blocks({tile_x, tile_z}, cell_index * CANDIDATES_PER_CELL * BLOCKS_PER_CANDIDATE, cell_random);
+
+                for(Uint32 i = 0; i < CANDIDATES_PER_CELL; i++) {
+                    const auto* words = cell_random[i * BLOCKS_PER_CANDIDATE].words;
+                    const auto* more_words = cell_random[i * BLOCKS_PER_CANDIDATE + 1].words;
+
+                    const auto location = Vec2f{(static_cast<Float32>(cell_x) + terraingen::WorldRandom::to_float(words[0])) * cell_size,
+                                                (static_cast<Float32>(cell_z) + terraingen::WorldRandom::to_float(words[1])) * cell_size};
+                    if(!rect.contains(location)) {
+                        continue;
+                    }
+
+                    candidates.locations.push_back(location);
+                    candidates.priorities.push_back(terraingen::WorldRandom::to_uint64(words[2], words[3]));
+                    candidates.object_choices.push_back(terraingen::WorldRandom::to_float(more_words[0]));
+                    candidates.yaws.push_back(terraingen::WorldRandom::to_float(more_words[1]));
+                    candidates.scales.push_back(terraingen::WorldRandom::to_float(more_words[2]));
+                    candidates.objects.push_back(NO_OBJECT);
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Evaluates an object's density at a batch of locations
+     *
+     * \param window_ecotypes Every ecotype that the locations might be in
+     */
+    static void evaluate_densities(const ScatterObject& object,
+                                   const TerrainFallbackHeightmap* world_maps,
+                                   const EcotypeMask window_ecotypes,
+                                   const Rx::Vector<Vec2f>& locations,
+                                   Float32* densities,
+                                   DensityScratch& density_scratch) {
+        if(object.density_program.is_empty()) {
+            for(Size i = 0; i < locations.size(); i++) {
+                densities[i] = object.density;
+            }
+
+        } else {
+            object.density_program.evaluate(world_maps, {locations.data(), locations.size()}, densities, density_scratch);
+            if(object.density != 1.0f) {
+                for(Size i = 0; i < locations.size(); i++) {
+                    densities[i] *= object.density;
+                }
+            }
+        }
+
+        if(world_maps == nullptr) {
+            return;
+        }
+
+        // Only look up each location's ecotype if some of the ecotypes around here don't suit the object
+        if((window_ecotypes & ~object.ecotypes) != 0) {
+            for(Size i = 0; i < locations.size(); i++) {
+                if((world_maps->ecotypes.get_ecotype_at(locations[i] - world_maps->origin) & object.ecotypes) == 0) {
+                    densities[i] = 0;
+                }
+            }
+        }
+
+        if(world_maps->water_depths.is_empty()) {
+            return;
+        }
+
+        const auto width = static_cast<Int32>(world_maps->width);
+        const auto depth = static_cast<Int32>(world_maps->depth);
+        for(Size i = 0; i < locations.size(); i++) {
+            const auto x = static_cast<Int32>(std::floor(locations[i].x - world_maps->origin.x + 0.5f));
+            const auto z = static_cast<Int32>(std::floor(locations[i].y - world_maps->origin.y + 0.5f));
+            if(x >= 0 && z >= 0 && x < width && z < depth && world_maps->water_depths[z * width + x] > 0) {
+                densities[i] = 0;
+            }
+        }
+    }
+
+    /*!
+     * \brief Decides whether candidate `a` wins an overlap against candidate `b`
+     *
+     * Ties are broken by location rather than by index, since the same candidate has different indices in different tiles
+     */
+    static bool beats(const ScatterCandidates& candidates, const Uint32 a, const Uint32 b) {
+        if(candidates.priorities[a] != candidates.priorities[b]) {
+            return candidates.priorities[a] > candidates.priorities[b];
+        }
+
+        const auto& location_a = candidates.locations[a];
+        const auto& location_b = candidates.locations[b];
+        return location_a.x != location_b.x ? location_a.x > location_b.x : location_a.y > location_b.y;
+    }
+
+    static Float32 sample_tile_height(const std::span<const Float32> heights,
+                                      const Uint32 height_stride,
+                                      const Uint32 tile_size,
+                                      const Vec2f& local_location) {
+        const auto max_texel = static_cast<Float32>(tile_size - 1);
+        const auto x = Rx::Algorithm::clamp(local_location.x, 0.0f, static_cast<Float32>(tile_size));
+        const auto z = Rx::Algorithm::clamp(local_location.y, 0.0f, static_cast<Float32>(tile_size));
+        const auto texel_x = Rx::Algorithm::min(std::floor(x), max_texel);
+        const auto texel_z = Rx::Algorithm::min(std::floor(z), max_texel);
+        const auto fraction_x = x - texel_x;
+        const auto fraction_z = z - texel_z;
+
+        const auto* row = &heights[static_cast<Size>(texel_z) * height_stride + static_cast<Size>(texel_x)];
+        const auto top = row[0] + (row[1] - row[0]) * fraction_x;
+        const auto bottom = row[height_stride] + (row[height_stride + 1] - row[height_stride]) * fraction_x;
+
+        return top + (bottom - top) * fraction_z;
+    }
+
+    Float32 get_footprint_diameter(const FootprintClass footprint_class) {
+        switch(footprint_class) {
+            case FootprintClass::OneMeter:
+                return 1;
+
+            case FootprintClass::TwoMeters:
+                return 2;
+
+            case FootprintClass::FiveMeters:
+                return 5;
+
+            case FootprintClass::TenMeters:
+                return 10;
+        }
+
+        return 1;
+    }
+
+    ScatterObject make_scatter_object(const EnvironmentObject& object, const Uint32 mesh_id) {
+        auto scatter_object = ScatterObject{.footprint_class = object.footprint_class, .ecotypes = object.ecotypes, .mesh_id = mesh_id};
+        if(object.density_map_generation_pipeline.is_null()) {
+            return scatter_object;
+        }
+
+        auto program = DensityProgram::compile(object.density_map_generation_pipeline);
+        if(!program) {
+            logger->error("Density pipeline of environment object %s is not valid, so the object won't spawn", object.mesh_file_path);
+            scatter_object.density = 0;
+
+        } else if(const auto constant_density = program->get_constant_density()) {
+            scatter_object.density = *constant_density;
+
+        } else {
+            scatter_object.density_program = Rx::Utility::move(*program);
+        }
+
+        return scatter_object;
+    }
+
+    Uint64 get_scatter_generator_version(const ScatterSettings& settings, const std::span<const ScatterObject> objects) {
+        Uint64 version = mix_bits(SCATTER_ALGORITHM_VERSION);
+        const auto add_bits = [&](const Uint64 bits) { version = mix_bits(version ^ bits); };
+        const auto add_float = [&](const Float32 value) {
+            Uint32 bits;
+            memcpy(&bits, &value, sizeof(bits));
+            add_bits(bits);
+        };
+
+        add_bits(settings.seed);
+        add_bits(settings.tile_size);
+        add_float(settings.min_scale);
+        add_float(settings.max_scale);
+
+        for(const auto& object : objects) {
+            add_bits(static_cast<Uint64>(object.footprint_class));
+            add_float(object.density);
+            add_bits(object.ecotypes);
+            add_bits(object.mesh_id);
+            add_bits(object.density_program.hash());
+        }
+
+        return version;
+    }
+
+    Rx::Vector<EnvironmentObjectInstance> scatter_objects_in_tile(const ScatterSettings& settings,
+                                                                  const std::span<const ScatterObject> objects,
+                                                                  const TerrainFallbackHeightmap* world_maps,
+                                                                  const Vec2i& tile_coord,
+                                                                  const std::span<const Float32> heights,
+                                                                  const Uint32 height_stride) {
+        ZoneScoped;
+
+        Rx::Vector<EnvironmentObjectInstance> instances;
+
+        bool has_class[NUM_FOOTPRINT_CLASSES]{};
+        for(const auto& object : objects) {
+            has_class[static_cast<Uint32>(object.footprint_class)] = true;
+        }
+
+        // How far outside the tile each class's decisions must be right, and how far out it must throw candidates to get them right. A
+        // class's decisions depend on the candidates within `2 * NUM_RESOLVE_ROUNDS - 1` footprints, and on the bigger classes' objects
+        // that its candidates might touch
+        Float32 decided_margins[NUM_FOOTPRINT_CLASSES]{};
+        Float32 candidate_margins[NUM_FOOTPRINT_CLASSES]{};
+        for(Uint32 class_index = 0; class_index < NUM_FOOTPRINT_CLASSES; class_index++) {
+            if(!has_class[class_index]) {
+                continue;
+            }
+
+            const auto diameter = get_footprint_diameter(static_cast<FootprintClass>(class_index));
+            candidate_margins[class_index] = decided_margins[class_index] + static_cast<Float32>(2 * NUM_RESOLVE_ROUNDS - 1) * diameter;
+
+            for(Uint32 bigger_class = class_index + 1; bigger_class < NUM_FOOTPRINT_CLASSES; bigger_class++) {
+                const auto bigger_diameter = get_footprint_diameter(static_cast<FootprintClass>(bigger_class));
+                decided_margins[bigger_class] = Rx::Algorithm::max(decided_margins[bigger_class],
+                                                                   candidate_margins[class_index] + (diameter + bigger_diameter) * 0.5f);
+            }
+        }
+
+        const auto tile_size = static_cast<Float32>(settings.tile_size);
+        const auto tile_rect = ScatterRect{.min = {static_cast<Float32>(tile_coord.x) * tile_size,
+                                                   static_cast<Float32>(tile_coord.y) * tile_size},
+                                           .max = {static_cast<Float32>(tile_coord.x + 1) * tile_size,
+                                                   static_cast<Float32>(tile_coord.y + 1) * tile_size}};
+
+        ScatterCandidates candidates;
+        DensityScratch density_scratch;
+        Rx::Vector<Float32> densities;
+        Rx::Vector<Float32> total_densities;
+        Rx::Vector<Uint32> class_objects;
+        Rx::Vector<Uint32> survivors;
+        Rx::Vector<Vec2f> survivor_locations;
+        Rx::Vector<Uint32> overlap_starts;
+        Rx::Vector<Uint32> overlaps;
+        Rx::Vector<Uint8> survivor_states;
+        Rx::Vector<Uint32> winners;
+        ScatterHashGrid survivor_grid;
+
+        Rx::Vector<Vec2f> placed_locations[NUM_FOOTPRINT_CLASSES];
+        ScatterHashGrid placed_grids[NUM_FOOTPRINT_CLASSES];
+
+        enum SurvivorState : Uint8 { Undecided, Placed, Dropped };
+
+        for(Int32 class_index = NUM_FOOTPRINT_CLASSES - 1; class_index >= 0; class_index--) {
+            if(!has_class[class_index]) {
+                continue;
+            }
+
+            const auto footprint_class = static_cast<FootprintClass>(class_index);
+            const auto diameter = get_footprint_diameter(footprint_class);
+            const auto margin = candidate_margins[class_index];
+            const auto window = ScatterRect{.min = {tile_rect.min.x - margin, tile_rect.min.y - margin},
+                                            .max = {tile_rect.max.x + margin, tile_rect.max.y + margin}};
+
+            // Only the objects that are registered for the ecotypes around here get evaluated. The others would have a density of 0 at
+            // every candidate, so leaving them out doesn't change any decisions
+            auto window_ecotypes = ALL_ECOTYPES;
+            if(world_maps != nullptr) {
+                window_ecotypes = world_maps->ecotypes.get_ecotypes_in_rect(window.min - world_maps->origin,
+                                                                             window.max - world_maps->origin);
+            }
+
+            class_objects.clear();
+            for(Size object_index = 0; object_index < objects.size(); object_index++) {
+                const auto& object = objects[object_index];
+                if(object.footprint_class == footprint_class && (object.ecotypes & window_ecotypes) != 0) {
+                    class_objects.push_back(static_cast<Uint32>(object_index));
+                }
+            }
+
+            if(class_objects.is_empty()) {
+                continue;
+            }
+
+            throw_candidates(settings, static_cast<Uint32>(class_index), window, candidates);
+            const auto num_candidates = candidates.locations.size();
+
+            // Pick an object for each candidate. When the densities add up to more than 1, they share the candidates in proportion
+
+            densities.resize(class_objects.size() * num_candidates);
+            total_densities.clear();
+            total_densities.resize(num_candidates, 0.0f);
+            for(Size i = 0; i < class_objects.size(); i++) {
+                auto* object_densities = densities.data() + i * num_candidates;
+                evaluate_densities(objects[class_objects[i]],
+                                   world_maps,
+                                   window_ecotypes,
+                                   candidates.locations,
+                                   object_densities,
+                                   density_scratch);
+                for(Size candidate = 0; candidate < num_candidates; candidate++) {
+                    total_densities[candidate] += object_densities[candidate];
+                }
+            }
+
+            for(Size candidate = 0; candidate < num_candidates; candidate++) {
+                auto choice = candidates.object_choices[candidate] * Rx::Algorithm::max(total_densities[candidate], 1.0f);
+                for(Size i = 0; i < class_objects.size(); i++) {
+                    const auto density = densities[i * num_candidates + candidate];
+                    if(choice < density) {
+                        candidates.objects[candidate] = class_objects[i];
+                        break;
+                    }
+                    choice -= density;
+                }
+            }
+
+            // Keep clear of the bigger classes' objects
+            survivors.clear();
+            survivor_locations.clear();
+            for(Uint32 i = 0; i < num_candidates; i++) {
+                if(candidates.objects[i] == NO_OBJECT) {
+                    continue;
+                }
+
+                const auto& location = candidates.locations[i];
+                bool is_blocked = false;
+                for(Int32 bigger_class = class_index + 1; bigger_class < static_cast<Int32>(NUM_FOOTPRINT_CLASSES) && !is_blocked;
+                    bigger_class++) {
+                    const auto min_distance = (diameter + get_footprint_diameter(static_cast<FootprintClass>(bigger_class))) * 0.5f;
+                    placed_grids[bigger_class].for_each_point_near(location, [&](const Uint32 /* placed */, const Vec2f& placed_location) {
+                        const auto offset = placed_location - location;
+                        is_blocked = offset.x * offset.x + offset.y * offset.y < min_distance * min_distance;
+                        return !is_blocked;
+                    });
+                }
+
+                if(!is_blocked) {
+                    survivors.push_back(i);
+                    survivor_locations.push_back(location);
+                }
+            }
+
+            // Resolve the overlaps between the survivors. Finding each survivor's overlaps once up front is much cheaper than searching
+            // the grid again in every round
+            survivor_grid.build(survivor_locations, diameter);
+
+            const auto min_distance_squared = diameter * diameter;
+            overlap_starts.clear();
+            overlap_starts.push_back(0);
+            overlaps.clear();
+            for(Uint32 i = 0; i < survivors.size(); i++) {
+                const auto& location = survivor_locations[i];
+                survivor_grid.for_each_point_near(location, [&](const Uint32 other, const Vec2f& other_location) {
+                    const auto offset = other_location - location;
+                    if(other != i && offset.x * offset.x + offset.y * offset.y < min_distance_squared) {
+                        overlaps.push_back(other);
+                    }
+                    return true;
+                });
+                overlap_starts.push_back(static_cast<Uint32>(overlaps.size()));
+            }
+
+            survivor_states.clear();
+            survivor_states.resize(survivors.size(), Undecided);
+            for(Uint32 round = 0; round < NUM_RESOLVE_ROUNDS; round++) {
+                winners.clear();
+                for(Uint32 i = 0; i < survivors.size(); i++) {
+                    if(survivor_states[i] != Undecided) {
+                        continue;
+                    }
+
+                    bool is_winner = true;
+                    for(Uint32 overlap = overlap_starts[i]; overlap < overlap_starts[i + 1] && is_winner; overlap++) {
+                        const auto other = overlaps[overlap];
+                        is_winner = survivor_states[other] != Undecided || beats(candidates, survivors[i], survivors[other]);
+                    }
+
+                    if(is_winner) {
+                        winners.push_back(i);
+                    }
+                }
+
+                if(winners.is_empty()) {
+                    break;
+                }
+
+                winners.each_fwd([&](const Uint32 winner) {
+                    survivor_states[winner] = Placed;
+                    for(Uint32 overlap = overlap_starts[winner]; overlap < overlap_starts[winner + 1]; overlap++) {
+                        survivor_states[overlaps[overlap]] = Dropped;
+                    }
+                });
+            }
+
+            auto& class_locations = placed_locations[class_index];
+            const auto scale_range = settings.max_scale - settings.min_scale;
+            for(Uint32 i = 0; i < survivors.size(); i++) {
+                if(survivor_states[i] != Placed) {
+                    continue;
+                }
+
+                const auto& location = survivor_locations[i];
+                class_locations.push_back(location);
+
+                if(!tile_rect.contains(location)) {
+                    continue;
+                }
+
+                const auto candidate = survivors[i];
+                const auto height = sample_tile_height(heights, height_stride, settings.tile_size, location - tile_rect.min);
+                const auto scale = settings.min_scale + candidates.scales[candidate] * scale_range;
+
+                instances.push_back(EnvironmentObjectInstance{
+                    .location = {location.x, height, location.y},
+                    .yaw = static_cast<Uint16>(candidates.yaws[candidate] * EnvironmentObjectInstance::YAW_UNITS_PER_TURN),
+                    .scale = static_cast<Uint16>(Rx::Algorithm::clamp(scale * EnvironmentObjectInstance::SCALE_UNITS, 0.0f, 65535.0f)),
+                    .mesh_id = objects[candidates.objects[candidate]].mesh_id});
+            }
+
+            placed_grids[class_index].build(class_locations, diameter);
+        }
+
+        return instances;
+    }
+} // namespace environment
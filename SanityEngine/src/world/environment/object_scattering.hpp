@@ -0,0 +1,143 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+#include "world/environment/density_pipeline.hpp"
+#include "world/environment/environment_object.hpp"
+
+struct TerrainFallbackHeightmap;
+
+namespace environment {
+    constexpr Uint32 NUM_FOOTPRINT_CLASSES = 4;
+
+    /*!
+     * \brief Diameter of a footprint class, in meters. Objects in a class are placed at least this far apart
+     */
+    [[nodiscard]] Float32 get_footprint_diameter(FootprintClass footprint_class);
+
+    /*!
+     * \brief One placed environment object, packed small enough that millions of them fit in memory
+     */
+    struct EnvironmentObjectInstance {
+        static constexpr Float32 YAW_UNITS_PER_TURN = 65536.0f;
+
+        static constexpr Float32 SCALE_UNITS = 4096.0f;
+
+        /*!
+         * \brief World-space location of the bottom of the object
+         */
+        Vec3f location;
+
+        /*!
+         * \brief Rotation around the y axis, in `1 / YAW_UNITS_PER_TURN`ths of a turn
+         */
+        Uint16 yaw;
+
+        /*!
+         * \brief Uniform scale, in `1 / SCALE_UNITS`ths
+         */
+        Uint16 scale;
+
+        /*!
+         * \brief The mesh ID that the object was registered with
+         */
+        Uint32 mesh_id;
+    };
+
+    static_assert(sizeof(EnvironmentObjectInstance) == 20, "Environment object instances should stay small");
+
+    /*!
+     * \brief An environment object, ready to be scattered
+     */
+    struct ScatterObject {
+        FootprintClass footprint_class{FootprintClass::TwoMeters};
+
+        /*!
+         * \brief Chance that a free spot in this object's footprint class spawns this object, from 0 to 1. Multiplies the density
+         * program's output when there is one
+         */
+        Float32 density{1};
+
+        /*!
+         * \brief Ecotypes that the object can spawn in
+         */
+        EcotypeMask ecotypes{ALL_ECOTYPES};
+
+        Uint32 mesh_id{0};
+
+        /*!
+         * \brief Compiled density pipeline. Empty if the object has the same density everywhere
+         */
+        DensityProgram density_program;
+    };
+
+    /*!
+     * \brief Gets an environment object ready to scatter, compiling its density pipeline
+     *
+     * Density pipelines that always come out to the same number give the object that density everywhere. Objects without a density
+     * pipeline spawn everywhere that their footprint fits, and objects whose pipeline doesn't compile don't spawn at all
+     */
+    [[nodiscard]] ScatterObject make_scatter_object(const EnvironmentObject& object, Uint32 mesh_id);
+
+    struct ScatterSettings {
+        /*!
+         * \brief Seed for all the random choices. Together with the tile coordinates, this decides everything about a tile's objects
+         */
+        Uint64 seed{0};
+
+        /*!
+         * \brief Width of a terrain tile, in meters
+         */
+        Uint32 tile_size{64};
+
+        Float32 min_scale{0.8f};
+
+        Float32 max_scale{1.2f};
+    };
+
+    /*!
+     * \brief Identifies everything that decides the objects on a tile, besides the tile's coordinates and the world's maps
+     *
+     * Tiles that were placed with the same generator version and world maps always get the same objects, so their objects can be cached
+     * and reused. Changes to the scattering algorithm must bump `SCATTER_ALGORITHM_VERSION` in object_scattering.cpp
+     */
+    [[nodiscard]] Uint64 get_scatter_generator_version(const ScatterSettings& settings, std::span<const ScatterObject> objects);
+
+    /*!
+     * \brief Places environment objects on one terrain tile
+     *
+     * Each footprint class gets its own Poisson-disk pattern, and the classes are placed from the biggest footprint to the smallest.
+     * Objects keep clear of the objects in the bigger classes, so rocks don't end up inside trees. Placing a class goes like this:
+     *
+     * 1. The tile is split into a grid of cells that are small enough to hold only one object of the class. Each cell throws a few
+     * candidate locations, with counter-based random numbers that are keyed by the seed, the class, the tile coordinates, and the cell
+     * 2. Each candidate picks one of the class's objects, or nothing, based on the objects' densities at the candidate's location. Only the
+     * objects that are registered for the ecotypes around the tile get their densities evaluated, so the cost grows with the number of
+     * objects that might spawn on the tile rather than with the number of objects in the world
+     * 3. Candidates that are too close to an object from a bigger class are dropped
+     * 4. The candidates that are left resolve their overlaps over a few rounds. In each round, every candidate whose random priority beats
+     * all the candidates that it overlaps gets placed, and the candidates that it overlaps get dropped. Candidates find the candidates they
+     * overlap through a spatial hash grid
+     *
+     * Every step only depends on the candidates within a few footprints of each other, so the tile also generates the candidates of its
+     * neighbours near its edges, and comes to the same decisions about them as the neighbours do. That means that objects line up across
+     * tile edges no matter which tiles are loaded, or what order they were placed in
+     *
+     * Safe to call from any number of threads at once
+     *
+     * \param settings How to place the objects. Must be the same for every tile
+     * \param objects The objects to place. Must be the same for every tile
+     * \param world_maps The maps that were generated with the world. Objects don't spawn in the water on these maps. May be null
+     * \param tile_coord Coordinates of the tile to place objects on
+     * \param heights The tile's heights, in rows along the x axis. Must have at least `tile_size + 1` rows and columns
+     * \param height_stride Number of heights in each row of `heights`
+     */
+    [[nodiscard]] Rx::Vector<EnvironmentObjectInstance> scatter_objects_in_tile(const ScatterSettings& settings,
+                                                                              std::span<const ScatterObject> objects,
+                                                                              const TerrainFallbackHeightmap* world_maps,
+                                                                              const Vec2i& tile_coord,
+                                                                              std::span<const Float32> heights,
+                                                                              Uint32 height_stride);
+} // namespace environment
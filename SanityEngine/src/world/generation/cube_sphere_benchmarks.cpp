@@ -0,0 +1,259 @@
+#include "cube_sphere_benchmarks.hpp"
+
+#include <cmath>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/log.h"
+#include "rx/core/time/stop_watch.h"
+#include "world/heightmap_tile_pool.hpp"
+
+namespace terraingen {
+    RX_LOG("CubeSphereBenchmarks", logger);
+
+    /*!
+     * \brief Deepest depth that the benchmark measures the tile area ratio at. Every depth past this has about the same ratio
+     */
+    constexpr Uint32 MAX_AREA_RATIO_DEPTH = 8;
+
+    /*!
+     * \brief Depth that the benchmark checks every tile's neighbours at
+     */
+    constexpr Uint32 NEIGHBOUR_CHECK_DEPTH = 3;
+
+    /*!
+     * \brief Largest difference between a latitude and longitude and itself after a round trip through a cube face point, in degrees
+     */
+    constexpr Float64 MAX_LAT_LONG_ERROR = 1e-9;
+
+    /*!
+     * \brief Largest difference across a seam, as a fraction of the difference between the lowest and highest heights
+     *
+     * Neighbouring tiles' texels don't line up across face edges, so seams always differ by a little bilinear filtering error
+     */
+    constexpr Float32 MAX_SEAM_DIFFERENCE = 0.0001f;
+
+    constexpr CubeSphereTileEdge TILE_EDGES[] = {CubeSphereTileEdge::MinU,
+                                                 CubeSphereTileEdge::MaxU,
+                                                 CubeSphereTileEdge::MinV,
+                                                 CubeSphereTileEdge::MaxV};
+
+    static Float64 get_max_lat_long_error() {
+        auto max_error = 0.0;
+        for(auto latitude = -89.0; latitude <= 89.0; latitude += 0.5) {
+            for(auto longitude = -179.75; longitude < 180.0; longitude += 0.5) {
+                const auto lat_long = LatLong{.latitude = latitude, .longitude = longitude};
+                const auto round_trip = get_lat_long_from_cube_face_point(get_cube_face_point_from_lat_long(lat_long));
+
+                max_error = Rx::Algorithm::max(max_error, std::abs(round_trip.latitude - latitude));
+                max_error = Rx::Algorithm::max(max_error, std::abs(round_trip.longitude - longitude));
+            }
+        }
+
+        return max_error;
+    }
+
+    static Uint32 count_neighbour_mismatches() {
+        const auto num_tiles_per_edge = 1u << NEIGHBOUR_CHECK_DEPTH;
+
+        Uint32 num_mismatches = 0;
+        for(Uint32 face = 0; face < NUM_CUBE_FACES; face++) {
+            for(Uint32 y = 0; y < num_tiles_per_edge; y++) {
+                for(Uint32 x = 0; x < num_tiles_per_edge; x++) {
+                    const auto tile = CubeSphereTileKey{.face = static_cast<CubeFace>(face),
+                                                        .depth = NEIGHBOUR_CHECK_DEPTH,
+                                                        .coord = {x, y}};
+                    for(const auto edge : TILE_EDGES) {
+                        const auto neighbour = get_cube_sphere_tile_neighbour(tile, edge);
+
+                        // We don't know which of the neighbour's edges leads back here, but exactly one of them should
+                        Uint32 num_ways_back = 0;
+                        for(const auto neighbour_edge : TILE_EDGES) {
+                            if(get_cube_sphere_tile_neighbour(neighbour, neighbour_edge) == tile) {
+                                num_ways_back++;
+                            }
+                        }
+
+                        if(num_ways_back != 1) {
+                            num_mismatches++;
+                        }
+                    }
+                }
+            }
+        }
+
+        return num_mismatches;
+    }
+
+    /*!
+     * \brief Largest difference between the heights along one of a tile's edges and the heights of its neighbour at the same directions
+     */
+    static Float32 get_seam_difference(const CubeSphereTileKey& tile,
+                                       const TileHeightmap& heightmap,
+                                       const CubeSphereTileEdge edge,
+                                       const CubeSphereTileKey& neighbour,
+                                       const TileHeightmap& neighbour_heightmap) {
+        const auto max_texel = heightmap.size - 1;
+        const auto min_uv = tile.get_min_uv();
+        const auto uv_per_texel = tile.get_uv_size() / static_cast<Float64>(max_texel);
+
+        auto max_difference = 0.0f;
+        for(Uint32 i = 0; i <= max_texel; i++) {
+            auto texel = Vec2u{i, i};
+            switch(edge) {
+                case CubeSphereTileEdge::MinU:
+                    texel.x = 0;
+                    break;
+
+                case CubeSphereTileEdge::MaxU:
+                    texel.x = max_texel;
+                    break;
+
+                case CubeSphereTileEdge::MinV:
+                    texel.y = 0;
+                    break;
+
+                case CubeSphereTileEdge::MaxV:
+                    texel.y = max_texel;
+                    break;
+            }
+
+            const auto direction = get_cube_sphere_direction(
+                {.face = tile.face, .uv = {min_uv.x + texel.x * uv_per_texel, min_uv.y + texel.y * uv_per_texel}});
+            const auto neighbour_height = sample_cube_sphere_heightmap(neighbour_heightmap, neighbour, direction);
+
+            max_difference = Rx::Algorithm::max(max_difference, std::abs(heightmap.at(texel.x, texel.y) - neighbour_height));
+        }
+
+        return max_difference;
+    }
+
+    CubeSphereBenchmarkResults benchmark_cube_sphere_tiles(const NoiseConfig& config,
+                                                           const Float64 radius,
+                                                           const Uint32 depth,
+                                                           const Uint32 heightmap_size,
+                                                           const Uint32 num_tiles,
+                                                           const Float32 min_height,
+                                                           const Float32 max_height) {
+        ZoneScoped;
+
+        CubeSphereBenchmarkResults results;
+        results.tile_area_ratio = get_cube_sphere_tile_area_ratio(Rx::Algorithm::min(depth, MAX_AREA_RATIO_DEPTH));
+        results.max_lat_long_error = get_max_lat_long_error();
+        results.num_neighbour_mismatches = count_neighbour_mismatches();
+
+        HeightmapTilePool heightmap_pool{heightmap_size};
+        auto heightmap = heightmap_pool.allocate();
+        auto neighbour_heightmap = heightmap_pool.allocate();
+
+        // The tiles on both sides of the middle of every edge of every face, and the tile next to each of those on the same face
+        const auto middle = (1u << depth) / 2;
+        for(Uint32 face = 0; face < NUM_CUBE_FACES; face++) {
+            for(const auto edge : TILE_EDGES) {
+                auto tile = CubeSphereTileKey{.face = static_cast<CubeFace>(face), .depth = depth, .coord = {middle, middle}};
+                switch(edge) {
+                    case CubeSphereTileEdge::MinU:
+                        tile.coord.x = 0;
+                        break;
+
+                    case CubeSphereTileEdge::MaxU:
+                        tile.coord.x = tile.get_num_tiles_per_edge() - 1;
+                        break;
+
+                    case CubeSphereTileEdge::MinV:
+                        tile.coord.y = 0;
+                        break;
+
+                    case CubeSphereTileEdge::MaxV:
+                        tile.coord.y = tile.get_num_tiles_per_edge() - 1;
+                        break;
+                }
+
+                fill_cube_sphere_tile_heightmap(config, tile, radius, heightmap, min_height, max_height);
+
+                const auto other_face = get_cube_sphere_tile_neighbour(tile, edge);
+                fill_cube_sphere_tile_heightmap(config, other_face, radius, neighbour_heightmap, min_height, max_height);
+                results.max_cross_face_seam_difference = Rx::Algorithm::max(results.max_cross_face_seam_difference,
+                                                                             get_seam_difference(tile,
+                                                                                                 heightmap,
+                                                                                                 edge,
+                                                                                                 other_face,
+                                                                                                 neighbour_heightmap));
+
+                // Every edge tile has a neighbour toward the middle of the face, unless the whole face is one tile
+                if(depth > 0) {
+                    const auto inward_edge = edge == CubeSphereTileEdge::MinU ? CubeSphereTileEdge::MaxU :
+                                             edge == CubeSphereTileEdge::MaxU ? CubeSphereTileEdge::MinU :
+                                             edge == CubeSphereTileEdge::MinV ? CubeSphereTileEdge::MaxV :
+                                                                                CubeSphereTileEdge::MinV;
+                    const auto same_face = get_cube_sphere_tile_neighbour(tile, inward_edge);
+                    fill_cube_sphere_tile_heightmap(config, same_face, radius, neighbour_heightmap, min_height, max_height);
+                    results.max_face_seam_difference = Rx::Algorithm::max(results.max_face_seam_difference,
+                                                                          get_seam_difference(tile,
+                                                                                              heightmap,
+                                                                                              inward_edge,
+                                                                                              same_face,
+                                                                                              neighbour_heightmap));
+                }
+            }
+        }
+
+        heightmap_pool.free(neighbour_heightmap);
+
+        const auto max_seam_difference = (max_height - min_height) * MAX_SEAM_DIFFERENCE;
+        results.failed = results.max_lat_long_error > MAX_LAT_LONG_ERROR || results.num_neighbour_mismatches > 0 ||
+                         results.max_face_seam_difference > max_seam_difference ||
+                         results.max_cross_face_seam_difference > max_seam_difference;
+
+        // Spread the timed tiles evenly over the planet with a Fibonacci lattice, so they land on every part of every face
+        const auto golden_angle = 3.14159265358979323846 * (3.0 - std::sqrt(5.0));
+
+        results.num_tiles = num_tiles;
+        results.min_tile_milliseconds = 1e30;
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            const auto y = 1.0 - 2.0 * (i + 0.5) / static_cast<Float64>(num_tiles);
+            const auto horizontal_radius = std::sqrt(1.0 - y * y);
+            const auto angle = golden_angle * i;
+            const auto tile = get_cube_sphere_tile_containing({horizontal_radius * std::cos(angle), y, horizontal_radius * std::sin(angle)},
+                                                              depth);
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            fill_cube_sphere_tile_heightmap(config, tile, radius, heightmap, min_height, max_height);
+
+            timer.stop();
+
+            const auto milliseconds = timer.elapsed().total_seconds() * 1000.0;
+            results.milliseconds += milliseconds;
+            results.min_tile_milliseconds = Rx::Algorithm::min(results.min_tile_milliseconds, milliseconds);
+            results.max_tile_milliseconds = Rx::Algorithm::max(results.max_tile_milliseconds, milliseconds);
+        }
+
+        heightmap_pool.free(heightmap);
+
+        logger->info("Cube sphere tiles at depth %u have an area ratio of %f. Latitudes and longitudes round-trip within %g degrees. %u "
+                     "tile edges don't lead back to the same tile",
+                     depth,
+                     results.tile_area_ratio,
+                     results.max_lat_long_error,
+                     results.num_neighbour_mismatches);
+        logger->info("Seams between %ux%u tiles differ by up to %f meters on the same face and up to %f meters across faces",
+                     heightmap_size,
+                     heightmap_size,
+                     results.max_face_seam_difference,
+                     results.max_cross_face_seam_difference);
+        logger->info("Filled %u tiles in %f ms. The fastest tile took %f ms and the slowest took %f ms",
+                     num_tiles,
+                     results.milliseconds,
+                     results.min_tile_milliseconds,
+                     results.max_tile_milliseconds);
+
+        if(results.failed) {
+            logger->error("The cube sphere tiles failed their checks");
+        }
+
+        return results;
+    }
+} // namespace terraingen
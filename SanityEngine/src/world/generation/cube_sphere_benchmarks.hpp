@@ -0,0 +1,76 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "world/cube_sphere.hpp"
+#include "world/generation/terrain_noise.hpp"
+
+namespace terraingen {
+    struct CubeSphereBenchmarkResults {
+        /*!
+         * \brief Area of the smallest tile divided by the area of the biggest, at the benchmarked depth or depth 8, whichever is shallower
+         */
+        Float64 tile_area_ratio{0};
+
+        /*!
+         * \brief Largest difference between a latitude and longitude and the same latitude and longitude after converting it to a cube face
+         * point and back, in degrees
+         */
+        Float64 max_lat_long_error{0};
+
+        /*!
+         * \brief Number of tile edges whose neighbour doesn't have the tile as a neighbour in return
+         */
+        Uint32 num_neighbour_mismatches{0};
+
+        /*!
+         * \brief Largest difference between the heights on either side of an edge between two tiles on the same face, in meters
+         */
+        Float32 max_face_seam_difference{0};
+
+        /*!
+         * \brief Largest difference between the heights on either side of an edge between two faces, in meters
+         */
+        Float32 max_cross_face_seam_difference{0};
+
+        /*!
+         * \brief Whether the latitudes and longitudes didn't round-trip, a tile edge didn't lead back, or a seam differed by more than a
+         * ten-thousandth of the height range
+         */
+        bool failed{false};
+
+        Uint32 num_tiles{0};
+
+        /*!
+         * \brief Time it took to fill every tile's heightmap on one thread, in milliseconds
+         */
+        double milliseconds{0};
+
+        double min_tile_milliseconds{0};
+
+        double max_tile_milliseconds{0};
+    };
+
+    /*!
+     * \brief Checks the cube sphere tiling and measures how long its tiles take to generate
+     *
+     * Converts a grid of latitudes and longitudes to cube face points and back, walks every edge of every tile at depth 3 to its neighbour
+     * and back, and fills the tiles on both sides of the middle of every face's edges to compare their heights along the edge. Then fills
+     * tiles spread over the whole planet, which shows whether tiles near the corners of the faces cost any more than tiles in the middle.
+     * Results get logged as well as returned
+     *
+     * \param config Noise settings to fill the tiles with
+     * \param radius Radius of the planet, in meters
+     * \param depth Depth of the tiles to fill
+     * \param heightmap_size Width and height of each tile's heightmap, in texels
+     * \param num_tiles Number of tiles to fill for the timing
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    [[nodiscard]] CubeSphereBenchmarkResults benchmark_cube_sphere_tiles(const NoiseConfig& config,
+                                                                         Float64 radius,
+                                                                         Uint32 depth,
+                                                                         Uint32 heightmap_size,
+                                                                         Uint32 num_tiles,
+                                                                         Float32 min_height,
+                                                                         Float32 max_height);
+} // namespace terraingen
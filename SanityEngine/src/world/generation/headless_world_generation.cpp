@@ -0,0 +1,280 @@
+#include "headless_world_generation.hpp"
+
+#include "Tracy.hpp"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+#include "rx/core/log.h"
+#include "rx/core/time/stop_watch.h"
+#include "world/heightmap_tile_pool.hpp"
+#include "world/terrain_height_queries.hpp"
+#include "world/terrain_water.hpp"
+
+namespace terraingen {
+    RX_LOG("HeadlessWorldGeneration", logger);
+
+    /*!
+     * \brief Runs one stage of world generation, and records how long it took
+     *
+     * \param func Runs the stage, and returns the number of `unit`s that it produced
+     */
+    template <typename FuncType>
+    static void run_stage(HeadlessWorld& world, const char* name, const char* unit, FuncType&& func) {
+        Rx::Time::StopWatch timer;
+        timer.start();
+        const auto num_elements = static_cast<Uint64>(func());
+        timer.stop();
+
+        auto timing = WorldGenerationStageTiming{.name = name,
+                                                 .milliseconds = timer.elapsed().total_seconds() * 1000.0,
+                                                 .num_elements = num_elements,
+                                                 .unit = unit};
+        timing.elements_per_millisecond = timing.milliseconds > 0 ? static_cast<double>(num_elements) / timing.milliseconds : 0.0;
+
+        logger->info("Stage '%s' took %f ms (%f %s/ms)", name, timing.milliseconds, timing.elements_per_millisecond, unit);
+
+        world.stage_timings.push_back(timing);
+    }
+
+    /*!
+     * \brief Runs a task for each tile on a thread pool, and waits for all of them
+     */
+    template <typename FuncType>
+    static void for_each_tile(const Uint32 num_threads, const Uint32 num_tiles, FuncType&& func) {
+        Rx::Concurrency::ThreadPool pool{num_threads, num_tiles};
+        Rx::Concurrency::WaitGroup tiles_finished{num_tiles};
+
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            pool.add([&, i](int /* thread_id */) {
+                func(i);
+                tiles_finished.signal();
+            });
+        }
+
+        tiles_finished.wait();
+    }
+
+    /*!
+     * \brief Gathers the world's maps for object placement and the tiles' water, like the terrain does when it's created
+     */
+    static TerrainFallbackHeightmap make_world_maps(const WorldParameters& params, const HeadlessWorld& world) {
+        const auto width = params.height / 2 * 2;
+        const auto depth = params.width / 2 * 2;
+        if(world.heightmap.size() != static_cast<Size>(width) * depth) {
+            logger->warning("World heightmap has %zu heights instead of %ux%u. The tiles won't have any world maps",
+                            world.heightmap.size(),
+                            width,
+                            depth);
+            return {};
+        }
+
+        return TerrainFallbackHeightmap{.origin = {-static_cast<Float32>(params.height / 2), -static_cast<Float32>(params.width / 2)},
+                                        .width = width,
+                                        .depth = depth,
+                                        .heights = world.heightmap,
+                                        .water_depths = world.water.water_depths,
+                                        .humidity = world.climate.humidity,
+                                        .soil_moisture = world.climate.soil_moisture,
+                                        .water_distance = world.derived_maps.water_distance,
+                                        .groundwater = world.derived_maps.groundwater,
+                                        .ecotypes = world.ecotypes};
+    }
+
+    template <typename ElementType>
+    static void add_map_hash(HeadlessWorld& world, const char* name, const Rx::Vector<ElementType>& map) {
+        const auto num_bytes = map.size() * sizeof(ElementType);
+        world.map_hashes.push_back(WorldMapHash{.name = name,
+                                                .num_bytes = num_bytes,
+                                                .hash = hash_map_bytes({reinterpret_cast<const Byte*>(map.data()), num_bytes})});
+    }
+
+    HeadlessWorld generate_headless_world(const WorldParameters& params,
+                                          const std::span<const environment::EnvironmentObject> objects,
+                                          const HeadlessWorldSettings& settings) {
+        ZoneScoped;
+
+        logger->info("Generating world with seed %u on %u threads", params.seed, settings.num_threads);
+
+        HeadlessWorld world;
+
+        const auto noise_config = get_world_noise_config(params);
+
+        const auto num_texels = static_cast<Size>(params.width) * params.height;
+
+        run_stage(world, "heightmap noise", "texels", [&] {
+            world.heightmap = generate_world_heightmap(params, settings.num_threads);
+            return num_texels;
+        });
+
+        run_stage(world, "erosion", "texels", [&] {
+            erode_world_heightmap({world.heightmap.data(), world.heightmap.size()},
+                                  params,
+                                  settings.num_erosion_iterations,
+                                  settings.num_threads);
+            return num_texels;
+        });
+
+        run_stage(world, "hydrology", "texels", [&] {
+            world.water = find_world_water({world.heightmap.data(), world.heightmap.size()}, params, settings.num_threads);
+            return num_texels;
+        });
+
+        run_stage(world, "climate", "texels", [&] {
+            world.climate = compute_world_climate({world.heightmap.data(), world.heightmap.size()},
+                                                  {world.water.water_depths.data(), world.water.water_depths.size()},
+                                                  params,
+                                                  settings.num_threads);
+            return num_texels;
+        });
+
+        run_stage(world, "ecotypes", "texels", [&] {
+            world.ecotypes = classify_world_ecotypes(params,
+                                                     {world.heightmap.data(), world.heightmap.size()},
+                                                     {world.water.water_depths.data(), world.water.water_depths.size()},
+                                                     {world.water.river_mask.data(), world.water.river_mask.size()},
+                                                     {world.climate.humidity.data(), world.climate.humidity.size()},
+                                                     {world.climate.soil_moisture.data(), world.climate.soil_moisture.size()});
+            return num_texels;
+        });
+
+        run_stage(world, "derived maps", "texels", [&] {
+            world.derived_maps = derive_world_maps(world.ecotypes,
+                                                   {world.climate.humidity.data(), world.climate.humidity.size()},
+                                                   settings.num_threads);
+            return num_texels;
+        });
+
+        // The tiles, centered on the origin like the streamer loads them around a player who just spawned
+        const auto num_tiles = settings.tiles_per_side * settings.tiles_per_side;
+        const auto first_tile = -static_cast<Int32>(settings.tiles_per_side / 2);
+        world.tile_coords.reserve(num_tiles);
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            world.tile_coords.push_back(Vec2i{first_tile + static_cast<Int32>(i % settings.tiles_per_side),
+                                              first_tile + static_cast<Int32>(i / settings.tiles_per_side)});
+        }
+
+        const auto tile_size = settings.tile_size;
+        const auto min_terrain_height = params.min_terrain_depth_under_ocean;
+        const auto max_terrain_height = params.min_terrain_depth_under_ocean + params.max_ocean_depth + params.max_height_above_sea_level;
+
+        // Tiles have one more row and column than they have cells, like the terrain's tile heightmaps
+        HeightmapTilePool heightmap_pool{tile_size + 1};
+        Rx::Vector<TileHeightmap> heightmaps;
+        heightmaps.reserve(num_tiles);
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            heightmaps.push_back(heightmap_pool.allocate());
+        }
+
+        run_stage(world, "tile heightmaps", "heights", [&] {
+            for_each_tile(settings.num_threads, num_tiles, [&](const Uint32 i) {
+                fill_tile_heightmap(noise_config,
+                                    world.tile_coords[i] * static_cast<Int32>(tile_size),
+                                    heightmaps[i],
+                                    static_cast<Float32>(min_terrain_height),
+                                    static_cast<Float32>(max_terrain_height));
+            });
+            return static_cast<Size>(num_tiles) * (tile_size + 1) * (tile_size + 1);
+        });
+
+        const auto world_maps = make_world_maps(params, world);
+
+        // The objects' meshes aren't loaded, so each object's index stands in for its mesh ID
+        Rx::Vector<environment::ScatterObject> scatter_objects;
+        for(Uint32 i = 0; i < objects.size(); i++) {
+            scatter_objects.push_back(environment::make_scatter_object(objects[i], i));
+        }
+
+        run_stage(world, "object placement", "objects", [&] {
+            // Same settings as the terrain's object placer
+            const auto scatter_settings = environment::ScatterSettings{.seed = static_cast<Uint64>(noise_config.seed),
+                                                                       .tile_size = tile_size};
+
+            Rx::Vector<Rx::Vector<environment::EnvironmentObjectInstance>> tile_instances{num_tiles};
+            if(!scatter_objects.is_empty()) {
+                for_each_tile(settings.num_threads, num_tiles, [&](const Uint32 i) {
+                    tile_instances[i] = environment::scatter_objects_in_tile(scatter_settings,
+                                                                             {scatter_objects.data(), scatter_objects.size()},
+                                                                             world_maps.heights.is_empty() ? nullptr : &world_maps,
+                                                                             world.tile_coords[i],
+                                                                             heightmaps[i].get_heights(),
+                                                                             heightmaps[i].size);
+                });
+            }
+
+            tile_instances.each_fwd([&](const Rx::Vector<environment::EnvironmentObjectInstance>& instances) {
+                instances.each_fwd([&](const environment::EnvironmentObjectInstance& instance) { world.objects.push_back(instance); });
+            });
+            return world.objects.size();
+        });
+
+        run_stage(world, "water simulation", "cells", [&] {
+            TerrainWaterSimulation simulation{tile_size, TerrainWaterSettings{}, settings.num_threads};
+            for(Uint32 i = 0; i < num_tiles; i++) {
+                const auto initial_depths = get_tile_water_depths(world_maps, world.tile_coords[i], tile_size);
+                simulation.add_tile(world.tile_coords[i],
+                                    heightmaps[i].get_heights(),
+                                    heightmaps[i].size,
+                                    {initial_depths.data(), initial_depths.size()});
+            }
+
+            Uint64 num_cells_updated = 0;
+            for(Uint32 step = 0; step < settings.num_water_steps; step++) {
+                num_cells_updated += static_cast<Uint64>(simulation.step()) * tile_size * tile_size;
+            }
+
+            simulation.publish();
+
+            const auto num_cells_per_tile = static_cast<Size>(tile_size) * tile_size;
+            world.tile_water_depths.reserve(num_tiles * num_cells_per_tile);
+            for(Uint32 i = 0; i < num_tiles; i++) {
+                const auto* depths = simulation.get_published_depths(world.tile_coords[i]);
+                for(Size cell = 0; cell < num_cells_per_tile; cell++) {
+                    world.tile_water_depths.push_back(depths[cell]);
+                }
+            }
+
+            return num_cells_updated;
+        });
+
+        world.tile_heights.reserve(static_cast<Size>(num_tiles) * (tile_size + 1) * (tile_size + 1));
+        heightmaps.each_fwd([&](const TileHeightmap& heightmap) {
+            const auto heights = heightmap.get_heights();
+            for(Size i = 0; i < heights.size(); i++) {
+                world.tile_heights.push_back(heights[i]);
+            }
+
+            heightmap_pool.free(heightmap);
+        });
+
+        add_map_hash(world, "heightmap", world.heightmap);
+        add_map_hash(world, "flow_accumulation", world.water.flow_accumulation);
+        add_map_hash(world, "river_mask", world.water.river_mask);
+        add_map_hash(world, "lake_mask", world.water.lake_mask);
+        add_map_hash(world, "water_depths", world.water.water_depths);
+        add_map_hash(world, "wind", world.climate.wind);
+        add_map_hash(world, "humidity", world.climate.humidity);
+        add_map_hash(world, "soil_moisture", world.climate.soil_moisture);
+        add_map_hash(world, "temperature", world.climate.temperature);
+        add_map_hash(world, "ecotypes", world.ecotypes.ecotypes);
+        add_map_hash(world, "water_distance", world.derived_maps.water_distance);
+        add_map_hash(world, "groundwater", world.derived_maps.groundwater);
+        add_map_hash(world, "tile_heights", world.tile_heights);
+        add_map_hash(world, "objects", world.objects);
+        add_map_hash(world, "tile_water_depths", world.tile_water_depths);
+
+        return world;
+    }
+
+    Uint64 hash_map_bytes(const std::span<const Byte> bytes) {
+        // Rex has an FNV-1a, but its namespace clashes with `Rx::Hash` everywhere that includes the containers
+        constexpr Uint64 FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+        constexpr Uint64 FNV_PRIME = 0x100000001B3ull;
+
+        auto hash = FNV_OFFSET_BASIS;
+        for(const auto byte : bytes) {
+            hash ^= byte;
+            hash *= FNV_PRIME;
+        }
+
+        return hash;
+    }
+} // namespace terraingen
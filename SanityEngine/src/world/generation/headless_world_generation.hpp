@@ -0,0 +1,129 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+#include "world/environment/environment_object.hpp"
+#include "world/environment/object_scattering.hpp"
+#include "world/generation/world_generation.hpp"
+
+namespace terraingen {
+    struct HeadlessWorldSettings {
+        /*!
+         * \brief Number of iterations of hydraulic erosion to run over the world heightmap. The engine reads this from
+         * `t.TerrainErosionIterations`
+         */
+        Uint32 num_erosion_iterations{64};
+
+        Uint32 num_threads{1};
+
+        /*!
+         * \brief Width of a terrain tile, in meters. Should be `Terrain::TILE_SIZE` to match the engine
+         */
+        Uint32 tile_size{64};
+
+        /*!
+         * \brief Number of tiles along each side of the square of tiles around the origin that get heightmaps, objects, and water
+         */
+        Uint32 tiles_per_side{8};
+
+        /*!
+         * \brief Number of shallow-water simulation steps to run on the tiles
+         */
+        Uint32 num_water_steps{600};
+    };
+
+    struct WorldGenerationStageTiming {
+        const char* name{nullptr};
+
+        double milliseconds{0};
+
+        /*!
+         * \brief Number of things that the stage produced, in `unit`s
+         */
+        Uint64 num_elements{0};
+
+        const char* unit{nullptr};
+
+        double elements_per_millisecond{0};
+    };
+
+    struct WorldMapHash {
+        const char* name{nullptr};
+
+        Size num_bytes{0};
+
+        /*!
+         * \brief 64-bit FNV-1a hash of the map's bytes
+         */
+        Uint64 hash{0};
+    };
+
+    /*!
+     * \brief Everything that headless world generation produced
+     */
+    struct HeadlessWorld {
+        Rx::Vector<Float32> heightmap;
+
+        WorldWaterMaps water;
+
+        ClimateMaps climate;
+
+        environment::EcotypeMap ecotypes;
+
+        WorldDerivedMaps derived_maps;
+
+        /*!
+         * \brief The heights of each tile, one tile after the other, in the order of `tile_coords`. Each tile has `tile_size + 1` rows of
+         * `tile_size + 1` heights
+         */
+        Rx::Vector<Float32> tile_heights;
+
+        /*!
+         * \brief The water depths of each tile after the water simulation, one tile after the other, in the order of `tile_coords`. Each
+         * tile has `tile_size` rows of `tile_size` depths
+         */
+        Rx::Vector<Float32> tile_water_depths;
+
+        /*!
+         * \brief The environment objects on each tile, one tile after the other, in the order of `tile_coords`
+         */
+        Rx::Vector<environment::EnvironmentObjectInstance> objects;
+
+        Rx::Vector<Vec2i> tile_coords;
+
+        /*!
+         * \brief How long each stage took, in the order that they ran
+         */
+        Rx::Vector<WorldGenerationStageTiming> stage_timings;
+
+        /*!
+         * \brief A hash of each map, so that runs can be checked for bit-exactness against each other
+         */
+        Rx::Vector<WorldMapHash> map_hashes;
+    };
+
+    /*!
+     * \brief Runs the CPU parts of world generation without a GPU or a window
+     *
+     * The world maps go through the same stages as `World::create`: the heightmap noise, hydraulic erosion, hydrology, the climate model,
+     * the ecotypes, and the derived maps. Then a square of terrain tiles around the origin gets heightmaps from the tile noise, environment
+     * objects, and a run of the shallow-water simulation, like the terrain streamer would give them. Each stage gets timed, and each map
+     * gets hashed once everything is done. Every stage is deterministic, so the hashes only depend on the parameters, the settings, and
+     * the objects, no matter how many threads ran the stages
+     *
+     * \param params The world to generate
+     * \param objects The environment objects to place on the tiles. The objects' meshes aren't loaded, so instances get the object's
+     * index as their mesh ID
+     * \param settings How much to generate
+     */
+    [[nodiscard]] HeadlessWorld generate_headless_world(const WorldParameters& params,
+                                                        std::span<const environment::EnvironmentObject> objects,
+                                                        const HeadlessWorldSettings& settings);
+
+    /*!
+     * \brief Hashes a map's bytes with 64-bit FNV-1a
+     */
+    [[nodiscard]] Uint64 hash_map_bytes(std::span<const Byte> bytes);
+} // namespace terraingen
@@ -0,0 +1,791 @@
+#include "noise_benchmarks.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/log.h"
+#include "rx/core/time/stop_watch.h"
+
+namespace terraingen {
+    RX_LOG("NoiseBenchmarks", logger);
+
+    /*!
+     * \brief One set that every level generates
+     */
+    struct NoiseBenchmarkCase {
+        FastNoiseSIMD::NoiseType noise_type;
+
+        FastNoiseSIMD::FractalType fractal_type;
+
+        FastNoiseSIMD::PerturbType perturb_type;
+
+        Uint32 num_dimensions;
+    };
+
+    static Rx::Vector<NoiseBenchmarkCase> get_noise_benchmark_cases() {
+        constexpr auto num_noise_types = static_cast<int>(FastNoiseSIMD::CubicFractal) + 1;
+        constexpr auto num_fractal_types = static_cast<int>(FastNoiseSIMD::RigidMulti) + 1;
+        constexpr auto num_perturb_types = static_cast<int>(FastNoiseSIMD::GradientFractal_Normalise) + 1;
+
+        Rx::Vector<NoiseBenchmarkCase> cases;
+        for(Uint32 num_dimensions = 2; num_dimensions <= 3; num_dimensions++) {
+            for(int noise_type = 0; noise_type < num_noise_types; noise_type++) {
+                const auto num_fractal_types_to_run = is_fractal_noise_type(static_cast<FastNoiseSIMD::NoiseType>(noise_type)) ?
+                                                          num_fractal_types :
+                                                          1;
+                for(int fractal_type = 0; fractal_type < num_fractal_types_to_run; fractal_type++) {
+                    for(int perturb_type = 0; perturb_type < num_perturb_types; perturb_type++) {
+                        cases.push_back(NoiseBenchmarkCase{.noise_type = static_cast<FastNoiseSIMD::NoiseType>(noise_type),
+                                                           .fractal_type = static_cast<FastNoiseSIMD::FractalType>(fractal_type),
+                                                           .perturb_type = static_cast<FastNoiseSIMD::PerturbType>(perturb_type),
+                                                           .num_dimensions = num_dimensions});
+                    }
+                }
+            }
+        }
+
+        return cases;
+    }
+
+    /*!
+     * \brief Distances from the origin that `benchmark_large_coordinate_noise` generates its sets at. 4e7 is about the Earth's
+     * circumference in meters, and 1e12 is too far for `FillNoiseSet`'s int start
+     */
+    constexpr double LARGE_COORDINATE_ORIGINS[] = {0.0, 1.0e5, 4.0e7, 1.0e9, 1.0e12};
+
+    /*!
+     * \brief Largest fraction of neighbouring values in a `FillNoiseSetAtOrigin` set that may be equal before it counts as banded
+     */
+    constexpr Float32 MAX_ORIGIN_BANDING = 0.01f;
+
+    /*!
+     * \brief Noise types that `FillNoiseSetWithDerivatives` has derivatives for
+     */
+    constexpr FastNoiseSIMD::NoiseType DERIVATIVE_NOISE_TYPES[] = {FastNoiseSIMD::Perlin,
+                                                                   FastNoiseSIMD::PerlinFractal,
+                                                                   FastNoiseSIMD::Simplex,
+                                                                   FastNoiseSIMD::SimplexFractal};
+
+    /*!
+     * \brief Distance between neighbouring samples of the highest octave in the finite difference sets, in lattice cells
+     */
+    constexpr Float32 FINITE_DIFFERENCE_STEP = 0.005f;
+
+    /*!
+     * \brief Where the finite difference sets start, in lattice cells of the highest octave
+     *
+     * None of these are near a lattice point of any octave. Every octave of Perlin noise is zero at the origin, so sets there have
+     * octaves that cross zero at the same sample, and the kinks of Billow and RigidMulti can cancel out in the differences. Float
+     * coordinates can't resolve the step much further from the origin than this
+     */
+    constexpr Float32 FINITE_DIFFERENCE_STARTS[][3] = {{0.3183f, 0.2718f, 0.1414f},
+                                                       {1.7321f, -1.4142f, 0.5772f},
+                                                       {-2.2361f, 2.6458f, -1.1892f},
+                                                       {2.8284f, 1.6180f, -2.4495f}};
+
+    /*!
+     * \brief A noise set and its derivative sets, allocated by FastNoiseSIMD
+     */
+    struct NoiseDerivativeSets {
+        Float32* values{nullptr};
+
+        Float32* x{nullptr};
+
+        Float32* y{nullptr};
+
+        Float32* z{nullptr};
+    };
+
+    /*!
+     * \brief Gets the largest derivative along any axis in a cube of derivative sets
+     */
+    static Float32 get_max_derivative(const NoiseDerivativeSets& sets, const Uint32 num_samples) {
+        Float32 max_derivative = 0;
+        for(Uint32 i = 0; i < num_samples; i++) {
+            max_derivative = Rx::Algorithm::max(max_derivative, std::abs(sets.x[i]), std::abs(sets.y[i]), std::abs(sets.z[i]));
+        }
+
+        return max_derivative;
+    }
+
+    /*!
+     * \brief Compares a cube of derivatives with central differences of its values, leaving out the samples near a kink
+     *
+     * Curvature and float rounding make the forward and backward differences disagree a little everywhere, but only a kink makes the
+     * second difference jump from one sample to the next
+     *
+     * \param kinked Gets a 1 for every sample that was left out, including the two samples nearest each face of the cube, and a 0 for
+     * every other sample
+     */
+    static void check_finite_differences(const NoiseDerivativeSets& sets,
+                                         const Uint32 set_size,
+                                         const Float32 max_derivative,
+                                         const Float32 tolerance,
+                                         Uint8* kinked,
+                                         NoiseDerivativeResult& result) {
+        // FastNoiseSIMD stores its sets x-major, so neighbours along z are next to each other
+        const Uint32 strides[] = {set_size * set_size, set_size, 1};
+        const Float32* derivatives[] = {sets.x, sets.y, sets.z};
+
+        const auto get_second_difference = [&](const Uint32 index, const Uint32 stride) {
+            return sets.values[index + stride] - 2.0f * sets.values[index] + sets.values[index - stride];
+        };
+
+        const auto is_near_face = [&](const Uint32 i) { return i < 2 || i + 2 >= set_size; };
+
+        for(Uint32 x = 0; x < set_size; x++) {
+            for(Uint32 y = 0; y < set_size; y++) {
+                for(Uint32 z = 0; z < set_size; z++) {
+                    const auto index = (x * set_size + y) * set_size + z;
+                    if(is_near_face(x) || is_near_face(y) || is_near_face(z)) {
+                        kinked[index] = 1;
+                        continue;
+                    }
+
+                    auto is_kinked = false;
+                    Float32 max_error = 0;
+                    for(Uint32 axis = 0; axis < 3; axis++) {
+                        const auto stride = strides[axis];
+                        const auto second_difference = get_second_difference(index, stride);
+                        if(std::abs(get_second_difference(index + stride, stride) - second_difference) > tolerance * max_derivative ||
+                           std::abs(second_difference - get_second_difference(index - stride, stride)) > tolerance * max_derivative) {
+                            is_kinked = true;
+                            break;
+                        }
+
+                        const auto central_difference = (sets.values[index + stride] - sets.values[index - stride]) * 0.5f;
+                        max_error = Rx::Algorithm::max(max_error, std::abs(derivatives[axis][index] - central_difference));
+                    }
+
+                    kinked[index] = is_kinked ? 1 : 0;
+                    if(is_kinked) {
+                        result.num_kinked_samples++;
+                    } else {
+                        result.max_finite_difference_error = Rx::Algorithm::max(result.max_finite_difference_error,
+                                                                                max_error / max_derivative);
+                    }
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Gets the fraction of neighbouring values along each row of a square set that are exactly equal
+     */
+    static Float32 get_banding(const Float32* noise_set, const Uint32 set_size) {
+        Uint64 num_equal_neighbours = 0;
+        for(Uint32 row = 0; row < set_size; row++) {
+            for(Uint32 i = 1; i < set_size; i++) {
+                if(noise_set[row * set_size + i] == noise_set[row * set_size + i - 1]) {
+                    num_equal_neighbours++;
+                }
+            }
+        }
+
+        const auto num_neighbours = static_cast<Uint64>(set_size) * (set_size - 1);
+        return num_neighbours > 0 ? static_cast<Float32>(num_equal_neighbours) / static_cast<Float32>(num_neighbours) : 0.0f;
+    }
+
+    const char* get_simd_level_name(const int simd_level) {
+        switch(simd_level) {
+            case FN_NO_SIMD_FALLBACK:
+                return "Scalar";
+
+            case FN_SSE2:
+                return "SSE2";
+
+            case FN_SSE41:
+                return "SSE4.1";
+
+            case FN_AVX2:
+                return "AVX2";
+
+            case FN_AVX512:
+                return "AVX-512";
+
+            case FN_NEON:
+                return "NEON";
+
+            default:
+                return "Unknown";
+        }
+    }
+
+    const char* get_noise_type_name(const FastNoiseSIMD::NoiseType noise_type) {
+        switch(noise_type) {
+            case FastNoiseSIMD::Value:
+                return "Value";
+
+            case FastNoiseSIMD::ValueFractal:
+                return "ValueFractal";
+
+            case FastNoiseSIMD::Perlin:
+                return "Perlin";
+
+            case FastNoiseSIMD::PerlinFractal:
+                return "PerlinFractal";
+
+            case FastNoiseSIMD::Simplex:
+                return "Simplex";
+
+            case FastNoiseSIMD::SimplexFractal:
+                return "SimplexFractal";
+
+            case FastNoiseSIMD::WhiteNoise:
+                return "WhiteNoise";
+
+            case FastNoiseSIMD::Cellular:
+                return "Cellular";
+
+            case FastNoiseSIMD::Cubic:
+                return "Cubic";
+
+            case FastNoiseSIMD::CubicFractal:
+                return "CubicFractal";
+
+            default:
+                return "Unknown";
+        }
+    }
+
+    const char* get_fractal_type_name(const FastNoiseSIMD::FractalType fractal_type) {
+        switch(fractal_type) {
+            case FastNoiseSIMD::FBM:
+                return "FBM";
+
+            case FastNoiseSIMD::Billow:
+                return "Billow";
+
+            case FastNoiseSIMD::RigidMulti:
+                return "RigidMulti";
+
+            default:
+                return "Unknown";
+        }
+    }
+
+    const char* get_perturb_type_name(const FastNoiseSIMD::PerturbType perturb_type) {
+        switch(perturb_type) {
+            case FastNoiseSIMD::None:
+                return "None";
+
+            case FastNoiseSIMD::Gradient:
+                return "Gradient";
+
+            case FastNoiseSIMD::GradientFractal:
+                return "GradientFractal";
+
+            case FastNoiseSIMD::Normalise:
+                return "Normalise";
+
+            case FastNoiseSIMD::Gradient_Normalise:
+                return "Gradient_Normalise";
+
+            case FastNoiseSIMD::GradientFractal_Normalise:
+                return "GradientFractal_Normalise";
+
+            default:
+                return "Unknown";
+        }
+    }
+
+    bool is_fractal_noise_type(const FastNoiseSIMD::NoiseType noise_type) {
+        return noise_type == FastNoiseSIMD::ValueFractal || noise_type == FastNoiseSIMD::PerlinFractal ||
+               noise_type == FastNoiseSIMD::SimplexFractal || noise_type == FastNoiseSIMD::CubicFractal;
+    }
+
+    Rx::Vector<int> get_supported_simd_levels() {
+        // Forgetting the current level makes FastNoiseSIMD detect the fastest level again
+        const auto current_level = FastNoiseSIMD::GetSIMDLevel();
+        FastNoiseSIMD::SetSIMDLevel(-1);
+        [[maybe_unused]] const auto fastest_level = FastNoiseSIMD::GetSIMDLevel();
+        FastNoiseSIMD::SetSIMDLevel(current_level);
+
+        Rx::Vector<int> levels;
+
+#ifdef FN_COMPILE_NO_SIMD_FALLBACK
+        levels.push_back(FN_NO_SIMD_FALLBACK);
+#endif
+
+#ifdef FN_COMPILE_SSE2
+        if(fastest_level >= FN_SSE2) {
+            levels.push_back(FN_SSE2);
+        }
+#endif
+
+#ifdef FN_COMPILE_SSE41
+        if(fastest_level >= FN_SSE41) {
+            levels.push_back(FN_SSE41);
+        }
+#endif
+
+#ifdef FN_COMPILE_AVX2
+        if(fastest_level >= FN_AVX2) {
+            levels.push_back(FN_AVX2);
+        }
+#endif
+
+#ifdef FN_COMPILE_AVX512
+        if(fastest_level >= FN_AVX512) {
+            levels.push_back(FN_AVX512);
+        }
+#endif
+
+#ifdef FN_COMPILE_NEON
+        if(fastest_level >= FN_NEON) {
+            levels.push_back(FN_NEON);
+        }
+#endif
+
+        return levels;
+    }
+
+    NoiseBackendBenchmarkResults benchmark_noise_backends(const NoiseConfig& config,
+                                                          const Uint32 set_size_2d,
+                                                          const Uint32 set_size_3d,
+                                                          const Uint32 num_repeats,
+                                                          const Float32 tolerance) {
+        ZoneScoped;
+
+        NoiseBackendBenchmarkResults results;
+        results.simd_levels = get_supported_simd_levels();
+        if(results.simd_levels.is_empty()) {
+            logger->error("FastNoiseSIMD doesn't support any instruction set level on this CPU");
+            return results;
+        }
+
+        results.reference_simd_level = results.simd_levels[0];
+
+        const auto cases = get_noise_benchmark_cases();
+        results.runs.reserve(cases.size() * results.simd_levels.size());
+
+        const auto previous_level = FastNoiseSIMD::GetSIMDLevel();
+
+        // Allocate the set at the highest level, since it needs the strictest alignment and the most padding
+        FastNoiseSIMD::SetSIMDLevel(results.simd_levels.last());
+        const auto max_num_samples = Rx::Algorithm::max(set_size_2d * set_size_2d, set_size_3d * set_size_3d * set_size_3d);
+        auto* noise_set = FastNoiseSIMD::GetEmptySet(static_cast<int>(max_num_samples));
+
+        Rx::Vector<Float32> reference_set{max_num_samples};
+
+        logger->info("Benchmarking %zu noise sets on %zu instruction set levels, checked against %s",
+                     cases.size(),
+                     results.simd_levels.size(),
+                     get_simd_level_name(results.reference_simd_level));
+
+        cases.each_fwd([&](const NoiseBenchmarkCase& benchmark_case) {
+            const auto set_size = benchmark_case.num_dimensions == 2 ? set_size_2d : set_size_3d;
+            const auto z_size = benchmark_case.num_dimensions == 2 ? 1u : set_size_3d;
+            const auto num_samples = set_size * set_size * z_size;
+
+            // Start away from the origin, so the sets cover negative coordinates too
+            const auto start = -static_cast<Int32>(set_size / 2);
+            const auto z_start = -static_cast<Int32>(z_size / 2);
+
+            auto case_config = config;
+            case_config.noise_type = benchmark_case.noise_type;
+            case_config.fractal_type = benchmark_case.fractal_type;
+
+            results.simd_levels.each_fwd([&](const int simd_level) {
+                FastNoiseSIMD::SetSIMDLevel(simd_level);
+                const auto generator = case_config.create_generator();
+                generator->SetPerturbType(benchmark_case.perturb_type);
+
+                generator->FillNoiseSet(noise_set, start, start, z_start, set_size, set_size, z_size);
+
+                auto result = NoiseBackendBenchmarkResult{.simd_level = simd_level,
+                                                          .noise_type = benchmark_case.noise_type,
+                                                          .fractal_type = benchmark_case.fractal_type,
+                                                          .perturb_type = benchmark_case.perturb_type,
+                                                          .num_dimensions = benchmark_case.num_dimensions,
+                                                          .num_samples = static_cast<Uint64>(num_samples) * num_repeats};
+
+                if(simd_level == results.reference_simd_level) {
+                    for(Uint32 i = 0; i < num_samples; i++) {
+                        reference_set[i] = noise_set[i];
+                    }
+
+                } else {
+                    for(Uint32 i = 0; i < num_samples; i++) {
+                        // Normalise perturbing divides by zero at the origin, which is fine as long as every level does it
+                        if(std::isnan(noise_set[i]) && std::isnan(reference_set[i])) {
+                            continue;
+                        }
+
+                        // A NaN on only one level never compares greater than the tolerance, so check that the difference is within it
+                        // instead
+                        const auto difference = std::abs(noise_set[i] - reference_set[i]);
+                        if(!(difference <= tolerance)) {
+                            result.num_mismatched_samples++;
+                        }
+                        if(!(difference <= result.max_difference)) {
+                            result.max_difference = difference;
+                        }
+                    }
+                }
+
+                Rx::Time::StopWatch timer;
+                timer.start();
+
+                for(Uint32 repeat = 0; repeat < num_repeats; repeat++) {
+                    generator->FillNoiseSet(noise_set, start, start, z_start, set_size, set_size, z_size);
+                }
+
+                timer.stop();
+
+                result.milliseconds = timer.elapsed().total_seconds() * 1000.0;
+                result.samples_per_second = static_cast<double>(result.num_samples) / (result.milliseconds / 1000.0);
+
+                if(result.num_mismatched_samples > 0) {
+                    results.num_mismatched_runs++;
+                    logger->warning("%s %s %s %s %uD: %zu samples differ from %s by more than %f, by up to %f",
+                                    get_simd_level_name(simd_level),
+                                    get_noise_type_name(benchmark_case.noise_type),
+                                    get_fractal_type_name(benchmark_case.fractal_type),
+                                    get_perturb_type_name(benchmark_case.perturb_type),
+                                    benchmark_case.num_dimensions,
+                                    static_cast<Size>(result.num_mismatched_samples),
+                                    get_simd_level_name(results.reference_simd_level),
+                                    tolerance,
+                                    result.max_difference);
+                }
+
+                logger->verbose("%s %s %s %s %uD: %f million samples/second, max difference %f",
+                                get_simd_level_name(simd_level),
+                                get_noise_type_name(benchmark_case.noise_type),
+                                get_fractal_type_name(benchmark_case.fractal_type),
+                                get_perturb_type_name(benchmark_case.perturb_type),
+                                benchmark_case.num_dimensions,
+                                result.samples_per_second / 1000000.0,
+                                result.max_difference);
+
+                results.runs.push_back(result);
+            });
+        });
+
+        FastNoiseSIMD::SetSIMDLevel(results.simd_levels.last());
+        FastNoiseSIMD::FreeNoiseSet(noise_set);
+        FastNoiseSIMD::SetSIMDLevel(previous_level);
+
+        logger->info("%u of %zu noise benchmark runs differ from %s by more than %f",
+                     results.num_mismatched_runs,
+                     results.runs.size(),
+                     get_simd_level_name(results.reference_simd_level),
+                     tolerance);
+
+        return results;
+    }
+
+    NoiseDerivativeResults benchmark_noise_derivatives(const NoiseConfig& config,
+                                                       const Uint32 set_size,
+                                                       const Uint32 num_repeats,
+                                                       const Float32 tolerance) {
+        ZoneScoped;
+
+        constexpr auto num_fractal_types = static_cast<int>(FastNoiseSIMD::RigidMulti) + 1;
+        constexpr auto num_finite_difference_sets = sizeof(FINITE_DIFFERENCE_STARTS) / sizeof(FINITE_DIFFERENCE_STARTS[0]);
+
+        NoiseDerivativeResults results;
+
+        const auto simd_levels = get_supported_simd_levels();
+        if(simd_levels.is_empty()) {
+            logger->error("FastNoiseSIMD doesn't support any instruction set level on this CPU");
+            return results;
+        }
+
+        results.reference_simd_level = simd_levels[0];
+
+        const auto previous_level = FastNoiseSIMD::GetSIMDLevel();
+
+        // Allocate the sets at the highest level, since it needs the strictest alignment and the most padding
+        FastNoiseSIMD::SetSIMDLevel(simd_levels.last());
+        const auto num_samples = set_size * set_size * set_size;
+        auto* noise_set = FastNoiseSIMD::GetEmptySet(static_cast<int>(num_samples));
+        const auto sets = NoiseDerivativeSets{.values = FastNoiseSIMD::GetEmptySet(static_cast<int>(num_samples)),
+                                              .x = FastNoiseSIMD::GetEmptySet(static_cast<int>(num_samples)),
+                                              .y = FastNoiseSIMD::GetEmptySet(static_cast<int>(num_samples)),
+                                              .z = FastNoiseSIMD::GetEmptySet(static_cast<int>(num_samples))};
+
+        // The reference level's derivatives and kinks for every finite difference set, so the other levels can skip the samples that
+        // straddle a kink at either level. Billow and RigidMulti flip the sign of an octave's derivatives where it crosses zero, and
+        // levels can disagree about which side of zero a sample that close is on
+        const auto num_reference_samples = num_samples * num_finite_difference_sets;
+        Rx::Vector<Float32> reference_x{num_reference_samples};
+        Rx::Vector<Float32> reference_y{num_reference_samples};
+        Rx::Vector<Float32> reference_z{num_reference_samples};
+        Rx::Vector<Uint8> reference_kinked{num_reference_samples};
+        Rx::Vector<Uint8> kinked{num_samples};
+        Float32 reference_max_derivatives[num_finite_difference_sets]{};
+
+        const auto size = static_cast<int>(set_size);
+        const auto start = -size / 2;
+
+        logger->info("Checking FillNoiseSetWithDerivatives on %zu instruction set levels against %s and against finite differences",
+                     simd_levels.size(),
+                     get_simd_level_name(results.reference_simd_level));
+
+        for(const auto noise_type : DERIVATIVE_NOISE_TYPES) {
+            const auto num_fractal_types_to_run = is_fractal_noise_type(noise_type) ? num_fractal_types : 1;
+            for(int fractal_type = 0; fractal_type < num_fractal_types_to_run; fractal_type++) {
+                auto run_config = config;
+                run_config.noise_type = noise_type;
+                run_config.fractal_type = static_cast<FastNoiseSIMD::FractalType>(fractal_type);
+
+                // Scale the finite difference sets so that the highest octave's samples are the step apart
+                const auto highest_frequency = is_fractal_noise_type(noise_type) ?
+                                                   run_config.frequency * std::pow(run_config.lacunarity,
+                                                                                   static_cast<Float32>(run_config.octaves - 1)) :
+                                                   run_config.frequency;
+                const auto scale_modifier = FINITE_DIFFERENCE_STEP / highest_frequency;
+
+                simd_levels.each_fwd([&](const int simd_level) {
+                    FastNoiseSIMD::SetSIMDLevel(simd_level);
+                    const auto generator = run_config.create_generator();
+                    const auto is_reference_level = simd_level == results.reference_simd_level;
+
+                    auto result = NoiseDerivativeResult{.simd_level = simd_level,
+                                                        .noise_type = noise_type,
+                                                        .fractal_type = run_config.fractal_type,
+                                                        .num_samples = static_cast<Uint64>(num_samples) * num_repeats};
+
+                    generator->FillNoiseSet(noise_set, start, start, start, size, size, size);
+                    [[maybe_unused]] const auto filled = generator->FillNoiseSetWithDerivatives(sets.values,
+                                                                                                sets.x,
+                                                                                                sets.y,
+                                                                                                sets.z,
+                                                                                                start,
+                                                                                                start,
+                                                                                                start,
+                                                                                                size,
+                                                                                                size,
+                                                                                                size);
+
+                    for(Uint32 i = 0; i < num_samples; i++) {
+                        result.max_value_difference = Rx::Algorithm::max(result.max_value_difference,
+                                                                         std::abs(sets.values[i] - noise_set[i]));
+                    }
+
+                    Rx::Time::StopWatch timer;
+                    timer.start();
+
+                    for(Uint32 repeat = 0; repeat < num_repeats; repeat++) {
+                        [[maybe_unused]] const auto timed_fill = generator->FillNoiseSetWithDerivatives(sets.values,
+                                                                                                        sets.x,
+                                                                                                        sets.y,
+                                                                                                        sets.z,
+                                                                                                        start,
+                                                                                                        start,
+                                                                                                        start,
+                                                                                                        size,
+                                                                                                        size,
+                                                                                                        size);
+                    }
+
+                    timer.stop();
+
+                    result.milliseconds = timer.elapsed().total_seconds() * 1000.0;
+                    result.samples_per_second = static_cast<double>(result.num_samples) / (result.milliseconds / 1000.0);
+
+                    for(Uint32 set_index = 0; set_index < num_finite_difference_sets; set_index++) {
+                        const auto get_start = [&](const Float32 cells) {
+                            return static_cast<int>(std::round(cells / FINITE_DIFFERENCE_STEP)) - size / 2;
+                        };
+
+                        const auto& finite_difference_start = FINITE_DIFFERENCE_STARTS[set_index];
+                        const auto x_start = get_start(finite_difference_start[0]);
+                        const auto y_start = get_start(finite_difference_start[1]);
+                        const auto z_start = get_start(finite_difference_start[2]);
+                        [[maybe_unused]] const auto filled_fine = generator->FillNoiseSetWithDerivatives(sets.values,
+                                                                                                         sets.x,
+                                                                                                         sets.y,
+                                                                                                         sets.z,
+                                                                                                         x_start,
+                                                                                                         y_start,
+                                                                                                         z_start,
+                                                                                                         size,
+                                                                                                         size,
+                                                                                                         size,
+                                                                                                         scale_modifier);
+
+                        const auto max_derivative = get_max_derivative(sets, num_samples);
+                        if(max_derivative == 0) {
+                            continue;
+                        }
+
+                        check_finite_differences(sets, set_size, max_derivative, tolerance, kinked.data(), result);
+
+                        const auto reference_offset = set_index * num_samples;
+                        if(is_reference_level) {
+                            for(Uint32 i = 0; i < num_samples; i++) {
+                                reference_x[reference_offset + i] = sets.x[i];
+                                reference_y[reference_offset + i] = sets.y[i];
+                                reference_z[reference_offset + i] = sets.z[i];
+                                reference_kinked[reference_offset + i] = kinked[i];
+                            }
+
+                            reference_max_derivatives[set_index] = max_derivative;
+
+                        } else if(reference_max_derivatives[set_index] > 0) {
+                            Float32 max_difference = 0;
+                            for(Uint32 i = 0; i < num_samples; i++) {
+                                if(kinked[i] != 0 || reference_kinked[reference_offset + i] != 0) {
+                                    continue;
+                                }
+
+                                max_difference = Rx::Algorithm::max(max_difference,
+                                                                    std::abs(sets.x[i] - reference_x[reference_offset + i]),
+                                                                    std::abs(sets.y[i] - reference_y[reference_offset + i]),
+                                                                    std::abs(sets.z[i] - reference_z[reference_offset + i]));
+                            }
+
+                            result.max_level_difference = Rx::Algorithm::max(result.max_level_difference,
+                                                                             max_difference / reference_max_derivatives[set_index]);
+                        }
+                    }
+
+                    result.failed = result.max_value_difference > tolerance || result.max_level_difference > tolerance ||
+                                    result.max_finite_difference_error > tolerance;
+                    if(result.failed) {
+                        results.num_failed_runs++;
+                        logger->warning("%s %s %s: values differ from FillNoiseSet by up to %f, and derivatives differ from %s by up to %f "
+                                        "and from finite differences by up to %f of the largest derivative",
+                                        get_simd_level_name(simd_level),
+                                        get_noise_type_name(noise_type),
+                                        get_fractal_type_name(run_config.fractal_type),
+                                        result.max_value_difference,
+                                        get_simd_level_name(results.reference_simd_level),
+                                        result.max_level_difference,
+                                        result.max_finite_difference_error);
+                    }
+
+                    logger->verbose("%s %s %s: %f million samples/second with derivatives, %zu samples straddle a kink",
+                                    get_simd_level_name(simd_level),
+                                    get_noise_type_name(noise_type),
+                                    get_fractal_type_name(run_config.fractal_type),
+                                    result.samples_per_second / 1000000.0,
+                                    static_cast<Size>(result.num_kinked_samples));
+
+                    results.runs.push_back(result);
+                });
+            }
+        }
+
+        FastNoiseSIMD::SetSIMDLevel(simd_levels.last());
+        FastNoiseSIMD::FreeNoiseSet(noise_set);
+        FastNoiseSIMD::FreeNoiseSet(sets.values);
+        FastNoiseSIMD::FreeNoiseSet(sets.x);
+        FastNoiseSIMD::FreeNoiseSet(sets.y);
+        FastNoiseSIMD::FreeNoiseSet(sets.z);
+        FastNoiseSIMD::SetSIMDLevel(previous_level);
+
+        logger->info("%u of %zu noise derivative runs failed", results.num_failed_runs, results.runs.size());
+
+        return results;
+    }
+
+    LargeCoordinateNoiseResults benchmark_large_coordinate_noise(const NoiseConfig& config,
+                                                                 const Uint32 set_size,
+                                                                 const Uint32 num_repeats,
+                                                                 const Float32 tolerance) {
+        ZoneScoped;
+
+        constexpr FastNoiseSIMD::NoiseType noise_types[] = {FastNoiseSIMD::Value,
+                                                            FastNoiseSIMD::ValueFractal,
+                                                            FastNoiseSIMD::Perlin,
+                                                            FastNoiseSIMD::PerlinFractal,
+                                                            FastNoiseSIMD::Simplex,
+                                                            FastNoiseSIMD::SimplexFractal};
+        constexpr auto num_fractal_types = static_cast<int>(FastNoiseSIMD::RigidMulti) + 1;
+
+        LargeCoordinateNoiseResults results;
+
+        const auto num_samples = static_cast<int>(set_size * set_size);
+        auto* int_start_set = FastNoiseSIMD::GetEmptySet(num_samples);
+        auto* origin_set = FastNoiseSIMD::GetEmptySet(num_samples);
+
+        logger->info("Comparing FillNoiseSet with FillNoiseSetAtOrigin on %s", get_simd_level_name(FastNoiseSIMD::GetSIMDLevel()));
+
+        for(const auto noise_type : noise_types) {
+            const auto num_fractal_types_to_run = is_fractal_noise_type(noise_type) ? num_fractal_types : 1;
+            for(int fractal_type = 0; fractal_type < num_fractal_types_to_run; fractal_type++) {
+                auto run_config = config;
+                run_config.noise_type = noise_type;
+                run_config.fractal_type = static_cast<FastNoiseSIMD::FractalType>(fractal_type);
+                const auto generator = run_config.create_generator();
+
+                for(const auto origin : LARGE_COORDINATE_ORIGINS) {
+                    auto result = LargeCoordinateNoiseResult{.noise_type = noise_type,
+                                                             .fractal_type = run_config.fractal_type,
+                                                             .origin = origin};
+
+                    const auto size = static_cast<int>(set_size);
+                    const auto fits_in_int_start = origin <= static_cast<double>(INT32_MAX - size);
+                    if(fits_in_int_start) {
+                        const auto start = static_cast<int>(origin);
+
+                        Rx::Time::StopWatch timer;
+                        timer.start();
+
+                        for(Uint32 repeat = 0; repeat < num_repeats; repeat++) {
+                            generator->FillNoiseSet(int_start_set, start, start, 0, size, size, 1);
+                        }
+
+                        timer.stop();
+
+                        result.int_start_milliseconds = timer.elapsed().total_seconds() * 1000.0;
+                        result.int_start_banding = get_banding(int_start_set, set_size);
+                    }
+
+                    Rx::Time::StopWatch timer;
+                    timer.start();
+
+                    for(Uint32 repeat = 0; repeat < num_repeats; repeat++) {
+                        [[maybe_unused]] const auto filled = generator->FillNoiseSetAtOrigin(origin_set, origin, origin, 0, size, size, 1);
+                    }
+
+                    timer.stop();
+
+                    result.origin_milliseconds = timer.elapsed().total_seconds() * 1000.0;
+                    result.origin_banding = get_banding(origin_set, set_size);
+
+                    if(origin == 0.0) {
+                        for(int i = 0; i < num_samples; i++) {
+                            result.max_difference = Rx::Algorithm::max(result.max_difference, std::abs(int_start_set[i] - origin_set[i]));
+                        }
+                    }
+
+                    result.failed = result.max_difference > tolerance || result.origin_banding > MAX_ORIGIN_BANDING;
+                    if(result.failed) {
+                        results.num_failed_runs++;
+                        logger->warning("%s %s at %f: FillNoiseSetAtOrigin differs from FillNoiseSet by up to %f, and %f of its neighbours "
+                                        "are equal",
+                                        get_noise_type_name(noise_type),
+                                        get_fractal_type_name(run_config.fractal_type),
+                                        origin,
+                                        result.max_difference,
+                                        result.origin_banding);
+                    }
+
+                    logger->verbose("%s %s at %f: %f of FillNoiseSet's neighbours and %f of FillNoiseSetAtOrigin's are equal",
+                                    get_noise_type_name(noise_type),
+                                    get_fractal_type_name(run_config.fractal_type),
+                                    origin,
+                                    result.int_start_banding,
+                                    result.origin_banding);
+
+                    results.runs.push_back(result);
+                }
+            }
+        }
+
+        FastNoiseSIMD::FreeNoiseSet(int_start_set);
+        FastNoiseSIMD::FreeNoiseSet(origin_set);
+
+        logger->info("%u of %zu large coordinate noise runs failed", results.num_failed_runs, results.runs.size());
+
+        return results;
+    }
+} // namespace terraingen
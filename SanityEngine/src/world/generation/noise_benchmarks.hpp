@@ -0,0 +1,242 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "noise/FastNoiseSIMD/FastNoiseSIMD.h"
+#include "rx/core/vector.h"
+#include "world/generation/terrain_noise.hpp"
+
+namespace terraingen {
+    struct NoiseBackendBenchmarkResult {
+        /*!
+         * \brief FastNoiseSIMD's instruction set level, e.g. FN_AVX2
+         */
+        int simd_level{FN_NO_SIMD_FALLBACK};
+
+        FastNoiseSIMD::NoiseType noise_type{FastNoiseSIMD::Value};
+
+        /*!
+         * \brief Fractal type of this run. Only means anything for the fractal noise types
+         */
+        FastNoiseSIMD::FractalType fractal_type{FastNoiseSIMD::FBM};
+
+        FastNoiseSIMD::PerturbType perturb_type{FastNoiseSIMD::None};
+
+        /*!
+         * \brief 2 for a square set with one sample along z, or 3 for a cube
+         */
+        Uint32 num_dimensions{2};
+
+        /*!
+         * \brief Number of samples that were generated, summed over every repeat
+         */
+        Uint64 num_samples{0};
+
+        double milliseconds{0};
+
+        double samples_per_second{0};
+
+        /*!
+         * \brief Largest difference from the same set at the reference level
+         */
+        Float32 max_difference{0};
+
+        /*!
+         * \brief Number of samples that differ from the same set at the reference level by more than the tolerance
+         */
+        Uint64 num_mismatched_samples{0};
+    };
+
+    struct NoiseBackendBenchmarkResults {
+        /*!
+         * \brief Every instruction set level that was benchmarked, from lowest to highest
+         */
+        Rx::Vector<int> simd_levels;
+
+        /*!
+         * \brief The level that every other level was checked against. This is the lowest level that this build and CPU support
+         */
+        int reference_simd_level{FN_NO_SIMD_FALLBACK};
+
+        Rx::Vector<NoiseBackendBenchmarkResult> runs;
+
+        /*!
+         * \brief Number of runs that had any samples outside the tolerance
+         */
+        Uint32 num_mismatched_runs{0};
+    };
+
+    struct NoiseDerivativeResult {
+        /*!
+         * \brief FastNoiseSIMD's instruction set level, e.g. FN_AVX2
+         */
+        int simd_level{FN_NO_SIMD_FALLBACK};
+
+        FastNoiseSIMD::NoiseType noise_type{FastNoiseSIMD::Perlin};
+
+        /*!
+         * \brief Fractal type of this run. Only means anything for the fractal noise types
+         */
+        FastNoiseSIMD::FractalType fractal_type{FastNoiseSIMD::FBM};
+
+        /*!
+         * \brief Number of samples that were generated, summed over every repeat
+         */
+        Uint64 num_samples{0};
+
+        double milliseconds{0};
+
+        double samples_per_second{0};
+
+        /*!
+         * \brief Largest difference between the values and `FillNoiseSet`'s values at the same level
+         */
+        Float32 max_value_difference{0};
+
+        /*!
+         * \brief Largest difference from the same derivatives at the reference level, as a fraction of the largest derivative in the
+         * reference level's set
+         */
+        Float32 max_level_difference{0};
+
+        /*!
+         * \brief Largest difference from the central differences of the values, as a fraction of the largest derivative in the set
+         */
+        Float32 max_finite_difference_error{0};
+
+        /*!
+         * \brief Number of samples left out of the finite difference check because their second differences jump, like they do at a kink
+         * where Billow or RigidMulti takes the absolute value of an octave that crosses zero
+         */
+        Uint64 num_kinked_samples{0};
+
+        bool failed{false};
+    };
+
+    struct NoiseDerivativeResults {
+        /*!
+         * \brief The level that every other level was checked against. This is the lowest level that this build and CPU support
+         */
+        int reference_simd_level{FN_NO_SIMD_FALLBACK};
+
+        Rx::Vector<NoiseDerivativeResult> runs;
+
+        Uint32 num_failed_runs{0};
+    };
+
+    struct LargeCoordinateNoiseResult {
+        FastNoiseSIMD::NoiseType noise_type{FastNoiseSIMD::Value};
+
+        /*!
+         * \brief Fractal type of this run. Only means anything for the fractal noise types
+         */
+        FastNoiseSIMD::FractalType fractal_type{FastNoiseSIMD::FBM};
+
+        /*!
+         * \brief Coordinates of the first value in the set, along both axes
+         */
+        double origin{0};
+
+        /*!
+         * \brief Fraction of neighbouring values that are exactly equal in the `FillNoiseSet` set, which is how float banding shows up.
+         * Negative if the origin doesn't fit in `FillNoiseSet`'s int start
+         */
+        Float32 int_start_banding{-1};
+
+        /*!
+         * \brief Fraction of neighbouring values that are exactly equal in the `FillNoiseSetAtOrigin` set
+         */
+        Float32 origin_banding{0};
+
+        double int_start_milliseconds{0};
+
+        double origin_milliseconds{0};
+
+        /*!
+         * \brief Largest difference between the two sets. Only measured when the origin is 0, where `FillNoiseSet` is still precise
+         */
+        Float32 max_difference{0};
+
+        bool failed{false};
+    };
+
+    struct LargeCoordinateNoiseResults {
+        Rx::Vector<LargeCoordinateNoiseResult> runs;
+
+        Uint32 num_failed_runs{0};
+    };
+
+    [[nodiscard]] const char* get_simd_level_name(int simd_level);
+
+    [[nodiscard]] const char* get_noise_type_name(FastNoiseSIMD::NoiseType noise_type);
+
+    [[nodiscard]] const char* get_fractal_type_name(FastNoiseSIMD::FractalType fractal_type);
+
+    [[nodiscard]] const char* get_perturb_type_name(FastNoiseSIMD::PerturbType perturb_type);
+
+    [[nodiscard]] bool is_fractal_noise_type(FastNoiseSIMD::NoiseType noise_type);
+
+    /*!
+     * \brief Gets every instruction set level that FastNoiseSIMD was compiled with and that this CPU supports, from lowest to highest
+     */
+    [[nodiscard]] Rx::Vector<int> get_supported_simd_levels();
+
+    /*!
+     * \brief Measures how many samples per second each of FastNoiseSIMD's instruction set levels generates, and checks that the levels
+     * agree with each other
+     *
+     * Every noise type, every fractal type of the fractal noise types, and every perturb type gets a 2D and a 3D set at every supported
+     * level. Each set gets generated once to warm up, then timed over the repeats on this thread. The first set is compared with the same
+     * set at the lowest level, since the levels round differently (most of all where AVX2 and NEON fuse multiplies and adds) but should
+     * never disagree by more than that. The SIMD level that new generators get is put back afterwards. Results get logged as well as
+     * returned
+     *
+     * \param config Noise settings to generate the sets with. The noise type and fractal type get replaced by each run's
+     * \param set_size_2d Width and height of the 2D sets
+     * \param set_size_3d Width, height, and depth of the 3D sets
+     * \param num_repeats Number of times each set gets generated for the timing
+     * \param tolerance Largest difference from the reference level that still counts as agreeing
+     */
+    [[nodiscard]] NoiseBackendBenchmarkResults benchmark_noise_backends(
+        const NoiseConfig& config, Uint32 set_size_2d, Uint32 set_size_3d, Uint32 num_repeats, Float32 tolerance);
+
+    /*!
+     * \brief Checks `FastNoiseSIMD::FillNoiseSetWithDerivatives` on every instruction set level that this CPU supports, and measures how
+     * many samples per second it generates
+     *
+     * Every noise type that has derivatives, with every fractal type of the fractal noise types, gets a 3D set at every supported level. A
+     * run fails if its values differ from `FillNoiseSet`'s by more than the tolerance, or if its derivatives differ from the lowest
+     * level's or from central differences of its values by more than the tolerance times the set's largest derivative
+     *
+     * The central differences come from sets at a scale where neighbouring samples of the highest octave are a fraction of a lattice cell
+     * apart, close enough to the origin that float coordinates still resolve them. Samples whose second differences jump from one sample
+     * to the next are left out of the finite difference check, since their differences straddle a kink of Billow or RigidMulti, and so are
+     * samples that straddle a kink at the lowest level from the level check. Results get logged as well as returned
+     *
+     * \param config Noise settings to generate the sets with. The noise type and fractal type get replaced by each run's
+     * \param set_size Width, height, and depth of the sets
+     * \param num_repeats Number of times each set gets generated for the timing
+     * \param tolerance Largest difference that still counts as agreeing
+     */
+    [[nodiscard]] NoiseDerivativeResults benchmark_noise_derivatives(const NoiseConfig& config,
+                                                                     Uint32 set_size,
+                                                                     Uint32 num_repeats,
+                                                                     Float32 tolerance);
+
+    /*!
+     * \brief Compares `FastNoiseSIMD::FillNoiseSet` with `FastNoiseSIMD::FillNoiseSetAtOrigin` from the origin out to planetary distances
+     *
+     * Every noise type that `FillNoiseSetAtOrigin` supports, with every fractal type of the fractal noise types, gets a 2D set from both
+     * functions at a few distances from the origin, on the current SIMD level. A run fails if the two disagree by more than the tolerance
+     * at the origin, or if more than 1% of the `FillNoiseSetAtOrigin` set's neighbouring values are equal anywhere. Results get logged as
+     * well as returned
+     *
+     * \param config Noise settings to generate the sets with. The noise type and fractal type get replaced by each run's
+     * \param set_size Width and height of the sets
+     * \param num_repeats Number of times each set gets generated for the timing
+     * \param tolerance Largest difference between the two functions at the origin that still counts as agreeing
+     */
+    [[nodiscard]] LargeCoordinateNoiseResults benchmark_large_coordinate_noise(const NoiseConfig& config,
+                                                                               Uint32 set_size,
+                                                                               Uint32 num_repeats,
+                                                                               Float32 tolerance);
+} // namespace terraingen
@@ -0,0 +1,1143 @@
+#include "terrain_benchmarks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+#include "rx/core/log.h"
+#include "rx/core/time/stop_watch.h"
+#include "world/environment/object_scattering.hpp"
+#include "world/generation/terrain_erosion.hpp"
+#include "world/generation/terrain_node_mesh.hpp"
+#include "world/terrain_water.hpp"
+#include "world/voxel_chunk_store.hpp"
+#include "world/world_save.hpp"
+
+namespace terraingen {
+    RX_LOG("TerrainBenchmarks", logger);
+
+    Rx::Vector<TileGenerationBenchmarkResult> benchmark_tile_heightmap_generation(const NoiseConfig& config,
+                                                                                  const Uint32 tile_size,
+                                                                                  const Uint32 num_tiles,
+                                                                                  const Rx::Vector<Uint32>& thread_counts) {
+        ZoneScoped;
+
+        Rx::Vector<TileGenerationBenchmarkResult> results;
+        results.reserve(thread_counts.size());
+
+        HeightmapTilePool heightmap_pool{tile_size};
+
+        Rx::Vector<TileHeightmap> heightmaps;
+        heightmaps.reserve(num_tiles);
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            heightmaps.push_back(heightmap_pool.allocate());
+        }
+
+        // Lay the tiles out in a square around the origin, like the terrain streamer would
+        const auto tiles_per_row = static_cast<Uint32>(std::ceil(std::sqrt(static_cast<double>(num_tiles))));
+
+        thread_counts.each_fwd([&](const Uint32 num_threads) {
+            Rx::Concurrency::ThreadPool pool{num_threads, num_tiles};
+            Rx::Concurrency::WaitGroup tiles_finished{num_tiles};
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            for(Uint32 i = 0; i < num_tiles; i++) {
+                pool.add([&, i](int /* thread_id */) {
+                    const auto top_left = Vec2i{static_cast<Int32>(i % tiles_per_row), static_cast<Int32>(i / tiles_per_row)} *
+                                          static_cast<Int32>(tile_size);
+                    fill_tile_heightmap(config, top_left, heightmaps[i], 0, 1);
+
+                    tiles_finished.signal();
+                });
+            }
+
+            tiles_finished.wait();
+
+            timer.stop();
+
+            const auto seconds = timer.elapsed().total_seconds();
+            const auto result = TileGenerationBenchmarkResult{.num_threads = num_threads,
+                                                              .num_tiles = num_tiles,
+                                                              .seconds = seconds,
+                                                              .tiles_per_second = static_cast<double>(num_tiles) / seconds};
+
+            logger->info("Generated %u %ux%u tiles on %u threads in %f seconds (%f tiles/second)",
+                         num_tiles,
+                         tile_size,
+                         tile_size,
+                         num_threads,
+                         result.seconds,
+                         result.tiles_per_second);
+
+            results.push_back(result);
+        });
+
+        heightmaps.each_fwd([&](const TileHeightmap& heightmap) { heightmap_pool.free(heightmap); });
+
+        return results;
+    }
+
+    Rx::Vector<TerrainLodBenchmarkResult> benchmark_terrain_lod(const NoiseConfig& config,
+                                                                const TerrainLodSettings& lod_settings,
+                                                                const Uint32 tile_size,
+                                                                const Rx::Vector<Int32>& tile_distances) {
+        ZoneScoped;
+
+        Rx::Vector<TerrainLodBenchmarkResult> results;
+        results.reserve(tile_distances.size());
+
+        const auto view = TileStreamingView{.location = {0, 0}, .height = lod_settings.max_terrain_height, .view_direction = {1, 0}};
+        const auto skirt_depth = get_terrain_skirt_depth(lod_settings);
+
+        Rx::Vector<TerrainNodeRequest> selection;
+
+        tile_distances.each_fwd([&](const Int32 tile_distance) {
+            const auto streaming_settings = TileStreamingSettings{.tile_size = tile_size, .max_tile_distance = tile_distance};
+
+            Rx::Time::StopWatch selection_timer;
+            selection_timer.start();
+            select_terrain_nodes(view, streaming_settings, lod_settings, selection);
+            selection_timer.stop();
+
+            Rx::Time::StopWatch meshing_timer;
+            meshing_timer.start();
+            selection.each_fwd([&](const TerrainNodeRequest& request) {
+                [[maybe_unused]] const auto mesh = generate_terrain_node_mesh(config,
+                                                                              request.node,
+                                                                              tile_size,
+                                                                              lod_settings.min_terrain_height,
+                                                                              lod_settings.max_terrain_height,
+                                                                              skirt_depth);
+            });
+            meshing_timer.stop();
+
+            auto result = TerrainLodBenchmarkResult{.tile_distance = tile_distance,
+                                                    .stats = get_terrain_lod_stats(selection, tile_size, lod_settings.num_levels),
+                                                    .selection_ms = selection_timer.elapsed().total_seconds() * 1000.0,
+                                                    .meshing_ms = meshing_timer.elapsed().total_seconds() * 1000.0};
+
+            logger->info("View distance of %d tiles: %u nodes, %llu triangles (%llu at full res), selected in %f ms, meshed in %f ms",
+                         tile_distance,
+                         result.stats.num_nodes,
+                         result.stats.num_triangles,
+                         result.stats.num_full_resolution_triangles,
+                         result.selection_ms,
+                         result.meshing_ms);
+
+            for(Size level = 0; level < result.stats.num_nodes_per_level.size(); level++) {
+                logger->info("\tLevel %zu: %u nodes", level, result.stats.num_nodes_per_level[level]);
+            }
+
+            results.push_back(Rx::Utility::move(result));
+        });
+
+        return results;
+    }
+
+    Rx::Vector<ErosionBenchmarkResult> benchmark_hydraulic_erosion(const NoiseConfig& config,
+                                                                   const Rx::Vector<Vec2u>& world_sizes,
+                                                                   const Uint32 num_iterations,
+                                                                   const Rx::Vector<Uint32>& thread_counts,
+                                                                   const Float32 min_height,
+                                                                   const Float32 max_height) {
+        ZoneScoped;
+
+        Rx::Vector<ErosionBenchmarkResult> results;
+        results.reserve(world_sizes.size() * thread_counts.size());
+
+        const auto noise_generator = config.create_generator();
+        const auto settings = HydraulicErosionSettings{.seed = static_cast<Uint32>(config.seed), .num_iterations = num_iterations};
+
+        world_sizes.each_fwd([&](const Vec2u& world_size) {
+            const auto num_heights = static_cast<Size>(world_size.x) * world_size.y;
+
+            // Lay the heights out like Terrain::generate_heightmap does, in rows of `world_size.x` heights
+            Rx::Vector<Float32> heightmap{num_heights};
+            auto* noise = noise_generator->GetNoiseSet(0, 0, 0, static_cast<Int32>(world_size.y), static_cast<Int32>(world_size.x), 1);
+            for(Size i = 0; i < num_heights; i++) {
+                heightmap[i] = min_height + noise[i] * (max_height - min_height);
+            }
+            FastNoiseSIMD::FreeNoiseSet(noise);
+
+            Rx::Vector<Float32> first_run_heights;
+
+            thread_counts.each_fwd([&](const Uint32 num_threads) {
+                auto eroded_heightmap = heightmap;
+
+                Rx::Time::StopWatch timer;
+                timer.start();
+                erode_heightmap({eroded_heightmap.data(), num_heights}, world_size.x, world_size.y, settings, num_threads);
+                timer.stop();
+
+                auto result = ErosionBenchmarkResult{.world_size = world_size,
+                                                     .num_threads = num_threads,
+                                                     .num_iterations = num_iterations,
+                                                     .seconds = timer.elapsed().total_seconds()};
+                result.iterations_per_second = static_cast<double>(num_iterations) / result.seconds;
+
+                if(first_run_heights.is_empty()) {
+                    first_run_heights = Rx::Utility::move(eroded_heightmap);
+                } else {
+                    const auto num_bytes = num_heights * sizeof(Float32);
+                    result.matches_first_run = memcmp(first_run_heights.data(), eroded_heightmap.data(), num_bytes) == 0;
+                }
+
+                logger->info("Eroded a %ux%u heightmap %u times on %u threads in %f seconds (%f iterations/second)",
+                             world_size.x,
+                             world_size.y,
+                             num_iterations,
+                             num_threads,
+                             result.seconds,
+                             result.iterations_per_second);
+                if(!result.matches_first_run) {
+                    logger->error("Eroding a %ux%u heightmap on %u threads gave different heights than on %u threads",
+                                  world_size.x,
+                                  world_size.y,
+                                  num_threads,
+                                  thread_counts[0]);
+                }
+
+                results.push_back(result);
+            });
+        });
+
+        return results;
+    }
+
+    Rx::Vector<WaterSimulationBenchmarkResult> benchmark_water_simulation(const NoiseConfig& config,
+                                                                          const Uint32 tile_size,
+                                                                          const Uint32 tiles_per_side,
+                                                                          const Uint32 num_steps,
+                                                                          const Rx::Vector<Uint32>& thread_counts,
+                                                                          const Float32 min_height,
+                                                                          const Float32 max_height) {
+        ZoneScoped;
+
+        Rx::Vector<WaterSimulationBenchmarkResult> results;
+        results.reserve(thread_counts.size());
+
+        const auto num_tiles = tiles_per_side * tiles_per_side;
+        const auto num_cells_per_tile = static_cast<Size>(tile_size) * tile_size;
+
+        // Tiles have one more row and column than they have cells, like the terrain's tile heightmaps
+        HeightmapTilePool heightmap_pool{tile_size + 1};
+
+        Rx::Vector<TileHeightmap> heightmaps;
+        Rx::Vector<Rx::Vector<Float32>> initial_depths;
+        heightmaps.reserve(num_tiles);
+        initial_depths.reserve(num_tiles);
+
+        const auto water_level = (min_height + max_height) * 0.5f;
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            const auto tile_x = i % tiles_per_side;
+            const auto tile_y = i / tiles_per_side;
+
+            auto heightmap = heightmap_pool.allocate();
+            fill_tile_heightmap(config,
+                                Vec2i{static_cast<Int32>(tile_x), static_cast<Int32>(tile_y)} * static_cast<Int32>(tile_size),
+                                heightmap,
+                                min_height,
+                                max_height);
+            heightmaps.push_back(heightmap);
+
+            Rx::Vector<Float32> depths{num_cells_per_tile};
+            if(tile_x < tiles_per_side / 2) {
+                for(Uint32 y = 0; y < tile_size; y++) {
+                    for(Uint32 x = 0; x < tile_size; x++) {
+                        depths[y * tile_size + x] = Rx::Algorithm::max(water_level - heightmap.at(x, y), 0.0f);
+                    }
+                }
+            }
+            initial_depths.push_back(Rx::Utility::move(depths));
+        }
+
+        Rx::Vector<Float32> first_run_depths;
+
+        thread_counts.each_fwd([&](const Uint32 num_threads) {
+            TerrainWaterSimulation simulation{tile_size, TerrainWaterSettings{}, num_threads};
+            for(Uint32 i = 0; i < num_tiles; i++) {
+                const auto coord = Vec2i{static_cast<Int32>(i % tiles_per_side), static_cast<Int32>(i / tiles_per_side)};
+                simulation.add_tile(coord,
+                                    heightmaps[i].get_heights(),
+                                    heightmaps[i].size,
+                                    {initial_depths[i].data(), initial_depths[i].size()});
+            }
+
+            auto result = WaterSimulationBenchmarkResult{.num_threads = num_threads, .num_tiles = num_tiles, .num_steps = num_steps};
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+            for(Uint32 step = 0; step < num_steps; step++) {
+                result.num_cells_updated += static_cast<Uint64>(simulation.step()) * num_cells_per_tile;
+            }
+            timer.stop();
+
+            result.milliseconds = timer.elapsed().total_seconds() * 1000.0;
+            result.cells_per_millisecond = static_cast<double>(result.num_cells_updated) / result.milliseconds;
+            result.num_awake_tiles = simulation.get_num_awake_tiles();
+
+            simulation.publish();
+            Rx::Vector<Float32> depths;
+            depths.reserve(num_tiles * num_cells_per_tile);
+            for(Uint32 i = 0; i < num_tiles; i++) {
+                const auto* tile_depths = simulation.get_published_depths(
+                    Vec2i{static_cast<Int32>(i % tiles_per_side), static_cast<Int32>(i / tiles_per_side)});
+                for(Size cell = 0; cell < num_cells_per_tile; cell++) {
+                    depths.push_back(tile_depths[cell]);
+                }
+            }
+
+            if(first_run_depths.is_empty()) {
+                first_run_depths = Rx::Utility::move(depths);
+            } else {
+                result.matches_first_run = memcmp(first_run_depths.data(), depths.data(), depths.size() * sizeof(Float32)) == 0;
+            }
+
+            logger->info("Simulated water on %u %ux%u tiles for %u steps on %u threads in %f ms (%f cells/ms, %u tiles still awake)",
+                         num_tiles,
+                         tile_size,
+                         tile_size,
+                         num_steps,
+                         num_threads,
+                         result.milliseconds,
+                         result.cells_per_millisecond,
+                         result.num_awake_tiles);
+            if(!result.matches_first_run) {
+                logger->error("Simulating water on %u threads gave different depths than on %u threads", num_threads, thread_counts[0]);
+            }
+
+            results.push_back(result);
+        });
+
+        heightmaps.each_fwd([&](const TileHeightmap& heightmap) { heightmap_pool.free(heightmap); });
+
+        return results;
+    }
+
+    /*!
+     * \brief Counts the pairs of objects that are closer than their footprints allow. Objects in the scattering benchmark use their
+     * footprint class as their mesh ID
+     */
+    static Uint32 count_overlapping_instances(Rx::Vector<environment::EnvironmentObjectInstance> instances) {
+        using environment::EnvironmentObjectInstance;
+
+        std::sort(instances.data(),
+                  instances.data() + instances.size(),
+                  [](const EnvironmentObjectInstance& a, const EnvironmentObjectInstance& b) { return a.location.x < b.location.x; });
+
+        const auto max_diameter = environment::get_footprint_diameter(environment::FootprintClass::TenMeters);
+
+        Uint32 num_overlaps = 0;
+        for(Size i = 0; i < instances.size(); i++) {
+            const auto& instance = instances[i];
+            const auto diameter = environment::get_footprint_diameter(static_cast<environment::FootprintClass>(instance.mesh_id));
+
+            for(Size j = i + 1; j < instances.size() && instances[j].location.x - instance.location.x < max_diameter; j++) {
+                const auto& other = instances[j];
+                const auto other_diameter = environment::get_footprint_diameter(static_cast<environment::FootprintClass>(other.mesh_id));
+                const auto min_distance = instance.mesh_id == other.mesh_id ? diameter : (diameter + other_diameter) * 0.5f;
+
+                const auto offset_x = other.location.x - instance.location.x;
+                const auto offset_z = other.location.z - instance.location.z;
+                if(offset_x * offset_x + offset_z * offset_z < min_distance * min_distance) {
+                    num_overlaps++;
+                }
+            }
+        }
+
+        return num_overlaps;
+    }
+
+    Rx::Vector<EnvironmentScatteringBenchmarkResult> benchmark_environment_scattering(const NoiseConfig& config,
+                                                                                      const Uint32 tile_size,
+                                                                                      const Uint32 tiles_per_side,
+                                                                                      const Rx::Vector<Uint32>& thread_counts,
+                                                                                      const Float32 min_height,
+                                                                                      const Float32 max_height) {
+        ZoneScoped;
+
+        Rx::Vector<EnvironmentScatteringBenchmarkResult> results;
+        results.reserve(thread_counts.size());
+
+        const auto num_tiles = tiles_per_side * tiles_per_side;
+
+        HeightmapTilePool heightmap_pool{tile_size + 1};
+
+        Rx::Vector<TileHeightmap> heightmaps;
+        heightmaps.reserve(num_tiles);
+        for(Uint32 i = 0; i < num_tiles; i++) {
+            auto heightmap = heightmap_pool.allocate();
+            fill_tile_heightmap(config,
+                                Vec2i{static_cast<Int32>(i % tiles_per_side), static_cast<Int32>(i / tiles_per_side)} *
+                                    static_cast<Int32>(tile_size),
+                                heightmap,
+                                min_height,
+                                max_height);
+            heightmaps.push_back(heightmap);
+        }
+
+        Rx::Vector<environment::ScatterObject> objects;
+        for(Uint32 footprint_class = 0; footprint_class < environment::NUM_FOOTPRINT_CLASSES; footprint_class++) {
+            objects.push_back(environment::ScatterObject{.footprint_class = static_cast<environment::FootprintClass>(footprint_class),
+                                                         .density = 0.5f,
+                                                         .mesh_id = footprint_class});
+        }
+
+        const auto settings = environment::ScatterSettings{.seed = static_cast<Uint64>(config.seed), .tile_size = tile_size};
+
+        Rx::Vector<environment::EnvironmentObjectInstance> first_run_instances;
+
+        thread_counts.each_fwd([&](const Uint32 num_threads) {
+            Rx::Vector<Rx::Vector<environment::EnvironmentObjectInstance>> tile_instances{num_tiles};
+
+            Rx::Concurrency::ThreadPool pool{num_threads, num_tiles};
+            Rx::Concurrency::WaitGroup tiles_finished{num_tiles};
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            for(Uint32 i = 0; i < num_tiles; i++) {
+                pool.add([&, i](int /* thread_id */) {
+                    tile_instances[i] = environment::scatter_objects_in_tile(
+                        settings,
+                        {objects.data(), objects.size()},
+                        nullptr,
+                        Vec2i{static_cast<Int32>(i % tiles_per_side), static_cast<Int32>(i / tiles_per_side)},
+                        heightmaps[i].get_heights(),
+                        heightmaps[i].size);
+
+                    tiles_finished.signal();
+                });
+            }
+
+            tiles_finished.wait();
+
+            timer.stop();
+
+            Rx::Vector<environment::EnvironmentObjectInstance> instances;
+            tile_instances.each_fwd([&](const Rx::Vector<environment::EnvironmentObjectInstance>& tile) {
+                tile.each_fwd([&](const environment::EnvironmentObjectInstance& instance) { instances.push_back(instance); });
+            });
+
+            auto result = EnvironmentScatteringBenchmarkResult{.num_threads = num_threads,
+                                                               .num_tiles = num_tiles,
+                                                               .num_instances = instances.size(),
+                                                               .milliseconds = timer.elapsed().total_seconds() * 1000.0};
+            result.instances_per_millisecond = static_cast<double>(result.num_instances) / result.milliseconds;
+
+            if(first_run_instances.is_empty()) {
+                result.num_overlaps = count_overlapping_instances(instances);
+                first_run_instances = Rx::Utility::move(instances);
+            } else {
+                result.num_overlaps = results[0].num_overlaps;
+                result.matches_first_run = instances.size() == first_run_instances.size() &&
+                                           memcmp(instances.data(),
+                                                  first_run_instances.data(),
+                                                  instances.size() * sizeof(environment::EnvironmentObjectInstance)) == 0;
+            }
+
+            logger->info("Placed %zu environment objects on %u %ux%u tiles on %u threads in %f ms (%f objects/ms, %u overlaps)",
+                         result.num_instances,
+                         num_tiles,
+                         tile_size,
+                         tile_size,
+                         num_threads,
+                         result.milliseconds,
+                         result.instances_per_millisecond,
+                         result.num_overlaps);
+            if(!result.matches_first_run) {
+                logger->error("Placing environment objects on %u threads gave different objects than on %u threads",
+                              num_threads,
+                              thread_counts[0]);
+            }
+
+            results.push_back(result);
+        });
+
+        heightmaps.each_fwd([&](const TileHeightmap& heightmap) { heightmap_pool.free(heightmap); });
+
+        return results;
+    }
+
+    static const char* to_string(const DistanceTransformMethod method) {
+        return method == DistanceTransformMethod::Exact ? "exact" : "chamfer";
+    }
+
+    /*!
+     * \brief Checks exact distances against a brute-force search of the seeds around a sample of texels
+     *
+     * Each sampled texel searches the square that its distance fits in, so texels that are far from every seed get skipped
+     *
+     * \return The largest difference between the distances and the brute-force distances, in texels
+     */
+    static Float32 check_distances_by_brute_force(const Rx::Vector<Uint8>& seeds,
+                                                  const Rx::Vector<Float32>& distances,
+                                                  const Uint32 width,
+                                                  const Uint32 depth) {
+        constexpr Uint32 NUM_SAMPLES = 4096;
+        constexpr Float32 MAX_SEARCH_RADIUS = 64;
+
+        Float32 max_error = 0;
+        const auto stride = Rx::Algorithm::max(seeds.size() / NUM_SAMPLES, static_cast<Size>(1));
+        for(Size texel = stride / 2; texel < seeds.size(); texel += stride) {
+            if(distances[texel] > MAX_SEARCH_RADIUS) {
+                continue;
+            }
+
+            const auto x = static_cast<Int32>(texel % width);
+            const auto z = static_cast<Int32>(texel / width);
+            const auto radius = static_cast<Int32>(std::ceil(distances[texel])) + 1;
+
+            auto closest_squared = std::numeric_limits<Int32>::max();
+            for(auto seed_z = Rx::Algorithm::max(z - radius, 0); seed_z <= Rx::Algorithm::min(z + radius, static_cast<Int32>(depth) - 1);
+                seed_z++) {
+                for(auto seed_x = Rx::Algorithm::max(x - radius, 0);
+                    seed_x <= Rx::Algorithm::min(x + radius, static_cast<Int32>(width) - 1);
+                    seed_x++) {
+                    if(seeds[static_cast<Size>(seed_z) * width + seed_x] != 0) {
+                        const auto squared = (seed_x - x) * (seed_x - x) + (seed_z - z) * (seed_z - z);
+                        closest_squared = Rx::Algorithm::min(closest_squared, squared);
+                    }
+                }
+            }
+
+            const auto brute_force_distance = std::sqrt(static_cast<Float32>(closest_squared));
+            max_error = Rx::Algorithm::max(max_error, std::abs(brute_force_distance - distances[texel]));
+        }
+
+        return max_error;
+    }
+
+    static Float32 get_max_difference(const Rx::Vector<Float32>& distances, const Rx::Vector<Float32>& exact_distances) {
+        Float32 max_difference = 0;
+        for(Size i = 0; i < distances.size(); i++) {
+            max_difference = Rx::Algorithm::max(max_difference, std::abs(distances[i] - exact_distances[i]));
+        }
+
+        return max_difference;
+    }
+
+    Rx::Vector<DistanceTransformBenchmarkResult> benchmark_distance_transforms(const NoiseConfig& config,
+                                                                              const Rx::Vector<Vec2u>& world_sizes,
+                                                                              const Rx::Vector<Uint32>& thread_counts,
+                                                                              const Uint32 tile_size,
+                                                                              const Uint32 apron) {
+        ZoneScoped;
+
+        Rx::Vector<DistanceTransformBenchmarkResult> results;
+        results.reserve(world_sizes.size() * (thread_counts.size() + 3));
+
+        const auto noise_generator = config.create_generator();
+
+        const auto log_result = [&](const DistanceTransformBenchmarkResult& result) {
+            if(result.tile_size > 0) {
+                logger->info("Transformed a %ux%u map as %ux%u tiles with %u apron texels with the %s transform in %f ms (%f texels/ms, "
+                             "max error %f)",
+                             result.world_size.x,
+                             result.world_size.y,
+                             result.tile_size,
+                             result.tile_size,
+                             apron,
+                             to_string(result.method),
+                             result.milliseconds,
+                             result.texels_per_millisecond,
+                             result.max_error);
+            } else {
+                logger->info("Transformed a %ux%u map with the %s transform on %u threads in %f ms (%f texels/ms, max error %f)",
+                             result.world_size.x,
+                             result.world_size.y,
+                             to_string(result.method),
+                             result.num_threads,
+                             result.milliseconds,
+                             result.texels_per_millisecond,
+                             result.max_error);
+            }
+        };
+
+        world_sizes.each_fwd([&](const Vec2u& world_size) {
+            const auto num_texels = static_cast<Size>(world_size.x) * world_size.y;
+
+            Rx::Vector<Uint8> seeds{num_texels};
+            auto* noise = noise_generator->GetNoiseSet(0, 0, 0, static_cast<Int32>(world_size.y), static_cast<Int32>(world_size.x), 1);
+            for(Size i = 0; i < num_texels; i++) {
+                seeds[i] = noise[i] < 0 ? 1 : 0;
+            }
+            FastNoiseSIMD::FreeNoiseSet(noise);
+
+            const auto make_result = [&](const DistanceTransformMethod method, const Uint32 num_threads, const Rx::Time::StopWatch& timer) {
+                auto result = DistanceTransformBenchmarkResult{.world_size = world_size,
+                                                               .method = method,
+                                                               .num_threads = num_threads,
+                                                               .milliseconds = timer.elapsed().total_seconds() * 1000.0};
+                result.texels_per_millisecond = static_cast<double>(num_texels) / result.milliseconds;
+                return result;
+            };
+
+            Rx::Vector<Float32> exact_distances;
+
+            thread_counts.each_fwd([&](const Uint32 num_threads) {
+                Rx::Time::StopWatch timer;
+                timer.start();
+                auto distances = compute_distance_field({seeds.data(), num_texels},
+                                                        world_size.x,
+                                                        world_size.y,
+                                                        DistanceTransformSettings{.num_threads = num_threads});
+                timer.stop();
+
+                auto result = make_result(DistanceTransformMethod::Exact, num_threads, timer);
+                if(exact_distances.is_empty()) {
+                    result.max_error = check_distances_by_brute_force(seeds, distances, world_size.x, world_size.y);
+                    exact_distances = Rx::Utility::move(distances);
+                } else {
+                    result.max_error = get_max_difference(distances, exact_distances);
+                }
+
+                log_result(result);
+                results.push_back(result);
+            });
+
+            if(exact_distances.is_empty()) {
+                exact_distances = compute_distance_field({seeds.data(), num_texels}, world_size.x, world_size.y, {});
+            }
+
+            {
+                Rx::Time::StopWatch timer;
+                timer.start();
+                const auto distances = compute_distance_field({seeds.data(), num_texels},
+                                                              world_size.x,
+                                                              world_size.y,
+                                                              DistanceTransformSettings{.method = DistanceTransformMethod::Chamfer});
+                timer.stop();
+
+                auto result = make_result(DistanceTransformMethod::Chamfer, 1, timer);
+                result.max_error = get_max_difference(distances, exact_distances);
+
+                log_result(result);
+                results.push_back(result);
+            }
+
+            // Tiles that would need seeds from off the map get left out, so every tile has a full apron
+            const auto padded_size = tile_size + apron * 2;
+            if(tile_size == 0 || world_size.x < padded_size || world_size.y < padded_size) {
+                return;
+            }
+
+            const auto num_tiles_x = (world_size.x - apron * 2) / tile_size;
+            const auto num_tiles_z = (world_size.y - apron * 2) / tile_size;
+            const auto num_tile_texels = static_cast<Size>(num_tiles_x) * num_tiles_z * tile_size * tile_size;
+
+            Rx::Vector<Uint8> tile_seeds{static_cast<Size>(padded_size) * padded_size};
+
+            for(const auto method : {DistanceTransformMethod::Exact, DistanceTransformMethod::Chamfer}) {
+                Float32 max_error = 0;
+                double seconds = 0;
+
+                for(Uint32 tile_z = 0; tile_z < num_tiles_z; tile_z++) {
+                    for(Uint32 tile_x = 0; tile_x < num_tiles_x; tile_x++) {
+                        for(Uint32 z = 0; z < padded_size; z++) {
+                            memcpy(&tile_seeds[static_cast<Size>(z) * padded_size],
+                                   &seeds[static_cast<Size>(tile_z * tile_size + z) * world_size.x + tile_x * tile_size],
+                                   padded_size);
+                        }
+
+                        Rx::Time::StopWatch timer;
+                        timer.start();
+                        const auto distances = compute_tile_distance_field({tile_seeds.data(), tile_seeds.size()},
+                                                                           tile_size,
+                                                                           apron,
+                                                                           method);
+                        timer.stop();
+                        seconds += timer.elapsed().total_seconds();
+
+                        for(Uint32 z = 0; z < tile_size; z++) {
+                            const auto world_z = tile_z * tile_size + apron + z;
+                            for(Uint32 x = 0; x < tile_size; x++) {
+                                const auto world_x = tile_x * tile_size + apron + x;
+                                const auto world_texel = static_cast<Size>(world_z) * world_size.x + world_x;
+                                const auto exact_distance = Rx::Algorithm::min(exact_distances[world_texel], static_cast<Float32>(apron));
+                                const auto distance = distances[static_cast<Size>(z) * tile_size + x];
+                                max_error = Rx::Algorithm::max(max_error, std::abs(distance - exact_distance));
+                            }
+                        }
+                    }
+                }
+
+                auto result = DistanceTransformBenchmarkResult{.world_size = world_size,
+                                                               .tile_size = tile_size,
+                                                               .method = method,
+                                                               .num_threads = 1,
+                                                               .milliseconds = seconds * 1000.0,
+                                                               .max_error = max_error};
+                result.texels_per_millisecond = static_cast<double>(num_tile_texels) / result.milliseconds;
+
+                log_result(result);
+                results.push_back(result);
+            }
+        });
+
+        return results;
+    }
+
+    static const char* to_string(const VoxelMeshingMethod method) { return method == VoxelMeshingMethod::Greedy ? "greedy" : "naive"; }
+
+    /*!
+     * \brief Marks the voxel faces that a chunk mesh covers
+     *
+     * \param coverage One entry for each face of each voxel in the chunk, face by face. Each entry is one more than the material of the
+     * quad that covers the face, or 0 if no quad covers it, or UINT16_MAX if more than one quad covers it
+     */
+    static void get_chunk_mesh_coverage(const VoxelChunkMesh& mesh, Rx::Vector<Uint16>& coverage) {
+        for(Size i = 0; i < coverage.size(); i++) {
+            coverage[i] = 0;
+        }
+
+        for(Size quad = 0; quad < mesh.get_num_quads(); quad++) {
+            const auto face = get_chunk_vertex_face(mesh.vertices[quad * 4]);
+            const auto material = get_chunk_vertex_material(mesh.vertices[quad * 4]);
+            const auto axis = static_cast<Uint32>(face) / 2;
+
+            auto min_corner = get_chunk_vertex_position(mesh.vertices[quad * 4]);
+            auto max_corner = min_corner;
+            for(Size corner = 1; corner < 4; corner++) {
+                const auto position = get_chunk_vertex_position(mesh.vertices[quad * 4 + corner]);
+                for(Uint32 i = 0; i < 3; i++) {
+                    min_corner[i] = Rx::Algorithm::min(min_corner[i], position[i]);
+                    max_corner[i] = Rx::Algorithm::max(max_corner[i], position[i]);
+                }
+            }
+
+            // The quad lies on the far side of its voxels for positive faces
+            if(static_cast<Uint32>(face) % 2 == 0) {
+                min_corner[axis]--;
+            }
+            max_corner[axis] = min_corner[axis] + 1;
+
+            for(auto y = min_corner.y; y < max_corner.y; y++) {
+                for(auto z = min_corner.z; z < max_corner.z; z++) {
+                    for(auto x = min_corner.x; x < max_corner.x; x++) {
+                        auto& entry = coverage[static_cast<Size>(face) * VoxelChunk::NUM_VOXELS + VoxelChunk::get_voxel_index(x, y, z)];
+                        entry = entry == 0 ? static_cast<Uint16>(material + 1) : UINT16_MAX;
+                    }
+                }
+            }
+        }
+    }
+
+    static void log_result(const VoxelMeshingBenchmarkResult& result) {
+        logger->info("Meshed %u voxel chunks (%u with visible faces) with the %s mesher on %u threads in %f ms (%f chunks/ms): %llu "
+                     "triangles, %f triangles/chunk, %zu bytes of vertices",
+                     result.num_chunks,
+                     result.num_meshed_chunks,
+                     to_string(result.method),
+                     result.num_threads,
+                     result.milliseconds,
+                     result.chunks_per_millisecond,
+                     static_cast<unsigned long long>(result.num_triangles),
+                     result.triangles_per_chunk,
+                     result.num_vertex_bytes);
+        if(!result.matches_naive_faces) {
+            logger->error("The %s mesher on %u threads didn't cover the same faces as the naive mesher",
+                          to_string(result.method),
+                          result.num_threads);
+        }
+    }
+
+    /*!
+     * \brief Fills in a meshing result's totals from the chunks' meshes
+     */
+    static void count_chunk_meshes(VoxelMeshingBenchmarkResult& result, const Rx::Vector<VoxelChunkMesh>& meshes) {
+        meshes.each_fwd([&](const VoxelChunkMesh& mesh) {
+            if(mesh.vertices.is_empty()) {
+                return;
+            }
+
+            result.num_meshed_chunks++;
+            result.num_triangles += mesh.get_num_triangles();
+            result.num_vertex_bytes += mesh.vertices.size() * sizeof(ChunkVertex);
+        });
+
+        result.chunks_per_millisecond = static_cast<double>(result.num_chunks) / result.milliseconds;
+        result.triangles_per_chunk = result.num_meshed_chunks > 0 ?
+                                         static_cast<double>(result.num_triangles) / static_cast<double>(result.num_meshed_chunks) :
+                                         0.0;
+    }
+
+    VoxelMeshingBenchmarkResults benchmark_voxel_meshing(const NoiseConfig& config,
+                                                         const Uint32 chunks_per_side,
+                                                         const Rx::Vector<Uint32>& thread_counts,
+                                                         const Float32 min_height,
+                                                         const Float32 max_height,
+                                                         const Float32 sea_level) {
+        ZoneScoped;
+
+        constexpr auto chunk_size = static_cast<Int32>(VoxelChunk::SIZE);
+
+        VoxelMeshingBenchmarkResults results;
+
+        // Stack enough chunks on each column to hold every height the terrain can have
+        const auto lowest_chunk_y = static_cast<Int32>(std::floor(min_height / chunk_size));
+        const auto highest_chunk_y = static_cast<Int32>(std::floor(max_height / chunk_size));
+
+        Rx::Vector<Vec3i> coords;
+        Rx::Vector<VoxelChunk> chunks;
+        Rx::Map<Vec3i, Size> chunk_indices;
+
+        HeightmapTilePool heightmap_pool{VoxelChunk::SIZE};
+        auto heightmap = heightmap_pool.allocate();
+        for(Uint32 column = 0; column < chunks_per_side * chunks_per_side; column++) {
+            const auto column_coord = Vec2i{static_cast<Int32>(column % chunks_per_side), static_cast<Int32>(column / chunks_per_side)};
+            fill_tile_heightmap(config, column_coord * chunk_size, heightmap, min_height, max_height);
+
+            for(auto chunk_y = lowest_chunk_y; chunk_y <= highest_chunk_y; chunk_y++) {
+                const auto coord = Vec3i{column_coord.x, chunk_y, column_coord.y};
+                chunk_indices.insert(coord, chunks.size());
+                coords.push_back(coord);
+                chunks.push_back(generate_voxel_chunk(heightmap.get_heights(), heightmap.size, chunk_y, sea_level));
+
+                results.num_chunk_bytes += chunks.last().get_num_bytes();
+                results.num_uncompressed_chunk_bytes += VoxelChunk::NUM_VOXELS * sizeof(VoxelMaterial);
+            }
+        }
+        heightmap_pool.free(heightmap);
+
+        const auto num_chunks = static_cast<Uint32>(chunks.size());
+
+        logger->info("Generated %u voxel chunks. Their palettes and indices take %zu bytes, instead of %zu bytes as plain arrays",
+                     num_chunks,
+                     results.num_chunk_bytes,
+                     results.num_uncompressed_chunk_bytes);
+
+        Rx::Vector<VoxelChunkNeighbours> neighbours{num_chunks};
+        for(Uint32 i = 0; i < num_chunks; i++) {
+            for(Uint32 face = 0; face < NUM_VOXEL_FACES; face++) {
+                if(const auto* index = chunk_indices.find(coords[i] + get_voxel_face_offset(static_cast<VoxelFace>(face)));
+                   index != nullptr) {
+                    neighbours[i].chunks[face] = &chunks[*index];
+                }
+            }
+        }
+
+        // Mesh everything on this thread with both meshers, so they can be compared directly
+        Rx::Vector<VoxelChunkMesh> naive_meshes{num_chunks};
+        Rx::Vector<VoxelChunkMesh> greedy_meshes{num_chunks};
+        for(const auto method : {VoxelMeshingMethod::Naive, VoxelMeshingMethod::Greedy}) {
+            auto& meshes = method == VoxelMeshingMethod::Naive ? naive_meshes : greedy_meshes;
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            for(Uint32 i = 0; i < num_chunks; i++) {
+                meshes[i] = mesh_voxel_chunk(chunks[i], neighbours[i], method);
+            }
+
+            timer.stop();
+
+            auto result = VoxelMeshingBenchmarkResult{.method = method,
+                                                      .num_threads = 1,
+                                                      .num_chunks = num_chunks,
+                                                      .milliseconds = timer.elapsed().total_seconds() * 1000.0};
+            count_chunk_meshes(result, meshes);
+
+            if(method == VoxelMeshingMethod::Greedy) {
+                Rx::Vector<Uint16> naive_coverage{static_cast<Size>(NUM_VOXEL_FACES) * VoxelChunk::NUM_VOXELS};
+                Rx::Vector<Uint16> greedy_coverage{static_cast<Size>(NUM_VOXEL_FACES) * VoxelChunk::NUM_VOXELS};
+                for(Uint32 i = 0; i < num_chunks && result.matches_naive_faces; i++) {
+                    get_chunk_mesh_coverage(naive_meshes[i], naive_coverage);
+                    get_chunk_mesh_coverage(greedy_meshes[i], greedy_coverage);
+                    result.matches_naive_faces = memcmp(naive_coverage.data(),
+                                                        greedy_coverage.data(),
+                                                        naive_coverage.size() * sizeof(Uint16)) == 0;
+                }
+            }
+
+            log_result(result);
+            results.runs.push_back(result);
+        }
+
+        const auto greedy_matches_naive_faces = results.runs.last().matches_naive_faces;
+
+        Rx::Ptr<VoxelChunkStore> store;
+        thread_counts.each_fwd([&](const Uint32 num_threads) {
+            store = Rx::make_ptr<VoxelChunkStore>(RX_SYSTEM_ALLOCATOR, num_threads);
+            for(Uint32 i = 0; i < num_chunks; i++) {
+                store->add_chunk(coords[i], chunks[i]);
+            }
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            store->dispatch_remeshes();
+            [[maybe_unused]] const auto changed_chunks = store->wait_for_meshes();
+
+            timer.stop();
+
+            // The store's meshes should be exactly the same as the ones from this thread
+            Rx::Vector<VoxelChunkMesh> meshes{num_chunks};
+            auto matches_single_thread = true;
+            for(Uint32 i = 0; i < num_chunks; i++) {
+                meshes[i] = *store->get_mesh(coords[i]);
+                matches_single_thread = matches_single_thread && meshes[i].vertices.size() == greedy_meshes[i].vertices.size() &&
+                                        memcmp(meshes[i].vertices.data(),
+                                               greedy_meshes[i].vertices.data(),
+                                               meshes[i].vertices.size() * sizeof(ChunkVertex)) == 0;
+            }
+
+            auto result = VoxelMeshingBenchmarkResult{.method = VoxelMeshingMethod::Greedy,
+                                                      .num_threads = num_threads,
+                                                      .num_chunks = num_chunks,
+                                                      .milliseconds = timer.elapsed().total_seconds() * 1000.0,
+                                                      .matches_naive_faces = greedy_matches_naive_faces && matches_single_thread};
+            count_chunk_meshes(result, meshes);
+
+            log_result(result);
+            results.runs.push_back(result);
+        });
+
+        if(!store) {
+            return results;
+        }
+
+        // Dig a voxel out of the surface of columns spread over the whole square, then remesh only the chunks that the edits touched
+        constexpr Uint32 NUM_EDITS = 64;
+        const auto square_size = chunks_per_side * VoxelChunk::SIZE;
+        const auto top = (highest_chunk_y + 1) * chunk_size - 1;
+        const auto bottom = lowest_chunk_y * chunk_size;
+        for(Uint32 i = 0; i < NUM_EDITS; i++) {
+            const auto x = static_cast<Int32>((i * 7919u) % square_size);
+            const auto z = static_cast<Int32>((i * 104729u) % square_size);
+            for(auto y = top; y >= bottom; y--) {
+                if(store->get_voxel({x, y, z}) != VoxelMaterial::Air) {
+                    results.num_edits += store->set_voxel({x, y, z}, VoxelMaterial::Air) ? 1 : 0;
+                    break;
+                }
+            }
+        }
+
+        Rx::Time::StopWatch timer;
+        timer.start();
+
+        results.num_remeshed_chunks = store->dispatch_remeshes();
+        [[maybe_unused]] const auto changed_chunks = store->wait_for_meshes();
+
+        timer.stop();
+
+        results.remesh_milliseconds = timer.elapsed().total_seconds() * 1000.0;
+
+        logger->info("Dug %u voxels out of the surface, which remeshed %u of %u chunks in %f ms",
+                     results.num_edits,
+                     results.num_remeshed_chunks,
+                     num_chunks,
+                     results.remesh_milliseconds);
+
+        return results;
+    }
+
+    WorldSaveBenchmarkResults benchmark_world_save(const NoiseConfig& config,
+                                                   const Rx::String& directory,
+                                                   const Uint32 chunks_per_side,
+                                                   const Uint32 tile_size,
+                                                   const Float32 min_height,
+                                                   const Float32 max_height,
+                                                   const Float32 sea_level) {
+        ZoneScoped;
+
+        constexpr auto chunk_size = static_cast<Int32>(VoxelChunk::SIZE);
+
+        WorldSaveBenchmarkResults results;
+
+        std::error_code error;
+        std::filesystem::remove_all(directory.data(), error);
+
+        const auto lowest_chunk_y = static_cast<Int32>(std::floor(min_height / chunk_size));
+        const auto highest_chunk_y = static_cast<Int32>(std::floor(max_height / chunk_size));
+
+        Rx::Vector<Vec3i> chunk_coords;
+        Rx::Vector<VoxelChunk> chunks;
+        {
+            HeightmapTilePool heightmap_pool{VoxelChunk::SIZE};
+            auto heightmap = heightmap_pool.allocate();
+            for(Uint32 column = 0; column < chunks_per_side * chunks_per_side; column++) {
+                const auto column_coord = Vec2i{static_cast<Int32>(column % chunks_per_side),
+                                                static_cast<Int32>(column / chunks_per_side)};
+                fill_tile_heightmap(config, column_coord * chunk_size, heightmap, min_height, max_height);
+
+                for(auto chunk_y = lowest_chunk_y; chunk_y <= highest_chunk_y; chunk_y++) {
+                    chunk_coords.push_back(Vec3i{column_coord.x, chunk_y, column_coord.y});
+                    chunks.push_back(generate_voxel_chunk(heightmap.get_heights(), heightmap.size, chunk_y, sea_level));
+                }
+            }
+            heightmap_pool.free(heightmap);
+        }
+
+        // The tiles under the same square as the chunks
+        const auto tiles_per_side = (chunks_per_side * VoxelChunk::SIZE + tile_size - 1) / tile_size;
+        Rx::Vector<Vec2i> tile_coords;
+        Rx::Vector<Rx::Vector<Float32>> tile_heights;
+        {
+            HeightmapTilePool heightmap_pool{tile_size};
+            auto heightmap = heightmap_pool.allocate();
+            for(Uint32 tile = 0; tile < tiles_per_side * tiles_per_side; tile++) {
+                const auto tile_coord = Vec2i{static_cast<Int32>(tile % tiles_per_side), static_cast<Int32>(tile / tiles_per_side)};
+                fill_tile_heightmap(config, tile_coord * static_cast<Int32>(tile_size), heightmap, min_height, max_height);
+
+                const auto heights = heightmap.get_heights();
+                Rx::Vector<Float32> heights_copy{heights.size()};
+                memcpy(heights_copy.data(), heights.data(), heights.size_bytes());
+
+                tile_coords.push_back(tile_coord);
+                tile_heights.push_back(Rx::Utility::move(heights_copy));
+            }
+            heightmap_pool.free(heightmap);
+        }
+
+        results.num_chunks = static_cast<Uint32>(chunks.size());
+        results.num_tiles = static_cast<Uint32>(tile_heights.size());
+
+        const auto create_info = WorldSaveCreateInfo{.directory = directory, .tile_size = tile_size};
+        {
+            WorldSave save{create_info};
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            Rx::Vector<Byte> serialized_chunk;
+            for(Size i = 0; i < chunks.size(); i++) {
+                save.save_chunk(chunk_coords[i], chunks[i]);
+
+                serialized_chunk.clear();
+                chunks[i].serialize(serialized_chunk);
+                results.num_uncompressed_bytes += serialized_chunk.size();
+            }
+
+            for(Size i = 0; i < tile_heights.size(); i++) {
+                save.save_tile(tile_coords[i], {tile_heights[i].data(), tile_heights[i].size()});
+                results.num_uncompressed_bytes += tile_heights[i].size() * sizeof(Float32);
+            }
+
+            timer.stop();
+            results.save_milliseconds = timer.elapsed().total_seconds() * 1000.0;
+
+            Rx::Time::StopWatch flush_timer;
+            flush_timer.start();
+
+            Rx::Time::StopWatch dispatch_timer;
+            dispatch_timer.start();
+
+            results.num_region_files = save.flush_dirty_regions();
+
+            dispatch_timer.stop();
+            results.flush_dispatch_milliseconds = dispatch_timer.elapsed().total_seconds() * 1000.0;
+
+            save.wait_for_flushes();
+
+            flush_timer.stop();
+            results.flush_milliseconds = flush_timer.elapsed().total_seconds() * 1000.0;
+        }
+
+        for(const auto& entry : std::filesystem::directory_iterator{directory.data(), error}) {
+            if(entry.is_regular_file()) {
+                results.num_file_bytes += static_cast<Size>(entry.file_size());
+            }
+        }
+
+        {
+            WorldSave save{create_info};
+
+            Rx::Vector<VoxelMaterial> saved_voxels{VoxelChunk::NUM_VOXELS};
+            Rx::Vector<VoxelMaterial> loaded_voxels{VoxelChunk::NUM_VOXELS};
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            Rx::Vector<VoxelChunk> loaded_chunks;
+            loaded_chunks.reserve(chunks.size());
+            for(Size i = 0; i < chunks.size(); i++) {
+                auto chunk = save.load_chunk(chunk_coords[i]);
+                results.matches_saved_data = results.matches_saved_data && chunk.has_value();
+                loaded_chunks.push_back(chunk ? Rx::Utility::move(*chunk) : VoxelChunk{});
+            }
+
+            Rx::Vector<Rx::Vector<Float32>> loaded_tile_heights;
+            loaded_tile_heights.reserve(tile_heights.size());
+            for(Size i = 0; i < tile_heights.size(); i++) {
+                auto heights = save.load_tile(tile_coords[i]);
+                results.matches_saved_data = results.matches_saved_data && heights.has_value();
+                loaded_tile_heights.push_back(heights ? Rx::Utility::move(*heights) : Rx::Vector<Float32>{});
+            }
+
+            timer.stop();
+            results.load_milliseconds = timer.elapsed().total_seconds() * 1000.0;
+
+            for(Size i = 0; i < chunks.size() && results.matches_saved_data; i++) {
+                chunks[i].get_all({saved_voxels.data(), saved_voxels.size()});
+                loaded_chunks[i].get_all({loaded_voxels.data(), loaded_voxels.size()});
+                results.matches_saved_data = memcmp(saved_voxels.data(),
+                                                    loaded_voxels.data(),
+                                                    saved_voxels.size() * sizeof(VoxelMaterial)) == 0;
+            }
+
+            for(Size i = 0; i < tile_heights.size() && results.matches_saved_data; i++) {
+                results.matches_saved_data = loaded_tile_heights[i].size() == tile_heights[i].size() &&
+                                             memcmp(loaded_tile_heights[i].data(),
+                                                    tile_heights[i].data(),
+                                                    tile_heights[i].size() * sizeof(Float32)) == 0;
+            }
+        }
+
+        // Load a handful of chunks spread over the square from a save that has nothing open yet
+        constexpr Uint32 NUM_RANDOM_LOADS = 64;
+        {
+            WorldSave save{create_info};
+
+            Rx::Time::StopWatch timer;
+            timer.start();
+
+            for(Uint32 i = 0; i < NUM_RANDOM_LOADS; i++) {
+                [[maybe_unused]] const auto chunk = save.load_chunk(chunk_coords[(i * 7919u) % chunk_coords.size()]);
+            }
+
+            timer.stop();
+            results.random_load_microseconds = timer.elapsed().total_seconds() * 1000000.0 / NUM_RANDOM_LOADS;
+            results.num_random_load_regions = static_cast<Uint32>(save.get_num_open_regions());
+        }
+
+        std::filesystem::remove_all(directory.data(), error);
+
+        const auto megabytes = static_cast<double>(results.num_uncompressed_bytes) / (1024.0 * 1024.0);
+        const auto compression_ratio = static_cast<double>(results.num_uncompressed_bytes) /
+                                       static_cast<double>(Rx::Algorithm::max(results.num_file_bytes, Size{1}));
+        logger->info("Saved %u voxel chunks and %u terrain tiles in %f ms (%f MB/s). Compressed %zu bytes into %u region files with %zu "
+                     "bytes (%f:1)",
+                     results.num_chunks,
+                     results.num_tiles,
+                     results.save_milliseconds,
+                     megabytes / (results.save_milliseconds / 1000.0),
+                     results.num_uncompressed_bytes,
+                     results.num_region_files,
+                     results.num_file_bytes,
+                     compression_ratio);
+        logger->info("Starting the background writes took %f ms, and they finished after %f ms",
+                     results.flush_dispatch_milliseconds,
+                     results.flush_milliseconds);
+        logger->info("Loaded everything back in %f ms (%f MB/s). It %s what was saved",
+                     results.load_milliseconds,
+                     megabytes / (results.load_milliseconds / 1000.0),
+                     results.matches_saved_data ? "matches" : "DOES NOT match");
+        logger->info("Loading a single chunk from a fresh save took %f us on average, and opened %u regions for %u chunks",
+                     results.random_load_microseconds,
+                     results.num_random_load_regions,
+                     NUM_RANDOM_LOADS);
+
+        return results;
+    }
+} // namespace terraingen
@@ -0,0 +1,414 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+#include "world/generation/terrain_distance_transforms.hpp"
+#include "world/generation/terrain_noise.hpp"
+#include "world/terrain_lod.hpp"
+#include "world/voxel_meshing.hpp"
+
+namespace terraingen {
+    struct TileGenerationBenchmarkResult {
+        Uint32 num_threads{0};
+
+        Uint32 num_tiles{0};
+
+        double seconds{0};
+
+        double tiles_per_second{0};
+    };
+
+    /*!
+     * \brief Measures how quickly we can generate tile heightmaps with different numbers of worker threads
+     *
+     * Every run generates the same tiles, so the runs are directly comparable. Results get logged as well as returned
+     *
+     * \param config Noise settings to generate the tiles with
+     * \param tile_size Width and height of each tile, in heightmap texels
+     * \param num_tiles Number of tiles to generate in each run
+     * \param thread_counts The number of worker threads to use for each run
+     */
+    [[nodiscard]] Rx::Vector<TileGenerationBenchmarkResult> benchmark_tile_heightmap_generation(const NoiseConfig& config,
+                                                                                                Uint32 tile_size,
+                                                                                                Uint32 num_tiles,
+                                                                                                const Rx::Vector<Uint32>& thread_counts);
+
+    struct TerrainLodBenchmarkResult {
+        /*!
+         * \brief View distance, in tiles
+         */
+        Int32 tile_distance{0};
+
+        TerrainLodStats stats;
+
+        /*!
+         * \brief Time it took to select the quadtree nodes, in milliseconds
+         */
+        double selection_ms{0};
+
+        /*!
+         * \brief Time it took to mesh every selected node on one thread, in milliseconds
+         */
+        double meshing_ms{0};
+    };
+
+    /*!
+     * \brief Measures how many nodes and triangles the terrain quadtree selects at different view distances, and how long selecting and
+     * meshing them takes
+     *
+     * The view is at the origin, looking down the positive x axis. Results get logged as well as returned
+     *
+     * \param config Noise settings to mesh the nodes with
+     * \param lod_settings LOD settings to select the nodes with
+     * \param tile_size Width of a level 0 node, in meters
+     * \param tile_distances The view distance, in tiles, to use for each run
+     */
+    [[nodiscard]] Rx::Vector<TerrainLodBenchmarkResult> benchmark_terrain_lod(const NoiseConfig& config,
+                                                                              const TerrainLodSettings& lod_settings,
+                                                                              Uint32 tile_size,
+                                                                              const Rx::Vector<Int32>& tile_distances);
+
+    struct ErosionBenchmarkResult {
+        /*!
+         * \brief Size of the eroded heightmap, in texels
+         */
+        Vec2u world_size{};
+
+        Uint32 num_threads{0};
+
+        Uint32 num_iterations{0};
+
+        double seconds{0};
+
+        double iterations_per_second{0};
+
+        /*!
+         * \brief Whether this run eroded the heightmap to exactly the same heights as the first run at the same world size
+         */
+        bool matches_first_run{true};
+    };
+
+    /*!
+     * \brief Measures how many iterations of hydraulic erosion per second we can run on world heightmaps of different sizes with
+     * different numbers of worker threads
+     *
+     * Each world size gets a heightmap from the provided noise settings, and every thread count erodes a copy of that same heightmap. Runs
+     * that don't match the first run at their world size are reported, since erosion is supposed to be deterministic. Results get logged
+     * as well as returned
+     *
+     * \param config Noise settings to generate the heightmaps with
+     * \param world_sizes Width and height, in texels, of each heightmap to erode
+     * \param num_iterations Number of erosion iterations in each run
+     * \param thread_counts The number of worker threads to use for each run
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    [[nodiscard]] Rx::Vector<ErosionBenchmarkResult> benchmark_hydraulic_erosion(const NoiseConfig& config,
+                                                                                 const Rx::Vector<Vec2u>& world_sizes,
+                                                                                 Uint32 num_iterations,
+                                                                                 const Rx::Vector<Uint32>& thread_counts,
+                                                                                 Float32 min_height,
+                                                                                 Float32 max_height);
+
+    struct WaterSimulationBenchmarkResult {
+        Uint32 num_threads{0};
+
+        Uint32 num_tiles{0};
+
+        Uint32 num_steps{0};
+
+        /*!
+         * \brief Number of cells that were updated, summed over every step
+         */
+        Uint64 num_cells_updated{0};
+
+        double milliseconds{0};
+
+        double cells_per_millisecond{0};
+
+        /*!
+         * \brief Number of tiles that were still awake after the last step
+         */
+        Uint32 num_awake_tiles{0};
+
+        /*!
+         * \brief Whether this run ended with exactly the same water depths as the first run
+         */
+        bool matches_first_run{true};
+    };
+
+    /*!
+     * \brief Measures how many shallow-water cells per millisecond we can update with different numbers of worker threads
+     *
+     * Every run simulates a dam break on the same square of terrain tiles: the tiles in the left half start flooded up to the middle of
+     * the height range, and the rest start dry. Tiles wake up as the water reaches them and go back to sleep once it settles, so only the
+     * cells that were actually updated count. Runs that don't end with the same water as the first run are reported, since the simulation
+     * is supposed to be deterministic. Results get logged as well as returned
+     *
+     * \param config Noise settings to generate the terrain with
+     * \param tile_size Width of a tile, in cells
+     * \param tiles_per_side Number of tiles along each side of the square
+     * \param num_steps Number of simulation steps in each run
+     * \param thread_counts The number of worker threads to use for each run
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    [[nodiscard]] Rx::Vector<WaterSimulationBenchmarkResult> benchmark_water_simulation(const NoiseConfig& config,
+                                                                                        Uint32 tile_size,
+                                                                                        Uint32 tiles_per_side,
+                                                                                        Uint32 num_steps,
+                                                                                        const Rx::Vector<Uint32>& thread_counts,
+                                                                                        Float32 min_height,
+                                                                                        Float32 max_height);
+
+    struct EnvironmentScatteringBenchmarkResult {
+        Uint32 num_threads{0};
+
+        Uint32 num_tiles{0};
+
+        Size num_instances{0};
+
+        double milliseconds{0};
+
+        double instances_per_millisecond{0};
+
+        /*!
+         * \brief Number of pairs of objects that are closer than their footprints allow. Should always be 0, even across tile edges
+         */
+        Uint32 num_overlaps{0};
+
+        /*!
+         * \brief Whether this run placed exactly the same objects as the first run
+         */
+        bool matches_first_run{true};
+    };
+
+    /*!
+     * \brief Measures how many environment objects per millisecond we can place with different numbers of worker threads
+     *
+     * Every run places one object from each footprint class on the same square of terrain tiles, one tile per task. Each tile is placed
+     * on its own, like the terrain streamer does, and the benchmark checks that the objects don't overlap across the tile edges. Runs that
+     * don't place the same objects as the first run are reported, since placement is supposed to be deterministic. Results get logged as
+     * well as returned
+     *
+     * \param config Noise settings to generate the terrain with
+     * \param tile_size Width of a tile, in meters
+     * \param tiles_per_side Number of tiles along each side of the square
+     * \param thread_counts The number of worker threads to use for each run
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    [[nodiscard]] Rx::Vector<EnvironmentScatteringBenchmarkResult> benchmark_environment_scattering(const NoiseConfig& config,
+                                                                                                    Uint32 tile_size,
+                                                                                                    Uint32 tiles_per_side,
+                                                                                                    const Rx::Vector<Uint32>& thread_counts,
+                                                                                                    Float32 min_height,
+                                                                                                    Float32 max_height);
+
+    struct DistanceTransformBenchmarkResult {
+        /*!
+         * \brief Size of the map, in texels
+         */
+        Vec2u world_size{};
+
+        /*!
+         * \brief Width of the tiles that the map was split into, or 0 if the whole map was transformed at once
+         */
+        Uint32 tile_size{0};
+
+        DistanceTransformMethod method{DistanceTransformMethod::Exact};
+
+        Uint32 num_threads{0};
+
+        double milliseconds{0};
+
+        double texels_per_millisecond{0};
+
+        /*!
+         * \brief Largest difference from the exact distances, in texels. Exact runs on the whole map get checked against a brute-force
+         * search around a sample of texels instead. Tile runs get checked against the whole map's distances, clamped to the apron
+         */
+        Float32 max_error{0};
+    };
+
+    /*!
+     * \brief Measures how quickly the distance transforms run on maps of different sizes with different numbers of worker threads, and how
+     * far they are from the exact distances
+     *
+     * Each map gets seeds where the noise is below 0, like low ground filling with water. The exact transform runs once for each thread
+     * count and the chamfer transform runs once, on the whole map. Then the map gets split into tiles, which each get transformed on their
+     * own with an apron of their neighbours' seeds, like a streamed tile would be. Results get logged as well as returned
+     *
+     * \param config Noise settings to generate the seeds with
+     * \param world_sizes Width and height, in texels, of each map
+     * \param thread_counts The number of worker threads to use for each run of the exact transform
+     * \param tile_size Width of a tile, in texels
+     * \param apron Width of the apron around each tile, in texels
+     */
+    [[nodiscard]] Rx::Vector<DistanceTransformBenchmarkResult> benchmark_distance_transforms(const NoiseConfig& config,
+                                                                                            const Rx::Vector<Vec2u>& world_sizes,
+                                                                                            const Rx::Vector<Uint32>& thread_counts,
+                                                                                            Uint32 tile_size,
+                                                                                            Uint32 apron);
+
+    struct VoxelMeshingBenchmarkResult {
+        VoxelMeshingMethod method{VoxelMeshingMethod::Greedy};
+
+        Uint32 num_threads{0};
+
+        Uint32 num_chunks{0};
+
+        /*!
+         * \brief Number of chunks that have any visible faces
+         */
+        Uint32 num_meshed_chunks{0};
+
+        double milliseconds{0};
+
+        double chunks_per_millisecond{0};
+
+        Uint64 num_triangles{0};
+
+        /*!
+         * \brief Average number of triangles in the chunks that have any visible faces
+         */
+        double triangles_per_chunk{0};
+
+        Size num_vertex_bytes{0};
+
+        /*!
+         * \brief Whether every chunk's mesh covers exactly the same faces, with the same materials, as its naive mesh
+         */
+        bool matches_naive_faces{true};
+    };
+
+    struct VoxelMeshingBenchmarkResults {
+        Rx::Vector<VoxelMeshingBenchmarkResult> runs;
+
+        /*!
+         * \brief Number of bytes that the chunks' palettes and indices take
+         */
+        Size num_chunk_bytes{0};
+
+        /*!
+         * \brief Number of bytes that the chunks would take as plain arrays of materials
+         */
+        Size num_uncompressed_chunk_bytes{0};
+
+        /*!
+         * \brief Number of voxels that got dug out of the surface after the last run
+         */
+        Uint32 num_edits{0};
+
+        /*!
+         * \brief Number of chunks that had to be remeshed after the edits
+         */
+        Uint32 num_remeshed_chunks{0};
+
+        /*!
+         * \brief Time it took to remesh the chunks after the edits, in milliseconds
+         */
+        double remesh_milliseconds{0};
+    };
+
+    /*!
+     * \brief Measures how quickly voxel chunks get meshed, and how many triangles the greedy mesher saves over one quad per face
+     *
+     * The chunks get filled from the terrain heights, in a square of chunk columns that cover the terrain's height range. First every chunk
+     * gets meshed on this thread by the naive mesher and by the greedy mesher, and each greedy mesh is checked against its naive mesh. Then
+     * the chunks go into a VoxelChunkStore for each thread count, which meshes all of them at once on its thread pool. Finally, the last
+     * store digs voxels out of the surface and remeshes only the chunks that changed, like a player editing the world. Results get logged
+     * as well as returned
+     *
+     * \param config Noise settings to generate the terrain with
+     * \param chunks_per_side Number of chunk columns along each side of the square
+     * \param thread_counts The number of worker threads to use for each run of the chunk store
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     * \param sea_level Height of the sea. Columns that end near it get sand on top instead of grass
+     */
+    [[nodiscard]] VoxelMeshingBenchmarkResults benchmark_voxel_meshing(const NoiseConfig& config,
+                                                                       Uint32 chunks_per_side,
+                                                                       const Rx::Vector<Uint32>& thread_counts,
+                                                                       Float32 min_height,
+                                                                       Float32 max_height,
+                                                                       Float32 sea_level);
+
+    struct WorldSaveBenchmarkResults {
+        Uint32 num_chunks{0};
+
+        Uint32 num_tiles{0};
+
+        /*!
+         * \brief Number of bytes that the chunks and tiles take before they're compressed
+         */
+        Size num_uncompressed_bytes{0};
+
+        /*!
+         * \brief Total size of the region files
+         */
+        Size num_file_bytes{0};
+
+        Uint32 num_region_files{0};
+
+        /*!
+         * \brief Time it took to serialize and compress everything, in milliseconds
+         */
+        double save_milliseconds{0};
+
+        /*!
+         * \brief Time that starting the background writes blocked the thread that started them, in milliseconds
+         */
+        double flush_dispatch_milliseconds{0};
+
+        /*!
+         * \brief Time from starting the background writes until they all finished, in milliseconds
+         */
+        double flush_milliseconds{0};
+
+        /*!
+         * \brief Time it took to load every chunk and tile back from a freshly opened save, in milliseconds
+         */
+        double load_milliseconds{0};
+
+        /*!
+         * \brief Average time it took to load a single chunk from a freshly opened save, including opening its region, in microseconds
+         */
+        double random_load_microseconds{0};
+
+        /*!
+         * \brief Number of regions that the single chunk loads opened
+         */
+        Uint32 num_random_load_regions{0};
+
+        /*!
+         * \brief Whether every chunk and tile loaded back exactly as it was saved
+         */
+        bool matches_saved_data{true};
+    };
+
+    /*!
+     * \brief Measures how quickly voxel chunks and terrain tiles get saved to region files and loaded back, and how well they compress
+     *
+     * The chunks get filled from the terrain heights like in `benchmark_voxel_meshing`, and the terrain tiles are the tiles under the same
+     * square. Everything gets saved and flushed to region files in a fresh directory, then loaded back from a new save. A few chunks also
+     * get loaded from another new save, to show what loading a chunk costs when its region isn't open yet. The directory gets removed
+     * afterwards. Results get logged as well as returned
+     *
+     * \param config Noise settings to generate the terrain with
+     * \param directory Directory to save to. Anything in it gets deleted
+     * \param chunks_per_side Number of chunk columns along each side of the square
+     * \param tile_size Number of heights along each side of a terrain tile
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     * \param sea_level Height of the sea. Columns that end near it get sand on top instead of grass
+     */
+    [[nodiscard]] WorldSaveBenchmarkResults benchmark_world_save(const NoiseConfig& config,
+                                                                 const Rx::String& directory,
+                                                                 Uint32 chunks_per_side,
+                                                                 Uint32 tile_size,
+                                                                 Float32 min_height,
+                                                                 Float32 max_height,
+                                                                 Float32 sea_level);
+} // namespace terraingen
@@ -0,0 +1,706 @@
+#include "terrain_climate.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/clamp.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+#include "rx/core/time/stop_watch.h"
+#include "rx/core/utility/swap.h"
+#include "rx/math/constants.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TERRAIN_CLIMATE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace terraingen {
+    /*!
+     * \brief Number of rows that one task handles in the passes that work on rows. Fixed so that the work split doesn't depend on the
+     * number of threads
+     */
+    constexpr Uint32 CLIMATE_BAND_SIZE = 32;
+
+    /*!
+     * \brief Number of columns that one task blurs at a time. 64 columns of running sums plus the two rows that they read from fit in L1
+     */
+    constexpr Uint32 CLIMATE_COLUMN_BLOCK_SIZE = 64;
+
+    /*!
+     * \brief Number of box blurs that the humidity blur runs. Three box blurs are close enough to a gaussian
+     */
+    constexpr Uint32 NUM_HUMIDITY_BLUR_PASSES = 3;
+
+    /*!
+     * \brief Width of each circulation cell, in degrees of latitude
+     */
+    constexpr Float32 CIRCULATION_CELL_DEGREES = 30;
+
+    /*!
+     * \brief Strength of the wind towards or away from the equator, compared to the wind along the lines of latitude
+     */
+    constexpr Float32 MERIDIONAL_WIND_FACTOR = 0.3f;
+
+    struct MaxHeightLevel {
+        Uint32 width;
+
+        Uint32 height;
+
+        Rx::Vector<Float32> heights;
+    };
+
+    /*!
+     * \brief Where a texel gets its air from in each advection step
+     */
+    struct AdvectionSource {
+        /*!
+         * \brief Index of the top left of the four texels around the upwind location
+         */
+        Uint32 index;
+
+        Float32 fraction_x;
+
+        Float32 fraction_y;
+
+        /*!
+         * \brief Fraction of the upwind humidity that makes it to this texel
+         */
+        Float32 retention;
+    };
+
+    /*!
+     * \brief Everything that the climate stages read and write
+     */
+    struct ClimateGrid {
+        Uint32 width;
+
+        Uint32 height;
+
+        ClimateSettings settings;
+
+        std::span<const Float32> heightmap;
+
+        std::span<const Float32> water_depths;
+
+        /*!
+         * \brief Max-height pyramid. Level 0 is the heightmap with the oceans filled up to sea level, and each texel of each level after
+         * it is the highest of the 2x2 texels that it covers in the level before it
+         */
+        Rx::Vector<MaxHeightLevel> max_height_levels;
+
+        /*!
+         * \brief 1 for texels that are covered by water, 0 for everything else
+         */
+        Rx::Vector<Float32> humidity_sources;
+
+        /*!
+         * \brief Where each texel's air comes from in each advection step. Humidity advection finds them, and temperature advection reuses
+         * them
+         */
+        Rx::Vector<AdvectionSource> advection_sources;
+
+        /*!
+         * \brief Somewhere to write a pass's results while the pass reads the previous results
+         */
+        Rx::Vector<Float32> scratch;
+    };
+
+    template <typename FuncType>
+    static void run_tasks(Rx::Concurrency::ThreadPool& pool, const Uint32 num_tasks, FuncType&& func) {
+        Rx::Concurrency::WaitGroup tasks_finished{num_tasks};
+
+        for(Uint32 task = 0; task < num_tasks; task++) {
+            pool.add([&, task](int /* thread_id */) {
+                func(task);
+
+                tasks_finished.signal();
+            });
+        }
+
+        tasks_finished.wait();
+    }
+
+    /*!
+     * \brief Calls a function for bands of rows in parallel, and waits for all of them to finish
+     */
+    template <typename FuncType>
+    static void for_each_band(Rx::Concurrency::ThreadPool& pool, const Uint32 num_rows, FuncType&& func) {
+        const auto num_bands = (num_rows + CLIMATE_BAND_SIZE - 1) / CLIMATE_BAND_SIZE;
+        run_tasks(pool, num_bands, [&](const Uint32 band) {
+            const auto first_row = band * CLIMATE_BAND_SIZE;
+            func(first_row, Rx::Algorithm::min(first_row + CLIMATE_BAND_SIZE, num_rows));
+        });
+    }
+
+    /*!
+     * \brief Calls a function for blocks of columns in parallel, and waits for all of them to finish
+     */
+    template <typename FuncType>
+    static void for_each_column_block(Rx::Concurrency::ThreadPool& pool, const Uint32 num_columns, FuncType&& func) {
+        const auto num_blocks = (num_columns + CLIMATE_COLUMN_BLOCK_SIZE - 1) / CLIMATE_COLUMN_BLOCK_SIZE;
+        run_tasks(pool, num_blocks, [&](const Uint32 block) {
+            const auto first_column = block * CLIMATE_COLUMN_BLOCK_SIZE;
+            func(first_column, Rx::Algorithm::min(first_column + CLIMATE_COLUMN_BLOCK_SIZE, num_columns));
+        });
+    }
+
+    /*!
+     * \brief Gets the latitude of a column of the climate grid, in degrees, negative in the north
+     */
+    static Float32 get_latitude(const Uint32 x, const Uint32 width) {
+        return (static_cast<Float32>(x) + 0.5f) / static_cast<Float32>(width) * 180.0f - 90.0f;
+    }
+
+    /*!
+     * \brief Gets the prevailing wind at a latitude, from a three-cell model of the atmospheric circulation
+     *
+     * Each hemisphere has three cells. The wind blows towards the equator and west in the Hadley and polar cells, and towards the pole and
+     * east in the Ferrel cell between them. It dies down at the edges of the cells, like in the doldrums and the horse latitudes
+     *
+     * \param latitude Latitude in degrees, negative in the north
+     * \param max_wind_speed Speed of the strongest wind
+     */
+    static Vec2f get_prevailing_wind(const Float32 latitude, const Float32 max_wind_speed) {
+        const auto cell_position = Rx::Algorithm::min(std::abs(latitude) / CIRCULATION_CELL_DEGREES, 2.999f);
+        const auto cell = static_cast<Uint32>(cell_position);
+        const auto strength = std::sin((cell_position - static_cast<Float32>(cell)) * Rx::Math::k_pi<Float32>) * max_wind_speed;
+
+        const auto is_ferrel_cell = cell == 1;
+        const auto towards_equator = latitude < 0 ? 1.0f : -1.0f;
+
+        const auto meridional = (is_ferrel_cell ? -towards_equator : towards_equator) * MERIDIONAL_WIND_FACTOR * strength;
+        const auto zonal = (is_ferrel_cell ? 1.0f : -1.0f) * strength;
+
+        return Vec2f{meridional, zonal};
+    }
+
+    static void compute_circulation(Rx::Concurrency::ThreadPool& pool, const ClimateGrid& grid, Rx::Vector<Vec2f>& wind) {
+        ZoneScoped;
+
+        // Every row covers the same latitudes, so work out one row and copy it
+        Rx::Vector<Vec2f> row_wind{grid.width};
+        for(Uint32 x = 0; x < grid.width; x++) {
+            row_wind[x] = get_prevailing_wind(get_latitude(x, grid.width), grid.settings.max_wind_speed);
+        }
+
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Uint32 y = first_row; y < last_row; y++) {
+                memcpy(wind.data() + static_cast<Size>(y) * grid.width, row_wind.data(), grid.width * sizeof(Vec2f));
+            }
+        });
+    }
+
+    static void build_max_height_rows(const MaxHeightLevel& source, MaxHeightLevel& level, const Uint32 first_row, const Uint32 last_row) {
+        for(Uint32 y = first_row; y < last_row; y++) {
+            const auto* row_0 = source.heights.data() + static_cast<Size>(y * 2) * source.width;
+            const auto* row_1 = source.heights.data() + static_cast<Size>(Rx::Algorithm::min(y * 2 + 1, source.height - 1)) * source.width;
+            auto* level_row = level.heights.data() + static_cast<Size>(y) * level.width;
+
+            Uint32 x = 0;
+#ifdef TERRAIN_CLIMATE_SSE2
+            // Take the max of the two rows eight texels at a time, then the max of each pair of texels in that
+            for(; x + 4 <= source.width / 2; x += 4) {
+                const auto first_half = _mm_max_ps(_mm_loadu_ps(row_0 + x * 2), _mm_loadu_ps(row_1 + x * 2));
+                const auto second_half = _mm_max_ps(_mm_loadu_ps(row_0 + x * 2 + 4), _mm_loadu_ps(row_1 + x * 2 + 4));
+                const auto even = _mm_shuffle_ps(first_half, second_half, _MM_SHUFFLE(2, 0, 2, 0));
+                const auto odd = _mm_shuffle_ps(first_half, second_half, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm_storeu_ps(level_row + x, _mm_max_ps(even, odd));
+            }
+#endif
+            for(; x < level.width; x++) {
+                const auto x_0 = x * 2;
+                const auto x_1 = Rx::Algorithm::min(x * 2 + 1, source.width - 1);
+                level_row[x] = Rx::Algorithm::max(Rx::Algorithm::max(row_0[x_0], row_0[x_1]), Rx::Algorithm::max(row_1[x_0], row_1[x_1]));
+            }
+        }
+    }
+
+    static void build_max_height_pyramid(Rx::Concurrency::ThreadPool& pool, ClimateGrid& grid) {
+        ZoneScoped;
+
+        auto& levels = grid.max_height_levels;
+
+        // The wind blows over the surface of the ocean, not the sea floor
+        auto base_level = MaxHeightLevel{.width = grid.width, .height = grid.height, .heights = Rx::Vector<Float32>{grid.heightmap.size()}};
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            const auto first = static_cast<Size>(first_row) * grid.width;
+            const auto last = static_cast<Size>(last_row) * grid.width;
+
+            auto i = first;
+#ifdef TERRAIN_CLIMATE_SSE2
+            const auto sea_level = _mm_set1_ps(grid.settings.sea_level);
+            for(; i + 4 <= last; i += 4) {
+                _mm_storeu_ps(base_level.heights.data() + i, _mm_max_ps(_mm_loadu_ps(grid.heightmap.data() + i), sea_level));
+            }
+#endif
+            for(; i < last; i++) {
+                base_level.heights[i] = Rx::Algorithm::max(grid.heightmap[i], grid.settings.sea_level);
+            }
+        });
+        levels.push_back(Rx::Utility::move(base_level));
+
+        while(levels.last().width > 1 || levels.last().height > 1) {
+            const auto& source = levels.last();
+            const auto level_width = (source.width + 1) / 2;
+            const auto level_height = (source.height + 1) / 2;
+            auto level = MaxHeightLevel{.width = level_width,
+                                        .height = level_height,
+                                        .heights = Rx::Vector<Float32>{static_cast<Size>(level_width) * level_height}};
+
+            for_each_band(pool, level_height, [&](const Uint32 first_row, const Uint32 last_row) {
+                build_max_height_rows(source, level, first_row, last_row);
+            });
+
+            levels.push_back(Rx::Utility::move(level));
+        }
+    }
+
+    static void block_wind_rows(const ClimateGrid& grid, Rx::Vector<Vec2f>& wind, const Uint32 first_row, const Uint32 last_row) {
+        const auto max_level = static_cast<Uint32>(grid.max_height_levels.size() - 1);
+        const auto max_distance = grid.settings.horizon_distance;
+        const auto inverse_full_blocking_slope = 1.0f / grid.settings.full_blocking_slope;
+
+        for(Uint32 y = first_row; y < last_row; y++) {
+            for(Uint32 x = 0; x < grid.width; x++) {
+                const auto i = static_cast<Size>(y) * grid.width + x;
+                const auto texel_wind = wind[i];
+                const auto speed = std::sqrt(texel_wind.x * texel_wind.x + texel_wind.y * texel_wind.y);
+                if(speed <= 0) {
+                    continue;
+                }
+
+                const auto upwind_x = -texel_wind.x / speed;
+                const auto upwind_y = -texel_wind.y / speed;
+                const auto origin_height = grid.max_height_levels[0].heights[i];
+
+                // Take steps of half the distance travelled so far, and read a level whose texels are at most half a step wide
+                auto max_slope = 0.0f;
+                Uint32 level = 0;
+                for(Uint32 distance = 1; distance <= max_distance; distance += Rx::Algorithm::max(distance / 2, 1u)) {
+                    const auto sample_x = static_cast<Float32>(x) + 0.5f + upwind_x * static_cast<Float32>(distance);
+                    const auto sample_y = static_cast<Float32>(y) + 0.5f + upwind_y * static_cast<Float32>(distance);
+                    if(sample_x < 0 || sample_y < 0 || sample_x >= static_cast<Float32>(grid.width) ||
+                       sample_y >= static_cast<Float32>(grid.height)) {
+                        break;
+                    }
+
+                    while(level < max_level && (4u << level) <= distance) {
+                        level++;
+                    }
+
+                    const auto& max_heights = grid.max_height_levels[level];
+                    const auto level_x = static_cast<Uint32>(sample_x) >> level;
+                    const auto level_y = static_cast<Uint32>(sample_y) >> level;
+                    const auto horizon_height = max_heights.heights[static_cast<Size>(level_y) * max_heights.width + level_x];
+
+                    max_slope = Rx::Algorithm::max(max_slope, (horizon_height - origin_height) / static_cast<Float32>(distance));
+                }
+
+                const auto blocking = Rx::Algorithm::clamp(max_slope * inverse_full_blocking_slope, 0.0f, 1.0f);
+                wind[i] = texel_wind * (1.0f - blocking);
+            }
+        }
+    }
+
+    static void find_humidity_sources(Rx::Concurrency::ThreadPool& pool, ClimateGrid& grid) {
+        ZoneScoped;
+
+        const auto has_water_depths = grid.water_depths.size() == grid.heightmap.size();
+
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            const auto first = static_cast<Size>(first_row) * grid.width;
+            const auto last = static_cast<Size>(last_row) * grid.width;
+
+            auto i = first;
+#ifdef TERRAIN_CLIMATE_SSE2
+            const auto sea_level = _mm_set1_ps(grid.settings.sea_level);
+            const auto one = _mm_set1_ps(1.0f);
+            const auto zero = _mm_setzero_ps();
+            for(; i + 4 <= last; i += 4) {
+                auto is_water = _mm_cmple_ps(_mm_loadu_ps(grid.heightmap.data() + i), sea_level);
+                if(has_water_depths) {
+                    is_water = _mm_or_ps(is_water, _mm_cmpgt_ps(_mm_loadu_ps(grid.water_depths.data() + i), zero));
+                }
+                _mm_storeu_ps(grid.humidity_sources.data() + i, _mm_and_ps(is_water, one));
+            }
+#endif
+            for(; i < last; i++) {
+                const auto is_water = grid.heightmap[i] <= grid.settings.sea_level || (has_water_depths && grid.water_depths[i] > 0);
+                grid.humidity_sources[i] = is_water ? 1.0f : 0.0f;
+            }
+        });
+    }
+
+    static Uint32 clamp_index(const Int64 index, const Uint32 size) {
+        return static_cast<Uint32>(Rx::Algorithm::clamp(index, static_cast<Int64>(0), static_cast<Int64>(size) - 1));
+    }
+
+    /*!
+     * \brief Box blurs each row with a running sum. Texels past the ends of a row repeat the texel at the end
+     */
+    static void blur_rows(const ClimateGrid& grid,
+                          const Float32* source,
+                          Float32* destination,
+                          const Uint32 first_row,
+                          const Uint32 last_row) {
+        const auto radius = static_cast<Int64>(grid.settings.humidity_blur_radius);
+        const auto scale = 1.0f / static_cast<Float32>(radius * 2 + 1);
+
+        for(Uint32 y = first_row; y < last_row; y++) {
+            const auto* source_row = source + static_cast<Size>(y) * grid.width;
+            auto* destination_row = destination + static_cast<Size>(y) * grid.width;
+
+            auto sum = 0.0f;
+            for(auto x = -radius; x <= radius; x++) {
+                sum += source_row[clamp_index(x, grid.width)];
+            }
+
+            for(Uint32 x = 0; x < grid.width; x++) {
+                destination_row[x] = sum * scale;
+                sum += source_row[clamp_index(x + radius + 1, grid.width)] - source_row[clamp_index(x - radius, grid.width)];
+            }
+        }
+    }
+
+    /*!
+     * \brief Box blurs a block of columns, walking down them with a running sum for each column. Texels past the top and bottom repeat the
+     * texels at the edges
+     */
+    static void blur_columns(const ClimateGrid& grid,
+                             const Float32* source,
+                             Float32* destination,
+                             const Uint32 first_column,
+                             const Uint32 last_column) {
+        const auto radius = static_cast<Int64>(grid.settings.humidity_blur_radius);
+        const auto scale = 1.0f / static_cast<Float32>(radius * 2 + 1);
+        const auto num_columns = last_column - first_column;
+
+        alignas(16) Float32 sums[CLIMATE_COLUMN_BLOCK_SIZE]{};
+        for(auto y = -radius; y <= radius; y++) {
+            const auto* source_row = source + static_cast<Size>(clamp_index(y, grid.height)) * grid.width + first_column;
+            for(Uint32 column = 0; column < num_columns; column++) {
+                sums[column] += source_row[column];
+            }
+        }
+
+        for(Uint32 y = 0; y < grid.height; y++) {
+            const auto* entering_row = source + static_cast<Size>(clamp_index(y + radius + 1, grid.height)) * grid.width + first_column;
+            const auto* leaving_row = source + static_cast<Size>(clamp_index(y - radius, grid.height)) * grid.width + first_column;
+            auto* destination_row = destination + static_cast<Size>(y) * grid.width + first_column;
+
+            Uint32 column = 0;
+#ifdef TERRAIN_CLIMATE_SSE2
+            const auto scale_4 = _mm_set1_ps(scale);
+            for(; column + 4 <= num_columns; column += 4) {
+                const auto sum = _mm_load_ps(sums + column);
+                _mm_storeu_ps(destination_row + column, _mm_mul_ps(sum, scale_4));
+                const auto change = _mm_sub_ps(_mm_loadu_ps(entering_row + column), _mm_loadu_ps(leaving_row + column));
+                _mm_store_ps(sums + column, _mm_add_ps(sum, change));
+            }
+#endif
+            for(; column < num_columns; column++) {
+                destination_row[column] = sums[column] * scale;
+                sums[column] += entering_row[column] - leaving_row[column];
+            }
+        }
+    }
+
+    static void blur_humidity(Rx::Concurrency::ThreadPool& pool, ClimateGrid& grid, Rx::Vector<Float32>& humidity) {
+        ZoneScoped;
+
+        memcpy(humidity.data(), grid.humidity_sources.data(), humidity.size() * sizeof(Float32));
+        if(grid.settings.humidity_blur_radius == 0) {
+            return;
+        }
+
+        for(Uint32 pass = 0; pass < NUM_HUMIDITY_BLUR_PASSES; pass++) {
+            for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+                blur_rows(grid, humidity.data(), grid.scratch.data(), first_row, last_row);
+            });
+
+            for_each_column_block(pool, grid.width, [&](const Uint32 first_column, const Uint32 last_column) {
+                blur_columns(grid, grid.scratch.data(), humidity.data(), first_column, last_column);
+            });
+        }
+
+        // The blur pulls in dry air from the land, but the air right above the water is always fully humid
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            const auto first = static_cast<Size>(first_row) * grid.width;
+            const auto last = static_cast<Size>(last_row) * grid.width;
+
+            auto i = first;
+#ifdef TERRAIN_CLIMATE_SSE2
+            for(; i + 4 <= last; i += 4) {
+                const auto blurred_humidity = _mm_loadu_ps(humidity.data() + i);
+                _mm_storeu_ps(humidity.data() + i, _mm_max_ps(blurred_humidity, _mm_loadu_ps(grid.humidity_sources.data() + i)));
+            }
+#endif
+            for(; i < last; i++) {
+                humidity[i] = Rx::Algorithm::max(humidity[i], grid.humidity_sources[i]);
+            }
+        });
+    }
+
+    /*!
+     * \brief Bilinearly samples a map, clamping the location to the map's edges
+     */
+    static Float32 sample_bilinear(const Float32* map, const Uint32 width, const Uint32 height, const Float32 x, const Float32 y) {
+        const auto clamped_x = Rx::Algorithm::clamp(x, 0.0f, static_cast<Float32>(width - 1));
+        const auto clamped_y = Rx::Algorithm::clamp(y, 0.0f, static_cast<Float32>(height - 1));
+
+        const auto x_0 = static_cast<Uint32>(clamped_x);
+        const auto y_0 = static_cast<Uint32>(clamped_y);
+        const auto x_1 = Rx::Algorithm::min(x_0 + 1, width - 1);
+        const auto y_1 = Rx::Algorithm::min(y_0 + 1, height - 1);
+        const auto fraction_x = clamped_x - static_cast<Float32>(x_0);
+        const auto fraction_y = clamped_y - static_cast<Float32>(y_0);
+
+        const auto* row_0 = map + static_cast<Size>(y_0) * width;
+        const auto* row_1 = map + static_cast<Size>(y_1) * width;
+        const auto top = row_0[x_0] + (row_0[x_1] - row_0[x_0]) * fraction_x;
+        const auto bottom = row_1[x_0] + (row_1[x_1] - row_1[x_0]) * fraction_x;
+
+        return top + (bottom - top) * fraction_y;
+    }
+
+    /*!
+     * \brief Splits a location into the texel that it's in and how far along that texel it is, so that the texel and the one after it
+     * are both in the map
+     */
+    static void split_advection_location(const Float32 location, const Uint32 size, Uint32& texel, Float32& fraction) {
+        const auto clamped_location = Rx::Algorithm::clamp(location, 0.0f, static_cast<Float32>(size - 1));
+        texel = Rx::Algorithm::min(static_cast<Uint32>(clamped_location), size - 2);
+        fraction = clamped_location - static_cast<Float32>(texel);
+    }
+
+    static void advect_humidity(Rx::Concurrency::ThreadPool& pool,
+                                ClimateGrid& grid,
+                                const Rx::Vector<Vec2f>& wind,
+                                Rx::Vector<Float32>& humidity) {
+        ZoneScoped;
+
+        const auto& settings = grid.settings;
+        if(grid.width < 2 || grid.height < 2 || settings.max_wind_speed <= 0) {
+            return;
+        }
+
+        const auto step_scale = settings.advection_step_length / settings.max_wind_speed;
+
+        // The wind doesn't change between steps, so work out where each texel's air comes from once
+        grid.advection_sources = Rx::Vector<AdvectionSource>{grid.heightmap.size()};
+        auto& sources = grid.advection_sources;
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Uint32 y = first_row; y < last_row; y++) {
+                for(Uint32 x = 0; x < grid.width; x++) {
+                    const auto i = static_cast<Size>(y) * grid.width + x;
+
+                    Uint32 texel_x;
+                    Uint32 texel_y;
+                    auto& source = sources[i];
+                    split_advection_location(static_cast<Float32>(x) - wind[i].x * step_scale, grid.width, texel_x, source.fraction_x);
+                    split_advection_location(static_cast<Float32>(y) - wind[i].y * step_scale, grid.height, texel_y, source.fraction_y);
+                    source.index = texel_y * grid.width + texel_x;
+
+                    // Air that climbs to get here rains out some of its humidity on the way up
+                    const auto upwind_height = sample_bilinear(grid.heightmap.data(),
+                                                               grid.width,
+                                                               grid.height,
+                                                               static_cast<Float32>(texel_x) + source.fraction_x,
+                                                               static_cast<Float32>(texel_y) + source.fraction_y);
+                    const auto climb = Rx::Algorithm::max(grid.heightmap[i] - upwind_height, 0.0f);
+                    source.retention = settings.humidity_retention * std::exp(-settings.orographic_rain_rate * climb);
+                }
+            }
+        });
+
+        for(Uint32 step = 0; step < settings.num_advection_steps; step++) {
+            const auto* previous_humidity = humidity.data();
+            auto* next_humidity = grid.scratch.data();
+
+            for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+                const auto first = static_cast<Size>(first_row) * grid.width;
+                const auto last = static_cast<Size>(last_row) * grid.width;
+                for(auto i = first; i < last; i++) {
+                    const auto& source = sources[i];
+                    const auto* top_row = previous_humidity + source.index;
+                    const auto* bottom_row = top_row + grid.width;
+
+                    const auto top = top_row[0] + (top_row[1] - top_row[0]) * source.fraction_x;
+                    const auto bottom = bottom_row[0] + (bottom_row[1] - bottom_row[0]) * source.fraction_x;
+                    const auto carried_humidity = (top + (bottom - top) * source.fraction_y) * source.retention;
+
+                    next_humidity[i] = Rx::Algorithm::max(previous_humidity[i], carried_humidity);
+                }
+            });
+
+            Rx::Utility::swap(humidity, grid.scratch);
+        }
+    }
+
+    static void compute_temperature(Rx::Concurrency::ThreadPool& pool, ClimateGrid& grid, Rx::Vector<Float32>& temperature) {
+        ZoneScoped;
+
+        const auto& settings = grid.settings;
+
+        // Every row covers the same latitudes, so work out the sea level temperature of one row
+        Rx::Vector<Float32> row_temperature{grid.width};
+        for(Uint32 x = 0; x < grid.width; x++) {
+            const auto latitude_radians = get_latitude(x, grid.width) * Rx::Math::k_pi<Float32> / 180.0f;
+            row_temperature[x] = settings.pole_temperature +
+                                 (settings.equator_temperature - settings.pole_temperature) * std::cos(latitude_radians);
+        }
+
+        // Air keeps its sea level temperature as it moves, and gets colder when it climbs. Carry the sea level temperature downwind so
+        // that air which crosses a mountain range is only as cold as the ground under it
+        Rx::Vector<Float32> sea_level_temperature{temperature.size()};
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Uint32 y = first_row; y < last_row; y++) {
+                auto* row = sea_level_temperature.data() + static_cast<Size>(y) * grid.width;
+                memcpy(row, row_temperature.data(), grid.width * sizeof(Float32));
+            }
+        });
+        memcpy(temperature.data(), sea_level_temperature.data(), temperature.size() * sizeof(Float32));
+
+        // Humidity advection finds the sources, unless the grid is too small or there's no wind
+        if(grid.advection_sources.size() == temperature.size()) {
+            for(Uint32 step = 0; step < settings.num_advection_steps; step++) {
+                const auto* previous_temperature = temperature.data();
+                auto* next_temperature = grid.scratch.data();
+
+                for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+                    const auto first = static_cast<Size>(first_row) * grid.width;
+                    const auto last = static_cast<Size>(last_row) * grid.width;
+                    for(auto i = first; i < last; i++) {
+                        const auto& source = grid.advection_sources[i];
+                        const auto* top_row = previous_temperature + source.index;
+                        const auto* bottom_row = top_row + grid.width;
+
+                        const auto top = top_row[0] + (top_row[1] - top_row[0]) * source.fraction_x;
+                        const auto bottom = bottom_row[0] + (bottom_row[1] - bottom_row[0]) * source.fraction_x;
+                        const auto upwind_temperature = top + (bottom - top) * source.fraction_y;
+
+                        next_temperature[i] = sea_level_temperature[i] +
+                                              (upwind_temperature - sea_level_temperature[i]) * settings.temperature_retention;
+                    }
+                });
+
+                Rx::Utility::swap(temperature, grid.scratch);
+            }
+        }
+
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            const auto first = static_cast<Size>(first_row) * grid.width;
+            const auto last = static_cast<Size>(last_row) * grid.width;
+            for(auto i = first; i < last; i++) {
+                const auto altitude = Rx::Algorithm::max(grid.heightmap[i] - settings.sea_level, 0.0f);
+                temperature[i] -= altitude * settings.temperature_lapse_rate;
+            }
+        });
+    }
+
+    static void compute_soil_moisture(Rx::Concurrency::ThreadPool& pool,
+                                      const ClimateGrid& grid,
+                                      const Rx::Vector<Float32>& humidity,
+                                      Rx::Vector<Float32>& soil_moisture) {
+        ZoneScoped;
+
+        const auto slope_drainage = grid.settings.slope_drainage;
+
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Uint32 y = first_row; y < last_row; y++) {
+                const auto* row = grid.heightmap.data() + static_cast<Size>(y) * grid.width;
+                const auto* previous_row = grid.heightmap.data() + static_cast<Size>(y > 0 ? y - 1 : y) * grid.width;
+                const auto* next_row = grid.heightmap.data() + static_cast<Size>(Rx::Algorithm::min(y + 1, grid.height - 1)) * grid.width;
+
+                for(Uint32 x = 0; x < grid.width; x++) {
+                    const auto i = static_cast<Size>(y) * grid.width + x;
+                    if(grid.humidity_sources[i] > 0) {
+                        soil_moisture[i] = 1;
+                        continue;
+                    }
+
+                    const auto slope_x = (row[Rx::Algorithm::min(x + 1, grid.width - 1)] - row[x > 0 ? x - 1 : x]) * 0.5f;
+                    const auto slope_y = (next_row[x] - previous_row[x]) * 0.5f;
+                    const auto slope = std::sqrt(slope_x * slope_x + slope_y * slope_y);
+
+                    soil_moisture[i] = Rx::Algorithm::clamp(humidity[i] / (1.0f + slope_drainage * slope), 0.0f, 1.0f);
+                }
+            }
+        });
+    }
+
+    ClimateMaps compute_climate(const std::span<const Float32> heightmap,
+                                const std::span<const Float32> water_depths,
+                                const Uint32 width,
+                                const Uint32 height,
+                                const ClimateSettings& settings,
+                                const Uint32 num_threads) {
+        ZoneScoped;
+
+        const auto num_texels = static_cast<Size>(width) * height;
+        RX_ASSERT(heightmap.size() >= num_texels,
+                  "Heightmap needs %u rows of %u heights, but there are only %zu heights",
+                  height,
+                  width,
+                  heightmap.size());
+
+        ClimateMaps maps;
+        if(num_texels == 0) {
+            return maps;
+        }
+
+        maps.wind = Rx::Vector<Vec2f>{num_texels};
+        maps.humidity = Rx::Vector<Float32>{num_texels};
+        maps.soil_moisture = Rx::Vector<Float32>{num_texels};
+        maps.temperature = Rx::Vector<Float32>{num_texels};
+
+        auto grid = ClimateGrid{.width = width,
+                                .height = height,
+                                .settings = settings,
+                                .heightmap = heightmap.subspan(0, num_texels),
+                                .water_depths = water_depths.size() >= num_texels ? water_depths.subspan(0, num_texels) : water_depths,
+                                .humidity_sources = Rx::Vector<Float32>{num_texels},
+                                .scratch = Rx::Vector<Float32>{num_texels}};
+
+        const auto num_bands = (height + CLIMATE_BAND_SIZE - 1) / CLIMATE_BAND_SIZE;
+        const auto num_column_blocks = (width + CLIMATE_COLUMN_BLOCK_SIZE - 1) / CLIMATE_COLUMN_BLOCK_SIZE;
+        Rx::Concurrency::ThreadPool pool{Rx::Algorithm::max(num_threads, 1u), Rx::Algorithm::max(num_bands, num_column_blocks)};
+
+        const auto run_stage = [&](const char* name, auto&& stage) {
+            Rx::Time::StopWatch timer;
+            timer.start();
+            stage();
+            timer.stop();
+
+            maps.stage_timings.push_back(ClimateStageTiming{.name = name, .milliseconds = timer.elapsed().total_seconds() * 1000.0});
+        };
+
+        run_stage("Atmospheric circulation", [&] { compute_circulation(pool, grid, maps.wind); });
+
+        run_stage("Max-height pyramid", [&] { build_max_height_pyramid(pool, grid); });
+
+        run_stage("Horizon blocking", [&] {
+            ZoneScopedN("block_wind");
+            for_each_band(pool, height, [&](const Uint32 first_row, const Uint32 last_row) {
+                block_wind_rows(grid, maps.wind, first_row, last_row);
+            });
+        });
+
+        run_stage("Humidity sources", [&] { find_humidity_sources(pool, grid); });
+
+        run_stage("Humidity blur", [&] { blur_humidity(pool, grid, maps.humidity); });
+
+        run_stage("Humidity advection", [&] { advect_humidity(pool, grid, maps.wind, maps.humidity); });
+
+        run_stage("Soil moisture", [&] { compute_soil_moisture(pool, grid, maps.humidity, maps.soil_moisture); });
+
+        run_stage("Temperature", [&] { compute_temperature(pool, grid, maps.temperature); });
+
+        return maps;
+    }
+} // namespace terraingen
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace terraingen {
+    struct ClimateSettings {
+        /*!
+         * \brief Height of the ocean's surface. Texels at or below it are ocean
+         */
+        Float32 sea_level{0};
+
+        /*!
+         * \brief Speed of the strongest winds that the atmospheric circulation makes, in kmph
+         */
+        Float32 max_wind_speed{40};
+
+        /*!
+         * \brief How far upwind to look for terrain that blocks the wind, in texels
+         */
+        Uint32 horizon_distance{512};
+
+        /*!
+         * \brief How steep the horizon must be, as height over distance, to block the wind completely
+         */
+        Float32 full_blocking_slope{0.25f};
+
+        /*!
+         * \brief Radius of the blur that spreads humidity away from water, in texels
+         */
+        Uint32 humidity_blur_radius{32};
+
+        /*!
+         * \brief Number of steps that carry humidity downwind
+         */
+        Uint32 num_advection_steps{16};
+
+        /*!
+         * \brief How far humidity moves downwind in one step when the wind is at `max_wind_speed`, in texels
+         */
+        Float32 advection_step_length{4};
+
+        /*!
+         * \brief Fraction of its humidity that air keeps in each advection step on flat ground
+         */
+        Float32 humidity_retention{0.98f};
+
+        /*!
+         * \brief Fraction of its humidity that air rains out for each meter that it climbs
+         */
+        Float32 orographic_rain_rate{0.01f};
+
+        /*!
+         * \brief How quickly slopes shed water. Soil on a slope of 1 holds `1 / (1 + slope_drainage)` of the humidity above it
+         */
+        Float32 slope_drainage{2};
+
+        /*!
+         * \brief Temperature at sea level on the equator, in degrees celsius
+         */
+        Float32 equator_temperature{30};
+
+        /*!
+         * \brief Temperature at sea level on the poles, in degrees celsius
+         */
+        Float32 pole_temperature{-25};
+
+        /*!
+         * \brief How much colder the air gets for each meter above sea level, in degrees celsius
+         */
+        Float32 temperature_lapse_rate{0.0065f};
+
+        /*!
+         * \brief Fraction of the difference between the upwind air's temperature and the local temperature that air keeps in each
+         * advection step
+         */
+        Float32 temperature_retention{0.9f};
+    };
+
+    struct ClimateStageTiming {
+        const char* name{nullptr};
+
+        double milliseconds{0};
+    };
+
+    struct ClimateMaps {
+        /*!
+         * \brief Wind on each texel, in kmph. x is along the rows, towards the south. y is across the rows, towards the east
+         */
+        Rx::Vector<Vec2f> wind;
+
+        /*!
+         * \brief Humidity of the air above each texel, from 0 for bone dry to 1 for the air over water
+         */
+        Rx::Vector<Float32> humidity;
+
+        /*!
+         * \brief How wet the ground on each texel is, from 0 to 1. Water texels are 1
+         */
+        Rx::Vector<Float32> soil_moisture;
+
+        /*!
+         * \brief Mean air temperature on each texel, in degrees celsius
+         */
+        Rx::Vector<Float32> temperature;
+
+        /*!
+         * \brief How long each stage of the climate model took, in the order that they ran
+         */
+        Rx::Vector<ClimateStageTiming> stage_timings;
+    };
+
+    /*!
+     * \brief Runs the climate model on a heightmap
+     *
+     * The model runs as a chain of stages, each split into fixed bands of rows or blocks of columns that run in parallel:
+     *
+     * 1. Atmospheric circulation gives every latitude an Earth-like prevailing wind: trade winds near the equator, westerlies in the mid
+     * latitudes, and polar easterlies near the poles
+     * 2. A pyramid of max-height mips gets built from the heightmap, with the oceans filled up to sea level
+     * 3. Every texel looks upwind for the steepest horizon and loses that much of its wind. Instead of ray marching through every texel,
+     * the search takes steps that grow with distance and reads a pyramid level whose texels are about as big as the step, so each texel
+     * only takes O(log n) samples. Since the pyramid stores maximums, no peak between the samples is missed
+     * 4. Water texels become humidity sources
+     * 5. A separable box blur, run three times to approximate a gaussian, spreads the humidity away from the water. Rows blur one at a
+     * time, and columns blur in blocks that are narrow enough to stay in the cache while the blur walks down them
+     * 6. Humidity gets carried downwind a few steps at a time, raining out as the air climbs
+     * 7. Soil moisture comes from the humidity, less on steep slopes
+     * 8. Temperature falls off from the equator to the poles. The wind carries it along the same paths as the humidity, so air from
+     * warmer latitudes warms the land downwind of it. Then it falls with altitude at the lapse rate
+     *
+     * The heavy loops use SSE2 where it's available. The results don't depend on the number of threads
+     *
+     * \param heightmap The heights to run the model on, in rows. Latitude runs along the rows, from the north pole at the first height in
+     * each row to the south pole at the last
+     * \param water_depths Depth of the lakes and rivers on each texel, laid out like `heightmap`. May be empty
+     * \param width Number of heights in each row
+     * \param height Number of rows
+     * \param settings How the climate behaves
+     * \param num_threads Number of worker threads to use
+     */
+    [[nodiscard]] ClimateMaps compute_climate(std::span<const Float32> heightmap,
+                                              std::span<const Float32> water_depths,
+                                              Uint32 width,
+                                              Uint32 height,
+                                              const ClimateSettings& settings,
+                                              Uint32 num_threads);
+} // namespace terraingen
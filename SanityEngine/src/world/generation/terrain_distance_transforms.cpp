@@ -0,0 +1,388 @@
+#include "terrain_distance_transforms.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TERRAIN_DISTANCE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace terraingen {
+    /*!
+     * \brief Number of rows in each band of the row pass
+     */
+    constexpr Uint32 DISTANCE_BAND_SIZE = 32;
+
+    /*!
+     * \brief Number of columns that each task of the column pass sweeps together. Each row of a block is a few whole cache lines
+     */
+    constexpr Uint32 DISTANCE_COLUMN_BLOCK_SIZE = 64;
+
+    /*!
+     * \brief Width of the border of empty texels around the chamfer transform's working map, so its mask never reads off the map
+     */
+    constexpr Uint32 CHAMFER_BORDER = 2;
+
+    constexpr Float32 NO_SEED = std::numeric_limits<Float32>::infinity();
+
+    /*!
+     * \brief Runs tasks on a thread pool and waits for them to finish, or runs them one after another if there's no pool
+     */
+    template <typename FuncType>
+    static void run_tasks(Rx::Concurrency::ThreadPool* pool, const Uint32 num_tasks, FuncType&& func) {
+        if(pool == nullptr) {
+            for(Uint32 task = 0; task < num_tasks; task++) {
+                func(task);
+            }
+
+            return;
+        }
+
+        Rx::Concurrency::WaitGroup tasks_finished{num_tasks};
+
+        for(Uint32 task = 0; task < num_tasks; task++) {
+            pool->add([&, task](int /* thread_id */) {
+                func(task);
+
+                tasks_finished.signal();
+            });
+        }
+
+        tasks_finished.wait();
+    }
+
+    /*!
+     * \brief Finds the distance from each texel to the nearest seed in its column, for a block of columns
+     *
+     * The sweep down carries the distance to the nearest seed above each texel, and the sweep up takes the minimum with the nearest seed
+     * below it. Both sweeps walk along whole rows of the block, so they read memory in order
+     */
+    static void sweep_columns(std::span<const Uint8> seeds,
+                              const Uint32 width,
+                              const Uint32 depth,
+                              const Uint32 first_column,
+                              const Uint32 last_column,
+                              Float32* column_distances) {
+        for(Uint32 x = first_column; x < last_column; x++) {
+            column_distances[x] = seeds[x] != 0 ? 0 : NO_SEED;
+        }
+
+        for(Uint32 z = 1; z < depth; z++) {
+            const auto* seed_row = &seeds[static_cast<Size>(z) * width];
+            const auto* previous_row = &column_distances[static_cast<Size>(z - 1) * width];
+            auto* row = &column_distances[static_cast<Size>(z) * width];
+            for(Uint32 x = first_column; x < last_column; x++) {
+                row[x] = seed_row[x] != 0 ? 0 : previous_row[x] + 1;
+            }
+        }
+
+        for(Uint32 z = depth - 1; z > 0; z--) {
+            const auto* next_row = &column_distances[static_cast<Size>(z) * width];
+            auto* row = &column_distances[static_cast<Size>(z - 1) * width];
+            for(Uint32 x = first_column; x < last_column; x++) {
+                row[x] = Rx::Algorithm::min(row[x], next_row[x] + 1);
+            }
+        }
+    }
+
+    /*!
+     * \brief Working memory for the lower envelope of one row
+     */
+    struct EnvelopeScratch {
+        /*!
+         * \brief Copy of the row's column distances, since the row gets overwritten with the final distances
+         */
+        Rx::Vector<Float32> column_distances;
+
+        /*!
+         * \brief Texels whose parabolas make up the lower envelope, from left to right
+         */
+        Rx::Vector<Int32> parabolas;
+
+        /*!
+         * \brief Where each parabola of the envelope starts. The last parabola ends at the entry after it
+         */
+        Rx::Vector<double> boundaries;
+    };
+
+    /*!
+     * \brief Turns the column distances of a row into Euclidean distances
+     *
+     * Each texel `q` with a seed somewhere in its column contributes the parabola `(x - q)^2 + column_distance(q)^2`, and the squared
+     * distance at `x` is the lowest of the parabolas there. The parabolas get added from left to right, popping the ones that the new
+     * parabola hides, so the envelope is built in linear time. The arithmetic is in doubles, which hold every squared distance exactly
+     */
+    static void transform_row(Float32* row, const Uint32 width, const Float32 max_distance, EnvelopeScratch& scratch) {
+        memcpy(scratch.column_distances.data(), row, width * sizeof(Float32));
+        const auto* column_distances = scratch.column_distances.data();
+        auto* parabolas = scratch.parabolas.data();
+        auto* boundaries = scratch.boundaries.data();
+
+        const auto get_height = [&](const Int32 q) {
+            const auto column_distance = static_cast<double>(column_distances[q]);
+            return column_distance * column_distance + static_cast<double>(q) * q;
+        };
+
+        Int32 last = -1;
+        for(Int32 q = 0; q < static_cast<Int32>(width); q++) {
+            // Columns without seeds are parabolas at infinity, which are never part of the envelope
+            if(column_distances[q] == NO_SEED) {
+                continue;
+            }
+
+            if(last < 0) {
+                last = 0;
+                parabolas[0] = q;
+                boundaries[0] = -std::numeric_limits<double>::infinity();
+                continue;
+            }
+
+            const auto height = get_height(q);
+            const auto get_intersection = [&](const Int32 previous) {
+                return (height - get_height(previous)) / (2.0 * (q - previous));
+            };
+
+            // The first parabola starts at negative infinity, so it's never popped
+            auto intersection = get_intersection(parabolas[last]);
+            while(intersection <= boundaries[last]) {
+                last--;
+                intersection = get_intersection(parabolas[last]);
+            }
+
+            last++;
+            parabolas[last] = q;
+            boundaries[last] = intersection;
+        }
+
+        if(last < 0) {
+            for(Uint32 x = 0; x < width; x++) {
+                row[x] = max_distance;
+            }
+
+            return;
+        }
+
+        boundaries[last + 1] = std::numeric_limits<double>::infinity();
+
+        Int32 parabola = 0;
+        for(Int32 x = 0; x < static_cast<Int32>(width); x++) {
+            while(boundaries[parabola + 1] < x) {
+                parabola++;
+            }
+
+            const auto q = parabolas[parabola];
+            const auto column_distance = static_cast<double>(column_distances[q]);
+            const auto squared_distance = static_cast<double>(x - q) * (x - q) + column_distance * column_distance;
+            row[x] = Rx::Algorithm::min(static_cast<Float32>(std::sqrt(squared_distance)), max_distance);
+        }
+    }
+
+    static void compute_exact_distance_field(std::span<const Uint8> seeds,
+                                             const Uint32 width,
+                                             const Uint32 depth,
+                                             const Float32 max_distance,
+                                             Rx::Concurrency::ThreadPool* pool,
+                                             Rx::Vector<Float32>& distances) {
+        const auto num_column_blocks = (width + DISTANCE_COLUMN_BLOCK_SIZE - 1) / DISTANCE_COLUMN_BLOCK_SIZE;
+        run_tasks(pool, num_column_blocks, [&](const Uint32 block) {
+            const auto first_column = block * DISTANCE_COLUMN_BLOCK_SIZE;
+            const auto last_column = Rx::Algorithm::min(first_column + DISTANCE_COLUMN_BLOCK_SIZE, width);
+            sweep_columns(seeds, width, depth, first_column, last_column, distances.data());
+        });
+
+        const auto num_bands = (depth + DISTANCE_BAND_SIZE - 1) / DISTANCE_BAND_SIZE;
+        run_tasks(pool, num_bands, [&](const Uint32 band) {
+            EnvelopeScratch scratch;
+            scratch.column_distances.resize(width);
+            scratch.parabolas.resize(width);
+            scratch.boundaries.resize(static_cast<Size>(width) + 1);
+
+            const auto first_row = band * DISTANCE_BAND_SIZE;
+            const auto last_row = Rx::Algorithm::min(first_row + DISTANCE_BAND_SIZE, depth);
+            for(auto z = first_row; z < last_row; z++) {
+                transform_row(&distances[static_cast<Size>(z) * width], width, max_distance, scratch);
+            }
+        });
+    }
+
+    /*!
+     * \brief One step of the chamfer mask, from a texel to a neighbour that the forwards pass has already visited
+     */
+    struct ChamferStep {
+        Int32 x;
+
+        Int32 z;
+
+        /*!
+         * \brief Euclidean length of the step
+         */
+        Float32 length;
+    };
+
+    /*!
+     * \brief The steps of the forwards half of the 5x5 chamfer mask that reach into earlier rows. The backwards pass uses the same steps,
+     * negated. The step along the row is handled on its own, since it's the only one that depends on the texel right before
+     */
+    constexpr ChamferStep CHAMFER_ROW_STEPS[] = {
+        {0, -1, 1},
+        {-1, -1, 1.41421356f},
+        {1, -1, 1.41421356f},
+        {-1, -2, 2.23606798f},
+        {1, -2, 2.23606798f},
+        {-2, -1, 2.23606798f},
+        {2, -1, 2.23606798f},
+    };
+
+    constexpr Size NUM_CHAMFER_ROW_STEPS = sizeof(CHAMFER_ROW_STEPS) / sizeof(CHAMFER_ROW_STEPS[0]);
+
+    /*!
+     * \brief Takes the chamfer steps from finished rows for every texel of a row
+     *
+     * \param row The row's first texel
+     * \param offsets Offset of each step's neighbour from a texel, in texels
+     * \param width Number of texels in the row
+     */
+    static void take_chamfer_row_steps(Float32* row, const Int64 (&offsets)[NUM_CHAMFER_ROW_STEPS], const Uint32 width) {
+        Uint32 x = 0;
+#ifdef TERRAIN_DISTANCE_SSE2
+        for(; x + 4 <= width; x += 4) {
+            auto distance = _mm_loadu_ps(row + x);
+            for(Size i = 0; i < NUM_CHAMFER_ROW_STEPS; i++) {
+                const auto neighbour = _mm_loadu_ps(row + x + offsets[i]);
+                distance = _mm_min_ps(distance, _mm_add_ps(neighbour, _mm_set1_ps(CHAMFER_ROW_STEPS[i].length)));
+            }
+            _mm_storeu_ps(row + x, distance);
+        }
+#endif
+        for(; x < width; x++) {
+            auto distance = row[x];
+            for(Size i = 0; i < NUM_CHAMFER_ROW_STEPS; i++) {
+                distance = Rx::Algorithm::min(distance, row[x + offsets[i]] + CHAMFER_ROW_STEPS[i].length);
+            }
+            row[x] = distance;
+        }
+    }
+
+    /*!
+     * \brief Runs a 5x5 chamfer transform, with a pass forwards over the map and a pass backwards
+     *
+     * The mask steps to the neighbours along the axes and diagonals and to the knight's-move neighbours, each weighted by its Euclidean
+     * length. Each row first takes the steps from the rows that are already finished, which don't depend on each other and vectorize, and
+     * then sweeps along itself. The map gets a border of empty texels so the mask never has to check whether it's on the map
+     */
+    static void compute_chamfer_distance_field(std::span<const Uint8> seeds,
+                                               const Uint32 width,
+                                               const Uint32 depth,
+                                               const Float32 max_distance,
+                                               Rx::Vector<Float32>& distances) {
+        const auto padded_width = width + CHAMFER_BORDER * 2;
+        const auto padded_depth = depth + CHAMFER_BORDER * 2;
+        Rx::Vector<Float32> padded;
+        padded.resize(static_cast<Size>(padded_width) * padded_depth, NO_SEED);
+
+        for(Uint32 z = 0; z < depth; z++) {
+            const auto* seed_row = &seeds[static_cast<Size>(z) * width];
+            auto* row = &padded[static_cast<Size>(z + CHAMFER_BORDER) * padded_width + CHAMFER_BORDER];
+            for(Uint32 x = 0; x < width; x++) {
+                row[x] = seed_row[x] != 0 ? 0 : NO_SEED;
+            }
+        }
+
+        Int64 forwards_offsets[NUM_CHAMFER_ROW_STEPS];
+        Int64 backwards_offsets[NUM_CHAMFER_ROW_STEPS];
+        for(Size i = 0; i < NUM_CHAMFER_ROW_STEPS; i++) {
+            forwards_offsets[i] = static_cast<Int64>(CHAMFER_ROW_STEPS[i].z) * padded_width + CHAMFER_ROW_STEPS[i].x;
+            backwards_offsets[i] = -forwards_offsets[i];
+        }
+
+        for(Uint32 z = CHAMFER_BORDER; z < depth + CHAMFER_BORDER; z++) {
+            auto* row = &padded[static_cast<Size>(z) * padded_width + CHAMFER_BORDER];
+            take_chamfer_row_steps(row, forwards_offsets, width);
+
+            for(Uint32 x = 1; x < width; x++) {
+                row[x] = Rx::Algorithm::min(row[x], row[x - 1] + 1);
+            }
+        }
+
+        for(auto z = depth + CHAMFER_BORDER; z > CHAMFER_BORDER; z--) {
+            auto* row = &padded[static_cast<Size>(z - 1) * padded_width + CHAMFER_BORDER];
+            take_chamfer_row_steps(row, backwards_offsets, width);
+
+            for(auto x = width - 1; x > 0; x--) {
+                row[x - 1] = Rx::Algorithm::min(row[x - 1], row[x] + 1);
+            }
+        }
+
+        for(Uint32 z = 0; z < depth; z++) {
+            const auto* row = &padded[static_cast<Size>(z + CHAMFER_BORDER) * padded_width + CHAMFER_BORDER];
+            auto* distance_row = &distances[static_cast<Size>(z) * width];
+            for(Uint32 x = 0; x < width; x++) {
+                distance_row[x] = Rx::Algorithm::min(row[x], max_distance);
+            }
+        }
+    }
+
+    Rx::Vector<Float32> compute_distance_field(std::span<const Uint8> seeds,
+                                               const Uint32 width,
+                                               const Uint32 depth,
+                                               const DistanceTransformSettings& settings) {
+        ZoneScoped;
+
+        if(width == 0 || depth == 0 || seeds.size() != static_cast<Size>(width) * depth) {
+            return {};
+        }
+
+        Rx::Vector<Float32> distances;
+        distances.resize(seeds.size());
+
+        if(settings.method == DistanceTransformMethod::Chamfer) {
+            compute_chamfer_distance_field(seeds, width, depth, settings.max_distance, distances);
+
+        } else if(settings.num_threads > 1) {
+            const auto num_tasks = Rx::Algorithm::max((width + DISTANCE_COLUMN_BLOCK_SIZE - 1) / DISTANCE_COLUMN_BLOCK_SIZE,
+                                                      (depth + DISTANCE_BAND_SIZE - 1) / DISTANCE_BAND_SIZE);
+            Rx::Concurrency::ThreadPool pool{settings.num_threads, num_tasks};
+            compute_exact_distance_field(seeds, width, depth, settings.max_distance, &pool, distances);
+
+        } else {
+            compute_exact_distance_field(seeds, width, depth, settings.max_distance, nullptr, distances);
+        }
+
+        return distances;
+    }
+
+    Rx::Vector<Float32> compute_tile_distance_field(std::span<const Uint8> seeds_with_apron,
+                                                    const Uint32 tile_size,
+                                                    const Uint32 apron,
+                                                    const DistanceTransformMethod method) {
+        ZoneScoped;
+
+        const auto padded_size = tile_size + apron * 2;
+        const auto padded_distances = compute_distance_field(seeds_with_apron,
+                                                             padded_size,
+                                                             padded_size,
+                                                             DistanceTransformSettings{.method = method,
+                                                                                       .max_distance = static_cast<Float32>(apron)});
+        if(padded_distances.is_empty()) {
+            return {};
+        }
+
+        Rx::Vector<Float32> distances;
+        distances.resize(static_cast<Size>(tile_size) * tile_size);
+        for(Uint32 z = 0; z < tile_size; z++) {
+            memcpy(&distances[static_cast<Size>(z) * tile_size],
+                   &padded_distances[static_cast<Size>(z + apron) * padded_size + apron],
+                   tile_size * sizeof(Float32));
+        }
+
+        return distances;
+    }
+} // namespace terraingen
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace terraingen {
+    enum class DistanceTransformMethod : Uint8 {
+        /*!
+         * \brief Exact Euclidean distances, from Felzenszwalb and Huttenlocher's lower envelope of parabolas
+         */
+        Exact,
+
+        /*!
+         * \brief Approximate distances from a two-pass 5x5 chamfer, up to about 3% longer than the exact distances
+         *
+         * Much simpler than the exact transform, but usually no faster, since each texel of a row has to wait for the texel before it.
+         * `benchmark_distance_transforms` compares them
+         */
+        Chamfer,
+    };
+
+    struct DistanceTransformSettings {
+        DistanceTransformMethod method{DistanceTransformMethod::Exact};
+
+        /*!
+         * \brief Distances are clamped to this many texels. Texels that have no seeds anywhere in the map get this distance
+         */
+        Float32 max_distance{65536};
+
+        /*!
+         * \brief Number of worker threads to use. The exact transform runs bands of rows and blocks of columns in parallel. The chamfer
+         * transform always runs on the calling thread, since each texel depends on the texels before it
+         */
+        Uint32 num_threads{1};
+    };
+
+    /*!
+     * \brief Computes the distance from every texel of a map to the nearest seed texel, in linear time
+     *
+     * The exact transform finds the distance to the nearest seed in each column with a sweep down and a sweep up the columns, then runs
+     * Felzenszwalb and Huttenlocher's one-dimensional transform along each row, which finds the lower envelope of one parabola per texel.
+     * Both passes are O(n) in the number of texels, no matter how far apart the seeds are. The columns get swept in blocks, so each sweep
+     * reads whole cache lines of each row. The results don't depend on the number of threads
+     *
+     * \param seeds Non-zero for seed texels, in rows of `width` texels
+     * \param width Number of texels in each row
+     * \param depth Number of rows
+     * \param settings How to compute the distances
+     *
+     * \return The distance in texels from each texel to the nearest seed, laid out like `seeds`. Seeds are 0
+     */
+    [[nodiscard]] Rx::Vector<Float32> compute_distance_field(std::span<const Uint8> seeds,
+                                                             Uint32 width,
+                                                             Uint32 depth,
+                                                             const DistanceTransformSettings& settings);
+
+    /*!
+     * \brief Computes the distances from the texels of a square tile to the nearest seed texel, from the seeds in the tile and an apron
+     * around it
+     *
+     * Streamed tiles can't see the seeds in the tiles around them, so they bring an apron of their neighbours' seeds. Any seed outside the
+     * apron is at least `apron` texels away from every texel in the tile, so the distances are the same as the distances on the whole map
+     * up to `apron` texels. Farther distances get clamped to `apron`, which is where the tile stops knowing for sure
+     *
+     * \param seeds_with_apron Non-zero for seed texels, in `tile_size + 2 * apron` rows of `tile_size + 2 * apron` texels. The tile's
+     * first texel is `apron` texels into the `apron`th row
+     * \param tile_size Width of the tile, in texels
+     * \param apron Width of the apron on each side of the tile, in texels
+     * \param method How to compute the distances
+     *
+     * \return The distance in texels from each texel of the tile to the nearest seed, in `tile_size` rows of `tile_size` texels
+     */
+    [[nodiscard]] Rx::Vector<Float32> compute_tile_distance_field(std::span<const Uint8> seeds_with_apron,
+                                                                  Uint32 tile_size,
+                                                                  Uint32 apron,
+                                                                  DistanceTransformMethod method);
+} // namespace terraingen
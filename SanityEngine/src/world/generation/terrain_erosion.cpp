@@ -0,0 +1,348 @@
+#include "terrain_erosion.hpp"
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+#include "rx/core/vector.h"
+#include "world/generation/world_random.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TERRAIN_EROSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace terraingen {
+    /*!
+     * \brief Number of rows that one task updates in each pass. Fixed so that the work split doesn't depend on the number of threads
+     */
+    constexpr Uint32 EROSION_BAND_SIZE = 16;
+
+    /*!
+     * \brief Height of the wall of texels around the heightmap. Nothing flows into the wall, so water can't leave the heightmap
+     */
+    constexpr Float32 EROSION_WALL_HEIGHT = 1e30f;
+
+    /*!
+     * \brief Smallest value we divide by, so that dry or flat texels don't divide by zero
+     */
+    constexpr Float32 EROSION_EPSILON = 1e-20f;
+
+    /*!
+     * \brief Everything that hydraulic erosion keeps track of, for the heightmap plus a one-texel wall around it
+     */
+    struct ErosionGrid {
+        Uint32 width;
+
+        Uint32 height;
+
+        /*!
+         * \brief Number of texels in each row, including the wall
+         */
+        Uint32 stride;
+
+        Float32 evaporation_factor;
+
+        Float32 sediment_capacity;
+
+        Float32 erosion_rate;
+
+        Float32 deposition_rate;
+
+        Float32 max_erosion_depth;
+
+        Rx::Vector<Float32> terrain;
+
+        Rx::Vector<Float32> water;
+
+        Rx::Vector<Float32> sediment;
+
+        /*!
+         * \brief Sediment per meter of water, written by the outflow pass so that the transport pass can read its neighbours' values
+         * while updating its own sediment
+         */
+        Rx::Vector<Float32> concentration;
+
+        Rx::Vector<Float32> rain;
+
+        /*!
+         * \brief Amount of water that flows out of each texel to its neighbour in the negative x direction
+         */
+        Rx::Vector<Float32> outflow_left;
+
+        Rx::Vector<Float32> outflow_right;
+
+        /*!
+         * \brief Amount of water that flows out of each texel to its neighbour in the previous row
+         */
+        Rx::Vector<Float32> outflow_up;
+
+        Rx::Vector<Float32> outflow_down;
+
+        [[nodiscard]] Size get_index(const Uint32 x, const Uint32 y) const {
+            return static_cast<Size>(y + 1) * stride + x + 1;
+        }
+    };
+
+    static void compute_outflow(ErosionGrid& grid, const Size i) {
+        const auto* terrain = grid.terrain.data();
+        const auto* water = grid.water.data();
+        const auto stride = grid.stride;
+
+        const auto surface = terrain[i] + water[i];
+
+        // Water flows towards each neighbour in proportion to how far below us its water surface is
+        const auto drop_left = Rx::Algorithm::max(surface - (terrain[i - 1] + water[i - 1]), 0.0f);
+        const auto drop_right = Rx::Algorithm::max(surface - (terrain[i + 1] + water[i + 1]), 0.0f);
+        const auto drop_up = Rx::Algorithm::max(surface - (terrain[i - stride] + water[i - stride]), 0.0f);
+        const auto drop_down = Rx::Algorithm::max(surface - (terrain[i + stride] + water[i + stride]), 0.0f);
+
+        const auto total_drop = ((drop_left + drop_right) + drop_up) + drop_down;
+        const auto max_drop = Rx::Algorithm::max(Rx::Algorithm::max(drop_left, drop_right), Rx::Algorithm::max(drop_up, drop_down));
+
+        // Moving more than half the biggest drop would make the water slosh back and forth between us and our lowest neighbour
+        const auto total_outflow = Rx::Algorithm::min(water[i], max_drop * 0.5f);
+        const auto scale = total_outflow / Rx::Algorithm::max(total_drop, EROSION_EPSILON);
+
+        grid.outflow_left[i] = drop_left * scale;
+        grid.outflow_right[i] = drop_right * scale;
+        grid.outflow_up[i] = drop_up * scale;
+        grid.outflow_down[i] = drop_down * scale;
+        grid.concentration[i] = grid.sediment[i] / Rx::Algorithm::max(water[i], EROSION_EPSILON);
+    }
+
+    static void transport(ErosionGrid& grid, const Size i) {
+        const auto* concentration = grid.concentration.data();
+        const auto* outflow_left = grid.outflow_left.data();
+        const auto* outflow_right = grid.outflow_right.data();
+        const auto* outflow_up = grid.outflow_up.data();
+        const auto* outflow_down = grid.outflow_down.data();
+        const auto stride = grid.stride;
+
+        const auto inflow = ((outflow_right[i - 1] + outflow_left[i + 1]) + outflow_down[i - stride]) + outflow_up[i + stride];
+        const auto sediment_inflow = ((concentration[i - 1] * outflow_right[i - 1] + concentration[i + 1] * outflow_left[i + 1]) +
+                                      concentration[i - stride] * outflow_down[i - stride]) +
+                                     concentration[i + stride] * outflow_up[i + stride];
+        const auto outflow = ((outflow_left[i] + outflow_right[i]) + outflow_up[i]) + outflow_down[i];
+
+        const auto water = (grid.water[i] - outflow) + inflow;
+        auto sediment = Rx::Algorithm::max((grid.sediment[i] - concentration[i] * outflow) + sediment_inflow, 0.0f);
+
+        // The more water flows through a texel, the more sediment it can carry
+        const auto capacity = grid.sediment_capacity * (outflow + inflow);
+        const auto eroded = Rx::Algorithm::min(Rx::Algorithm::max(capacity - sediment, 0.0f) * grid.erosion_rate, grid.max_erosion_depth);
+        const auto deposited = Rx::Algorithm::max(sediment - capacity, 0.0f) * grid.deposition_rate;
+        const auto change = eroded - deposited;
+
+        grid.terrain[i] -= change;
+        sediment += change;
+
+        grid.sediment[i] = sediment;
+        grid.water[i] = (water + grid.rain[i]) * grid.evaporation_factor;
+    }
+
+#ifdef TERRAIN_EROSION_SSE2
+    static void compute_four_outflows(ErosionGrid& grid, const Size i) {
+        const auto* terrain = grid.terrain.data();
+        const auto* water = grid.water.data();
+        const auto stride = grid.stride;
+
+        const auto zero = _mm_setzero_ps();
+
+        const auto own_water = _mm_loadu_ps(water + i);
+        const auto surface = _mm_add_ps(_mm_loadu_ps(terrain + i), own_water);
+
+        const auto surface_left = _mm_add_ps(_mm_loadu_ps(terrain + i - 1), _mm_loadu_ps(water + i - 1));
+        const auto surface_right = _mm_add_ps(_mm_loadu_ps(terrain + i + 1), _mm_loadu_ps(water + i + 1));
+        const auto surface_up = _mm_add_ps(_mm_loadu_ps(terrain + i - stride), _mm_loadu_ps(water + i - stride));
+        const auto surface_down = _mm_add_ps(_mm_loadu_ps(terrain + i + stride), _mm_loadu_ps(water + i + stride));
+
+        const auto drop_left = _mm_max_ps(_mm_sub_ps(surface, surface_left), zero);
+        const auto drop_right = _mm_max_ps(_mm_sub_ps(surface, surface_right), zero);
+        const auto drop_up = _mm_max_ps(_mm_sub_ps(surface, surface_up), zero);
+        const auto drop_down = _mm_max_ps(_mm_sub_ps(surface, surface_down), zero);
+
+        const auto total_drop = _mm_add_ps(_mm_add_ps(_mm_add_ps(drop_left, drop_right), drop_up), drop_down);
+        const auto max_drop = _mm_max_ps(_mm_max_ps(drop_left, drop_right), _mm_max_ps(drop_up, drop_down));
+
+        const auto epsilon = _mm_set1_ps(EROSION_EPSILON);
+        const auto total_outflow = _mm_min_ps(own_water, _mm_mul_ps(max_drop, _mm_set1_ps(0.5f)));
+        const auto scale = _mm_div_ps(total_outflow, _mm_max_ps(total_drop, epsilon));
+
+        _mm_storeu_ps(grid.outflow_left.data() + i, _mm_mul_ps(drop_left, scale));
+        _mm_storeu_ps(grid.outflow_right.data() + i, _mm_mul_ps(drop_right, scale));
+        _mm_storeu_ps(grid.outflow_up.data() + i, _mm_mul_ps(drop_up, scale));
+        _mm_storeu_ps(grid.outflow_down.data() + i, _mm_mul_ps(drop_down, scale));
+        _mm_storeu_ps(grid.concentration.data() + i, _mm_div_ps(_mm_loadu_ps(grid.sediment.data() + i), _mm_max_ps(own_water, epsilon)));
+    }
+
+    static void transport_four(ErosionGrid& grid, const Size i) {
+        const auto* concentration = grid.concentration.data();
+        const auto* outflow_left = grid.outflow_left.data();
+        const auto* outflow_right = grid.outflow_right.data();
+        const auto* outflow_up = grid.outflow_up.data();
+        const auto* outflow_down = grid.outflow_down.data();
+        const auto stride = grid.stride;
+
+        const auto zero = _mm_setzero_ps();
+
+        const auto from_left = _mm_loadu_ps(outflow_right + i - 1);
+        const auto from_right = _mm_loadu_ps(outflow_left + i + 1);
+        const auto from_up = _mm_loadu_ps(outflow_down + i - stride);
+        const auto from_down = _mm_loadu_ps(outflow_up + i + stride);
+
+        const auto inflow = _mm_add_ps(_mm_add_ps(_mm_add_ps(from_left, from_right), from_up), from_down);
+        const auto sediment_inflow = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(concentration + i - 1), from_left),
+                                                                      _mm_mul_ps(_mm_loadu_ps(concentration + i + 1), from_right)),
+                                                           _mm_mul_ps(_mm_loadu_ps(concentration + i - stride), from_up)),
+                                                _mm_mul_ps(_mm_loadu_ps(concentration + i + stride), from_down));
+        const auto outflow = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(outflow_left + i), _mm_loadu_ps(outflow_right + i)),
+                                                   _mm_loadu_ps(outflow_up + i)),
+                                        _mm_loadu_ps(outflow_down + i));
+
+        auto* terrain = grid.terrain.data() + i;
+        auto* water = grid.water.data() + i;
+        auto* sediment = grid.sediment.data() + i;
+
+        const auto new_water = _mm_add_ps(_mm_sub_ps(_mm_loadu_ps(water), outflow), inflow);
+        auto new_sediment = _mm_max_ps(
+            _mm_add_ps(_mm_sub_ps(_mm_loadu_ps(sediment), _mm_mul_ps(_mm_loadu_ps(concentration + i), outflow)), sediment_inflow),
+            zero);
+
+        const auto capacity = _mm_mul_ps(_mm_set1_ps(grid.sediment_capacity), _mm_add_ps(outflow, inflow));
+        const auto eroded = _mm_min_ps(_mm_mul_ps(_mm_max_ps(_mm_sub_ps(capacity, new_sediment), zero), _mm_set1_ps(grid.erosion_rate)),
+                                       _mm_set1_ps(grid.max_erosion_depth));
+        const auto deposited = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(new_sediment, capacity), zero), _mm_set1_ps(grid.deposition_rate));
+        const auto change = _mm_sub_ps(eroded, deposited);
+
+        _mm_storeu_ps(terrain, _mm_sub_ps(_mm_loadu_ps(terrain), change));
+        new_sediment = _mm_add_ps(new_sediment, change);
+
+        _mm_storeu_ps(sediment, new_sediment);
+        _mm_storeu_ps(water,
+                      _mm_mul_ps(_mm_add_ps(new_water, _mm_loadu_ps(grid.rain.data() + i)), _mm_set1_ps(grid.evaporation_factor)));
+    }
+#endif
+
+    /*!
+     * \brief Runs one of the erosion passes over a band of rows
+     */
+    template <void (*UpdateOne)(ErosionGrid&, Size), void (*UpdateFour)(ErosionGrid&, Size)>
+    static void update_band(ErosionGrid& grid, const Uint32 first_row, const Uint32 last_row) {
+        for(Uint32 y = first_row; y < last_row; y++) {
+            const auto row_start = grid.get_index(0, y);
+
+            // Every band splits its rows the same way, so the same texels take the scalar path no matter how many threads there are
+            Uint32 x = 0;
+#ifdef TERRAIN_EROSION_SSE2
+            for(; x + 4 <= grid.width; x += 4) {
+                UpdateFour(grid, row_start + x);
+            }
+#endif
+            for(; x < grid.width; x++) {
+                UpdateOne(grid, row_start + x);
+            }
+        }
+    }
+
+    template <void (*UpdateOne)(ErosionGrid&, Size), void (*UpdateFour)(ErosionGrid&, Size)>
+    static void run_pass(Rx::Concurrency::ThreadPool& pool, ErosionGrid& grid) {
+        const auto num_bands = (grid.height + EROSION_BAND_SIZE - 1) / EROSION_BAND_SIZE;
+
+        // Waiting for every band before starting the next pass is what exchanges the halos. No band reads a row that another band is
+        // still writing
+        Rx::Concurrency::WaitGroup bands_finished{num_bands};
+
+        for(Uint32 band = 0; band < num_bands; band++) {
+            pool.add([&, band](int /* thread_id */) {
+                const auto first_row = band * EROSION_BAND_SIZE;
+                const auto last_row = Rx::Algorithm::min(first_row + EROSION_BAND_SIZE, grid.height);
+                update_band<UpdateOne, UpdateFour>(grid, first_row, last_row);
+
+                bands_finished.signal();
+            });
+        }
+
+        bands_finished.wait();
+    }
+
+    void erode_heightmap(const std::span<Float32> heightmap,
+                         const Uint32 width,
+                         const Uint32 height,
+                         const HydraulicErosionSettings& settings,
+                         const Uint32 num_threads) {
+        ZoneScoped;
+
+        RX_ASSERT(heightmap.size() >= static_cast<Size>(width) * height,
+                  "A %ux%u heightmap needs %u heights, but only has %zu",
+                  width,
+                  height,
+                  width * height,
+                  heightmap.size());
+
+        if(width == 0 || height == 0 || settings.num_iterations == 0) {
+            return;
+        }
+
+        ErosionGrid grid{.width = width,
+                         .height = height,
+                         .stride = width + 2,
+                         .evaporation_factor = 1.0f - settings.evaporation_rate,
+                         .sediment_capacity = settings.sediment_capacity,
+                         .erosion_rate = settings.erosion_rate,
+                         .deposition_rate = settings.deposition_rate,
+                         .max_erosion_depth = settings.max_erosion_depth};
+
+        const auto num_texels = static_cast<Size>(grid.stride) * (height + 2);
+        grid.terrain.resize(num_texels, EROSION_WALL_HEIGHT);
+        grid.water.resize(num_texels, 0.0f);
+        grid.sediment.resize(num_texels, 0.0f);
+        grid.concentration.resize(num_texels, 0.0f);
+        grid.rain.resize(num_texels, 0.0f);
+        grid.outflow_left.resize(num_texels, 0.0f);
+        grid.outflow_right.resize(num_texels, 0.0f);
+        grid.outflow_up.resize(num_texels, 0.0f);
+        grid.outflow_down.resize(num_texels, 0.0f);
+
+        // Each texel's rain comes from its own word of counter-based random bits, so it doesn't depend on the order we visit the texels in
+        const auto num_heights = static_cast<Size>(width) * height;
+        Rx::Vector<RandomBlock> rain_bits{(num_heights + 3) / 4};
+        WorldRandom{settings.seed, WorldGenStage::HydraulicErosion}.fill_blocks({0, 0}, 0, {rain_bits.data(), rain_bits.size()});
+
+        for(Uint32 y = 0; y < height; y++) {
+            for(Uint32 x = 0; x < width; x++) {
+                const auto grid_index = grid.get_index(x, y);
+                const auto heightmap_index = static_cast<Size>(y) * width + x;
+                grid.terrain[grid_index] = heightmap[heightmap_index];
+
+                const auto rain = WorldRandom::to_float(rain_bits[heightmap_index / 4].words[heightmap_index % 4]);
+                grid.rain[grid_index] = settings.rain_rate * (0.5f + rain);
+            }
+        }
+
+        {
+            const auto num_bands = (height + EROSION_BAND_SIZE - 1) / EROSION_BAND_SIZE;
+            Rx::Concurrency::ThreadPool pool{Rx::Algorithm::max(num_threads, 1u), num_bands};
+
+            for(Uint32 iteration = 0; iteration < settings.num_iterations; iteration++) {
+#ifdef TERRAIN_EROSION_SSE2
+                run_pass<compute_outflow, compute_four_outflows>(pool, grid);
+                run_pass<transport, transport_four>(pool, grid);
+#else
+                run_pass<compute_outflow, compute_outflow>(pool, grid);
+                run_pass<transport, transport>(pool, grid);
+#endif
+            }
+        }
+
+        // Drop whatever sediment the water is still carrying where it is, so the erosion doesn't remove any terrain from the world
+        for(Uint32 y = 0; y < height; y++) {
+            for(Uint32 x = 0; x < width; x++) {
+                const auto grid_index = grid.get_index(x, y);
+                heightmap[static_cast<Size>(y) * width + x] = grid.terrain[grid_index] + grid.sediment[grid_index];
+            }
+        }
+    }
+} // namespace terraingen
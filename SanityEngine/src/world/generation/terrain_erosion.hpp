@@ -0,0 +1,75 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+
+namespace terraingen {
+    /*!
+     * \brief Settings for the hydraulic erosion that runs over the world heightmap
+     *
+     * Amounts of water, sediment, and terrain are all in meters of height per heightmap texel
+     */
+    struct HydraulicErosionSettings {
+        /*!
+         * \brief Seed for where the rain falls. The same seed and heightmap erode the same way no matter how many threads do the work
+         */
+        Uint32 seed{0};
+
+        Uint32 num_iterations{64};
+
+        /*!
+         * \brief Average amount of rain that falls on each texel every iteration. Each texel gets between half and one and a half times
+         * this much
+         */
+        Float32 rain_rate{0.01f};
+
+        /*!
+         * \brief Fraction of each texel's water that evaporates every iteration
+         */
+        Float32 evaporation_rate{0.02f};
+
+        /*!
+         * \brief How much sediment water can carry, relative to how much water flows through a texel
+         */
+        Float32 sediment_capacity{1.0f};
+
+        /*!
+         * \brief Fraction of a texel's unused sediment capacity that gets dissolved from the terrain every iteration
+         */
+        Float32 erosion_rate{0.3f};
+
+        /*!
+         * \brief Fraction of a texel's excess sediment that gets deposited onto the terrain every iteration
+         */
+        Float32 deposition_rate{0.3f};
+
+        /*!
+         * \brief Most terrain that may be dissolved from one texel in one iteration. Keeps fast-flowing water from digging pits
+         */
+        Float32 max_erosion_depth{0.05f};
+    };
+
+    /*!
+     * \brief Runs grid-based hydraulic erosion over a heightmap
+     *
+     * Every iteration, rain falls on every texel, water flows towards the lower neighbours of each texel, and the water dissolves terrain
+     * or deposits sediment depending on how much water flows through. Water can't leave the edges of the heightmap
+     *
+     * The heightmap is split into bands of rows that worker threads update in parallel. Each iteration is two passes with a barrier
+     * between them: the first computes every texel's outflow from the heights of its neighbours, the second moves water and sediment by
+     * reading the outflows of its neighbours. Each texel only ever reads its neighbours' results from the previous pass, so the rows just
+     * outside a band act as its halo and the results are identical for any number of threads. The passes update four texels at a time
+     * with SSE2
+     *
+     * Uses nine floats of scratch memory per texel
+     *
+     * \param heightmap The heights to erode, in rows. Modified in place
+     * \param width Number of heights in each row
+     * \param height Number of rows
+     * \param settings How to erode the heightmap
+     * \param num_threads Number of worker threads to erode with
+     */
+    void erode_heightmap(
+        std::span<Float32> heightmap, Uint32 width, Uint32 height, const HydraulicErosionSettings& settings, Uint32 num_threads);
+} // namespace terraingen
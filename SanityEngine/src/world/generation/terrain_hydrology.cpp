@@ -0,0 +1,571 @@
+#include "terrain_hydrology.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+#include "rx/core/map.h"
+
+namespace terraingen {
+    /*!
+     * \brief Width and height of the tiles that get flooded in parallel. Fixed so that the results don't depend on the number of threads
+     */
+    constexpr Uint32 FLOOD_TILE_SIZE = 256;
+
+    /*!
+     * \brief Number of rows that one task handles in the passes that look at each texel on its own
+     */
+    constexpr Uint32 HYDROLOGY_BAND_SIZE = 64;
+
+    /*!
+     * \brief Label of the area off the edge of the heightmap, where all water ends up
+     */
+    constexpr Uint32 OCEAN_LABEL = 0;
+
+    /*!
+     * \brief Flow direction of texels that we haven't found a way downhill for yet
+     */
+    constexpr Uint8 FLOW_DIRECTION_UNRESOLVED = 0xFF;
+
+    constexpr Float32 INVERSE_SQRT_2 = 0.70710678f;
+
+    struct FloodCell {
+        Float32 height;
+
+        Uint32 index;
+    };
+
+    /*!
+     * \brief Orders cells for a min-heap. Equal heights are broken by index so that the flood order never depends on the heap's history
+     */
+    static bool is_flooded_later(const FloodCell& a, const FloodCell& b) {
+        return a.height > b.height || (a.height == b.height && a.index > b.index);
+    }
+
+    /*!
+     * \brief Height at which water from one label spills into another
+     */
+    struct LabelSpill {
+        Uint32 first_label;
+
+        Uint32 second_label;
+
+        Float32 height;
+    };
+
+    struct FloodTile {
+        Uint32 min_x;
+
+        Uint32 min_y;
+
+        Uint32 max_x;
+
+        Uint32 max_y;
+
+        /*!
+         * \brief Number of labels this tile handed out. Labels are numbered from 1, since 0 is the ocean
+         */
+        Uint32 num_labels{0};
+
+        /*!
+         * \brief Number that this tile's labels are offset by to make them unique across the heightmap
+         */
+        Uint32 first_global_label{0};
+
+        Rx::Vector<LabelSpill> spills;
+
+        [[nodiscard]] bool is_on_edge(const Uint32 x, const Uint32 y) const {
+            return x == min_x || y == min_y || x == max_x - 1 || y == max_y - 1;
+        }
+
+        [[nodiscard]] bool contains(const Int32 x, const Int32 y) const {
+            return x >= static_cast<Int32>(min_x) && y >= static_cast<Int32>(min_y) && x < static_cast<Int32>(max_x) &&
+                   y < static_cast<Int32>(max_y);
+        }
+
+        [[nodiscard]] Uint32 get_global_label(const Uint32 local_label) const {
+            return local_label == OCEAN_LABEL ? OCEAN_LABEL : first_global_label + local_label - 1;
+        }
+    };
+
+    struct HydrologyGrid {
+        Uint32 width;
+
+        Uint32 height;
+
+        [[nodiscard]] bool contains(const Int32 x, const Int32 y) const {
+            return x >= 0 && y >= 0 && x < static_cast<Int32>(width) && y < static_cast<Int32>(height);
+        }
+
+        [[nodiscard]] bool is_on_edge(const Uint32 x, const Uint32 y) const {
+            return x == 0 || y == 0 || x == width - 1 || y == height - 1;
+        }
+    };
+
+    static Uint64 get_spill_key(const Uint32 first_label, const Uint32 second_label) {
+        return (static_cast<Uint64>(Rx::Algorithm::min(first_label, second_label)) << 32) | Rx::Algorithm::max(first_label, second_label);
+    }
+
+    /*!
+     * \brief Priority-floods one tile from its edges, labelling every texel with the edge texel it was flooded from
+     *
+     * Texels that are lower than the texel they were flooded from get raised to its height. They go in a plain queue instead of the heap,
+     * since they're already in the right order
+     */
+    static void flood_tile(FloodTile& tile, const HydrologyGrid& grid, Float32* filled_heights, Uint32* labels, Uint8* is_queued) {
+        ZoneScoped;
+
+        Rx::Vector<FloodCell> open;
+        Rx::Vector<Uint32> pit;
+        Size next_pit_cell = 0;
+
+        for(Uint32 y = tile.min_y; y < tile.max_y; y++) {
+            for(Uint32 x = tile.min_x; x < tile.max_x; x++) {
+                if(tile.is_on_edge(x, y)) {
+                    const auto index = y * grid.width + x;
+                    is_queued[index] = 1;
+                    open.push_back(FloodCell{filled_heights[index], index});
+                }
+            }
+        }
+        std::make_heap(open.data(), open.data() + open.size(), is_flooded_later);
+
+        Rx::Map<Uint64, Float32> spill_heights;
+        const auto add_spill = [&](const Uint32 first_label, const Uint32 second_label, const Float32 height) {
+            const auto key = get_spill_key(first_label, second_label);
+            if(auto* existing_height = spill_heights.find(key)) {
+                *existing_height = Rx::Algorithm::min(*existing_height, height);
+            } else {
+                spill_heights.insert(key, height);
+            }
+        };
+
+        while(true) {
+            Uint32 index;
+            if(next_pit_cell < pit.size()) {
+                index = pit[next_pit_cell];
+                next_pit_cell++;
+
+            } else if(!open.is_empty()) {
+                pit.clear();
+                next_pit_cell = 0;
+
+                std::pop_heap(open.data(), open.data() + open.size(), is_flooded_later);
+                index = open.last().index;
+                open.pop_back();
+
+            } else {
+                break;
+            }
+
+            if(labels[index] == 0) {
+                tile.num_labels++;
+                labels[index] = tile.num_labels;
+            }
+
+            const auto label = labels[index];
+            const auto height = filled_heights[index];
+            const auto x = index % grid.width;
+            const auto y = index / grid.width;
+
+            if(grid.is_on_edge(x, y)) {
+                add_spill(label, OCEAN_LABEL, height);
+            }
+
+            for(const auto& offset : D8_NEIGHBOUR_OFFSETS) {
+                const auto neighbour_x = static_cast<Int32>(x) + offset[0];
+                const auto neighbour_y = static_cast<Int32>(y) + offset[1];
+                if(!tile.contains(neighbour_x, neighbour_y)) {
+                    continue;
+                }
+
+                const auto neighbour = static_cast<Uint32>(neighbour_y) * grid.width + static_cast<Uint32>(neighbour_x);
+                if(is_queued[neighbour] != 0) {
+                    // Edge texels that haven't been popped yet don't have a label. They record their spills when they get one
+                    const auto neighbour_label = labels[neighbour];
+                    if(neighbour_label != 0 && neighbour_label != label) {
+                        add_spill(label, neighbour_label, Rx::Algorithm::max(height, filled_heights[neighbour]));
+                    }
+                    continue;
+                }
+
+                is_queued[neighbour] = 1;
+                labels[neighbour] = label;
+
+                if(filled_heights[neighbour] <= height) {
+                    filled_heights[neighbour] = height;
+                    pit.push_back(neighbour);
+                } else {
+                    open.push_back(FloodCell{filled_heights[neighbour], neighbour});
+                    std::push_heap(open.data(), open.data() + open.size(), is_flooded_later);
+                }
+            }
+        }
+
+        tile.spills.reserve(spill_heights.size());
+        spill_heights.each_pair([&](const Uint64 key, const Float32 height) {
+            tile.spills.push_back(LabelSpill{static_cast<Uint32>(key >> 32), static_cast<Uint32>(key & 0xFFFFFFFF), height});
+        });
+    }
+
+    /*!
+     * \brief Works out the height at which each label's water spills off the edge of the heightmap, by priority-flooding the graph of
+     * labels from the ocean
+     */
+    static Rx::Vector<Float32> get_label_spill_heights(const Rx::Vector<LabelSpill>& spills, const Uint32 num_labels) {
+        ZoneScoped;
+
+        // Compressed adjacency lists, so that the graph is a handful of allocations
+        Rx::Vector<Uint32> first_neighbour{num_labels + 1};
+        spills.each_fwd([&](const LabelSpill& spill) {
+            first_neighbour[spill.first_label + 1]++;
+            first_neighbour[spill.second_label + 1]++;
+        });
+        for(Uint32 label = 0; label < num_labels; label++) {
+            first_neighbour[label + 1] += first_neighbour[label];
+        }
+
+        Rx::Vector<FloodCell> neighbours{spills.size() * 2};
+        Rx::Vector<Uint32> num_neighbours_added{num_labels};
+        spills.each_fwd([&](const LabelSpill& spill) {
+            neighbours[first_neighbour[spill.first_label] + num_neighbours_added[spill.first_label]] = {spill.height, spill.second_label};
+            num_neighbours_added[spill.first_label]++;
+            neighbours[first_neighbour[spill.second_label] + num_neighbours_added[spill.second_label]] = {spill.height, spill.first_label};
+            num_neighbours_added[spill.second_label]++;
+        });
+
+        Rx::Vector<Float32> spill_heights;
+        spill_heights.resize(num_labels, std::numeric_limits<Float32>::infinity());
+        spill_heights[OCEAN_LABEL] = -std::numeric_limits<Float32>::infinity();
+
+        Rx::Vector<FloodCell> open;
+        open.push_back(FloodCell{spill_heights[OCEAN_LABEL], OCEAN_LABEL});
+
+        while(!open.is_empty()) {
+            std::pop_heap(open.data(), open.data() + open.size(), is_flooded_later);
+            const auto current = open.last();
+            open.pop_back();
+
+            if(current.height > spill_heights[current.index]) {
+                continue;
+            }
+
+            for(Uint32 i = first_neighbour[current.index]; i < first_neighbour[current.index + 1]; i++) {
+                const auto& neighbour = neighbours[i];
+                const auto spill_height = Rx::Algorithm::max(current.height, neighbour.height);
+                if(spill_height < spill_heights[neighbour.index]) {
+                    spill_heights[neighbour.index] = spill_height;
+                    open.push_back(FloodCell{spill_height, neighbour.index});
+                    std::push_heap(open.data(), open.data() + open.size(), is_flooded_later);
+                }
+            }
+        }
+
+        return spill_heights;
+    }
+
+    /*!
+     * \brief Calls a function for bands of rows in parallel, and waits for all of them to finish
+     */
+    template <typename FuncType>
+    static void for_each_band(Rx::Concurrency::ThreadPool& pool, const Uint32 num_rows, FuncType&& func) {
+        const auto num_bands = (num_rows + HYDROLOGY_BAND_SIZE - 1) / HYDROLOGY_BAND_SIZE;
+        Rx::Concurrency::WaitGroup bands_finished{num_bands};
+
+        for(Uint32 band = 0; band < num_bands; band++) {
+            pool.add([&, band](int /* thread_id */) {
+                const auto first_row = band * HYDROLOGY_BAND_SIZE;
+                func(first_row, Rx::Algorithm::min(first_row + HYDROLOGY_BAND_SIZE, num_rows));
+
+                bands_finished.signal();
+            });
+        }
+
+        bands_finished.wait();
+    }
+
+    static void fill_depressions(Rx::Concurrency::ThreadPool& pool, const HydrologyGrid& grid, Rx::Vector<Float32>& filled_heights) {
+        ZoneScoped;
+
+        const auto num_texels = static_cast<Size>(grid.width) * grid.height;
+        Rx::Vector<Uint32> labels{num_texels};
+        Rx::Vector<Uint8> is_queued{num_texels};
+
+        const auto num_tiles_x = (grid.width + FLOOD_TILE_SIZE - 1) / FLOOD_TILE_SIZE;
+        const auto num_tiles_y = (grid.height + FLOOD_TILE_SIZE - 1) / FLOOD_TILE_SIZE;
+
+        Rx::Vector<FloodTile> tiles;
+        tiles.reserve(num_tiles_x * num_tiles_y);
+        for(Uint32 tile_y = 0; tile_y < num_tiles_y; tile_y++) {
+            for(Uint32 tile_x = 0; tile_x < num_tiles_x; tile_x++) {
+                tiles.push_back(FloodTile{.min_x = tile_x * FLOOD_TILE_SIZE,
+                                          .min_y = tile_y * FLOOD_TILE_SIZE,
+                                          .max_x = Rx::Algorithm::min((tile_x + 1) * FLOOD_TILE_SIZE, grid.width),
+                                          .max_y = Rx::Algorithm::min((tile_y + 1) * FLOOD_TILE_SIZE, grid.height)});
+            }
+        }
+
+        {
+            Rx::Concurrency::WaitGroup tiles_flooded{tiles.size()};
+            for(Size i = 0; i < tiles.size(); i++) {
+                pool.add([&, i](int /* thread_id */) {
+                    flood_tile(tiles[i], grid, filled_heights.data(), labels.data(), is_queued.data());
+                    tiles_flooded.signal();
+                });
+            }
+            tiles_flooded.wait();
+        }
+
+        // Merge the tiles' label graphs into one graph, connecting labels that touch across tile edges
+        Uint32 num_labels = 1;
+        tiles.each_fwd([&](FloodTile& tile) {
+            tile.first_global_label = num_labels;
+            num_labels += tile.num_labels;
+        });
+
+        Rx::Vector<LabelSpill> spills;
+        tiles.each_fwd([&](const FloodTile& tile) {
+            tile.spills.each_fwd([&](const LabelSpill& spill) {
+                spills.push_back(
+                    LabelSpill{tile.get_global_label(spill.first_label), tile.get_global_label(spill.second_label), spill.height});
+            });
+
+            for(Uint32 y = tile.min_y; y < tile.max_y; y++) {
+                for(Uint32 x = tile.min_x; x < tile.max_x; x++) {
+                    if(!tile.is_on_edge(x, y)) {
+                        continue;
+                    }
+
+                    const auto index = y * grid.width + x;
+                    for(const auto& offset : D8_NEIGHBOUR_OFFSETS) {
+                        const auto neighbour_x = static_cast<Int32>(x) + offset[0];
+                        const auto neighbour_y = static_cast<Int32>(y) + offset[1];
+                        if(!grid.contains(neighbour_x, neighbour_y) || tile.contains(neighbour_x, neighbour_y)) {
+                            continue;
+                        }
+
+                        const auto neighbour_tile_index = (static_cast<Uint32>(neighbour_y) / FLOOD_TILE_SIZE) * num_tiles_x +
+                                                          static_cast<Uint32>(neighbour_x) / FLOOD_TILE_SIZE;
+                        const auto neighbour = static_cast<Uint32>(neighbour_y) * grid.width + static_cast<Uint32>(neighbour_x);
+
+                        // Both tiles see this pair of texels, so only record it once
+                        if(neighbour < index) {
+                            continue;
+                        }
+
+                        spills.push_back(LabelSpill{tile.get_global_label(labels[index]),
+                                                    tiles[neighbour_tile_index].get_global_label(labels[neighbour]),
+                                                    Rx::Algorithm::max(filled_heights[index], filled_heights[neighbour])});
+                    }
+                }
+            }
+        });
+
+        const auto label_spill_heights = get_label_spill_heights(spills, num_labels);
+
+        // Each texel was only filled to the height where it spills out of its tile. Raise it to where its water spills out of the world
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Uint32 y = first_row; y < last_row; y++) {
+                const auto tile_row_start = (y / FLOOD_TILE_SIZE) * num_tiles_x;
+                for(Uint32 x = 0; x < grid.width; x++) {
+                    const auto index = y * grid.width + x;
+                    const auto& tile = tiles[tile_row_start + x / FLOOD_TILE_SIZE];
+                    const auto spill_height = label_spill_heights[tile.get_global_label(labels[index])];
+                    filled_heights[index] = Rx::Algorithm::max(filled_heights[index], spill_height);
+                }
+            }
+        });
+    }
+
+    static void compute_flow_directions(Rx::Concurrency::ThreadPool& pool,
+                                        const HydrologyGrid& grid,
+                                        const Rx::Vector<Float32>& filled_heights,
+                                        Rx::Vector<Uint8>& flow_directions) {
+        ZoneScoped;
+
+        for_each_band(pool, grid.height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Uint32 y = first_row; y < last_row; y++) {
+                for(Uint32 x = 0; x < grid.width; x++) {
+                    const auto index = y * grid.width + x;
+                    const auto height = filled_heights[index];
+
+                    auto direction = FLOW_DIRECTION_UNRESOLVED;
+                    auto steepest_slope = 0.0f;
+                    for(Uint8 i = 0; i < 8; i++) {
+                        const auto neighbour_x = static_cast<Int32>(x) + D8_NEIGHBOUR_OFFSETS[i][0];
+                        const auto neighbour_y = static_cast<Int32>(y) + D8_NEIGHBOUR_OFFSETS[i][1];
+                        if(!grid.contains(neighbour_x, neighbour_y)) {
+                            continue;
+                        }
+
+                        const auto drop = height - filled_heights[static_cast<Size>(neighbour_y) * grid.width + neighbour_x];
+                        const auto is_diagonal = D8_NEIGHBOUR_OFFSETS[i][0] != 0 && D8_NEIGHBOUR_OFFSETS[i][1] != 0;
+                        const auto slope = is_diagonal ? drop * INVERSE_SQRT_2 : drop;
+                        if(slope > steepest_slope) {
+                            steepest_slope = slope;
+                            direction = i;
+                        }
+                    }
+
+                    if(direction == FLOW_DIRECTION_UNRESOLVED && grid.is_on_edge(x, y)) {
+                        direction = FLOW_DIRECTION_OFF_MAP;
+                    }
+
+                    flow_directions[index] = direction;
+                }
+            }
+        });
+
+        // Texels on flats don't have a downhill neighbour. Send their water towards the closest texel on the same flat that does. Filling
+        // the depressions guarantees that every flat has one
+        Rx::Vector<Uint32> open;
+        for(Uint32 y = 0; y < grid.height; y++) {
+            for(Uint32 x = 0; x < grid.width; x++) {
+                const auto index = y * grid.width + x;
+                if(flow_directions[index] == FLOW_DIRECTION_UNRESOLVED) {
+                    continue;
+                }
+
+                for(const auto& offset : D8_NEIGHBOUR_OFFSETS) {
+                    const auto neighbour_x = static_cast<Int32>(x) + offset[0];
+                    const auto neighbour_y = static_cast<Int32>(y) + offset[1];
+                    if(!grid.contains(neighbour_x, neighbour_y)) {
+                        continue;
+                    }
+
+                    const auto neighbour = static_cast<Size>(neighbour_y) * grid.width + neighbour_x;
+                    if(flow_directions[neighbour] == FLOW_DIRECTION_UNRESOLVED && filled_heights[neighbour] == filled_heights[index]) {
+                        open.push_back(index);
+                        break;
+                    }
+                }
+            }
+        }
+
+        for(Size next_cell = 0; next_cell < open.size(); next_cell++) {
+            const auto index = open[next_cell];
+            const auto x = static_cast<Int32>(index % grid.width);
+            const auto y = static_cast<Int32>(index / grid.width);
+
+            for(Uint8 i = 0; i < 8; i++) {
+                const auto neighbour_x = x + D8_NEIGHBOUR_OFFSETS[i][0];
+                const auto neighbour_y = y + D8_NEIGHBOUR_OFFSETS[i][1];
+                if(!grid.contains(neighbour_x, neighbour_y)) {
+                    continue;
+                }
+
+                const auto neighbour = static_cast<Uint32>(neighbour_y) * grid.width + static_cast<Uint32>(neighbour_x);
+                if(flow_directions[neighbour] == FLOW_DIRECTION_UNRESOLVED && filled_heights[neighbour] == filled_heights[index]) {
+                    // The offsets are symmetric, so the direction back to us is the mirror of the direction to the neighbour
+                    flow_directions[neighbour] = static_cast<Uint8>(7 - i);
+                    open.push_back(neighbour);
+                }
+            }
+        }
+    }
+
+    static void compute_flow_accumulation(const HydrologyGrid& grid,
+                                          const Rx::Vector<Uint8>& flow_directions,
+                                          Rx::Vector<Uint32>& flow_accumulation) {
+        ZoneScoped;
+
+        const auto get_downstream_texel = [&](const Uint32 index) {
+            const auto direction = flow_directions[index];
+            const auto x = static_cast<Int32>(index % grid.width) + D8_NEIGHBOUR_OFFSETS[direction][0];
+            const auto y = static_cast<Int32>(index / grid.width) + D8_NEIGHBOUR_OFFSETS[direction][1];
+            return static_cast<Uint32>(y) * grid.width + static_cast<Uint32>(x);
+        };
+
+        const auto num_texels = static_cast<Uint32>(flow_directions.size());
+        Rx::Vector<Uint8> num_upstream_texels{num_texels};
+        for(Uint32 index = 0; index < num_texels; index++) {
+            if(flow_directions[index] < FLOW_DIRECTION_OFF_MAP) {
+                num_upstream_texels[get_downstream_texel(index)]++;
+            }
+        }
+
+        // Visit each texel after everything upstream of it, starting from the ridges
+        Rx::Vector<Uint32> open;
+        for(Uint32 index = 0; index < num_texels; index++) {
+            flow_accumulation[index] = 1;
+            if(num_upstream_texels[index] == 0) {
+                open.push_back(index);
+            }
+        }
+
+        while(!open.is_empty()) {
+            const auto index = open.last();
+            open.pop_back();
+
+            if(flow_directions[index] >= FLOW_DIRECTION_OFF_MAP) {
+                continue;
+            }
+
+            const auto downstream_texel = get_downstream_texel(index);
+            flow_accumulation[downstream_texel] += flow_accumulation[index];
+            num_upstream_texels[downstream_texel]--;
+            if(num_upstream_texels[downstream_texel] == 0) {
+                open.push_back(downstream_texel);
+            }
+        }
+    }
+
+    HydrologyMaps compute_hydrology(const std::span<const Float32> heightmap,
+                                    const Uint32 width,
+                                    const Uint32 height,
+                                    const HydrologySettings& settings,
+                                    const Uint32 num_threads) {
+        ZoneScoped;
+
+        const auto num_texels = static_cast<Size>(width) * height;
+        RX_ASSERT(heightmap.size() >= num_texels,
+                  "A %ux%u heightmap needs %zu heights, but only has %zu",
+                  width,
+                  height,
+                  num_texels,
+                  heightmap.size());
+
+        HydrologyMaps maps;
+        if(num_texels == 0) {
+            return maps;
+        }
+
+        const auto grid = HydrologyGrid{width, height};
+
+        maps.filled_heights.resize(num_texels, 0.0f);
+        maps.flow_directions.resize(num_texels, FLOW_DIRECTION_UNRESOLVED);
+        maps.flow_accumulation.resize(num_texels, 0u);
+        maps.river_mask.resize(num_texels, static_cast<Uint8>(0));
+        maps.lake_mask.resize(num_texels, static_cast<Uint8>(0));
+
+        for(Size i = 0; i < num_texels; i++) {
+            maps.filled_heights[i] = heightmap[i];
+        }
+
+        const auto num_tiles = ((width + FLOOD_TILE_SIZE - 1) / FLOOD_TILE_SIZE) * ((height + FLOOD_TILE_SIZE - 1) / FLOOD_TILE_SIZE);
+        const auto num_bands = (height + HYDROLOGY_BAND_SIZE - 1) / HYDROLOGY_BAND_SIZE;
+        Rx::Concurrency::ThreadPool pool{Rx::Algorithm::max(num_threads, 1u), Rx::Algorithm::max(num_tiles, num_bands)};
+
+        fill_depressions(pool, grid, maps.filled_heights);
+
+        compute_flow_directions(pool, grid, maps.filled_heights, maps.flow_directions);
+
+        compute_flow_accumulation(grid, maps.flow_directions, maps.flow_accumulation);
+
+        for_each_band(pool, height, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(Size i = static_cast<Size>(first_row) * width; i < static_cast<Size>(last_row) * width; i++) {
+                const auto is_lake = maps.filled_heights[i] - heightmap[i] > settings.min_lake_depth;
+                const auto is_river = !is_lake && maps.flow_accumulation[i] >= settings.min_river_upstream_texels;
+                maps.lake_mask[i] = is_lake ? 1 : 0;
+                maps.river_mask[i] = is_river ? 1 : 0;
+            }
+        });
+
+        return maps;
+    }
+} // namespace terraingen
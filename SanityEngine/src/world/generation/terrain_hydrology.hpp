@@ -0,0 +1,83 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace terraingen {
+    /*!
+     * \brief Flow direction of a texel that drains off the edge of the heightmap
+     *
+     * Other texels store the index of the neighbour they drain into, in the order of `D8_NEIGHBOUR_OFFSETS`
+     */
+    constexpr Uint8 FLOW_DIRECTION_OFF_MAP = 8;
+
+    /*!
+     * \brief Offsets to a texel's eight neighbours, as (x, y)
+     */
+    constexpr Int32 D8_NEIGHBOUR_OFFSETS[8][2] = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+    struct HydrologySettings {
+        /*!
+         * \brief How far below the surface of a filled depression a texel must be to count as part of a lake, in meters
+         */
+        Float32 min_lake_depth{0.05f};
+
+        /*!
+         * \brief How many texels must drain through a texel for it to count as part of a river
+         */
+        Uint32 min_river_upstream_texels{256};
+    };
+
+    struct HydrologyMaps {
+        /*!
+         * \brief The heightmap with every depression filled up to the height where it would spill over. This is the surface of the lakes
+         */
+        Rx::Vector<Float32> filled_heights;
+
+        /*!
+         * \brief Which neighbour each texel drains into, or `FLOW_DIRECTION_OFF_MAP`
+         */
+        Rx::Vector<Uint8> flow_directions;
+
+        /*!
+         * \brief Number of texels that drain through each texel, including itself
+         */
+        Rx::Vector<Uint32> flow_accumulation;
+
+        /*!
+         * \brief 1 for texels that are part of a river, 0 for everything else. Lakes aren't rivers
+         */
+        Rx::Vector<Uint8> river_mask;
+
+        /*!
+         * \brief 1 for texels that are part of a lake, 0 for everything else
+         */
+        Rx::Vector<Uint8> lake_mask;
+    };
+
+    /*!
+     * \brief Works out where water on a heightmap would pool into lakes and flow as rivers
+     *
+     * Depressions are filled with a priority-flood, which is O(n log n) in the number of texels. The heightmap is split into fixed-size
+     * tiles that get flooded in parallel, each from its own edges. Every tile labels its texels with the tile edge texel they were flooded
+     * from and records the height at which neighbouring labels spill into each other. A small serial priority-flood over that graph of
+     * labels works out the height at which each label spills off the edge of the heightmap, and a last parallel pass raises every texel to
+     * at least its label's spill height. This gives exactly the same heights as flooding the whole heightmap at once
+     *
+     * Each texel then drains into its steepest downhill neighbour. Texels on the flat surface of a filled depression drain towards the
+     * closest texel that can flow downhill, so water finds its way across lakes. Flow accumulation follows the drainage network in
+     * topological order
+     *
+     * Water drains off every edge of the heightmap. The results don't depend on the number of threads
+     *
+     * \param heightmap The heights to analyse, in rows
+     * \param width Number of heights in each row
+     * \param height Number of rows
+     * \param settings Thresholds for what counts as a lake or a river
+     * \param num_threads Number of worker threads to use
+     */
+    [[nodiscard]] HydrologyMaps compute_hydrology(
+        std::span<const Float32> heightmap, Uint32 width, Uint32 height, const HydrologySettings& settings, Uint32 num_threads);
+} // namespace terraingen
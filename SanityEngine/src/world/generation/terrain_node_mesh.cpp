@@ -0,0 +1,116 @@
+#include "terrain_node_mesh.hpp"
+
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "world/generation/terrain_normals.hpp"
+
+namespace terraingen {
+    /*!
+     * \brief Smallest height range that a node's vertices get quantized across, so that flat nodes don't divide by zero
+     */
+    constexpr Float32 MIN_NODE_HEIGHT_RANGE = 0.01f;
+
+    TerrainNodeMesh generate_terrain_node_mesh(const NoiseConfig& config,
+                                               const TerrainNodeKey& node,
+                                               const Uint32 tile_size,
+                                               const Float32 min_terrain_height,
+                                               const Float32 max_terrain_height,
+                                               const Float32 skirt_depth,
+                                               TileHeightmap* heightmap) {
+        ZoneScoped;
+
+        // One more vertex than the node has quads, so that the node's far edge is the same as its neighbour's near edge
+        const auto grid_size = tile_size + 1;
+        const auto texel_size = node.get_texel_size();
+
+        HeightGradients gradients;
+        const auto apron_heights = fill_heights_with_apron(config,
+                                                           node.get_top_left(tile_size),
+                                                           texel_size,
+                                                           grid_size,
+                                                           min_terrain_height,
+                                                           max_terrain_height,
+                                                           &gradients);
+
+        return build_terrain_node_mesh(apron_heights, grid_size, static_cast<Float32>(texel_size), skirt_depth, heightmap, &gradients);
+    }
+
+    void copy_apron_heights_to_heightmap(const std::span<const Float32> apron_heights, const Uint32 grid_size, TileHeightmap& heightmap) {
+        RX_ASSERT(heightmap.size <= grid_size, "Heightmap of size %u is bigger than the node's grid", heightmap.size);
+
+        const auto apron_size = grid_size + 2;
+        for(Uint32 y = 0; y < heightmap.size; y++) {
+            memcpy(heightmap.heights + static_cast<Size>(y) * heightmap.size,
+                   apron_heights.data() + static_cast<Size>(y + 1) * apron_size + 1,
+                   heightmap.size * sizeof(Float32));
+        }
+    }
+
+    TerrainNodeMesh build_terrain_node_mesh(const std::span<const Float32> apron_heights,
+                                            const Uint32 grid_size,
+                                            const Float32 texel_size,
+                                            const Float32 skirt_depth,
+                                            TileHeightmap* heightmap,
+                                            const HeightGradients* gradients) {
+        ZoneScoped;
+
+        const auto apron_size = grid_size + 2;
+        RX_ASSERT(apron_heights.size() == static_cast<Size>(apron_size) * apron_size,
+                  "Node with a grid of size %u needs %u apron heights, but %zu were provided",
+                  grid_size,
+                  apron_size * apron_size,
+                  apron_heights.size());
+
+        const auto height_at = [&](const Uint32 x, const Uint32 y) { return apron_heights[(y + 1) * apron_size + x + 1]; };
+
+        if(heightmap != nullptr) {
+            copy_apron_heights_to_heightmap(apron_heights, grid_size, *heightmap);
+        }
+
+        // Nothing writes to the apron heights while we mesh them, so we can compute every normal in the node without any locking
+        Rx::Vector<Vec3f> normals{grid_size * grid_size};
+        if(gradients != nullptr && !gradients->x.empty()) {
+            compute_tile_normals_from_gradients(*gradients, grid_size, {normals.data(), normals.size()}, texel_size);
+        } else {
+            compute_tile_normals(apron_heights, grid_size, {normals.data(), normals.size()}, texel_size);
+        }
+
+        auto min_height = height_at(0, 0);
+        auto max_height = min_height;
+        for(Uint32 y = 0; y < grid_size; y++) {
+            for(Uint32 x = 0; x < grid_size; x++) {
+                min_height = Rx::Algorithm::min(min_height, height_at(x, y));
+                max_height = Rx::Algorithm::max(max_height, height_at(x, y));
+            }
+        }
+
+        // Quantize the heights across this node's own height range, which keeps more precision than the whole terrain's range would. The
+        // node's model matrix scales them back up
+        TerrainNodeMesh mesh{.min_height = min_height - skirt_depth};
+        mesh.max_height = Rx::Algorithm::max(max_height, mesh.min_height + MIN_NODE_HEIGHT_RANGE);
+        const auto height_range = mesh.max_height - mesh.min_height;
+
+        mesh.vertices.reserve(get_num_terrain_tile_vertices(grid_size));
+
+        for(Uint32 y = 0; y < grid_size; y++) {
+            for(Uint32 x = 0; x < grid_size; x++) {
+                const auto normalized_height = (height_at(x, y) - mesh.min_height) / height_range;
+                mesh.vertices.push_back(make_terrain_vertex(normalized_height, normals[y * grid_size + x]));
+            }
+        }
+
+        // Skirt vertices sit right below their edge vertex, and share its normal so the skirt is lit like the terrain above it
+        const auto num_skirt_vertices = get_num_terrain_skirt_vertices(grid_size);
+        for(Uint32 skirt_index = 0; skirt_index < num_skirt_vertices; skirt_index++) {
+            const auto edge_position = get_terrain_skirt_grid_position(skirt_index, grid_size);
+            const auto normalized_height = (height_at(edge_position.x, edge_position.y) - skirt_depth - mesh.min_height) / height_range;
+            mesh.vertices.push_back(make_terrain_vertex(normalized_height, normals[edge_position.y * grid_size + edge_position.x]));
+        }
+
+        return mesh;
+    }
+} // namespace terraingen
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rhi/terrain_vertex.hpp"
+#include "rx/core/vector.h"
+#include "world/generation/terrain_noise.hpp"
+#include "world/heightmap_tile_pool.hpp"
+#include "world/terrain_lod.hpp"
+
+namespace terraingen {
+    /*!
+     * \brief Mesh for one node of the terrain quadtree
+     *
+     * The vertices are a grid with `tile_size + 1` vertices on each side, followed by the skirt. Their heights are normalized to
+     * [min_height, max_height]
+     */
+    struct TerrainNodeMesh {
+        Rx::Vector<TerrainVertex> vertices;
+
+        /*!
+         * \brief The height that a normalized height of 0 maps to. This is below the node's lowest height, to make room for the skirt
+         */
+        Float32 min_height{0};
+
+        Float32 max_height{0};
+    };
+
+    /*!
+     * \brief Generates the mesh for a node of the terrain quadtree
+     *
+     * Nodes at every level use the same number of vertices, spaced further apart at coarser levels. The grid includes the node's far
+     * edge, so neighbouring nodes share their edge vertices and line up without gaps
+     *
+     * Doesn't touch the renderer or any shared state, so it's safe to call from any number of threads at once
+     *
+     * \param config Noise settings to generate the heights with
+     * \param node The node to mesh
+     * \param tile_size Width of a level 0 node, in meters
+     * \param min_terrain_height The height that a noise value of 0 maps to
+     * \param max_terrain_height The height that a noise value of 1 maps to
+     * \param skirt_depth How far the skirt hangs below the edges of the node, in meters
+     * \param heightmap If not nullptr, the node's heights get copied into this heightmap. Only meaningful for level 0 nodes, whose
+     * heightmaps are used for gameplay queries
+     */
+    [[nodiscard]] TerrainNodeMesh generate_terrain_node_mesh(const NoiseConfig& config,
+                                                             const TerrainNodeKey& node,
+                                                             Uint32 tile_size,
+                                                             Float32 min_terrain_height,
+                                                             Float32 max_terrain_height,
+                                                             Float32 skirt_depth,
+                                                             TileHeightmap* heightmap = nullptr);
+
+    /*!
+     * \brief Meshes a node from heights that were already generated, such as heights from the terrain tile cache
+     *
+     * \param apron_heights The node's heights plus a one-texel apron, as returned by `fill_heights_with_apron`
+     * \param grid_size Number of vertices on each side of the node's grid
+     * \param texel_size Distance between neighbouring heights, in meters
+     * \param skirt_depth How far the skirt hangs below the edges of the node, in meters
+     * \param heightmap If not nullptr, the node's heights get copied into this heightmap
+     * \param gradients If not nullptr and not empty, the normals come from these analytic gradients instead of central differences of the
+     * heights
+     */
+    [[nodiscard]] TerrainNodeMesh build_terrain_node_mesh(std::span<const Float32> apron_heights,
+                                                          Uint32 grid_size,
+                                                          Float32 texel_size,
+                                                          Float32 skirt_depth,
+                                                          TileHeightmap* heightmap = nullptr,
+                                                          const HeightGradients* gradients = nullptr);
+
+    /*!
+     * \brief Copies the heights inside a node's apron into a heightmap
+     *
+     * The heightmap may be smaller than the grid, in which case only its top left corner gets copied
+     */
+    void copy_apron_heights_to_heightmap(std::span<const Float32> apron_heights, Uint32 grid_size, TileHeightmap& heightmap);
+} // namespace terraingen
@@ -0,0 +1,351 @@
+#include "terrain_noise.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/concurrency/wait_group.h"
+#include "rx/core/hash.h"
+
+namespace terraingen {
+    /*!
+     * \brief Number of values that `generate_noise_set` aims for in each block. A block and its copy in the worker's scratch set are 128 KB
+     * together, which fits in the L2 cache of anything we run on
+     */
+    constexpr Size NOISE_SET_BLOCK_SIZE = 16 * 1024;
+
+    /*!
+     * \brief A noise generator owned by a single thread
+     */
+    struct ThreadNoiseGenerator {
+        NoiseConfig config;
+
+        std::unique_ptr<FastNoiseSIMD> generator;
+    };
+
+    /*!
+     * \brief Scratch memory for noise, owned by a single thread
+     *
+     * The memory comes from FastNoiseSIMD so that it's aligned and padded well enough for FastNoiseSIMD's aligned stores
+     */
+    struct ThreadNoiseSet {
+        Float32* values{nullptr};
+
+        Size capacity{0};
+
+        ThreadNoiseSet() = default;
+
+        ThreadNoiseSet(const ThreadNoiseSet& other) = delete;
+        ThreadNoiseSet& operator=(const ThreadNoiseSet& other) = delete;
+
+        ThreadNoiseSet(ThreadNoiseSet&& old) noexcept = delete;
+        ThreadNoiseSet& operator=(ThreadNoiseSet&& old) noexcept = delete;
+
+        ~ThreadNoiseSet() { FastNoiseSIMD::FreeNoiseSet(values); }
+
+        void reserve(const Size size) {
+            if(size <= capacity) {
+                return;
+            }
+
+            FastNoiseSIMD::FreeNoiseSet(values);
+            values = FastNoiseSIMD::GetEmptySet(static_cast<int>(size));
+            capacity = size;
+        }
+    };
+
+    static thread_local ThreadNoiseGenerator thread_noise_generator;
+
+    /*!
+     * \brief Heights plus their apron, for `fill_heights_with_apron`
+     */
+    static thread_local ThreadNoiseSet thread_apron_heightmap;
+
+    /*!
+     * \brief Derivatives of the heights plus their apron along FastNoiseSIMD's x, y, and z axes, for `fill_heights_with_apron`
+     */
+    static thread_local ThreadNoiseSet thread_apron_derivatives[3];
+
+    /*!
+     * \brief One block of a `generate_noise_set`
+     */
+    static thread_local ThreadNoiseSet thread_noise_set_block;
+
+    /*!
+     * \brief Sample positions of a cube sphere tile, for `fill_cube_sphere_tile_heightmap`
+     */
+    static thread_local FastNoiseVectorSet thread_cube_sphere_positions;
+
+    /*!
+     * \brief Fills a square of heights, stored row-major
+     *
+     * FastNoiseSIMD stores its sets x-major, so we hand it the world's z axis as its x axis. That way our rows run along the world's x axis
+     *
+     * The terrain is a 2D slice of 3D noise. The slice is at 0 so that it stays put when coarse LODs scale the frequency
+     */
+    static void fill_heights(FastNoiseSIMD& noise_generator, Float32* heights, const Vec2i& top_left, const Int32 size) {
+        noise_generator.FillNoiseSet(heights, top_left.y, top_left.x, 0, size, size, 1);
+    }
+
+    /*!
+     * \brief Fills a square of heights like `fill_heights`, along with their derivatives along each of FastNoiseSIMD's axes
+     *
+     * \return Whether the noise type has derivatives. If it doesn't, nothing gets filled
+     */
+    static bool fill_heights_with_derivatives(FastNoiseSIMD& noise_generator,
+                                              Float32* heights,
+                                              Float32* derivatives[3],
+                                              const Vec2i& top_left,
+                                              const Int32 size) {
+        return noise_generator
+            .FillNoiseSetWithDerivatives(heights, derivatives[0], derivatives[1], derivatives[2], top_left.y, top_left.x, 0, size, size, 1);
+    }
+
+    std::unique_ptr<FastNoiseSIMD> NoiseConfig::create_generator() const {
+        auto generator = std::unique_ptr<FastNoiseSIMD>{FastNoiseSIMD::NewFastNoiseSIMD(seed)};
+        apply_to(*generator);
+
+        return generator;
+    }
+
+    void NoiseConfig::apply_to(FastNoiseSIMD& generator) const {
+        generator.SetSeed(seed);
+        generator.SetNoiseType(noise_type);
+        generator.SetFrequency(frequency);
+        generator.SetFractalType(fractal_type);
+        generator.SetFractalOctaves(octaves);
+        generator.SetFractalLacunarity(lacunarity);
+        generator.SetFractalGain(gain);
+    }
+
+    Size NoiseConfig::hash() const {
+        auto hash = Rx::Hash<Int32>{}(seed);
+        hash = Rx::hash_combine(hash, Rx::Hash<Int32>{}(static_cast<Int32>(noise_type)));
+        hash = Rx::hash_combine(hash, Rx::Hash<Float32>{}(frequency));
+        hash = Rx::hash_combine(hash, Rx::Hash<Int32>{}(static_cast<Int32>(fractal_type)));
+        hash = Rx::hash_combine(hash, Rx::Hash<Int32>{}(octaves));
+        hash = Rx::hash_combine(hash, Rx::Hash<Float32>{}(lacunarity));
+        hash = Rx::hash_combine(hash, Rx::Hash<Float32>{}(gain));
+
+        return hash;
+    }
+
+    bool NoiseConfig::operator==(const NoiseConfig& other) const {
+        return seed == other.seed && noise_type == other.noise_type && frequency == other.frequency && fractal_type == other.fractal_type &&
+               octaves == other.octaves && lacunarity == other.lacunarity && gain == other.gain;
+    }
+
+    bool NoiseConfig::operator!=(const NoiseConfig& other) const { return !(*this == other); }
+
+    FastNoiseSIMD& get_thread_noise_generator(const NoiseConfig& config) {
+        if(!thread_noise_generator.generator) {
+            thread_noise_generator.generator = config.create_generator();
+            thread_noise_generator.config = config;
+            thread_noise_generator.generator->SetOutputRemap(1, 0);
+
+        } else if(thread_noise_generator.config != config) {
+            config.apply_to(*thread_noise_generator.generator);
+            thread_noise_generator.config = config;
+            thread_noise_generator.generator->SetOutputRemap(1, 0);
+        }
+
+        return *thread_noise_generator.generator;
+    }
+
+    void fill_tile_heightmap(
+        const NoiseConfig& config, const Vec2i& top_left, TileHeightmap& heightmap, const Float32 min_height, const Float32 max_height) {
+        ZoneScoped;
+
+        const auto size = static_cast<Int32>(heightmap.size);
+
+        auto& noise_generator = get_thread_noise_generator(config);
+        noise_generator.SetOutputRemap(max_height - min_height, min_height);
+        fill_heights(noise_generator, heightmap.heights, top_left, size);
+    }
+
+    void fill_tile_heightmap_at_origin(
+        const NoiseConfig& config, const Vec2d& top_left, TileHeightmap& heightmap, const Float32 min_height, const Float32 max_height) {
+        ZoneScoped;
+
+        const auto size = static_cast<Int32>(heightmap.size);
+
+        auto& noise_generator = get_thread_noise_generator(config);
+        noise_generator.SetOutputRemap(max_height - min_height, min_height);
+
+        // Same axis swap as `fill_heights`
+        if(!noise_generator.FillNoiseSetAtOrigin(heightmap.heights, top_left.y, top_left.x, 0, size, size, 1)) {
+            const auto rounded_top_left = Vec2i{static_cast<Int32>(std::round(top_left.x)), static_cast<Int32>(std::round(top_left.y))};
+            fill_heights(noise_generator, heightmap.heights, rounded_top_left, size);
+        }
+    }
+
+    void fill_cube_sphere_tile_heightmap(const NoiseConfig& config,
+                                         const CubeSphereTileKey& tile,
+                                         const Float64 radius,
+                                         TileHeightmap& heightmap,
+                                         const Float32 min_height,
+                                         const Float32 max_height) {
+        ZoneScoped;
+
+        RX_ASSERT(heightmap.size >= 2, "Cube sphere heightmaps need at least two texels along each edge");
+
+        const auto size = heightmap.size;
+        const auto num_heights = static_cast<int>(size * size);
+        if(thread_cube_sphere_positions.size != num_heights) {
+            thread_cube_sphere_positions.SetSize(num_heights);
+        }
+
+        // Every row has the same u tangents and every column has the same v tangents, so only compute them once
+        const auto min_uv = tile.get_min_uv();
+        const auto uv_per_texel = tile.get_uv_size() / static_cast<Float64>(size - 1);
+        Rx::Vector<Float64> u_tangents{size};
+        Rx::Vector<Float64> v_tangents{size};
+        for(Uint32 i = 0; i < size; i++) {
+            u_tangents[i] = get_cube_face_tangent(min_uv.x + i * uv_per_texel);
+            v_tangents[i] = get_cube_face_tangent(min_uv.y + i * uv_per_texel);
+        }
+
+        const auto& axes = get_cube_face_axes(tile.face);
+        const auto origin = get_cube_sphere_tile_center(tile) * radius;
+
+        auto* x_positions = thread_cube_sphere_positions.xSet;
+        auto* y_positions = thread_cube_sphere_positions.ySet;
+        auto* z_positions = thread_cube_sphere_positions.zSet;
+        for(Uint32 y = 0; y < size; y++) {
+            const auto row_point = axes.normal + axes.v_axis * v_tangents[y];
+            for(Uint32 x = 0; x < size; x++) {
+                const auto point = row_point + axes.u_axis * u_tangents[x];
+                const auto position = point * (radius / std::sqrt(Rx::Math::dot(point, point))) - origin;
+
+                const auto index = y * size + x;
+                x_positions[index] = static_cast<Float32>(position.x);
+                y_positions[index] = static_cast<Float32>(position.y);
+                z_positions[index] = static_cast<Float32>(position.z);
+            }
+        }
+
+        auto& noise_generator = get_thread_noise_generator(config);
+        noise_generator.SetOutputRemap(max_height - min_height, min_height);
+
+        if(!noise_generator.FillNoiseSetAtOrigin(heightmap.heights, &thread_cube_sphere_positions, origin.x, origin.y, origin.z)) {
+            noise_generator.FillNoiseSet(heightmap.heights,
+                                         &thread_cube_sphere_positions,
+                                         static_cast<Float32>(origin.x),
+                                         static_cast<Float32>(origin.y),
+                                         static_cast<Float32>(origin.z));
+        }
+    }
+
+    Rx::Vector<Float32> generate_noise_set(const NoiseConfig& config,
+                                           const Vec2i& start,
+                                           const Vec2u& size,
+                                           const Float32 min_value,
+                                           const Float32 max_value,
+                                           const Uint32 num_threads) {
+        ZoneScoped;
+
+        const auto num_values = static_cast<Size>(size.x) * size.y;
+        Rx::Vector<Float32> noise_set{num_values};
+        if(num_values == 0) {
+            return noise_set;
+        }
+
+        // Makes sure that FastNoiseSIMD's static data is initialized before the workers make their own generators
+        [[maybe_unused]] const auto& noise_generator = get_thread_noise_generator(config);
+
+        const auto rows_per_block = Rx::Algorithm::max(static_cast<Uint32>(NOISE_SET_BLOCK_SIZE / size.y), 1u);
+        const auto num_blocks = (size.x + rows_per_block - 1) / rows_per_block;
+
+        Rx::Concurrency::ThreadPool pool{Rx::Algorithm::max(num_threads, 1u), num_blocks};
+        Rx::Concurrency::WaitGroup blocks_finished{num_blocks};
+
+        for(Uint32 block = 0; block < num_blocks; block++) {
+            pool.add([&, block](int /* thread_id */) {
+                ZoneScopedN("generate_noise_set block");
+
+                const auto first_row = block * rows_per_block;
+                const auto num_rows = Rx::Algorithm::min(rows_per_block, size.x - first_row);
+                const auto num_block_values = static_cast<Size>(num_rows) * size.y;
+
+                thread_noise_set_block.reserve(num_block_values);
+
+                auto& block_generator = get_thread_noise_generator(config);
+                block_generator.SetOutputRemap(max_value - min_value, min_value);
+                block_generator.FillNoiseSet(thread_noise_set_block.values,
+                                             start.x + static_cast<Int32>(first_row),
+                                             start.y,
+                                             0,
+                                             static_cast<Int32>(num_rows),
+                                             static_cast<Int32>(size.y),
+                                             1);
+
+                memcpy(noise_set.data() + static_cast<Size>(first_row) * size.y,
+                       thread_noise_set_block.values,
+                       num_block_values * sizeof(Float32));
+
+                blocks_finished.signal();
+            });
+        }
+
+        blocks_finished.wait();
+
+        return noise_set;
+    }
+
+    std::span<const Float32> fill_heights_with_apron(const NoiseConfig& config,
+                                                     const Vec2i& top_left,
+                                                     const Uint32 texel_size,
+                                                     const Uint32 size,
+                                                     const Float32 min_height,
+                                                     const Float32 max_height,
+                                                     HeightGradients* gradients) {
+        ZoneScoped;
+
+        const auto texel_size_int = static_cast<Int32>(texel_size);
+        RX_ASSERT(top_left.x % texel_size_int == 0 && top_left.y % texel_size_int == 0,
+                  "Top left (%d, %d) is not a multiple of the texel size %u",
+                  top_left.x,
+                  top_left.y,
+                  texel_size);
+
+        const auto apron_size = size + 2;
+        const auto num_apron_heights = static_cast<Size>(apron_size) * apron_size;
+
+        thread_apron_heightmap.reserve(num_apron_heights);
+        auto* apron_heights = thread_apron_heightmap.values;
+
+        // FastNoiseSIMD samples integer coordinates. Scaling the frequency up by the texel size lets us sample every `texel_size`th meter
+        // of the full-resolution terrain
+        auto scaled_config = config;
+        scaled_config.frequency *= static_cast<Float32>(texel_size);
+
+        auto& noise_generator = get_thread_noise_generator(scaled_config);
+        noise_generator.SetOutputRemap(max_height - min_height, min_height);
+
+        const auto apron_top_left = top_left / texel_size_int - Vec2i{1, 1};
+        if(gradients != nullptr) {
+            *gradients = {};
+
+            Float32* derivatives[3];
+            for(Uint32 axis = 0; axis < 3; axis++) {
+                thread_apron_derivatives[axis].reserve(num_apron_heights);
+                derivatives[axis] = thread_apron_derivatives[axis].values;
+            }
+
+            // The derivatives are per unit of FastNoiseSIMD's coordinates, which are texels. Its x axis runs from one row to the next
+            if(fill_heights_with_derivatives(noise_generator, apron_heights, derivatives, apron_top_left, static_cast<Int32>(apron_size))) {
+                *gradients = {.x = {derivatives[1], num_apron_heights}, .y = {derivatives[0], num_apron_heights}};
+
+                return {apron_heights, num_apron_heights};
+            }
+        }
+
+        fill_heights(noise_generator, apron_heights, apron_top_left, static_cast<Int32>(apron_size));
+
+        return {apron_heights, num_apron_heights};
+    }
+} // namespace terraingen
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <memory>
+#include <span>
+
+#include "core/types.hpp"
+#include "noise/FastNoiseSIMD/FastNoiseSIMD.h"
+#include "rx/core/vector.h"
+#include "world/cube_sphere.hpp"
+#include "world/heightmap_tile_pool.hpp"
+
+namespace terraingen {
+    /*!
+     * \brief Immutable description of the noise that generates the terrain
+     *
+     * FastNoiseSIMD objects are cheap to make but not safe to share between threads while someone's changing their settings. Instead of
+     * sharing one generator behind a mutex, we capture the settings once and let every worker thread build its own generator from them
+     */
+    struct NoiseConfig {
+        Int32 seed{1337};
+
+        FastNoiseSIMD::NoiseType noise_type{FastNoiseSIMD::PerlinFractal};
+
+        Float32 frequency{1.0f / 64.0f};
+
+        FastNoiseSIMD::FractalType fractal_type{FastNoiseSIMD::FBM};
+
+        Int32 octaves{10};
+
+        Float32 lacunarity{2.0f};
+
+        Float32 gain{0.5f};
+
+        /*!
+         * \brief Creates a new noise generator with these settings
+         *
+         * FastNoiseSIMD allocates its generators with `new`, so they have to be owned by something that releases them with `delete`
+         */
+        [[nodiscard]] std::unique_ptr<FastNoiseSIMD> create_generator() const;
+
+        /*!
+         * \brief Applies these settings to an existing noise generator
+         */
+        void apply_to(FastNoiseSIMD& generator) const;
+
+        [[nodiscard]] Size hash() const;
+
+        [[nodiscard]] bool operator==(const NoiseConfig& other) const;
+
+        [[nodiscard]] bool operator!=(const NoiseConfig& other) const;
+    };
+
+    /*!
+     * \brief Gets a noise generator for the calling thread, configured with the provided settings
+     *
+     * Each thread gets its own generator, so callers may use it without any locking. The generator is reconfigured if the thread asks for
+     * a different config than last time, which also resets its output remap. Asking for the same config again keeps whatever remap the
+     * last caller set, so every caller has to set the remap it wants after getting the generator
+     *
+     * FastNoiseSIMD initializes some static SIMD constants the first time a generator is constructed. Make sure one generator has been
+     * constructed on the main thread (World::create does this) before calling this from worker threads
+     */
+    [[nodiscard]] FastNoiseSIMD& get_thread_noise_generator(const NoiseConfig& config);
+
+    /*!
+     * \brief Fills a tile heightmap with terrain heights, remapped into the range [min_height, max_height]
+     *
+     * The heightmap's x axis runs along the world's x axis, so neighbouring tiles line up. Safe to call from any number of threads at once
+     *
+     * \param config The noise settings to generate the heightmap with
+     * \param top_left World x and y coordinates of the top left of the heightmap
+     * \param heightmap The heightmap to fill. Its size determines how many heights get generated
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    void fill_tile_heightmap(
+        const NoiseConfig& config, const Vec2i& top_left, TileHeightmap& heightmap, Float32 min_height, Float32 max_height);
+
+    /*!
+     * \brief Fills a tile heightmap like `fill_tile_heightmap`, but from a double precision top left, for planet-sized worlds
+     *
+     * `fill_tile_heightmap` hands FastNoiseSIMD float coordinates, which can't tell neighbouring heights apart once they're tens of
+     * kilometers from the origin, so the terrain comes out in flat bands. This splits every octave's top left into a lattice cell and a
+     * small float offset from it instead, so the heights are just as precise on the far side of the planet as they are at the origin
+     *
+     * Falls back to `fill_tile_heightmap` at the nearest whole coordinates for noise types that FastNoiseSIMD can't sample at a double
+     * precision origin. Safe to call from any number of threads at once
+     *
+     * \param config The noise settings to generate the heightmap with
+     * \param top_left World x and y coordinates of the top left of the heightmap
+     * \param heightmap The heightmap to fill. Its size determines how many heights get generated
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    void fill_tile_heightmap_at_origin(
+        const NoiseConfig& config, const Vec2d& top_left, TileHeightmap& heightmap, Float32 min_height, Float32 max_height);
+
+    /*!
+     * \brief Fills a cube sphere tile's heightmap with terrain heights, remapped into the range [min_height, max_height]
+     *
+     * The terrain is 3D noise sampled on the surface of the planet, so it doesn't stretch or pinch anywhere and it continues across the
+     * edges of the cube's faces. Texel (x, y) is at `x / (size - 1)` and `y / (size - 1)` of the way across the tile, so tiles that share
+     * an edge sample the same points along it. The sample positions are computed in doubles relative to the tile's center, and the noise
+     * is sampled at that center with `FastNoiseSIMD::FillNoiseSetAtOrigin`, so deep tiles are as precise on the far side of an Earth-sized
+     * planet as they are anywhere else
+     *
+     * Noise types that FastNoiseSIMD can't sample at a double precision origin are sampled with float positions instead. Safe to call from
+     * any number of threads at once
+     *
+     * \param config The noise settings to generate the heightmap with
+     * \param tile The tile to generate
+     * \param radius Radius of the planet, in meters. Noise is sampled at the planet's surface, so the noise frequency is per meter of it
+     * \param heightmap The heightmap to fill. Its size determines how many heights get generated, and must be at least 2
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     */
+    void fill_cube_sphere_tile_heightmap(const NoiseConfig& config,
+                                         const CubeSphereTileKey& tile,
+                                         Float64 radius,
+                                         TileHeightmap& heightmap,
+                                         Float32 min_height,
+                                         Float32 max_height);
+
+    /*!
+     * \brief Generates a large 2D set of noise on a pool of worker threads, remapped into the range [min_value, max_value]
+     *
+     * The set is split into blocks of whole rows that are small enough to stay in the L2 cache. Each worker fills a block into its own
+     * aligned scratch set with its own generator, with the remap done by the noise kernel as it stores each value, then copies the block
+     * into place. Every value only depends on its own coordinates, so the set comes out the same no matter how many threads fill it
+     *
+     * FastNoiseSIMD fills its sets x-major, so the set has `size.x` rows of `size.y` values
+     *
+     * \param config The noise settings to generate the set with
+     * \param start Noise coordinates of the first value
+     * \param size Number of values along each axis
+     * \param min_value The value that a noise value of 0 maps to
+     * \param max_value The value that a noise value of 1 maps to
+     * \param num_threads Number of worker threads to fill the blocks on
+     */
+    [[nodiscard]] Rx::Vector<Float32> generate_noise_set(
+        const NoiseConfig& config, const Vec2i& start, const Vec2u& size, Float32 min_value, Float32 max_value, Uint32 num_threads);
+
+    /*!
+     * \brief Analytic slopes of a square of heights plus its apron, in the same layout as the heights
+     */
+    struct HeightGradients {
+        /*!
+         * \brief Change in height per texel along each row
+         */
+        std::span<const Float32> x;
+
+        /*!
+         * \brief Change in height per texel from one row to the next
+         */
+        std::span<const Float32> y;
+    };
+
+    /*!
+     * \brief Generates a square of heights plus a one-texel apron around them, for meshing
+     *
+     * Meshing needs the heights just outside the square to compute the normals on its edges. Generating the apron in the same noise pass
+     * as the square is much cheaper than looking the heights up in the neighbouring tiles, which might not even be loaded
+     *
+     * The heights are `texel_size` meters apart. Coarse terrain LODs use a bigger texel size, which generates the same terrain at a lower
+     * resolution
+     *
+     * \param config The noise settings to generate the heights with
+     * \param top_left World x and y coordinates of the first height inside the apron. Must be a multiple of `texel_size`
+     * \param texel_size Distance between neighbouring heights, in meters
+     * \param size Number of heights along each side of the square, not counting the apron
+     * \param min_height The height that a noise value of 0 maps to
+     * \param max_height The height that a noise value of 1 maps to
+     * \param gradients If not nullptr, gets the heights' analytic gradients from the same noise pass, which are exact where central
+     * differences of the heights blur over a texel. Left empty for noise types that FastNoiseSIMD has no derivatives for. Like the
+     * heights, this memory belongs to the calling thread and is only valid until the thread's next call to this function
+     *
+     * \return `(size + 2) * (size + 2)` heights, in the layout that `compute_tile_normals` expects. This memory belongs to the calling
+     * thread and is only valid until the thread's next call to this function
+     */
+    [[nodiscard]] std::span<const Float32> fill_heights_with_apron(const NoiseConfig& config,
+                                                                   const Vec2i& top_left,
+                                                                   Uint32 texel_size,
+                                                                   Uint32 size,
+                                                                   Float32 min_height,
+                                                                   Float32 max_height,
+                                                                   HeightGradients* gradients = nullptr);
+} // namespace terraingen
@@ -0,0 +1,129 @@
+#include "terrain_normals.hpp"
+
+#include <cmath>
+
+#include "Tracy.hpp"
+#include "rx/core/assert.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TERRAIN_NORMALS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace terraingen {
+    static Vec3f compute_normal(
+        const Float32 left, const Float32 right, const Float32 up, const Float32 down, const Float32 sample_spacing) {
+        const auto dx = right - left;
+        const auto dz = down - up;
+        const auto inverse_length = 1.0f / std::sqrt(dx * dx + sample_spacing * sample_spacing + dz * dz);
+
+        return Vec3f{-dx * inverse_length, sample_spacing * inverse_length, -dz * inverse_length};
+    }
+
+    void compute_tile_normals(const std::span<const Float32> apron_heights,
+                              const Uint32 size,
+                              const std::span<Vec3f> normals,
+                              const Float32 texel_size) {
+        ZoneScoped;
+
+        // Distance between the two samples of a central difference, in meters
+        const auto sample_spacing = 2.0f * texel_size;
+
+        const auto apron_size = size + 2;
+
+        RX_ASSERT(apron_heights.size() >= static_cast<Size>(apron_size) * apron_size,
+                  "Apron heightmap needs %u heights, but only has %zu",
+                  apron_size * apron_size,
+                  apron_heights.size());
+        RX_ASSERT(normals.size() >= static_cast<Size>(size) * size,
+                  "Need room for %u normals, but only have %zu",
+                  size * size,
+                  normals.size());
+
+#ifdef TERRAIN_NORMALS_SSE2
+        const auto spacing = _mm_set1_ps(sample_spacing);
+        const auto spacing_squared = _mm_set1_ps(sample_spacing * sample_spacing);
+        const auto one = _mm_set1_ps(1.0f);
+        const auto sign_bit = _mm_set1_ps(-0.0f);
+#endif
+
+        for(Uint32 y = 0; y < size; y++) {
+            // Row y of the tile is row y + 1 of the apron heightmap
+            const auto* row_above = apron_heights.data() + static_cast<Size>(y) * apron_size;
+            const auto* row_middle = row_above + apron_size;
+            const auto* row_below = row_middle + apron_size;
+
+            auto* row_normals = normals.data() + static_cast<Size>(y) * size;
+
+            Uint32 x = 0;
+
+#ifdef TERRAIN_NORMALS_SSE2
+            for(; x + 4 <= size; x += 4) {
+                const auto left = _mm_loadu_ps(row_middle + x);
+                const auto right = _mm_loadu_ps(row_middle + x + 2);
+                const auto up = _mm_loadu_ps(row_above + x + 1);
+                const auto down = _mm_loadu_ps(row_below + x + 1);
+
+                const auto dx = _mm_sub_ps(right, left);
+                const auto dz = _mm_sub_ps(down, up);
+
+                const auto length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)), spacing_squared);
+                const auto inverse_length = _mm_div_ps(one, _mm_sqrt_ps(length_squared));
+
+                alignas(16) Float32 normal_x[4];
+                alignas(16) Float32 normal_y[4];
+                alignas(16) Float32 normal_z[4];
+                _mm_store_ps(normal_x, _mm_xor_ps(_mm_mul_ps(dx, inverse_length), sign_bit));
+                _mm_store_ps(normal_y, _mm_mul_ps(spacing, inverse_length));
+                _mm_store_ps(normal_z, _mm_xor_ps(_mm_mul_ps(dz, inverse_length), sign_bit));
+
+                for(Uint32 i = 0; i < 4; i++) {
+                    row_normals[x + i] = Vec3f{normal_x[i], normal_y[i], normal_z[i]};
+                }
+            }
+#endif
+
+            for(; x < size; x++) {
+                row_normals[x] = compute_normal(row_middle[x], row_middle[x + 2], row_above[x + 1], row_below[x + 1], sample_spacing);
+            }
+        }
+    }
+
+    void compute_tile_normals_from_gradients(const HeightGradients& gradients,
+                                             const Uint32 size,
+                                             const std::span<Vec3f> normals,
+                                             const Float32 texel_size) {
+        ZoneScoped;
+
+        const auto apron_size = size + 2;
+
+        RX_ASSERT(gradients.x.size() >= static_cast<Size>(apron_size) * apron_size &&
+                      gradients.y.size() >= static_cast<Size>(apron_size) * apron_size,
+                  "Apron gradients need %u values along each axis, but only have %zu and %zu",
+                  apron_size * apron_size,
+                  gradients.x.size(),
+                  gradients.y.size());
+        RX_ASSERT(normals.size() >= static_cast<Size>(size) * size,
+                  "Need room for %u normals, but only have %zu",
+                  size * size,
+                  normals.size());
+
+        for(Uint32 y = 0; y < size; y++) {
+            // Row y of the tile is row y + 1 of the apron, and starts one texel in
+            const auto row_start = static_cast<Size>(y + 1) * apron_size + 1;
+            const auto* row_gradients_x = gradients.x.data() + row_start;
+            const auto* row_gradients_y = gradients.y.data() + row_start;
+
+            auto* row_normals = normals.data() + static_cast<Size>(y) * size;
+
+            // The gradients are per texel, so the normal of the surface (x, height(x, y), y) is (-dx, texel_size, -dy) before normalizing
+            for(Uint32 x = 0; x < size; x++) {
+                const auto dx = row_gradients_x[x];
+                const auto dy = row_gradients_y[x];
+                const auto inverse_length = 1.0f / std::sqrt(dx * dx + texel_size * texel_size + dy * dy);
+
+                row_normals[x] = Vec3f{-dx * inverse_length, texel_size * inverse_length, -dy * inverse_length};
+            }
+        }
+    }
+} // namespace terraingen
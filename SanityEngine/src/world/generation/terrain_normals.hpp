@@ -0,0 +1,43 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "world/generation/terrain_noise.hpp"
+
+namespace terraingen {
+    /*!
+     * \brief Computes the normals of a terrain tile with central differences
+     *
+     * The heights must include a one-texel apron around the tile, so that the normals on the tile's edges use the same heights as the
+     * neighbouring tile's normals. That makes the lighting seamless across tile borders. The apron heights are stored row-major with a row
+     * length of `size + 2`, and the tile's height at (x, y) lives at `apron_heights[(y + 1) * (size + 2) + x + 1]`
+     *
+     * The inner loop works on four texels at once. It doesn't touch any shared state, so it's safe to call from any number of threads
+     *
+     * \param apron_heights Heights of the tile plus its apron. Must have at least `(size + 2) * (size + 2)` elements
+     * \param size Width of the tile, in texels
+     * \param normals Where to write the normals. Must have at least `size * size` elements. The normal at (x, y) is written to
+     * `normals[y * size + x]`
+     * \param texel_size Distance between neighbouring heights, in meters
+     */
+    void compute_tile_normals(std::span<const Float32> apron_heights, Uint32 size, std::span<Vec3f> normals, Float32 texel_size = 1.0f);
+
+    /*!
+     * \brief Computes the normals of a terrain tile from the analytic gradients of its heights
+     *
+     * The gradients come from the same noise pass as the heights, so they're exact at every texel instead of averaged over the two texels
+     * on either side. They use the same apron layout as `compute_tile_normals`, and neighbouring tiles sample the same noise at their
+     * shared edge, so the lighting is still seamless. Safe to call from any number of threads
+     *
+     * \param gradients Gradients of the tile plus its apron, as filled by `fill_heights_with_apron`
+     * \param size Width of the tile, in texels
+     * \param normals Where to write the normals. Must have at least `size * size` elements. The normal at (x, y) is written to
+     * `normals[y * size + x]`
+     * \param texel_size Distance between neighbouring heights, in meters
+     */
+    void compute_tile_normals_from_gradients(const HeightGradients& gradients,
+                                             Uint32 size,
+                                             std::span<Vec3f> normals,
+                                             Float32 texel_size = 1.0f);
+} // namespace terraingen
@@ -0,0 +1,332 @@
+#include "world_benchmarks.hpp"
+
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/array.h"
+#include "rx/core/log.h"
+#include "world/cube_sphere.hpp"
+#include "world/generation/cube_sphere_benchmarks.hpp"
+#include "world/generation/noise_benchmarks.hpp"
+#include "world/generation/terrain_benchmarks.hpp"
+#include "world/generation/world_generation.hpp"
+
+namespace terraingen {
+    RX_LOG("WorldBenchmarks", logger);
+
+    constexpr WorldBenchmark WORLD_BENCHMARKS[] = {WorldBenchmark::TileGeneration,
+                                                   WorldBenchmark::NoiseBackends,
+                                                   WorldBenchmark::LargeCoordinateNoise,
+                                                   WorldBenchmark::CubeSphereTiles,
+                                                   WorldBenchmark::Erosion,
+                                                   WorldBenchmark::TerrainLod,
+                                                   WorldBenchmark::WaterSimulation,
+                                                   WorldBenchmark::EnvironmentScattering,
+                                                   WorldBenchmark::DistanceTransforms,
+                                                   WorldBenchmark::VoxelMeshing,
+                                                   WorldBenchmark::WorldSave};
+
+    /*!
+     * \brief Largest difference from the brute-force distances that the exact distance transform may have, in texels
+     */
+    constexpr Float32 MAX_EXACT_DISTANCE_ERROR = 0.001f;
+
+    static bool run_tile_generation_benchmark(const NoiseConfig& config, const WorldBenchmarkSettings& settings) {
+        [[maybe_unused]] const auto results = benchmark_tile_heightmap_generation(config, settings.tile_size, 1024, settings.thread_counts);
+
+        return true;
+    }
+
+    static bool run_noise_backends_benchmark(const NoiseConfig& config) {
+        const auto results = benchmark_noise_backends(config, 256, 32, 4, 0.01f);
+
+        return results.num_mismatched_runs == 0;
+    }
+
+    static bool run_large_coordinate_noise_benchmark(const NoiseConfig& config) {
+        const auto results = benchmark_large_coordinate_noise(config, 256, 4, 0.01f);
+
+        return results.num_failed_runs == 0;
+    }
+
+    static bool run_cube_sphere_tiles_benchmark(const NoiseConfig& config,
+                                                const Float32 min_height,
+                                                const Float32 max_height,
+                                                const WorldBenchmarkSettings& settings) {
+        // Tiles about as wide as the flat terrain's tiles, on a planet the size of the Earth
+        const auto planet_radius = CubeSphereStreamingSettings{}.radius;
+        const auto results = benchmark_cube_sphere_tiles(config,
+                                                         planet_radius,
+                                                         get_cube_sphere_depth_for_tile_size(planet_radius,
+                                                                                             static_cast<Float64>(settings.tile_size)),
+                                                         settings.tile_size + 1,
+                                                         256,
+                                                         min_height,
+                                                         max_height);
+
+        return !results.failed;
+    }
+
+    static bool run_erosion_benchmark(const NoiseConfig& config,
+                                      const Float32 min_height,
+                                      const Float32 max_height,
+                                      const WorldBenchmarkSettings& settings) {
+        const Rx::Vector<Vec2u> world_sizes = Rx::Array{Vec2u{512, 256}, Vec2u{1024, 512}, Vec2u{2048, 1024}, Vec2u{4096, 2048}};
+        const auto results = benchmark_hydraulic_erosion(config, world_sizes, 16, settings.thread_counts, min_height, max_height);
+
+        auto all_match = true;
+        results.each_fwd([&](const ErosionBenchmarkResult& result) { all_match = all_match && result.matches_first_run; });
+
+        return all_match;
+    }
+
+    static bool run_terrain_lod_benchmark(const NoiseConfig& config,
+                                          const Float32 min_height,
+                                          const Float32 max_height,
+                                          const WorldBenchmarkSettings& settings) {
+        const auto lod_settings = TerrainLodSettings{.min_terrain_height = min_height, .max_terrain_height = max_height};
+        const Rx::Vector<Int32> tile_distances = Rx::Array{8, 16, 32, 64, 128};
+        [[maybe_unused]] const auto results = benchmark_terrain_lod(config, lod_settings, settings.tile_size, tile_distances);
+
+        return true;
+    }
+
+    static bool run_water_simulation_benchmark(const NoiseConfig& config,
+                                               const Float32 min_height,
+                                               const Float32 max_height,
+                                               const WorldBenchmarkSettings& settings) {
+        const auto results = benchmark_water_simulation(config,
+                                                        settings.tile_size,
+                                                        16,
+                                                        600,
+                                                        settings.thread_counts,
+                                                        min_height,
+                                                        max_height);
+
+        auto all_match = true;
+        results.each_fwd([&](const WaterSimulationBenchmarkResult& result) { all_match = all_match && result.matches_first_run; });
+
+        return all_match;
+    }
+
+    static bool run_environment_scattering_benchmark(const NoiseConfig& config,
+                                                     const Float32 min_height,
+                                                     const Float32 max_height,
+                                                     const WorldBenchmarkSettings& settings) {
+        const auto results = benchmark_environment_scattering(config,
+                                                              settings.tile_size,
+                                                              16,
+                                                              settings.thread_counts,
+                                                              min_height,
+                                                              max_height);
+
+        auto passed = true;
+        results.each_fwd([&](const EnvironmentScatteringBenchmarkResult& result) {
+            passed = passed && result.num_overlaps == 0 && result.matches_first_run;
+        });
+
+        return passed;
+    }
+
+    static bool run_distance_transforms_benchmark(const NoiseConfig& config, const WorldBenchmarkSettings& settings) {
+        const Rx::Vector<Vec2u> world_sizes = Rx::Array{Vec2u{1024, 1024}, Vec2u{2048, 2048}, Vec2u{4096, 4096}};
+        const auto results = benchmark_distance_transforms(config,
+                                                           world_sizes,
+                                                           settings.thread_counts,
+                                                           settings.tile_size,
+                                                           settings.tile_size);
+
+        // The chamfer transform is only ever close to the exact distances, so only the exact transform gets checked
+        auto passed = true;
+        results.each_fwd([&](const DistanceTransformBenchmarkResult& result) {
+            passed = passed && (result.method != DistanceTransformMethod::Exact || result.max_error <= MAX_EXACT_DISTANCE_ERROR);
+        });
+
+        return passed;
+    }
+
+    static bool run_voxel_meshing_benchmark(const NoiseConfig& config,
+                                            const Float32 min_height,
+                                            const Float32 max_height,
+                                            const Float32 sea_level,
+                                            const WorldBenchmarkSettings& settings) {
+        const auto results = benchmark_voxel_meshing(config, 16, settings.thread_counts, min_height, max_height, sea_level);
+
+        auto passed = true;
+        results.runs.each_fwd([&](const VoxelMeshingBenchmarkResult& result) { passed = passed && result.matches_naive_faces; });
+
+        return passed;
+    }
+
+    static bool run_world_save_benchmark(const NoiseConfig& config,
+                                         const Float32 min_height,
+                                         const Float32 max_height,
+                                         const Float32 sea_level,
+                                         const WorldBenchmarkSettings& settings) {
+        const auto results = benchmark_world_save(config,
+                                                  settings.save_directory,
+                                                  16,
+                                                  settings.tile_size,
+                                                  min_height,
+                                                  max_height,
+                                                  sea_level);
+
+        return results.matches_saved_data;
+    }
+
+    Rx::Vector<WorldBenchmark> get_world_benchmarks() {
+        Rx::Vector<WorldBenchmark> benchmarks;
+        for(const auto benchmark : WORLD_BENCHMARKS) {
+            benchmarks.push_back(benchmark);
+        }
+
+        return benchmarks;
+    }
+
+    const char* get_world_benchmark_name(const WorldBenchmark benchmark) {
+        switch(benchmark) {
+            case WorldBenchmark::TileGeneration:
+                return "tiles";
+
+            case WorldBenchmark::NoiseBackends:
+                return "noise-backends";
+
+            case WorldBenchmark::LargeCoordinateNoise:
+                return "large-coordinates";
+
+            case WorldBenchmark::CubeSphereTiles:
+                return "cube-sphere";
+
+            case WorldBenchmark::Erosion:
+                return "erosion";
+
+            case WorldBenchmark::TerrainLod:
+                return "lod";
+
+            case WorldBenchmark::WaterSimulation:
+                return "water";
+
+            case WorldBenchmark::EnvironmentScattering:
+                return "scattering";
+
+            case WorldBenchmark::DistanceTransforms:
+                return "distance-transforms";
+
+            case WorldBenchmark::VoxelMeshing:
+                return "voxel-meshing";
+
+            case WorldBenchmark::WorldSave:
+                return "save";
+        }
+
+        return "unknown";
+    }
+
+    bool find_world_benchmark(const char* name, WorldBenchmark& benchmark) {
+        for(const auto candidate : WORLD_BENCHMARKS) {
+            if(strcmp(name, get_world_benchmark_name(candidate)) == 0) {
+                benchmark = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool find_world_benchmarks(const char* names, Rx::Vector<WorldBenchmark>& benchmarks) {
+        auto found_all = true;
+
+        const auto* name_start = names;
+        while(*name_start != '\0') {
+            const auto* name_end = strchr(name_start, ',');
+            if(name_end == nullptr) {
+                name_end = name_start + strlen(name_start);
+            }
+
+            const auto name = Rx::String{name_start, name_end};
+            auto benchmark = WorldBenchmark{};
+            if(name == "all") {
+                for(const auto candidate : WORLD_BENCHMARKS) {
+                    benchmarks.push_back(candidate);
+                }
+            } else if(find_world_benchmark(name.data(), benchmark)) {
+                benchmarks.push_back(benchmark);
+            } else if(!name.is_empty()) {
+                logger->error("There's no benchmark named %s", name.data());
+                found_all = false;
+            }
+
+            name_start = *name_end == ',' ? name_end + 1 : name_end;
+        }
+
+        return found_all;
+    }
+
+    bool run_world_benchmark(const WorldBenchmark benchmark, const WorldParameters& params, const WorldBenchmarkSettings& settings) {
+        ZoneScoped;
+
+        logger->info("Running the %s benchmark", get_world_benchmark_name(benchmark));
+
+        const auto config = get_world_noise_config(params);
+        const auto min_height = static_cast<Float32>(params.min_terrain_depth_under_ocean);
+        const auto max_height = static_cast<Float32>(params.min_terrain_depth_under_ocean + params.max_ocean_depth +
+                                                     params.max_height_above_sea_level);
+        const auto sea_level = get_sea_level(params);
+
+        // Makes sure that FastNoiseSIMD's static data is initialized before any benchmark makes generators on worker threads
+        [[maybe_unused]] const auto& noise_generator = get_thread_noise_generator(config);
+
+        auto passed = true;
+        switch(benchmark) {
+            case WorldBenchmark::TileGeneration:
+                passed = run_tile_generation_benchmark(config, settings);
+                break;
+
+            case WorldBenchmark::NoiseBackends:
+                passed = run_noise_backends_benchmark(config);
+                break;
+
+            case WorldBenchmark::LargeCoordinateNoise:
+                passed = run_large_coordinate_noise_benchmark(config);
+                break;
+
+            case WorldBenchmark::CubeSphereTiles:
+                passed = run_cube_sphere_tiles_benchmark(config, min_height, max_height, settings);
+                break;
+
+            case WorldBenchmark::Erosion:
+                passed = run_erosion_benchmark(config, min_height, max_height, settings);
+                break;
+
+            case WorldBenchmark::TerrainLod:
+                passed = run_terrain_lod_benchmark(config, min_height, max_height, settings);
+                break;
+
+            case WorldBenchmark::WaterSimulation:
+                passed = run_water_simulation_benchmark(config, min_height, max_height, settings);
+                break;
+
+            case WorldBenchmark::EnvironmentScattering:
+                passed = run_environment_scattering_benchmark(config, min_height, max_height, settings);
+                break;
+
+            case WorldBenchmark::DistanceTransforms:
+                passed = run_distance_transforms_benchmark(config, settings);
+                break;
+
+            case WorldBenchmark::VoxelMeshing:
+                passed = run_voxel_meshing_benchmark(config, min_height, max_height, sea_level, settings);
+                break;
+
+            case WorldBenchmark::WorldSave:
+                passed = run_world_save_benchmark(config, min_height, max_height, sea_level, settings);
+                break;
+        }
+
+        if(!passed) {
+            logger->error("The %s benchmark failed its checks", get_world_benchmark_name(benchmark));
+        }
+
+        return passed;
+    }
+} // namespace terraingen
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/array.h"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+#include "world/world_parameters.hpp"
+
+/*!
+ * \brief Runs the world generation benchmarks by name
+ *
+ * `SanityWorldGen --bench <names>` runs these headless, and `World::create` runs the ones named in the `t.Benchmarks` cvar. Both get
+ * the same benchmark with the same settings, so a number from the build machines means the same thing as a number from the engine
+ */
+namespace terraingen {
+    enum class WorldBenchmark : Uint8 {
+        /*!
+         * \brief Terrain tiles generated per second on different numbers of threads
+         */
+        TileGeneration,
+
+        /*!
+         * \brief Every noise type on every FastNoiseSIMD instruction set level that the CPU supports. Checks that the levels agree
+         */
+        NoiseBackends,
+
+        /*!
+         * \brief Noise sampled from double precision origins out to planetary distances. Checks it against noise sampled at int coordinates
+         */
+        LargeCoordinateNoise,
+
+        /*!
+         * \brief Time to fill Earth-sized cube sphere tiles. Checks the latitude/longitude conversions and the tiles' neighbours
+         */
+        CubeSphereTiles,
+
+        /*!
+         * \brief Hydraulic erosion on world heightmaps up to 4096x2048 on different numbers of threads. Checks that every thread count
+         * erodes the same heightmap
+         */
+        Erosion,
+
+        /*!
+         * \brief Nodes and triangles that the terrain quadtree selects at different view distances, and how long meshing them takes
+         */
+        TerrainLod,
+
+        /*!
+         * \brief Shallow-water cells updated per millisecond on different numbers of threads. Checks that every thread count simulates the
+         * same water
+         */
+        WaterSimulation,
+
+        /*!
+         * \brief Environment object placement on 16x16 terrain tiles on different numbers of threads. Checks that no objects overlap and
+         * that every thread count places the same objects
+         */
+        EnvironmentScattering,
+
+        /*!
+         * \brief The distance transforms on maps up to 4096x4096. Checks the exact transform against a brute-force search
+         */
+        DistanceTransforms,
+
+        /*!
+         * \brief Greedy and naive voxel chunk meshing on 16x16 chunk columns. Checks that the greedy meshes cover the same faces as the
+         * naive ones
+         */
+        VoxelMeshing,
+
+        /*!
+         * \brief Saving and loading 16x16 voxel chunk columns and their terrain tiles in region files. Checks that everything loads back
+         * the same as it was saved
+         */
+        WorldSave,
+    };
+
+    struct WorldBenchmarkSettings {
+        /*!
+         * \brief Width of a terrain tile, in meters. Should be `Terrain::TILE_SIZE` to match the engine
+         */
+        Uint32 tile_size{64};
+
+        /*!
+         * \brief Number of worker threads to use for each run of the benchmarks that compare thread counts
+         */
+        Rx::Vector<Uint32> thread_counts = Rx::Array{1u, 2u, 4u, 8u, 16u};
+
+        /*!
+         * \brief Directory that the world save benchmark writes its region files to. It gets deleted afterwards
+         */
+        Rx::String save_directory{"saves/benchmark"};
+    };
+
+    /*!
+     * \brief Gets every benchmark, in the order that `--bench all` runs them
+     */
+    [[nodiscard]] Rx::Vector<WorldBenchmark> get_world_benchmarks();
+
+    /*!
+     * \brief Gets the name that a benchmark is run by, e.g. "lod"
+     */
+    [[nodiscard]] const char* get_world_benchmark_name(WorldBenchmark benchmark);
+
+    /*!
+     * \brief Looks a benchmark up by its name
+     *
+     * \return Whether there's a benchmark with that name
+     */
+    [[nodiscard]] bool find_world_benchmark(const char* name, WorldBenchmark& benchmark);
+
+    /*!
+     * \brief Looks up a comma-separated list of benchmark names, e.g. "lod,water". "all" adds every benchmark
+     *
+     * \return Whether every name was a benchmark
+     */
+    [[nodiscard]] bool find_world_benchmarks(const char* names, Rx::Vector<WorldBenchmark>& benchmarks);
+
+    /*!
+     * \brief Runs a benchmark on the world that the parameters describe. Results get logged
+     *
+     * \return Whether the benchmark's checks passed. Benchmarks that don't check anything always pass
+     */
+    bool run_world_benchmark(WorldBenchmark benchmark, const WorldParameters& params, const WorldBenchmarkSettings& settings);
+} // namespace terraingen
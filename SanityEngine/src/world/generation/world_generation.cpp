@@ -0,0 +1,176 @@
+#include "world_generation.hpp"
+
+#include <cmath>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "world/generation/terrain_distance_transforms.hpp"
+#include "world/generation/terrain_erosion.hpp"
+#include "world/generation/terrain_hydrology.hpp"
+#include "world/terrain_height_queries.hpp"
+
+namespace terraingen {
+    NoiseConfig get_world_noise_config(const WorldParameters& params) {
+        // Settings gotten from messing around in the demo application. High chance these should be tuned in-game
+        return NoiseConfig{.seed = static_cast<Int32>(params.seed),
+                           .noise_type = FastNoiseSIMD::PerlinFractal,
+                           .frequency = 1.0f / 64.0f,
+                           .fractal_type = FastNoiseSIMD::FBM,
+                           .octaves = 10,
+                           .lacunarity = 2,
+                           .gain = 0.5f};
+    }
+
+    Float32 get_sea_level(const WorldParameters& params) {
+        return static_cast<Float32>(params.min_terrain_depth_under_ocean + params.max_ocean_depth);
+    }
+
+    Rx::Vector<Float32> generate_world_heightmap(const WorldParameters& params, const Uint32 num_threads) {
+        ZoneScoped;
+
+        const auto min_terrain_height = params.min_terrain_depth_under_ocean;
+        const auto max_terrain_height = params.min_terrain_depth_under_ocean + params.max_ocean_depth + params.max_height_above_sea_level;
+
+        // The noise set puts x in the outermost loop, so the heightmap has `params.width` rows of `params.height` heights
+        return generate_noise_set(get_world_noise_config(params),
+                                  {-static_cast<Int32>(params.width) / 2, -static_cast<Int32>(params.height) / 2},
+                                  {params.width, params.height},
+                                  static_cast<Float32>(min_terrain_height),
+                                  static_cast<Float32>(max_terrain_height),
+                                  num_threads);
+    }
+
+    void erode_world_heightmap(const std::span<Float32> heightmap,
+                               const WorldParameters& params,
+                               const Uint32 num_iterations,
+                               const Uint32 num_threads) {
+        ZoneScoped;
+
+        const auto erosion_settings = HydraulicErosionSettings{.seed = params.seed, .num_iterations = num_iterations};
+        erode_heightmap(heightmap, params.height, params.width, erosion_settings, num_threads);
+    }
+
+    WorldWaterMaps find_world_water(const std::span<const Float32> heightmap, const WorldParameters& params, const Uint32 num_threads) {
+        ZoneScoped;
+
+        auto hydrology = compute_hydrology(heightmap, params.height, params.width, {}, num_threads);
+
+        constexpr Float32 river_depth = 1.0f;
+
+        Rx::Vector<Float32> water_depths{heightmap.size()};
+        for(Size i = 0; i < heightmap.size(); i++) {
+            if(hydrology.lake_mask[i] != 0) {
+                water_depths[i] = hydrology.filled_heights[i] - heightmap[i];
+            } else if(hydrology.river_mask[i] != 0) {
+                water_depths[i] = river_depth;
+            }
+        }
+
+        return WorldWaterMaps{.flow_accumulation = Rx::Utility::move(hydrology.flow_accumulation),
+                              .river_mask = Rx::Utility::move(hydrology.river_mask),
+                              .lake_mask = Rx::Utility::move(hydrology.lake_mask),
+                              .water_depths = Rx::Utility::move(water_depths)};
+    }
+
+    ClimateMaps compute_world_climate(const std::span<const Float32> heightmap,
+                                      const std::span<const Float32> water_depths,
+                                      const WorldParameters& params,
+                                      const Uint32 num_threads) {
+        // Latitude runs along each row
+        return compute_climate(heightmap,
+                               water_depths,
+                               params.height,
+                               params.width,
+                               ClimateSettings{.sea_level = get_sea_level(params)},
+                               num_threads);
+    }
+
+    environment::EcotypeMap classify_world_ecotypes(const WorldParameters& params,
+                                                    const std::span<const Float32> heightmap,
+                                                    const std::span<const Float32> water_depths,
+                                                    const std::span<const Uint8> river_mask,
+                                                    const std::span<const Float32> humidity,
+                                                    const std::span<const Float32> soil_moisture) {
+        const auto fields = environment::EcotypeFields{
+            .width = params.height,
+            .depth = params.width,
+            .heights = heightmap,
+            .water_depths = water_depths,
+            .river_mask = river_mask,
+            .humidity = humidity,
+            .soil_moisture = soil_moisture,
+        };
+
+        return environment::classify_ecotypes(fields, environment::EcotypeSettings{.sea_level = get_sea_level(params)});
+    }
+
+    WorldDerivedMaps derive_world_maps(const environment::EcotypeMap& ecotypes,
+                                       const std::span<const Float32> humidity,
+                                       const Uint32 num_threads) {
+        ZoneScoped;
+
+        /*
+         * Groundwater is full next to water and falls off with distance from it, and rain tops it up everywhere. The rain is what the
+         * humidity can give, since the air rains out its humidity
+         */
+        constexpr Float32 GROUNDWATER_FALLOFF_DISTANCE = 64;
+        constexpr Float32 RAIN_GROUNDWATER = 0.5f;
+
+        if(ecotypes.is_empty()) {
+            return {};
+        }
+
+        constexpr auto water_ecotypes = environment::to_mask(environment::Ecotype::Ocean) |
+                                        environment::to_mask(environment::Ecotype::River) |
+                                        environment::to_mask(environment::Ecotype::Lake);
+
+        Rx::Vector<Uint8> water_mask{ecotypes.ecotypes.size()};
+        for(Size i = 0; i < water_mask.size(); i++) {
+            water_mask[i] = (environment::to_mask(ecotypes.ecotypes[i]) & water_ecotypes) != 0 ? 1 : 0;
+        }
+
+        WorldDerivedMaps maps;
+        maps.water_distance = compute_distance_field({water_mask.data(), water_mask.size()},
+                                                     ecotypes.width,
+                                                     ecotypes.depth,
+                                                     DistanceTransformSettings{.num_threads = num_threads});
+
+        const auto has_humidity = humidity.size() == maps.water_distance.size();
+        maps.groundwater.resize(maps.water_distance.size());
+        for(Size i = 0; i < maps.groundwater.size(); i++) {
+            const auto near_water = std::exp(-maps.water_distance[i] / GROUNDWATER_FALLOFF_DISTANCE);
+            const auto rain = has_humidity ? humidity[i] * RAIN_GROUNDWATER : 0.0f;
+            maps.groundwater[i] = near_water + (1 - near_water) * rain;
+        }
+
+        return maps;
+    }
+
+    Rx::Vector<Float32> get_tile_water_depths(const TerrainFallbackHeightmap& world_maps, const Vec2i& tile_coord, const Uint32 tile_size) {
+        if(world_maps.water_depths.is_empty()) {
+            return {};
+        }
+
+        const auto maps_left = static_cast<Int32>(world_maps.origin.x);
+        const auto maps_top = static_cast<Int32>(world_maps.origin.y);
+        const auto size = static_cast<Int32>(tile_size);
+        const auto tile_left = tile_coord.x * size - maps_left;
+        const auto tile_top = tile_coord.y * size - maps_top;
+
+        const auto maps_width = static_cast<Int32>(world_maps.width);
+        const auto maps_depth = static_cast<Int32>(world_maps.depth);
+        if(tile_left + size <= 0 || tile_top + size <= 0 || tile_left >= maps_width || tile_top >= maps_depth) {
+            return {};
+        }
+
+        Rx::Vector<Float32> depths{static_cast<Size>(tile_size) * tile_size};
+        for(Int32 z = Rx::Algorithm::max(-tile_top, 0); z < Rx::Algorithm::min(size, maps_depth - tile_top); z++) {
+            for(Int32 x = Rx::Algorithm::max(-tile_left, 0); x < Rx::Algorithm::min(size, maps_width - tile_left); x++) {
+                depths[z * size + x] = world_maps.water_depths[(tile_top + z) * maps_width + tile_left + x];
+            }
+        }
+
+        return depths;
+    }
+} // namespace terraingen
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+#include "world/environment/ecotypes.hpp"
+#include "world/generation/terrain_climate.hpp"
+#include "world/generation/terrain_noise.hpp"
+#include "world/world_parameters.hpp"
+
+struct TerrainFallbackHeightmap;
+
+/*!
+ * \brief The CPU stages of world generation
+ *
+ * `World::create` and `Terrain::generate_terrain` run these and upload the results to the GPU, and `generate_headless_world` runs them
+ * without a GPU. Both go through the same functions, so a world that's generated headless is bit-identical to the world that the engine
+ * generates from the same parameters
+ *
+ * Every map is laid out like the world heightmap, in `params.width` rows of `params.height` texels
+ */
+namespace terraingen {
+    /*!
+     * \brief Gets the noise settings for the world heightmap and the terrain tiles
+     */
+    [[nodiscard]] NoiseConfig get_world_noise_config(const WorldParameters& params);
+
+    /*!
+     * \brief Height of the ocean's surface
+     */
+    [[nodiscard]] Float32 get_sea_level(const WorldParameters& params);
+
+    /*!
+     * \brief Generates the world heightmap from the noise, mapped to the world's height range
+     *
+     * \param params The world's parameters
+     * \param num_threads Number of worker threads to generate the noise on. The heightmap is the same no matter how many threads there are
+     */
+    [[nodiscard]] Rx::Vector<Float32> generate_world_heightmap(const WorldParameters& params, Uint32 num_threads);
+
+    /*!
+     * \brief Runs hydraulic erosion over the world heightmap
+     */
+    void erode_world_heightmap(std::span<Float32> heightmap, const WorldParameters& params, Uint32 num_iterations, Uint32 num_threads);
+
+    struct WorldWaterMaps {
+        Rx::Vector<Uint32> flow_accumulation;
+
+        Rx::Vector<Uint8> river_mask;
+
+        Rx::Vector<Uint8> lake_mask;
+
+        /*!
+         * \brief Depth of the lakes and rivers on each texel. The oceans get added on the GPU later
+         */
+        Rx::Vector<Float32> water_depths;
+    };
+
+    /*!
+     * \brief Finds where water pools into lakes and flows as rivers
+     */
+    [[nodiscard]] WorldWaterMaps find_world_water(std::span<const Float32> heightmap, const WorldParameters& params, Uint32 num_threads);
+
+    /*!
+     * \brief Runs the climate model over the world, see `compute_climate`
+     */
+    [[nodiscard]] ClimateMaps compute_world_climate(std::span<const Float32> heightmap,
+                                                    std::span<const Float32> water_depths,
+                                                    const WorldParameters& params,
+                                                    Uint32 num_threads);
+
+    /*!
+     * \brief Decides the ecotype of each texel of the world, once the climate model has run
+     */
+    [[nodiscard]] environment::EcotypeMap classify_world_ecotypes(const WorldParameters& params,
+                                                                  std::span<const Float32> heightmap,
+                                                                  std::span<const Float32> water_depths,
+                                                                  std::span<const Uint8> river_mask,
+                                                                  std::span<const Float32> humidity,
+                                                                  std::span<const Float32> soil_moisture);
+
+    struct WorldDerivedMaps {
+        /*!
+         * \brief Distance to the nearest ocean, river, or lake texel, in meters
+         */
+        Rx::Vector<Float32> water_distance;
+
+        /*!
+         * \brief Groundwater from 0 to 1
+         */
+        Rx::Vector<Float32> groundwater;
+    };
+
+    /*!
+     * \brief Derives the distance to water and groundwater maps from the ecotypes and the climate
+     *
+     * \param ecotypes The world's ecotypes
+     * \param humidity The climate model's humidity. May be empty
+     * \param num_threads Number of worker threads for the distance transform
+     */
+    [[nodiscard]] WorldDerivedMaps derive_world_maps(const environment::EcotypeMap& ecotypes,
+                                                     std::span<const Float32> humidity,
+                                                     Uint32 num_threads);
+
+    /*!
+     * \brief Gets the water that a terrain tile starts with, from the water depths on the world's maps
+     *
+     * \return The tile's water depths, in `tile_size` rows of `tile_size` cells, or nothing if the world's maps have no water under the
+     * tile
+     */
+    [[nodiscard]] Rx::Vector<Float32> get_tile_water_depths(const TerrainFallbackHeightmap& world_maps,
+                                                            const Vec2i& tile_coord,
+                                                            Uint32 tile_size);
+} // namespace terraingen
@@ -0,0 +1,153 @@
+#include "world_random.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define WORLD_RANDOM_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace terraingen {
+    constexpr Uint32 PHILOX_MULTIPLIER_0 = 0xD2511F53;
+    constexpr Uint32 PHILOX_MULTIPLIER_1 = 0xCD9E8D57;
+
+    /*!
+     * \brief What gets added to the key after each round. The golden ratio and sqrt(3) - 1, as 32-bit fractions
+     */
+    constexpr Uint32 PHILOX_KEY_STEP_0 = 0x9E3779B9;
+    constexpr Uint32 PHILOX_KEY_STEP_1 = 0xBB67AE85;
+
+    constexpr Uint32 PHILOX_ROUNDS = 10;
+
+    static Uint64 mix_bits(Uint64 bits) {
+        bits ^= bits >> 30;
+        bits *= 0xBF58476D1CE4E5B9ull;
+        bits ^= bits >> 27;
+        bits *= 0x94D049BB133111EBull;
+        bits ^= bits >> 31;
+
+        return bits;
+    }
+
+    static RandomBlock make_counter(const Vec2i& tile, const Uint64 index) {
+        return RandomBlock{{static_cast<Uint32>(tile.x),
+                            static_cast<Uint32>(tile.y),
+                            static_cast<Uint32>(index),
+                            static_cast<Uint32>(index >> 32)}};
+    }
+
+    static RandomBlock encrypt(RandomBlock counter, const Uint32 (&key)[2]) {
+        auto key_0 = key[0];
+        auto key_1 = key[1];
+
+        for(Uint32 round = 0; round < PHILOX_ROUNDS; round++) {
+            const auto product_0 = static_cast<Uint64>(PHILOX_MULTIPLIER_0) * counter.words[0];
+            const auto product_1 = static_cast<Uint64>(PHILOX_MULTIPLIER_1) * counter.words[2];
+
+            counter = RandomBlock{{static_cast<Uint32>(product_1 >> 32) ^ counter.words[1] ^ key_0,
+                                   static_cast<Uint32>(product_1),
+                                   static_cast<Uint32>(product_0 >> 32) ^ counter.words[3] ^ key_1,
+                                   static_cast<Uint32>(product_0)}};
+
+            key_0 += PHILOX_KEY_STEP_0;
+            key_1 += PHILOX_KEY_STEP_1;
+        }
+
+        return counter;
+    }
+
+#ifdef WORLD_RANDOM_SSE2
+    /*!
+     * \brief The words of two counters, in the even 32-bit lanes of a vector. The odd lanes hold junk that never reaches the even lanes
+     *
+     * `_mm_mul_epu32` multiplies the even lanes into whole 64-bit products, so the low half of each product lands right where the next
+     * round needs it, and the high half is one shift away. That keeps the rounds free of shuffles
+     */
+    struct CounterPair {
+        __m128i words[4];
+    };
+
+    static CounterPair make_counter_pair(const Vec2i& tile, const Uint64 index) {
+        const auto make_words = [](const Uint32 first, const Uint32 second) {
+            return _mm_setr_epi32(static_cast<int>(first), 0, static_cast<int>(second), 0);
+        };
+
+        return CounterPair{{make_words(static_cast<Uint32>(tile.x), static_cast<Uint32>(tile.x)),
+                            make_words(static_cast<Uint32>(tile.y), static_cast<Uint32>(tile.y)),
+                            make_words(static_cast<Uint32>(index), static_cast<Uint32>(index + 1)),
+                            make_words(static_cast<Uint32>(index >> 32), static_cast<Uint32>((index + 1) >> 32))}};
+    }
+
+    static void encrypt_round(
+        CounterPair& pair, const __m128i multiplier_0, const __m128i multiplier_1, const __m128i key_0, const __m128i key_1) {
+        const auto product_0 = _mm_mul_epu32(pair.words[0], multiplier_0);
+        const auto product_1 = _mm_mul_epu32(pair.words[2], multiplier_1);
+
+        pair.words[0] = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi64(product_1, 32), pair.words[1]), key_0);
+        pair.words[1] = product_1;
+        pair.words[2] = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi64(product_0, 32), pair.words[3]), key_1);
+        pair.words[3] = product_0;
+    }
+
+    /*!
+     * \brief Encrypts two pairs of counters at once, so that one pair's multiplies can run while the other pair waits on its own
+     */
+    static void encrypt_two_pairs(CounterPair& first, CounterPair& second, const Uint32 (&key)[2]) {
+        const auto multiplier_0 = _mm_set1_epi32(static_cast<int>(PHILOX_MULTIPLIER_0));
+        const auto multiplier_1 = _mm_set1_epi32(static_cast<int>(PHILOX_MULTIPLIER_1));
+        const auto key_step_0 = _mm_set1_epi32(static_cast<int>(PHILOX_KEY_STEP_0));
+        const auto key_step_1 = _mm_set1_epi32(static_cast<int>(PHILOX_KEY_STEP_1));
+        auto key_0 = _mm_set1_epi32(static_cast<int>(key[0]));
+        auto key_1 = _mm_set1_epi32(static_cast<int>(key[1]));
+
+        for(Uint32 round = 0; round < PHILOX_ROUNDS; round++) {
+            encrypt_round(first, multiplier_0, multiplier_1, key_0, key_1);
+            encrypt_round(second, multiplier_0, multiplier_1, key_0, key_1);
+
+            key_0 = _mm_add_epi32(key_0, key_step_0);
+            key_1 = _mm_add_epi32(key_1, key_step_1);
+        }
+    }
+
+    static void store_counter_pair(const CounterPair& pair, RandomBlock* blocks) {
+        const auto words_01 = _mm_unpacklo_epi32(pair.words[0], pair.words[1]);
+        const auto words_23 = _mm_unpacklo_epi32(pair.words[2], pair.words[3]);
+        const auto words_01_second = _mm_unpackhi_epi32(pair.words[0], pair.words[1]);
+        const auto words_23_second = _mm_unpackhi_epi32(pair.words[2], pair.words[3]);
+
+        auto* output = reinterpret_cast<__m128i*>(blocks);
+        _mm_storeu_si128(output, _mm_unpacklo_epi64(words_01, words_23));
+        _mm_storeu_si128(output + 1, _mm_unpacklo_epi64(words_01_second, words_23_second));
+    }
+#endif
+
+    WorldRandom::WorldRandom(const Uint64 world_seed, const WorldGenStage stage, const Uint32 stream) {
+        const auto stage_bits = static_cast<Uint64>(stage) << 32 | stream;
+        const auto key_bits = mix_bits(world_seed ^ mix_bits(stage_bits));
+        key[0] = static_cast<Uint32>(key_bits);
+        key[1] = static_cast<Uint32>(key_bits >> 32);
+    }
+
+    RandomBlock WorldRandom::get_block(const Vec2i& tile, const Uint64 index) const { return encrypt(make_counter(tile, index), key); }
+
+    void WorldRandom::fill_blocks(const Vec2i& tile, const Uint64 first_index, std::span<RandomBlock> blocks) const {
+        Size i = 0;
+#ifdef WORLD_RANDOM_SSE2
+        for(; i + 4 <= blocks.size(); i += 4) {
+            auto first = make_counter_pair(tile, first_index + i);
+            auto second = make_counter_pair(tile, first_index + i + 2);
+            encrypt_two_pairs(first, second, key);
+
+            store_counter_pair(first, &blocks[i]);
+            store_counter_pair(second, &blocks[i + 2]);
+        }
+#endif
+        for(; i < blocks.size(); i++) {
+            blocks[i] = get_block(tile, first_index + i);
+        }
+    }
+
+    Float32 WorldRandom::to_float(const Uint32 bits) { return static_cast<Float32>(bits >> 8) * (1.0f / 16777216.0f); }
+
+    Uint64 WorldRandom::to_uint64(const Uint32 low_bits, const Uint32 high_bits) {
+        return static_cast<Uint64>(high_bits) << 32 | low_bits;
+    }
+} // namespace terraingen
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+
+namespace terraingen {
+    /*!
+     * \brief The world generation stages that draw random numbers. Each stage gets its own streams, so adding random numbers to one stage
+     * never changes the numbers that another stage gets
+     *
+     * The values are part of the streams' keys. Never change them, or every world will generate differently
+     */
+    enum class WorldGenStage : Uint32 {
+        HydraulicErosion = 1,
+        ObjectScattering = 2,
+    };
+
+    /*!
+     * \brief 128 random bits, from one Philox block
+     */
+    struct RandomBlock {
+        Uint32 words[4];
+    };
+
+    /*!
+     * \brief Counter-based random numbers for world generation
+     *
+     * The numbers come from Philox4x32-10, which encrypts a 128-bit counter with a 64-bit key. The key is the world seed, the stage, and a
+     * stream within the stage, and the counter is a tile coordinate and the index of an element in that tile. There's no state to carry
+     * from one number to the next, so any thread can draw the numbers for any element in any order, and the world comes out bit-identical
+     * no matter how many threads generate it
+     *
+     * Stages that aren't split into tiles use tile (0, 0)
+     */
+    class WorldRandom {
+    public:
+        /*!
+         * \param world_seed The world's seed, from `WorldParameters::seed`
+         * \param stage The stage that's drawing the numbers
+         * \param stream Which of the stage's streams to draw from, for stages that need several independent sets of numbers
+         */
+        WorldRandom(Uint64 world_seed, WorldGenStage stage, Uint32 stream = 0);
+
+        /*!
+         * \brief Gets the random bits for one element
+         */
+        [[nodiscard]] RandomBlock get_block(const Vec2i& tile, Uint64 index) const;
+
+        /*!
+         * \brief Gets the random bits for a run of elements with consecutive indices. Four blocks get encrypted at a time with SSE2
+         *
+         * The results are exactly the same as calling `get_block` for each index
+         *
+         * \param tile The elements' tile
+         * \param first_index Index of the element whose bits go in the first block
+         * \param blocks Where to write the blocks
+         */
+        void fill_blocks(const Vec2i& tile, Uint64 first_index, std::span<RandomBlock> blocks) const;
+
+        /*!
+         * \brief Turns 32 random bits into a number in [0, 1), with the 24 bits of precision that a float has
+         */
+        [[nodiscard]] static Float32 to_float(Uint32 bits);
+
+        /*!
+         * \brief Joins two words of a block into 64 random bits
+         */
+        [[nodiscard]] static Uint64 to_uint64(Uint32 low_bits, Uint32 high_bits);
+
+    private:
+        Uint32 key[2];
+    };
+} // namespace terraingen
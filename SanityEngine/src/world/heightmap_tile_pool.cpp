@@ -0,0 +1,82 @@
+#include "heightmap_tile_pool.hpp"
+
+#include "Tracy.hpp"
+#include "core/align.hpp"
+#include "rx/core/concurrency/scope_lock.h"
+#include "rx/core/log.h"
+#include "rx/core/memory/system_allocator.h"
+
+RX_LOG("HeightmapTilePool", logger);
+
+HeightmapTilePool::HeightmapTilePool(const Uint32 block_size_in)
+    : block_size{block_size_in}, block_stride{ALIGN(CACHE_LINE_SIZE, static_cast<Size>(block_size_in) * block_size_in * sizeof(Float32))} {}
+
+HeightmapTilePool::~HeightmapTilePool() {
+    if(num_live_blocks > 0) {
+        logger->warning("Destroying heightmap tile pool while %zu blocks are still in use", num_live_blocks);
+    }
+
+    auto& allocator = Rx::Memory::SystemAllocator::instance();
+    slabs.each_fwd([&](Byte* slab) { allocator.deallocate(slab); });
+}
+
+TileHeightmap HeightmapTilePool::allocate() {
+    Rx::Concurrency::ScopeLock l{mutex};
+
+    if(free_blocks.is_empty()) {
+        allocate_slab();
+    }
+
+    auto* block = free_blocks.last();
+    free_blocks.pop_back();
+
+    num_live_blocks++;
+
+    return {.heights = block, .size = block_size};
+}
+
+void HeightmapTilePool::free(const TileHeightmap& heightmap) {
+    if(!heightmap.is_valid()) {
+        return;
+    }
+
+    RX_ASSERT(heightmap.size == block_size, "Heightmap of size %u does not belong to a pool of size %u", heightmap.size, block_size);
+
+    Rx::Concurrency::ScopeLock l{mutex};
+    free_blocks.push_back(heightmap.heights);
+    num_live_blocks--;
+}
+
+Uint32 HeightmapTilePool::get_block_size() const { return block_size; }
+
+Size HeightmapTilePool::get_num_live_blocks() const {
+    Rx::Concurrency::ScopeLock l{mutex};
+    return num_live_blocks;
+}
+
+Size HeightmapTilePool::get_num_reserved_bytes() const {
+    Rx::Concurrency::ScopeLock l{mutex};
+    return slabs.size() * block_stride * BLOCKS_PER_SLAB;
+}
+
+void HeightmapTilePool::allocate_slab() {
+    ZoneScoped;
+
+    auto& allocator = Rx::Memory::SystemAllocator::instance();
+
+    // Over-allocate by a cache line so we can slide the first block forward onto a cache line boundary
+    auto* slab = allocator.allocate(block_stride * BLOCKS_PER_SLAB + CACHE_LINE_SIZE);
+    RX_ASSERT(slab != nullptr, "Could not allocate heightmap slab");
+    slabs.push_back(slab);
+
+    const auto first_block_address = ALIGN(CACHE_LINE_SIZE, reinterpret_cast<Rx::UintPtr>(slab));
+
+    free_blocks.reserve(free_blocks.size() + BLOCKS_PER_SLAB);
+
+    // Push the blocks in reverse order so that allocate() hands them out front-to-back
+    for(Uint32 i = BLOCKS_PER_SLAB; i > 0; i--) {
+        free_blocks.push_back(reinterpret_cast<Float32*>(first_block_address + (i - 1) * block_stride));
+    }
+
+    logger->verbose("Allocated new heightmap slab with %u blocks of %u x %u heights", BLOCKS_PER_SLAB, block_size, block_size);
+}
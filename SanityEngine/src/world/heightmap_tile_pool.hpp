@@ -0,0 +1,88 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/mutex.h"
+#include "rx/core/vector.h"
+
+/*!
+ * \brief Non-owning view of one square heightmap block in a HeightmapTilePool
+ *
+ * Heights are stored row-major, so the height at (x, y) lives at `heights[y * size + x]`
+ */
+struct TileHeightmap {
+    Float32* heights{nullptr};
+
+    Uint32 size{0};
+
+    [[nodiscard]] bool is_valid() const { return heights != nullptr; }
+
+    [[nodiscard]] Float32 at(Uint32 x, Uint32 y) const { return heights[y * size + x]; }
+
+    [[nodiscard]] std::span<const Float32> row(Uint32 y) const { return {heights + y * size, size}; }
+
+    [[nodiscard]] std::span<const Float32> get_heights() const { return {heights, static_cast<Size>(size) * size}; }
+
+    [[nodiscard]] std::span<Float32> get_heights() { return {heights, static_cast<Size>(size) * size}; }
+};
+
+/*!
+ * \brief Fixed-size allocator for terrain tile heightmaps
+ *
+ * Every block is `block_size * block_size` floats, is contiguous, and starts on a cache line. Blocks are carved out of large slabs so
+ * that streaming in a tile doesn't hit the general-purpose heap. When a tile is evicted its block goes back on the free list and is
+ * handed to the next tile that gets generated
+ *
+ * Blocks are aligned well enough that FastNoiseSIMD can write noise sets directly into them
+ */
+class HeightmapTilePool {
+public:
+    static constexpr Size CACHE_LINE_SIZE = 64;
+
+    static constexpr Uint32 BLOCKS_PER_SLAB = 64;
+
+    explicit HeightmapTilePool(Uint32 block_size_in);
+
+    HeightmapTilePool(const HeightmapTilePool& other) = delete;
+    HeightmapTilePool& operator=(const HeightmapTilePool& other) = delete;
+
+    HeightmapTilePool(HeightmapTilePool&& old) noexcept = delete;
+    HeightmapTilePool& operator=(HeightmapTilePool&& old) noexcept = delete;
+
+    ~HeightmapTilePool();
+
+    /*!
+     * \brief Grabs a block from the pool. The contents of the block are undefined
+     */
+    [[nodiscard]] TileHeightmap allocate();
+
+    /*!
+     * \brief Returns a block to the pool so that another tile may use it
+     */
+    void free(const TileHeightmap& heightmap);
+
+    [[nodiscard]] Uint32 get_block_size() const;
+
+    [[nodiscard]] Size get_num_live_blocks() const;
+
+    [[nodiscard]] Size get_num_reserved_bytes() const;
+
+private:
+    Uint32 block_size;
+
+    Size block_stride;
+
+    mutable Rx::Concurrency::Mutex mutex;
+
+    /*!
+     * \brief Raw allocations that the blocks are carved out of. These aren't aligned, the blocks inside them are
+     */
+    Rx::Vector<Byte*> slabs;
+
+    Rx::Vector<Float32*> free_blocks;
+
+    Size num_live_blocks{0};
+
+    void allocate_slab();
+};
@@ -0,0 +1,171 @@
+#include "region_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+#include "Tracy.hpp"
+#include "core/lz_compression.hpp"
+#include "rx/core/filesystem/file.h"
+#include "rx/core/log.h"
+
+RX_LOG("RegionFile", logger);
+
+/*!
+ * \brief Identifies a region file. Spells "SERG" in a hex editor
+ */
+constexpr Uint32 REGION_FILE_MAGIC = 0x47524553;
+
+/*!
+ * \brief Version of the region file layout. Bump this whenever the layout or the layout of the entries changes
+ */
+constexpr Uint32 REGION_FILE_VERSION = 1;
+
+struct RegionFile::Header {
+    Uint32 magic;
+
+    Uint32 version;
+
+    Uint32 num_slots;
+
+    Uint32 reserved;
+};
+
+/*!
+ * \brief Where a slot's entry is in the file. Empty slots have a compressed size of zero
+ */
+struct RegionFile::Slot {
+    Uint64 offset;
+
+    Uint32 compressed_size;
+
+    Uint32 num_bytes;
+
+    Uint32 checksum;
+
+    Uint32 reserved;
+};
+
+static Uint32 hash_entry_data(const std::span<const Byte> data) {
+    auto hash = 2166136261u;
+    for(const auto byte : data) {
+        hash ^= byte;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+RegionFile::RegionFile(const Rx::String& path, const Uint32 num_slots_in) : file{path}, num_slots{num_slots_in} {
+    if(!file.is_open()) {
+        return;
+    }
+
+    const auto data = file.get_data();
+    const auto table_end = sizeof(Header) + sizeof(Slot) * num_slots;
+    if(data.size() < table_end) {
+        logger->error("Region file %s is too small to be a region file, ignoring it", path);
+        return;
+    }
+
+    Header header;
+    memcpy(&header, data.data(), sizeof(header));
+    if(header.magic != REGION_FILE_MAGIC || header.version != REGION_FILE_VERSION || header.num_slots != num_slots) {
+        logger->error("Region file %s is from a different version or has a different number of slots, ignoring it", path);
+        return;
+    }
+
+    // The mapping starts on a page boundary and the header is a multiple of the slots' alignment, so the offset table can be used in place
+    const auto* table = reinterpret_cast<const Slot*>(data.data() + sizeof(Header));
+    for(Uint32 slot = 0; slot < num_slots; slot++) {
+        const auto& entry = table[slot];
+        if(entry.offset < table_end || entry.offset > data.size() || entry.compressed_size > data.size() - entry.offset) {
+            logger->error("Region file %s has an entry past the end of the file, ignoring it", path);
+            return;
+        }
+    }
+
+    slots = table;
+}
+
+bool RegionFile::is_open() const { return slots != nullptr; }
+
+Uint32 RegionFile::get_num_slots() const { return num_slots; }
+
+RegionEntryView RegionFile::get_entry(const Uint32 slot) const {
+    if(slots == nullptr || slots[slot].compressed_size == 0) {
+        return {};
+    }
+
+    const auto& entry = slots[slot];
+    return {.compressed_data = file.get_data().subspan(entry.offset, entry.compressed_size),
+            .num_bytes = entry.num_bytes,
+            .checksum = entry.checksum};
+}
+
+RegionEntry compress_region_entry(const std::span<const Byte> data) {
+    return {.compressed_data = lz_compress(data), .num_bytes = static_cast<Uint32>(data.size()), .checksum = hash_entry_data(data)};
+}
+
+bool decompress_region_entry(const RegionEntryView& entry, Rx::Vector<Byte>& data) {
+    ZoneScoped;
+
+    data.resize(entry.num_bytes);
+    if(!lz_decompress(entry.compressed_data, {data.data(), data.size()})) {
+        return false;
+    }
+
+    return hash_entry_data({data.data(), data.size()}) == entry.checksum;
+}
+
+bool RegionFile::write(const Rx::String& path, const Rx::Vector<RegionEntry>& entries) {
+    ZoneScoped;
+
+    const auto num_slots = static_cast<Uint32>(entries.size());
+
+    Rx::Vector<Slot> table{num_slots};
+    auto offset = static_cast<Uint64>(sizeof(Header) + sizeof(Slot) * num_slots);
+    for(Uint32 slot = 0; slot < num_slots; slot++) {
+        const auto& entry = entries[slot];
+        table[slot] = {.offset = offset,
+                       .compressed_size = static_cast<Uint32>(entry.compressed_data.size()),
+                       .num_bytes = entry.num_bytes,
+                       .checksum = entry.checksum};
+        offset += entry.compressed_data.size();
+    }
+
+    const auto temp_path = Rx::String::format("%s.tmp", path);
+    {
+        Rx::Filesystem::File file{temp_path, "wb"};
+        if(!file.is_valid()) {
+            logger->error("Could not open %s for writing", temp_path);
+            return false;
+        }
+
+        const auto header = Header{.magic = REGION_FILE_MAGIC, .version = REGION_FILE_VERSION, .num_slots = num_slots};
+        auto succeeded = file.write(reinterpret_cast<const Byte*>(&header), sizeof(header)) == sizeof(header);
+        succeeded &= file.write(reinterpret_cast<const Byte*>(table.data()), table.size() * sizeof(Slot)) ==
+                     table.size() * sizeof(Slot);
+        entries.each_fwd([&](const RegionEntry& entry) {
+            if(succeeded && !entry.is_empty()) {
+                succeeded = file.write(entry.compressed_data.data(), entry.compressed_data.size()) == entry.compressed_data.size();
+            }
+        });
+
+        if(!succeeded) {
+            logger->error("Could not write %s", temp_path);
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(temp_path.data(), error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path.data(), path.data(), error);
+    if(error) {
+        logger->error("Could not replace %s: %s", path, error.message().c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <span>
+
+#include "core/mapped_file.hpp"
+#include "core/types.hpp"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+
+/*!
+ * \brief One compressed entry in a region file, pointing into the file's mapping
+ */
+struct RegionEntryView {
+    std::span<const Byte> compressed_data;
+
+    /*!
+     * \brief Size of the entry's data once it's decompressed
+     */
+    Uint32 num_bytes{0};
+
+    /*!
+     * \brief FNV-1a hash of the entry's decompressed data
+     */
+    Uint32 checksum{0};
+
+    [[nodiscard]] bool is_empty() const { return compressed_data.empty(); }
+};
+
+/*!
+ * \brief One compressed entry of a region that's held in memory
+ */
+struct RegionEntry {
+    Rx::Vector<Byte> compressed_data;
+
+    /*!
+     * \brief Size of the entry's data once it's decompressed
+     */
+    Uint32 num_bytes{0};
+
+    /*!
+     * \brief FNV-1a hash of the entry's decompressed data
+     */
+    Uint32 checksum{0};
+
+    [[nodiscard]] bool is_empty() const { return compressed_data.is_empty(); }
+
+    [[nodiscard]] RegionEntryView get_view() const {
+        return {.compressed_data = {compressed_data.data(), compressed_data.size()}, .num_bytes = num_bytes, .checksum = checksum};
+    }
+};
+
+/*!
+ * \brief A region file, mapped for random access
+ *
+ * A region file holds a fixed number of slots, each of which may have one entry. Every entry is compressed on its own, so reading one
+ * entry only decompresses that entry. The file starts with a header and an offset table with the location, sizes, and checksum of each
+ * slot's entry, followed by the entries themselves. Opening a region file maps it and checks the offset table, but doesn't read any
+ * entries, so the cost of opening a region doesn't depend on how much is in it
+ *
+ * Region files are only ever written whole, by `write`
+ */
+class RegionFile {
+public:
+    /*!
+     * \brief Maps a region file
+     *
+     * A region file that doesn't exist stays closed, and every one of its slots is empty. A region file that's damaged or has a different
+     * number of slots gets logged and stays closed too
+     */
+    RegionFile(const Rx::String& path, Uint32 num_slots_in);
+
+    [[nodiscard]] bool is_open() const;
+
+    [[nodiscard]] Uint32 get_num_slots() const;
+
+    /*!
+     * \brief Gets a slot's entry, or an empty entry if the slot is empty or the file is closed
+     */
+    [[nodiscard]] RegionEntryView get_entry(Uint32 slot) const;
+
+    /*!
+     * \brief Writes a region file with one slot for each entry
+     *
+     * The file is written next to its final path, then renamed over the old file, so a crash while writing never leaves a half-written
+     * region behind. The old file must not be mapped while this runs, since Windows can't replace mapped files
+     *
+     * Safe to call from any thread, as long as nobody else writes the same region at the same time
+     *
+     * \return Whether the file was written
+     */
+    static bool write(const Rx::String& path, const Rx::Vector<RegionEntry>& entries);
+
+private:
+    struct Header;
+
+    struct Slot;
+
+    MappedFile file;
+
+    Uint32 num_slots;
+
+    /*!
+     * \brief The offset table in the file's mapping, or nullptr if the file is closed
+     */
+    const Slot* slots{nullptr};
+};
+
+/*!
+ * \brief Compresses data into an entry for a region
+ */
+[[nodiscard]] RegionEntry compress_region_entry(std::span<const Byte> data);
+
+/*!
+ * \brief Decompresses an entry from a region
+ *
+ * \return Whether the entry decompressed and its data matched its checksum
+ */
+[[nodiscard]] bool decompress_region_entry(const RegionEntryView& entry, Rx::Vector<Byte>& data);
+
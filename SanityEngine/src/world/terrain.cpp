@@ -1,12 +1,19 @@
 #include "terrain.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.System.Threading.h>
 
 #include "Tracy.hpp"
 #include "TracyD3D12.hpp"
+#include "core/constants.hpp"
 #include "entt/entity/registry.hpp"
 #include "generation/gpu_terrain_generation.hpp"
+#include "generation/terrain_normals.hpp"
+#include "generation/world_generation.hpp"
 #include "loading/image_loading.hpp"
 #include "pix3.h"
 #include "renderer/renderer.hpp"
@@ -14,9 +21,10 @@
 #include "rhi/helpers.hpp"
 #include "rhi/render_device.hpp"
 #include "rx/console/variable.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
 #include "rx/core/array.h"
 #include "rx/core/log.h"
-#include "rx/core/prng/mt19937.h"
 #include "sanity_engine.hpp"
 
 using namespace winrt;
@@ -26,8 +34,52 @@ using winrt::Windows::System::Threading::ThreadPool;
 
 RX_LOG("\033[32mTerrain\033[0m", logger);
 
-RX_CONSOLE_IVAR(
-    cvar_max_terrain_tile_distance, "t.MaxTileDistance", "Maximum distance at which Sanity Engine will load terrain tiles", 1, INT_MAX, 16);
+RX_CONSOLE_IVAR(cvar_max_terrain_tile_distance,
+                "t.MaxTileDistance",
+                "Maximum distance, in tiles, at which Sanity Engine will load terrain",
+                1,
+                INT_MAX,
+                16);
+
+RX_CONSOLE_IVAR(cvar_terrain_lod_levels,
+                "t.TerrainLodLevels",
+                "Number of levels in the terrain quadtree. Each level covers four times as much ground per tile as the level before it",
+                1,
+                8,
+                6);
+
+RX_CONSOLE_FVAR(cvar_terrain_lod_max_error,
+                "t.TerrainLodMaxError",
+                "Largest error, in pixels, that a terrain tile may have on screen before it's split into more detailed tiles",
+                0.1f,
+                100.0f,
+                4.0f);
+
+RX_CONSOLE_IVAR(cvar_terrain_erosion_iterations,
+                "t.TerrainErosionIterations",
+                "Number of iterations of hydraulic erosion to run over the world heightmap when generating a world",
+                0,
+                INT_MAX,
+                64);
+
+RX_CONSOLE_BVAR(cvar_terrain_cache_enabled,
+                "t.TerrainCacheEnabled",
+                "Whether to keep generated terrain tiles in an on-disk cache, so that revisiting them doesn't have to generate them again",
+                true);
+
+RX_CONSOLE_SVAR(cvar_terrain_cache_path, "t.TerrainCachePath", "Path of the terrain tile cache file", "cache/terrain_tiles.cache");
+
+RX_CONSOLE_BVAR(cvar_terrain_cache_meshes,
+                "t.TerrainCacheMeshes",
+                "Whether the terrain tile cache stores tile meshes as well as heights. Makes the cache file about three times as big",
+                true);
+
+RX_CONSOLE_IVAR(cvar_terrain_cache_max_tiles,
+                "t.TerrainCacheMaxTiles",
+                "Maximum number of tiles in the terrain tile cache. Decides the size of the cache file",
+                1,
+                INT_MAX,
+                4096);
 
 RX_CONSOLE_IVAR(cvar_max_generating_terrain_tiles,
                 "t.MaxGeneratingTiles",
@@ -36,37 +88,48 @@ RX_CONSOLE_IVAR(cvar_max_generating_terrain_tiles,
                 INT_MAX,
                 128);
 
-struct GenerateTileTaskArgs {
-    Terrain* terrain{nullptr};
+RX_CONSOLE_IVAR(cvar_terrain_memory_budget_mb,
+                "t.TerrainMemoryBudgetMb",
+                "Maximum number of megabytes that loaded terrain tiles may use before Sanity Engine starts evicting tiles",
+                1,
+                INT_MAX,
+                512);
+
+RX_CONSOLE_BVAR(cvar_water_simulation_enabled,
+                "t.WaterSimulationEnabled",
+                "Whether to simulate the water that flows over the loaded terrain tiles",
+                true);
 
-    Vec2i tilecoord{};
-};
+RX_CONSOLE_IVAR(cvar_water_max_steps_per_frame,
+                "t.WaterMaxStepsPerFrame",
+                "Maximum number of water simulation steps to run in a frame. Water slows down when a frame needs more steps than this",
+                1,
+                INT_MAX,
+                4);
 
-TerrainData Terrain::generate_terrain(FastNoiseSIMD& noise_generator, const WorldParameters& params, renderer::Renderer& renderer) {
+TerrainData Terrain::generate_terrain(const WorldParameters& params, renderer::Renderer& renderer) {
     ZoneScoped;
 
     auto& device = renderer.get_render_device();
     auto commands = device.create_command_list();
     commands->SetName(L"Terrain::generate_terrain");
 
-    const auto total_pixels_in_maps = params.width * params.height;
-    auto data = TerrainData{.size = {.max_latitude = params.height, .max_longitude = params.width},
-                            .heightmap = Rx::Vector<Float32>{total_pixels_in_maps}};
+    auto data = TerrainData{.size = {.max_latitude = params.height, .max_longitude = params.width}};
 
     {
         TracyD3D12Zone(renderer::RenderDevice::tracy_context, commands.get(), "Terrain::generate_terrain");
         PIXScopedEvent(commands.get(), PIX_COLOR_DEFAULT, "Terrain::generate_terrain");
 
         // Generate heightmap
-        generate_heightmap(noise_generator, params, renderer, commands, data, total_pixels_in_maps);
+        generate_heightmap(params, renderer, commands, data);
         const auto heightmap_image = renderer.get_image(data.heightmap_handle);
 
         const auto heightmap_barrier = CD3DX12_RESOURCE_BARRIER::UAV(heightmap_image.resource.get());
 
         commands->ResourceBarrier(1, &heightmap_barrier);
 
-        // Place water sources
-        place_water_sources(params, renderer, commands, data, total_pixels_in_maps);
+        // Find where water pools into lakes and flows as rivers
+        place_water_sources(params, renderer, commands, data);
         const auto water_depth_image = renderer.get_image(data.water_depth_handle);
 
         terraingen::place_oceans(commands, renderer, params.min_terrain_depth_under_ocean + params.max_ocean_depth, data);
@@ -82,120 +145,215 @@ TerrainData Terrain::generate_terrain(FastNoiseSIMD& noise_generator, const Worl
 
 Terrain::Terrain(const TerrainData& data,
                  renderer::Renderer& renderer_in,
-                 FastNoiseSIMD& noise_generator_in,
-                 SynchronizedResource<entt::registry>& registry_in)
+                 const terraingen::NoiseConfig& noise_config_in,
+                 SynchronizedResource<entt::registry>& registry_in,
+                 WorldSave& save_in)
     : renderer{&renderer_in},
-      noise_generator{&noise_generator_in},
+      noise_config{noise_config_in},
       registry{&registry_in},
+      save{&save_in},
       max_latitude{data.size.max_latitude},
       max_longitude{data.size.max_longitude},
       min_terrain_height{data.size.min_terrain_height},
       max_terrain_height{data.size.max_terrain_height} {
 
+    renderer->create_terrain_mesh_store(TILE_SIZE + 1, MAX_NUM_TERRAIN_TILES);
+
+    // The world's heightmap was generated with the same noise as the tiles, then eroded, so it's only an approximation of the tiles'
+    // heights. Its rows run along the x axis, and it's centered on the origin
+    const auto fallback_width = max_latitude * 2;
+    const auto fallback_depth = max_longitude * 2;
+    if(data.heightmap.size() == static_cast<Size>(fallback_width) * fallback_depth) {
+        fallback_heightmap = TerrainFallbackHeightmap{.origin = {-static_cast<Float32>(max_latitude), -static_cast<Float32>(max_longitude)},
+                                                      .width = fallback_width,
+                                                      .depth = fallback_depth,
+                                                      .heights = data.heightmap};
+        if(data.water_depths.size() == data.heightmap.size()) {
+            fallback_heightmap.water_depths = data.water_depths;
+        }
+
+        if(data.humidity_map.size() == data.heightmap.size()) {
+            fallback_heightmap.humidity = data.humidity_map;
+        }
+
+        if(data.soil_moisture.size() == data.heightmap.size()) {
+            fallback_heightmap.soil_moisture = data.soil_moisture;
+        }
+
+        if(data.water_distance.size() == data.heightmap.size()) {
+            fallback_heightmap.water_distance = data.water_distance;
+        }
+
+        if(data.groundwater.size() == data.heightmap.size()) {
+            fallback_heightmap.groundwater = data.groundwater;
+        }
+
+        if(data.ecotype_map.width == fallback_width && data.ecotype_map.depth == fallback_depth) {
+            fallback_heightmap.ecotypes = data.ecotype_map;
+        }
+    } else {
+        logger->warning("World heightmap has %zu heights instead of %ux%u. Terrain queries won't have any fallback heights",
+                        data.heightmap.size(),
+                        fallback_width,
+                        fallback_depth);
+    }
+
+    current_height_snapshot = Rx::make_ptr<TerrainHeightSnapshot>(RX_SYSTEM_ALLOCATOR,
+                                                                  TILE_SIZE,
+                                                                  Rx::Vector<TerrainHeightSnapshot::Tile>{},
+                                                                  &fallback_heightmap);
+    published_height_snapshot.store(current_height_snapshot.get());
+
+    water_simulation = Rx::make_ptr<TerrainWaterSimulation>(RX_SYSTEM_ALLOCATOR,
+                                                            TILE_SIZE,
+                                                            TerrainWaterSettings{},
+                                                            Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
+
+    const auto scatter_settings = environment::ScatterSettings{.seed = static_cast<Uint64>(noise_config.seed), .tile_size = TILE_SIZE};
+    object_placer = Rx::make_ptr<environment::EnvironmentObjectPlacer>(RX_SYSTEM_ALLOCATOR, scatter_settings, &fallback_heightmap);
+
+    if(cvar_terrain_cache_enabled->get()) {
+        const auto generator_hash = TerrainTileCache::get_generator_hash(noise_config,
+                                                                         TILE_SIZE,
+                                                                         static_cast<Float32>(min_terrain_height),
+                                                                         static_cast<Float32>(max_terrain_height));
+        tile_cache = Rx::make_ptr<TerrainTileCache>(RX_SYSTEM_ALLOCATOR,
+                                                    TerrainTileCacheCreateInfo{.path = cvar_terrain_cache_path->get(),
+                                                                               .generator_hash = generator_hash,
+                                                                               .grid_size = TILE_SIZE + 1,
+                                                                               .max_num_tiles = static_cast<Uint32>(
+                                                                                   cvar_terrain_cache_max_tiles->get()),
+                                                                               .store_meshes = cvar_terrain_cache_meshes->get()});
+    }
+
     // TODO: Make a good data structure to load the terrain material(s) at runtime
     load_terrain_textures_and_create_material();
 }
 
+Terrain::~Terrain() {
+    Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+    loaded_terrain_tiles.each_value([&](const TerrainTile& tile) { heightmap_pool.free(tile.heightmap); });
+    evicted_heightmaps.each_fwd([&](const TileHeightmap& heightmap) { heightmap_pool.free(heightmap); });
+    retired_heightmaps.each_fwd([&](const TileHeightmap& heightmap) { heightmap_pool.free(heightmap); });
+}
+
 void Terrain::tick(float delta_time) {
     ZoneScoped;
 
+    free_evicted_meshes();
+
     upload_new_tile_meshes();
+
+    if(cvar_water_simulation_enabled->get()) {
+        water_simulation->advance(delta_time, static_cast<Uint32>(cvar_water_max_steps_per_frame->get()));
+    }
+
+    object_placer->collect_placed_tiles();
+
+    update_height_snapshot();
 }
 
-void Terrain::load_terrain_around_player(const TransformComponent& player_transform) {
+void Terrain::load_terrain_around_player(const TransformComponent& player_transform, const Float32 delta_time) {
     ZoneScoped;
-    const auto coords_of_tile_containing_player = get_coords_of_tile_containing_position(
-        {player_transform.location.x, player_transform.location.y, player_transform.location.z});
 
-    // V0: load the tile the player is in and nothing else
+    frame_count++;
 
-    // V1: load the tiles in the player's frustum, plus a few on either side so it's nice and fast for the player to spin around
+    const auto view = get_streaming_view(player_transform, delta_time);
+    const auto settings = TileStreamingSettings{.tile_size = TILE_SIZE, .max_tile_distance = cvar_max_terrain_tile_distance->get()};
+    const auto lod_settings = get_lod_settings();
+    const auto skirt_depth = get_terrain_skirt_depth(lod_settings);
 
-    // TODO: Define some maximum number of tiles that may be loaded/generated in a given frame
+    select_terrain_nodes(view, settings, lod_settings, tile_requests);
 
-    Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+    Rx::Vector<entt::entity> shown_entities;
+    Rx::Vector<entt::entity> hidden_entities;
 
-    if(loaded_terrain_tiles.find(coords_of_tile_containing_player) == nullptr) {
-        logger->verbose("Marking tile (%d, %d) as having started loading",
-                        coords_of_tile_containing_player.x,
-                        coords_of_tile_containing_player.y);
-        loaded_terrain_tiles.insert(coords_of_tile_containing_player, {});
-        num_active_tilegen_tasks.fetch_add(1);
-        ThreadPool::RunAsync([=](const IAsyncAction& /* work_item */) { generate_tile(coords_of_tile_containing_player); });
-    }
+    {
+        Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
 
-    // const auto max_tile_distance = cvar_max_terrain_tile_distance->get();
-    // for(Int32 distance_from_player = 1; distance_from_player < max_tile_distance; distance_from_player++) {
-    //     for(Int32 chunk_y = -distance_from_player; chunk_y <= distance_from_player; chunk_y++) {
-    //         for(Int32 chunk_x = -distance_from_player; chunk_x <= distance_from_player; chunk_x++) {
-    //             // Only generate chunks at the edge of our current square
-    //             if((chunk_y != -distance_from_player) && (chunk_y != distance_from_player) && (chunk_x != -distance_from_player) &&
-    //                (chunk_x != distance_from_player)) {
-    //                 continue;
-    //             }
-    //
-    //             const auto new_tile_coords = coords_of_tile_containing_player + Vec2i{chunk_x, chunk_y};
-    //
-    //             if(loaded_terrain_tiles.find(new_tile_coords) == nullptr) {
-    //                 if(num_active_tilegen_tasks.load() < static_cast<Uint32>(cvar_max_generating_terrain_tiles->get())) {
-    //                     logger->verbose("Marking tile (%d, %d) as having started loading", new_tile_coords.x, new_tile_coords.y);
-    //                     loaded_terrain_tiles.insert(new_tile_coords, {});
-    //                     num_active_tilegen_tasks.fetch_add(1);
-    //                     ThreadPool::RunAsync([=](const IAsyncAction& /* work_item */) { generate_tile(new_tile_coords); });
-    //                 }
-    //             }
-    //         }
-    //     }
-    // }
-}
-
-Float32 Terrain::get_terrain_height(const Vec2f& location) {
-    const auto tilecoords = get_coords_of_tile_containing_position({location.x, 0, location.y});
-
-    const auto tile_start_location = tilecoords * static_cast<Int32>(TILE_SIZE);
-    const auto location_within_tile = Vec2u{static_cast<Uint32>(abs(round(location.x - tile_start_location.x))),
-                                            static_cast<Uint32>(abs(round(location.y - tile_start_location.y)))};
+        drop_stale_tile_requests();
 
-    Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
-    if(const auto* tile = loaded_terrain_tiles.find(tilecoords)) {
-        if(tile->loading_phase != TerrainTile::LoadingPhase::GeneratingHeightmap) {
-            return tile->heightmap[location_within_tile.y][location_within_tile.x];
-        }
+        // Tiles count against the limit until their meshes are uploaded, so this also bounds the mesh upload queue
+        const auto max_generating_tiles = static_cast<Uint32>(cvar_max_generating_terrain_tiles->get());
+        tile_requests.each_fwd([&](const TerrainNodeRequest& request) {
+            const auto& node = request.node;
+            if(auto* tile = loaded_terrain_tiles.find(node)) {
+                tile->last_used_frame = frame_count;
+                return;
+            }
+
+            if(num_active_tilegen_tasks.load() >= max_generating_tiles) {
+                return;
+            }
+
+            const auto request_id = next_tile_request_id++;
+
+            logger->verbose("Marking tile (%d, %d) at level %u as having started loading", node.coord.x, node.coord.y, node.level);
+            loaded_terrain_tiles.insert(node, TerrainTile{.request_id = request_id, .node = node, .last_used_frame = frame_count});
+
+            // The world save only reads regions on this thread, so look the tile up here and hand its heights to the generation task
+            if(node.level == 0) {
+                if(auto heights = save->load_tile(node.coord)) {
+                    saved_tile_heights.insert(request_id, Rx::Utility::move(*heights));
+                }
+            }
+
+            num_active_tilegen_tasks.fetch_add(1);
+            ThreadPool::RunAsync([=](const IAsyncAction& /* work_item */) { generate_tile(node, request_id, skirt_depth); });
+        });
+
+        update_visible_tiles(shown_entities, hidden_entities);
     }
 
-    // Tile isn't loaded yet. Figure out how to handle this. Right now I don't want to deal with it, so I won't
-    return 0;
+    if(!shown_entities.is_empty() || !hidden_entities.is_empty()) {
+        auto locked_registry = registry->lock();
+        shown_entities.each_fwd([&](const entt::entity entity) {
+            locked_registry->get<renderer::TerrainTileRenderableComponent>(entity).is_visible = true;
+        });
+        hidden_entities.each_fwd([&](const entt::entity entity) {
+            locked_registry->get<renderer::TerrainTileRenderableComponent>(entity).is_visible = false;
+        });
+    }
+
+    evict_tiles_over_budget();
+}
+
+void Terrain::sample_terrain(const std::span<const Vec2f> locations, const std::span<TerrainSample> samples) const {
+    const auto guard = height_snapshot_reclaimer.enter();
+    published_height_snapshot.load()->sample(locations, samples);
+}
+
+Float32 Terrain::get_terrain_height(const Vec2f& location) const {
+    TerrainSample sample;
+    sample_terrain({&location, 1}, {&sample, 1});
+    return sample.height;
 }
 
 Vec2i Terrain::get_coords_of_tile_containing_position(const Vec3f& position) {
-    return Vec2i{static_cast<Int32>(round(position.x)), static_cast<Int32>(round(position.z))} / static_cast<Int32>(TILE_SIZE);
+    return get_tile_containing_location(Vec2f{position.x, position.z}, TILE_SIZE);
 }
 
-void Terrain::generate_heightmap(FastNoiseSIMD& noise_generator,
-                                 const WorldParameters& params,
+Size Terrain::get_loaded_tiles_memory_usage() const {
+    Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+    return loaded_tiles_memory_usage;
+}
+
+void Terrain::generate_heightmap(const WorldParameters& params,
                                  renderer::Renderer& renderer,
                                  const com_ptr<ID3D12GraphicsCommandList4>& commands,
-                                 TerrainData& data,
-                                 const unsigned total_pixels_in_maps) {
+                                 TerrainData& data) {
     ZoneScoped;
 
     TracyD3D12Zone(renderer::RenderDevice::tracy_context, commands.get(), "Terrain::generate_heightmap");
     PIXScopedEvent(commands.get(), PIX_COLOR_DEFAULT, "Terrain::generate_heightmap");
 
-    auto* height_noise = noise_generator.GetNoiseSet(-static_cast<Int32>(params.width) / 2,
-                                                     -static_cast<Int32>(params.height) / 2,
-                                                     0,
-                                                     params.width,
-                                                     params.height,
-                                                     1);
-
-    memcpy(data.heightmap.data(), height_noise, total_pixels_in_maps * sizeof(Float32));
+    data.heightmap = terraingen::generate_world_heightmap(params, Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
 
-    const auto min_terrain_height = params.min_terrain_depth_under_ocean;
-    const auto max_terrain_height = params.min_terrain_depth_under_ocean + params.max_ocean_depth + params.max_height_above_sea_level;
-    const auto height_range = max_terrain_height - min_terrain_height;
-
-    data.heightmap.each_fwd([&](Float32& height) { height = height * height_range + min_terrain_height; });
+    const auto num_erosion_iterations = static_cast<Uint32>(cvar_terrain_erosion_iterations->get());
+    terraingen::erode_world_heightmap({data.heightmap.data(), data.heightmap.size()},
+                                      params,
+                                      num_erosion_iterations,
+                                      Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
 
     data.heightmap_handle = renderer.create_image({.name = "Terrain Heightmap",
                                                    .usage = renderer::ImageUsage::UnorderedAccess,
@@ -209,39 +367,29 @@ void Terrain::generate_heightmap(FastNoiseSIMD& noise_generator,
 void Terrain::place_water_sources(const WorldParameters& params,
                                   renderer::Renderer& renderer,
                                   const com_ptr<ID3D12GraphicsCommandList4>& commands,
-                                  TerrainData& data,
-                                  const unsigned total_pixels_in_maps) {
+                                  TerrainData& data) {
     ZoneScoped;
 
     TracyD3D12Zone(renderer::RenderDevice::tracy_context, commands.get(), "Terrain::place_water_sources");
     PIXScopedEvent(commands.get(), PIX_COLOR_DEFAULT, "Terrain::place_water_sources");
 
-    Rx::Vector<Float32> water_depth_map{total_pixels_in_maps};
-
-    constexpr Float32 water_source_spawn_rate = 0.0001f;
-
-    const auto num_water_sources = static_cast<Float32>(total_pixels_in_maps) * water_source_spawn_rate;
-
-    Rx::Vector<glm::uvec2> water_source_locations{static_cast<Uint32>(num_water_sources)};
+    auto water = terraingen::find_world_water({data.heightmap.data(), data.heightmap.size()},
+                                              params,
+                                              Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
 
-    Rx::PRNG::MT19937 random_number_generator;
-    random_number_generator.seed(params.seed);
-
-    water_source_locations.each_fwd([&](glm::uvec2& location) {
-        const auto x = round(random_number_generator.f32() * params.width);
-        const auto y = round(random_number_generator.f32() * params.height);
-        location = {static_cast<Uint32>(x), static_cast<Uint32>(y)};
-
-        water_depth_map[location.y * params.width + location.x] = 1;
-    });
+    data.flow_accumulation = Rx::Utility::move(water.flow_accumulation);
+    data.river_mask = Rx::Utility::move(water.river_mask);
+    data.lake_mask = Rx::Utility::move(water.lake_mask);
 
     data.water_depth_handle = renderer.create_image({.name = "Terrain Water Map",
                                                      .usage = renderer::ImageUsage::UnorderedAccess,
                                                      .format = renderer::ImageFormat::Rg16F,
                                                      .width = params.width,
                                                      .height = params.height},
-                                                    water_depth_map.data(),
+                                                    water.water_depths.data(),
                                                     commands);
+
+    data.water_depths = Rx::Utility::move(water.water_depths);
 }
 
 void Terrain::compute_water_flow(renderer::Renderer& renderer, const com_ptr<ID3D12GraphicsCommandList4>& commands, TerrainData& data) {
@@ -285,111 +433,452 @@ void Terrain::load_terrain_textures_and_create_material() {
     terrain_material = renderer->allocate_standard_material(material);
 }
 
-void Terrain::generate_tile(const Vec2i& tilecoord) {
+TileStreamingView Terrain::get_streaming_view(const TransformComponent& player_transform, const Float32 delta_time) {
+    const auto location = Vec2f{player_transform.location.x, player_transform.location.z};
+    if(frame_count == 1) {
+        last_player_location = location;
+    }
+
+    auto view = TileStreamingView{.location = location, .height = player_transform.location.y};
+
+    // The player looks down their transform's negative forward axis
+    const auto forward = -player_transform.get_forward_vector();
+    const auto horizontal_forward = Vec2f{forward.x, forward.z};
+    const auto horizontal_forward_length = Rx::Math::length(horizontal_forward);
+    if(horizontal_forward_length > 0.001f) {
+        view.view_direction = horizontal_forward / horizontal_forward_length;
+    }
+
+    if(delta_time > 0) {
+        view.velocity = (location - last_player_location) / delta_time;
+    }
+
+    last_player_location = location;
+
+    return view;
+}
+
+TerrainLodSettings Terrain::get_lod_settings() const {
+    return TerrainLodSettings{.num_levels = static_cast<Uint32>(cvar_terrain_lod_levels->get()),
+                              .max_screen_space_error = cvar_terrain_lod_max_error->get(),
+                              .min_terrain_height = static_cast<Float32>(min_terrain_height),
+                              .max_terrain_height = static_cast<Float32>(max_terrain_height)};
+}
+
+static bool overlaps_any(const TerrainNodeKey& node, const Rx::Vector<TerrainNodeKey>& nodes) {
+    for(Size i = 0; i < nodes.size(); i++) {
+        if(node.overlaps(nodes[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool contains_node(const Rx::Vector<TerrainNodeKey>& nodes, const TerrainNodeKey& node) {
+    for(Size i = 0; i < nodes.size(); i++) {
+        if(nodes[i] == node) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Terrain::drop_stale_tile_requests() {
+    // Only drop tiles whose task hasn't published a heightmap yet. Once a tile is generating its mesh, its task and the upload queue
+    // both refer to it, so we let it finish and let the LRU eviction deal with it
+    Rx::Vector<TerrainNodeKey> stale_tiles;
+    loaded_terrain_tiles.each_value([&](const TerrainTile& tile) {
+        if(tile.loading_phase != TerrainTile::LoadingPhase::GeneratingHeightmap) {
+            return;
+        }
+
+        const auto is_selected = [&] {
+            for(Size i = 0; i < tile_requests.size(); i++) {
+                if(tile_requests[i].node == tile.node) {
+                    return true;
+                }
+            }
+
+            return false;
+        }();
+
+        if(!is_selected) {
+            stale_tiles.push_back(tile.node);
+        }
+    });
+
+    stale_tiles.each_fwd([&](const TerrainNodeKey& node) {
+        logger->verbose("Dropping request for tile (%d, %d) at level %u", node.coord.x, node.coord.y, node.level);
+        loaded_terrain_tiles.erase(node);
+    });
+}
+
+void Terrain::update_visible_tiles(Rx::Vector<entt::entity>& shown_entities, Rx::Vector<entt::entity>& hidden_entities) {
     ZoneScoped;
 
-    const auto top_left = tilecoord * static_cast<Int32>(TILE_SIZE);
-    const auto size = Vec2u{TILE_SIZE, TILE_SIZE};
+    const auto is_complete = [&](const TerrainNodeKey& node) {
+        const auto* tile = loaded_terrain_tiles.find(node);
+        return tile != nullptr && tile->loading_phase == TerrainTile::LoadingPhase::Complete;
+    };
+
+    Rx::Vector<TerrainNodeKey> pending_nodes;
+    tile_requests.each_fwd([&](const TerrainNodeRequest& request) {
+        if(!is_complete(request.node)) {
+            pending_nodes.push_back(request.node);
+        }
+    });
+
+    // Keep drawing last frame's tiles wherever the selected tiles aren't ready yet. A kept tile either contains the pending tiles or is
+    // inside one of them, so the selected tiles that it overlaps wait until it's no longer needed
+    Rx::Vector<TerrainNodeKey> new_visible_tiles;
+    visible_tiles.each_fwd([&](const TerrainNodeKey& node) {
+        if(is_complete(node) && overlaps_any(node, pending_nodes)) {
+            new_visible_tiles.push_back(node);
+        }
+    });
 
-    logger->info("Generating tile (%d, %d) with size (%d, %d)", tilecoord.x, tilecoord.y, size.x, size.y);
+    const auto kept_tiles = new_visible_tiles;
+    tile_requests.each_fwd([&](const TerrainNodeRequest& request) {
+        if(is_complete(request.node) && !overlaps_any(request.node, kept_tiles)) {
+            new_visible_tiles.push_back(request.node);
+        }
+    });
 
-    auto tile_heightmap = generate_terrain_heightmap(top_left, size);
+    new_visible_tiles.each_fwd([&](const TerrainNodeKey& node) {
+        auto* tile = loaded_terrain_tiles.find(node);
+        tile->last_used_frame = frame_count;
 
-    const auto tile_entity = registry->lock()->create();
+        if(!contains_node(visible_tiles, node)) {
+            shown_entities.push_back(tile->entity);
+        }
+    });
+
+    visible_tiles.each_fwd([&](const TerrainNodeKey& node) {
+        if(contains_node(new_visible_tiles, node)) {
+            return;
+        }
+
+        if(const auto* tile = loaded_terrain_tiles.find(node)) {
+            hidden_entities.push_back(tile->entity);
+        }
+    });
+
+    visible_tiles = Rx::Utility::move(new_visible_tiles);
+}
+
+void Terrain::evict_tiles_over_budget() {
+    ZoneScoped;
+
+    const auto memory_budget = static_cast<Size>(cvar_terrain_memory_budget_mb->get()) * 1024 * 1024;
+
+    // Every tile that's generating needs a free slot in the terrain mesh store when it's done. Tiles that are waiting for the GPU to
+    // finish with them will be free soon, so they count as free
+    const auto* terrain_mesh_store = renderer->get_terrain_mesh_store();
+    const auto min_free_tiles = static_cast<Size>(cvar_max_generating_terrain_tiles->get());
+
+    Rx::Vector<TerrainTile> evicted_tiles;
+
+    const auto needs_eviction = [&] {
+        const auto num_free_tiles = terrain_mesh_store->get_num_free_tiles() + pending_mesh_frees.size() + evicted_tiles.size();
+        return loaded_tiles_memory_usage > memory_budget || num_free_tiles < min_free_tiles;
+    };
 
     {
         Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
-        auto* tile = loaded_terrain_tiles.find(tilecoord);
-        tile->loading_phase = TerrainTile::LoadingPhase::GeneratingMesh;
-        tile->heightmap = tile_heightmap;
-        tile->coord = tilecoord;
-        tile->entity = tile_entity;
+        if(!needs_eviction()) {
+            return;
+        }
+
+        Rx::Vector<TerrainTile> eviction_candidates;
+        loaded_terrain_tiles.each_value([&](const TerrainTile& tile) {
+            if(tile.loading_phase == TerrainTile::LoadingPhase::Complete && tile.last_used_frame < frame_count) {
+                eviction_candidates.push_back(tile);
+            }
+        });
+
+        std::sort(eviction_candidates.data(),
+                  eviction_candidates.data() + eviction_candidates.size(),
+                  [](const TerrainTile& a, const TerrainTile& b) { return a.last_used_frame < b.last_used_frame; });
+
+        for(Size i = 0; i < eviction_candidates.size() && needs_eviction(); i++) {
+            const auto& tile = eviction_candidates[i];
+
+            // The published height snapshot might still refer to this tile's heights
+            if(tile.heightmap.is_valid()) {
+                evicted_heightmaps.push_back(tile.heightmap);
+                is_height_snapshot_stale = true;
+            }
+
+            if(tile.node.level == 0) {
+                water_simulation->remove_tile(tile.node.coord);
+                object_placer->remove_tile(tile.node.coord);
+                newly_evicted_tiles.push_back(tile.node.coord);
+            }
+
+            loaded_tiles_memory_usage -= tile.memory_usage;
+            loaded_terrain_tiles.erase(tile.node);
+
+            evicted_tiles.push_back(tile);
+        }
+
+        if(loaded_tiles_memory_usage > memory_budget) {
+            logger->warning("Terrain tiles in streaming range use %zu bytes, which is over the budget of %zu bytes",
+                            loaded_tiles_memory_usage,
+                            memory_budget);
+        }
     }
 
-    logger->verbose("Finished generating heightmap for tile (%d, %d)", tilecoord.x, tilecoord.y);
+    evicted_tiles.each_fwd([&](const TerrainTile& tile) {
+        logger->verbose("Evicting tile (%d, %d) at level %u", tile.node.coord.x, tile.node.coord.y, tile.node.level);
+        release_tile_render_resources(tile);
+    });
+}
 
-    Rx::Vector<StandardVertex> tile_vertices;
-    tile_vertices.reserve(tile_heightmap.size() * tile_heightmap[0].size());
+void Terrain::release_tile_render_resources(const TerrainTile& tile) {
+    registry->lock()->destroy(tile.entity);
 
-    Rx::Vector<Uint32> tile_indices;
-    tile_indices.reserve(tile_vertices.size() * 6);
+    if(tile.node.level == 0) {
+        renderer->remove_raytracing_geometry(tile.raytracing_geometry);
+    }
 
-    for(Uint32 y = 0; y < tile_heightmap.size(); y++) {
-        const auto& tile_heightmap_row = tile_heightmap[y];
-        for(Uint32 x = 0; x < tile_heightmap_row.size(); x++) {
-            const auto height = tile_heightmap_row[x];
+    pending_mesh_frees.push_back({.mesh = tile.mesh, .frames_until_free = renderer->get_render_device().get_max_num_gpu_frames()});
+}
 
-            const auto normal = get_normal_at_location(Vec2f{static_cast<Float32>(x), static_cast<Float32>(y)});
+void Terrain::free_evicted_meshes() {
+    if(pending_mesh_frees.is_empty()) {
+        return;
+    }
 
-            tile_vertices.push_back(StandardVertex{.position = {static_cast<Float32>(x), height, static_cast<Float32>(y)},
-                                                   .normal = normal,
-                                                   .color = 0xFFFFFFFF,
-                                                   .texcoord = {static_cast<Float32>(x), static_cast<Float32>(y)}});
+    auto* terrain_mesh_store = renderer->get_terrain_mesh_store();
 
-            if(x < tile_heightmap_row.size() - 1 && y < tile_heightmap.size() - 1) {
-                const auto width = static_cast<Uint32>(tile_heightmap_row.size());
-                const auto face_start_idx = static_cast<Uint32>(y * width + x);
+    Rx::Vector<PendingMeshFree> still_pending;
+    pending_mesh_frees.each_fwd([&](PendingMeshFree& pending_free) {
+        if(pending_free.frames_until_free == 0) {
+            terrain_mesh_store->free_tile(pending_free.mesh);
+        } else {
+            pending_free.frames_until_free--;
+            still_pending.push_back(pending_free);
+        }
+    });
 
-                // TODO: Triangulate the terrain mesh such that the vertices joined by an edge have more similar normals the the vertices
-                // that don't share an edge
+    pending_mesh_frees = Rx::Utility::move(still_pending);
+}
 
-                tile_indices.push_back(face_start_idx);
-                tile_indices.push_back(face_start_idx + 1);
-                tile_indices.push_back(face_start_idx + width);
+bool Terrain::is_tile_request_current(const TerrainNodeKey& node, const Uint64 request_id) const {
+    const auto* tile = loaded_terrain_tiles.find(node);
+    return tile != nullptr && tile->request_id == request_id;
+}
 
-                tile_indices.push_back(face_start_idx + width);
-                tile_indices.push_back(face_start_idx + 1);
-                tile_indices.push_back(face_start_idx + width + 1);
-            }
+void Terrain::generate_tile(const TerrainNodeKey& node, const Uint64 request_id, const Float32 skirt_depth) {
+    ZoneScoped;
+
+    Rx::Vector<Float32> saved_apron_heights;
+    {
+        Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+
+        // Take the saved heights even if the request is stale, so they don't stay in the map forever
+        if(auto* heights = saved_tile_heights.find(request_id)) {
+            saved_apron_heights = Rx::Utility::move(*heights);
+            saved_tile_heights.erase(request_id);
+        }
+
+        if(!is_tile_request_current(node, request_id)) {
+            logger->verbose("Tile (%d, %d) at level %u was dropped before it started generating", node.coord.x, node.coord.y, node.level);
+            num_active_tilegen_tasks.fetch_sub(1);
+            return;
         }
     }
 
+    // Level 0 tiles keep their heights for gameplay queries. This task owns the heightmap block until it hands it to the tile, so we
+    // don't need to hold the tiles lock while we fill it
+    auto tile_heightmap = node.level == 0 ? heightmap_pool.allocate() : TileHeightmap{};
+    auto* heightmap = tile_heightmap.is_valid() ? &tile_heightmap : nullptr;
+
+    const auto grid_size = TILE_SIZE + 1;
+    const auto num_apron_heights = static_cast<Size>(grid_size + 2) * (grid_size + 2);
+    if(!saved_apron_heights.is_empty() && saved_apron_heights.size() != num_apron_heights) {
+        logger->warning("Saved tile (%d, %d) has %zu heights instead of %zu, generating it again",
+                        node.coord.x,
+                        node.coord.y,
+                        saved_apron_heights.size(),
+                        num_apron_heights);
+        saved_apron_heights.clear();
+    }
+
+    Rx::Vector<Float32> apron_heights_to_save;
+    terraingen::TerrainNodeMesh tile_mesh;
+    if(!saved_apron_heights.is_empty()) {
+        logger->verbose("Loading tile (%d, %d) from the world save", node.coord.x, node.coord.y);
+        tile_mesh = terraingen::build_terrain_node_mesh({saved_apron_heights.data(), saved_apron_heights.size()},
+                                                        grid_size,
+                                                        static_cast<Float32>(node.get_texel_size()),
+                                                        skirt_depth,
+                                                        heightmap);
+    } else {
+        tile_mesh = load_or_generate_tile_mesh(node, skirt_depth, heightmap, node.level == 0 ? &apron_heights_to_save : nullptr);
+    }
+
+    const auto tile_entity = registry->lock()->create();
+
+    bool is_tile_still_wanted;
     {
-        auto locked_tile_mesh_queue = tile_mesh_create_infos.lock();
-        locked_tile_mesh_queue->emplace_back(tilecoord, tile_entity, Rx::Utility::move(tile_vertices), Rx::Utility::move(tile_indices));
+        Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+        is_tile_still_wanted = is_tile_request_current(node, request_id);
+        if(is_tile_still_wanted) {
+            auto* tile = loaded_terrain_tiles.find(node);
+            tile->loading_phase = TerrainTile::LoadingPhase::GeneratingMesh;
+            tile->heightmap = tile_heightmap;
+            tile->entity = tile_entity;
+        }
     }
 
-    logger->verbose("Finished generating mesh for tile (%d, %d)", tilecoord.x, tilecoord.y);
+    if(!is_tile_still_wanted) {
+        logger->verbose("Tile (%d, %d) at level %u was dropped while it was generating", node.coord.x, node.coord.y, node.level);
+        heightmap_pool.free(tile_heightmap);
+        registry->lock()->destroy(tile_entity);
+        num_active_tilegen_tasks.fetch_sub(1);
+        return;
+    }
+
+    {
+        auto locked_tile_mesh_queue = tile_mesh_create_infos.lock();
+        locked_tile_mesh_queue->emplace_back(node,
+                                             request_id,
+                                             tile_entity,
+                                             Rx::Utility::move(tile_mesh),
+                                             Rx::Utility::move(apron_heights_to_save));
+    }
 
-    num_active_tilegen_tasks.fetch_sub(1);
+    logger->verbose("Finished generating mesh for tile (%d, %d) at level %u", node.coord.x, node.coord.y, node.level);
 }
 
-Rx::Vector<Rx::Vector<Float32>> Terrain::generate_terrain_heightmap(const Vec2i& top_left, const Vec2u& size) {
-    const auto height_range = max_terrain_height - min_terrain_height;
+void Terrain::update_height_snapshot() {
+    ZoneScoped;
+
+    if(retired_height_snapshot) {
+        if(!height_snapshot_reclaimer.is_previous_epoch_quiescent()) {
+            return;
+        }
+
+        retired_height_snapshot = nullptr;
+        retired_heightmaps.each_fwd([&](const TileHeightmap& heightmap) { heightmap_pool.free(heightmap); });
+        retired_heightmaps.clear();
+    }
 
-    Rx::Vector<Rx::Vector<Float32>> heightmap;
-    heightmap.reserve(size.x);
+    if(!is_height_snapshot_stale && !water_simulation->has_unpublished_changes()) {
+        return;
+    }
 
-    auto raw_noise = Rx::Vector<Float32>{size.y * size.x};
+    // The water simulation double-buffers its published depths, which is safe because the snapshot before the current one is retired
+    water_simulation->publish();
 
+    Rx::Vector<TerrainHeightSnapshot::Tile> tiles;
     {
-        Rx::Concurrency::ScopeLock l{noise_generator_mutex};
-        noise_generator->FillNoiseSet(raw_noise.data(), top_left.x, top_left.y, 1, size.x, size.y, 1);
+        Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+        loaded_terrain_tiles.each_value([&](const TerrainTile& tile) {
+            if(tile.loading_phase == TerrainTile::LoadingPhase::Complete && tile.heightmap.is_valid()) {
+                tiles.push_back({.coord = tile.node.coord,
+                                 .heights = tile.heightmap.heights,
+                                 .water_depths = water_simulation->get_published_depths(tile.node.coord)});
+            }
+        });
     }
 
-    for(Uint32 y = 0; y < size.y; y++) {
-        for(Uint32 x = 0; x < size.x; x++) {
-            if(heightmap.size() <= y) {
-                heightmap.emplace_back();
-                heightmap[y].reserve(size.x);
+    auto new_snapshot = Rx::make_ptr<TerrainHeightSnapshot>(RX_SYSTEM_ALLOCATOR, TILE_SIZE, tiles, &fallback_heightmap);
+
+    // Readers that entered before the advance may still be using the old snapshot, along with the heights of tiles that were evicted
+    // while it was current
+    published_height_snapshot.store(new_snapshot.get());
+    height_snapshot_reclaimer.advance();
+
+    retired_height_snapshot = Rx::Utility::move(current_height_snapshot);
+    current_height_snapshot = Rx::Utility::move(new_snapshot);
+
+    retired_heightmaps = Rx::Utility::move(evicted_heightmaps);
+    evicted_heightmaps.clear();
+
+    is_height_snapshot_stale = false;
+}
+
+static void copy_to_vector(const std::span<const Float32> heights, Rx::Vector<Float32>& vector) {
+    vector.resize(heights.size());
+    memcpy(vector.data(), heights.data(), heights.size_bytes());
+}
+
+terraingen::TerrainNodeMesh Terrain::load_or_generate_tile_mesh(const TerrainNodeKey& node,
+                                                                const Float32 skirt_depth,
+                                                                TileHeightmap* heightmap,
+                                                                Rx::Vector<Float32>* apron_heights) {
+    ZoneScoped;
+
+    const auto grid_size = TILE_SIZE + 1;
+    const auto texel_size = static_cast<Float32>(node.get_texel_size());
+
+    if(tile_cache) {
+        if(const auto cached_tile = tile_cache->find(node)) {
+            logger->verbose("Loading tile (%d, %d) at level %u from the tile cache", node.coord.x, node.coord.y, node.level);
+
+            if(apron_heights != nullptr) {
+                copy_to_vector(cached_tile->apron_heights, *apron_heights);
             }
-            if(heightmap[y].size() <= x) {
-                heightmap[y].emplace_back();
+
+            // A mesh with a different skirt depth might leave cracks next to the other tiles, so mesh those tiles again from their heights
+            if(!cached_tile->vertices.empty() && cached_tile->skirt_depth == skirt_depth) {
+                if(heightmap != nullptr) {
+                    terraingen::copy_apron_heights_to_heightmap(cached_tile->apron_heights, grid_size, *heightmap);
+                }
+
+                auto mesh = terraingen::TerrainNodeMesh{.vertices = Rx::Vector<TerrainVertex>{cached_tile->vertices.size()},
+                                                        .min_height = cached_tile->min_height,
+                                                        .max_height = cached_tile->max_height};
+                memcpy(mesh.vertices.data(), cached_tile->vertices.data(), cached_tile->vertices.size_bytes());
+
+                return mesh;
             }
-            heightmap[y][x] = raw_noise[y * size.x + x] * height_range + min_terrain_height;
+
+            return terraingen::build_terrain_node_mesh(cached_tile->apron_heights, grid_size, texel_size, skirt_depth, heightmap);
         }
     }
 
-    return heightmap;
+    logger->info("Generating tile (%d, %d) at level %u", node.coord.x, node.coord.y, node.level);
+
+    terraingen::HeightGradients gradients;
+    const auto generated_apron_heights = terraingen::fill_heights_with_apron(noise_config,
+                                                                             node.get_top_left(TILE_SIZE),
+                                                                             node.get_texel_size(),
+                                                                             grid_size,
+                                                                             static_cast<Float32>(min_terrain_height),
+                                                                             static_cast<Float32>(max_terrain_height),
+                                                                             &gradients);
+    auto mesh = terraingen::build_terrain_node_mesh(generated_apron_heights, grid_size, texel_size, skirt_depth, heightmap, &gradients);
+
+    if(tile_cache) {
+        tile_cache->store(node, generated_apron_heights, mesh, skirt_depth);
+    }
+
+    if(apron_heights != nullptr) {
+        copy_to_vector(generated_apron_heights, *apron_heights);
+    }
+
+    return mesh;
 }
 
 void Terrain::upload_new_tile_meshes() {
     ZoneScoped;
     PIXScopedEvent(PIX_COLOR_DEFAULT, "Upload new terrain tile meshes");
 
-    auto locked_tile_mesh_queue = tile_mesh_create_infos.lock();
-    if(locked_tile_mesh_queue->is_empty()) {
-        return;
+    {
+        // Swap the queues so that generation tasks can keep adding meshes while we upload these ones
+        auto locked_tile_mesh_queue = tile_mesh_create_infos.lock();
+        if(locked_tile_mesh_queue->is_empty()) {
+            return;
+        }
+
+        auto new_tile_meshes = Rx::Utility::move(*locked_tile_mesh_queue);
+        *locked_tile_mesh_queue = Rx::Utility::move(tile_meshes_to_upload);
+        tile_meshes_to_upload = Rx::Utility::move(new_tile_meshes);
     }
 
     auto& device = renderer->get_render_device();
@@ -400,79 +889,125 @@ void Terrain::upload_new_tile_meshes() {
         TracyD3D12Zone(renderer::RenderDevice::tracy_context, commands.get(), "Terrain::upload_new_tile_meshes");
         PIXScopedEvent(commands.get(), PIX_COLOR_DEFAULT, "Terrain::upload_new_tile_meshes");
 
-        Rx::Vector<renderer::VisibleObjectCullingInformation> tile_culling_information{locked_tile_mesh_queue->size()};
+        Rx::Vector<renderer::VisibleObjectCullingInformation> tile_culling_information{tile_meshes_to_upload.size()};
+
+        auto* terrain_mesh_store = renderer->get_terrain_mesh_store();
+
+        tile_meshes_to_upload.each_fwd([&](const TerrainTileMeshCreateInfo& create_info) {
+            const auto& node = create_info.node;
+            const auto& mesh = create_info.mesh;
 
-        locked_tile_mesh_queue->each_fwd([&](const TerrainTileMeshCreateInfo& create_info) {
             PIXScopedEvent(commands.get(),
                            PIX_COLOR_DEFAULT,
-                           "Terrain::upload_new_tile_meshes(%d, %d)",
-                           create_info.tilecoord.x,
-                           create_info.tilecoord.y);
+                           "Terrain::upload_new_tile_meshes(%d, %d, %u)",
+                           node.coord.x,
+                           node.coord.y,
+                           node.level);
+
+            const auto top_left = node.get_top_left(TILE_SIZE);
+            const auto node_size = static_cast<Float32>(node.get_size(TILE_SIZE));
+            const auto texel_size = static_cast<Float32>(node.get_texel_size());
+            const auto height_range = mesh.max_height - mesh.min_height;
+
+            terrain_mesh_store->begin_adding_tiles(commands.get());
+            const auto tile_mesh = terrain_mesh_store->add_tile(mesh.vertices, commands.get());
+            terrain_mesh_store->end_adding_tiles(commands.get());
+
+            if(!tile_mesh) {
+                logger->error("No room for tile (%d, %d) at level %u in the terrain mesh store, dropping it",
+                              node.coord.x,
+                              node.coord.y,
+                              node.level);
+
+                {
+                    Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+                    const auto* tile = loaded_terrain_tiles.find(node);
+                    heightmap_pool.free(tile->heightmap);
+                    loaded_terrain_tiles.erase(node);
+                }
 
-            auto& meshes = renderer->get_static_mesh_store();
+                registry->lock()->destroy(create_info.entity);
+                num_active_tilegen_tasks.fetch_sub(1);
+                return;
+            }
 
-            meshes.begin_adding_meshes(commands.get());
+            // Coarser tiles would overlap the level 0 tiles in the raytracing scene, so only level 0 tiles are raytraced
+            auto ray_geo = renderer::RaytracableGeometryHandle{};
+            if(node.level == 0) {
+                ray_geo = create_tile_raytracing_geometry(create_info, top_left, commands.get());
+                renderer->add_raytracing_objects_to_scene(
+                    Rx::Array{renderer::RaytracingObject{.geometry_handle = ray_geo, .material = {0}}});
+            }
 
-            const auto tile_mesh_ld = meshes.add_mesh(create_info.vertices, create_info.indices, commands.get());
-            const auto& vertex_buffer = *meshes.get_vertex_bindings()[0].buffer;
+            {
+                // The vertices are a grid with one vertex per texel and normalized heights, so scale them into the tile's size and
+                // height range. New tiles start hidden, `update_visible_tiles` shows them once they're ready to replace what's on screen
+                const auto tile_transform = TransformComponent{
+                    .location = {static_cast<Float32>(top_left.x), mesh.min_height, static_cast<Float32>(top_left.y)},
+                    .scale = {texel_size, height_range, texel_size}};
 
-            float max_y = 0;
-            float min_y = 256;
+                auto locked_registry = registry->lock();
+                locked_registry->emplace<renderer::TerrainTileRenderableComponent>(create_info.entity,
+                                                                                    *tile_mesh,
+                                                                                    0u,
+                                                                                    terrain_material,
+                                                                                    false);
+                locked_registry->emplace<TransformComponent>(create_info.entity, tile_transform);
+            }
 
-            create_info.vertices.each_fwd([&](const StandardVertex& vertex) {
-                if(vertex.position.y < min_y) {
-                    min_y = vertex.position.y;
+            {
+                logger->verbose("Marking tile (%d, %d) at level %u as completely loaded", node.coord.x, node.coord.y, node.level);
+                Rx::Log::flush();
+                Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
+                auto* tile = loaded_terrain_tiles.find(node);
+                tile->loading_phase = TerrainTile::LoadingPhase::Complete;
+                tile->mesh = *tile_mesh;
+                if(tile->heightmap.is_valid()) {
+                    is_height_snapshot_stale = true;
                 }
 
-                if(vertex.position.y > max_y) {
-                    max_y = vertex.position.y;
+                if(node.level == 0 && tile->heightmap.is_valid()) {
+                    const auto initial_water_depths = get_initial_water_depths(node.coord);
+                    water_simulation->add_tile(node.coord,
+                                               tile->heightmap.get_heights(),
+                                               tile->heightmap.size,
+                                               {initial_water_depths.data(), initial_water_depths.size()});
+                    object_placer->add_tile(node.coord, tile->heightmap.get_heights(), tile->heightmap.size);
+
+                    const auto heights = tile->heightmap.get_heights();
+                    auto loaded_tile = TerrainTileHeights{.coord = node.coord, .heights = Rx::Vector<Float32>{heights.size()}};
+                    memcpy(loaded_tile.heights.data(), heights.data(), heights.size_bytes());
+                    newly_loaded_tiles.push_back(Rx::Utility::move(loaded_tile));
                 }
-            });
-
-            const Rx::Vector<D3D12_RESOURCE_BARRIER>
-                barriers = Rx::Array{CD3DX12_RESOURCE_BARRIER::Transition(vertex_buffer.resource.get(),
-                                                                          D3D12_RESOURCE_STATE_COPY_DEST,
-                                                                          D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-                                     CD3DX12_RESOURCE_BARRIER::Transition(meshes.get_index_buffer().resource.get(),
-                                                                          D3D12_RESOURCE_STATE_COPY_DEST,
-                                                                          D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)};
-            commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
 
-            const auto ray_geo = renderer->create_raytracing_geometry(vertex_buffer,
-                                                                      meshes.get_index_buffer(),
-                                                                      Rx::Array{tile_mesh_ld},
-                                                                      commands.get());
-            const auto tile_mesh = tile_mesh_ld;
+                tile->raytracing_geometry = ray_geo;
 
-            renderer->add_raytracing_objects_to_scene(Rx::Array{renderer::RaytracingObject{.geometry_handle = ray_geo, .material = {0}}});
+                const auto heightmap_size = tile->heightmap.is_valid() ?
+                                                heightmap_pool.get_block_size() * heightmap_pool.get_block_size() * sizeof(Float32) :
+                                                0;
+                tile->memory_usage = heightmap_size + mesh.vertices.size() * sizeof(TerrainVertex);
 
-            {
-                auto locked_registry = registry->lock();
-                locked_registry->emplace<renderer::StandardRenderableComponent>(create_info.entity, tile_mesh, terrain_material);
-                locked_registry->emplace<TransformComponent>(create_info.entity,
-                                                            glm::vec3{create_info.tilecoord.x, 0.0f, create_info.tilecoord.y});
+                loaded_tiles_memory_usage += tile->memory_usage;
             }
 
-            {
-                logger->verbose("Marking tile (%d, %d) as completely loaded", create_info.tilecoord.x, create_info.tilecoord.y);
-                Rx::Log::flush();
-                Rx::Concurrency::ScopeLock l{loaded_terrain_tiles_mutex};
-                loaded_terrain_tiles.find(create_info.tilecoord)->loading_phase = TerrainTile::LoadingPhase::Complete;
+            const auto& apron_heights = create_info.apron_heights_to_save;
+            if(!apron_heights.is_empty()) {
+                save->save_tile(node.coord, {apron_heights.data(), apron_heights.size()});
             }
 
-            const auto cull_info = renderer::VisibleObjectCullingInformation{.aabb_x_min_max = {static_cast<float>(create_info.tilecoord.x),
-                                                                                                static_cast<float>(create_info.tilecoord.x +
-                                                                                                                   TILE_SIZE)},
-                                                                             .aabb_y_min_max = {min_y, max_y},
-                                                                             .aabb_z_min_max = {static_cast<float>(create_info.tilecoord.y),
-                                                                                                static_cast<float>(create_info.tilecoord.y +
-                                                                                                                   TILE_SIZE)},
-                                                                             .vertex_count = tile_mesh_ld.num_vertices,
-                                                                             .start_vertex_location = tile_mesh_ld.first_vertex};
+            num_active_tilegen_tasks.fetch_sub(1);
+
+            const auto cull_info = renderer::VisibleObjectCullingInformation{
+                .aabb_x_min_max = {static_cast<float>(top_left.x), static_cast<float>(top_left.x) + node_size},
+                .aabb_y_min_max = {mesh.min_height, mesh.max_height},
+                .aabb_z_min_max = {static_cast<float>(top_left.y), static_cast<float>(top_left.y) + node_size},
+                .vertex_count = static_cast<Uint32>(mesh.vertices.size()),
+                .start_vertex_location = tile_mesh->first_vertex};
             tile_culling_information.push_back(cull_info);
         });
 
-        locked_tile_mesh_queue->clear();
+        // Keep the vector's memory around so the next swap doesn't have to allocate
+        tile_meshes_to_upload.clear();
     }
     {
         TracyD3D12Zone(renderer::RenderDevice::tracy_context, commands.get(), "Terrain::upload_new_tile_meshes::upload_visible_objects");
@@ -484,16 +1019,79 @@ void Terrain::upload_new_tile_meshes() {
     device.submit_command_list(Rx::Utility::move(commands));
 }
 
-Vec3f Terrain::get_normal_at_location(const Vec2f& location) {
-    const auto height_middle_right = get_terrain_height(location + Vec2f{1, 0});
-    const auto height_bottom_middle = get_terrain_height(location + Vec2f{0, -1});
-    const auto height_top_middle = get_terrain_height(location + Vec2f{0, 1});
-    const auto height_middle_left = get_terrain_height(location + Vec2f{-1, 0});
+Rx::Vector<Float32> Terrain::get_initial_water_depths(const Vec2i& tile_coord) const {
+    return terraingen::get_tile_water_depths(fallback_heightmap, tile_coord, TILE_SIZE);
+}
+
+renderer::RaytracableGeometryHandle Terrain::create_tile_raytracing_geometry(const TerrainTileMeshCreateInfo& create_info,
+                                                                            const Vec2i& top_left,
+                                                                            ID3D12GraphicsCommandList4* commands) {
+    ZoneScoped;
+
+    auto& device = renderer->get_render_device();
+    const auto* terrain_mesh_store = renderer->get_terrain_mesh_store();
+
+    // The acceleration structure builder can't read the compact vertices, so expand them to world-space positions in a staging buffer.
+    // The staging buffer only needs to live until the build runs, the index buffer is the one that the terrain mesh store shares
+    const auto& mesh = create_info.mesh;
+    const auto num_vertices = static_cast<Uint32>(mesh.vertices.size());
+    auto positions_buffer = device.get_staging_buffer(num_vertices * static_cast<Uint32>(sizeof(Vec3f)));
+    auto* positions = static_cast<Vec3f*>(positions_buffer.mapped_ptr);
+
+    const auto grid_size = TILE_SIZE + 1;
+    const auto num_grid_vertices = grid_size * grid_size;
+    const auto height_range = mesh.max_height - mesh.min_height;
+    for(Uint32 i = 0; i < num_vertices; i++) {
+        const auto grid_position = i < num_grid_vertices ? Vec2u{i % grid_size, i / grid_size} :
+                                                           get_terrain_skirt_grid_position(i - num_grid_vertices, grid_size);
+        const auto normalized_height = static_cast<Float32>(mesh.vertices[i].height) / static_cast<Float32>(UINT16_MAX);
+        positions[i] = Vec3f{static_cast<Float32>(top_left.x + static_cast<Int32>(grid_position.x)),
+                             mesh.min_height + normalized_height * height_range,
+                             static_cast<Float32>(top_left.y + static_cast<Int32>(grid_position.y))};
+    }
+
+    const auto& lod = terrain_mesh_store->get_lod(0);
+    const auto geom_desc = D3D12_RAYTRACING_GEOMETRY_DESC{
+        .Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
+        .Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE,
+        .Triangles = {.Transform3x4 = 0,
+                      .IndexFormat = DXGI_FORMAT_R16_UINT,
+                      .VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT,
+                      .IndexCount = lod.num_indices,
+                      .VertexCount = num_vertices,
+                      .IndexBuffer = terrain_mesh_store->get_index_buffer().resource->GetGPUVirtualAddress() +
+                                     lod.first_index * sizeof(Uint16),
+                      .VertexBuffer = {.StartAddress = positions_buffer.resource->GetGPUVirtualAddress(), .StrideInBytes = sizeof(Vec3f)}}};
+
+    const auto ray_geo = renderer->create_raytracing_geometry(Rx::Array{geom_desc}, commands);
+
+    device.return_staging_buffer(Rx::Utility::move(positions_buffer));
+
+    return ray_geo;
+}
+
+Vec3f Terrain::get_normal_at_location(const Vec2f& location) const {
+    TerrainSample sample;
+    sample_terrain({&location, 1}, {&sample, 1});
+    return sample.normal;
+}
 
-    const auto va = normalize(Vec3f{2.0, 0.0, height_middle_right - height_middle_left});
-    const auto vb = normalize(Vec3f{0.0, 2.0, height_bottom_middle - height_top_middle});
-    const auto normal = normalize(cross(va, vb));
-    return {normal.x, normal.z, -normal.y};
+Float32 Terrain::get_water_depth(const Vec2f& location) const {
+    TerrainSample sample;
+    sample_terrain({&location, 1}, {&sample, 1});
+    return sample.water_depth;
 }
 
+environment::EnvironmentObjectPlacer& Terrain::get_object_placer() const { return *object_placer; }
+
 Rx::Concurrency::Atomic<Uint32>& Terrain::get_num_active_tilegen_tasks() { return num_active_tilegen_tasks; }
+
+void Terrain::collect_level_0_tile_changes(Rx::Vector<TerrainTileHeights>& loaded_tiles, Rx::Vector<Vec2i>& evicted_tiles) {
+    loaded_tiles = Rx::Utility::move(newly_loaded_tiles);
+    newly_loaded_tiles.clear();
+
+    evicted_tiles = Rx::Utility::move(newly_evicted_tiles);
+    newly_evicted_tiles.clear();
+}
+
+renderer::StandardMaterialHandle Terrain::get_material() const { return terrain_material; }
@@ -1,11 +1,25 @@
 #pragma once
 
+#include <span>
+
+#include "core/async/epoch_reclaimer.hpp"
 #include "core/async/synchronized_resource.hpp"
 #include "noise/FastNoiseSIMD/FastNoiseSIMD.h"
 #include "renderer/renderer.hpp"
 #include "rx/core/concurrency/mutex.h"
 #include "rx/core/map.h"
+#include "rx/core/ptr.h"
 #include "rx/core/vector.h"
+#include "world/environment/environment_object_placer.hpp"
+#include "world/generation/terrain_node_mesh.hpp"
+#include "world/generation/terrain_noise.hpp"
+#include "world/heightmap_tile_pool.hpp"
+#include "world/terrain_height_queries.hpp"
+#include "world/terrain_lod.hpp"
+#include "world/terrain_streaming.hpp"
+#include "world/terrain_tile_cache.hpp"
+#include "world/terrain_water.hpp"
+#include "world/world_save.hpp"
 
 struct WorldParameters;
 
@@ -28,21 +42,74 @@ struct TerrainTile {
 
     LoadingPhase loading_phase{LoadingPhase::GeneratingHeightmap};
 
-    Rx::Vector<Rx::Vector<Float32>> heightmap{};
+    /*!
+     * \brief Identifies the generation task that's loading this tile
+     *
+     * If the player walks away from a tile before its task starts, the tile gets dropped and might be requested again later. The old task
+     * uses this ID to notice that it's stale
+     */
+    Uint64 request_id{0};
+
+    /*!
+     * \brief This tile's heights, including the first row and column of the next tiles over. The memory is owned by the Terrain's
+     * heightmap pool. Only level 0 tiles have a heightmap, coarser tiles only need their mesh
+     */
+    TileHeightmap heightmap{};
 
-    Vec2i coord{};
+    /*!
+     * \brief The quadtree node that this tile covers
+     */
+    TerrainNodeKey node{};
 
     entt::entity entity{};
+
+    /*!
+     * \brief Where this tile's mesh lives in the terrain mesh store. Only valid once the tile is Complete
+     */
+    renderer::TerrainTileMesh mesh{};
+
+    /*!
+     * \brief Only level 0 tiles are raytraced, so that tiles at different levels of detail don't overlap in the raytracing scene
+     */
+    renderer::RaytracableGeometryHandle raytracing_geometry{};
+
+    /*!
+     * \brief Number of bytes this tile uses in the heightmap pool and the terrain mesh store. Only valid once the tile is Complete
+     */
+    Size memory_usage{0};
+
+    /*!
+     * \brief The last frame that this tile was selected or visible. Used to find the least recently used tiles to evict
+     */
+    Uint64 last_used_frame{0};
+};
+
+/*!
+ * \brief Heights of a level 0 tile that finished loading
+ */
+struct TerrainTileHeights {
+    Vec2i coord;
+
+    /*!
+     * \brief The tile's heights, laid out like its heightmap: `Terrain::TILE_SIZE + 1` rows of `Terrain::TILE_SIZE + 1` heights
+     */
+    Rx::Vector<Float32> heights;
 };
 
 struct TerrainTileMeshCreateInfo {
-    Vec2i tilecoord;
+    TerrainNodeKey node;
+
+    Uint64 request_id;
 
     entt::entity entity;
 
-    Rx::Vector<StandardVertex> vertices;
+    terraingen::TerrainNodeMesh mesh;
 
-    Rx::Vector<Uint32> indices;
+    /*!
+     * \brief Heights to save the tile with once it's loaded, including the apron. Empty for tiles that came from the world save, and for
+     * tiles that aren't level 0
+     */
+    Rx::Vector<Float32> apron_heights_to_save;
 };
 
 class Terrain;
@@ -58,6 +125,61 @@ struct TerrainData {
 
     Rx::Vector<Float32> heightmap;
 
+    /*!
+     * \brief Number of heightmap texels whose water flows through each texel, including the texel itself
+     */
+    Rx::Vector<Uint32> flow_accumulation;
+
+    /*!
+     * \brief 1 for heightmap texels that a river flows through, 0 for everything else
+     */
+    Rx::Vector<Uint8> river_mask;
+
+    /*!
+     * \brief 1 for heightmap texels that are covered by a lake, 0 for everything else
+     */
+    Rx::Vector<Uint8> lake_mask;
+
+    /*!
+     * \brief Depth of the water on each heightmap texel when the world was generated. The water simulation starts from these depths
+     */
+    Rx::Vector<Float32> water_depths;
+
+    /*!
+     * \brief Wind on each heightmap texel, in kmph. See `terraingen::ClimateMaps::wind` for the axes
+     */
+    Rx::Vector<Vec2f> wind_map;
+
+    /*!
+     * \brief Humidity of the air above each heightmap texel, from 0 to 1
+     */
+    Rx::Vector<Float32> humidity_map;
+
+    /*!
+     * \brief How wet the ground on each heightmap texel is, from 0 to 1
+     */
+    Rx::Vector<Float32> soil_moisture;
+
+    /*!
+     * \brief Mean air temperature on each heightmap texel, in degrees celsius
+     */
+    Rx::Vector<Float32> temperature_map;
+
+    /*!
+     * \brief Ecotype of each heightmap texel, from the heightmap and the climate
+     */
+    environment::EcotypeMap ecotype_map;
+
+    /*!
+     * \brief Distance from each heightmap texel to the nearest ocean, river, or lake texel, in meters
+     */
+    Rx::Vector<Float32> water_distance;
+
+    /*!
+     * \brief How much groundwater there is under each heightmap texel, from 0 to 1. Comes from the distance to water and the humidity
+     */
+    Rx::Vector<Float32> groundwater;
+
     /*!
      * \brief Handle to a texture that has the raw height values for the terrain
      */
@@ -90,6 +212,11 @@ struct TerrainData {
      * \brief Handle to a texture that stores the soil moisture percentage
      */
     renderer::TextureHandle soil_moisture_handle;
+
+    /*!
+     * \brief Handle to a texture that stores the mean air temperature in degrees celsius
+     */
+    renderer::TextureHandle temperature_map_handle;
 };
 
 /*!
@@ -97,48 +224,236 @@ struct TerrainData {
  *
  * The terrain has a resolution of one meter. This terrain class is made for a game that uses voxels with a resolution of one meter, so
  * everything should be groovy
+ *
+ * Level 0 tiles are loaded from the world save if they're in it, and saved to it after they're generated. A tile's heights never change
+ * once it's generated, so evicting a tile doesn't need to save it again
  */
 class Terrain {
 public:
     // TODO: Make this configurable
     static constexpr Uint32 TILE_SIZE = 64;
 
-    [[nodiscard]] static TerrainData generate_terrain(FastNoiseSIMD& noise_generator,
-                                                      const WorldParameters& params,
-                                                      renderer::Renderer& renderer);
+    [[nodiscard]] static TerrainData generate_terrain(const WorldParameters& params, renderer::Renderer& renderer);
 
     [[nodiscard]] static Vec2i get_coords_of_tile_containing_position(const Vec3f& position);
 
     explicit Terrain(const TerrainData& data,
                      renderer::Renderer& renderer_in,
-                     FastNoiseSIMD& noise_generator_in,
-                     SynchronizedResource<entt::registry>& registry_in);
+                     const terraingen::NoiseConfig& noise_config_in,
+                     SynchronizedResource<entt::registry>& registry_in,
+                     WorldSave& save_in);
+
+    Terrain(const Terrain& other) = delete;
+    Terrain& operator=(const Terrain& other) = delete;
+
+    Terrain(Terrain&& old) noexcept = delete;
+    Terrain& operator=(Terrain&& old) noexcept = delete;
+
+    ~Terrain();
 
     void tick(float delta_time);
 
-    void load_terrain_around_player(const TransformComponent& player_transform);
+    /*!
+     * \brief Selects the quadtree nodes around the player, requests the ones that aren't loaded yet, and evicts old tiles if the terrain
+     * is over its memory budget
+     */
+    void load_terrain_around_player(const TransformComponent& player_transform, Float32 delta_time);
+
+    /*!
+     * \brief Samples the terrain's height and normal at a batch of locations
+     *
+     * Heights are bilinearly filtered from the loaded tiles. Locations whose tile isn't loaded fall back to the heightmap that was
+     * generated with the world, and each sample says where its height came from
+     *
+     * This doesn't take any locks, so it's safe to call from any number of threads at once, even while tiles are loading and evicting
+     *
+     * \param locations World x and z coordinates to sample at
+     * \param samples Where to write the samples. Must be at least as big as `locations`
+     */
+    void sample_terrain(std::span<const Vec2f> locations, std::span<TerrainSample> samples) const;
+
+    /*!
+     * \brief Samples the terrain's height at one location. Returns 0 if nothing covers the location
+     *
+     * Prefer `sample_terrain` when you have more than one location
+     */
+    [[nodiscard]] Float32 get_terrain_height(const Vec2f& location) const;
 
-    [[nodiscard]] Float32 get_terrain_height(const Vec2f& location);
+    /*!
+     * \brief Samples the terrain's normal at one location. Points straight up if nothing covers the location
+     */
+    [[nodiscard]] Vec3f get_normal_at_location(const Vec2f& location) const;
 
-    [[nodiscard]] Vec3f get_normal_at_location(const Vec2f& location);
+    /*!
+     * \brief Gets the depth of the water on top of the terrain at one location. Returns 0 if there's no water or nothing covers the
+     * location
+     *
+     * Water depths come from the same snapshot as the heights, so they lag the water simulation by up to a frame
+     */
+    [[nodiscard]] Float32 get_water_depth(const Vec2f& location) const;
+
+    /*!
+     * \brief Places environment objects on the level 0 tiles as they stream in
+     */
+    [[nodiscard]] environment::EnvironmentObjectPlacer& get_object_placer() const;
 
     [[nodiscard]] Rx::Concurrency::Atomic<Uint32>& get_num_active_tilegen_tasks();
 
+    /*!
+     * \brief Hands over the level 0 tiles that finished loading and the ones that were evicted since the last call
+     *
+     * Loaded tiles come with a copy of their heights, so they stay valid after the tile is evicted. Must be called every frame, or the
+     * tiles pile up
+     */
+    void collect_level_0_tile_changes(Rx::Vector<TerrainTileHeights>& loaded_tiles, Rx::Vector<Vec2i>& evicted_tiles);
+
+    [[nodiscard]] renderer::StandardMaterialHandle get_material() const;
+
+    /*!
+     * \brief Number of bytes that the Complete tiles use in the heightmap pool and the terrain mesh store
+     */
+    [[nodiscard]] Size get_loaded_tiles_memory_usage() const;
+
 private:
+    /*!
+     * \brief A tile mesh that was evicted, but which the GPU might still be rendering
+     */
+    struct PendingMeshFree {
+        renderer::TerrainTileMesh mesh;
+
+        Uint32 frames_until_free;
+    };
+
     renderer::Renderer* renderer;
 
-    Rx::Concurrency::Mutex noise_generator_mutex;
-    FastNoiseSIMD* noise_generator;
+    /*!
+     * \brief Settings for the noise that generates the terrain. Every tile generation task builds its own noise generator from these, so
+     * tiles can generate in parallel
+     */
+    terraingen::NoiseConfig noise_config;
 
     SynchronizedResource<entt::registry>* registry;
 
+    /*!
+     * \brief Where level 0 tiles are loaded from and saved to. Only used on the main thread
+     */
+    WorldSave* save;
+
+    /*!
+     * \brief Number of tiles that have been requested but whose meshes haven't been uploaded yet
+     *
+     * This counts tiles until `upload_new_tile_meshes` is done with them, which keeps `tile_mesh_create_infos` from growing past
+     * `t.MaxGeneratingTiles` entries
+     */
     Rx::Concurrency::Atomic<Uint32> num_active_tilegen_tasks;
 
-    Rx::Concurrency::Mutex loaded_terrain_tiles_mutex;
-    Rx::Map<Vec2i, TerrainTile> loaded_terrain_tiles;
+    /*!
+     * \brief Allocates tile heightmaps. Blocks have room for one more row and column than a tile has texels, so that bilinear filtering
+     * can stay inside a single tile
+     */
+    HeightmapTilePool heightmap_pool{TILE_SIZE + 1};
+
+    /*!
+     * \brief Heights for locations whose tile isn't loaded, copied from the heightmap that was generated with the world
+     */
+    TerrainFallbackHeightmap fallback_heightmap;
+
+    /*!
+     * \brief Protects the height snapshots from being freed while another thread is sampling them
+     */
+    EpochReclaimer height_snapshot_reclaimer;
+
+    /*!
+     * \brief The snapshot that `sample_terrain` reads. Owned by `current_height_snapshot`
+     */
+    Rx::Concurrency::Atomic<const TerrainHeightSnapshot*> published_height_snapshot{nullptr};
+
+    Rx::Ptr<TerrainHeightSnapshot> current_height_snapshot;
+
+    /*!
+     * \brief The previous snapshot, which readers may still be using
+     */
+    Rx::Ptr<TerrainHeightSnapshot> retired_height_snapshot;
+
+    /*!
+     * \brief Heightmaps that the retired snapshot may refer to. They go back to the heightmap pool along with the retired snapshot
+     */
+    Rx::Vector<TileHeightmap> retired_heightmaps;
+
+    /*!
+     * \brief Heightmaps of tiles that were evicted since the current snapshot was published. The current snapshot still refers to them
+     */
+    Rx::Vector<TileHeightmap> evicted_heightmaps;
+
+    /*!
+     * \brief Whether level 0 tiles were loaded or evicted since the current snapshot was published
+     */
+    bool is_height_snapshot_stale{false};
+
+    /*!
+     * \brief Simulates the water on the loaded level 0 tiles. Its depths are published along with the height snapshots
+     */
+    Rx::Ptr<TerrainWaterSimulation> water_simulation;
+
+    Rx::Ptr<environment::EnvironmentObjectPlacer> object_placer;
+
+    /*!
+     * \brief On-disk cache of generated tiles. Null if `t.TerrainCacheEnabled` was off when the terrain was created
+     */
+    Rx::Ptr<TerrainTileCache> tile_cache;
+
+    mutable Rx::Concurrency::Mutex loaded_terrain_tiles_mutex;
+    Rx::Map<TerrainNodeKey, TerrainTile> loaded_terrain_tiles;
+
+    /*!
+     * \brief Sum of the memory usage of all Complete tiles. Guarded by `loaded_terrain_tiles_mutex`
+     */
+    Size loaded_tiles_memory_usage{0};
+
+    Uint64 next_tile_request_id{1};
+
+    /*!
+     * \brief Heights of the level 0 tiles that were requested and are in the world save, by request ID. Each generation task takes its
+     * tile's heights out of here, so it doesn't have to generate them. Guarded by `loaded_terrain_tiles_mutex`
+     */
+    Rx::Map<Uint64, Rx::Vector<Float32>> saved_tile_heights;
+
+    Uint64 frame_count{0};
+
+    Vec2f last_player_location{};
+
+    /*!
+     * \brief Quadtree nodes that were selected this frame. Kept around so we don't allocate a new vector every frame
+     */
+    Rx::Vector<TerrainNodeRequest> tile_requests;
+
+    /*!
+     * \brief Tiles that are being drawn. Guarded by `loaded_terrain_tiles_mutex`
+     */
+    Rx::Vector<TerrainNodeKey> visible_tiles;
 
+    /*!
+     * \brief Meshes that generation tasks have finished, waiting to be uploaded on the main thread
+     *
+     * `upload_new_tile_meshes` swaps this with `tile_meshes_to_upload` so that it only holds the lock for the swap, and generation tasks
+     * can keep adding meshes while it uploads
+     */
     SynchronizedResource<Rx::Vector<TerrainTileMeshCreateInfo>> tile_mesh_create_infos;
 
+    Rx::Vector<TerrainTileMeshCreateInfo> tile_meshes_to_upload;
+
+    Rx::Vector<PendingMeshFree> pending_mesh_frees;
+
+    /*!
+     * \brief Level 0 tiles that finished loading since the last `collect_level_0_tile_changes`
+     */
+    Rx::Vector<TerrainTileHeights> newly_loaded_tiles;
+
+    /*!
+     * \brief Level 0 tiles that were evicted since the last `collect_level_0_tile_changes`
+     */
+    Rx::Vector<Vec2i> newly_evicted_tiles;
+
     renderer::StandardMaterialHandle terrain_material{1};
 
     Uint32 max_latitude{};
@@ -149,32 +464,114 @@ private:
 
     Uint32 max_terrain_height;
 
-    static void generate_heightmap(FastNoiseSIMD& noise_generator,
-                                   const WorldParameters& params,
+    static void generate_heightmap(const WorldParameters& params,
                                    renderer::Renderer& renderer,
                                    const com_ptr<ID3D12GraphicsCommandList4>& commands,
-                                   TerrainData& data,
-                                   unsigned total_pixels_in_maps);
+                                   TerrainData& data);
 
     static void place_water_sources(const WorldParameters& params,
                                     renderer::Renderer& renderer,
                                     const com_ptr<ID3D12GraphicsCommandList4>& commands,
-                                    TerrainData& data,
-                                    unsigned total_pixels_in_maps);
+                                    TerrainData& data);
 
     static void compute_water_flow(renderer::Renderer& renderer, const com_ptr<ID3D12GraphicsCommandList4>& commands, TerrainData& data);
 
     void load_terrain_textures_and_create_material();
 
-    void generate_tile(const Vec2i& tilecoord);
+    [[nodiscard]] TileStreamingView get_streaming_view(const TransformComponent& player_transform, Float32 delta_time);
+
+    [[nodiscard]] TerrainLodSettings get_lod_settings() const;
+
+    /*!
+     * \brief Drops tiles that are still waiting for their generation task to start but are no longer selected
+     *
+     * Must be called with `loaded_terrain_tiles_mutex` held
+     */
+    void drop_stale_tile_requests();
+
+    /*!
+     * \brief Decides which tiles to draw this frame
+     *
+     * Selected tiles are drawn once they're loaded. Until then, the tiles that were drawn in their place last frame keep being drawn, so
+     * the terrain doesn't get holes while switching between levels of detail
+     *
+     * Must be called with `loaded_terrain_tiles_mutex` held
+     *
+     * \param shown_entities Entities of the tiles that became visible this frame
+     * \param hidden_entities Entities of the tiles that stopped being visible this frame
+     */
+    void update_visible_tiles(Rx::Vector<entt::entity>& shown_entities, Rx::Vector<entt::entity>& hidden_entities);
+
+    /*!
+     * \brief Evicts the least recently used tiles until the loaded tiles fit in the memory budget, and the terrain mesh store has room
+     * for every tile that might be generating
+     *
+     * Tiles that were used this frame are never evicted
+     */
+    void evict_tiles_over_budget();
+
+    /*!
+     * \brief Destroys an evicted tile's entity and raytracing geometry, and schedules its mesh to be freed once the GPU is done with it
+     */
+    void release_tile_render_resources(const TerrainTile& tile);
+
+    /*!
+     * \brief Returns evicted tile meshes to the terrain mesh store once no in-flight frame can be using them
+     */
+    void free_evicted_meshes();
+
+    /*!
+     * \brief Checks if the tile that a generation task is working on is still wanted
+     *
+     * Must be called with `loaded_terrain_tiles_mutex` held
+     */
+    [[nodiscard]] bool is_tile_request_current(const TerrainNodeKey& node, Uint64 request_id) const;
+
+    /*!
+     * \brief Generates a tile's heights and mesh, or meshes the heights from the world save, and queues the mesh to be uploaded on the
+     * main thread
+     *
+     * \param node The quadtree node to generate
+     * \param request_id ID of the request that this task is loading
+     * \param skirt_depth How far the tile's skirt hangs below its edges. Every tile must use the same depth, or the skirts might not
+     * cover the cracks between levels
+     */
+    void generate_tile(const TerrainNodeKey& node, Uint64 request_id, Float32 skirt_depth);
 
     /*!
-     * \brief Generates a terrain heightmap of a specific size
+     * \brief Gets a tile's mesh from the tile cache, or generates it and adds it to the cache if it's not there
      *
-     * \param top_left World x and y coordinates of the top left of this terrain heightmap
-     * \param size Size in world units of this terrain heightmap
+     * \param node The quadtree node to mesh
+     * \param skirt_depth How far the tile's skirt hangs below its edges
+     * \param heightmap If not nullptr, the tile's heights get copied into this heightmap
+     * \param apron_heights If not nullptr, the tile's heights and their apron get copied into this vector
      */
-    [[nodiscard]] Rx::Vector<Rx::Vector<Float32>> generate_terrain_heightmap(const Vec2i& top_left, const Vec2u& size);
+    [[nodiscard]] terraingen::TerrainNodeMesh load_or_generate_tile_mesh(const TerrainNodeKey& node,
+                                                                         Float32 skirt_depth,
+                                                                         TileHeightmap* heightmap,
+                                                                         Rx::Vector<Float32>* apron_heights);
 
     void upload_new_tile_meshes();
+
+    /*!
+     * \brief Gets the water depths that a level 0 tile starts with, from the water that was placed when the world was generated
+     *
+     * \return `TILE_SIZE * TILE_SIZE` depths, or an empty vector if the world's water doesn't cover the tile
+     */
+    [[nodiscard]] Rx::Vector<Float32> get_initial_water_depths(const Vec2i& tile_coord) const;
+
+    /*!
+     * \brief Publishes a new height snapshot if the loaded tiles or the water changed, and frees the previous snapshot once no readers
+     * are using it
+     *
+     * Only one snapshot may be retired at a time, so if readers are still using the previous one this waits until a later frame
+     */
+    void update_height_snapshot();
+
+    /*!
+     * \brief Builds the raytracing geometry for a level 0 tile, using the shared index buffer in the terrain mesh store
+     */
+    [[nodiscard]] renderer::RaytracableGeometryHandle create_tile_raytracing_geometry(const TerrainTileMeshCreateInfo& create_info,
+                                                                                      const Vec2i& top_left,
+                                                                                      ID3D12GraphicsCommandList4* commands);
 };
@@ -0,0 +1,278 @@
+#include "terrain_height_queries.hpp"
+
+#include <climits>
+#include <cmath>
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/clamp.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "rx/core/hash.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TERRAIN_HEIGHT_QUERIES_SSE2
+#include <emmintrin.h>
+#endif
+
+/*!
+ * \brief Number of samples that get resolved to texels before they're filtered. Small enough that the scratch arrays fit in L1
+ */
+constexpr Size TERRAIN_SAMPLE_BATCH_SIZE = 64;
+
+/*!
+ * \brief Heights for samples that nothing covers. Sampled with a row stride of 0, so every corner reads a 0
+ */
+static const Float32 NOT_LOADED_HEIGHTS[2] = {0, 0};
+
+static const Float32 NO_WATER_DEPTH = 0;
+
+/*!
+ * \brief A batch of samples that have been resolved to the four heights around them
+ *
+ * Sample i's corners are `corners[i][0]`, `corners[i][1]`, `corners[i][strides[i]]`, and `corners[i][strides[i] + 1]`
+ */
+struct ResolvedTerrainSamples {
+    const Float32* corners[TERRAIN_SAMPLE_BATCH_SIZE];
+
+    Uint32 strides[TERRAIN_SAMPLE_BATCH_SIZE];
+
+    alignas(16) Float32 fractions_x[TERRAIN_SAMPLE_BATCH_SIZE];
+
+    alignas(16) Float32 fractions_z[TERRAIN_SAMPLE_BATCH_SIZE];
+
+    /*!
+     * \brief Water depth of the cell that each sample is in. Water isn't filtered, since it doesn't flow smoothly between cells
+     */
+    const Float32* water_depths[TERRAIN_SAMPLE_BATCH_SIZE];
+
+    TerrainSampleSource sources[TERRAIN_SAMPLE_BATCH_SIZE];
+};
+
+static Size get_tile_table_index(const Vec2i& coord, const Size table_size) {
+    return Rx::Hash<Rx::Math::Vec2i>{}(coord) & (table_size - 1);
+}
+
+/*!
+ * \brief Splits a location within a grid into the texel that it's in and how far along that texel it is
+ *
+ * \param location Location within the grid, in texels
+ * \param last_texel The last texel that may be returned. Locations past it are measured from it, so the fraction may reach 1
+ */
+static void split_grid_location(const Float32 location, const Uint32 last_texel, Uint32& texel, Float32& fraction) {
+    const auto clamped_location = Rx::Algorithm::clamp(location, 0.0f, static_cast<Float32>(last_texel + 1));
+    texel = Rx::Algorithm::min(static_cast<Uint32>(clamped_location), last_texel);
+    fraction = clamped_location - static_cast<Float32>(texel);
+}
+
+static void filter_sample(const ResolvedTerrainSamples& resolved, const Size i, TerrainSample& sample) {
+    const auto* corners = resolved.corners[i];
+    const auto stride = resolved.strides[i];
+    const auto fraction_x = resolved.fractions_x[i];
+    const auto fraction_z = resolved.fractions_z[i];
+
+    const auto h00 = corners[0];
+    const auto h10 = corners[1];
+    const auto h01 = corners[stride];
+    const auto h11 = corners[stride + 1];
+
+    const auto top = h00 + (h10 - h00) * fraction_x;
+    const auto bottom = h01 + (h11 - h01) * fraction_x;
+
+    // Slopes of the bilinear surface. Heights are one meter apart, so these are already in meters per meter
+    const auto dx = (h10 - h00) + ((h11 - h01) - (h10 - h00)) * fraction_z;
+    const auto dz = bottom - top;
+    const auto inverse_length = 1.0f / std::sqrt(dx * dx + 1.0f + dz * dz);
+
+    sample.height = top + dz * fraction_z;
+    sample.normal = Vec3f{-dx * inverse_length, inverse_length, -dz * inverse_length};
+    sample.water_depth = *resolved.water_depths[i];
+    sample.source = resolved.sources[i];
+}
+
+#ifdef TERRAIN_HEIGHT_QUERIES_SSE2
+static void filter_four_samples(const ResolvedTerrainSamples& resolved, const Size first, TerrainSample* samples) {
+    const auto* c0 = resolved.corners[first];
+    const auto* c1 = resolved.corners[first + 1];
+    const auto* c2 = resolved.corners[first + 2];
+    const auto* c3 = resolved.corners[first + 3];
+
+    const auto s0 = resolved.strides[first];
+    const auto s1 = resolved.strides[first + 1];
+    const auto s2 = resolved.strides[first + 2];
+    const auto s3 = resolved.strides[first + 3];
+
+    // The corners are scattered across tiles, so gather them into lanes by hand
+    const auto h00 = _mm_setr_ps(c0[0], c1[0], c2[0], c3[0]);
+    const auto h10 = _mm_setr_ps(c0[1], c1[1], c2[1], c3[1]);
+    const auto h01 = _mm_setr_ps(c0[s0], c1[s1], c2[s2], c3[s3]);
+    const auto h11 = _mm_setr_ps(c0[s0 + 1], c1[s1 + 1], c2[s2 + 1], c3[s3 + 1]);
+
+    const auto fraction_x = _mm_load_ps(resolved.fractions_x + first);
+    const auto fraction_z = _mm_load_ps(resolved.fractions_z + first);
+
+    const auto top_slope = _mm_sub_ps(h10, h00);
+    const auto bottom_slope = _mm_sub_ps(h11, h01);
+    const auto top = _mm_add_ps(h00, _mm_mul_ps(top_slope, fraction_x));
+    const auto bottom = _mm_add_ps(h01, _mm_mul_ps(bottom_slope, fraction_x));
+
+    const auto dx = _mm_add_ps(top_slope, _mm_mul_ps(_mm_sub_ps(bottom_slope, top_slope), fraction_z));
+    const auto dz = _mm_sub_ps(bottom, top);
+
+    const auto one = _mm_set1_ps(1.0f);
+    const auto length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), one), _mm_mul_ps(dz, dz)));
+    const auto inverse_length = _mm_div_ps(one, length);
+
+    alignas(16) Float32 heights[4];
+    alignas(16) Float32 normals_x[4];
+    alignas(16) Float32 normals_y[4];
+    alignas(16) Float32 normals_z[4];
+
+    const auto sign_bit = _mm_set1_ps(-0.0f);
+    _mm_store_ps(heights, _mm_add_ps(top, _mm_mul_ps(dz, fraction_z)));
+    _mm_store_ps(normals_x, _mm_xor_ps(_mm_mul_ps(dx, inverse_length), sign_bit));
+    _mm_store_ps(normals_y, inverse_length);
+    _mm_store_ps(normals_z, _mm_xor_ps(_mm_mul_ps(dz, inverse_length), sign_bit));
+
+    for(Size lane = 0; lane < 4; lane++) {
+        samples[lane].height = heights[lane];
+        samples[lane].normal = Vec3f{normals_x[lane], normals_y[lane], normals_z[lane]};
+        samples[lane].water_depth = *resolved.water_depths[first + lane];
+        samples[lane].source = resolved.sources[first + lane];
+    }
+}
+#endif
+
+TerrainHeightSnapshot::TerrainHeightSnapshot(const Uint32 tile_size_in,
+                                             const Rx::Vector<Tile>& tiles,
+                                             const TerrainFallbackHeightmap* fallback_in)
+    : tile_size{tile_size_in}, fallback{fallback_in}, num_tiles{static_cast<Uint32>(tiles.size())} {
+    ZoneScoped;
+
+    // Keep the table at most half full so that probe sequences stay short
+    Size table_size = 16;
+    while(table_size < tiles.size() * 2) {
+        table_size *= 2;
+    }
+
+    tile_table.resize(table_size, Tile{});
+
+    tiles.each_fwd([&](const Tile& tile) {
+        auto index = get_tile_table_index(tile.coord, table_size);
+        while(tile_table[index].heights != nullptr) {
+            index = (index + 1) & (table_size - 1);
+        }
+
+        tile_table[index] = tile;
+    });
+}
+
+const Float32* TerrainHeightSnapshot::find_tile(const Vec2i& coord) const {
+    const auto* tile = find_tile_entry(coord);
+    return tile != nullptr ? tile->heights : nullptr;
+}
+
+void TerrainHeightSnapshot::sample(const std::span<const Vec2f> locations, const std::span<TerrainSample> samples) const {
+    ZoneScoped;
+
+    RX_ASSERT(samples.size() >= locations.size(), "Need room for %zu samples, but only have %zu", locations.size(), samples.size());
+
+    const auto tile_size_float = static_cast<Float32>(tile_size);
+    const auto tile_stride = tile_size + 1;
+    const auto has_fallback = fallback != nullptr && fallback->width >= 2 && fallback->depth >= 2;
+    const auto has_fallback_water = has_fallback && fallback->water_depths.size() == fallback->heights.size();
+
+    // Locations from a single caller tend to be close together, so remember the last tile we looked up
+    auto last_tile_coord = Vec2i{INT_MAX, INT_MAX};
+    const Tile* last_tile = nullptr;
+
+    ResolvedTerrainSamples resolved;
+
+    for(Size batch_start = 0; batch_start < locations.size(); batch_start += TERRAIN_SAMPLE_BATCH_SIZE) {
+        const auto batch_size = Rx::Algorithm::min(TERRAIN_SAMPLE_BATCH_SIZE, locations.size() - batch_start);
+
+        for(Size i = 0; i < batch_size; i++) {
+            const auto& location = locations[batch_start + i];
+
+            const auto tile_coord = Vec2i{static_cast<Int32>(std::floor(location.x / tile_size_float)),
+                                          static_cast<Int32>(std::floor(location.y / tile_size_float))};
+            if(tile_coord != last_tile_coord) {
+                last_tile_coord = tile_coord;
+                last_tile = find_tile_entry(tile_coord);
+            }
+
+            Uint32 texel_x;
+            Uint32 texel_z;
+            if(last_tile != nullptr) {
+                split_grid_location(location.x - static_cast<Float32>(tile_coord.x) * tile_size_float,
+                                    tile_size - 1,
+                                    texel_x,
+                                    resolved.fractions_x[i]);
+                split_grid_location(location.y - static_cast<Float32>(tile_coord.y) * tile_size_float,
+                                    tile_size - 1,
+                                    texel_z,
+                                    resolved.fractions_z[i]);
+
+                resolved.corners[i] = last_tile->heights + texel_z * tile_stride + texel_x;
+                resolved.strides[i] = tile_stride;
+                resolved.water_depths[i] = last_tile->water_depths != nullptr ? last_tile->water_depths + texel_z * tile_size + texel_x
+                                                                              : &NO_WATER_DEPTH;
+                resolved.sources[i] = TerrainSampleSource::Tile;
+                continue;
+            }
+
+            if(has_fallback) {
+                const auto fallback_location = location - fallback->origin;
+                const auto is_in_fallback = fallback_location.x >= 0 && fallback_location.y >= 0 &&
+                                            fallback_location.x <= static_cast<Float32>(fallback->width - 1) &&
+                                            fallback_location.y <= static_cast<Float32>(fallback->depth - 1);
+                if(is_in_fallback) {
+                    split_grid_location(fallback_location.x, fallback->width - 2, texel_x, resolved.fractions_x[i]);
+                    split_grid_location(fallback_location.y, fallback->depth - 2, texel_z, resolved.fractions_z[i]);
+
+                    const auto texel_index = static_cast<Size>(texel_z) * fallback->width + texel_x;
+                    resolved.corners[i] = fallback->heights.data() + texel_index;
+                    resolved.strides[i] = fallback->width;
+                    resolved.water_depths[i] = has_fallback_water ? fallback->water_depths.data() + texel_index : &NO_WATER_DEPTH;
+                    resolved.sources[i] = TerrainSampleSource::Fallback;
+                    continue;
+                }
+            }
+
+            resolved.corners[i] = NOT_LOADED_HEIGHTS;
+            resolved.strides[i] = 0;
+            resolved.fractions_x[i] = 0;
+            resolved.fractions_z[i] = 0;
+            resolved.water_depths[i] = &NO_WATER_DEPTH;
+            resolved.sources[i] = TerrainSampleSource::NotLoaded;
+        }
+
+        auto* batch_samples = samples.data() + batch_start;
+
+        Size i = 0;
+#ifdef TERRAIN_HEIGHT_QUERIES_SSE2
+        for(; i + 4 <= batch_size; i += 4) {
+            filter_four_samples(resolved, i, batch_samples + i);
+        }
+#endif
+        for(; i < batch_size; i++) {
+            filter_sample(resolved, i, batch_samples[i]);
+        }
+    }
+}
+
+Uint32 TerrainHeightSnapshot::get_num_tiles() const { return num_tiles; }
+
+const TerrainHeightSnapshot::Tile* TerrainHeightSnapshot::find_tile_entry(const Vec2i& coord) const {
+    const auto table_size = tile_table.size();
+
+    auto index = get_tile_table_index(coord, table_size);
+    while(tile_table[index].heights != nullptr) {
+        if(tile_table[index].coord == coord) {
+            return &tile_table[index];
+        }
+
+        index = (index + 1) & (table_size - 1);
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+#include "world/environment/ecotypes.hpp"
+
+/*!
+ * \brief Where a terrain sample's height came from
+ */
+enum class TerrainSampleSource : Uint8 {
+    /*!
+     * \brief Neither a loaded tile nor the fallback heightmap covers the location. The sample's height is 0 and its normal points up
+     */
+    NotLoaded,
+
+    /*!
+     * \brief The location's tile isn't loaded, so the height came from the coarse heightmap that was generated with the world
+     */
+    Fallback,
+
+    /*!
+     * \brief The height came from a loaded terrain tile
+     */
+    Tile,
+};
+
+struct TerrainSample {
+    Float32 height{0};
+
+    Vec3f normal{0, 1, 0};
+
+    /*!
+     * \brief Depth of the water on top of the terrain in the sample's one-meter cell, in meters. 0 where there's no water
+     */
+    Float32 water_depth{0};
+
+    TerrainSampleSource source{TerrainSampleSource::NotLoaded};
+};
+
+/*!
+ * \brief Heightmap that covers the area around the world's origin at one height per meter. Used for locations whose tile isn't loaded
+ */
+struct TerrainFallbackHeightmap {
+    /*!
+     * \brief World x and z coordinates of the first height
+     */
+    Vec2f origin{};
+
+    /*!
+     * \brief Number of heights along the world's x axis
+     */
+    Uint32 width{0};
+
+    /*!
+     * \brief Number of heights along the world's z axis
+     */
+    Uint32 depth{0};
+
+    /*!
+     * \brief Heights, stored in rows along the x axis
+     */
+    Rx::Vector<Float32> heights;
+
+    /*!
+     * \brief Water depths at world generation time, laid out like `heights`. May be empty if the world has no water
+     */
+    Rx::Vector<Float32> water_depths;
+
+    /*!
+     * \brief Humidity of the air from the climate model, laid out like `heights`. May be empty
+     */
+    Rx::Vector<Float32> humidity;
+
+    /*!
+     * \brief Soil moisture from the climate model, laid out like `heights`. May be empty
+     */
+    Rx::Vector<Float32> soil_moisture;
+
+    /*!
+     * \brief Distance to the nearest ocean, river, or lake texel in meters, laid out like `heights`. May be empty
+     */
+    Rx::Vector<Float32> water_distance;
+
+    /*!
+     * \brief Groundwater from 0 to 1, laid out like `heights`. May be empty
+     */
+    Rx::Vector<Float32> groundwater;
+
+    /*!
+     * \brief Ecotypes at world generation time, laid out like `heights`. May be empty
+     */
+    environment::EcotypeMap ecotypes;
+};
+
+/*!
+ * \brief Immutable view of the terrain heights that are loaded at one point in time
+ *
+ * The terrain builds a new snapshot whenever tiles are loaded or evicted and publishes it with an `EpochReclaimer`, so any number of
+ * threads can sample the terrain without taking a lock. A snapshot doesn't own any heights or water depths. The terrain keeps the
+ * heightmaps of evicted tiles alive until no reader can be using a snapshot that refers to them, and publishes the water simulation's
+ * depths with the same rules
+ */
+class TerrainHeightSnapshot {
+public:
+    struct Tile {
+        Vec2i coord{};
+
+        /*!
+         * \brief `(tile_size + 1) * (tile_size + 1)` heights, in rows along the x axis. The last row and column are the first row and
+         * column of the neighbouring tiles, so bilinear filtering never has to look outside the tile
+         */
+        const Float32* heights{nullptr};
+
+        /*!
+         * \brief `tile_size * tile_size` water depths, one per one-meter cell, in rows along the x axis. May be nullptr if the tile has
+         * no water
+         */
+        const Float32* water_depths{nullptr};
+    };
+
+    /*!
+     * \brief Builds a snapshot
+     *
+     * \param tile_size_in Width of a tile, in meters
+     * \param tiles The loaded tiles
+     * \param fallback_in Heightmap for locations without a loaded tile. May be nullptr. Must outlive the snapshot
+     */
+    TerrainHeightSnapshot(Uint32 tile_size_in, const Rx::Vector<Tile>& tiles, const TerrainFallbackHeightmap* fallback_in);
+
+    /*!
+     * \brief Gets the heights of the tile with the provided coordinates, or nullptr if it's not loaded
+     */
+    [[nodiscard]] const Float32* find_tile(const Vec2i& coord) const;
+
+    /*!
+     * \brief Samples bilinearly-filtered heights and normals, and water depths, at a batch of locations
+     *
+     * Locations are resolved to heightmap texels one at a time, reusing the previous tile when consecutive locations fall in the same
+     * one. The filtering and normal math then runs four samples at a time
+     *
+     * \param locations World x and z coordinates to sample at
+     * \param samples Where to write the samples. Must be at least as big as `locations`
+     */
+    void sample(std::span<const Vec2f> locations, std::span<TerrainSample> samples) const;
+
+    [[nodiscard]] Uint32 get_num_tiles() const;
+
+private:
+    Uint32 tile_size;
+
+    const TerrainFallbackHeightmap* fallback;
+
+    /*!
+     * \brief Open-addressed hash table of the loaded tiles. Always a power of two in size and at most half full
+     */
+    Rx::Vector<Tile> tile_table;
+
+    Uint32 num_tiles;
+
+    [[nodiscard]] const Tile* find_tile_entry(const Vec2i& coord) const;
+};
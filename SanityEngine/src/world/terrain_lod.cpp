@@ -0,0 +1,171 @@
+#include "terrain_lod.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rx/core/algorithm/clamp.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+
+bool TerrainNodeKey::operator==(const TerrainNodeKey& other) const { return coord == other.coord && level == other.level; }
+
+bool TerrainNodeKey::operator!=(const TerrainNodeKey& other) const { return !(*this == other); }
+
+Uint32 TerrainNodeKey::get_texel_size() const { return 1u << level; }
+
+Uint32 TerrainNodeKey::get_size(const Uint32 tile_size) const { return tile_size << level; }
+
+Vec2i TerrainNodeKey::get_top_left(const Uint32 tile_size) const { return coord * static_cast<Int32>(get_size(tile_size)); }
+
+TerrainNodeKey TerrainNodeKey::get_child(const Uint32 index) const {
+    return {.coord = coord * 2 + Vec2i{static_cast<Int32>(index & 1), static_cast<Int32>(index >> 1)}, .level = level - 1};
+}
+
+bool TerrainNodeKey::contains(const TerrainNodeKey& other) const {
+    if(other.level > level) {
+        return false;
+    }
+
+    // Right-shifting negative coordinates rounds toward negative infinity, which is what we want
+    const auto level_difference = static_cast<Int32>(level - other.level);
+    return Vec2i{other.coord.x >> level_difference, other.coord.y >> level_difference} == coord;
+}
+
+bool TerrainNodeKey::overlaps(const TerrainNodeKey& other) const { return contains(other) || other.contains(*this); }
+
+Float32 get_terrain_node_geometric_error(const Uint32 level, const TerrainLodSettings& settings) {
+    return settings.geometric_error_per_meter * static_cast<Float32>((1u << level) - 1);
+}
+
+Float32 get_terrain_skirt_depth(const TerrainLodSettings& settings) {
+    // Skirts should still hide some cracks if the error estimate is zero, so give them a minimum depth
+    return Rx::Algorithm::max(get_terrain_node_geometric_error(settings.num_levels - 1, settings), 1.0f);
+}
+
+Float32 get_terrain_node_screen_space_error(const Uint32 level, const Float32 distance, const TerrainLodSettings& settings) {
+    // Keep nodes that the camera is inside from dividing by zero
+    const auto clamped_distance = Rx::Algorithm::max(distance, 0.001f);
+    const auto pixels_per_meter = settings.viewport_height / (2.0f * clamped_distance * std::tan(settings.vertical_fov * 0.5f));
+
+    return get_terrain_node_geometric_error(level, settings) * pixels_per_meter;
+}
+
+/*!
+ * \brief Distance from a point to the closest point of a node's bounding box
+ */
+static Float32 get_distance_to_node(const Vec2f& location,
+                                    const Float32 height,
+                                    const TerrainNodeKey& node,
+                                    const TileStreamingSettings& streaming_settings,
+                                    const TerrainLodSettings& lod_settings) {
+    const auto top_left = node.get_top_left(streaming_settings.tile_size);
+    const auto size = static_cast<Float32>(node.get_size(streaming_settings.tile_size));
+
+    const auto min_x = static_cast<Float32>(top_left.x);
+    const auto min_z = static_cast<Float32>(top_left.y);
+
+    const auto closest_point = Vec3f{Rx::Algorithm::clamp(location.x, min_x, min_x + size),
+                                     Rx::Algorithm::clamp(height, lod_settings.min_terrain_height, lod_settings.max_terrain_height),
+                                     Rx::Algorithm::clamp(location.y, min_z, min_z + size)};
+
+    return Rx::Math::length(closest_point - Vec3f{location.x, height, location.y});
+}
+
+/*!
+ * \brief Computes how urgently a node is needed. Lower numbers are more urgent
+ *
+ * Priority starts at the distance in tiles between the node and the player. Nodes behind the player are weighted to be up to twice as far
+ * away as they really are, so that the terrain in front of the player gets loaded first
+ */
+static Float32 get_node_priority(const TerrainNodeKey& node,
+                                 const Float32 distance,
+                                 const TileStreamingView& view,
+                                 const TileStreamingSettings& settings) {
+    const auto distance_in_tiles = distance / static_cast<Float32>(settings.tile_size);
+
+    // The nodes the player is standing in always go first
+    if(distance_in_tiles < 1.0f) {
+        return distance_in_tiles;
+    }
+
+    const auto size = static_cast<Float32>(node.get_size(settings.tile_size));
+    const auto top_left = node.get_top_left(settings.tile_size);
+    const auto node_center = Vec2f{static_cast<Float32>(top_left.x) + size * 0.5f, static_cast<Float32>(top_left.y) + size * 0.5f};
+
+    const auto to_node = node_center - view.location;
+    const auto distance_to_center = Rx::Math::length(to_node);
+    const auto facing = distance_to_center > 0.0f ? Rx::Math::dot(to_node / distance_to_center, view.view_direction) : 1.0f;
+
+    // facing is 1 for nodes straight ahead and -1 for nodes straight behind. Map that to a weight of 1 ahead and 2 behind
+    const auto view_weight = 1.5f - 0.5f * facing;
+
+    return distance_in_tiles * view_weight;
+}
+
+void select_terrain_nodes(const TileStreamingView& view,
+                          const TileStreamingSettings& streaming_settings,
+                          const TerrainLodSettings& lod_settings,
+                          Rx::Vector<TerrainNodeRequest>& selection) {
+    selection.clear();
+
+    const auto root_level = lod_settings.num_levels - 1;
+    const auto root_size = static_cast<Float32>(streaming_settings.tile_size << root_level);
+    const auto max_distance = static_cast<Float32>(streaming_settings.max_tile_distance * static_cast<Int32>(streaming_settings.tile_size));
+
+    const auto prefetch_location = get_prefetch_location(view, streaming_settings);
+
+    const auto select_node = [&](const auto& self, const TerrainNodeKey& node) -> void {
+        // Only the player's real location decides what's in range. The prefetch location decides how detailed it is
+        const auto distance_to_player = get_distance_to_node(view.location, view.height, node, streaming_settings, lod_settings);
+        if(distance_to_player > max_distance) {
+            return;
+        }
+
+        const auto distance_to_prefetch = get_distance_to_node(prefetch_location, view.height, node, streaming_settings, lod_settings);
+        const auto distance = Rx::Algorithm::min(distance_to_player, distance_to_prefetch);
+
+        if(node.level == 0 ||
+           get_terrain_node_screen_space_error(node.level, distance, lod_settings) <= lod_settings.max_screen_space_error) {
+            selection.push_back({.node = node, .priority = get_node_priority(node, distance, view, streaming_settings)});
+            return;
+        }
+
+        for(Uint32 child = 0; child < 4; child++) {
+            self(self, node.get_child(child));
+        }
+    };
+
+    const auto min_root = Vec2i{static_cast<Int32>(std::floor((view.location.x - max_distance) / root_size)),
+                                static_cast<Int32>(std::floor((view.location.y - max_distance) / root_size))};
+    const auto max_root = Vec2i{static_cast<Int32>(std::floor((view.location.x + max_distance) / root_size)),
+                                static_cast<Int32>(std::floor((view.location.y + max_distance) / root_size))};
+
+    for(Int32 y = min_root.y; y <= max_root.y; y++) {
+        for(Int32 x = min_root.x; x <= max_root.x; x++) {
+            select_node(select_node, {.coord = {x, y}, .level = root_level});
+        }
+    }
+
+    // Rx::Algorithm::quick_sort loses and duplicates elements, so use the standard library's sort
+    std::sort(selection.data(),
+              selection.data() + selection.size(),
+              [](const TerrainNodeRequest& a, const TerrainNodeRequest& b) { return a.priority < b.priority; });
+}
+
+TerrainLodStats get_terrain_lod_stats(const Rx::Vector<TerrainNodeRequest>& selection, const Uint32 tile_size, const Uint32 num_levels) {
+    auto stats = TerrainLodStats{.num_nodes = static_cast<Uint32>(selection.size())};
+    stats.num_nodes_per_level.resize(num_levels, 0);
+
+    // Every node has the same mesh: a grid with tile_size quads on each side, and a quad of skirt for each edge quad
+    const auto triangles_per_node = static_cast<Uint64>(tile_size) * tile_size * 2 + static_cast<Uint64>(tile_size) * 4 * 2;
+
+    selection.each_fwd([&](const TerrainNodeRequest& request) {
+        stats.num_nodes_per_level[request.node.level]++;
+        stats.num_triangles += triangles_per_node;
+
+        const auto num_tiles = static_cast<Uint64>(1) << (request.node.level * 2);
+        stats.num_full_resolution_triangles += triangles_per_node * num_tiles;
+    });
+
+    return stats;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/hash.h"
+#include "rx/core/vector.h"
+#include "world/terrain_streaming.hpp"
+
+/*!
+ * \brief Identifies a node in the terrain quadtree
+ *
+ * A node at level 0 is one terrain tile. A node at level n covers 2^n by 2^n tiles. Every node is meshed with the same number of vertices,
+ * so each level has half the resolution of the level below it
+ */
+struct TerrainNodeKey {
+    /*!
+     * \brief Coordinates of the node, in units of the node's own size
+     */
+    Vec2i coord{};
+
+    Uint32 level{0};
+
+    [[nodiscard]] bool operator==(const TerrainNodeKey& other) const;
+
+    [[nodiscard]] bool operator!=(const TerrainNodeKey& other) const;
+
+    /*!
+     * \brief Distance between the node's heights, in meters
+     */
+    [[nodiscard]] Uint32 get_texel_size() const;
+
+    /*!
+     * \brief Width of the node, in meters
+     */
+    [[nodiscard]] Uint32 get_size(Uint32 tile_size) const;
+
+    /*!
+     * \brief World x and z coordinates of the node's top left corner
+     */
+    [[nodiscard]] Vec2i get_top_left(Uint32 tile_size) const;
+
+    /*!
+     * \brief Gets one of this node's four children. Only valid for nodes above level 0
+     */
+    [[nodiscard]] TerrainNodeKey get_child(Uint32 index) const;
+
+    /*!
+     * \brief Checks if this node is `other` or one of its ancestors
+     */
+    [[nodiscard]] bool contains(const TerrainNodeKey& other) const;
+
+    /*!
+     * \brief Checks if this node and `other` cover any of the same terrain. In a quadtree that only happens when one contains the other
+     */
+    [[nodiscard]] bool overlaps(const TerrainNodeKey& other) const;
+};
+
+namespace Rx {
+    template <>
+    struct Hash<TerrainNodeKey> {
+        Size operator()(const TerrainNodeKey& key) const {
+            return hash_combine(Hash<Math::Vec2i>{}(key.coord), Hash<Uint32>{}(key.level));
+        }
+    };
+} // namespace Rx
+
+struct TerrainLodSettings {
+    /*!
+     * \brief Number of quadtree levels. The coarsest nodes are at level `num_levels - 1`
+     */
+    Uint32 num_levels{6};
+
+    /*!
+     * \brief Largest error, in pixels, that a node may have on screen before we switch to its children
+     */
+    Float32 max_screen_space_error{4.0f};
+
+    /*!
+     * \brief How far a node's mesh may be from the full-resolution terrain for each meter of texel size above one, in meters
+     *
+     * Level 0 nodes are the full-resolution terrain, so they have no error. This is a rough estimate for the terrain noise, not a bound
+     */
+    Float32 geometric_error_per_meter{0.5f};
+
+    Float32 viewport_height{1080.0f};
+
+    /*!
+     * \brief Vertical field of view of the camera, in radians
+     */
+    Float32 vertical_fov{1.5707963f};
+
+    /*!
+     * \brief Lowest height that the terrain can have. Nodes are assumed to span the whole height range until they're meshed
+     */
+    Float32 min_terrain_height{0.0f};
+
+    Float32 max_terrain_height{0.0f};
+};
+
+/*!
+ * \brief A node that the quadtree selected for rendering
+ */
+struct TerrainNodeRequest {
+    TerrainNodeKey node{};
+
+    /*!
+     * \brief How urgently this node is needed. Lower numbers are more urgent
+     */
+    Float32 priority{0};
+};
+
+/*!
+ * \brief What a quadtree selection costs to render
+ */
+struct TerrainLodStats {
+    Uint32 num_nodes{0};
+
+    /*!
+     * \brief Number of nodes at each level of the quadtree
+     */
+    Rx::Vector<Uint32> num_nodes_per_level;
+
+    Uint64 num_triangles{0};
+
+    /*!
+     * \brief Number of triangles that the selected area would take if all of it was meshed at full resolution
+     */
+    Uint64 num_full_resolution_triangles{0};
+};
+
+/*!
+ * \brief Estimates how far a node's mesh is from the full-resolution terrain, in meters
+ */
+[[nodiscard]] Float32 get_terrain_node_geometric_error(Uint32 level, const TerrainLodSettings& settings);
+
+/*!
+ * \brief Depth of the skirts that hang below the edges of every node
+ *
+ * Neighbouring nodes may be any number of levels apart, so the skirts must cover the error of the coarsest level
+ */
+[[nodiscard]] Float32 get_terrain_skirt_depth(const TerrainLodSettings& settings);
+
+/*!
+ * \brief Projects a node's geometric error onto the screen
+ *
+ * \param level The node's level
+ * \param distance Distance from the camera to the closest point of the node, in meters
+ * \param settings LOD settings
+ *
+ * \return The node's error, in pixels
+ */
+[[nodiscard]] Float32 get_terrain_node_screen_space_error(Uint32 level, Float32 distance, const TerrainLodSettings& settings);
+
+/*!
+ * \brief Selects the quadtree nodes that cover the terrain around the player
+ *
+ * Starts with the coarsest nodes within the maximum tile distance of the player, and splits nodes until their screen-space error is
+ * small enough. Distances are measured from the closer of the player's location and their prefetch location, so the terrain that the
+ * player is heading toward gets refined before they get there. The selected nodes don't overlap, and together they cover the streaming
+ * area
+ *
+ * This doesn't touch any terrain state, so it can run anywhere
+ *
+ * \param view The player's current view
+ * \param streaming_settings The tile size, maximum tile distance, and prefetch time
+ * \param lod_settings LOD settings
+ * \param selection Vector to write the selected nodes into, most urgent first. Any existing nodes are cleared. Callers can keep the vector
+ * around between frames to avoid allocating
+ */
+void select_terrain_nodes(const TileStreamingView& view,
+                          const TileStreamingSettings& streaming_settings,
+                          const TerrainLodSettings& lod_settings,
+                          Rx::Vector<TerrainNodeRequest>& selection);
+
+/*!
+ * \brief Counts the nodes and triangles in a selection
+ *
+ * \param selection Nodes from `select_terrain_nodes`
+ * \param tile_size Width of a level 0 node, in meters
+ * \param num_levels Number of levels in the quadtree
+ */
+[[nodiscard]] TerrainLodStats get_terrain_lod_stats(const Rx::Vector<TerrainNodeRequest>& selection, Uint32 tile_size, Uint32 num_levels);
@@ -0,0 +1,13 @@
+#include "terrain_streaming.hpp"
+
+#include <cmath>
+
+Vec2f get_prefetch_location(const TileStreamingView& view, const TileStreamingSettings& settings) {
+    return view.location + view.velocity * settings.prefetch_seconds;
+}
+
+Vec2i get_tile_containing_location(const Vec2f& location, const Uint32 tile_size) {
+    // Floor rather than truncate so that negative locations end up in negative tiles
+    return Vec2i{static_cast<Int32>(std::floor(location.x / static_cast<Float32>(tile_size))),
+                 static_cast<Int32>(std::floor(location.y / static_cast<Float32>(tile_size)))};
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/types.hpp"
+
+/*!
+ * \brief Everything the terrain streamer needs to know about the player to decide which tiles to load
+ */
+struct TileStreamingView {
+    /*!
+     * \brief Location of the player on the terrain's XZ plane
+     */
+    Vec2f location{};
+
+    /*!
+     * \brief Height of the player's eyes
+     */
+    Float32 height{0};
+
+    /*!
+     * \brief Normalized direction the player is looking, on the XZ plane. May be zero if the player is looking straight up or down
+     */
+    Vec2f view_direction{};
+
+    /*!
+     * \brief Player's velocity on the XZ plane, in meters per second
+     */
+    Vec2f velocity{};
+};
+
+struct TileStreamingSettings {
+    /*!
+     * \brief Width of a tile, in meters
+     */
+    Uint32 tile_size{64};
+
+    /*!
+     * \brief Maximum distance from the player at which terrain gets loaded, in tiles
+     */
+    Int32 max_tile_distance{16};
+
+    /*!
+     * \brief How many seconds ahead of the player to prefetch tiles. The prefetch location is the player's location plus their velocity
+     * times this
+     */
+    Float32 prefetch_seconds{2.0f};
+};
+
+/*!
+ * \brief Returns the coordinates of the tile that contains the provided location on the XZ plane
+ */
+[[nodiscard]] Vec2i get_tile_containing_location(const Vec2f& location, Uint32 tile_size);
+
+/*!
+ * \brief Where the player will be in `prefetch_seconds`, if they keep moving the way they are
+ */
+[[nodiscard]] Vec2f get_prefetch_location(const TileStreamingView& view, const TileStreamingSettings& settings);
@@ -0,0 +1,318 @@
+#include "terrain_tile_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "core/align.hpp"
+#include "rx/core/assert.h"
+#include "rx/core/concurrency/scope_lock.h"
+#include "rx/core/hash.h"
+#include "rx/core/log.h"
+#include "world/heightmap_tile_pool.hpp"
+
+RX_LOG("TerrainTileCache", logger);
+
+/*!
+ * \brief Identifies a terrain tile cache file. Spells "SETC" in a hex editor
+ */
+constexpr Uint32 TERRAIN_TILE_CACHE_MAGIC = 0x43544553;
+
+/*!
+ * \brief Version of the cache file layout. Bump this whenever the layout or the tile generation algorithm changes
+ */
+constexpr Uint32 TERRAIN_TILE_CACHE_VERSION = 1;
+
+/*!
+ * \brief Size of the file header. A whole page, so that the slots start on a page boundary
+ */
+constexpr Size TERRAIN_TILE_CACHE_HEADER_SIZE = 4096;
+
+/*!
+ * \brief Maximum number of slots that a lookup or store looks at before it gives up
+ */
+constexpr Uint32 MAX_TERRAIN_TILE_CACHE_PROBES = 16;
+
+struct TerrainTileCache::Header {
+    Uint32 magic;
+
+    Uint32 version;
+
+    Uint64 generator_hash;
+
+    Uint32 grid_size;
+
+    Uint32 num_slots;
+
+    Uint64 slot_size;
+
+    Uint32 store_meshes;
+};
+
+/*!
+ * \brief State of a slot
+ *
+ * Empty slots are all zeros, so a freshly grown file is full of empty slots. Slots that were still being written when a previous run
+ * ended are abandoned rather than emptied, because emptying them would break the probe sequences of the tiles after them
+ */
+enum class TerrainTileCacheSlotState : Uint32 { Empty = 0, Writing, Valid, Abandoned };
+
+struct alignas(HeightmapTilePool::CACHE_LINE_SIZE) TerrainTileCache::Entry {
+    TerrainTileCacheSlotState state;
+
+    Uint32 level;
+
+    Int32 x;
+
+    Int32 y;
+
+    Uint64 key;
+
+    Float32 skirt_depth;
+
+    Float32 min_height;
+
+    Float32 max_height;
+
+    Uint32 has_mesh;
+};
+
+Uint64 TerrainTileCache::get_generator_hash(const terraingen::NoiseConfig& noise_config,
+                                            const Uint32 tile_size,
+                                            const Float32 min_terrain_height,
+                                            const Float32 max_terrain_height) {
+    auto hash = static_cast<Uint64>(noise_config.hash());
+    hash = Rx::hash_combine(hash, Rx::Hash<Uint32>{}(tile_size));
+    hash = Rx::hash_combine(hash, Rx::Hash<Float32>{}(min_terrain_height));
+    hash = Rx::hash_combine(hash, Rx::Hash<Float32>{}(max_terrain_height));
+    hash = Rx::hash_combine(hash, Rx::Hash<Uint32>{}(TERRAIN_TILE_CACHE_VERSION));
+
+    return hash;
+}
+
+TerrainTileCache::TerrainTileCache(const TerrainTileCacheCreateInfo& create_info)
+    : generator_hash{create_info.generator_hash},
+      grid_size{create_info.grid_size},
+      num_slots{create_info.max_num_tiles},
+      store_meshes{create_info.store_meshes} {
+    ZoneScoped;
+
+    const auto apron_heights_size = ALIGN(HeightmapTilePool::CACHE_LINE_SIZE, get_num_apron_heights() * sizeof(Float32));
+    const auto vertices_size = store_meshes ? get_num_terrain_tile_vertices(grid_size) * sizeof(TerrainVertex) : 0;
+    slot_size = ALIGN(HeightmapTilePool::CACHE_LINE_SIZE, sizeof(Entry) + apron_heights_size + vertices_size);
+    file_size = TERRAIN_TILE_CACHE_HEADER_SIZE + slot_size * num_slots;
+
+    const auto path = std::filesystem::path{create_info.path.data()};
+    if(path.has_parent_path()) {
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        if(error) {
+            logger->error("Could not create the directory for terrain tile cache %s: %s", create_info.path, error.message().c_str());
+            return;
+        }
+    }
+
+    // Growing the file fills it with zeros, which are empty slots
+    file = Rx::make_ptr<MappedFile>(RX_SYSTEM_ALLOCATOR, create_info.path, file_size);
+    if(!file->is_open()) {
+        logger->error("Could not open terrain tile cache %s", create_info.path);
+        return;
+    }
+
+    mapped_data = file->get_writable_data().data();
+
+    validate_contents();
+
+    logger->info("Opened terrain tile cache %s with room for %u tiles (%zu MB)", create_info.path, num_slots, file_size / (1024 * 1024));
+}
+
+TerrainTileCache::~TerrainTileCache() {
+    if(is_open()) {
+        logger->info("Closing terrain tile cache after %llu hits, %llu misses, and %llu new tiles",
+                     num_hits.load(),
+                     num_misses.load(),
+                     num_stores.load());
+    }
+
+    // Unmapping the file flushes it
+}
+
+bool TerrainTileCache::is_open() const { return mapped_data != nullptr; }
+
+Rx::Optional<CachedTerrainTile> TerrainTileCache::find(const TerrainNodeKey& node) const {
+    ZoneScoped;
+
+    if(!is_open()) {
+        return Rx::nullopt;
+    }
+
+    const auto key = get_tile_key(node);
+
+    Rx::Concurrency::ScopeLock l{slots_mutex};
+
+    for(Uint32 probe = 0; probe < MAX_TERRAIN_TILE_CACHE_PROBES; probe++) {
+        const auto slot = static_cast<Uint32>((key + probe) % num_slots);
+        const auto& entry = get_entry(slot);
+        if(entry.state == TerrainTileCacheSlotState::Empty) {
+            break;
+        }
+
+        if(entry.state == TerrainTileCacheSlotState::Valid && entry.key == key && entry.x == node.coord.x && entry.y == node.coord.y &&
+           entry.level == node.level) {
+            num_hits.fetch_add(1);
+
+            auto tile = CachedTerrainTile{.apron_heights = {get_apron_heights(slot), get_num_apron_heights()},
+                                          .skirt_depth = entry.skirt_depth,
+                                          .min_height = entry.min_height,
+                                          .max_height = entry.max_height};
+            if(entry.has_mesh != 0) {
+                tile.vertices = {get_vertices(slot), get_num_terrain_tile_vertices(grid_size)};
+            }
+
+            return tile;
+        }
+    }
+
+    num_misses.fetch_add(1);
+
+    return Rx::nullopt;
+}
+
+void TerrainTileCache::store(const TerrainNodeKey& node,
+                             const std::span<const Float32> apron_heights,
+                             const terraingen::TerrainNodeMesh& mesh,
+                             const Float32 skirt_depth) {
+    ZoneScoped;
+
+    if(!is_open()) {
+        return;
+    }
+
+    RX_ASSERT(apron_heights.size() == get_num_apron_heights(),
+              "Terrain tile cache needs %zu apron heights, but %zu were provided",
+              get_num_apron_heights(),
+              apron_heights.size());
+
+    const auto key = get_tile_key(node);
+
+    Rx::Optional<Uint32> claimed_slot;
+    {
+        Rx::Concurrency::ScopeLock l{slots_mutex};
+
+        for(Uint32 probe = 0; probe < MAX_TERRAIN_TILE_CACHE_PROBES; probe++) {
+            const auto slot = static_cast<Uint32>((key + probe) % num_slots);
+            auto& entry = get_entry(slot);
+            if(entry.state == TerrainTileCacheSlotState::Empty) {
+                entry.state = TerrainTileCacheSlotState::Writing;
+                entry.key = key;
+                entry.x = node.coord.x;
+                entry.y = node.coord.y;
+                entry.level = node.level;
+                claimed_slot = slot;
+                break;
+            }
+
+            // Another task already stored this tile, or is storing it right now
+            if(entry.key == key && entry.x == node.coord.x && entry.y == node.coord.y && entry.level == node.level) {
+                return;
+            }
+        }
+    }
+
+    if(!claimed_slot) {
+        logger->verbose("No room for tile (%d, %d) at level %u in the terrain tile cache", node.coord.x, node.coord.y, node.level);
+        return;
+    }
+
+    const auto slot = *claimed_slot;
+    auto& entry = get_entry(slot);
+
+    memcpy(get_apron_heights(slot), apron_heights.data(), apron_heights.size_bytes());
+
+    const auto can_store_mesh = store_meshes && mesh.vertices.size() == get_num_terrain_tile_vertices(grid_size);
+    if(can_store_mesh) {
+        memcpy(get_vertices(slot), mesh.vertices.data(), mesh.vertices.size() * sizeof(TerrainVertex));
+    }
+
+    entry.skirt_depth = skirt_depth;
+    entry.min_height = mesh.min_height;
+    entry.max_height = mesh.max_height;
+    entry.has_mesh = can_store_mesh ? 1 : 0;
+
+    {
+        Rx::Concurrency::ScopeLock l{slots_mutex};
+        entry.state = TerrainTileCacheSlotState::Valid;
+    }
+
+    num_stores.fetch_add(1);
+}
+
+Uint64 TerrainTileCache::get_tile_key(const TerrainNodeKey& node) const {
+    auto key = Rx::hash_combine(generator_hash, Rx::Hash<Int32>{}(node.coord.x));
+    key = Rx::hash_combine(key, Rx::Hash<Int32>{}(node.coord.y));
+    key = Rx::hash_combine(key, Rx::Hash<Uint32>{}(node.level));
+
+    return key;
+}
+
+Size TerrainTileCache::get_num_apron_heights() const {
+    const auto apron_size = static_cast<Size>(grid_size) + 2;
+    return apron_size * apron_size;
+}
+
+TerrainTileCache::Entry& TerrainTileCache::get_entry(const Uint32 slot) const {
+    return *reinterpret_cast<Entry*>(mapped_data + TERRAIN_TILE_CACHE_HEADER_SIZE + slot * slot_size);
+}
+
+Float32* TerrainTileCache::get_apron_heights(const Uint32 slot) const {
+    return reinterpret_cast<Float32*>(reinterpret_cast<Byte*>(&get_entry(slot)) + sizeof(Entry));
+}
+
+TerrainVertex* TerrainTileCache::get_vertices(const Uint32 slot) const {
+    const auto apron_heights_size = ALIGN(HeightmapTilePool::CACHE_LINE_SIZE, get_num_apron_heights() * sizeof(Float32));
+    return reinterpret_cast<TerrainVertex*>(reinterpret_cast<Byte*>(get_apron_heights(slot)) + apron_heights_size);
+}
+
+void TerrainTileCache::validate_contents() {
+    ZoneScoped;
+
+    auto& header = *reinterpret_cast<Header*>(mapped_data);
+    const auto is_header_current = header.magic == TERRAIN_TILE_CACHE_MAGIC && header.version == TERRAIN_TILE_CACHE_VERSION &&
+                                   header.generator_hash == generator_hash && header.grid_size == grid_size &&
+                                   header.num_slots == num_slots && header.slot_size == slot_size &&
+                                   header.store_meshes == (store_meshes ? 1u : 0u);
+
+    if(!is_header_current) {
+        if(header.magic == TERRAIN_TILE_CACHE_MAGIC) {
+            logger->info("Terrain tile cache was written by a different terrain generator or with different settings, clearing it");
+        }
+
+        for(Uint32 slot = 0; slot < num_slots; slot++) {
+            get_entry(slot) = Entry{};
+        }
+
+        header = Header{.magic = TERRAIN_TILE_CACHE_MAGIC,
+                        .version = TERRAIN_TILE_CACHE_VERSION,
+                        .generator_hash = generator_hash,
+                        .grid_size = grid_size,
+                        .num_slots = num_slots,
+                        .slot_size = slot_size,
+                        .store_meshes = store_meshes ? 1u : 0u};
+
+        return;
+    }
+
+    Uint32 num_cached_tiles = 0;
+    for(Uint32 slot = 0; slot < num_slots; slot++) {
+        auto& entry = get_entry(slot);
+        if(entry.state == TerrainTileCacheSlotState::Writing) {
+            entry.state = TerrainTileCacheSlotState::Abandoned;
+
+        } else if(entry.state == TerrainTileCacheSlotState::Valid) {
+            num_cached_tiles++;
+        }
+    }
+
+    logger->verbose("Terrain tile cache has %u tiles from previous runs", num_cached_tiles);
+}
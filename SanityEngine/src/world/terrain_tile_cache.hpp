@@ -0,0 +1,190 @@
+#pragma once
+
+#include <span>
+
+#include "core/mapped_file.hpp"
+#include "core/types.hpp"
+#include "rhi/terrain_vertex.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/concurrency/mutex.h"
+#include "rx/core/optional.h"
+#include "rx/core/ptr.h"
+#include "rx/core/string.h"
+#include "world/generation/terrain_node_mesh.hpp"
+#include "world/generation/terrain_noise.hpp"
+#include "world/terrain_lod.hpp"
+
+struct TerrainTileCacheCreateInfo {
+    /*!
+     * \brief Path of the cache file. It's created if it doesn't exist
+     */
+    Rx::String path;
+
+    /*!
+     * \brief Hash of everything that decides what the generated tiles look like. See `TerrainTileCache::get_generator_hash`
+     */
+    Uint64 generator_hash{0};
+
+    /*!
+     * \brief Number of vertices on each side of a tile's grid
+     */
+    Uint32 grid_size{0};
+
+    /*!
+     * \brief Maximum number of tiles that the cache can hold. Decides the size of the cache file
+     */
+    Uint32 max_num_tiles{4096};
+
+    /*!
+     * \brief Whether to store the tiles' meshes as well as their heights
+     *
+     * Tiles without a stored mesh get meshed from their cached heights, which is much cheaper than generating them but not free. Storing
+     * the meshes roughly triples the size of the cache file
+     */
+    bool store_meshes{true};
+};
+
+/*!
+ * \brief A tile from the terrain tile cache
+ *
+ * The spans point straight into the cache file's mapping. They stay valid for as long as the cache exists
+ */
+struct CachedTerrainTile {
+    /*!
+     * \brief The tile's heights, plus a one-texel apron, in the layout that `terraingen::fill_heights_with_apron` returns
+     */
+    std::span<const Float32> apron_heights;
+
+    /*!
+     * \brief The tile's vertices. Empty if the cache doesn't store meshes
+     */
+    std::span<const TerrainVertex> vertices;
+
+    /*!
+     * \brief The skirt depth that the mesh was built with. The mesh is only usable if this matches the terrain's current skirt depth
+     */
+    Float32 skirt_depth{0};
+
+    Float32 min_height{0};
+
+    Float32 max_height{0};
+};
+
+/*!
+ * \brief Persistent on-disk cache for generated terrain tiles
+ *
+ * Terrain tiles are a pure function of the noise settings, the terrain's height range, and the tile's quadtree node. The cache stores
+ * each generated tile in a memory-mapped file, so revisiting a tile - in this run or a later one - skips noise generation entirely
+ *
+ * The file is a header followed by a fixed number of fixed-size slots, which form an open-addressed hash table keyed on a hash of the
+ * generator settings and the tile's node. The header records the generator hash. If it doesn't match the terrain that opens the cache,
+ * every slot gets cleared, so changing the seed or the noise settings can never load stale tiles
+ *
+ * Slots are written once and never overwritten while the cache is open, which is what lets lookups hand out pointers into the mapping.
+ * When a tile's neighbourhood in the hash table is full the tile just doesn't get cached
+ *
+ * Safe to use from any number of threads at once
+ */
+class TerrainTileCache {
+public:
+    /*!
+     * \brief Hashes everything that decides what the generated tiles look like
+     */
+    [[nodiscard]] static Uint64 get_generator_hash(const terraingen::NoiseConfig& noise_config,
+                                                   Uint32 tile_size,
+                                                   Float32 min_terrain_height,
+                                                   Float32 max_terrain_height);
+
+    /*!
+     * \brief Opens or creates a cache file
+     *
+     * If the file can't be opened or mapped, the error is logged and the cache stays closed. A closed cache misses every lookup and
+     * ignores every store
+     */
+    explicit TerrainTileCache(const TerrainTileCacheCreateInfo& create_info);
+
+    TerrainTileCache(const TerrainTileCache& other) = delete;
+    TerrainTileCache& operator=(const TerrainTileCache& other) = delete;
+
+    TerrainTileCache(TerrainTileCache&& old) noexcept = delete;
+    TerrainTileCache& operator=(TerrainTileCache&& old) noexcept = delete;
+
+    /*!
+     * \brief Flushes the cache to disk and closes it
+     */
+    ~TerrainTileCache();
+
+    [[nodiscard]] bool is_open() const;
+
+    /*!
+     * \brief Looks up a tile
+     *
+     * \return The cached tile, or an empty optional if the tile isn't in the cache or is still being stored
+     */
+    [[nodiscard]] Rx::Optional<CachedTerrainTile> find(const TerrainNodeKey& node) const;
+
+    /*!
+     * \brief Stores a tile in the cache. Does nothing if the tile is already cached or if there's no room for it
+     *
+     * \param node The tile's quadtree node
+     * \param apron_heights The tile's heights plus their apron
+     * \param mesh The tile's mesh. Ignored if the cache doesn't store meshes
+     * \param skirt_depth The skirt depth that the mesh was built with
+     */
+    void store(const TerrainNodeKey& node,
+               std::span<const Float32> apron_heights,
+               const terraingen::TerrainNodeMesh& mesh,
+               Float32 skirt_depth);
+
+private:
+    struct Header;
+
+    struct Entry;
+
+    Uint64 generator_hash;
+
+    Uint32 grid_size;
+
+    Uint32 num_slots;
+
+    bool store_meshes;
+
+    Size slot_size;
+
+    Size file_size;
+
+    Rx::Ptr<MappedFile> file;
+
+    /*!
+     * \brief Start of the file's writable mapping, or nullptr if the cache is closed
+     */
+    Byte* mapped_data{nullptr};
+
+    /*!
+     * \brief Guards the state of every slot. The tile data in a slot is written outside the lock, while the slot is marked as being
+     * written so that nobody else reads it
+     */
+    mutable Rx::Concurrency::Mutex slots_mutex;
+
+    mutable Rx::Concurrency::Atomic<Uint64> num_hits{0};
+
+    mutable Rx::Concurrency::Atomic<Uint64> num_misses{0};
+
+    Rx::Concurrency::Atomic<Uint64> num_stores{0};
+
+    [[nodiscard]] Uint64 get_tile_key(const TerrainNodeKey& node) const;
+
+    [[nodiscard]] Size get_num_apron_heights() const;
+
+    [[nodiscard]] Entry& get_entry(Uint32 slot) const;
+
+    [[nodiscard]] Float32* get_apron_heights(Uint32 slot) const;
+
+    [[nodiscard]] TerrainVertex* get_vertices(Uint32 slot) const;
+
+    /*!
+     * \brief Clears the cache if it was written by a different terrain generator or with a different layout, and forgets any slots that
+     * were still being written when the last run ended
+     */
+    void validate_contents();
+};
@@ -0,0 +1,449 @@
+#include "terrain_water.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/concurrency/wait_group.h"
+
+/*!
+ * \brief Surface height of the cells outside tiles that aren't being updated. Nothing flows into them
+ */
+constexpr Float32 WATER_WALL_HEIGHT = 1e30f;
+
+static bool has_any_water(const Rx::Vector<Float32>& depths) {
+    for(Size i = 0; i < depths.size(); i++) {
+        if(depths[i] > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+TerrainWaterSimulation::TerrainWaterSimulation(const Uint32 tile_size_in,
+                                               const TerrainWaterSettings& settings_in,
+                                               const Uint32 num_threads_in)
+    : tile_size{tile_size_in},
+      settings{settings_in},
+      num_threads{Rx::Algorithm::max(num_threads_in, 1u)},
+      thread_pool{num_threads, num_threads} {}
+
+TerrainWaterSimulation::~TerrainWaterSimulation() = default;
+
+void TerrainWaterSimulation::add_tile(const Vec2i& coord,
+                                      const std::span<const Float32> terrain_heights,
+                                      const Uint32 terrain_stride,
+                                      const std::span<const Float32> initial_depths) {
+    ZoneScoped;
+
+    RX_ASSERT(terrain_heights.size() >= static_cast<Size>(terrain_stride) * tile_size,
+              "Terrain heights for a tile need %u rows of %u heights, but there are only %zu heights",
+              tile_size,
+              terrain_stride,
+              terrain_heights.size());
+
+    if(find_tile(coord) != nullptr) {
+        return;
+    }
+
+    const auto num_cells = static_cast<Size>(tile_size) * tile_size;
+    const auto halo_size = tile_size + 2;
+
+    auto tile = Rx::make_ptr<WaterTile>(RX_SYSTEM_ALLOCATOR);
+    tile->coord = coord;
+
+    tile->terrain_heights.resize(num_cells, 0.0f);
+    for(Uint32 y = 0; y < tile_size; y++) {
+        memcpy(tile->terrain_heights.data() + y * tile_size, terrain_heights.data() + y * terrain_stride, tile_size * sizeof(Float32));
+    }
+
+    tile->depths.resize(num_cells, 0.0f);
+    if(initial_depths.size() >= num_cells) {
+        memcpy(tile->depths.data(), initial_depths.data(), num_cells * sizeof(Float32));
+    }
+
+    for(Uint32 side = 0; side < NumSides; side++) {
+        tile->outflows[side].resize(num_cells, 0.0f);
+        tile->edge_inflows[side].resize(tile_size, 0.0f);
+    }
+    tile->surface_heights.resize(static_cast<Size>(halo_size) * halo_size, WATER_WALL_HEIGHT);
+
+    tile->published_depths[0] = tile->depths;
+    tile->published_depths[1].resize(num_cells, 0.0f);
+
+    auto* new_tile = tile.get();
+    tiles.insert(coord, Rx::Utility::move(tile));
+
+    const auto has_water = has_any_water(new_tile->depths);
+    if(has_water) {
+        wake(*new_tile);
+    }
+
+    // The new tile's edges used to be walls to its neighbours, so water might start flowing across them
+    const Vec2i side_offsets[NumSides] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    constexpr TileSide opposite_sides[NumSides] = {Right, Left, Down, Up};
+    for(Uint32 side = 0; side < NumSides; side++) {
+        if(auto* neighbour = find_tile(coord + side_offsets[side])) {
+            new_tile->neighbours[side] = neighbour;
+            neighbour->neighbours[opposite_sides[side]] = new_tile;
+            if(has_water || has_any_water(neighbour->depths)) {
+                wake(*neighbour);
+            }
+        }
+    }
+}
+
+void TerrainWaterSimulation::remove_tile(const Vec2i& coord) {
+    auto* tile_ptr = tiles.find(coord);
+    if(tile_ptr == nullptr) {
+        return;
+    }
+
+    auto& tile = **tile_ptr;
+    constexpr TileSide opposite_sides[NumSides] = {Right, Left, Down, Up};
+    for(Uint32 side = 0; side < NumSides; side++) {
+        if(auto* neighbour = tile.neighbours[side]) {
+            neighbour->neighbours[opposite_sides[side]] = nullptr;
+        }
+    }
+
+    removed_tiles.push_back(Rx::Utility::move(*tile_ptr));
+    tiles.erase(coord);
+}
+
+void TerrainWaterSimulation::add_water(const Vec2f& location, const Float32 depth) {
+    const auto tile_size_float = static_cast<Float32>(tile_size);
+    const auto coord = Vec2i{static_cast<Int32>(std::floor(location.x / tile_size_float)),
+                             static_cast<Int32>(std::floor(location.y / tile_size_float))};
+
+    auto* tile = find_tile(coord);
+    if(tile == nullptr) {
+        return;
+    }
+
+    const auto x = Rx::Algorithm::min(static_cast<Uint32>(location.x - static_cast<Float32>(coord.x) * tile_size_float), tile_size - 1);
+    const auto y = Rx::Algorithm::min(static_cast<Uint32>(location.y - static_cast<Float32>(coord.y) * tile_size_float), tile_size - 1);
+    tile->depths[y * tile_size + x] += depth;
+    tile->has_unpublished_changes = true;
+
+    wake(*tile);
+}
+
+TerrainWaterStepStats TerrainWaterSimulation::advance(const Float32 delta_time, const Uint32 max_steps) {
+    ZoneScoped;
+
+    TerrainWaterStepStats stats;
+
+    unsimulated_time += delta_time;
+    while(unsimulated_time >= settings.time_step && stats.num_steps < max_steps) {
+        const auto num_tiles_updated = step();
+
+        stats.num_steps++;
+        stats.num_tiles_updated += num_tiles_updated;
+        stats.num_cells_updated += static_cast<Uint64>(num_tiles_updated) * tile_size * tile_size;
+
+        unsimulated_time -= settings.time_step;
+    }
+
+    // If we couldn't keep up, drop the time we didn't simulate instead of trying to catch up later
+    if(stats.num_steps == max_steps) {
+        unsimulated_time = Rx::Algorithm::min(unsimulated_time, settings.time_step);
+    }
+
+    return stats;
+}
+
+Uint32 TerrainWaterSimulation::step() {
+    ZoneScoped;
+
+    // Update every awake tile, plus its neighbours so that they can catch the water that flows out of it
+    stepping_tiles.clear();
+    tiles.each_value([&](Rx::Ptr<WaterTile>& tile) { tile->is_stepping = false; });
+    tiles.each_value([&](Rx::Ptr<WaterTile>& tile) {
+        if(!tile->is_awake) {
+            return;
+        }
+
+        const auto add_stepping_tile = [&](WaterTile* stepping_tile) {
+            if(stepping_tile != nullptr && !stepping_tile->is_stepping) {
+                stepping_tile->is_stepping = true;
+                stepping_tiles.push_back(stepping_tile);
+            }
+        };
+
+        add_stepping_tile(tile.get());
+        for(auto* neighbour : tile->neighbours) {
+            add_stepping_tile(neighbour);
+        }
+    });
+
+    if(stepping_tiles.is_empty()) {
+        return 0;
+    }
+
+    for_each_stepping_tile([&](WaterTile& tile) { compute_outflows(tile); });
+
+    for_each_stepping_tile([&](WaterTile& tile) { move_water(tile); });
+
+    stepping_tiles.each_fwd([&](WaterTile* tile) {
+        if(tile->max_depth_change >= settings.sleep_threshold) {
+            tile->is_awake = true;
+            tile->num_calm_steps = 0;
+            return;
+        }
+
+        tile->num_calm_steps++;
+        if(tile->is_awake && tile->num_calm_steps < settings.num_calm_steps_to_sleep) {
+            return;
+        }
+
+        // Sleeping tiles don't flow, so that their neighbours can rely on them not sending any water
+        tile->is_awake = false;
+        for(auto& outflow : tile->outflows) {
+            memset(outflow.data(), 0, outflow.size() * sizeof(Float32));
+        }
+    });
+
+    return static_cast<Uint32>(stepping_tiles.size());
+}
+
+bool TerrainWaterSimulation::has_unpublished_changes() const {
+    if(!removed_tiles.is_empty()) {
+        return true;
+    }
+
+    auto has_changes = false;
+    tiles.each_value([&](const Rx::Ptr<WaterTile>& tile) {
+        if(tile->has_unpublished_changes) {
+            has_changes = true;
+            return false;
+        }
+
+        return true;
+    });
+
+    return has_changes;
+}
+
+void TerrainWaterSimulation::publish() {
+    ZoneScoped;
+
+    retired_tiles = Rx::Utility::move(removed_tiles);
+    removed_tiles.clear();
+
+    tiles.each_value([&](Rx::Ptr<WaterTile>& tile) {
+        if(!tile->has_unpublished_changes) {
+            return;
+        }
+
+        const auto next_index = 1 - tile->published_index;
+        memcpy(tile->published_depths[next_index].data(), tile->depths.data(), tile->depths.size() * sizeof(Float32));
+        tile->published_index = next_index;
+        tile->has_unpublished_changes = false;
+    });
+}
+
+const Float32* TerrainWaterSimulation::get_published_depths(const Vec2i& coord) const {
+    const auto* tile = find_tile(coord);
+    return tile != nullptr ? tile->published_depths[tile->published_index].data() : nullptr;
+}
+
+Uint32 TerrainWaterSimulation::get_num_tiles() const { return static_cast<Uint32>(tiles.size()); }
+
+Uint32 TerrainWaterSimulation::get_num_awake_tiles() const {
+    Uint32 num_awake_tiles = 0;
+    tiles.each_value([&](const Rx::Ptr<WaterTile>& tile) {
+        if(tile->is_awake) {
+            num_awake_tiles++;
+        }
+    });
+
+    return num_awake_tiles;
+}
+
+TerrainWaterSimulation::WaterTile* TerrainWaterSimulation::find_tile(const Vec2i& coord) const {
+    auto* tile = tiles.find(coord);
+    return tile != nullptr ? tile->get() : nullptr;
+}
+
+void TerrainWaterSimulation::wake(WaterTile& tile) {
+    tile.is_awake = true;
+    tile.num_calm_steps = 0;
+}
+
+void TerrainWaterSimulation::compute_outflows(WaterTile& tile) const {
+    ZoneScoped;
+
+    const auto halo_size = tile_size + 2;
+    auto* surface = tile.surface_heights.data();
+
+    for(Uint32 y = 0; y < tile_size; y++) {
+        const auto* terrain_row = tile.terrain_heights.data() + y * tile_size;
+        const auto* depth_row = tile.depths.data() + y * tile_size;
+        auto* surface_row = surface + (y + 1) * halo_size + 1;
+        for(Uint32 x = 0; x < tile_size; x++) {
+            surface_row[x] = terrain_row[x] + depth_row[x];
+        }
+    }
+
+    // Copy the edges of the neighbours into the halo. Neighbours that aren't being updated won't take any water, so they're walls
+    const auto get_neighbour_surface = [&](const WaterTile* neighbour, const Uint32 x, const Uint32 y) {
+        if(neighbour == nullptr || !neighbour->is_stepping) {
+            return WATER_WALL_HEIGHT;
+        }
+
+        const auto index = y * tile_size + x;
+        return neighbour->terrain_heights[index] + neighbour->depths[index];
+    };
+
+    for(Uint32 i = 0; i < tile_size; i++) {
+        surface[(i + 1) * halo_size] = get_neighbour_surface(tile.neighbours[Left], tile_size - 1, i);
+        surface[(i + 1) * halo_size + tile_size + 1] = get_neighbour_surface(tile.neighbours[Right], 0, i);
+        surface[i + 1] = get_neighbour_surface(tile.neighbours[Up], i, tile_size - 1);
+        surface[(tile_size + 1) * halo_size + i + 1] = get_neighbour_surface(tile.neighbours[Down], i, 0);
+    }
+
+    // Cells are one meter wide, and the pipes between them are one meter long with a cross section of one square meter, so a difference
+    // in surface height accelerates the flow by gravity times the difference
+    const auto acceleration = settings.time_step * settings.gravity;
+    const auto damping = settings.flow_damping;
+
+    auto* outflow_left = tile.outflows[Left].data();
+    auto* outflow_right = tile.outflows[Right].data();
+    auto* outflow_up = tile.outflows[Up].data();
+    auto* outflow_down = tile.outflows[Down].data();
+
+    for(Uint32 y = 0; y < tile_size; y++) {
+        const auto* surface_row = surface + (y + 1) * halo_size + 1;
+        const auto* surface_row_above = surface_row - halo_size;
+        const auto* surface_row_below = surface_row + halo_size;
+        const auto* surface_row_left = surface_row - 1;
+        const auto* surface_row_right = surface_row + 1;
+        for(Uint32 x = 0; x < tile_size; x++) {
+            const auto i = y * tile_size + x;
+            const auto height = surface_row[x];
+
+            auto left = Rx::Algorithm::max(outflow_left[i] * damping + acceleration * (height - surface_row_left[x]), 0.0f);
+            auto right = Rx::Algorithm::max(outflow_right[i] * damping + acceleration * (height - surface_row_right[x]), 0.0f);
+            auto up = Rx::Algorithm::max(outflow_up[i] * damping + acceleration * (height - surface_row_above[x]), 0.0f);
+            auto down = Rx::Algorithm::max(outflow_down[i] * damping + acceleration * (height - surface_row_below[x]), 0.0f);
+
+            // Don't let more water flow out of a cell than it has
+            const auto total_outflow = (left + right + up + down) * settings.time_step;
+            const auto depth = tile.depths[i];
+            if(total_outflow > depth) {
+                const auto scale = total_outflow > 0 ? depth / total_outflow : 0.0f;
+                left *= scale;
+                right *= scale;
+                up *= scale;
+                down *= scale;
+            }
+
+            outflow_left[i] = left;
+            outflow_right[i] = right;
+            outflow_up[i] = up;
+            outflow_down[i] = down;
+        }
+    }
+}
+
+void TerrainWaterSimulation::move_water(WaterTile& tile) const {
+    ZoneScoped;
+
+    // Gather the flow into this tile from the edges of its neighbours
+    const auto gather_edge_inflows = [&](const TileSide side, const WaterTile* neighbour, const TileSide neighbour_side) {
+        auto& edge_inflows = tile.edge_inflows[side];
+        if(neighbour == nullptr || !neighbour->is_stepping) {
+            memset(edge_inflows.data(), 0, edge_inflows.size() * sizeof(Float32));
+            return;
+        }
+
+        const auto& neighbour_outflows = neighbour->outflows[neighbour_side];
+        for(Uint32 i = 0; i < tile_size; i++) {
+            switch(side) {
+                case Left:
+                    edge_inflows[i] = neighbour_outflows[i * tile_size + tile_size - 1];
+                    break;
+
+                case Right:
+                    edge_inflows[i] = neighbour_outflows[i * tile_size];
+                    break;
+
+                case Up:
+                    edge_inflows[i] = neighbour_outflows[(tile_size - 1) * tile_size + i];
+                    break;
+
+                case Down:
+                    edge_inflows[i] = neighbour_outflows[i];
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    };
+
+    gather_edge_inflows(Left, tile.neighbours[Left], Right);
+    gather_edge_inflows(Right, tile.neighbours[Right], Left);
+    gather_edge_inflows(Up, tile.neighbours[Up], Down);
+    gather_edge_inflows(Down, tile.neighbours[Down], Up);
+
+    const auto* outflow_left = tile.outflows[Left].data();
+    const auto* outflow_right = tile.outflows[Right].data();
+    const auto* outflow_up = tile.outflows[Up].data();
+    const auto* outflow_down = tile.outflows[Down].data();
+    const auto last = tile_size - 1;
+
+    auto max_depth_change = 0.0f;
+    for(Uint32 y = 0; y < tile_size; y++) {
+        for(Uint32 x = 0; x < tile_size; x++) {
+            const auto i = y * tile_size + x;
+
+            const auto from_left = x > 0 ? outflow_right[i - 1] : tile.edge_inflows[Left][y];
+            const auto from_right = x < last ? outflow_left[i + 1] : tile.edge_inflows[Right][y];
+            const auto from_up = y > 0 ? outflow_down[i - tile_size] : tile.edge_inflows[Up][x];
+            const auto from_down = y < last ? outflow_up[i + tile_size] : tile.edge_inflows[Down][x];
+
+            const auto inflow = from_left + from_right + from_up + from_down;
+            const auto outflow = outflow_left[i] + outflow_right[i] + outflow_up[i] + outflow_down[i];
+
+            const auto old_depth = tile.depths[i];
+            const auto new_depth = Rx::Algorithm::max(old_depth + (inflow - outflow) * settings.time_step, 0.0f);
+            tile.depths[i] = new_depth;
+
+            max_depth_change = Rx::Algorithm::max(max_depth_change, std::abs(new_depth - old_depth));
+        }
+    }
+
+    tile.max_depth_change = max_depth_change;
+    if(max_depth_change > 0) {
+        tile.has_unpublished_changes = true;
+    }
+}
+
+template <typename FuncType>
+void TerrainWaterSimulation::for_each_stepping_tile(FuncType&& func) {
+    // Each worker takes the next tile that nobody has started on, so a few slow tiles don't hold up a whole batch
+    Rx::Concurrency::Atomic<Size> next_tile{0};
+
+    const auto num_tasks = Rx::Algorithm::min(static_cast<Size>(num_threads), stepping_tiles.size());
+    Rx::Concurrency::WaitGroup tasks_finished{num_tasks};
+
+    for(Size task = 0; task < num_tasks; task++) {
+        thread_pool.add([&](int /* thread_id */) {
+            for(auto i = next_tile.fetch_add(1); i < stepping_tiles.size(); i = next_tile.fetch_add(1)) {
+                func(*stepping_tiles[i]);
+            }
+
+            tasks_finished.signal();
+        });
+    }
+
+    tasks_finished.wait();
+}
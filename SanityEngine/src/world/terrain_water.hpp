@@ -0,0 +1,232 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/map.h"
+#include "rx/core/ptr.h"
+#include "rx/core/vector.h"
+
+struct TerrainWaterSettings {
+    /*!
+     * \brief Length of one simulation step, in seconds. Steps are fixed so that the simulation behaves the same at any framerate
+     */
+    Float32 time_step{1.0f / 60.0f};
+
+    Float32 gravity{9.81f};
+
+    /*!
+     * \brief Fraction of each pipe's flow that carries over to the next step. Less than 1 so that waves die down instead of sloshing
+     * forever
+     */
+    Float32 flow_damping{0.995f};
+
+    /*!
+     * \brief A tile whose water depths all change by less than this many meters in a step is calm
+     */
+    Float32 sleep_threshold{0.0001f};
+
+    /*!
+     * \brief Number of steps in a row that a tile must be calm before it goes to sleep
+     */
+    Uint32 num_calm_steps_to_sleep{60};
+};
+
+struct TerrainWaterStepStats {
+    Uint32 num_steps{0};
+
+    /*!
+     * \brief Number of tiles that were updated, summed over every step
+     */
+    Uint32 num_tiles_updated{0};
+
+    /*!
+     * \brief Number of cells that were updated, summed over every step
+     */
+    Uint64 num_cells_updated{0};
+};
+
+/*!
+ * \brief Shallow-water simulation for lakes and rivers on top of the level 0 terrain tiles
+ *
+ * Uses the virtual pipes model: every cell is a column of water connected to its four neighbours by pipes. Each step, the flow through
+ * each pipe accelerates by the difference between the water surfaces at its ends, then the water depths change by the net flow. Cells
+ * are one meter wide, so a tile has one cell per heightmap texel
+ *
+ * Each tile keeps its own copy of its terrain heights and water, so tiles can come and go with the terrain streamer. Water can't flow
+ * into tiles that aren't loaded. A tile's water is dropped when the tile is removed
+ *
+ * Only tiles where water is moving get updated. A tile goes to sleep once its water has been calm for a while, and wakes up when water
+ * flows into it. The awake tiles and their neighbours update in parallel on a thread pool, in two passes per step with a barrier between
+ * them: one that computes each cell's outflow, and one that moves the water. Tiles read the edges of their neighbours' previous pass
+ * into a one-cell halo, so the results don't depend on the number of threads
+ *
+ * The simulation is not thread-safe. Readers on other threads should use the depths from `get_published_depths`, which only change in
+ * `publish`
+ */
+class TerrainWaterSimulation {
+public:
+    /*!
+     * \param tile_size_in Width of a tile, in cells
+     * \param settings_in How the water behaves
+     * \param num_threads_in Number of worker threads to step the tiles on
+     */
+    TerrainWaterSimulation(Uint32 tile_size_in, const TerrainWaterSettings& settings_in, Uint32 num_threads_in);
+
+    TerrainWaterSimulation(const TerrainWaterSimulation& other) = delete;
+    TerrainWaterSimulation& operator=(const TerrainWaterSimulation& other) = delete;
+
+    TerrainWaterSimulation(TerrainWaterSimulation&& old) noexcept = delete;
+    TerrainWaterSimulation& operator=(TerrainWaterSimulation&& old) noexcept = delete;
+
+    ~TerrainWaterSimulation();
+
+    /*!
+     * \brief Starts simulating water on a tile
+     *
+     * \param coord Coordinates of the tile
+     * \param terrain_heights The tile's terrain heights, in rows of `terrain_stride` heights. Only the first `tile_size` rows and columns
+     * are used
+     * \param terrain_stride Number of heights in each row of `terrain_heights`
+     * \param initial_depths `tile_size * tile_size` water depths to start the tile with, in rows. May be empty for a dry tile
+     */
+    void add_tile(const Vec2i& coord,
+                  std::span<const Float32> terrain_heights,
+                  Uint32 terrain_stride,
+                  std::span<const Float32> initial_depths);
+
+    /*!
+     * \brief Stops simulating water on a tile. Its published depths stay valid until the second `publish` after this
+     */
+    void remove_tile(const Vec2i& coord);
+
+    /*!
+     * \brief Pours water onto the cell at a location, and wakes up the cell's tile. Does nothing if the location's tile isn't loaded
+     *
+     * \param location World x and z coordinates of the cell
+     * \param depth How many meters of water to add
+     */
+    void add_water(const Vec2f& location, Float32 depth);
+
+    /*!
+     * \brief Runs as many fixed steps as fit in the time since the last call, up to `max_steps`. Time that doesn't fit in a step carries
+     * over to the next call
+     */
+    TerrainWaterStepStats advance(Float32 delta_time, Uint32 max_steps);
+
+    /*!
+     * \brief Runs one fixed step. Returns the number of tiles that were updated
+     */
+    Uint32 step();
+
+    /*!
+     * \brief Whether any water has moved or any tile has been removed since the last `publish`
+     */
+    [[nodiscard]] bool has_unpublished_changes() const;
+
+    /*!
+     * \brief Copies the current water depths of every tile that changed into a buffer that readers may use
+     *
+     * Each tile has two buffers for readers, which take turns. Only call this when no reader can be using the depths from two `publish`es
+     * ago. Tiles that were removed before the previous `publish` get freed here
+     */
+    void publish();
+
+    /*!
+     * \brief Gets the water depths of a tile as of the last `publish`, or nullptr if the tile isn't loaded
+     *
+     * \return `tile_size * tile_size` depths, in rows along the x axis
+     */
+    [[nodiscard]] const Float32* get_published_depths(const Vec2i& coord) const;
+
+    [[nodiscard]] Uint32 get_num_tiles() const;
+
+    [[nodiscard]] Uint32 get_num_awake_tiles() const;
+
+private:
+    enum TileSide : Uint32 { Left = 0, Right, Up, Down, NumSides };
+
+    struct WaterTile {
+        Vec2i coord;
+
+        WaterTile* neighbours[NumSides]{};
+
+        Rx::Vector<Float32> terrain_heights;
+
+        Rx::Vector<Float32> depths;
+
+        /*!
+         * \brief Flow out of each cell through the pipe on each side, in cubic meters per second
+         */
+        Rx::Vector<Float32> outflows[NumSides];
+
+        /*!
+         * \brief Terrain plus water height of each cell, with a one-cell halo copied from the neighbouring tiles
+         */
+        Rx::Vector<Float32> surface_heights;
+
+        /*!
+         * \brief Flow into the cells along each side from the neighbouring tile
+         */
+        Rx::Vector<Float32> edge_inflows[NumSides];
+
+        Rx::Vector<Float32> published_depths[2];
+
+        Uint32 published_index{0};
+
+        bool has_unpublished_changes{false};
+
+        bool is_awake{false};
+
+        /*!
+         * \brief Whether the tile is being updated this step. Tiles treat neighbours that aren't being updated as walls
+         */
+        bool is_stepping{false};
+
+        Uint32 num_calm_steps{0};
+
+        /*!
+         * \brief Largest change in water depth during the last step
+         */
+        Float32 max_depth_change{0};
+    };
+
+    Uint32 tile_size;
+
+    TerrainWaterSettings settings;
+
+    Uint32 num_threads;
+
+    Rx::Concurrency::ThreadPool thread_pool;
+
+    Rx::Map<Vec2i, Rx::Ptr<WaterTile>> tiles;
+
+    /*!
+     * \brief Tiles that were removed since the last `publish`. The current published depths may still refer to them
+     */
+    Rx::Vector<Rx::Ptr<WaterTile>> removed_tiles;
+
+    /*!
+     * \brief Tiles that were removed before the last `publish`. Freed at the next `publish`
+     */
+    Rx::Vector<Rx::Ptr<WaterTile>> retired_tiles;
+
+    /*!
+     * \brief Tiles being updated this step. Kept around so we don't allocate a new vector every step
+     */
+    Rx::Vector<WaterTile*> stepping_tiles;
+
+    Float32 unsimulated_time{0};
+
+    [[nodiscard]] WaterTile* find_tile(const Vec2i& coord) const;
+
+    void wake(WaterTile& tile);
+
+    void compute_outflows(WaterTile& tile) const;
+
+    void move_water(WaterTile& tile) const;
+
+    template <typename FuncType>
+    void for_each_stepping_tile(FuncType&& func);
+};
@@ -0,0 +1,397 @@
+#include "voxel_chunk.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "rx/core/assert.h"
+
+/*!
+ * \brief Depth of the dirt under a column's top voxel, in voxels
+ */
+constexpr Int32 DIRT_DEPTH = 3;
+
+/*!
+ * \brief Smallest number of bits per voxel that can address a palette of this many entries. Always a power of two, so that indices
+ * don't straddle two words
+ */
+static Uint32 get_bits_for_palette_size(const Size palette_size) {
+    Uint32 bits = 0;
+    while((1ull << bits) < palette_size) {
+        bits = bits == 0 ? 1 : bits * 2;
+    }
+
+    return bits;
+}
+
+static Size get_num_index_words(const Uint32 bits_per_voxel) {
+    return bits_per_voxel == 0 ? 0 : VoxelChunk::NUM_VOXELS / (64 / bits_per_voxel);
+}
+
+VoxelChunk::VoxelChunk(const VoxelMaterial material) {
+    palette.push_back(material);
+    palette_counts.push_back(NUM_VOXELS);
+}
+
+VoxelMaterial VoxelChunk::get(const Uint32 x, const Uint32 y, const Uint32 z) const {
+    return palette[get_palette_index(get_voxel_index(x, y, z))];
+}
+
+bool VoxelChunk::set(const Uint32 x, const Uint32 y, const Uint32 z, const VoxelMaterial material) {
+    const auto voxel_index = get_voxel_index(x, y, z);
+    const auto old_palette_index = get_palette_index(voxel_index);
+    if(palette[old_palette_index] == material) {
+        return false;
+    }
+
+    // If this was the old material's last voxel, the new material can take over its palette entry
+    palette_counts[old_palette_index]--;
+    const auto new_palette_index = get_or_add_palette_entry(material);
+    palette_counts[new_palette_index]++;
+    set_palette_index(voxel_index, new_palette_index);
+
+    return true;
+}
+
+void VoxelChunk::set_all(const std::span<const VoxelMaterial> materials) {
+    RX_ASSERT(materials.size() == NUM_VOXELS, "A chunk needs %u voxels, but got %zu", NUM_VOXELS, materials.size());
+
+    palette.clear();
+    palette_counts.clear();
+
+    // Find the palette first, so the indices only get written once. Neighbouring voxels are usually the same material, so check the last
+    // one before searching the palette
+    Uint32 last_palette_index = 0;
+    for(Uint32 i = 0; i < NUM_VOXELS; i++) {
+        if(!palette.is_empty() && palette[last_palette_index] == materials[i]) {
+            palette_counts[last_palette_index]++;
+            continue;
+        }
+
+        const auto found_index = palette.find(materials[i]);
+        if(found_index == Rx::Vector<VoxelMaterial>::k_npos) {
+            last_palette_index = static_cast<Uint32>(palette.size());
+            palette.push_back(materials[i]);
+            palette_counts.push_back(1);
+        } else {
+            last_palette_index = static_cast<Uint32>(found_index);
+            palette_counts[last_palette_index]++;
+        }
+    }
+
+    bits_per_voxel = get_bits_for_palette_size(palette.size());
+    indices.clear();
+    indices.resize(get_num_index_words(bits_per_voxel), 0);
+    if(bits_per_voxel == 0) {
+        return;
+    }
+
+    last_palette_index = 0;
+    for(Uint32 i = 0; i < NUM_VOXELS; i++) {
+        if(palette[last_palette_index] != materials[i]) {
+            last_palette_index = static_cast<Uint32>(palette.find(materials[i]));
+        }
+
+        set_palette_index(i, last_palette_index);
+    }
+}
+
+void VoxelChunk::get_all(const std::span<VoxelMaterial> materials) const {
+    RX_ASSERT(materials.size() == NUM_VOXELS, "A chunk has %u voxels, but got room for %zu", NUM_VOXELS, materials.size());
+
+    if(bits_per_voxel == 0) {
+        for(Uint32 i = 0; i < NUM_VOXELS; i++) {
+            materials[i] = palette[0];
+        }
+        return;
+    }
+
+    // Unpack a whole word at a time instead of finding each voxel's word
+    const auto voxels_per_word = 64 / bits_per_voxel;
+    const auto mask = (1ull << bits_per_voxel) - 1;
+    Uint32 voxel_index = 0;
+    for(Size word_index = 0; word_index < indices.size(); word_index++) {
+        auto word = indices[word_index];
+        for(Uint32 i = 0; i < voxels_per_word; i++) {
+            materials[voxel_index] = palette[static_cast<Size>(word & mask)];
+            word >>= bits_per_voxel;
+            voxel_index++;
+        }
+    }
+}
+
+void VoxelChunk::compact() {
+    Rx::Vector<Uint32> remap{palette.size()};
+    Rx::Vector<VoxelMaterial> new_palette;
+    Rx::Vector<Uint32> new_palette_counts;
+    for(Size i = 0; i < palette.size(); i++) {
+        if(palette_counts[i] > 0) {
+            remap[i] = static_cast<Uint32>(new_palette.size());
+            new_palette.push_back(palette[i]);
+            new_palette_counts.push_back(palette_counts[i]);
+        }
+    }
+
+    if(new_palette.size() == palette.size()) {
+        return;
+    }
+
+    const auto new_bits_per_voxel = get_bits_for_palette_size(new_palette.size());
+
+    Rx::Vector<Uint64> new_indices{get_num_index_words(new_bits_per_voxel)};
+    if(new_bits_per_voxel > 0) {
+        const auto voxels_per_word = 64 / new_bits_per_voxel;
+        for(Uint32 i = 0; i < NUM_VOXELS; i++) {
+            const auto new_index = static_cast<Uint64>(remap[get_palette_index(i)]);
+            new_indices[i / voxels_per_word] |= new_index << (i % voxels_per_word * new_bits_per_voxel);
+        }
+    }
+
+    palette = Rx::Utility::move(new_palette);
+    palette_counts = Rx::Utility::move(new_palette_counts);
+    indices = Rx::Utility::move(new_indices);
+    bits_per_voxel = new_bits_per_voxel;
+}
+
+bool VoxelChunk::is_uniform() const {
+    Uint32 num_used_entries = 0;
+    palette_counts.each_fwd([&](const Uint32 count) {
+        if(count > 0) {
+            num_used_entries++;
+        }
+    });
+
+    return num_used_entries == 1;
+}
+
+bool VoxelChunk::is_empty() const {
+    const auto air_index = palette.find(VoxelMaterial::Air);
+    return air_index != Rx::Vector<VoxelMaterial>::k_npos && palette_counts[air_index] == NUM_VOXELS;
+}
+
+Uint32 VoxelChunk::get_num_palette_entries() const { return static_cast<Uint32>(palette.size()); }
+
+Uint32 VoxelChunk::get_bits_per_voxel() const { return bits_per_voxel; }
+
+Size VoxelChunk::get_num_bytes() const {
+    return palette.size() * (sizeof(VoxelMaterial) + sizeof(Uint32)) + indices.size() * sizeof(Uint64);
+}
+
+/*!
+ * \brief Start of a serialized chunk. The palette follows, then the indices
+ */
+struct SerializedVoxelChunkHeader {
+    Uint16 bits_per_voxel;
+
+    Uint16 num_palette_entries;
+};
+
+void VoxelChunk::serialize(Rx::Vector<Byte>& bytes) const {
+    const auto header = SerializedVoxelChunkHeader{.bits_per_voxel = static_cast<Uint16>(bits_per_voxel),
+                                                   .num_palette_entries = static_cast<Uint16>(palette.size())};
+
+    const auto palette_size = palette.size() * sizeof(VoxelMaterial);
+    const auto indices_size = indices.size() * sizeof(Uint64);
+
+    const auto start = bytes.size();
+    bytes.resize(start + sizeof(header) + palette_size + indices_size);
+
+    auto* destination = bytes.data() + start;
+    memcpy(destination, &header, sizeof(header));
+    memcpy(destination + sizeof(header), palette.data(), palette_size);
+    memcpy(destination + sizeof(header) + palette_size, indices.data(), indices_size);
+}
+
+Rx::Optional<VoxelChunk> VoxelChunk::deserialize(const std::span<const Byte> bytes) {
+    SerializedVoxelChunkHeader header;
+    if(bytes.size() < sizeof(header)) {
+        return Rx::nullopt;
+    }
+
+    memcpy(&header, bytes.data(), sizeof(header));
+
+    // Chunks always have just enough bits to address their palette
+    if(header.num_palette_entries == 0 || header.bits_per_voxel > 16 ||
+       get_bits_for_palette_size(header.num_palette_entries) != header.bits_per_voxel) {
+        return Rx::nullopt;
+    }
+
+    const auto palette_size = static_cast<Size>(header.num_palette_entries) * sizeof(VoxelMaterial);
+    const auto num_index_words = get_num_index_words(header.bits_per_voxel);
+    if(bytes.size() != sizeof(header) + palette_size + num_index_words * sizeof(Uint64)) {
+        return Rx::nullopt;
+    }
+
+    VoxelChunk chunk;
+    chunk.bits_per_voxel = header.bits_per_voxel;
+    chunk.palette.resize(header.num_palette_entries);
+    chunk.palette_counts.clear();
+    chunk.palette_counts.resize(header.num_palette_entries, 0);
+    chunk.indices.resize(num_index_words);
+
+    memcpy(chunk.palette.data(), bytes.data() + sizeof(header), palette_size);
+    memcpy(chunk.indices.data(), bytes.data() + sizeof(header) + palette_size, num_index_words * sizeof(Uint64));
+
+    // The counts aren't saved, since counting them again also catches indices that are past the end of the palette
+    if(header.bits_per_voxel == 0) {
+        chunk.palette_counts[0] = NUM_VOXELS;
+        return chunk;
+    }
+
+    const Uint32 voxels_per_word = 64u / header.bits_per_voxel;
+    const auto mask = (1ull << header.bits_per_voxel) - 1;
+    for(Size word_index = 0; word_index < num_index_words; word_index++) {
+        auto word = chunk.indices[word_index];
+        for(Uint32 i = 0; i < voxels_per_word; i++) {
+            const auto palette_index = static_cast<Size>(word & mask);
+            if(palette_index >= header.num_palette_entries) {
+                return Rx::nullopt;
+            }
+
+            chunk.palette_counts[palette_index]++;
+            word >>= header.bits_per_voxel;
+        }
+    }
+
+    return chunk;
+}
+
+Uint32 VoxelChunk::get_palette_index(const Uint32 voxel_index) const {
+    if(bits_per_voxel == 0) {
+        return 0;
+    }
+
+    const auto voxels_per_word = 64 / bits_per_voxel;
+    const auto mask = (1ull << bits_per_voxel) - 1;
+
+    return static_cast<Uint32>((indices[voxel_index / voxels_per_word] >> (voxel_index % voxels_per_word * bits_per_voxel)) & mask);
+}
+
+void VoxelChunk::set_palette_index(const Uint32 voxel_index, const Uint32 palette_index) {
+    const auto voxels_per_word = 64 / bits_per_voxel;
+    const auto shift = voxel_index % voxels_per_word * bits_per_voxel;
+    const auto mask = ((1ull << bits_per_voxel) - 1) << shift;
+
+    auto& word = indices[voxel_index / voxels_per_word];
+    word = (word & ~mask) | (static_cast<Uint64>(palette_index) << shift);
+}
+
+Uint32 VoxelChunk::get_or_add_palette_entry(const VoxelMaterial material) {
+    const auto existing_index = palette.find(material);
+    if(existing_index != Rx::Vector<VoxelMaterial>::k_npos) {
+        return static_cast<Uint32>(existing_index);
+    }
+
+    const auto unused_index = palette_counts.find(0u);
+    if(unused_index != Rx::Vector<Uint32>::k_npos) {
+        palette[unused_index] = material;
+        return static_cast<Uint32>(unused_index);
+    }
+
+    palette.push_back(material);
+    palette_counts.push_back(0);
+
+    const auto new_bits_per_voxel = get_bits_for_palette_size(palette.size());
+    if(new_bits_per_voxel != bits_per_voxel) {
+        repack(new_bits_per_voxel);
+    }
+
+    return static_cast<Uint32>(palette.size() - 1);
+}
+
+void VoxelChunk::repack(const Uint32 new_bits_per_voxel) {
+    Rx::Vector<Uint64> new_indices{get_num_index_words(new_bits_per_voxel)};
+    if(new_bits_per_voxel > 0) {
+        const auto voxels_per_word = 64 / new_bits_per_voxel;
+        for(Uint32 i = 0; i < NUM_VOXELS; i++) {
+            new_indices[i / voxels_per_word] |= static_cast<Uint64>(get_palette_index(i)) << (i % voxels_per_word * new_bits_per_voxel);
+        }
+    }
+
+    indices = Rx::Utility::move(new_indices);
+    bits_per_voxel = new_bits_per_voxel;
+}
+
+static Int32 floor_divide(const Int32 value, const Int32 divisor) {
+    const auto quotient = value / divisor;
+    return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+Vec3i get_chunk_containing_voxel(const Vec3i& location) {
+    constexpr auto size = static_cast<Int32>(VoxelChunk::SIZE);
+    return {floor_divide(location.x, size), floor_divide(location.y, size), floor_divide(location.z, size)};
+}
+
+Vec3u get_voxel_in_chunk(const Vec3i& location) {
+    const auto chunk = get_chunk_containing_voxel(location);
+    const auto voxel = location - chunk * static_cast<Int32>(VoxelChunk::SIZE);
+    return {static_cast<Uint32>(voxel.x), static_cast<Uint32>(voxel.y), static_cast<Uint32>(voxel.z)};
+}
+
+VoxelChunk generate_voxel_chunk(const std::span<const Float32> heights,
+                                const Uint32 stride,
+                                const Int32 chunk_y,
+                                const Float32 sea_level) {
+    constexpr auto size = VoxelChunk::SIZE;
+
+    RX_ASSERT(stride >= size && heights.size() >= static_cast<Size>(size - 1) * stride + size,
+              "Need %ux%u heights to fill a chunk, but only got %zu with a stride of %u",
+              size,
+              size,
+              heights.size(),
+              stride);
+
+    // A column's voxels are solid up to the first voxel whose middle is above the terrain
+    Int32 surface_heights[size * size];
+    auto lowest_surface = INT32_MAX;
+    auto highest_surface = INT32_MIN;
+    for(Uint32 z = 0; z < size; z++) {
+        for(Uint32 x = 0; x < size; x++) {
+            const auto surface = static_cast<Int32>(std::floor(heights[z * stride + x] + 0.5f));
+            surface_heights[z * size + x] = surface;
+            lowest_surface = Rx::Algorithm::min(lowest_surface, surface);
+            highest_surface = Rx::Algorithm::max(highest_surface, surface);
+        }
+    }
+
+    const auto bottom = chunk_y * static_cast<Int32>(size);
+    const auto top = bottom + static_cast<Int32>(size);
+
+    // Most chunks are far above or below the surface, and don't need to touch their voxels at all
+    if(bottom >= highest_surface) {
+        return VoxelChunk{VoxelMaterial::Air};
+    }
+    if(top <= lowest_surface - 1 - DIRT_DEPTH) {
+        return VoxelChunk{VoxelMaterial::Stone};
+    }
+
+    Rx::Vector<VoxelMaterial> materials{VoxelChunk::NUM_VOXELS};
+    for(Uint32 z = 0; z < size; z++) {
+        for(Uint32 x = 0; x < size; x++) {
+            const auto surface = surface_heights[z * size + x];
+            const auto top_material = static_cast<Float32>(surface) <= sea_level + 1.0f ? VoxelMaterial::Sand : VoxelMaterial::Grass;
+
+            for(Uint32 y = 0; y < size; y++) {
+                const auto depth = surface - 1 - (bottom + static_cast<Int32>(y));
+
+                auto material = VoxelMaterial::Stone;
+                if(depth < 0) {
+                    material = VoxelMaterial::Air;
+                } else if(depth == 0) {
+                    material = top_material;
+                } else if(depth <= DIRT_DEPTH) {
+                    material = VoxelMaterial::Dirt;
+                }
+
+                materials[VoxelChunk::get_voxel_index(x, y, z)] = material;
+            }
+        }
+    }
+
+    VoxelChunk chunk;
+    chunk.set_all({materials.data(), materials.size()});
+
+    return chunk;
+}
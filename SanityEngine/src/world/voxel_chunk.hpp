@@ -0,0 +1,164 @@
+#pragma once
+
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+/*!
+ * \brief What a voxel is made of. Air is empty space, everything else is solid and opaque
+ *
+ * Chunk vertices store the material, so there may be at most MAX_NUM_CHUNK_VERTEX_MATERIALS of them
+ */
+enum class VoxelMaterial : Uint16 {
+    Air = 0,
+    Stone,
+    Dirt,
+    Grass,
+    Sand,
+};
+
+/*!
+ * \brief A 32x32x32 block of one-meter voxels, palette-compressed
+ *
+ * The chunk keeps a palette of the materials it contains, and each voxel stores an index into the palette with just enough bits to
+ * address every entry: no bits at all when the whole chunk is one material, then 1, 2, 4, 8, or 16 bits. Indices are packed into 64-bit
+ * words and never straddle two words. Most chunks are all air, all stone, or a stretch of surface with a handful of materials, so they
+ * take somewhere between a few bytes and 16 KB instead of the 64 KB that a plain array of materials would take
+ *
+ * Each palette entry counts the voxels that use it. An entry that drops to zero voxels gets reused by the next new material, and
+ * `compact` drops the unused entries and shrinks the indices back down
+ *
+ * Voxels are stored y-major, see `get_voxel_index`. Chunks are not thread-safe, but they're cheap to copy, so worker threads get copies
+ */
+class VoxelChunk {
+public:
+    static constexpr Uint32 SIZE = 32;
+
+    static constexpr Uint32 NUM_VOXELS = SIZE * SIZE * SIZE;
+
+    /*!
+     * \brief Makes a chunk that's all one material
+     */
+    explicit VoxelChunk(VoxelMaterial material = VoxelMaterial::Air);
+
+    [[nodiscard]] VoxelMaterial get(Uint32 x, Uint32 y, Uint32 z) const;
+
+    /*!
+     * \brief Changes one voxel. Returns whether the voxel's material changed
+     */
+    bool set(Uint32 x, Uint32 y, Uint32 z, VoxelMaterial material);
+
+    /*!
+     * \brief Replaces every voxel, and rebuilds the palette with exactly the materials that are used
+     *
+     * \param materials NUM_VOXELS materials, in the order of `get_voxel_index`
+     */
+    void set_all(std::span<const VoxelMaterial> materials);
+
+    /*!
+     * \brief Unpacks every voxel into NUM_VOXELS materials, in the order of `get_voxel_index`
+     */
+    void get_all(std::span<VoxelMaterial> materials) const;
+
+    /*!
+     * \brief Drops the palette entries that no voxel uses, and shrinks the indices if fewer bits can address the palette
+     */
+    void compact();
+
+    /*!
+     * \brief Whether every voxel in the chunk is the same material
+     */
+    [[nodiscard]] bool is_uniform() const;
+
+    /*!
+     * \brief Whether every voxel in the chunk is air
+     */
+    [[nodiscard]] bool is_empty() const;
+
+    /*!
+     * \brief Number of palette entries, including the ones that no voxel uses
+     */
+    [[nodiscard]] Uint32 get_num_palette_entries() const;
+
+    [[nodiscard]] Uint32 get_bits_per_voxel() const;
+
+    /*!
+     * \brief Number of bytes that the palette and the indices take
+     */
+    [[nodiscard]] Size get_num_bytes() const;
+
+    /*!
+     * \brief Appends the chunk's palette and indices to `bytes`, in the form that `deserialize` reads
+     */
+    void serialize(Rx::Vector<Byte>& bytes) const;
+
+    /*!
+     * \brief Reads a chunk that `serialize` wrote
+     *
+     * \return The chunk, or an empty optional if the bytes aren't a valid chunk
+     */
+    [[nodiscard]] static Rx::Optional<VoxelChunk> deserialize(std::span<const Byte> bytes);
+
+    /*!
+     * \brief Index of the voxel at (x, y, z) in the chunk's voxel order
+     */
+    [[nodiscard]] static constexpr Uint32 get_voxel_index(const Uint32 x, const Uint32 y, const Uint32 z) {
+        return (y * SIZE + z) * SIZE + x;
+    }
+
+private:
+    Rx::Vector<VoxelMaterial> palette;
+
+    /*!
+     * \brief Number of voxels that use each palette entry
+     */
+    Rx::Vector<Uint32> palette_counts;
+
+    Rx::Vector<Uint64> indices;
+
+    Uint32 bits_per_voxel{0};
+
+    [[nodiscard]] Uint32 get_palette_index(Uint32 voxel_index) const;
+
+    void set_palette_index(Uint32 voxel_index, Uint32 palette_index);
+
+    /*!
+     * \brief Finds the palette entry for a material, or makes a new one. Grows the indices if the palette outgrows them
+     */
+    [[nodiscard]] Uint32 get_or_add_palette_entry(VoxelMaterial material);
+
+    /*!
+     * \brief Rewrites the indices with a different number of bits per voxel. Every index must fit in the new size
+     */
+    void repack(Uint32 new_bits_per_voxel);
+};
+
+/*!
+ * \brief Coordinates of the chunk that contains a voxel
+ *
+ * \param location World coordinates of the voxel, in meters
+ */
+[[nodiscard]] Vec3i get_chunk_containing_voxel(const Vec3i& location);
+
+/*!
+ * \brief Coordinates of a voxel within its chunk
+ *
+ * \param location World coordinates of the voxel, in meters
+ */
+[[nodiscard]] Vec3u get_voxel_in_chunk(const Vec3i& location);
+
+/*!
+ * \brief Fills a chunk from the terrain's heights
+ *
+ * Each column of voxels is solid up to the terrain's height in the middle of the column. The top voxel is grass, or sand if it's within a
+ * meter of sea level, then there's three meters of dirt, and stone all the way down
+ *
+ * \param heights The terrain heights of the chunk's columns, in rows of `stride` heights. Row z, column x is the height of the chunk's
+ * column at (x, z). Only the first `VoxelChunk::SIZE` rows and columns are used. `fill_tile_heightmap` makes these
+ * \param stride Number of heights in each row of `heights`
+ * \param chunk_y The chunk's y coordinate. It holds the voxels from `chunk_y * VoxelChunk::SIZE` meters up to the next chunk
+ * \param sea_level Height of the sea, in meters
+ */
+[[nodiscard]] VoxelChunk generate_voxel_chunk(std::span<const Float32> heights, Uint32 stride, Int32 chunk_y, Float32 sea_level);
@@ -0,0 +1,217 @@
+#include "voxel_chunk_store.hpp"
+
+#include "Tracy.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/concurrency/scope_lock.h"
+#include "rx/core/log.h"
+
+RX_LOG("VoxelChunkStore", logger);
+
+VoxelChunkStore::VoxelChunkStore(const Uint32 num_threads_in, const VoxelMeshingMethod meshing_method_in)
+    : meshing_method{meshing_method_in}, thread_pool{Rx::Algorithm::max(num_threads_in, 1u), VoxelChunk::SIZE} {}
+
+VoxelChunkStore::~VoxelChunkStore() = default;
+
+void VoxelChunkStore::add_chunk(const Vec3i& coord, VoxelChunk chunk) {
+    if(auto* stored_chunk = chunks.find(coord); stored_chunk != nullptr) {
+        stored_chunk->chunk = Rx::Utility::move(chunk);
+    } else {
+        chunks.insert(coord, StoredChunk{.chunk = Rx::Utility::move(chunk)});
+    }
+
+    mark_dirty(coord);
+    mark_neighbours_dirty(coord);
+}
+
+void VoxelChunkStore::remove_chunk(const Vec3i& coord) {
+    if(!chunks.erase(coord)) {
+        return;
+    }
+
+    mark_neighbours_dirty(coord);
+}
+
+const VoxelChunk* VoxelChunkStore::get_chunk(const Vec3i& coord) const {
+    const auto* stored_chunk = chunks.find(coord);
+    return stored_chunk != nullptr ? &stored_chunk->chunk : nullptr;
+}
+
+VoxelMaterial VoxelChunkStore::get_voxel(const Vec3i& location) const {
+    const auto* chunk = get_chunk(get_chunk_containing_voxel(location));
+    if(chunk == nullptr) {
+        return VoxelMaterial::Air;
+    }
+
+    const auto voxel = get_voxel_in_chunk(location);
+    return chunk->get(voxel.x, voxel.y, voxel.z);
+}
+
+bool VoxelChunkStore::set_voxel(const Vec3i& location, const VoxelMaterial material) {
+    const auto coord = get_chunk_containing_voxel(location);
+    auto* stored_chunk = chunks.find(coord);
+    if(stored_chunk == nullptr) {
+        return false;
+    }
+
+    const auto voxel = get_voxel_in_chunk(location);
+    if(!stored_chunk->chunk.set(voxel.x, voxel.y, voxel.z, material)) {
+        return false;
+    }
+
+    mark_dirty(coord);
+
+    // A voxel on the chunk's edge hides or exposes a face of the neighbour's voxel on the other side
+    for(Uint32 axis = 0; axis < 3; axis++) {
+        if(voxel[axis] == 0) {
+            mark_dirty(coord + get_voxel_face_offset(static_cast<VoxelFace>(axis * 2 + 1)));
+        } else if(voxel[axis] == VoxelChunk::SIZE - 1) {
+            mark_dirty(coord + get_voxel_face_offset(static_cast<VoxelFace>(axis * 2)));
+        }
+    }
+
+    return true;
+}
+
+Uint32 VoxelChunkStore::dispatch_remeshes() {
+    ZoneScoped;
+
+    Uint32 num_dispatched = 0;
+    dirty_chunks.each_fwd([&](const Vec3i& coord) {
+        auto* stored_chunk = chunks.find(coord);
+        if(stored_chunk == nullptr || !stored_chunk->is_dirty) {
+            return;
+        }
+
+        stored_chunk->is_dirty = false;
+
+        // The task gets its own copies of the chunks, so that they may change while it runs. The chunk is always the first copy
+        Rx::Vector<VoxelChunk> chunk_copies;
+        chunk_copies.push_back(stored_chunk->chunk);
+
+        Int32 neighbour_copy_indices[NUM_VOXEL_FACES];
+        for(Uint32 face = 0; face < NUM_VOXEL_FACES; face++) {
+            neighbour_copy_indices[face] = -1;
+            if(const auto* neighbour = get_chunk(coord + get_voxel_face_offset(static_cast<VoxelFace>(face))); neighbour != nullptr) {
+                neighbour_copy_indices[face] = static_cast<Int32>(chunk_copies.size());
+                chunk_copies.push_back(*neighbour);
+            }
+        }
+
+        thread_pool.add([this,
+                         coord,
+                         version = stored_chunk->version,
+                         method = meshing_method,
+                         chunk_copies = Rx::Utility::move(chunk_copies),
+                         neighbour_copy_indices](int /* thread_id */) {
+            VoxelChunkNeighbours neighbours;
+            for(Uint32 face = 0; face < NUM_VOXEL_FACES; face++) {
+                if(neighbour_copy_indices[face] >= 0) {
+                    neighbours.chunks[face] = &chunk_copies[neighbour_copy_indices[face]];
+                }
+            }
+
+            auto mesh = mesh_voxel_chunk(chunk_copies[0], neighbours, method);
+
+            Rx::Concurrency::ScopeLock lock{finished_meshes_mutex};
+            finished_meshes.push_back(FinishedMesh{.coord = coord, .version = version, .mesh = Rx::Utility::move(mesh)});
+            mesh_finished_condition.signal();
+        });
+
+        num_dispatched++;
+    });
+
+    dirty_chunks.clear();
+    num_remeshes_in_flight += num_dispatched;
+
+    if(num_dispatched > 0) {
+        logger->verbose("Dispatched %u chunk remeshes", num_dispatched);
+    }
+
+    return num_dispatched;
+}
+
+Rx::Vector<Vec3i> VoxelChunkStore::collect_meshes() {
+    Rx::Vector<FinishedMesh> meshes;
+    {
+        Rx::Concurrency::ScopeLock lock{finished_meshes_mutex};
+        meshes = Rx::Utility::move(finished_meshes);
+    }
+
+    return store_finished_meshes(meshes);
+}
+
+Rx::Vector<Vec3i> VoxelChunkStore::wait_for_meshes() {
+    ZoneScoped;
+
+    Rx::Vector<FinishedMesh> meshes;
+    {
+        Rx::Concurrency::ScopeLock lock{finished_meshes_mutex};
+        mesh_finished_condition.wait(lock, [&] { return finished_meshes.size() >= num_remeshes_in_flight; });
+        meshes = Rx::Utility::move(finished_meshes);
+    }
+
+    return store_finished_meshes(meshes);
+}
+
+const VoxelChunkMesh* VoxelChunkStore::get_mesh(const Vec3i& coord) const {
+    const auto* stored_chunk = chunks.find(coord);
+    return stored_chunk != nullptr && stored_chunk->has_mesh ? &stored_chunk->mesh : nullptr;
+}
+
+Size VoxelChunkStore::get_num_chunks() const { return chunks.size(); }
+
+Size VoxelChunkStore::get_num_pending_remeshes() const { return dirty_chunks.size() + num_remeshes_in_flight; }
+
+Size VoxelChunkStore::get_num_chunk_bytes() const {
+    Size num_bytes = 0;
+    chunks.each_value([&](const StoredChunk& stored_chunk) { num_bytes += stored_chunk.chunk.get_num_bytes(); });
+
+    return num_bytes;
+}
+
+void VoxelChunkStore::mark_dirty(const Vec3i& coord) {
+    auto* stored_chunk = chunks.find(coord);
+    if(stored_chunk == nullptr) {
+        return;
+    }
+
+    stored_chunk->version = next_version++;
+    if(!stored_chunk->is_dirty) {
+        stored_chunk->is_dirty = true;
+        dirty_chunks.push_back(coord);
+    }
+}
+
+void VoxelChunkStore::mark_neighbours_dirty(const Vec3i& coord) {
+    for(Uint32 face = 0; face < NUM_VOXEL_FACES; face++) {
+        mark_dirty(coord + get_voxel_face_offset(static_cast<VoxelFace>(face)));
+    }
+}
+
+Rx::Vector<Vec3i> VoxelChunkStore::store_finished_meshes(Rx::Vector<FinishedMesh>& meshes) {
+    Rx::Vector<Vec3i> changed_chunks;
+
+    num_remeshes_in_flight -= static_cast<Uint32>(meshes.size());
+
+    meshes.each_fwd([&](FinishedMesh& finished_mesh) {
+        auto* stored_chunk = chunks.find(finished_mesh.coord);
+        if(stored_chunk == nullptr || stored_chunk->version != finished_mesh.version) {
+            return;
+        }
+
+        stored_chunk->mesh = Rx::Utility::move(finished_mesh.mesh);
+        stored_chunk->has_mesh = true;
+        changed_chunks.push_back(finished_mesh.coord);
+    });
+
+    return changed_chunks;
+}
+
+Vec3i get_voxel_face_offset(const VoxelFace face) {
+    const auto axis = static_cast<Uint32>(face) / 2;
+
+    auto offset = Vec3i{0, 0, 0};
+    offset[axis] = static_cast<Uint32>(face) % 2 == 0 ? 1 : -1;
+
+    return offset;
+}
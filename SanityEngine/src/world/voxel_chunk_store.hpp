@@ -0,0 +1,179 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/condition_variable.h"
+#include "rx/core/concurrency/mutex.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/map.h"
+#include "rx/core/vector.h"
+#include "world/voxel_chunk.hpp"
+#include "world/voxel_meshing.hpp"
+
+/*!
+ * \brief Owns voxel chunks, and keeps their meshes up to date on worker threads
+ *
+ * Adding a chunk or editing one of its voxels marks the chunk dirty, along with the neighbours whose edge faces it might have exposed or
+ * hidden. `dispatch_remeshes` hands every dirty chunk to the thread pool along with copies of the chunk and its neighbours, so the chunks
+ * may keep changing while the meshing tasks run. Palette compression keeps those copies small. `collect_meshes` picks up the meshes that
+ * finished. A mesh whose chunk changed again after its task started gets dropped, since the newer change has a remesh of its own coming
+ *
+ * Only the chunks that changed get remeshed, so editing a voxel costs one mesh, or up to four when the voxel is on a chunk's edge or
+ * corner
+ *
+ * Everything but the meshing tasks runs on the thread that owns the store
+ */
+class VoxelChunkStore {
+public:
+    /*!
+     * \param num_threads_in Number of worker threads to mesh the chunks on
+     * \param meshing_method_in How to mesh the chunks
+     */
+    explicit VoxelChunkStore(Uint32 num_threads_in, VoxelMeshingMethod meshing_method_in = VoxelMeshingMethod::Greedy);
+
+    VoxelChunkStore(const VoxelChunkStore& other) = delete;
+    VoxelChunkStore& operator=(const VoxelChunkStore& other) = delete;
+
+    VoxelChunkStore(VoxelChunkStore&& old) noexcept = delete;
+    VoxelChunkStore& operator=(VoxelChunkStore&& old) noexcept = delete;
+
+    /*!
+     * \brief Waits for every meshing task to finish
+     */
+    ~VoxelChunkStore();
+
+    /*!
+     * \brief Adds a chunk, or replaces the chunk that's already at its coordinates
+     */
+    void add_chunk(const Vec3i& coord, VoxelChunk chunk);
+
+    /*!
+     * \brief Removes a chunk and its mesh. Its neighbours get remeshed, since the faces that touched it are visible now
+     */
+    void remove_chunk(const Vec3i& coord);
+
+    [[nodiscard]] const VoxelChunk* get_chunk(const Vec3i& coord) const;
+
+    /*!
+     * \brief Gets the material of a voxel, or air if its chunk isn't loaded
+     *
+     * \param location World coordinates of the voxel, in meters
+     */
+    [[nodiscard]] VoxelMaterial get_voxel(const Vec3i& location) const;
+
+    /*!
+     * \brief Changes a voxel, and marks the chunks whose meshes it affects as dirty
+     *
+     * \param location World coordinates of the voxel, in meters
+     * \param material The voxel's new material
+     *
+     * \return Whether the voxel changed. Voxels in chunks that aren't loaded can't change
+     */
+    bool set_voxel(const Vec3i& location, VoxelMaterial material);
+
+    /*!
+     * \brief Starts remeshing every dirty chunk on the thread pool
+     *
+     * \return The number of chunks that started remeshing
+     */
+    Uint32 dispatch_remeshes();
+
+    /*!
+     * \brief Moves the meshes that finished since the last call into the store
+     *
+     * \return Coordinates of the chunks whose meshes changed
+     */
+    Rx::Vector<Vec3i> collect_meshes();
+
+    /*!
+     * \brief Blocks until every remesh that's been dispatched has finished, then collects their meshes
+     *
+     * \return Coordinates of the chunks whose meshes changed
+     */
+    Rx::Vector<Vec3i> wait_for_meshes();
+
+    /*!
+     * \brief Gets a chunk's latest mesh, or nullptr if the chunk hasn't been meshed yet
+     */
+    [[nodiscard]] const VoxelChunkMesh* get_mesh(const Vec3i& coord) const;
+
+    [[nodiscard]] Size get_num_chunks() const;
+
+    /*!
+     * \brief Number of chunks that are waiting to be dispatched, plus the number of remeshes that haven't been collected yet
+     */
+    [[nodiscard]] Size get_num_pending_remeshes() const;
+
+    /*!
+     * \brief Number of bytes that the chunks' palettes and indices take
+     */
+    [[nodiscard]] Size get_num_chunk_bytes() const;
+
+private:
+    struct StoredChunk {
+        VoxelChunk chunk;
+
+        /*!
+         * \brief Changes every time the chunk or one of the neighbours that its mesh depends on changes
+         */
+        Uint64 version{0};
+
+        bool is_dirty{false};
+
+        bool has_mesh{false};
+
+        VoxelChunkMesh mesh;
+    };
+
+    struct FinishedMesh {
+        Vec3i coord;
+
+        /*!
+         * \brief Version of the chunk that the mesh was built from
+         */
+        Uint64 version{0};
+
+        VoxelChunkMesh mesh;
+    };
+
+    VoxelMeshingMethod meshing_method;
+
+    Rx::Map<Vec3i, StoredChunk> chunks;
+
+    Rx::Vector<Vec3i> dirty_chunks;
+
+    /*!
+     * \brief Versions come from one counter for the whole store, so that a chunk that gets removed and added again can't be mistaken
+     * for the old chunk by a task that's still meshing the old one
+     */
+    Uint64 next_version{1};
+
+    /*!
+     * \brief Number of remeshes that have been dispatched but not collected
+     */
+    Uint32 num_remeshes_in_flight{0};
+
+    Rx::Concurrency::Mutex finished_meshes_mutex;
+
+    Rx::Concurrency::ConditionVariable mesh_finished_condition;
+
+    /*!
+     * \brief Meshes that the tasks finished. Guarded by `finished_meshes_mutex`
+     */
+    Rx::Vector<FinishedMesh> finished_meshes;
+
+    /*!
+     * \brief Declared last, so that it gets destroyed first and its tasks finish before the rest of the store goes away
+     */
+    Rx::Concurrency::ThreadPool thread_pool;
+
+    void mark_dirty(const Vec3i& coord);
+
+    void mark_neighbours_dirty(const Vec3i& coord);
+
+    Rx::Vector<Vec3i> store_finished_meshes(Rx::Vector<FinishedMesh>& meshes);
+};
+
+/*!
+ * \brief Offset from a chunk to the neighbour across one of its faces
+ */
+[[nodiscard]] Vec3i get_voxel_face_offset(VoxelFace face);
@@ -0,0 +1,250 @@
+#include "voxel_meshing.hpp"
+
+#include <cstring>
+
+#include "Tracy.hpp"
+
+constexpr Uint32 CHUNK_SIZE = VoxelChunk::SIZE;
+
+/*!
+ * \brief Width of a chunk plus a one-voxel border of its neighbours' voxels on each side
+ */
+constexpr Uint32 PADDED_CHUNK_SIZE = CHUNK_SIZE + 2;
+
+constexpr Uint32 NUM_PADDED_VOXELS = PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE;
+
+/*!
+ * \brief Distance between neighbouring voxels along each axis in the padded voxels, which are y-major like the chunk's voxels
+ */
+constexpr Uint32 PADDED_AXIS_STRIDES[3] = {1, PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE, PADDED_CHUNK_SIZE};
+
+/*!
+ * \brief Scratch memory for meshing a chunk, owned by a single thread
+ */
+struct ThreadMeshingScratch {
+    Rx::Vector<VoxelMaterial> chunk_voxels{VoxelChunk::NUM_VOXELS};
+
+    /*!
+     * \brief The chunk's voxels, surrounded by its neighbours' voxels. Only the voxels that share a face with the chunk get filled in
+     */
+    Rx::Vector<VoxelMaterial> padded_voxels{NUM_PADDED_VOXELS};
+
+    /*!
+     * \brief Material of each visible face in the slice that's being meshed, or air if the face isn't visible
+     */
+    Rx::Vector<VoxelMaterial> face_mask{CHUNK_SIZE * CHUNK_SIZE};
+};
+
+static thread_local ThreadMeshingScratch thread_meshing_scratch;
+
+/*!
+ * \brief Index of a position in the padded voxels. The chunk's voxels start at (1, 1, 1)
+ */
+static Uint32 get_padded_index(const Vec3u& padded_position) {
+    return padded_position.x * PADDED_AXIS_STRIDES[0] + padded_position.y * PADDED_AXIS_STRIDES[1] +
+           padded_position.z * PADDED_AXIS_STRIDES[2];
+}
+
+/*!
+ * \brief Index of one of the chunk's voxels in the padded voxels
+ */
+static Uint32 get_padded_voxel_index(const Vec3u& voxel) { return get_padded_index(voxel + 1u); }
+
+/*!
+ * \brief Copies a chunk and the layers of its neighbours that touch it into the padded voxels
+ */
+static void fill_padded_voxels(ThreadMeshingScratch& scratch, const VoxelChunk& chunk, const VoxelChunkNeighbours& neighbours) {
+    auto& padded_voxels = scratch.padded_voxels;
+    for(Uint32 i = 0; i < NUM_PADDED_VOXELS; i++) {
+        padded_voxels[i] = VoxelMaterial::Air;
+    }
+
+    chunk.get_all({scratch.chunk_voxels.data(), scratch.chunk_voxels.size()});
+    for(Uint32 y = 0; y < CHUNK_SIZE; y++) {
+        for(Uint32 z = 0; z < CHUNK_SIZE; z++) {
+            memcpy(padded_voxels.data() + get_padded_voxel_index({0, y, z}),
+                   scratch.chunk_voxels.data() + VoxelChunk::get_voxel_index(0, y, z),
+                   CHUNK_SIZE * sizeof(VoxelMaterial));
+        }
+    }
+
+    for(Uint32 face = 0; face < NUM_VOXEL_FACES; face++) {
+        const auto* neighbour = neighbours.chunks[face];
+        if(neighbour == nullptr) {
+            continue;
+        }
+
+        const auto axis = face / 2;
+        const auto u_axis = (axis + 1) % 3;
+        const auto v_axis = (axis + 2) % 3;
+        const auto is_positive = face % 2 == 0;
+
+        for(Uint32 v = 0; v < CHUNK_SIZE; v++) {
+            for(Uint32 u = 0; u < CHUNK_SIZE; u++) {
+                // The neighbour's voxel on the far side of the face, and where it goes in the border
+                Vec3u neighbour_voxel;
+                neighbour_voxel[axis] = is_positive ? 0 : CHUNK_SIZE - 1;
+                neighbour_voxel[u_axis] = u;
+                neighbour_voxel[v_axis] = v;
+
+                Vec3u padded_position;
+                padded_position[axis] = is_positive ? PADDED_CHUNK_SIZE - 1 : 0;
+                padded_position[u_axis] = u + 1;
+                padded_position[v_axis] = v + 1;
+
+                padded_voxels[get_padded_index(padded_position)] = neighbour->get(neighbour_voxel.x, neighbour_voxel.y, neighbour_voxel.z);
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Adds a quad that covers a rectangle of faces in a slice
+ *
+ * \param face The face that the quad is on
+ * \param slice Position of the voxels along the face's axis
+ * \param u Position of the rectangle's first corner along the slice's first axis
+ * \param v Position of the rectangle's first corner along the slice's second axis
+ * \param width Size of the rectangle along the slice's first axis
+ * \param height Size of the rectangle along the slice's second axis
+ */
+static void add_quad(VoxelChunkMesh& mesh,
+                     const Uint32 face,
+                     const Uint32 slice,
+                     const Uint32 u,
+                     const Uint32 v,
+                     const Uint32 width,
+                     const Uint32 height,
+                     const VoxelMaterial material) {
+    const auto axis = face / 2;
+    const auto u_axis = (axis + 1) % 3;
+    const auto v_axis = (axis + 2) % 3;
+    const auto is_positive = face % 2 == 0;
+
+    const auto make_corner = [&](const Uint32 corner_u, const Uint32 corner_v) {
+        Vec3u position;
+        position[axis] = is_positive ? slice + 1 : slice;
+        position[u_axis] = corner_u;
+        position[v_axis] = corner_v;
+
+        return make_chunk_vertex(position, static_cast<VoxelFace>(face), static_cast<Uint32>(material));
+    };
+
+    // The slice's axes are ordered so that u cross v points along the positive face's normal. Walking from u to v would wind the quad
+    // counter-clockwise as seen from the positive side, so positive faces walk from v to u instead
+    if(is_positive) {
+        mesh.vertices.push_back(make_corner(u, v));
+        mesh.vertices.push_back(make_corner(u, v + height));
+        mesh.vertices.push_back(make_corner(u + width, v + height));
+        mesh.vertices.push_back(make_corner(u + width, v));
+    } else {
+        mesh.vertices.push_back(make_corner(u, v));
+        mesh.vertices.push_back(make_corner(u + width, v));
+        mesh.vertices.push_back(make_corner(u + width, v + height));
+        mesh.vertices.push_back(make_corner(u, v + height));
+    }
+}
+
+/*!
+ * \brief Turns the visible faces in a slice's face mask into quads, and clears the mask
+ */
+static void mesh_face_mask(VoxelChunkMesh& mesh,
+                           Rx::Vector<VoxelMaterial>& face_mask,
+                           const Uint32 face,
+                           const Uint32 slice,
+                           const VoxelMeshingMethod method) {
+    for(Uint32 v = 0; v < CHUNK_SIZE; v++) {
+        for(Uint32 u = 0; u < CHUNK_SIZE; u++) {
+            const auto material = face_mask[v * CHUNK_SIZE + u];
+            if(material == VoxelMaterial::Air) {
+                continue;
+            }
+
+            Uint32 width = 1;
+            Uint32 height = 1;
+            if(method == VoxelMeshingMethod::Greedy) {
+                while(u + width < CHUNK_SIZE && face_mask[v * CHUNK_SIZE + u + width] == material) {
+                    width++;
+                }
+
+                for(; v + height < CHUNK_SIZE; height++) {
+                    const auto* row = face_mask.data() + (v + height) * CHUNK_SIZE + u;
+                    auto row_matches = true;
+                    for(Uint32 i = 0; i < width; i++) {
+                        if(row[i] != material) {
+                            row_matches = false;
+                            break;
+                        }
+                    }
+
+                    if(!row_matches) {
+                        break;
+                    }
+                }
+            }
+
+            for(Uint32 row = v; row < v + height; row++) {
+                for(Uint32 column = u; column < u + width; column++) {
+                    face_mask[row * CHUNK_SIZE + column] = VoxelMaterial::Air;
+                }
+            }
+
+            add_quad(mesh, face, slice, u, v, width, height, material);
+
+            u += width - 1;
+        }
+    }
+}
+
+VoxelChunkMesh mesh_voxel_chunk(const VoxelChunk& chunk, const VoxelChunkNeighbours& neighbours, const VoxelMeshingMethod method) {
+    ZoneScoped;
+
+    VoxelChunkMesh mesh;
+    if(chunk.is_empty()) {
+        return mesh;
+    }
+
+    auto& scratch = thread_meshing_scratch;
+    fill_padded_voxels(scratch, chunk, neighbours);
+
+    const auto& padded_voxels = scratch.padded_voxels;
+    auto& face_mask = scratch.face_mask;
+
+    for(Uint32 face = 0; face < NUM_VOXEL_FACES; face++) {
+        const auto axis = face / 2;
+        const auto u_axis = (axis + 1) % 3;
+        const auto v_axis = (axis + 2) % 3;
+
+        // Offset from a voxel to the voxel on the other side of the face
+        const auto neighbour_offset = face % 2 == 0 ? static_cast<Int32>(PADDED_AXIS_STRIDES[axis]) :
+                                                      -static_cast<Int32>(PADDED_AXIS_STRIDES[axis]);
+
+        for(Uint32 slice = 0; slice < CHUNK_SIZE; slice++) {
+            auto has_visible_faces = false;
+            for(Uint32 v = 0; v < CHUNK_SIZE; v++) {
+                Vec3u voxel;
+                voxel[axis] = slice;
+                voxel[u_axis] = 0;
+                voxel[v_axis] = v;
+
+                auto voxel_index = get_padded_voxel_index(voxel);
+                for(Uint32 u = 0; u < CHUNK_SIZE; u++) {
+                    const auto material = padded_voxels[voxel_index];
+                    const auto is_visible = material != VoxelMaterial::Air &&
+                                            padded_voxels[voxel_index + neighbour_offset] == VoxelMaterial::Air;
+
+                    face_mask[v * CHUNK_SIZE + u] = is_visible ? material : VoxelMaterial::Air;
+                    has_visible_faces |= is_visible;
+
+                    voxel_index += PADDED_AXIS_STRIDES[u_axis];
+                }
+            }
+
+            if(has_visible_faces) {
+                mesh_face_mask(mesh, face_mask, face, slice, method);
+            }
+        }
+    }
+
+    return mesh;
+}
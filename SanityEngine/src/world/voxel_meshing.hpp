@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rhi/chunk_vertex.hpp"
+#include "rx/core/vector.h"
+#include "world/voxel_chunk.hpp"
+
+/*!
+ * \brief The chunks that touch a chunk's faces, indexed by VoxelFace. May be nullptr for chunks that aren't loaded, which count as air
+ */
+struct VoxelChunkNeighbours {
+    const VoxelChunk* chunks[NUM_VOXEL_FACES]{};
+};
+
+struct VoxelChunkMesh {
+    /*!
+     * \brief Four vertices for each quad. Draw them with the shared quad index pattern from `get_chunk_quad_index`
+     */
+    Rx::Vector<ChunkVertex> vertices;
+
+    [[nodiscard]] Uint32 get_num_quads() const { return static_cast<Uint32>(vertices.size() / 4); }
+
+    [[nodiscard]] Uint32 get_num_triangles() const { return get_num_quads() * 2; }
+};
+
+enum class VoxelMeshingMethod {
+    /*!
+     * \brief Merges neighbouring faces with the same material and normal into rectangles
+     */
+    Greedy,
+
+    /*!
+     * \brief One quad for every visible face. Only useful as a baseline for the greedy mesher
+     */
+    Naive,
+};
+
+/*!
+ * \brief Builds the mesh for a chunk's visible faces
+ *
+ * A face is visible when its voxel is solid and the voxel on the other side of it is air. The voxels on the other side of the chunk's
+ * faces come from its neighbours
+ *
+ * The greedy mesher sweeps through the chunk one slice at a time for each of the six face directions. It gathers the visible faces in the
+ * slice into a mask, then repeatedly takes the first face left in the mask, grows it along the slice's first axis while the faces have the
+ * same material, grows that row along the second axis while every face in the next row matches, and emits the rectangle as one quad.
+ * Terrain chunks are mostly big flat areas of one material, so this makes many times fewer quads than one per face
+ *
+ * Quads wind the same way as the terrain's triangles: clockwise when seen from outside the voxel. Vertex positions are relative to the
+ * chunk's minimum corner
+ *
+ * Safe to call from any number of threads at once, as long as nobody changes the chunks while it runs
+ */
+[[nodiscard]] VoxelChunkMesh mesh_voxel_chunk(const VoxelChunk& chunk, const VoxelChunkNeighbours& neighbours, VoxelMeshingMethod method);
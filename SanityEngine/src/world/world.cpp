@@ -1,20 +1,59 @@
 #include "world.hpp"
 
+#include <cmath>
+#include <thread>
+
 #include "Tracy.hpp"
 #include "adapters/rex/rex_wrapper.hpp"
 #include "core/components.hpp"
 #include "core/types.hpp"
 #include "loading/mesh_loading.hpp"
+#include "renderer/render_components.hpp"
 #include "rhi/render_device.hpp"
+#include "rx/console/variable.h"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
 #include "rx/core/filesystem/directory.h"
 #include "rx/core/log.h"
-#include "rx/core/prng/mt19937.h"
+#include "rx/core/time/stop_watch.h"
 #include "rx/math/vec2.h"
 #include "sanity_engine.hpp"
+#include "world/generation/world_benchmarks.hpp"
+#include "world/generation/world_generation.hpp"
 
 RX_LOG("World", logger);
 RX_LOG("ChunkMeshGenTaskDispatcher", logger_dispatch);
 
+RX_CONSOLE_SVAR(cvar_benchmarks,
+                "t.Benchmarks",
+                "Comma-separated names of the world generation benchmarks to run when creating a world, or \"all\". "
+                "`SanityWorldGen --help` lists them",
+                "");
+
+RX_CONSOLE_SVAR(cvar_save_directory,
+                "w.SaveDirectory",
+                "Directory to save worlds in. Each world seed gets its own directory of region files in here",
+                "saves");
+
+RX_CONSOLE_FVAR(cvar_save_flush_interval,
+                "w.SaveFlushInterval",
+                "Seconds between background writes of the world save regions that changed",
+                0.1f,
+                600.0f,
+                5.0f);
+
+RX_CONSOLE_FVAR(cvar_save_region_unload_distance,
+                "w.SaveRegionUnloadDistance",
+                "Distance from the player, in meters, past which world save regions get unloaded once they've been written",
+                256.0f,
+                65536.0f,
+                2048.0f);
+
+RX_CONSOLE_BVAR(cvar_voxel_chunks_enabled,
+                "w.VoxelChunks",
+                "Whether to build voxel chunks from the level 0 terrain tiles and draw them on top of the heightmap terrain",
+                false);
+
 Rx::Ptr<World> World::create(const WorldParameters& params,
                              const entt::entity player,
                              SynchronizedResource<entt::registry>& registry,
@@ -23,94 +62,252 @@ Rx::Ptr<World> World::create(const WorldParameters& params,
 
     logger->info("Creating world with seed %d", params.seed);
 
-    auto noise_generator = Rx::Ptr<FastNoiseSIMD>{RX_SYSTEM_ALLOCATOR, FastNoiseSIMD::NewFastNoiseSIMD(params.seed)};
+    const auto noise_config = terraingen::get_world_noise_config(params);
+
+    // Creating this generator on the main thread also initializes FastNoiseSIMD's static data before any tile generation tasks make their
+    // own generators
+    auto noise_generator = noise_config.create_generator();
 
-    // Settings gotten from messing around in the demo application. High chance these should be tuned in-game
-    noise_generator->SetNoiseType(FastNoiseSIMD::PerlinFractal);
-    noise_generator->SetFrequency(1.0f / 64.0f);
-    noise_generator->SetFractalType(FastNoiseSIMD::FBM);
-    noise_generator->SetFractalOctaves(10);
-    noise_generator->SetFractalLacunarity(2);
-    noise_generator->SetFractalGain(0.5f);
+    Rx::Vector<terraingen::WorldBenchmark> benchmarks;
+    if(!terraingen::find_world_benchmarks(cvar_benchmarks->get().data(), benchmarks)) {
+        logger->warning("t.Benchmarks names benchmarks that don't exist");
+    }
 
-    auto terrain_data = Terrain::generate_terrain(*noise_generator, params, renderer);
+    benchmarks.each_fwd([&](const terraingen::WorldBenchmark benchmark) {
+        terraingen::run_world_benchmark(benchmark,
+                                        params,
+                                        {.tile_size = Terrain::TILE_SIZE,
+                                         .save_directory = Rx::String::format("%s/benchmark", cvar_save_directory->get())});
+    });
 
     const auto min_terrain_height = params.min_terrain_depth_under_ocean;
     const auto max_terrain_height = params.min_terrain_depth_under_ocean + params.max_ocean_depth + params.max_height_above_sea_level;
+
+    auto terrain_data = Terrain::generate_terrain(params, renderer);
+
     terrain_data.size = TerrainSize{params.height / 2, params.width / 2, min_terrain_height, max_terrain_height};
     ;
 
     generate_climate_data(terrain_data, params, renderer);
 
-    auto terrain = Rx::make_ptr<Terrain>(RX_SYSTEM_ALLOCATOR, terrain_data, renderer, *noise_generator, registry);
+    classify_ecotypes(terrain_data, params);
+
+    generate_derived_maps(terrain_data);
+
+    auto save = Rx::make_ptr<WorldSave>(RX_SYSTEM_ALLOCATOR,
+                                        WorldSaveCreateInfo{.directory = Rx::String::format("%s/world_%d",
+                                                                                            cvar_save_directory->get(),
+                                                                                            params.seed),
+                                                            .tile_size = Terrain::TILE_SIZE,
+                                                            .region_unload_distance = cvar_save_region_unload_distance->get(),
+                                                            .flush_interval = cvar_save_flush_interval->get()});
+
+    auto terrain = Rx::make_ptr<Terrain>(RX_SYSTEM_ALLOCATOR, terrain_data, renderer, noise_config, registry, *save);
 
     return Rx::make_ptr<World>(RX_SYSTEM_ALLOCATOR,
                                glm::uvec2{params.width, params.height},
-                               Rx::Utility::move(noise_generator),
+                               std::move(noise_generator),
                                player,
                                registry,
                                renderer,
-                               Rx::Utility::move(terrain));
+                               Rx::Utility::move(terrain),
+                               Rx::Utility::move(save),
+                               terraingen::get_sea_level(params));
 }
 
 World::World(const glm::uvec2& size_in,
-             Rx::Ptr<FastNoiseSIMD> noise_generator_in,
+             std::unique_ptr<FastNoiseSIMD> noise_generator_in,
              const entt::entity player_in,
              SynchronizedResource<entt::registry>& registry_in,
              renderer::Renderer& renderer_in,
-             Rx::Ptr<Terrain> terrain_in)
+             Rx::Ptr<Terrain> terrain_in,
+             Rx::Ptr<WorldSave> save_in,
+             const Float32 sea_level_in)
     : size{size_in},
-      noise_generator{Rx::Utility::move(noise_generator_in)},
+      noise_generator{std::move(noise_generator_in)},
       player{player_in},
       registry{&registry_in},
       renderer{&renderer_in},
-      terrain{Rx::Utility::move(terrain_in)} {}
+      save{Rx::Utility::move(save_in)},
+      terrain{Rx::Utility::move(terrain_in)},
+      sea_level{sea_level_in} {
+    renderer->create_chunk_mesh_store(MAX_VERTICES_PER_CHUNK_MESH, MAX_NUM_CHUNKS);
+
+    voxel_chunks = Rx::make_ptr<VoxelChunkStore>(RX_SYSTEM_ALLOCATOR, Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
+}
 
 void World::tick(const Float32 delta_time) {
     ZoneScoped;
 
-    {
-        auto locked_registry = registry->lock();
-        const auto& player_transform = locked_registry->get<TransformComponent>(player);
-        terrain->load_terrain_around_player(player_transform);
-    }
+    // Copy the player's transform so we don't hold the registry lock while loading terrain. Evicting tiles needs to lock the registry
+    const auto player_transform = registry->lock()->get<TransformComponent>(player);
+    terrain->load_terrain_around_player(player_transform, delta_time);
+
+    save->tick(Vec3f{player_transform.location.x, player_transform.location.y, player_transform.location.z}, delta_time);
 
     terrain->tick(delta_time);
 
+    update_voxel_chunks();
+
     tick_script_components(delta_time);
 }
 
 Terrain& World::get_terrain() const { return *terrain; }
 
+WorldSave& World::get_save() const { return *save; }
+
+VoxelChunkStore& World::get_voxel_chunks() const { return *voxel_chunks; }
+
+bool World::set_voxel(const Vec3i& location, const VoxelMaterial material) {
+    if(!voxel_chunks->set_voxel(location, material)) {
+        return false;
+    }
+
+    // Rx::Set::insert doesn't check for duplicates
+    const auto coord = get_chunk_containing_voxel(location);
+    if(edited_voxel_chunks.find(coord) == nullptr) {
+        edited_voxel_chunks.insert(coord);
+    }
+
+    return true;
+}
+
 void World::generate_climate_data(TerrainData& terrain_data, const WorldParameters& params, renderer::Renderer& renderer) {
     ZoneScoped;
 
     /*
-     * Runs a basic climate simulation on the the heightmap
-     *
-     * We upload the heightmap to the GPU to run the climate sim in a compute shader
+     * Runs a basic climate simulation on the the heightmap, on the CPU so that biome generation can read the results directly
      *
-     * Climate sim outputs are humidity, wind direction and strength, temperature range
+     * Climate sim outputs are humidity, wind direction and strength, soil moisture, and temperature
      *
      * Wind is based on atmospheric circulation. The wind currents in Sanity Engine are very similar to the wind currents on Earth. After
-     * computing the atmospheric circulation, the compute pass looks for features in the heightmap that would block the wind - mountains,
-     * mostly. We search along the wind direction, looking for the horizon of the terrain. The closer and higher that horizon is, the more
-     * wind it'll block. Wind gets output into a RGBA32F texture. The RGB holds the wind direction and strength - length of the vector is
-     * the wind's speed in kmph
+     * computing the atmospheric circulation, we look for features in the heightmap that would block the wind - mountains, mostly. We
+     * search along the wind direction, looking for the horizon of the terrain. The closer and higher that horizon is, the more wind it'll
+     * block
      *
      * Once we've determined wind speed and direction, we calculate humidity. There's a lot of humidity directly over water, then we give it
-     * is 10km (or so) blur, then smear humidity along wind direction. Mountains will be able to block humidity in some way - probably
-     * something about decreasing humidity amount by height and slope of the terrain is passes over? Humidity gets stored in a R8 texture
+     * a blur, then smear humidity along wind direction. Air that climbs over mountains rains out some of its humidity on the way up
      *
-     * Temperature range is based on latitude and wind direction. Latitude gives base temperature range - dot product multiplied by
-     * temperature range at the equator - then we take wind and humidity into account. Humid winds blowing off the ocean lower the upper
-     * part of the temperature range, while humidity that isn't from a body of water will both raise and lower max temperature. Temperature
-     * range gets saved to a RG8 texture - min in the red, max in the green
+     * Soil moisture comes from the humidity, with steep slopes shedding more of their water
      *
-     * After that process is finished, Sanity Engine runs more compute shaders to calculate other things -
+     * Temperature starts from the latitude, gets carried along the wind like the humidity, and falls with altitude
      *
-     * After the computations are done, we copy those textures back to the CPU so that they can be used for biome generation
+     * See terraingen::compute_climate for the details
      */
+
+    auto climate = terraingen::compute_world_climate({terrain_data.heightmap.data(), terrain_data.heightmap.size()},
+                                                     {terrain_data.water_depths.data(), terrain_data.water_depths.size()},
+                                                     params,
+                                                     Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
+
+    auto total_milliseconds = 0.0;
+    climate.stage_timings.each_fwd([&](const terraingen::ClimateStageTiming& timing) {
+        logger->info("Climate stage '%s' took %f ms", timing.name, timing.milliseconds);
+        total_milliseconds += timing.milliseconds;
+    });
+    logger->info("Generated the climate in %f ms", total_milliseconds);
+
+    terrain_data.wind_map = Rx::Utility::move(climate.wind);
+    terrain_data.humidity_map = Rx::Utility::move(climate.humidity);
+    terrain_data.soil_moisture = Rx::Utility::move(climate.soil_moisture);
+    terrain_data.temperature_map = Rx::Utility::move(climate.temperature);
+
+    if(terrain_data.wind_map.is_empty()) {
+        return;
+    }
+
+    // The wind texture's RGB is a 3D wind vector, which blows along the ground
+    Rx::Vector<Vec4f> wind_texels{terrain_data.wind_map.size()};
+    for(Size i = 0; i < wind_texels.size(); i++) {
+        const auto& wind = terrain_data.wind_map[i];
+        wind_texels[i] = Vec4f{wind.x, 0, wind.y, 0};
+    }
+
+    auto& device = renderer.get_render_device();
+    auto commands = device.create_command_list();
+    commands->SetName(L"World::generate_climate_data");
+
+    terrain_data.wind_map_handle = renderer.create_image({.name = "Wind Map",
+                                                          .usage = renderer::ImageUsage::SampledImage,
+                                                          .format = renderer::ImageFormat::Rgba32F,
+                                                          .width = params.width,
+                                                          .height = params.height},
+                                                         wind_texels.data(),
+                                                         commands);
+
+    terrain_data.humidity_map_handle = renderer.create_image({.name = "Humidity Map",
+                                                              .usage = renderer::ImageUsage::SampledImage,
+                                                              .format = renderer::ImageFormat::R32F,
+                                                              .width = params.width,
+                                                              .height = params.height},
+                                                             terrain_data.humidity_map.data(),
+                                                             commands);
+
+    terrain_data.soil_moisture_handle = renderer.create_image({.name = "Soil Moisture Map",
+                                                               .usage = renderer::ImageUsage::SampledImage,
+                                                               .format = renderer::ImageFormat::R32F,
+                                                               .width = params.width,
+                                                               .height = params.height},
+                                                              terrain_data.soil_moisture.data(),
+                                                              commands);
+
+    terrain_data.temperature_map_handle = renderer.create_image({.name = "Temperature Map",
+                                                                 .usage = renderer::ImageUsage::SampledImage,
+                                                                 .format = renderer::ImageFormat::R32F,
+                                                                 .width = params.width,
+                                                                 .height = params.height},
+                                                                terrain_data.temperature_map.data(),
+                                                                commands);
+
+    device.submit_command_list(Rx::Utility::move(commands));
+}
+
+void World::classify_ecotypes(TerrainData& terrain_data, const WorldParameters& params) {
+    ZoneScoped;
+
+    Rx::Time::StopWatch timer;
+    timer.start();
+    terrain_data.ecotype_map = terraingen::classify_world_ecotypes(params,
+                                                                   {terrain_data.heightmap.data(), terrain_data.heightmap.size()},
+                                                                   {terrain_data.water_depths.data(), terrain_data.water_depths.size()},
+                                                                   {terrain_data.river_mask.data(), terrain_data.river_mask.size()},
+                                                                   {terrain_data.humidity_map.data(), terrain_data.humidity_map.size()},
+                                                                   {terrain_data.soil_moisture.data(), terrain_data.soil_moisture.size()});
+    timer.stop();
+
+    Size ecotype_texels[environment::NUM_ECOTYPES]{};
+    terrain_data.ecotype_map.ecotypes.each_fwd(
+        [&](const environment::Ecotype ecotype) { ecotype_texels[static_cast<Uint32>(ecotype)]++; });
+
+    logger->info("Classified the world's ecotypes in %f ms", timer.elapsed().total_seconds() * 1000.0);
+    for(Uint32 ecotype = 0; ecotype < environment::NUM_ECOTYPES; ecotype++) {
+        const auto name = environment::to_string(static_cast<environment::Ecotype>(ecotype));
+        logger->verbose("%s covers %zu texels", name, ecotype_texels[ecotype]);
+    }
+}
+
+void World::generate_derived_maps(TerrainData& terrain_data) {
+    ZoneScoped;
+
+    const auto& ecotypes = terrain_data.ecotype_map;
+    if(ecotypes.is_empty()) {
+        return;
+    }
+
+    Rx::Time::StopWatch timer;
+    timer.start();
+    auto derived_maps = terraingen::derive_world_maps(ecotypes,
+                                                      {terrain_data.humidity_map.data(), terrain_data.humidity_map.size()},
+                                                      Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u));
+    timer.stop();
+
+    logger->info("Derived the distance to water and groundwater maps on %ux%u texels in %f ms",
+                 ecotypes.width,
+                 ecotypes.depth,
+                 timer.elapsed().total_seconds() * 1000.0);
+
+    terrain_data.water_distance = Rx::Utility::move(derived_maps.water_distance);
+    terrain_data.groundwater = Rx::Utility::move(derived_maps.groundwater);
 }
 
 void World::load_environment_objects(const Rx::String& environment_objects_folder) {
@@ -136,9 +333,14 @@ void World::load_environment_objects(const Rx::String& environment_objects_folde
             // For not, just yeet FBXs into memory
             const auto filename = item.name();
             if(filename.ends_with(".fbx")) {
-                const auto imported_mesh = import_mesh(filepath, commands, *renderer);
+                auto imported_mesh = import_mesh(filepath, commands, *renderer);
                 if(imported_mesh) {
                     loaded_anything = true;
+
+                    // Without an asset format there's nowhere to say how the object should be placed, so it gets the defaults
+                    const auto mesh_id = static_cast<Uint32>(environment_meshes.size());
+                    environment_meshes.push_back(Rx::Utility::move(*imported_mesh));
+                    terrain->get_object_placer().add_object(environment::EnvironmentObject{.mesh_file_path = filepath}, mesh_id);
                 }
             }
         }
@@ -158,3 +360,200 @@ void World::tick_script_components(Float32 delta_time) {
     //     }
     // });
 }
+
+void World::update_voxel_chunks() {
+    ZoneScoped;
+
+    free_released_chunk_meshes();
+
+    Rx::Vector<TerrainTileHeights> loaded_tiles;
+    Rx::Vector<Vec2i> evicted_tiles;
+    terrain->collect_level_0_tile_changes(loaded_tiles, evicted_tiles);
+
+    if(cvar_voxel_chunks_enabled->get()) {
+        // A tile that was evicted and loaded again has new heights, so drop its old chunks before building the new ones
+        evicted_tiles.each_fwd([&](const Vec2i& tile_coord) { unload_tile_voxel_chunks(tile_coord); });
+        loaded_tiles.each_fwd([&](const TerrainTileHeights& tile) { load_tile_voxel_chunks(tile); });
+
+    } else if(tile_voxel_chunks.size() > 0) {
+        Rx::Vector<Vec2i> tile_coords;
+        tile_voxel_chunks.each_key([&](const Vec2i& tile_coord) { tile_coords.push_back(tile_coord); });
+        tile_coords.each_fwd([&](const Vec2i& tile_coord) { unload_tile_voxel_chunks(tile_coord); });
+    }
+
+    save_edited_voxel_chunks();
+
+    voxel_chunks->dispatch_remeshes();
+
+    const auto changed_chunks = voxel_chunks->collect_meshes();
+    if(!changed_chunks.is_empty()) {
+        upload_voxel_chunk_meshes(changed_chunks);
+    }
+}
+
+void World::load_tile_voxel_chunks(const TerrainTileHeights& tile) {
+    ZoneScoped;
+
+    constexpr auto chunk_size = static_cast<Int32>(VoxelChunk::SIZE);
+    constexpr auto grid_size = Terrain::TILE_SIZE + 1;
+    constexpr auto columns_per_side = static_cast<Int32>(Terrain::TILE_SIZE / VoxelChunk::SIZE);
+
+    if(tile.heights.size() != static_cast<Size>(grid_size) * grid_size) {
+        logger->error("Tile (%d, %d) has %zu heights instead of %ux%u",
+                      tile.coord.x,
+                      tile.coord.y,
+                      tile.heights.size(),
+                      grid_size,
+                      grid_size);
+        return;
+    }
+
+    // Only stack chunks from the tile's lowest height to its highest. The stone below them is never seen
+    auto min_height = tile.heights[0];
+    auto max_height = tile.heights[0];
+    tile.heights.each_fwd([&](const Float32 height) {
+        min_height = Rx::Algorithm::min(min_height, height);
+        max_height = Rx::Algorithm::max(max_height, height);
+    });
+
+    const auto lowest_chunk_y = static_cast<Int32>(std::floor(min_height / chunk_size));
+    const auto highest_chunk_y = static_cast<Int32>(std::floor(max_height / chunk_size));
+
+    Rx::Vector<Vec3i> chunk_coords;
+    for(Int32 column_z = 0; column_z < columns_per_side; column_z++) {
+        for(Int32 column_x = 0; column_x < columns_per_side; column_x++) {
+            const auto first_height = static_cast<Size>(column_z * chunk_size) * grid_size + column_x * chunk_size;
+            const auto column_heights = std::span<const Float32>{tile.heights.data() + first_height, tile.heights.size() - first_height};
+            const auto column_coord = tile.coord * columns_per_side + Vec2i{column_x, column_z};
+
+            for(auto chunk_y = lowest_chunk_y; chunk_y <= highest_chunk_y; chunk_y++) {
+                const auto coord = Vec3i{column_coord.x, chunk_y, column_coord.y};
+                if(auto saved_chunk = save->load_chunk(coord)) {
+                    voxel_chunks->add_chunk(coord, Rx::Utility::move(*saved_chunk));
+                } else {
+                    voxel_chunks->add_chunk(coord, generate_voxel_chunk(column_heights, grid_size, chunk_y, sea_level));
+                }
+                chunk_coords.push_back(coord);
+            }
+        }
+    }
+
+    logger->verbose("Built %zu voxel chunks for tile (%d, %d)", chunk_coords.size(), tile.coord.x, tile.coord.y);
+
+    tile_voxel_chunks.insert(tile.coord, Rx::Utility::move(chunk_coords));
+}
+
+void World::unload_tile_voxel_chunks(const Vec2i& tile_coord) {
+    const auto* chunk_coords = tile_voxel_chunks.find(tile_coord);
+    if(chunk_coords == nullptr) {
+        return;
+    }
+
+    // Save the edits before the chunks go away
+    save_edited_voxel_chunks();
+
+    chunk_coords->each_fwd([&](const Vec3i& coord) {
+        voxel_chunks->remove_chunk(coord);
+        release_voxel_chunk_mesh(coord);
+    });
+
+    tile_voxel_chunks.erase(tile_coord);
+}
+
+void World::save_edited_voxel_chunks() {
+    if(edited_voxel_chunks.is_empty()) {
+        return;
+    }
+
+    ZoneScoped;
+
+    edited_voxel_chunks.each([&](const Vec3i& coord) {
+        if(const auto* chunk = voxel_chunks->get_chunk(coord)) {
+            save->save_chunk(coord, *chunk);
+        }
+    });
+
+    edited_voxel_chunks.clear();
+}
+
+void World::upload_voxel_chunk_meshes(const Rx::Vector<Vec3i>& changed_chunks) {
+    ZoneScoped;
+
+    auto* chunk_mesh_store = renderer->get_chunk_mesh_store();
+    const auto material = terrain->get_material();
+
+    auto& device = renderer->get_render_device();
+    auto commands = device.create_command_list();
+    commands->SetName(L"World::upload_voxel_chunk_meshes");
+
+    chunk_mesh_store->begin_adding_chunks(commands.get());
+
+    changed_chunks.each_fwd([&](const Vec3i& coord) {
+        // The GPU might still be drawing the chunk's old mesh, so it gets a new slot instead of overwriting the old one
+        release_voxel_chunk_mesh(coord);
+
+        const auto* mesh = voxel_chunks->get_mesh(coord);
+        if(mesh == nullptr || mesh->vertices.is_empty()) {
+            return;
+        }
+
+        const auto chunk_mesh = chunk_mesh_store->add_chunk(mesh->vertices, commands.get());
+        if(!chunk_mesh) {
+            logger->error("No room for voxel chunk (%d, %d, %d) in the chunk mesh store, it won't be drawn", coord.x, coord.y, coord.z);
+            return;
+        }
+
+        // Chunk vertices are relative to the chunk's minimum corner
+        const auto origin = coord * static_cast<Int32>(VoxelChunk::SIZE);
+        const auto chunk_transform = TransformComponent{
+            .location = {static_cast<Float32>(origin.x), static_cast<Float32>(origin.y), static_cast<Float32>(origin.z)}};
+
+        auto locked_registry = registry->lock();
+        const auto entity = locked_registry->create();
+        locked_registry->emplace<renderer::ChunkRenderableComponent>(entity, *chunk_mesh, material);
+        locked_registry->emplace<TransformComponent>(entity, chunk_transform);
+
+        voxel_chunk_entities.insert(coord, entity);
+    });
+
+    chunk_mesh_store->end_adding_chunks(commands.get());
+
+    device.submit_command_list(Rx::Utility::move(commands));
+}
+
+void World::release_voxel_chunk_mesh(const Vec3i& coord) {
+    const auto* entity = voxel_chunk_entities.find(coord);
+    if(entity == nullptr) {
+        return;
+    }
+
+    {
+        auto locked_registry = registry->lock();
+        const auto& chunk = locked_registry->get<renderer::ChunkRenderableComponent>(*entity);
+        pending_chunk_mesh_frees.push_back(
+            {.mesh = chunk.mesh, .frames_until_free = renderer->get_render_device().get_max_num_gpu_frames()});
+        locked_registry->destroy(*entity);
+    }
+
+    voxel_chunk_entities.erase(coord);
+}
+
+void World::free_released_chunk_meshes() {
+    if(pending_chunk_mesh_frees.is_empty()) {
+        return;
+    }
+
+    auto* chunk_mesh_store = renderer->get_chunk_mesh_store();
+
+    Rx::Vector<PendingChunkMeshFree> still_pending;
+    pending_chunk_mesh_frees.each_fwd([&](PendingChunkMeshFree& pending_free) {
+        if(pending_free.frames_until_free == 0) {
+            chunk_mesh_store->free_chunk(pending_free.mesh);
+        } else {
+            pending_free.frames_until_free--;
+            still_pending.push_back(pending_free);
+        }
+    });
+
+    pending_chunk_mesh_frees = Rx::Utility::move(still_pending);
+}
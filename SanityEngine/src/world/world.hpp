@@ -1,74 +1,63 @@
 #pragma once
 
+#include <memory>
+
 #include "core/types.hpp"
 #include "entt/entity/fwd.hpp"
 #include "entt/entity/observer.hpp"
+#include "renderer/mesh.hpp"
+#include "rhi/chunk_mesh_store.hpp"
+#include "rx/core/map.h"
+#include "rx/core/set.h"
 #include "rx/core/types.h"
 #include "rx/core/vector.h"
 #include "world/terrain.hpp"
+#include "world/voxel_chunk_store.hpp"
+#include "world/world_parameters.hpp"
+#include "world/world_save.hpp"
 
 namespace renderer {
     class Renderer;
 }
 
-/*!
- * \brief Parameters for generating SanityEngine's world
- */
-struct WorldParameters {
-    /*!
-     * \brief RNG seed to use for this world. The same seed will generate exactly the same world every time it's used
-     */
-    Uint32 seed;
-
+class World {
+public:
     /*!
-     * \brief Height of the world, in meters
-     *
-     * Height is the distance from the north end to the south end
+     * \brief Maximum number of voxel chunk meshes that may be drawn at once. Chunks that are all air or all solid don't have a mesh
      */
-    Uint32 height;
+    static constexpr Uint32 MAX_NUM_CHUNKS = 1 << 8;
 
     /*!
-     * \brief Width of the world, in meters
+     * \brief Number of vertices that a voxel chunk's mesh may have. Greedy meshes of terrain chunks have a few thousand
      */
-    Uint32 width;
+    static constexpr Uint32 MAX_VERTICES_PER_CHUNK_MESH = 1 << 13;
 
     /*!
-     * \brief Maximum depth of the ocean, in meters
+     * \brief Created a world with the provided parameters
      */
-    Uint32 max_ocean_depth;
+    static Rx::Ptr<World> create(const WorldParameters& params,
+                                 entt::entity player,
+                                 SynchronizedResource<entt::registry>& registry,
+                                 renderer::Renderer& renderer);
 
     /*!
-     * \brief Distance from the lowest point in the ocean to the bedrock layer
+     * \brief Decides the ecotype of each texel of the world's heightmap, once the climate model has run
      */
-    Uint32 min_terrain_depth_under_ocean;
-
-    /*
-     * \brief Height above sea level of the tallest possible mountain
-     *
-     * If this value is negative, no land will be above the ocean and you'll be playing in a world that's 100% water. This may or may not be
-     * interesting, so I'm leaving it here an an option
-     */
-    int32_t max_height_above_sea_level;
-};
-
-class World {
-public:
-    static constexpr Uint32 MAX_NUM_CHUNKS = 1 << 8;
+    static void classify_ecotypes(TerrainData& terrain_data, const WorldParameters& params);
 
     /*!
-     * \brief Created a world with the provided parameters
+     * \brief Derives the distance to water and groundwater maps from the ecotypes and the climate
      */
-    static Rx::Ptr<World> create(const WorldParameters& params,
-                                 entt::entity player,
-                                 SynchronizedResource<entt::registry>& registry,
-                                 renderer::Renderer& renderer);
+    static void generate_derived_maps(TerrainData& terrain_data);
 
     explicit World(const glm::uvec2& size_in,
-                   Rx::Ptr<FastNoiseSIMD> noise_generator_in,
+                   std::unique_ptr<FastNoiseSIMD> noise_generator_in,
                    entt::entity player_in,
                    SynchronizedResource<entt::registry>& registry_in,
                    renderer::Renderer& renderer_in,
-                   Rx::Ptr<Terrain> terrain_in);
+                   Rx::Ptr<Terrain> terrain_in,
+                   Rx::Ptr<WorldSave> save_in,
+                   Float32 sea_level_in);
 
     void load_environment_objects(const Rx::String& environment_objects_folder);
 
@@ -76,7 +65,36 @@ public:
 
     [[nodiscard]] Terrain& get_terrain() const;
 
+    /*!
+     * \brief Region files that the world's voxel chunks and terrain tiles get saved to and loaded from
+     */
+    [[nodiscard]] WorldSave& get_save() const;
+
+    /*!
+     * \brief Voxel chunks that get built from the level 0 terrain tiles while `w.VoxelChunks` is on
+     */
+    [[nodiscard]] VoxelChunkStore& get_voxel_chunks() const;
+
+    /*!
+     * \brief Changes a voxel, and remeshes the chunks that it touches and saves its chunk on the next tick
+     *
+     * \param location World coordinates of the voxel, in meters
+     * \param material The voxel's new material
+     *
+     * \return Whether the voxel changed. Voxels in chunks that aren't loaded can't change
+     */
+    bool set_voxel(const Vec3i& location, VoxelMaterial material);
+
 private:
+    /*!
+     * \brief A voxel chunk mesh that was replaced or unloaded, but which the GPU might still be rendering
+     */
+    struct PendingChunkMeshFree {
+        renderer::ChunkMesh mesh;
+
+        Uint32 frames_until_free;
+    };
+
     /*!
      * \brief Runs the Sanity Engine's climate model on the provided world data
      */
@@ -84,7 +102,7 @@ private:
 
     glm::uvec2 size;
 
-    Rx::Ptr<FastNoiseSIMD> noise_generator;
+    std::unique_ptr<FastNoiseSIMD> noise_generator;
 
     entt::entity player;
 
@@ -94,7 +112,69 @@ private:
 
     renderer::Renderer* renderer;
 
+    /*!
+     * \brief Declared before the terrain, so that it outlives the terrain that loads and saves tiles through it
+     */
+    Rx::Ptr<WorldSave> save;
+
     Rx::Ptr<Terrain> terrain;
 
+    Float32 sea_level;
+
+    Rx::Ptr<VoxelChunkStore> voxel_chunks;
+
+    /*!
+     * \brief Coordinates of the voxel chunks that were built from each level 0 terrain tile
+     */
+    Rx::Map<Vec2i, Rx::Vector<Vec3i>> tile_voxel_chunks;
+
+    /*!
+     * \brief Entity that draws each voxel chunk whose mesh is in the chunk mesh store
+     */
+    Rx::Map<Vec3i, entt::entity> voxel_chunk_entities;
+
+    Rx::Vector<PendingChunkMeshFree> pending_chunk_mesh_frees;
+
+    /*!
+     * \brief Voxel chunks that `set_voxel` changed since they were last saved
+     */
+    Rx::Set<Vec3i> edited_voxel_chunks;
+
+    /*!
+     * \brief Meshes of the environment objects. An object's mesh ID is the index of its mesh in here
+     */
+    Rx::Vector<renderer::MeshObject> environment_meshes;
+
     void tick_script_components(Float32 delta_time);
+
+    /*!
+     * \brief Builds voxel chunks for the level 0 tiles that loaded, drops the ones for the tiles that were evicted, and uploads the chunk
+     * meshes that finished
+     */
+    void update_voxel_chunks();
+
+    /*!
+     * \brief Builds the voxel chunks that cover a tile's heights, from the lowest height in the tile up to the highest. Chunks that are in
+     * the world save are loaded instead of built
+     */
+    void load_tile_voxel_chunks(const TerrainTileHeights& tile);
+
+    void unload_tile_voxel_chunks(const Vec2i& tile_coord);
+
+    /*!
+     * \brief Saves the voxel chunks that were edited since they were last saved, so the edits outlive the chunks
+     */
+    void save_edited_voxel_chunks();
+
+    void upload_voxel_chunk_meshes(const Rx::Vector<Vec3i>& changed_chunks);
+
+    /*!
+     * \brief Destroys a chunk's entity, and schedules its mesh to be freed once the GPU is done with it
+     */
+    void release_voxel_chunk_mesh(const Vec3i& coord);
+
+    /*!
+     * \brief Returns released chunk meshes to the chunk mesh store once no in-flight frame can be using them
+     */
+    void free_released_chunk_meshes();
 };
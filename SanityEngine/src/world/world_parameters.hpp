@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "core/types.hpp"
+
+/*!
+ * \brief Parameters for generating SanityEngine's world
+ */
+struct WorldParameters {
+    /*!
+     * \brief RNG seed to use for this world. The same seed will generate exactly the same world every time it's used
+     */
+    Uint32 seed;
+
+    /*!
+     * \brief Height of the world, in meters
+     *
+     * Height is the distance from the north end to the south end
+     */
+    Uint32 height;
+
+    /*!
+     * \brief Width of the world, in meters
+     */
+    Uint32 width;
+
+    /*!
+     * \brief Maximum depth of the ocean, in meters
+     */
+    Uint32 max_ocean_depth;
+
+    /*!
+     * \brief Distance from the lowest point in the ocean to the bedrock layer
+     */
+    Uint32 min_terrain_depth_under_ocean;
+
+    /*
+     * \brief Height above sea level of the tallest possible mountain
+     *
+     * If this value is negative, no land will be above the ocean and you'll be playing in a world that's 100% water. This may or may not be
+     * interesting, so I'm leaving it here an an option
+     */
+    int32_t max_height_above_sea_level;
+};
@@ -0,0 +1,335 @@
+#include "world_save.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/concurrency/scope_lock.h"
+#include "rx/core/log.h"
+
+RX_LOG("WorldSave", logger);
+
+static Int32 floor_divide(const Int32 value, const Int32 divisor) {
+    const auto quotient = value / divisor;
+    return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+static Uint32 floor_modulo(const Int32 value, const Int32 divisor) {
+    return static_cast<Uint32>(value - floor_divide(value, divisor) * divisor);
+}
+
+static WorldRegionKey get_chunk_region(const Vec3i& coord) {
+    constexpr auto region_size = static_cast<Int32>(WorldSave::CHUNK_REGION_SIZE);
+    return {.kind = WorldRegionKind::VoxelChunks,
+            .coord = {floor_divide(coord.x, region_size), floor_divide(coord.y, region_size), floor_divide(coord.z, region_size)}};
+}
+
+/*!
+ * \brief Slot of a chunk in its region. Slots are y-major, like the voxels in a chunk
+ */
+static Uint32 get_chunk_slot(const Vec3i& coord) {
+    constexpr auto region_size = static_cast<Int32>(WorldSave::CHUNK_REGION_SIZE);
+    return (floor_modulo(coord.y, region_size) * WorldSave::CHUNK_REGION_SIZE + floor_modulo(coord.z, region_size)) *
+               WorldSave::CHUNK_REGION_SIZE +
+           floor_modulo(coord.x, region_size);
+}
+
+static WorldRegionKey get_tile_region(const Vec2i& coord) {
+    constexpr auto region_size = static_cast<Int32>(WorldSave::TILE_REGION_SIZE);
+    return {.kind = WorldRegionKind::TerrainTiles, .coord = {floor_divide(coord.x, region_size), 0, floor_divide(coord.y, region_size)}};
+}
+
+static Uint32 get_tile_slot(const Vec2i& coord) {
+    constexpr auto region_size = static_cast<Int32>(WorldSave::TILE_REGION_SIZE);
+    return floor_modulo(coord.y, region_size) * WorldSave::TILE_REGION_SIZE + floor_modulo(coord.x, region_size);
+}
+
+bool WorldRegionKey::operator==(const WorldRegionKey& other) const { return kind == other.kind && coord == other.coord; }
+
+WorldSave::WorldSave(const WorldSaveCreateInfo& create_info)
+    : directory{create_info.directory},
+      tile_size{create_info.tile_size},
+      region_unload_distance{create_info.region_unload_distance},
+      flush_interval{create_info.flush_interval},
+      thread_pool{Rx::Algorithm::max(create_info.num_flush_threads, 1u), 16} {
+    std::error_code error;
+    std::filesystem::create_directories(directory.data(), error);
+    if(error) {
+        logger->error("Could not create the world save directory %s: %s", directory, error.message().c_str());
+    }
+
+    logger->info("Opened world save %s", directory);
+}
+
+WorldSave::~WorldSave() {
+    flush_dirty_regions();
+    wait_for_flushes();
+}
+
+void WorldSave::save_chunk(const Vec3i& coord, const VoxelChunk& chunk) {
+    Rx::Vector<Byte> data;
+    chunk.serialize(data);
+
+    save_entry(get_chunk_region(coord), get_chunk_slot(coord), {data.data(), data.size()});
+}
+
+Rx::Optional<VoxelChunk> WorldSave::load_chunk(const Vec3i& coord) {
+    Rx::Vector<Byte> data;
+    if(!load_entry(get_chunk_region(coord), get_chunk_slot(coord), data)) {
+        return Rx::nullopt;
+    }
+
+    auto chunk = VoxelChunk::deserialize({data.data(), data.size()});
+    if(!chunk) {
+        logger->error("Saved chunk (%d, %d, %d) isn't a valid chunk", coord.x, coord.y, coord.z);
+    }
+
+    return chunk;
+}
+
+void WorldSave::save_tile(const Vec2i& coord, const std::span<const Float32> heights) {
+    const auto num_heights = heights.size();
+    Rx::Vector<Byte> data{num_heights * sizeof(Float32)};
+    const auto* height_bytes = reinterpret_cast<const Byte*>(heights.data());
+    for(Size i = 0; i < num_heights; i++) {
+        for(Size byte = 0; byte < sizeof(Float32); byte++) {
+            data[byte * num_heights + i] = height_bytes[i * sizeof(Float32) + byte];
+        }
+    }
+
+    save_entry(get_tile_region(coord), get_tile_slot(coord), {data.data(), data.size()});
+}
+
+Rx::Optional<Rx::Vector<Float32>> WorldSave::load_tile(const Vec2i& coord) {
+    Rx::Vector<Byte> data;
+    if(!load_entry(get_tile_region(coord), get_tile_slot(coord), data)) {
+        return Rx::nullopt;
+    }
+
+    if(data.size() % sizeof(Float32) != 0) {
+        logger->error("Saved tile (%d, %d) isn't a whole number of heights", coord.x, coord.y);
+        return Rx::nullopt;
+    }
+
+    const auto num_heights = data.size() / sizeof(Float32);
+    Rx::Vector<Float32> heights{num_heights};
+    auto* height_bytes = reinterpret_cast<Byte*>(heights.data());
+    for(Size i = 0; i < num_heights; i++) {
+        for(Size byte = 0; byte < sizeof(Float32); byte++) {
+            height_bytes[i * sizeof(Float32) + byte] = data[byte * num_heights + i];
+        }
+    }
+
+    return heights;
+}
+
+void WorldSave::tick(const Vec3f& player_location, const Float32 delta_time) {
+    ZoneScoped;
+
+    collect_flushes();
+
+    time_since_flush += delta_time;
+    if(time_since_flush >= flush_interval) {
+        flush_dirty_regions();
+        time_since_flush = 0;
+    }
+
+    unload_distant_regions(player_location);
+}
+
+Uint32 WorldSave::flush_dirty_regions() {
+    ZoneScoped;
+
+    collect_flushes();
+
+    Uint32 num_dispatched = 0;
+    regions.each_pair([&](const WorldRegionKey& key, Region& region) {
+        if(region.is_flushing || region.version == region.saved_version) {
+            return;
+        }
+
+        region.is_flushing = true;
+
+        // The write shares the region's entries. Saving into the region while the write runs copies them first, so the write always sees
+        // the entries as they were right now
+        thread_pool.add([this,
+                         key,
+                         version = region.version,
+                         path = get_region_path(key),
+                         entries = std::shared_ptr<const Rx::Vector<RegionEntry>>{region.entries}](int /* thread_id */) {
+            const auto succeeded = RegionFile::write(path, *entries);
+
+            Rx::Concurrency::ScopeLock lock{finished_flushes_mutex};
+            finished_flushes.push_back(FinishedFlush{.key = key, .version = version, .succeeded = succeeded});
+            flush_finished_condition.signal();
+        });
+
+        num_dispatched++;
+    });
+
+    num_flushes_in_flight += num_dispatched;
+
+    if(num_dispatched > 0) {
+        logger->verbose("Flushing %u regions", num_dispatched);
+    }
+
+    return num_dispatched;
+}
+
+void WorldSave::wait_for_flushes() {
+    ZoneScoped;
+
+    Rx::Vector<FinishedFlush> flushes;
+    {
+        Rx::Concurrency::ScopeLock lock{finished_flushes_mutex};
+        flush_finished_condition.wait(lock, [&] { return finished_flushes.size() >= num_flushes_in_flight; });
+        flushes = Rx::Utility::move(finished_flushes);
+    }
+
+    store_finished_flushes(flushes);
+}
+
+void WorldSave::unload_distant_regions(const Vec3f& location) {
+    ZoneScoped;
+
+    Rx::Vector<WorldRegionKey> distant_regions;
+    regions.each_pair([&](const WorldRegionKey& key, const Region& region) {
+        if(region.is_flushing || region.version != region.saved_version) {
+            return;
+        }
+
+        const auto region_width = key.kind == WorldRegionKind::VoxelChunks ?
+                                      static_cast<Float32>(CHUNK_REGION_SIZE * VoxelChunk::SIZE) :
+                                      static_cast<Float32>(TILE_REGION_SIZE * tile_size);
+        const auto center = Vec2f{(static_cast<Float32>(key.coord.x) + 0.5f) * region_width,
+                                  (static_cast<Float32>(key.coord.z) + 0.5f) * region_width};
+        const auto offset = center - Vec2f{location.x, location.z};
+        if(offset.x * offset.x + offset.y * offset.y > region_unload_distance * region_unload_distance) {
+            distant_regions.push_back(key);
+        }
+    });
+
+    distant_regions.each_fwd([&](const WorldRegionKey& key) { regions.erase(key); });
+}
+
+Size WorldSave::get_num_open_regions() const { return regions.size(); }
+
+Size WorldSave::get_num_dirty_regions() const {
+    Size num_dirty_regions = 0;
+    regions.each_value([&](const Region& region) {
+        if(region.version != region.saved_version) {
+            num_dirty_regions++;
+        }
+    });
+
+    return num_dirty_regions;
+}
+
+Uint32 WorldSave::get_num_slots(const WorldRegionKind kind) {
+    return kind == WorldRegionKind::VoxelChunks ? CHUNK_REGION_SIZE * CHUNK_REGION_SIZE * CHUNK_REGION_SIZE :
+                                                  TILE_REGION_SIZE * TILE_REGION_SIZE;
+}
+
+Rx::String WorldSave::get_region_path(const WorldRegionKey& key) const {
+    if(key.kind == WorldRegionKind::VoxelChunks) {
+        return Rx::String::format("%s/chunks_%d_%d_%d.region", directory, key.coord.x, key.coord.y, key.coord.z);
+    } else {
+        return Rx::String::format("%s/tiles_%d_%d.region", directory, key.coord.x, key.coord.z);
+    }
+}
+
+WorldSave::Region& WorldSave::get_region(const WorldRegionKey& key) {
+    if(auto* region = regions.find(key); region != nullptr) {
+        return *region;
+    }
+
+    ZoneScoped;
+
+    auto file = Rx::make_ptr<RegionFile>(RX_SYSTEM_ALLOCATOR, get_region_path(key), get_num_slots(key.kind));
+    return *regions.insert(key, Region{.file = Rx::Utility::move(file)});
+}
+
+RegionEntryView WorldSave::get_entry(const Region& region, const Uint32 slot) {
+    if(region.file) {
+        return region.file->get_entry(slot);
+    }
+
+    return (*region.entries)[slot].get_view();
+}
+
+bool WorldSave::load_entry(const WorldRegionKey& key, const Uint32 slot, Rx::Vector<Byte>& data) {
+    ZoneScoped;
+
+    const auto entry = get_entry(get_region(key), slot);
+    if(entry.is_empty()) {
+        return false;
+    }
+
+    if(!decompress_region_entry(entry, data)) {
+        logger->error("Entry %u of region %s is damaged", slot, get_region_path(key));
+        return false;
+    }
+
+    return true;
+}
+
+void WorldSave::save_entry(const WorldRegionKey& key, const Uint32 slot, const std::span<const Byte> data) {
+    ZoneScoped;
+
+    auto& region = get_region(key);
+
+    // Bring the region into memory, so that its file may be replaced. Its entries are compressed already, so this is just a copy
+    if(region.file) {
+        const auto num_slots = get_num_slots(key.kind);
+        region.entries = std::make_shared<Rx::Vector<RegionEntry>>(num_slots);
+        for(Uint32 i = 0; i < num_slots; i++) {
+            const auto file_entry = region.file->get_entry(i);
+            auto& entry = (*region.entries)[i];
+            entry.compressed_data.resize(file_entry.compressed_data.size());
+            if(!file_entry.is_empty()) {
+                memcpy(entry.compressed_data.data(), file_entry.compressed_data.data(), file_entry.compressed_data.size());
+            }
+            entry.num_bytes = file_entry.num_bytes;
+            entry.checksum = file_entry.checksum;
+        }
+
+        region.file = nullptr;
+
+    } else if(region.entries.use_count() > 1) {
+        // A write is still using the entries
+        region.entries = std::make_shared<Rx::Vector<RegionEntry>>(*region.entries);
+    }
+
+    (*region.entries)[slot] = compress_region_entry(data);
+    region.version++;
+}
+
+void WorldSave::store_finished_flushes(const Rx::Vector<FinishedFlush>& flushes) {
+    num_flushes_in_flight -= static_cast<Uint32>(flushes.size());
+
+    flushes.each_fwd([&](const FinishedFlush& flush) {
+        auto* region = regions.find(flush.key);
+        if(region == nullptr) {
+            return;
+        }
+
+        region->is_flushing = false;
+
+        // A failed write leaves the region dirty, so the next flush tries again
+        if(flush.succeeded) {
+            region->saved_version = flush.version;
+        }
+    });
+}
+
+void WorldSave::collect_flushes() {
+    Rx::Vector<FinishedFlush> flushes;
+    {
+        Rx::Concurrency::ScopeLock lock{finished_flushes_mutex};
+        flushes = Rx::Utility::move(finished_flushes);
+    }
+
+    store_finished_flushes(flushes);
+}
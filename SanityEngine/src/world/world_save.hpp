@@ -0,0 +1,273 @@
+#pragma once
+
+#include <memory>
+#include <span>
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/condition_variable.h"
+#include "rx/core/concurrency/mutex.h"
+#include "rx/core/concurrency/thread_pool.h"
+#include "rx/core/hash.h"
+#include "rx/core/map.h"
+#include "rx/core/optional.h"
+#include "rx/core/ptr.h"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+#include "world/region_file.hpp"
+#include "world/voxel_chunk.hpp"
+
+/*!
+ * \brief The kinds of data that a world save holds. Each kind has its own regions
+ */
+enum class WorldRegionKind : Uint32 {
+    /*!
+     * \brief Voxel chunks, in cubes of `WorldSave::CHUNK_REGION_SIZE` chunks on each side
+     */
+    VoxelChunks = 0,
+
+    /*!
+     * \brief Terrain tile heights, in squares of `WorldSave::TILE_REGION_SIZE` tiles on each side
+     */
+    TerrainTiles,
+};
+
+/*!
+ * \brief Identifies a region of a world save
+ */
+struct WorldRegionKey {
+    WorldRegionKind kind{WorldRegionKind::VoxelChunks};
+
+    /*!
+     * \brief Coordinates of the region, in units of the region's own size. Terrain tile regions have a y of zero
+     */
+    Vec3i coord{};
+
+    [[nodiscard]] bool operator==(const WorldRegionKey& other) const;
+};
+
+namespace Rx {
+    template <>
+    struct Hash<WorldRegionKey> {
+        Size operator()(const WorldRegionKey& key) const {
+            return hash_combine(Hash<Math::Vec3i>{}(key.coord), Hash<Uint32>{}(static_cast<Uint32>(key.kind)));
+        }
+    };
+} // namespace Rx
+
+struct WorldSaveCreateInfo {
+    /*!
+     * \brief Directory to keep the region files in. It's created if it doesn't exist
+     */
+    Rx::String directory;
+
+    /*!
+     * \brief Width of a terrain tile, in meters. Decides how far the terrain tile regions are from the player
+     */
+    Uint32 tile_size{0};
+
+    /*!
+     * \brief Regions whose centers are further than this from the player get unloaded, once they've been saved
+     */
+    Float32 region_unload_distance{2048};
+
+    /*!
+     * \brief Seconds between background flushes of the regions that changed
+     */
+    Float32 flush_interval{5};
+
+    /*!
+     * \brief Number of threads to write region files on
+     */
+    Uint32 num_flush_threads{1};
+};
+
+/*!
+ * \brief Saves voxel chunks and terrain tiles in region files, and loads them back on demand
+ *
+ * Chunks and tiles are grouped into regions, and each region is one region file. Regions open the first time something in them is loaded
+ * or saved, and opening a region only maps its file and checks its offset table. Loading a chunk or tile decompresses just that one entry,
+ * so opening a world costs nothing up front, and playing it only ever touches the regions around the player
+ *
+ * Saving something compresses it right away, which is quick, and makes its region dirty. The first save to a region copies the region's
+ * compressed entries out of its file, so the region lives in memory until it's unloaded. `flush_dirty_regions` hands each dirty region's
+ * entries to a background thread as an immutable snapshot, which it writes to a new file and renames over the old one, so the slow part of
+ * saving never blocks the frame. A region keeps at most one write in flight. Changes that happen during a write make the region dirty
+ * again, and get written by the next flush
+ *
+ * `tick` flushes on an interval and unloads the regions that are far from the player. Dirty regions and regions that are being written
+ * are never unloaded
+ *
+ * Everything but the writes runs on the thread that owns the save
+ */
+class WorldSave {
+public:
+    /*!
+     * \brief Number of voxel chunks on each side of a voxel chunk region
+     */
+    static constexpr Uint32 CHUNK_REGION_SIZE = 8;
+
+    /*!
+     * \brief Number of terrain tiles on each side of a terrain tile region
+     */
+    static constexpr Uint32 TILE_REGION_SIZE = 16;
+
+    explicit WorldSave(const WorldSaveCreateInfo& create_info);
+
+    WorldSave(const WorldSave& other) = delete;
+    WorldSave& operator=(const WorldSave& other) = delete;
+
+    WorldSave(WorldSave&& old) noexcept = delete;
+    WorldSave& operator=(WorldSave&& old) noexcept = delete;
+
+    /*!
+     * \brief Flushes every dirty region, and waits for the writes to finish
+     */
+    ~WorldSave();
+
+    void save_chunk(const Vec3i& coord, const VoxelChunk& chunk);
+
+    /*!
+     * \brief Loads a chunk, or returns an empty optional if the chunk was never saved or its entry is damaged
+     */
+    [[nodiscard]] Rx::Optional<VoxelChunk> load_chunk(const Vec3i& coord);
+
+    /*!
+     * \brief Saves a terrain tile's heights
+     *
+     * The bytes of the heights are shuffled into planes before they're compressed - all the first bytes, then all the second bytes, and so
+     * on. Neighbouring heights have nearly the same sign, exponent, and high bits of their mantissa, so most of the planes compress very
+     * well even though the heights themselves rarely repeat
+     *
+     * \param coord The tile's coordinates, in units of tiles
+     * \param heights The tile's heights. May be any number of heights, `load_tile` gives back the same number
+     */
+    void save_tile(const Vec2i& coord, std::span<const Float32> heights);
+
+    /*!
+     * \brief Loads a terrain tile's heights, or returns an empty optional if the tile was never saved or its entry is damaged
+     */
+    [[nodiscard]] Rx::Optional<Rx::Vector<Float32>> load_tile(const Vec2i& coord);
+
+    /*!
+     * \brief Picks up the writes that finished, flushes the dirty regions when it's time to, and unloads the regions that are far from the
+     * player
+     */
+    void tick(const Vec3f& player_location, Float32 delta_time);
+
+    /*!
+     * \brief Starts writing every dirty region on the background threads. Doesn't wait for the writes
+     *
+     * \return The number of regions that started writing
+     */
+    Uint32 flush_dirty_regions();
+
+    /*!
+     * \brief Blocks until every write that's been started has finished
+     */
+    void wait_for_flushes();
+
+    /*!
+     * \brief Unloads the regions whose centers are further than the unload distance from a location, unless they have changes that
+     * haven't been written yet
+     */
+    void unload_distant_regions(const Vec3f& location);
+
+    [[nodiscard]] Size get_num_open_regions() const;
+
+    /*!
+     * \brief Number of regions with changes that haven't been written yet, including the regions that are being written
+     */
+    [[nodiscard]] Size get_num_dirty_regions() const;
+
+private:
+    struct Region {
+        /*!
+         * \brief The region's file, while nothing in the region has been saved since it opened. nullptr once the region is in memory
+         */
+        Rx::Ptr<RegionFile> file;
+
+        /*!
+         * \brief The region's entries, once something in it has been saved. nullptr until then
+         *
+         * A write shares the entries with the region instead of copying them, so they're copied on write: saving into the region copies
+         * them first if a write is still using them
+         */
+        std::shared_ptr<Rx::Vector<RegionEntry>> entries;
+
+        /*!
+         * \brief Changes every time something in the region gets saved
+         */
+        Uint64 version{0};
+
+        /*!
+         * \brief Version of the region that's in its file
+         */
+        Uint64 saved_version{0};
+
+        bool is_flushing{false};
+    };
+
+    struct FinishedFlush {
+        WorldRegionKey key;
+
+        /*!
+         * \brief Version of the region that was written
+         */
+        Uint64 version{0};
+
+        bool succeeded{false};
+    };
+
+    Rx::String directory;
+
+    Uint32 tile_size;
+
+    Float32 region_unload_distance;
+
+    Float32 flush_interval;
+
+    Float32 time_since_flush{0};
+
+    Rx::Map<WorldRegionKey, Region> regions;
+
+    /*!
+     * \brief Number of writes that have been started but not picked up
+     */
+    Uint32 num_flushes_in_flight{0};
+
+    Rx::Concurrency::Mutex finished_flushes_mutex;
+
+    Rx::Concurrency::ConditionVariable flush_finished_condition;
+
+    /*!
+     * \brief Writes that finished. Guarded by `finished_flushes_mutex`
+     */
+    Rx::Vector<FinishedFlush> finished_flushes;
+
+    /*!
+     * \brief Declared last, so that it gets destroyed first and its writes finish before the rest of the save goes away
+     */
+    Rx::Concurrency::ThreadPool thread_pool;
+
+    [[nodiscard]] static Uint32 get_num_slots(WorldRegionKind kind);
+
+    [[nodiscard]] Rx::String get_region_path(const WorldRegionKey& key) const;
+
+    /*!
+     * \brief Gets a region, opening it if it isn't open yet
+     */
+    [[nodiscard]] Region& get_region(const WorldRegionKey& key);
+
+    [[nodiscard]] static RegionEntryView get_entry(const Region& region, Uint32 slot);
+
+    /*!
+     * \brief Loads a slot's data. Returns whether the slot has data that decompressed without errors
+     */
+    [[nodiscard]] bool load_entry(const WorldRegionKey& key, Uint32 slot, Rx::Vector<Byte>& data);
+
+    void save_entry(const WorldRegionKey& key, Uint32 slot, std::span<const Byte> data);
+
+    void store_finished_flushes(const Rx::Vector<FinishedFlush>& flushes);
+
+    void collect_flushes();
+};
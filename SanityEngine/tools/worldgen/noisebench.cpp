@@ -0,0 +1,294 @@
+/*!
+ * \brief Benchmarks every FastNoiseSIMD instruction set level that this CPU supports, and checks that they generate the same noise
+ *
+ * Also checks that every level's analytic derivatives agree with each other and with finite differences of the noise, and that noise
+ * sampled at a double precision origin doesn't band at planetary distances from the origin
+ *
+ * Run with `--help` for the options. Exits with 1 if any level disagrees with the lowest level by more than the tolerance, or if the
+ * large coordinate check fails, or if the derivatives disagree, so it can gate changes to the noise kernels
+ *
+ * Pass `--cube-sphere` to check the cube sphere tiling that planet-sized worlds use instead. Exits with 1 if its seams, latitude/longitude
+ * round trips, or tile neighbours are wrong
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "adapters/rex/rex_wrapper.hpp"
+#include "rx/core/algorithm/max.h"
+#include "rx/core/algorithm/min.h"
+#include "world/cube_sphere.hpp"
+#include "world/generation/cube_sphere_benchmarks.hpp"
+#include "world/generation/noise_benchmarks.hpp"
+
+static void print_usage() {
+    printf("Usage: SanityNoiseBench [options]\n"
+           "  --seed <n>                 Noise seed (default 1337)\n"
+           "  --size-2d <n>              Width and height of the 2D sets (default 256)\n"
+           "  --size-3d <n>              Width, height, and depth of the 3D sets (default 32)\n"
+           "  --size-origin <n>          Width and height of the large coordinate sets (default 256)\n"
+           "  --repeats <n>              Number of times each set gets generated for the timing (default 4)\n"
+           "  --tolerance <x>            Largest difference from the lowest level that still counts as agreeing (default 0.01)\n"
+           "  --cube-sphere              Check the cube sphere tiling instead of the noise\n"
+           "  --radius <m>               Radius of the cube sphere planet (default: the Earth's)\n"
+           "  --tile-size <m>            Width of the cube sphere tiles to fill, at most 1024 (default 64)\n"
+           "  --tiles <n>                Number of cube sphere tiles to fill for the timing (default 256)\n"
+           "  --max-height <m>           Height that the cube sphere tiles' highest noise maps to (default 1000)\n");
+}
+
+/*!
+ * \brief Checks the cube sphere tiling's seams, latitude/longitude round trips, and tile neighbours, and times filling its tiles
+ *
+ * \return The exit code
+ */
+static int run_cube_sphere_checks(const terraingen::NoiseConfig& config,
+                                  const Float64 radius,
+                                  const Float64 tile_size,
+                                  const Uint32 num_tiles,
+                                  const Float32 max_height) {
+    const auto depth = get_cube_sphere_depth_for_tile_size(radius, tile_size);
+    const auto heightmap_size = static_cast<Uint32>(tile_size) + 1;
+    const auto results = terraingen::benchmark_cube_sphere_tiles(config, radius, depth, heightmap_size, num_tiles, 0, max_height);
+
+    printf("Cube sphere with a radius of %.0f m, %ux%u tiles at depth %u, heights from 0 to %g m\n",
+           radius,
+           heightmap_size,
+           heightmap_size,
+           depth,
+           static_cast<double>(max_height));
+    printf("%-32s %12.6f\n", "tile area ratio", results.tile_area_ratio);
+    printf("%-32s %12.3g\n", "lat/long round trip (degrees)", results.max_lat_long_error);
+    printf("%-32s %12u\n", "neighbour mismatches", results.num_neighbour_mismatches);
+    printf("%-32s %12.3g\n", "same face seam (m)", static_cast<double>(results.max_face_seam_difference));
+    printf("%-32s %12.3g\n", "cross face seam (m)", static_cast<double>(results.max_cross_face_seam_difference));
+    printf("%-32s %12.3f\n", "ms per tile", results.milliseconds / static_cast<double>(Rx::Algorithm::max(results.num_tiles, 1u)));
+
+    if(results.failed) {
+        printf("The cube sphere tiling failed its checks\n");
+        return 1;
+    }
+
+    printf("The cube sphere tiles' seams match and their latitudes, longitudes, and neighbours round-trip\n");
+    return 0;
+}
+
+int main(const int argc, char** argv) {
+    rex::Wrapper rex;
+
+    auto config = terraingen::NoiseConfig{.octaves = 5};
+    Uint32 set_size_2d = 256;
+    Uint32 set_size_3d = 32;
+    Uint32 set_size_origin = 256;
+    Uint32 num_repeats = 4;
+    Float32 tolerance = 0.01f;
+    auto check_cube_sphere = false;
+    auto cube_sphere_radius = CubeSphereStreamingSettings{}.radius;
+    Float64 cube_sphere_tile_size = 64;
+    Uint32 num_cube_sphere_tiles = 256;
+    Float32 cube_sphere_max_height = 1000;
+
+    for(int i = 1; i < argc; i++) {
+        const auto* arg = argv[i];
+        if(strcmp(arg, "--help") == 0) {
+            print_usage();
+            return 0;
+        }
+
+        if(strcmp(arg, "--cube-sphere") == 0) {
+            check_cube_sphere = true;
+            continue;
+        }
+
+        if(i + 1 >= argc) {
+            fprintf(stderr, "Unknown option or missing value: %s\n", arg);
+            print_usage();
+            return 2;
+        }
+
+        const auto* value = argv[++i];
+        const auto number = static_cast<Uint32>(strtoul(value, nullptr, 10));
+        if(strcmp(arg, "--seed") == 0) {
+            config.seed = static_cast<Int32>(number);
+        } else if(strcmp(arg, "--size-2d") == 0) {
+            set_size_2d = Rx::Algorithm::max(number, 1u);
+        } else if(strcmp(arg, "--size-3d") == 0) {
+            set_size_3d = Rx::Algorithm::max(number, 1u);
+        } else if(strcmp(arg, "--size-origin") == 0) {
+            set_size_origin = Rx::Algorithm::max(number, 2u);
+        } else if(strcmp(arg, "--repeats") == 0) {
+            num_repeats = Rx::Algorithm::max(number, 1u);
+        } else if(strcmp(arg, "--tolerance") == 0) {
+            tolerance = strtof(value, nullptr);
+        } else if(strcmp(arg, "--radius") == 0) {
+            cube_sphere_radius = Rx::Algorithm::max(strtod(value, nullptr), 1.0);
+        } else if(strcmp(arg, "--tile-size") == 0) {
+            cube_sphere_tile_size = Rx::Algorithm::min(Rx::Algorithm::max(number, 1u), 1024u);
+        } else if(strcmp(arg, "--tiles") == 0) {
+            num_cube_sphere_tiles = number;
+        } else if(strcmp(arg, "--max-height") == 0) {
+            cube_sphere_max_height = strtof(value, nullptr);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage();
+            return 2;
+        }
+    }
+
+    if(check_cube_sphere) {
+        return run_cube_sphere_checks(config, cube_sphere_radius, cube_sphere_tile_size, num_cube_sphere_tiles, cube_sphere_max_height);
+    }
+
+    const auto results = terraingen::benchmark_noise_backends(config, set_size_2d, set_size_3d, num_repeats, tolerance);
+    if(results.simd_levels.is_empty()) {
+        return 1;
+    }
+
+    printf("%ux%u 2D sets, %ux%ux%u 3D sets, %u repeats, checked against %s with a tolerance of %g\n",
+           set_size_2d,
+           set_size_2d,
+           set_size_3d,
+           set_size_3d,
+           set_size_3d,
+           num_repeats,
+           terraingen::get_simd_level_name(results.reference_simd_level),
+           static_cast<double>(tolerance));
+
+    printf("%-7s %-14s %-10s %-25s %3s %14s %12s %10s\n",
+           "level",
+           "noise",
+           "fractal",
+           "perturb",
+           "dim",
+           "Msamples/s",
+           "max diff",
+           "mismatched");
+    results.runs.each_fwd([&](const terraingen::NoiseBackendBenchmarkResult& run) {
+        printf("%-7s %-14s %-10s %-25s %2uD %14.2f %12.3g %10llu\n",
+               terraingen::get_simd_level_name(run.simd_level),
+               terraingen::get_noise_type_name(run.noise_type),
+               terraingen::is_fractal_noise_type(run.noise_type) ? terraingen::get_fractal_type_name(run.fractal_type) : "-",
+               terraingen::get_perturb_type_name(run.perturb_type),
+               run.num_dimensions,
+               run.samples_per_second / 1000000.0,
+               static_cast<double>(run.max_difference),
+               static_cast<unsigned long long>(run.num_mismatched_samples));
+    });
+
+    // Each level's total over every set, so levels can be compared at a glance
+    results.simd_levels.each_fwd([&](const int simd_level) {
+        Uint64 num_samples = 0;
+        auto milliseconds = 0.0;
+        results.runs.each_fwd([&](const terraingen::NoiseBackendBenchmarkResult& run) {
+            if(run.simd_level == simd_level) {
+                num_samples += run.num_samples;
+                milliseconds += run.milliseconds;
+            }
+        });
+
+        printf("total %-7s %12.3f ms %14.2f Msamples/s\n",
+               terraingen::get_simd_level_name(simd_level),
+               milliseconds,
+               static_cast<double>(num_samples) / (milliseconds * 1000.0));
+    });
+
+    const auto derivative_results = terraingen::benchmark_noise_derivatives(config, set_size_3d, num_repeats, tolerance);
+
+    printf("\n%ux%ux%u sets from FillNoiseSetWithDerivatives. Derivative differences are fractions of the largest derivative\n",
+           set_size_3d,
+           set_size_3d,
+           set_size_3d);
+
+    printf("%-7s %-14s %-10s %14s %12s %12s %12s %10s\n",
+           "level",
+           "noise",
+           "fractal",
+           "Msamples/s",
+           "value diff",
+           "level diff",
+           "finite diff",
+           "kinked");
+    derivative_results.runs.each_fwd([&](const terraingen::NoiseDerivativeResult& run) {
+        printf("%-7s %-14s %-10s %14.2f %12.3g %12.3g %12.3g %10llu%s\n",
+               terraingen::get_simd_level_name(run.simd_level),
+               terraingen::get_noise_type_name(run.noise_type),
+               terraingen::is_fractal_noise_type(run.noise_type) ? terraingen::get_fractal_type_name(run.fractal_type) : "-",
+               run.samples_per_second / 1000000.0,
+               static_cast<double>(run.max_value_difference),
+               static_cast<double>(run.max_level_difference),
+               static_cast<double>(run.max_finite_difference_error),
+               static_cast<unsigned long long>(run.num_kinked_samples),
+               run.failed ? "  FAILED" : "");
+    });
+
+    // FillNoiseSetAtOrigin on the fastest level, from the origin out to planetary distances
+    FastNoiseSIMD::SetSIMDLevel(results.simd_levels.last());
+    const auto origin_results = terraingen::benchmark_large_coordinate_noise(config, set_size_origin, num_repeats, tolerance);
+
+    printf("\n%ux%u sets from FillNoiseSet and FillNoiseSetAtOrigin on %s, with the fraction of equal neighbouring values in each\n",
+           set_size_origin,
+           set_size_origin,
+           terraingen::get_simd_level_name(results.simd_levels.last()));
+
+    printf("%-14s %-10s %8s %12s %12s %12s %12s %12s\n",
+           "noise",
+           "fractal",
+           "origin",
+           "int banding",
+           "int ms",
+           "origin band.",
+           "origin ms",
+           "diff at 0");
+    origin_results.runs.each_fwd([&](const terraingen::LargeCoordinateNoiseResult& run) {
+        char int_start_banding[16];
+        char int_start_milliseconds[16];
+        if(run.int_start_banding < 0) {
+            snprintf(int_start_banding, sizeof(int_start_banding), "-");
+            snprintf(int_start_milliseconds, sizeof(int_start_milliseconds), "-");
+        } else {
+            snprintf(int_start_banding, sizeof(int_start_banding), "%.4f", static_cast<double>(run.int_start_banding));
+            snprintf(int_start_milliseconds, sizeof(int_start_milliseconds), "%.3f", run.int_start_milliseconds);
+        }
+
+        printf("%-14s %-10s %8.0e %12s %12s %12.4f %12.3f %12.3g%s\n",
+               terraingen::get_noise_type_name(run.noise_type),
+               terraingen::is_fractal_noise_type(run.noise_type) ? terraingen::get_fractal_type_name(run.fractal_type) : "-",
+               run.origin,
+               int_start_banding,
+               int_start_milliseconds,
+               static_cast<double>(run.origin_banding),
+               run.origin_milliseconds,
+               static_cast<double>(run.max_difference),
+               run.failed ? "  FAILED" : "");
+    });
+
+    auto exit_code = 0;
+
+    if(results.num_mismatched_runs > 0) {
+        printf("%u of %zu runs differ from %s by more than %g\n",
+               results.num_mismatched_runs,
+               results.runs.size(),
+               terraingen::get_simd_level_name(results.reference_simd_level),
+               static_cast<double>(tolerance));
+        exit_code = 1;
+    } else {
+        printf("Every level agrees with %s\n", terraingen::get_simd_level_name(results.reference_simd_level));
+    }
+
+    if(derivative_results.num_failed_runs > 0) {
+        printf("%u of %zu derivative runs failed\n", derivative_results.num_failed_runs, derivative_results.runs.size());
+        exit_code = 1;
+    } else {
+        printf("Every level's derivatives agree with %s and with finite differences\n",
+               terraingen::get_simd_level_name(derivative_results.reference_simd_level));
+    }
+
+    if(origin_results.num_failed_runs > 0) {
+        printf("%u of %zu large coordinate runs failed\n", origin_results.num_failed_runs, origin_results.runs.size());
+        exit_code = 1;
+    } else {
+        printf("FillNoiseSetAtOrigin agrees with FillNoiseSet at the origin and doesn't band anywhere\n");
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,266 @@
+/*!
+ * \brief Generates a world without a GPU or a window, and reports how long each stage took and a hash of each map
+ *
+ * Run with `--help` for the options. Pass `--write-golden` to save the hashes, and `--golden` on a later run to check that the world
+ * still generates bit-identically
+ *
+ * Pass `--bench <names>` to run world generation benchmarks instead of generating a world. Exits with 1 if any benchmark's
+ * checks fail
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "adapters/rex/rex_wrapper.hpp"
+#include "json5/json5_input.hpp"
+#include "rx/core/algorithm/max.h"
+#include "world/generation/headless_world_generation.hpp"
+#include "world/generation/world_benchmarks.hpp"
+
+/*!
+ * \brief The objects that get placed on the tiles, one from each footprint class. Their density pipelines read every kind of map that
+ * world generation makes, so the placement hash covers how the maps get sampled
+ */
+static const char* DEFAULT_OBJECT_PIPELINES = R"([
+    { type: "multiply", inputs: [{ type: "texture", name: "groundwater" }, { type: "noise", frequency: 0.02 }] },
+    { type: "remap", input: { type: "texture", name: "soil_moisture" }, from: [0, 1], to: [0.2, 0.8] },
+    { type: "threshold", input: { type: "slope" }, threshold: 0.3, softness: 0.2 },
+    { type: "remap", input: { type: "distance_to_water", max_distance: 32 }, from: [0, 32], to: [1, 0.25] },
+])";
+
+struct GoldenHash {
+    char name[64];
+
+    Uint64 hash;
+};
+
+static void print_usage() {
+    printf("Usage: SanityWorldGen [options]\n"
+           "  --seed <n>                 World seed (default 666)\n"
+           "  --width <meters>           Width of the world (default 128)\n"
+           "  --height <meters>          Height of the world, from the north end to the south end (default 128)\n"
+           "  --max-ocean-depth <m>      Maximum depth of the ocean (default 8)\n"
+           "  --min-terrain-depth <m>    Distance from the lowest point in the ocean to the bedrock (default 8)\n"
+           "  --max-height <m>           Height above sea level of the tallest mountain (default 16)\n"
+           "  --erosion-iterations <n>   Hydraulic erosion iterations (default 64)\n"
+           "  --threads <n>              Worker threads (default: one per hardware thread)\n"
+           "  --tiles <n>                Tiles along each side of the square of tiles around the origin (default 8)\n"
+           "  --water-steps <n>          Water simulation steps on the tiles (default 600)\n"
+           "  --write-golden <file>      Write the map hashes to a file\n"
+           "  --golden <file>            Check the map hashes against a file from --write-golden. Exits with 1 if any differ\n"
+           "  --bench <names>            Run comma-separated benchmarks on the world instead of generating it. May be repeated,\n"
+           "                             or \"all\" runs every one\n");
+
+    printf("Benchmarks:");
+    terraingen::get_world_benchmarks().each_fwd(
+        [](const terraingen::WorldBenchmark benchmark) { printf(" %s", terraingen::get_world_benchmark_name(benchmark)); });
+    printf("\n");
+}
+
+static bool write_golden_hashes(const char* path, const terraingen::HeadlessWorld& world) {
+    auto* file = fopen(path, "w");
+    if(file == nullptr) {
+        fprintf(stderr, "Could not open %s for writing\n", path);
+        return false;
+    }
+
+    world.map_hashes.each_fwd([&](const terraingen::WorldMapHash& map_hash) {
+        fprintf(file, "%s %016" PRIx64 "\n", map_hash.name, static_cast<uint64_t>(map_hash.hash));
+    });
+
+    fclose(file);
+
+    return true;
+}
+
+/*!
+ * \brief Checks the world's hashes against a golden file, and prints every map that doesn't match
+ *
+ * \return Whether every map in the golden file matched
+ */
+static bool check_golden_hashes(const char* path, const terraingen::HeadlessWorld& world) {
+    auto* file = fopen(path, "r");
+    if(file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    Rx::Vector<GoldenHash> golden_hashes;
+    GoldenHash golden_hash{};
+    uint64_t hash;
+    while(fscanf(file, "%63s %" SCNx64, golden_hash.name, &hash) == 2) {
+        golden_hash.hash = hash;
+        golden_hashes.push_back(golden_hash);
+    }
+
+    fclose(file);
+
+    auto all_match = true;
+    golden_hashes.each_fwd([&](const GoldenHash& golden) {
+        const auto index = world.map_hashes.find_if(
+            [&](const terraingen::WorldMapHash& candidate) { return strcmp(candidate.name, golden.name) == 0; });
+        if(index == Rx::Vector<terraingen::WorldMapHash>::k_npos) {
+            printf("MISSING %s\n", golden.name);
+            all_match = false;
+            return;
+        }
+
+        const auto& map_hash = world.map_hashes[index];
+        if(map_hash.hash != golden.hash) {
+            printf("MISMATCH %s: expected %016" PRIx64 ", got %016" PRIx64 "\n",
+                   golden.name,
+                   static_cast<uint64_t>(golden.hash),
+                   static_cast<uint64_t>(map_hash.hash));
+            all_match = false;
+        }
+    });
+
+    if(all_match) {
+        printf("All %zu map hashes match %s\n", golden_hashes.size(), path);
+    }
+
+    return all_match;
+}
+
+int main(const int argc, char** argv) {
+    rex::Wrapper rex;
+
+    auto params = WorldParameters{.seed = 666,
+                                  .height = 128,
+                                  .width = 128,
+                                  .max_ocean_depth = 8,
+                                  .min_terrain_depth_under_ocean = 8,
+                                  .max_height_above_sea_level = 16};
+    auto settings = terraingen::HeadlessWorldSettings{.num_threads = Rx::Algorithm::max(std::thread::hardware_concurrency(), 1u)};
+    const char* write_golden_path = nullptr;
+    const char* golden_path = nullptr;
+    Rx::Vector<terraingen::WorldBenchmark> benchmarks;
+
+    for(int i = 1; i < argc; i++) {
+        const auto* arg = argv[i];
+        if(strcmp(arg, "--help") == 0) {
+            print_usage();
+            return 0;
+        }
+
+        if(i + 1 >= argc) {
+            fprintf(stderr, "Unknown option or missing value: %s\n", arg);
+            print_usage();
+            return 2;
+        }
+
+        const auto* value = argv[++i];
+        const auto number = static_cast<Uint32>(strtoul(value, nullptr, 10));
+        if(strcmp(arg, "--seed") == 0) {
+            params.seed = number;
+        } else if(strcmp(arg, "--width") == 0) {
+            params.width = number;
+        } else if(strcmp(arg, "--height") == 0) {
+            params.height = number;
+        } else if(strcmp(arg, "--max-ocean-depth") == 0) {
+            params.max_ocean_depth = number;
+        } else if(strcmp(arg, "--min-terrain-depth") == 0) {
+            params.min_terrain_depth_under_ocean = number;
+        } else if(strcmp(arg, "--max-height") == 0) {
+            params.max_height_above_sea_level = static_cast<int32_t>(strtol(value, nullptr, 10));
+        } else if(strcmp(arg, "--erosion-iterations") == 0) {
+            settings.num_erosion_iterations = number;
+        } else if(strcmp(arg, "--threads") == 0) {
+            settings.num_threads = Rx::Algorithm::max(number, 1u);
+        } else if(strcmp(arg, "--tiles") == 0) {
+            settings.tiles_per_side = number;
+        } else if(strcmp(arg, "--water-steps") == 0) {
+            settings.num_water_steps = number;
+        } else if(strcmp(arg, "--write-golden") == 0) {
+            write_golden_path = value;
+        } else if(strcmp(arg, "--golden") == 0) {
+            golden_path = value;
+        } else if(strcmp(arg, "--bench") == 0) {
+            if(!terraingen::find_world_benchmarks(value, benchmarks)) {
+                fprintf(stderr, "Unknown benchmark: %s\n", value);
+                print_usage();
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage();
+            return 2;
+        }
+    }
+
+    if(params.width == 0 || params.height == 0) {
+        fprintf(stderr, "The world must be at least 1x1 meters\n");
+        return 2;
+    }
+
+    if(!benchmarks.is_empty()) {
+        const auto benchmark_settings = terraingen::WorldBenchmarkSettings{.tile_size = settings.tile_size};
+
+        auto num_failed = 0u;
+        benchmarks.each_fwd([&](const terraingen::WorldBenchmark benchmark) {
+            const auto passed = terraingen::run_world_benchmark(benchmark, params, benchmark_settings);
+            printf("bench %-22s %s\n", terraingen::get_world_benchmark_name(benchmark), passed ? "passed" : "FAILED");
+            if(!passed) {
+                num_failed++;
+            }
+        });
+
+        return num_failed > 0 ? 1 : 0;
+    }
+
+    // The objects' density pipelines get compiled when they're placed, so the document only needs to outlive the generation
+    json5::document pipelines;
+    if(const auto error = json5::from_string(DEFAULT_OBJECT_PIPELINES, pipelines); error) {
+        fprintf(stderr, "Could not parse the default objects' density pipelines: %s\n", json5::error::type_string[error.type]);
+        return 1;
+    }
+
+    Rx::Vector<environment::EnvironmentObject> objects;
+    for(Uint32 footprint_class = 0; footprint_class < environment::NUM_FOOTPRINT_CLASSES; footprint_class++) {
+        objects.push_back(environment::EnvironmentObject{.footprint_class = static_cast<environment::FootprintClass>(footprint_class),
+                                                         .density_map_generation_pipeline = pipelines[footprint_class]});
+    }
+
+    const auto world = terraingen::generate_headless_world(params, {objects.data(), objects.size()}, settings);
+
+    printf("World %ux%u, seed %u, %u erosion iterations, %u threads, %ux%u tiles of %u meters, %u water steps\n",
+           params.width,
+           params.height,
+           params.seed,
+           settings.num_erosion_iterations,
+           settings.num_threads,
+           settings.tiles_per_side,
+           settings.tiles_per_side,
+           settings.tile_size,
+           settings.num_water_steps);
+
+    auto total_milliseconds = 0.0;
+    world.stage_timings.each_fwd([&](const terraingen::WorldGenerationStageTiming& timing) {
+        printf("stage %-18s %12.3f ms %14" PRIu64 " %-8s %14.1f %s/ms\n",
+               timing.name,
+               timing.milliseconds,
+               static_cast<uint64_t>(timing.num_elements),
+               timing.unit,
+               timing.elements_per_millisecond,
+               timing.unit);
+        total_milliseconds += timing.milliseconds;
+    });
+    printf("total %.3f ms\n", total_milliseconds);
+
+    world.map_hashes.each_fwd([&](const terraingen::WorldMapHash& map_hash) {
+        printf("hash  %-18s %016" PRIx64 " %12zu bytes\n", map_hash.name, static_cast<uint64_t>(map_hash.hash), map_hash.num_bytes);
+    });
+
+    if(write_golden_path != nullptr && !write_golden_hashes(write_golden_path, world)) {
+        return 1;
+    }
+
+    if(golden_path != nullptr && !check_golden_hashes(golden_path, world)) {
+        return 1;
+    }
+
+    return 0;
+}